@@ -0,0 +1,102 @@
+import argparse
+import re
+import struct
+import sys
+
+# printed record: index, ticks, cycles, format, tag (uint32), level, core, argc, string length (uint8),
+# the integer arguments (uint32) and the string, all little endian
+RECORD_HEADER = struct.Struct('<IIIIIBBBB')
+LEVELS = 'NEWIDV'
+
+LINE = re.compile(r'binlog: (s|r|lost) (.*?)(?:\x1b\[0m)?\s*$')
+STRING = re.compile(r'([0-9a-f]{8}) (.*)$')
+CONVERSION = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t)?([diouxXcsp%])')
+
+parser = argparse.ArgumentParser(description='decode the binary log ring of the gateway')
+
+parser.add_argument('log', type=str, nargs='?', help='monitor log with "binlog:" lines, default stdin')
+parser.add_argument('--mhz', type=int, default=240, help='CPU frequency, for the time between records')
+parser.add_argument('--all', action='store_true', help='also print the other lines of the log')
+
+args = parser.parse_args()
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def format_message(fmt, values, string):
+    """Format like printf, the integer arguments are 32 bit, the string fills the first %s."""
+    values = list(values)
+
+    def take():
+        return values.pop(0) if values else 0
+
+    def replace(match):
+        flags, width, precision, _, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        if width == '*':
+            width = str(signed(take()))
+        if precision == '*':
+            precision = str(signed(take()))
+        spec = '%' + flags + (width or '') + ('.' + precision if precision is not None else '')
+        if conversion == 's':
+            return (spec + 's') % (string if string is not None else '?')
+        value = take()
+        if conversion in 'di':
+            return (spec + 'd') % signed(value)
+        if conversion == 'u':
+            return (spec + 'd') % value
+        if conversion == 'p':
+            return '0x%08x' % value
+        if conversion == 'c':
+            return (spec + 'c') % chr(value & 0xff)
+        return (spec + conversion) % value
+
+    return CONVERSION.sub(replace, fmt)
+
+
+def decode(lines, out):
+    strings = {}
+    last_cycles = {}
+    for line in lines:
+        match = LINE.search(line)
+        if match is None:
+            if args.all:
+                out.write(line)
+            continue
+        kind, data = match.groups()
+        if kind == 's':
+            string = STRING.match(data)
+            if string is not None:
+                strings[int(string.group(1), 16)] = string.group(2)
+            continue
+        if kind == 'lost':
+            out.write(line)
+            continue
+        try:
+            record = bytes.fromhex(data)
+            index, ticks, cycles, fmt, tag, level, core, argc, str_len = RECORD_HEADER.unpack_from(record)
+            values = struct.unpack_from('<%dI' % argc, record, RECORD_HEADER.size)
+            offset = RECORD_HEADER.size + 4 * argc
+            string = record[offset:offset + str_len].decode('utf-8', 'replace') if str_len else None
+        except (ValueError, struct.error):
+            sys.stderr.write('broken record: {}\n'.format(data))
+            continue
+        # the cycle counters of the cores are not in sync
+        delta = ''
+        if core in last_cycles:
+            delta = ' +{:.1f} us'.format(((cycles - last_cycles[core]) & 0xffffffff) / args.mhz)
+        last_cycles[core] = cycles
+        message = format_message(strings.get(fmt, '<format {:08x}>'.format(fmt)), values, string)
+        out.write('{} ({}) [{}] {}: {}  #{}{}\n'.format(LEVELS[level] if level < len(LEVELS) else '?', ticks, core,
+                                                     strings.get(tag, '<tag {:08x}>'.format(tag)), message,
+                                                     index, delta))
+
+
+if args.log:
+    with open(args.log, errors='replace') as f:
+        decode(f, sys.stdout)
+else:
+    decode(sys.stdin, sys.stdout)
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""
+Benchmark the UPPs per second of the host build against the batch size.
+
+For every batch size, the gateway is built with a further defaults file,
+which sets CONFIG_UBIRCH_PIPELINE_BATCH_SIZE and a connection pool of the
+same size, and run against the mock backend, whose answers take --delay-ms. The table shows the UPPs, which were
+delivered per second in the measurement, the p99 latency of the transmit
+stage, the UPPs per batch and the chains, which the backend found broken.
+
+    $ python3 host/batch_bench.py --build-dir build-host-batch --sizes 1,2,4 --delay-ms 100
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+from host_test import HERE, Backend, run
+
+PROJECT_ROOT = os.path.dirname(HERE)
+
+
+def build(build_dir, size):
+    """Build the gateway with batches of size UPPs, return the program."""
+    os.makedirs(build_dir, exist_ok=True)
+    defaults = os.path.join(build_dir, "batch.defaults")
+    with open(defaults, "w") as f:
+        f.write(f"CONFIG_UBIRCH_PIPELINE_BATCH_SIZE={size}\nCONFIG_UBIRCH_HTTP_POOL_SIZE={size}\n")
+        # the sockets of the larger pools are taken from the ingestion server, which is not used
+        f.write("CONFIG_UBIRCH_INGEST_MAX_CONNECTIONS=4\n")
+    sdkconfig_defaults = ";".join([os.path.join(PROJECT_ROOT, "sdkconfig.defaults"),
+                                   os.path.join(HERE, "sdkconfig.host"), defaults])
+    subprocess.run(["cmake", "-S", HERE, "-B", build_dir, f"-DSDKCONFIG_DEFAULTS={sdkconfig_defaults}"],
+                   check=True, stdout=subprocess.DEVNULL)
+    subprocess.run(["cmake", "--build", build_dir, "-j", str(os.cpu_count() or 1), "--target",
+                    "example-esp32-host"], check=True, stdout=subprocess.DEVNULL)
+    return os.path.join(build_dir, "example-esp32-host")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="benchmark the UPPs per second against the batch size")
+    parser.add_argument("--build-dir", required=True, help="directory of the builds, one per batch size")
+    parser.add_argument("--sizes", type=lambda v: [int(s) for s in v.split(",")], default=[1, 2, 3, 4],
+                        help="batch sizes, comma separated")
+    parser.add_argument("--delay-ms", type=float, default=100, help="latency of the mock backend per UPP")
+    parser.add_argument("--sensors", type=int, default=16)
+    parser.add_argument("--rate", type=float, default=2, help="readings per second of every sensor")
+    parser.add_argument("--warmup", type=float, default=5)
+    parser.add_argument("--duration", type=float, default=10)
+    args = parser.parse_args()
+
+    print("batch  delivered/s  transmit p99 (ms)  upps/batch  chain breaks")
+    for size in args.sizes:
+        program = build(os.path.join(args.build_dir, f"batch-{size}"), size)
+        backend = Backend("--delay-ms", str(args.delay_ms))
+        try:
+            with tempfile.TemporaryDirectory() as flash:
+                report = run(program, flash, "--erase-flash", "--sensors", str(args.sensors),
+                             "--rate", str(args.rate), "--warmup", str(args.warmup),
+                             "--duration", str(args.duration))
+        finally:
+            stats = backend.stop()
+        delivered = report["delivery"]["delivered"] / report["config"]["duration_s"]
+        batches = report["batches"]
+        per_batch = batches["upps"] / batches["count"] if batches["count"] else 0
+        print(f"{size:5d}  {delivered:11.1f}  {report['stages']['transmit']['p99_us'] / 1000:17.1f}  "
+              f"{per_batch:10.2f}  {stats.get('chain_breaks', 0):12d}")
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
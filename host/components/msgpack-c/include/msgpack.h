@@ -0,0 +1,216 @@
+/*!
+ * @file msgpack.h
+ * @brief Stand-in of the msgpack-c C API for the host build.
+ *
+ * Packer, simple buffer and streaming unpacker with the types and the
+ * semantics of msgpack-c. Unpacked strings and binaries are copied into the
+ * zone of the result instead of referencing the unpacker buffer.
+ *
+ * @date   2026-10-17
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef MSGPACK_H
+#define MSGPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MSGPACK_OBJECT_NIL = 0x00,
+    MSGPACK_OBJECT_BOOLEAN = 0x01,
+    MSGPACK_OBJECT_POSITIVE_INTEGER = 0x02,
+    MSGPACK_OBJECT_NEGATIVE_INTEGER = 0x03,
+    MSGPACK_OBJECT_FLOAT32 = 0x0a,
+    MSGPACK_OBJECT_FLOAT64 = 0x04,
+    MSGPACK_OBJECT_FLOAT = 0x04,
+    MSGPACK_OBJECT_STR = 0x05,
+    MSGPACK_OBJECT_ARRAY = 0x06,
+    MSGPACK_OBJECT_MAP = 0x07,
+    MSGPACK_OBJECT_BIN = 0x08,
+    MSGPACK_OBJECT_EXT = 0x09,
+} msgpack_object_type;
+
+struct msgpack_object;
+struct msgpack_object_kv;
+
+typedef struct {
+    uint32_t size;
+    struct msgpack_object *ptr;
+} msgpack_object_array;
+
+typedef struct {
+    uint32_t size;
+    struct msgpack_object_kv *ptr;
+} msgpack_object_map;
+
+typedef struct {
+    uint32_t size;
+    const char *ptr;
+} msgpack_object_str;
+
+typedef struct {
+    uint32_t size;
+    const char *ptr;
+} msgpack_object_bin;
+
+typedef struct {
+    int8_t type;
+    uint32_t size;
+    const char *ptr;
+} msgpack_object_ext;
+
+typedef union {
+    bool boolean;
+    uint64_t u64;
+    int64_t i64;
+    double f64;
+    msgpack_object_array array;
+    msgpack_object_map map;
+    msgpack_object_str str;
+    msgpack_object_bin bin;
+    msgpack_object_ext ext;
+} msgpack_object_union;
+
+typedef struct msgpack_object {
+    msgpack_object_type type;
+    msgpack_object_union via;
+} msgpack_object;
+
+typedef struct msgpack_object_kv {
+    msgpack_object key;
+    msgpack_object val;
+} msgpack_object_kv;
+
+/*!
+ * Memory of the unpacked objects, freed at once.
+ */
+typedef struct msgpack_zone msgpack_zone;
+
+/* packer */
+
+typedef int (*msgpack_packer_write)(void *data, const char *buf, size_t len);
+
+typedef struct msgpack_packer {
+    void *data;
+    msgpack_packer_write callback;
+} msgpack_packer;
+
+void msgpack_packer_init(msgpack_packer *pk, void *data, msgpack_packer_write callback);
+msgpack_packer *msgpack_packer_new(void *data, msgpack_packer_write callback);
+void msgpack_packer_free(msgpack_packer *pk);
+
+int msgpack_pack_nil(msgpack_packer *pk);
+int msgpack_pack_true(msgpack_packer *pk);
+int msgpack_pack_false(msgpack_packer *pk);
+int msgpack_pack_uint8(msgpack_packer *pk, uint8_t d);
+int msgpack_pack_uint16(msgpack_packer *pk, uint16_t d);
+int msgpack_pack_uint32(msgpack_packer *pk, uint32_t d);
+int msgpack_pack_uint64(msgpack_packer *pk, uint64_t d);
+int msgpack_pack_int8(msgpack_packer *pk, int8_t d);
+int msgpack_pack_int16(msgpack_packer *pk, int16_t d);
+int msgpack_pack_int32(msgpack_packer *pk, int32_t d);
+int msgpack_pack_int64(msgpack_packer *pk, int64_t d);
+int msgpack_pack_float(msgpack_packer *pk, float d);
+int msgpack_pack_double(msgpack_packer *pk, double d);
+int msgpack_pack_array(msgpack_packer *pk, size_t n);
+int msgpack_pack_map(msgpack_packer *pk, size_t n);
+int msgpack_pack_str(msgpack_packer *pk, size_t l);
+int msgpack_pack_str_body(msgpack_packer *pk, const void *b, size_t l);
+int msgpack_pack_bin(msgpack_packer *pk, size_t l);
+int msgpack_pack_bin_body(msgpack_packer *pk, const void *b, size_t l);
+
+/* simple buffer */
+
+typedef struct msgpack_sbuffer {
+    size_t size;
+    char *data;
+    size_t alloc;
+} msgpack_sbuffer;
+
+void msgpack_sbuffer_init(msgpack_sbuffer *sbuf);
+void msgpack_sbuffer_destroy(msgpack_sbuffer *sbuf);
+void msgpack_sbuffer_clear(msgpack_sbuffer *sbuf);
+int msgpack_sbuffer_write(void *data, const char *buf, size_t len);
+
+/* streaming unpacker */
+
+typedef enum {
+    MSGPACK_UNPACK_SUCCESS = 2,
+    MSGPACK_UNPACK_EXTRA_BYTES = 1,
+    MSGPACK_UNPACK_CONTINUE = 0,
+    MSGPACK_UNPACK_PARSE_ERROR = -1,
+    MSGPACK_UNPACK_NOMEM_ERROR = -2,
+} msgpack_unpack_return;
+
+typedef struct msgpack_unpacker {
+    char *buffer;                   //!< received data
+    size_t used;                    //!< bytes received
+    size_t free;                    //!< bytes left in the buffer
+    size_t off;                     //!< start of the data, which is not unpacked yet
+    size_t parsed;                  //!< bytes unpacked since the last reset
+    msgpack_zone *z;                //!< unused, the zone belongs to the result
+    size_t initial_buffer_size;
+    void *ctx;                      //!< unused
+} msgpack_unpacker;
+
+typedef struct msgpack_unpacked {
+    msgpack_zone *zone;
+    msgpack_object data;
+} msgpack_unpacked;
+
+bool msgpack_unpacker_init(msgpack_unpacker *mpac, size_t initial_buffer_size);
+void msgpack_unpacker_destroy(msgpack_unpacker *mpac);
+msgpack_unpacker *msgpack_unpacker_new(size_t initial_buffer_size);
+void msgpack_unpacker_free(msgpack_unpacker *mpac);
+
+/*!
+ * Make room for \p size more bytes, the buffer is rewound first, if all data is unpacked.
+ */
+bool msgpack_unpacker_reserve_buffer(msgpack_unpacker *mpac, size_t size);
+char *msgpack_unpacker_buffer(msgpack_unpacker *mpac);
+size_t msgpack_unpacker_buffer_capacity(const msgpack_unpacker *mpac);
+void msgpack_unpacker_buffer_consumed(msgpack_unpacker *mpac, size_t size);
+
+/*!
+ * Unpack the next complete object of the buffer into \p result.
+ *
+ * @return MSGPACK_UNPACK_SUCCESS, MSGPACK_UNPACK_CONTINUE if more data is needed, or an error
+ */
+msgpack_unpack_return msgpack_unpacker_next(msgpack_unpacker *mpac, msgpack_unpacked *result);
+
+/*!
+ * Start parsing at the next object, the buffer is kept.
+ */
+void msgpack_unpacker_reset(msgpack_unpacker *mpac);
+
+void msgpack_unpacked_init(msgpack_unpacked *result);
+void msgpack_unpacked_destroy(msgpack_unpacked *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MSGPACK_H
@@ -0,0 +1,525 @@
+/*!
+ * @file msgpack.c
+ * @brief Stand-in of the msgpack-c C API for the host build.
+ *
+ * @date   2026-10-17
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "msgpack.h"
+
+#define SBUFFER_INIT_SIZE 256
+#define UNPACK_MAX_DEPTH 32
+
+/* packer */
+
+void msgpack_packer_init(msgpack_packer *pk, void *data, msgpack_packer_write callback) {
+    pk->data = data;
+    pk->callback = callback;
+}
+
+msgpack_packer *msgpack_packer_new(void *data, msgpack_packer_write callback) {
+    msgpack_packer *pk = malloc(sizeof(msgpack_packer));
+    if (pk != NULL) {
+        msgpack_packer_init(pk, data, callback);
+    }
+    return pk;
+}
+
+void msgpack_packer_free(msgpack_packer *pk) {
+    free(pk);
+}
+
+/*!
+ * Write the type byte \p head and \p bytes of \p value, big endian.
+ */
+static int pack_head(msgpack_packer *pk, uint8_t head, uint64_t value, size_t bytes) {
+    char buf[9];
+    buf[0] = (char)head;
+    for (size_t i = 0; i < bytes; ++i) {
+        buf[bytes - i] = (char)(value >> (8 * i));
+    }
+    return pk->callback(pk->data, buf, 1 + bytes);
+}
+
+static int pack_unsigned(msgpack_packer *pk, uint64_t d) {
+    if (d < 0x80) {
+        return pack_head(pk, (uint8_t)d, 0, 0);
+    } else if (d <= UINT8_MAX) {
+        return pack_head(pk, 0xcc, d, 1);
+    } else if (d <= UINT16_MAX) {
+        return pack_head(pk, 0xcd, d, 2);
+    } else if (d <= UINT32_MAX) {
+        return pack_head(pk, 0xce, d, 4);
+    }
+    return pack_head(pk, 0xcf, d, 8);
+}
+
+static int pack_signed(msgpack_packer *pk, int64_t d) {
+    if (d >= 0) {
+        return pack_unsigned(pk, (uint64_t)d);
+    } else if (d >= -32) {
+        return pack_head(pk, (uint8_t)d, 0, 0);
+    } else if (d >= INT8_MIN) {
+        return pack_head(pk, 0xd0, (uint64_t)d, 1);
+    } else if (d >= INT16_MIN) {
+        return pack_head(pk, 0xd1, (uint64_t)d, 2);
+    } else if (d >= INT32_MIN) {
+        return pack_head(pk, 0xd2, (uint64_t)d, 4);
+    }
+    return pack_head(pk, 0xd3, (uint64_t)d, 8);
+}
+
+int msgpack_pack_nil(msgpack_packer *pk) {
+    return pack_head(pk, 0xc0, 0, 0);
+}
+
+int msgpack_pack_true(msgpack_packer *pk) {
+    return pack_head(pk, 0xc3, 0, 0);
+}
+
+int msgpack_pack_false(msgpack_packer *pk) {
+    return pack_head(pk, 0xc2, 0, 0);
+}
+
+int msgpack_pack_uint8(msgpack_packer *pk, uint8_t d) {
+    return pack_unsigned(pk, d);
+}
+
+int msgpack_pack_uint16(msgpack_packer *pk, uint16_t d) {
+    return pack_unsigned(pk, d);
+}
+
+int msgpack_pack_uint32(msgpack_packer *pk, uint32_t d) {
+    return pack_unsigned(pk, d);
+}
+
+int msgpack_pack_uint64(msgpack_packer *pk, uint64_t d) {
+    return pack_unsigned(pk, d);
+}
+
+int msgpack_pack_int8(msgpack_packer *pk, int8_t d) {
+    return pack_signed(pk, d);
+}
+
+int msgpack_pack_int16(msgpack_packer *pk, int16_t d) {
+    return pack_signed(pk, d);
+}
+
+int msgpack_pack_int32(msgpack_packer *pk, int32_t d) {
+    return pack_signed(pk, d);
+}
+
+int msgpack_pack_int64(msgpack_packer *pk, int64_t d) {
+    return pack_signed(pk, d);
+}
+
+int msgpack_pack_float(msgpack_packer *pk, float d) {
+    uint32_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return pack_head(pk, 0xca, bits, 4);
+}
+
+int msgpack_pack_double(msgpack_packer *pk, double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return pack_head(pk, 0xcb, bits, 8);
+}
+
+int msgpack_pack_array(msgpack_packer *pk, size_t n) {
+    if (n < 16) {
+        return pack_head(pk, (uint8_t)(0x90 | n), 0, 0);
+    }
+    return n <= UINT16_MAX ? pack_head(pk, 0xdc, n, 2) : pack_head(pk, 0xdd, n, 4);
+}
+
+int msgpack_pack_map(msgpack_packer *pk, size_t n) {
+    if (n < 16) {
+        return pack_head(pk, (uint8_t)(0x80 | n), 0, 0);
+    }
+    return n <= UINT16_MAX ? pack_head(pk, 0xde, n, 2) : pack_head(pk, 0xdf, n, 4);
+}
+
+int msgpack_pack_str(msgpack_packer *pk, size_t l) {
+    if (l < 32) {
+        return pack_head(pk, (uint8_t)(0xa0 | l), 0, 0);
+    } else if (l <= UINT8_MAX) {
+        return pack_head(pk, 0xd9, l, 1);
+    }
+    return l <= UINT16_MAX ? pack_head(pk, 0xda, l, 2) : pack_head(pk, 0xdb, l, 4);
+}
+
+int msgpack_pack_str_body(msgpack_packer *pk, const void *b, size_t l) {
+    return pk->callback(pk->data, b, l);
+}
+
+int msgpack_pack_bin(msgpack_packer *pk, size_t l) {
+    if (l <= UINT8_MAX) {
+        return pack_head(pk, 0xc4, l, 1);
+    }
+    return l <= UINT16_MAX ? pack_head(pk, 0xc5, l, 2) : pack_head(pk, 0xc6, l, 4);
+}
+
+int msgpack_pack_bin_body(msgpack_packer *pk, const void *b, size_t l) {
+    return pk->callback(pk->data, b, l);
+}
+
+/* simple buffer */
+
+void msgpack_sbuffer_init(msgpack_sbuffer *sbuf) {
+    memset(sbuf, 0, sizeof(msgpack_sbuffer));
+}
+
+void msgpack_sbuffer_destroy(msgpack_sbuffer *sbuf) {
+    free(sbuf->data);
+    memset(sbuf, 0, sizeof(msgpack_sbuffer));
+}
+
+void msgpack_sbuffer_clear(msgpack_sbuffer *sbuf) {
+    sbuf->size = 0;
+}
+
+int msgpack_sbuffer_write(void *data, const char *buf, size_t len) {
+    msgpack_sbuffer *sbuf = data;
+    if (sbuf->alloc - sbuf->size < len) {
+        size_t alloc = sbuf->alloc ? sbuf->alloc * 2 : SBUFFER_INIT_SIZE;
+        while (alloc < sbuf->size + len) {
+            alloc *= 2;
+        }
+        char *grown = realloc(sbuf->data, alloc);
+        if (grown == NULL) {
+            return -1;
+        }
+        sbuf->data = grown;
+        sbuf->alloc = alloc;
+    }
+    memcpy(sbuf->data + sbuf->size, buf, len);
+    sbuf->size += len;
+    return 0;
+}
+
+/* zone */
+
+struct msgpack_zone {
+    struct msgpack_zone *next;      //!< every allocation is a chunk of the list
+    max_align_t data[];
+};
+
+static void *zone_alloc(msgpack_zone **zone, size_t size) {
+    msgpack_zone *chunk = malloc(sizeof(msgpack_zone) + size);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->next = *zone;
+    *zone = chunk;
+    return chunk->data;
+}
+
+static void zone_free(msgpack_zone *zone) {
+    while (zone != NULL) {
+        msgpack_zone *next = zone->next;
+        free(zone);
+        zone = next;
+    }
+}
+
+/* unpacker */
+
+bool msgpack_unpacker_init(msgpack_unpacker *mpac, size_t initial_buffer_size) {
+    memset(mpac, 0, sizeof(msgpack_unpacker));
+    mpac->buffer = malloc(initial_buffer_size);
+    if (mpac->buffer == NULL) {
+        return false;
+    }
+    mpac->free = initial_buffer_size;
+    mpac->initial_buffer_size = initial_buffer_size;
+    return true;
+}
+
+void msgpack_unpacker_destroy(msgpack_unpacker *mpac) {
+    free(mpac->buffer);
+    memset(mpac, 0, sizeof(msgpack_unpacker));
+}
+
+msgpack_unpacker *msgpack_unpacker_new(size_t initial_buffer_size) {
+    msgpack_unpacker *mpac = malloc(sizeof(msgpack_unpacker));
+    if (mpac != NULL && !msgpack_unpacker_init(mpac, initial_buffer_size)) {
+        free(mpac);
+        return NULL;
+    }
+    return mpac;
+}
+
+void msgpack_unpacker_free(msgpack_unpacker *mpac) {
+    if (mpac != NULL) {
+        msgpack_unpacker_destroy(mpac);
+        free(mpac);
+    }
+}
+
+bool msgpack_unpacker_reserve_buffer(msgpack_unpacker *mpac, size_t size) {
+    if (mpac->free >= size) {
+        return true;
+    }
+    if (mpac->used == mpac->off) {
+        // everything is unpacked, start at the beginning again
+        mpac->free += mpac->used;
+        mpac->used = 0;
+        mpac->off = 0;
+    } else if (mpac->off > 0) {
+        memmove(mpac->buffer, mpac->buffer + mpac->off, mpac->used - mpac->off);
+        mpac->used -= mpac->off;
+        mpac->free += mpac->off;
+        mpac->off = 0;
+    }
+    if (mpac->free >= size) {
+        return true;
+    }
+    size_t alloc = mpac->used + mpac->free;
+    while (alloc < mpac->used + size) {
+        alloc = alloc ? alloc * 2 : mpac->initial_buffer_size;
+    }
+    char *grown = realloc(mpac->buffer, alloc);
+    if (grown == NULL) {
+        return false;
+    }
+    mpac->buffer = grown;
+    mpac->free = alloc - mpac->used;
+    return true;
+}
+
+char *msgpack_unpacker_buffer(msgpack_unpacker *mpac) {
+    return mpac->buffer + mpac->used;
+}
+
+size_t msgpack_unpacker_buffer_capacity(const msgpack_unpacker *mpac) {
+    return mpac->free;
+}
+
+void msgpack_unpacker_buffer_consumed(msgpack_unpacker *mpac, size_t size) {
+    mpac->used += size;
+    mpac->free -= size;
+}
+
+void msgpack_unpacker_reset(msgpack_unpacker *mpac) {
+    mpac->parsed = 0;
+}
+
+void msgpack_unpacked_init(msgpack_unpacked *result) {
+    memset(result, 0, sizeof(msgpack_unpacked));
+}
+
+void msgpack_unpacked_destroy(msgpack_unpacked *result) {
+    zone_free(result->zone);
+    memset(result, 0, sizeof(msgpack_unpacked));
+}
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+    msgpack_zone *zone;
+} unpack_state;
+
+//! 1 if the value is read, 0 if more data is needed, -1 on errors
+static int read_uint(unpack_state *s, size_t bytes, uint64_t *value) {
+    if (s->size - s->pos < bytes) {
+        return 0;
+    }
+    *value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        *value = (*value << 8) | s->data[s->pos++];
+    }
+    return 1;
+}
+
+static int read_raw(unpack_state *s, size_t size, const char **ptr) {
+    if (s->size - s->pos < size) {
+        return 0;
+    }
+    char *copy = zone_alloc(&s->zone, size ? size : 1);
+    if (copy == NULL) {
+        return -1;
+    }
+    memcpy(copy, s->data + s->pos, size);
+    s->pos += size;
+    *ptr = copy;
+    return 1;
+}
+
+static int unpack_object(unpack_state *s, msgpack_object *obj, int depth);
+
+static int unpack_container(unpack_state *s, msgpack_object *obj, uint64_t n, bool map, int depth) {
+    if (depth >= UNPACK_MAX_DEPTH) {
+        return -1;
+    }
+    if (n > s->size - s->pos) {
+        // every element needs at least one byte
+        return 0;
+    }
+    size_t elements = map ? 2 * (size_t)n : (size_t)n;
+    msgpack_object *items = zone_alloc(&s->zone, (elements ? elements : 1) * sizeof(msgpack_object));
+    if (items == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < elements; ++i) {
+        int ret = unpack_object(s, &items[i], depth + 1);
+        if (ret <= 0) {
+            return ret;
+        }
+    }
+    if (map) {
+        // msgpack_object_kv is a pair of objects
+        obj->type = MSGPACK_OBJECT_MAP;
+        obj->via.map.size = (uint32_t)n;
+        obj->via.map.ptr = (msgpack_object_kv *)items;
+    } else {
+        obj->type = MSGPACK_OBJECT_ARRAY;
+        obj->via.array.size = (uint32_t)n;
+        obj->via.array.ptr = items;
+    }
+    return 1;
+}
+
+static int unpack_object(unpack_state *s, msgpack_object *obj, int depth) {
+    uint64_t v = 0;
+    int ret;
+    if (s->pos >= s->size) {
+        return 0;
+    }
+    uint8_t head = s->data[s->pos++];
+    if (head < 0x80 || head >= 0xe0) {
+        obj->type = head < 0x80 ? MSGPACK_OBJECT_POSITIVE_INTEGER : MSGPACK_OBJECT_NEGATIVE_INTEGER;
+        obj->via.i64 = (int8_t)head;
+        return 1;
+    } else if (head < 0x90) {
+        return unpack_container(s, obj, head & 0x0f, true, depth);
+    } else if (head < 0xa0) {
+        return unpack_container(s, obj, head & 0x0f, false, depth);
+    } else if (head < 0xc0) {
+        obj->type = MSGPACK_OBJECT_STR;
+        obj->via.str.size = head & 0x1f;
+        return read_raw(s, obj->via.str.size, &obj->via.str.ptr);
+    }
+    switch (head) {
+        case 0xc0:
+            obj->type = MSGPACK_OBJECT_NIL;
+            return 1;
+        case 0xc2:
+        case 0xc3:
+            obj->type = MSGPACK_OBJECT_BOOLEAN;
+            obj->via.boolean = head == 0xc3;
+            return 1;
+        case 0xc4:
+        case 0xc5:
+        case 0xc6:
+            if ((ret = read_uint(s, (size_t)1 << (head - 0xc4), &v)) <= 0) {
+                return ret;
+            }
+            obj->type = MSGPACK_OBJECT_BIN;
+            obj->via.bin.size = (uint32_t)v;
+            return read_raw(s, (size_t)v, &obj->via.bin.ptr);
+        case 0xca:
+        case 0xcb: {
+            if ((ret = read_uint(s, head == 0xca ? 4 : 8, &v)) <= 0) {
+                return ret;
+            }
+            if (head == 0xca) {
+                float f;
+                uint32_t bits = (uint32_t)v;
+                memcpy(&f, &bits, sizeof(f));
+                obj->type = MSGPACK_OBJECT_FLOAT32;
+                obj->via.f64 = f;
+            } else {
+                obj->type = MSGPACK_OBJECT_FLOAT64;
+                memcpy(&obj->via.f64, &v, sizeof(double));
+            }
+            return 1;
+        }
+        case 0xcc:
+        case 0xcd:
+        case 0xce:
+        case 0xcf:
+            if ((ret = read_uint(s, (size_t)1 << (head - 0xcc), &v)) <= 0) {
+                return ret;
+            }
+            obj->type = MSGPACK_OBJECT_POSITIVE_INTEGER;
+            obj->via.u64 = v;
+            return 1;
+        case 0xd0:
+        case 0xd1:
+        case 0xd2:
+        case 0xd3: {
+            size_t bytes = (size_t)1 << (head - 0xd0);
+            if ((ret = read_uint(s, bytes, &v)) <= 0) {
+                return ret;
+            }
+            // sign extension
+            int shift = 64 - 8 * (int)bytes;
+            int64_t i = (int64_t)(v << shift) >> shift;
+            obj->type = i < 0 ? MSGPACK_OBJECT_NEGATIVE_INTEGER : MSGPACK_OBJECT_POSITIVE_INTEGER;
+            obj->via.i64 = i;
+            return 1;
+        }
+        case 0xd9:
+        case 0xda:
+        case 0xdb:
+            if ((ret = read_uint(s, (size_t)1 << (head - 0xd9), &v)) <= 0) {
+                return ret;
+            }
+            obj->type = MSGPACK_OBJECT_STR;
+            obj->via.str.size = (uint32_t)v;
+            return read_raw(s, (size_t)v, &obj->via.str.ptr);
+        case 0xdc:
+        case 0xdd:
+            if ((ret = read_uint(s, head == 0xdc ? 2 : 4, &v)) <= 0) {
+                return ret;
+            }
+            return unpack_container(s, obj, v, false, depth);
+        case 0xde:
+        case 0xdf:
+            if ((ret = read_uint(s, head == 0xde ? 2 : 4, &v)) <= 0) {
+                return ret;
+            }
+            return unpack_container(s, obj, v, true, depth);
+        default:
+            // ext types are not used by the gateway
+            return -1;
+    }
+}
+
+msgpack_unpack_return msgpack_unpacker_next(msgpack_unpacker *mpac, msgpack_unpacked *result) {
+    msgpack_unpacked_destroy(result);
+    unpack_state s = {
+            .data = (const unsigned char *)mpac->buffer + mpac->off,
+            .size = mpac->used - mpac->off,
+    };
+    int ret = unpack_object(&s, &result->data, 0);
+    if (ret <= 0) {
+        zone_free(s.zone);
+        memset(&result->data, 0, sizeof(msgpack_object));
+        return ret == 0 ? MSGPACK_UNPACK_CONTINUE : MSGPACK_UNPACK_PARSE_ERROR;
+    }
+    result->zone = s.zone;
+    mpac->off += s.pos;
+    mpac->parsed += s.pos;
+    return MSGPACK_UNPACK_SUCCESS;
+}
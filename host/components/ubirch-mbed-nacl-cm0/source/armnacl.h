@@ -0,0 +1,70 @@
+/*!
+ * @file armnacl.h
+ * @brief Stand-in of the NaCl subset of ubirch-mbed-nacl-cm0 for the host build.
+ *
+ * Only ed25519 signatures and SHA-512, which the gateway uses. The field
+ * arithmetic follows TweetNaCl, it is neither fast nor constant time and
+ * must not be used on a device.
+ *
+ * @date   2026-10-17
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef ARMNACL_H
+#define ARMNACL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define crypto_sign_BYTES 64
+#define crypto_sign_PUBLICKEYBYTES 32
+#define crypto_sign_SECRETKEYBYTES 64
+#define crypto_hash_sha512_BYTES 64
+
+/*!
+ * Random source, provided by the platform.
+ */
+void randombytes(unsigned char *buffer, unsigned long long length);
+
+int crypto_hash_sha512(unsigned char *out, const unsigned char *m, unsigned long long mlen);
+
+/*!
+ * Create a key pair, the secret key is the random seed followed by the public key.
+ */
+int crypto_sign_keypair(unsigned char *pk, unsigned char *sk);
+
+/*!
+ * Sign \p m, \p sm gets the signature followed by the message, \p mlen + 64 bytes.
+ */
+int crypto_sign(unsigned char *sm, unsigned long long *smlen,
+                const unsigned char *m, unsigned long long mlen, const unsigned char *sk);
+
+/*!
+ * Open the signed message \p sm, \p m needs \p smlen bytes of space.
+ *
+ * @return 0 if the signature is valid, -1 else
+ */
+int crypto_sign_open(unsigned char *m, unsigned long long *mlen,
+                     const unsigned char *sm, unsigned long long smlen, const unsigned char *pk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARMNACL_H
@@ -0,0 +1,403 @@
+/*!
+ * @file nacl.c
+ * @brief ed25519 signatures of the NaCl stand-in, after TweetNaCl.
+ *
+ * @date   2026-10-17
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "armnacl.h"
+
+//! element of GF(2^255 - 19) in 16 limbs of 16 bits
+typedef int64_t gf[16];
+
+static const gf gf0;
+static const gf gf1 = { 1 };
+static const gf D = {
+        0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070,
+        0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203,
+};
+static const gf D2 = {
+        0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0,
+        0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406,
+};
+static const gf X = {
+        0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c,
+        0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169,
+};
+static const gf Y = {
+        0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666,
+        0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666,
+};
+static const gf I = {
+        0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43,
+        0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83,
+};
+
+//! order of the base point, little endian
+static const int64_t L[32] = {
+        0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x10,
+};
+
+static int verify_32(const unsigned char *x, const unsigned char *y) {
+    unsigned int d = 0;
+    for (int i = 0; i < 32; ++i) {
+        d |= x[i] ^ y[i];
+    }
+    return (1 & ((d - 1) >> 8)) - 1;
+}
+
+static void set25519(gf r, const gf a) {
+    memcpy(r, a, sizeof(gf));
+}
+
+static void car25519(gf o) {
+    for (int i = 0; i < 16; ++i) {
+        o[i] += (int64_t)1 << 16;
+        int64_t c = o[i] >> 16;
+        o[(i + 1) * (i < 15)] += c - 1 + 37 * (c - 1) * (i == 15);
+        o[i] -= c * 65536;
+    }
+}
+
+static void sel25519(gf p, gf q, int b) {
+    int64_t c = ~(b - 1);
+    for (int i = 0; i < 16; ++i) {
+        int64_t t = c & (p[i] ^ q[i]);
+        p[i] ^= t;
+        q[i] ^= t;
+    }
+}
+
+static void pack25519(unsigned char *o, const gf n) {
+    gf m, t;
+    set25519(t, n);
+    car25519(t);
+    car25519(t);
+    car25519(t);
+    for (int j = 0; j < 2; ++j) {
+        m[0] = t[0] - 0xffed;
+        for (int i = 1; i < 15; ++i) {
+            m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        int b = (int)((m[15] >> 16) & 1);
+        m[14] &= 0xffff;
+        sel25519(t, m, 1 - b);
+    }
+    for (int i = 0; i < 16; ++i) {
+        o[2 * i] = (unsigned char)(t[i] & 0xff);
+        o[2 * i + 1] = (unsigned char)(t[i] >> 8);
+    }
+}
+
+static int neq25519(const gf a, const gf b) {
+    unsigned char c[32], d[32];
+    pack25519(c, a);
+    pack25519(d, b);
+    return verify_32(c, d);
+}
+
+static int par25519(const gf a) {
+    unsigned char d[32];
+    pack25519(d, a);
+    return d[0] & 1;
+}
+
+static void unpack25519(gf o, const unsigned char *n) {
+    for (int i = 0; i < 16; ++i) {
+        o[i] = n[2 * i] + ((int64_t)n[2 * i + 1] << 8);
+    }
+    o[15] &= 0x7fff;
+}
+
+static void A(gf o, const gf a, const gf b) {
+    for (int i = 0; i < 16; ++i) {
+        o[i] = a[i] + b[i];
+    }
+}
+
+static void Z(gf o, const gf a, const gf b) {
+    for (int i = 0; i < 16; ++i) {
+        o[i] = a[i] - b[i];
+    }
+}
+
+static void M(gf o, const gf a, const gf b) {
+    int64_t t[31] = { 0 };
+    for (int i = 0; i < 16; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            t[i + j] += a[i] * b[j];
+        }
+    }
+    for (int i = 0; i < 15; ++i) {
+        t[i] += 38 * t[i + 16];
+    }
+    memcpy(o, t, sizeof(gf));
+    car25519(o);
+    car25519(o);
+}
+
+static void S(gf o, const gf a) {
+    M(o, a, a);
+}
+
+static void inv25519(gf o, const gf i) {
+    gf c;
+    set25519(c, i);
+    for (int a = 253; a >= 0; --a) {
+        S(c, c);
+        if (a != 2 && a != 4) {
+            M(c, c, i);
+        }
+    }
+    set25519(o, c);
+}
+
+static void pow2523(gf o, const gf i) {
+    gf c;
+    set25519(c, i);
+    for (int a = 250; a >= 0; --a) {
+        S(c, c);
+        if (a != 1) {
+            M(c, c, i);
+        }
+    }
+    set25519(o, c);
+}
+
+static void add(gf p[4], gf q[4]) {
+    gf a, b, c, d, t, e, f, g, h;
+    Z(a, p[1], p[0]);
+    Z(t, q[1], q[0]);
+    M(a, a, t);
+    A(b, p[0], p[1]);
+    A(t, q[0], q[1]);
+    M(b, b, t);
+    M(c, p[3], q[3]);
+    M(c, c, D2);
+    M(d, p[2], q[2]);
+    A(d, d, d);
+    Z(e, b, a);
+    Z(f, d, c);
+    A(g, d, c);
+    A(h, b, a);
+    M(p[0], e, f);
+    M(p[1], h, g);
+    M(p[2], g, f);
+    M(p[3], e, h);
+}
+
+static void cswap(gf p[4], gf q[4], int b) {
+    for (int i = 0; i < 4; ++i) {
+        sel25519(p[i], q[i], b);
+    }
+}
+
+static void pack(unsigned char *r, gf p[4]) {
+    gf tx, ty, zi;
+    inv25519(zi, p[2]);
+    M(tx, p[0], zi);
+    M(ty, p[1], zi);
+    pack25519(r, ty);
+    r[31] ^= (unsigned char)(par25519(tx) << 7);
+}
+
+static void scalarmult(gf p[4], gf q[4], const unsigned char *s) {
+    set25519(p[0], gf0);
+    set25519(p[1], gf1);
+    set25519(p[2], gf1);
+    set25519(p[3], gf0);
+    for (int i = 255; i >= 0; --i) {
+        int b = (s[i / 8] >> (i & 7)) & 1;
+        cswap(p, q, b);
+        add(q, p);
+        add(p, p);
+        cswap(p, q, b);
+    }
+}
+
+static void scalarbase(gf p[4], const unsigned char *s) {
+    gf q[4];
+    set25519(q[0], X);
+    set25519(q[1], Y);
+    set25519(q[2], gf1);
+    M(q[3], X, Y);
+    scalarmult(p, q, s);
+}
+
+static void mod_l(unsigned char *r, int64_t x[64]) {
+    int64_t carry;
+    for (int i = 63; i >= 32; --i) {
+        int j;
+        carry = 0;
+        for (j = i - 32; j < i - 12; ++j) {
+            x[j] += carry - 16 * x[i] * L[j - (i - 32)];
+            carry = (x[j] + 128) >> 8;
+            x[j] -= carry * 256;
+        }
+        x[j] += carry;
+        x[i] = 0;
+    }
+    carry = 0;
+    for (int j = 0; j < 32; ++j) {
+        x[j] += carry - (x[31] >> 4) * L[j];
+        carry = x[j] >> 8;
+        x[j] &= 255;
+    }
+    for (int j = 0; j < 32; ++j) {
+        x[j] -= carry * L[j];
+    }
+    for (int i = 0; i < 32; ++i) {
+        x[i + 1] += x[i] >> 8;
+        r[i] = (unsigned char)(x[i] & 255);
+    }
+}
+
+static void reduce(unsigned char *r) {
+    int64_t x[64];
+    for (int i = 0; i < 64; ++i) {
+        x[i] = r[i];
+        r[i] = 0;
+    }
+    mod_l(r, x);
+}
+
+static void secret_scalar(unsigned char d[64], const unsigned char *sk) {
+    crypto_hash_sha512(d, sk, 32);
+    d[0] &= 248;
+    d[31] &= 127;
+    d[31] |= 64;
+}
+
+int crypto_sign_keypair(unsigned char *pk, unsigned char *sk) {
+    unsigned char d[64];
+    gf p[4];
+
+    randombytes(sk, 32);
+    secret_scalar(d, sk);
+    scalarbase(p, d);
+    pack(pk, p);
+    memcpy(sk + 32, pk, 32);
+    return 0;
+}
+
+int crypto_sign(unsigned char *sm, unsigned long long *smlen,
+                const unsigned char *m, unsigned long long mlen, const unsigned char *sk) {
+    unsigned char d[64], h[64], r[64];
+    int64_t x[64] = { 0 };
+    gf p[4];
+
+    secret_scalar(d, sk);
+    *smlen = mlen + 64;
+    memmove(sm + 64, m, (size_t)mlen);
+    memcpy(sm + 32, d + 32, 32);
+    // r = H(prefix || M), R = [r]B
+    crypto_hash_sha512(r, sm + 32, mlen + 32);
+    reduce(r);
+    scalarbase(p, r);
+    pack(sm, p);
+    // S = r + H(R || A || M) a
+    memcpy(sm + 32, sk + 32, 32);
+    crypto_hash_sha512(h, sm, mlen + 64);
+    reduce(h);
+    for (int i = 0; i < 32; ++i) {
+        x[i] = r[i];
+    }
+    for (int i = 0; i < 32; ++i) {
+        for (int j = 0; j < 32; ++j) {
+            x[i + j] += h[i] * (int64_t)d[j];
+        }
+    }
+    mod_l(sm + 32, x);
+    return 0;
+}
+
+/*!
+ * Decode the point \p p and negate it.
+ */
+static int unpackneg(gf r[4], const unsigned char p[32]) {
+    gf t, chk, num, den, den2, den4, den6;
+    set25519(r[2], gf1);
+    unpack25519(r[1], p);
+    S(num, r[1]);
+    M(den, num, D);
+    Z(num, num, r[2]);
+    A(den, r[2], den);
+
+    S(den2, den);
+    S(den4, den2);
+    M(den6, den4, den2);
+    M(t, den6, num);
+    M(t, t, den);
+
+    pow2523(t, t);
+    M(t, t, num);
+    M(t, t, den);
+    M(t, t, den);
+    M(r[0], t, den);
+
+    S(chk, r[0]);
+    M(chk, chk, den);
+    if (neq25519(chk, num)) {
+        M(r[0], r[0], I);
+    }
+    S(chk, r[0]);
+    M(chk, chk, den);
+    if (neq25519(chk, num)) {
+        return -1;
+    }
+    if (par25519(r[0]) == (p[31] >> 7)) {
+        Z(r[0], gf0, r[0]);
+    }
+    M(r[3], r[0], r[1]);
+    return 0;
+}
+
+int crypto_sign_open(unsigned char *m, unsigned long long *mlen,
+                     const unsigned char *sm, unsigned long long smlen, const unsigned char *pk) {
+    unsigned char t[32], h[64];
+    gf p[4], q[4];
+
+    *mlen = (unsigned long long)-1;
+    if (smlen < 64 || unpackneg(q, pk) != 0) {
+        return -1;
+    }
+    memmove(m, sm, (size_t)smlen);
+    memcpy(m + 32, pk, 32);
+    crypto_hash_sha512(h, m, smlen);
+    reduce(h);
+    // [S]B - [h]A has to be R
+    scalarmult(p, q, h);
+    scalarbase(q, sm + 32);
+    add(p, q);
+    pack(t, p);
+    smlen -= 64;
+    if (verify_32(sm, t) != 0) {
+        memset(m, 0, (size_t)smlen);
+        return -1;
+    }
+    memmove(m, sm + 64, (size_t)smlen);
+    *mlen = smlen;
+    return 0;
+}
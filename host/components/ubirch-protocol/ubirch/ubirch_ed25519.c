@@ -0,0 +1,64 @@
+/*!
+ * @file ubirch_ed25519.c
+ * @brief ed25519 helpers of the ubirch-protocol stand-in for the host build.
+ *
+ * @date   2026-10-17
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ubirch_ed25519.h"
+
+int ed25519_sign_key(const unsigned char *data, size_t len, unsigned char signature[crypto_sign_BYTES],
+                     const unsigned char secret_key[crypto_sign_SECRETKEYBYTES]) {
+    unsigned long long signed_len;
+    unsigned char *signed_message = malloc(crypto_sign_BYTES + len);
+    if (signed_message == NULL) {
+        return -1;
+    }
+    crypto_sign(signed_message, &signed_len, data, len, secret_key);
+    memcpy(signature, signed_message, crypto_sign_BYTES);
+    free(signed_message);
+    return 0;
+}
+
+int ed25519_sign(const unsigned char *data, size_t len, unsigned char signature[crypto_sign_BYTES]) {
+    return ed25519_sign_key(data, len, signature, ed25519_secret_key);
+}
+
+int ed25519_verify_key(const unsigned char *data, size_t len, const unsigned char signature[crypto_sign_BYTES],
+                       const unsigned char public_key[crypto_sign_PUBLICKEYBYTES]) {
+    unsigned long long message_len;
+    unsigned char *signed_message = malloc(crypto_sign_BYTES + len);
+    unsigned char *message = malloc(crypto_sign_BYTES + len);
+    int result = -1;
+    if (signed_message != NULL && message != NULL) {
+        memcpy(signed_message, signature, crypto_sign_BYTES);
+        memcpy(signed_message + crypto_sign_BYTES, data, len);
+        result = crypto_sign_open(message, &message_len, signed_message, crypto_sign_BYTES + len, public_key);
+    }
+    free(signed_message);
+    free(message);
+    return result == 0 ? 0 : -1;
+}
+
+int ed25519_verify(const unsigned char *data, size_t len, const unsigned char signature[crypto_sign_BYTES]) {
+    return ed25519_verify_key(data, len, signature, ed25519_public_key);
+}
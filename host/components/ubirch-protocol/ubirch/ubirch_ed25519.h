@@ -0,0 +1,58 @@
+/*!
+ * @file ubirch_ed25519.h
+ * @brief ed25519 helpers of the ubirch-protocol stand-in for the host build.
+ *
+ * @date   2026-10-17
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef UBIRCH_ED25519_H
+#define UBIRCH_ED25519_H
+
+#include <stddef.h>
+#include <armnacl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! key pair of the current context, provided by the key storage
+extern unsigned char ed25519_secret_key[crypto_sign_SECRETKEYBYTES];
+extern unsigned char ed25519_public_key[crypto_sign_PUBLICKEYBYTES];
+
+/*!
+ * Sign \p data with ed25519_secret_key, 0 on success.
+ */
+int ed25519_sign(const unsigned char *data, size_t len, unsigned char signature[crypto_sign_BYTES]);
+
+int ed25519_sign_key(const unsigned char *data, size_t len, unsigned char signature[crypto_sign_BYTES],
+                     const unsigned char secret_key[crypto_sign_SECRETKEYBYTES]);
+
+/*!
+ * Verify \p signature of \p data with ed25519_public_key, 0 if it is valid.
+ */
+int ed25519_verify(const unsigned char *data, size_t len, const unsigned char signature[crypto_sign_BYTES]);
+
+int ed25519_verify_key(const unsigned char *data, size_t len, const unsigned char signature[crypto_sign_BYTES],
+                       const unsigned char public_key[crypto_sign_PUBLICKEYBYTES]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UBIRCH_ED25519_H
@@ -0,0 +1,118 @@
+/*!
+ * @file ubirch_protocol.c
+ * @brief Stand-in of the ubirch protocol (UPP) version 2 for the host build.
+ *
+ * @date   2026-10-17
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <armnacl.h>
+
+#include "ubirch_protocol.h"
+
+//! the packed signature: bin 8 header and 64 bytes
+#define UPP_SIGNATURE_PACKED_SIZE (2 + UBIRCH_PROTOCOL_SIGN_SIZE)
+
+static int upp_write(void *data, const char *buf, size_t len) {
+    ubirch_protocol *upp = data;
+    if (upp->size + len > upp->alloc) {
+        size_t alloc = upp->alloc ? upp->alloc : 256;
+        while (alloc < upp->size + len) {
+            alloc *= 2;
+        }
+        char *grown = realloc(upp->data, alloc);
+        if (grown == NULL) {
+            return -1;
+        }
+        upp->data = grown;
+        upp->alloc = alloc;
+    }
+    memcpy(upp->data + upp->size, buf, len);
+    upp->size += len;
+    return 0;
+}
+
+ubirch_protocol *ubirch_protocol_new(const unsigned char uuid[UBIRCH_PROTOCOL_UUID_SIZE], ubirch_protocol_sign sign) {
+    ubirch_protocol *upp = calloc(1, sizeof(ubirch_protocol));
+    if (upp == NULL) {
+        return NULL;
+    }
+    memcpy(upp->uuid, uuid, UBIRCH_PROTOCOL_UUID_SIZE);
+    upp->sign = sign;
+    return upp;
+}
+
+void ubirch_protocol_free(ubirch_protocol *upp) {
+    if (upp != NULL) {
+        free(upp->data);
+        free(upp);
+    }
+}
+
+int8_t ubirch_protocol_message(ubirch_protocol *upp, ubirch_protocol_variant variant, uint8_t payload_type,
+                               const char *payload, size_t payload_len) {
+    if (upp == NULL || (variant != proto_plain && upp->sign == NULL)) {
+        return -1;
+    }
+    msgpack_packer pk;
+    msgpack_packer_init(&pk, upp, upp_write);
+    upp->size = 0;
+
+    int err = msgpack_pack_array(&pk, variant == proto_chained ? 6 : (variant == proto_signed ? 5 : 4));
+    err |= msgpack_pack_uint8(&pk, (uint8_t)variant);
+    err |= msgpack_pack_bin(&pk, UBIRCH_PROTOCOL_UUID_SIZE);
+    err |= msgpack_pack_bin_body(&pk, upp->uuid, UBIRCH_PROTOCOL_UUID_SIZE);
+    if (variant == proto_chained) {
+        err |= msgpack_pack_bin(&pk, UBIRCH_PROTOCOL_SIGN_SIZE);
+        err |= msgpack_pack_bin_body(&pk, upp->signature, UBIRCH_PROTOCOL_SIGN_SIZE);
+    }
+    err |= msgpack_pack_uint8(&pk, payload_type);
+    if (payload_type == UBIRCH_PROTOCOL_TYPE_BIN) {
+        err |= msgpack_pack_bin(&pk, payload_len);
+        err |= msgpack_pack_bin_body(&pk, payload, payload_len);
+    } else {
+        err |= upp_write(upp, payload, payload_len);
+    }
+    if (err != 0) {
+        return -1;
+    }
+    if (variant == proto_plain) {
+        return 0;
+    }
+
+    unsigned char hash[crypto_hash_sha512_BYTES];
+    crypto_hash_sha512(hash, (const unsigned char *)upp->data, upp->size);
+    if (upp->sign(hash, sizeof(hash), upp->signature) != 0) {
+        return -1;
+    }
+    err = msgpack_pack_bin(&pk, UBIRCH_PROTOCOL_SIGN_SIZE);
+    err |= msgpack_pack_bin_body(&pk, upp->signature, UBIRCH_PROTOCOL_SIGN_SIZE);
+    return err == 0 ? 0 : -1;
+}
+
+int8_t ubirch_protocol_verify(const char *data, size_t data_len, ubirch_protocol_check verify) {
+    if (data == NULL || verify == NULL || data_len <= UPP_SIGNATURE_PACKED_SIZE) {
+        return -1;
+    }
+    unsigned char hash[crypto_hash_sha512_BYTES];
+    crypto_hash_sha512(hash, (const unsigned char *)data, data_len - UPP_SIGNATURE_PACKED_SIZE);
+    return verify(hash, sizeof(hash), (const unsigned char *)data + data_len - UBIRCH_PROTOCOL_SIGN_SIZE) == 0 ? 0 : -1;
+}
@@ -0,0 +1,100 @@
+/*!
+ * @file ubirch_protocol.h
+ * @brief Stand-in of the ubirch protocol (UPP) version 2 for the host build.
+ *
+ * Creates and verifies plain, signed and chained UPPs with the same layout as
+ * the ubirch-protocol component: the signature covers the SHA-512 of the
+ * packed message up to the signature.
+ *
+ * @date   2026-10-17
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef UBIRCH_PROTOCOL_H
+#define UBIRCH_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <msgpack.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UBIRCH_PROTOCOL_UUID_SIZE 16
+#define UBIRCH_PROTOCOL_SIGN_SIZE 64
+#define UBIRCH_PROTOCOL_PUBKEY_SIZE 32
+
+//! payload types, binary payloads are packed as bin, all others are packed msgpack
+#define UBIRCH_PROTOCOL_TYPE_BIN 0x00
+#define UBIRCH_PROTOCOL_TYPE_REG 0x01
+#define UBIRCH_PROTOCOL_TYPE_MSGPACK 0x32
+
+typedef enum ubirch_protocol_variant {
+    proto_plain = 0x21,     //!< plain message, no signature
+    proto_signed = 0x22,    //!< signed message
+    proto_chained = 0x23,   //!< signed message, chained to the signature of the previous message
+} ubirch_protocol_variant;
+
+/*!
+ * Sign \p len bytes of \p buf into \p signature, 0 on success.
+ */
+typedef int (*ubirch_protocol_sign)(const unsigned char *buf, size_t len,
+                                    unsigned char signature[UBIRCH_PROTOCOL_SIGN_SIZE]);
+
+/*!
+ * Verify the \p signature of \p len bytes of \p buf, 0 if it is valid.
+ */
+typedef int (*ubirch_protocol_check)(const unsigned char *buf, size_t len,
+                                     const unsigned char signature[UBIRCH_PROTOCOL_SIGN_SIZE]);
+
+typedef struct ubirch_protocol {
+    char *data;                                         //!< the packed message
+    size_t size;                                        //!< bytes in data
+    size_t alloc;                                       //!< allocated bytes of data
+    ubirch_protocol_sign sign;                          //!< signing function
+    unsigned char uuid[UBIRCH_PROTOCOL_UUID_SIZE];      //!< uuid of the sender
+    unsigned char signature[UBIRCH_PROTOCOL_SIGN_SIZE]; //!< signature of the last message, chained into the next
+} ubirch_protocol;
+
+ubirch_protocol *ubirch_protocol_new(const unsigned char uuid[UBIRCH_PROTOCOL_UUID_SIZE], ubirch_protocol_sign sign);
+
+void ubirch_protocol_free(ubirch_protocol *upp);
+
+/*!
+ * Create a message of \p variant with the payload into upp->data, a chained
+ * message contains the signature in upp->signature, which is replaced by the
+ * signature of the new message.
+ *
+ * @return 0 on success, -1 else
+ */
+int8_t ubirch_protocol_message(ubirch_protocol *upp, ubirch_protocol_variant variant, uint8_t payload_type,
+                               const char *payload, size_t payload_len);
+
+/*!
+ * Verify the signature at the end of the message in \p data with \p verify.
+ *
+ * @return 0 if the signature is valid, -1 else
+ */
+int8_t ubirch_protocol_verify(const char *data, size_t data_len, ubirch_protocol_check verify);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UBIRCH_PROTOCOL_H
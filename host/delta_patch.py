@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+Create a delta patch from one firmware image to another.
+
+The patch is applied by the firmware update task while it is downloaded,
+with the running image as the old image (see main/delta_patch.h). The new
+image is described by copies from the old image, inserted bytes and runs of
+one byte. The ops are split into frames, one frame per flash sector of the
+new image, every frame with its CRC-32, so an interrupted download continues
+at the last complete frame.
+
+Matches are found with an index of the blocks of the old image at multiples
+of the block size, every match is extended over the bytes before and after.
+A copy with the same distance as the one before is tried first, so a shifted
+part of the image stays one copy.
+
+    $ python3 host/delta_patch.py old.bin new.bin <old version>.patch
+"""
+
+import argparse
+import hashlib
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = b"UBDP"
+VERSION = 1
+SECTOR_SIZE = 4096
+BLOCK_SIZE = 16
+MIN_FILL = 16
+
+OP_COPY = 1
+OP_INSERT = 2
+OP_FILL = 3
+
+
+def diff(old, new):
+    """Return the ops ("copy", offset, length) and ("insert", bytes), which produce new."""
+    index = {}
+    for offset in range(0, len(old) - BLOCK_SIZE + 1, BLOCK_SIZE):
+        index.setdefault(old[offset:offset + BLOCK_SIZE], offset)
+
+    ops = []
+    literal = 0     # start of the bytes without a match
+    pos = 0
+    distance = 0    # old offset - new offset of the last copy
+    while pos + BLOCK_SIZE <= len(new):
+        block = new[pos:pos + BLOCK_SIZE]
+        offset = pos + distance
+        if not (0 <= offset <= len(old) - BLOCK_SIZE and old[offset:offset + BLOCK_SIZE] == block):
+            offset = index.get(block)
+            if offset is None:
+                pos += 1
+                continue
+        start = pos
+        while start > literal and offset > 0 and new[start - 1] == old[offset - 1]:
+            start -= 1
+            offset -= 1
+        end = pos + BLOCK_SIZE
+        old_end = offset + end - start
+        while end < len(new) and old_end < len(old) and new[end] == old[old_end]:
+            end += 1
+            old_end += 1
+        if literal < start:
+            ops.append(("insert", new[literal:start]))
+        ops.append(("copy", offset, end - start))
+        distance = offset - start
+        pos = literal = end
+    if literal < len(new):
+        ops.append(("insert", new[literal:]))
+    return ops
+
+
+def split_fills(ops):
+    """Replace the runs of one byte in the inserted bytes by fill ops."""
+    run = re.compile(rb"(.)\1{%d,}" % (MIN_FILL - 1), re.DOTALL)
+    for op in ops:
+        if op[0] != "insert":
+            yield op
+            continue
+        data = op[1]
+        start = 0
+        for match in run.finditer(data):
+            if start < match.start():
+                yield "insert", data[start:match.start()]
+            yield "fill", data[match.start()], match.end() - match.start()
+            start = match.end()
+        if start < len(data):
+            yield "insert", data[start:]
+
+
+def op_length(op):
+    return len(op[1]) if op[0] == "insert" else op[2]
+
+
+def op_encode(op, done, length):
+    """Encode length bytes of op, starting at its byte done."""
+    if op[0] == "copy":
+        return struct.pack("<BIH", OP_COPY, op[1] + done, length)
+    if op[0] == "insert":
+        return struct.pack("<BH", OP_INSERT, length) + op[1][done:done + length]
+    return struct.pack("<BHB", OP_FILL, length, op[1])
+
+
+def frame(payload):
+    return struct.pack("<HI", len(payload), zlib.crc32(payload)) + payload
+
+
+def frames(ops):
+    """Split the ops at the sectors of the new image, one frame per sector."""
+    payload = bytearray()
+    filled = 0
+    for op in ops:
+        done = 0
+        length = op_length(op)
+        while done < length:
+            take = min(length - done, SECTOR_SIZE - filled)
+            payload += op_encode(op, done, take)
+            done += take
+            filled += take
+            if filled == SECTOR_SIZE:
+                yield frame(bytes(payload))
+                payload = bytearray()
+                filled = 0
+    if filled:
+        yield frame(bytes(payload))
+
+
+def make_patch(old, new):
+    """Return the patch and the bytes (copied, inserted, filled) of the new image."""
+    if not new:
+        raise ValueError("the new image is empty")
+    ops = list(split_fills(diff(old, new)))
+    header = struct.pack("<4sB3xII32s32s", MAGIC, VERSION, len(old), len(new),
+                         hashlib.sha256(old).digest(), hashlib.sha256(new).digest())
+    counts = {"copy": 0, "insert": 0, "fill": 0}
+    for op in ops:
+        counts[op[0]] += op_length(op)
+    return header + b"".join(frames(ops)), counts
+
+
+def main():
+    parser = argparse.ArgumentParser(description="create a delta patch from one firmware image to another")
+    parser.add_argument("old", help="the running image")
+    parser.add_argument("new", help="the new image")
+    parser.add_argument("patch", help="the patch to write")
+    args = parser.parse_args()
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+    try:
+        patch, counts = make_patch(old, new)
+    except ValueError as e:
+        sys.exit(str(e))
+    with open(args.patch, "wb") as f:
+        f.write(patch)
+    print(f"new image {len(new)} bytes, patch {len(patch)} bytes ({100 * len(patch) / len(new):.1f} %): "
+          f"{counts['copy']} bytes copied, {counts['insert']} inserted, {counts['fill']} filled")
+
+
+if __name__ == "__main__":
+    main()
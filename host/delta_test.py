@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""
+Test the delta patches of the firmware update on image files.
+
+Creates firmware-like images and changed versions of them, makes the
+patches with delta_patch.py and applies them with the delta-apply tool,
+which uses the patch parser of the firmware update: in one go, with
+interrupted downloads, which continue at the stored frame, and with a
+broken frame, which is downloaded again. The results have to be the new
+images, a truncated patch and a patch for another image have to fail.
+
+Prints the size of every patch and the bytes downloaded with interruptions,
+compared to the size of the full image.
+
+    $ python3 host/delta_test.py --tool build-host/delta-apply
+    $ python3 host/delta_test.py --tool build-host/delta-apply --old old.bin --new new.bin
+"""
+
+import argparse
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+
+from delta_patch import make_patch
+
+IMAGE_SIZE = 512 * 1024
+HEADER_SIZE = 80
+FRAME_HEADER_SIZE = 6
+
+
+def firmware(rng, size):
+    """An image of code-like blocks, strings and padding."""
+    words = [rng.randbytes(4) for _ in range(256)]
+    image = bytearray()
+    while len(image) < size * 3 // 4:
+        # instructions repeat, but not in long runs
+        image += b"".join(rng.choice(words) for _ in range(rng.randint(8, 64)))
+    while len(image) < size * 7 // 8:
+        image += b"sensor %d value out of range\0" % rng.randint(0, 10 ** 6)
+    image += b"\xff" * (size - len(image))
+    return bytes(image[:size])
+
+
+def changed(image, rng, count, size=4):
+    """Change count places of size bytes."""
+    image = bytearray(image)
+    for _ in range(count):
+        offset = rng.randrange(len(image) - size)
+        image[offset:offset + size] = rng.randbytes(size)
+    return bytes(image)
+
+
+def relinked(image, rng):
+    """Insert a function and move the addresses of the code behind it."""
+    offset = len(image) // 3
+    image = image[:offset] + rng.randbytes(1200) + image[offset:]
+    image = bytearray(image)
+    for address in range(offset + 1200, len(image) * 3 // 4, 256):
+        image[address:address + 4] = (int.from_bytes(image[address:address + 4], "little") + 1200 & 0xffffffff) \
+            .to_bytes(4, "little")
+    return bytes(image)
+
+
+def cases(rng):
+    """Yield (name, old image, new image)."""
+    old = firmware(rng, IMAGE_SIZE)
+    yield "identical", old, old
+    yield "4 bytes changed", old, changed(old, rng, 1)
+    yield "100 places changed", old, changed(old, rng, 100)
+    yield "1200 bytes inserted", old, old[:IMAGE_SIZE // 2] + rng.randbytes(1200) + old[IMAGE_SIZE // 2:]
+    yield "relinked", old, relinked(old, rng)
+    yield "20 KiB removed", old, old[:IMAGE_SIZE // 4] + old[IMAGE_SIZE // 4 + 20 * 1024:]
+    yield "64 KiB appended", old, old + firmware(rng, 64 * 1024)
+    yield "unrelated", old, firmware(rng, IMAGE_SIZE)
+
+
+def apply(tool, old_path, patch_path, new_path, *options):
+    """Run the tool, return its statistics or None if it failed."""
+    result = subprocess.run([tool, *options, old_path, patch_path, new_path], capture_output=True, text=True)
+    if result.returncode != 0:
+        return None
+    return dict((key, int(value)) for key, value in (item.split("=") for item in result.stdout.split()))
+
+
+def largest_frame(patch):
+    """Size of the largest frame, a download has to get at least one frame between the interruptions."""
+    offset = HEADER_SIZE
+    largest = 0
+    while offset < len(patch):
+        size = FRAME_HEADER_SIZE + struct.unpack_from("<H", patch, offset)[0]
+        largest = max(largest, size)
+        offset += size
+    return largest
+
+
+def check(tool, directory, name, old, new):
+    """Apply the patch of one case in all ways, return the row of the table or None."""
+    patch, _ = make_patch(old, new)
+    paths = [os.path.join(directory, file) for file in ("old.bin", "new.bin", "patch", "out.bin")]
+    old_path, new_path, patch_path, out_path = paths
+    for path, data in ((old_path, old), (new_path, new), (patch_path, patch)):
+        with open(path, "wb") as f:
+            f.write(data)
+
+    ok = True
+    runs = {
+        "plain": (),
+        "interrupted": ("--chunk", "4096", "--drop", str(max(len(patch) // 4, largest_frame(patch)))),
+        "broken frame": ("--corrupt", "100"),
+    }
+    results = {}
+    for run, options in runs.items():
+        result = apply(tool, old_path, patch_path, out_path, *options)
+        with open(out_path, "rb") as f:
+            if result is None or f.read() != new:
+                print(f"FAIL {name}: {run}", file=sys.stderr)
+                ok = False
+        results[run] = result
+    if ok and results["broken frame"]["crc_errors"] != 1:
+        print(f"FAIL {name}: broken frame not detected", file=sys.stderr)
+        ok = False
+
+    with open(patch_path, "wb") as f:
+        f.write(patch[:len(patch) - 100])
+    if apply(tool, old_path, patch_path, out_path) is not None:
+        print(f"FAIL {name}: truncated patch accepted", file=sys.stderr)
+        ok = False
+    with open(patch_path, "wb") as f:
+        f.write(patch)
+    with open(old_path, "wb") as f:
+        f.write(old[:-1])
+    if apply(tool, old_path, patch_path, out_path) is not None:
+        print(f"FAIL {name}: patch for another image accepted", file=sys.stderr)
+        ok = False
+
+    if not ok:
+        return None
+    return (name, len(new), len(patch), 100 * len(patch) / len(new), results["interrupted"]["transferred"],
+            results["interrupted"]["interruptions"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="test the delta patches of the firmware update")
+    parser.add_argument("--tool", required=True, help="the delta-apply program")
+    parser.add_argument("--old", help="an old image to test, together with --new")
+    parser.add_argument("--new", help="a new image to test")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    if args.old and args.new:
+        with open(args.old, "rb") as f:
+            old = f.read()
+        with open(args.new, "rb") as f:
+            tests = [(os.path.basename(args.new), old, f.read())]
+    else:
+        tests = cases(random.Random(args.seed))
+
+    rows = []
+    failed = False
+    with tempfile.TemporaryDirectory() as directory:
+        for name, old, new in tests:
+            row = check(args.tool, directory, name, old, new)
+            failed |= row is None
+            if row is not None:
+                rows.append(row)
+
+    print(f"{'case':<22}{'image':>10}{'patch':>10}{'% image':>9}{'interrupted':>13}{'restarts':>10}")
+    for name, image, patch, percent, transferred, restarts in rows:
+        print(f"{name:<22}{image:>10}{patch:>10}{percent:>9.1f}{transferred:>13}{restarts:>10}")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
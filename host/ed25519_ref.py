@@ -0,0 +1,130 @@
+"""
+ed25519 of RFC 8032 in pure Python, for the host tools when PyNaCl is missing.
+
+Only the part of the PyNaCl API, which the tools use: SigningKey(seed).sign(),
+VerifyKey(key).verify() and BadSignatureError. Slow and not constant time,
+for tests only.
+"""
+
+import hashlib
+
+P = 2 ** 255 - 19
+L = 2 ** 252 + 27742317777372353535851937790883648493
+D = -121665 * pow(121666, P - 2, P) % P
+SQRT_M1 = pow(2, (P - 1) // 4, P)
+
+
+def _sha512_int(*parts):
+    return int.from_bytes(hashlib.sha512(b"".join(parts)).digest(), "little")
+
+
+def _add(p, q):
+    # extended coordinates (X, Y, Z, T), x = X / Z, y = Y / Z, x y = T / Z
+    a = (p[1] - p[0]) * (q[1] - q[0]) % P
+    b = (p[1] + p[0]) * (q[1] + q[0]) % P
+    c = 2 * p[3] * q[3] * D % P
+    d = 2 * p[2] * q[2] % P
+    e, f, g, h = b - a, d - c, d + c, b + a
+    return e * f % P, g * h % P, f * g % P, e * h % P
+
+
+def _mul(s, p):
+    q = (0, 1, 1, 0)
+    while s > 0:
+        if s & 1:
+            q = _add(q, p)
+        p = _add(p, p)
+        s >>= 1
+    return q
+
+
+def _equal(p, q):
+    return (p[0] * q[2] - q[0] * p[2]) % P == 0 and (p[1] * q[2] - q[1] * p[2]) % P == 0
+
+
+def _recover_x(y, sign):
+    if y >= P:
+        return None
+    x2 = (y * y - 1) * pow(D * y * y + 1, P - 2, P)
+    if x2 == 0:
+        return None if sign else 0
+    x = pow(x2, (P + 3) // 8, P)
+    if (x * x - x2) % P != 0:
+        x = x * SQRT_M1 % P
+    if (x * x - x2) % P != 0:
+        return None
+    if (x & 1) != sign:
+        x = P - x
+    return x
+
+
+def _compress(p):
+    zi = pow(p[2], P - 2, P)
+    x, y = p[0] * zi % P, p[1] * zi % P
+    return int.to_bytes(y | ((x & 1) << 255), 32, "little")
+
+
+def _decompress(s):
+    if len(s) != 32:
+        return None
+    y = int.from_bytes(s, "little")
+    sign = y >> 255
+    y &= (1 << 255) - 1
+    x = _recover_x(y, sign)
+    if x is None:
+        return None
+    return x, y, 1, x * y % P
+
+
+G_Y = 4 * pow(5, P - 2, P) % P
+G = (_recover_x(G_Y, 0), G_Y, 1, _recover_x(G_Y, 0) * G_Y % P)
+
+
+class BadSignatureError(Exception):
+    pass
+
+
+class _Signed:
+    def __init__(self, signature, message):
+        self.signature = signature
+        self.message = message
+
+
+class SigningKey:
+    def __init__(self, seed):
+        h = hashlib.sha512(seed).digest()
+        a = int.from_bytes(h[:32], "little")
+        a &= (1 << 254) - 8
+        a |= 1 << 254
+        self._scalar = a
+        self._prefix = h[32:]
+        self.verify_key = VerifyKey(_compress(_mul(a, G)))
+
+    def sign(self, message):
+        r = _sha512_int(self._prefix, message) % L
+        big_r = _compress(_mul(r, G))
+        h = _sha512_int(big_r, bytes(self.verify_key), message) % L
+        s = (r + h * self._scalar) % L
+        signature = big_r + int.to_bytes(s, 32, "little")
+        return _Signed(signature, message)
+
+
+class VerifyKey:
+    def __init__(self, key):
+        self._key = bytes(key)
+        self._point = _decompress(self._key)
+        if self._point is None:
+            raise ValueError("invalid public key")
+
+    def __bytes__(self):
+        return self._key
+
+    def verify(self, message, signature):
+        r = _decompress(signature[:32])
+        s = int.from_bytes(signature[32:64], "little")
+        if len(signature) != 64 or r is None or s >= L:
+            raise BadSignatureError("invalid signature")
+        h = _sha512_int(signature[:32], self._key, message) % L
+        if not _equal(_mul(s, G), _add(r, _mul(h, self._point))):
+            raise BadSignatureError("invalid signature")
+        return message
@@ -0,0 +1,384 @@
+#!/usr/bin/env python3
+"""
+Test the gateway of the host build against the mock backend.
+
+Every scenario starts mock_backend.py, runs example-esp32-host on fresh
+flash files and checks the JSON report of the gateway and the statistics of
+the backend: every reading is anchored, every UPP is verified by the backend
+and no chain is broken.
+
+    $ python3 host/host_test.py --program build-host/example-esp32-host anchor
+"""
+
+import argparse
+import json
+import os
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+import urllib.error
+import urllib.request
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+# the port of the backend URLs in sdkconfig.host
+BACKEND_PORT = 8080
+
+
+class Backend:
+    """mock_backend.py in a process, its statistics are printed when it is interrupted."""
+
+    def __init__(self, *options):
+        self.process = subprocess.Popen(
+            [sys.executable, os.path.join(HERE, "mock_backend.py"), "--port", str(BACKEND_PORT),
+             "--stats-interval", "0", *options], stderr=subprocess.PIPE, text=True)
+        deadline = time.monotonic() + 10
+        while time.monotonic() < deadline:
+            try:
+                urllib.request.urlopen(f"http://127.0.0.1:{BACKEND_PORT}/", timeout=1)
+            except urllib.error.HTTPError:
+                return
+            except OSError:
+                if self.process.poll() is not None:
+                    break
+                time.sleep(0.1)
+        self.stop()
+        raise RuntimeError(f"mock backend did not start on port {BACKEND_PORT}")
+
+    def stop(self):
+        """Stop the backend, return its statistics."""
+        if self.process.poll() is None:
+            self.process.send_signal(signal.SIGINT)
+        _, err = self.process.communicate(timeout=10)
+        lines = [line for line in err.splitlines() if line.startswith("{")]
+        return json.loads(lines[-1]) if lines else {}
+
+
+def run(program, flash, *options, timeout=300):
+    """Run the gateway, return its report."""
+    report_path = os.path.join(flash, "report.json")
+    result = subprocess.run([program, "--flash", flash, "--json", report_path, *options],
+                            capture_output=True, text=True, timeout=timeout)
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout + result.stderr)
+        raise RuntimeError(f"gateway failed with {result.returncode}")
+    with open(report_path) as f:
+        return json.load(f)
+
+
+class Checks:
+    def __init__(self, scenario):
+        self.scenario = scenario
+        self.failed = False
+
+    def check(self, condition, message):
+        print(f"{'ok  ' if condition else 'FAIL'} {self.scenario}: {message}")
+        self.failed |= not condition
+
+
+def anchor(program, flash, checks):
+    """Anchor the readings of 8 sensors without faults, they are onboarded in the warmup."""
+    backend = Backend()
+    try:
+        report = run(program, flash, "--erase-flash", "--sensors", "8", "--rate", "2", "--warmup", "6",
+                     "--duration", "5")
+    finally:
+        stats = backend.stop()
+    readings, delivery = report["readings"], report["delivery"]
+    checks.check(readings["generated"] >= 72, f"{readings['generated']} readings generated")
+    checks.check(readings["lost"] == 0 and report["failed"] == 0,
+                 f"{readings['lost']} readings lost, {report['failed']} failed")
+    # the readings of the warmup and of the measurement are in flight at its start and its end
+    anchored = report["stages"]["end_to_end"]["count"]
+    checks.check(anchored >= readings["generated"] * 0.9, f"{anchored} readings anchored")
+    checks.check(delivery["unverified"] == 0 and delivery["rejected"] == 0,
+                 f"{delivery['unverified']} responses unverified, {delivery['rejected']} UPPs rejected")
+    checks.check(stats.get("upps", 0) >= anchored and stats.get("rejected") == 0,
+                 f"backend verified {stats.get('upps')} UPPs, rejected {stats.get('rejected')}")
+    checks.check(stats.get("keys") == 8 and stats.get("chain_breaks") == 0,
+                 f"backend registered {stats.get('keys')} keys, {stats.get('chain_breaks')} chain breaks")
+
+
+def warm_cache(program, flash, checks):
+    """The contexts of sensors, which fit into the ID context cache, are never read from NVS again."""
+    backend = Backend()
+    try:
+        report = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "4", "--warmup", "5",
+                     "--duration", "5")
+    finally:
+        backend.stop()
+    id_cache = report["id_cache"]
+    checks.check(id_cache["hits"] >= report["readings"]["generated"] * 0.9, f"{id_cache['hits']} cache hits")
+    checks.check(id_cache["misses"] == 0 and id_cache["nvs_loads"] == 0,
+                 f"{id_cache['misses']} cache misses, {id_cache['nvs_loads']} contexts loaded from NVS")
+    # the ID cache keeps the expanded keys, the signer does not hash a secret key again
+    if "signer" in report:
+        signer = report["signer"]
+        checks.check(signer["signs"] > 0 and signer["expansions"] == 0,
+                     f"{signer['signs']} signatures, {signer['expansions']} secret keys expanded")
+    checks.check(report["failed"] == 0, f"{report['failed']} failed")
+
+
+def pooled_keys(program, flash, checks):
+    """The key registrations of the onboarding go through the connection pool, like the UPPs."""
+    backend = Backend()
+    try:
+        report = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "2", "--warmup", "0",
+                     "--duration", "4")
+    finally:
+        stats = backend.stop()
+    pool, anchored = report["http_pool"], report["stages"]["end_to_end"]["count"]
+    checks.check(stats.get("keys") == 4, f"backend registered {stats.get('keys')} keys")
+    checks.check(pool["requests"] >= anchored + stats.get("keys", 0),
+                 f"{pool['requests']} pooled requests for {anchored} UPPs and {stats.get('keys')} keys")
+    checks.check(pool["handshakes"] <= 2, f"{pool['handshakes']} handshakes")
+
+
+def sensor_index(program, flash, checks):
+    """Sensor ids, which are equal in the first 15 characters, get contexts and chains of their own."""
+    backend = Backend()
+    try:
+        report = run(program, flash, "--erase-flash", "--sensors", "8", "--rate", "2", "--warmup", "6",
+                     "--duration", "4", "--id-prefix", "warehouse-north-")
+    finally:
+        stats = backend.stop()
+    index = report["sensor_index"]
+    checks.check(index["sensors"] == 8 and index["lookups"] > 0,
+                 f"{index['sensors']} sensors indexed, {index['lookups']} lookups")
+    checks.check(stats.get("keys") == 8 and stats.get("chain_breaks") == 0,
+                 f"backend registered {stats.get('keys')} keys, {stats.get('chain_breaks')} chain breaks")
+    checks.check(report["failed"] == 0 and report["readings"]["lost"] == 0,
+                 f"{report['readings']['lost']} readings lost, {report['failed']} failed")
+
+
+def fast_boot(program, flash, checks):
+    """The anchoring starts before the network is up, the contexts of the last run are loaded at the start."""
+    backend = Backend()
+    try:
+        first = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "2", "--warmup", "6",
+                    "--duration", "6")
+        second = run(program, flash, "--sensors", "4", "--rate", "2", "--warmup", "0", "--duration", "4")
+    finally:
+        backend.stop()
+    boot = first["boot"]
+    checks.check(0 < boot["anchor_ready_ms"] < boot["network_up_ms"],
+                 f"anchoring ready after {boot['anchor_ready_ms']} ms, network up after {boot['network_up_ms']} ms")
+    # the contexts are stored every 10 s of sdkconfig.host, the runs stop without a shutdown
+    boot = second["boot"]
+    checks.check(boot["prefetched"] == 4 and second["id_cache"]["nvs_loads"] == 0,
+                 f"{boot['prefetched']} contexts prefetched, {second['id_cache']['nvs_loads']} loaded from NVS later")
+    checks.check(0 < boot["first_anchored_ms"], f"first UPP anchored after {boot['first_anchored_ms']} ms")
+
+
+def key_pool(program, flash, checks):
+    """New sensors take their key pairs from the pool, which is filled in the background."""
+    backend = Backend()
+    try:
+        report = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "2", "--warmup", "0",
+                     "--duration", "4")
+    finally:
+        stats = backend.stop()
+    pool, create = report["key_pool"], report["metrics"]["timers"]["create"]
+    checks.check(pool["taken"] > 0 and pool["taken"] + pool["missed"] >= 4,
+                 f"{pool['taken']} key pairs taken from the pool, {pool['missed']} generated at once")
+    checks.check(create["count"] >= 4, f"{create['count']} contexts created, {create['avg_us']} us on average")
+    checks.check(stats.get("keys") == 4, f"backend registered {stats.get('keys')} keys")
+
+
+def budget(program, flash, checks):
+    """The memory of the tasks and queues is reserved statically or on the heap, and reported."""
+    backend = Backend()
+    try:
+        report = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "2", "--warmup", "4",
+                     "--duration", "3")
+    finally:
+        backend.stop()
+    budget = report["budget"]
+    static, heap = budget["static_bytes"], budget["heap_bytes"]
+    # one or the other, by CONFIG_UBIRCH_STATIC_ALLOCATION
+    checks.check((static > 0) != (heap > 0), f"{static} bytes static, {heap} bytes on the heap")
+    tasks = budget["tasks"]
+    checks.check(all(name in tasks and tasks[name]["stack_size"] > 0 for name in ("sign", "transmit", "verify")),
+                 f"stacks of {', '.join(sorted(tasks))}")
+    checks.check(budget["heap_minimum_free"] > 0 and budget["context_size"] > 0,
+                 f"lowest free heap {budget['heap_minimum_free']} bytes, {budget['context_size']} bytes per context")
+    checks.check(report["failed"] == 0, f"{report['failed']} failed")
+
+
+def faults(program, flash, checks):
+    """Failed answers and dropped connections of the backend are retried, no UPP is lost or anchored twice."""
+    backend = Backend("--fail-rate", "0.05", "--fail-status", "500,502,503", "--drop-rate", "0.05", "--seed", "1")
+    try:
+        report = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "1", "--warmup", "6",
+                     "--duration", "16")
+    finally:
+        stats = backend.stop()
+    readings, delivery = report["readings"], report["delivery"]
+    checks.check(stats.get("faults", 0) > 0 and stats.get("dropped", 0) > 0,
+                 f"backend failed {stats.get('faults')} UPPs, dropped {stats.get('dropped')} connections")
+    # a UPP is sent again at once, after its retries it waits in the offline queue or in the transmit stage
+    checks.check(delivery["retries"] + report["retried"] > 0,
+                 f"{delivery['retries']} retries, {report['retried']} UPPs sent again later")
+    checks.check(readings["lost"] == 0 and report["failed"] == 0,
+                 f"{readings['lost']} readings lost, {report['failed']} failed")
+    # the backend backs the gateway off, the UPPs of the last seconds are still in flight at the end
+    checks.check(stats.get("upps", 0) >= readings["generated"] and stats.get("chain_breaks") == 0
+                 and stats.get("rejected") == 0,
+                 f"backend verified {stats.get('upps')} UPPs of {readings['generated']} readings, "
+                 f"{stats.get('chain_breaks')} chain breaks, {stats.get('rejected')} rejected")
+
+
+def ingest(program, flash, checks):
+    """The readings are sent to the ingestion server over TCP and UDP on the loopback interface."""
+    for transport in ("tcp", "udp"):
+        backend = Backend()
+        try:
+            report = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "2", "--warmup", "6",
+                         "--duration", "5", "--ingest", transport, "--connections", "2")
+        finally:
+            stats = backend.stop()
+        readings, server = report["readings"], report["ingest"]
+        checks.check(readings["lost"] == 0 and server["invalid"] == 0 and server["denied"] == 0,
+                     f"{transport}: {readings['lost']} readings lost, {server['invalid']} frames invalid, "
+                     f"{server['denied']} senders denied")
+        # the frames of the warmup and of the measurement are in flight at its start and its end
+        anchored = report["stages"]["end_to_end"]["count"]
+        checks.check(server["frames"] >= readings["generated"] * 0.9 and anchored >= readings["generated"] * 0.9,
+                     f"{transport}: {server['frames']} frames received, {anchored} of {readings['generated']} "
+                     f"readings anchored")
+        checks.check(stats.get("upps", 0) >= anchored and stats.get("chain_breaks") == 0,
+                     f"{transport}: backend verified {stats.get('upps')} UPPs, {stats.get('chain_breaks')} chain breaks")
+
+
+def journal_wear(program, flash, checks):
+    """The chain heads are appended to the journal instead of storing the contexts in NVS, after a stop
+    without a shutdown, like a power failure, the chains continue with the heads of the journal."""
+    backend = Backend()
+    try:
+        first = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "4", "--warmup", "5",
+                    "--duration", "10")
+        second = run(program, flash, "--sensors", "4", "--rate", "4", "--warmup", "2", "--duration", "4")
+    finally:
+        stats = backend.stop()
+    nvs, journal = first["flash"]["nvs"], first["flash"]["journal"]
+    anchored = first["stages"]["end_to_end"]["count"]
+    # a record of a journal has a signature of 64 bytes and its short name
+    checks.check(journal["bytes_written"] >= anchored * 64,
+                 f"{journal['bytes_written']} bytes written to the journal for {anchored} UPPs")
+    checks.check(nvs["bytes_written"] * 4 < journal["bytes_written"],
+                 f"{nvs['bytes_written']} bytes written to NVS")
+    checks.check(stats.get("keys") == 4 and stats.get("chain_breaks") == 0,
+                 f"backend registered {stats.get('keys')} keys, {stats.get('chain_breaks')} chain breaks after the restart")
+    checks.check(second["failed"] == 0 and second["readings"]["lost"] == 0,
+                 f"{second['readings']['lost']} readings lost, {second['failed']} failed after the restart")
+
+
+def key_update(program, flash, checks):
+    """The expired keys are replaced by key updates, which the new and the previous key sign."""
+    backend = Backend()
+    try:
+        run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "2", "--warmup", "6", "--duration", "2")
+        second = run(program, flash, "--expire-keys", "--sensors", "4", "--rate", "2", "--warmup", "6",
+                     "--duration", "4")
+    finally:
+        stats = backend.stop()
+    checks.check(stats.get("keys") == 4 and stats.get("key_updates") == 4,
+                 f"backend registered {stats.get('keys')} keys, updated {stats.get('key_updates')} keys")
+    checks.check(stats.get("rejected") == 0 and stats.get("chain_breaks") == 0,
+                 f"{stats.get('rejected')} requests rejected, {stats.get('chain_breaks')} chain breaks")
+    checks.check(second["failed"] == 0 and second["readings"]["lost"] == 0,
+                 f"{second['readings']['lost']} readings lost, {second['failed']} failed with the new keys")
+
+
+def outage(program, flash, checks):
+    """The UPPs of a backend outage are queued in the flash and delivered, when the backend is back."""
+    # the measurement starts after 6 s, the outage is in its first half
+    backend = Backend("--outage", "8,4")
+    try:
+        report = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "2", "--warmup", "6",
+                     "--duration", "16")
+    finally:
+        stats = backend.stop()
+    readings, rate_control = report["readings"], report["rate_control"]
+    checks.check(stats.get("faults", 0) > 0, f"{stats.get('faults')} UPPs refused in the outage")
+    checks.check(readings["lost"] == 0 and report["failed"] == 0,
+                 f"{readings['lost']} readings lost, {report['failed']} failed")
+    checks.check(report["flash"]["upp_queue"]["bytes_written"] > 0,
+                 f"{report['flash']['upp_queue']['bytes_written']} bytes written to the UPP queue")
+    anchored = report["stages"]["end_to_end"]["count"]
+    checks.check(anchored >= readings["generated"] * 0.9, f"{anchored} of {readings['generated']} readings anchored")
+    checks.check(stats.get("upps", 0) >= readings["generated"] and stats.get("chain_breaks") == 0,
+                 f"backend verified {stats.get('upps')} UPPs, {stats.get('chain_breaks')} chain breaks")
+    # the UPPs of the outage wait in the queue, so the transmit stage fills its batches
+    batches = report["batches"]
+    checks.check(batches["size"] == 1 or batches["upps"] > batches["count"],
+                 f"{batches['upps']} UPPs sent in {batches['count']} batches of up to {batches['size']}")
+    checks.check(rate_control["state"] != "backoff" and rate_control["rate_per_s"] >= 8,
+                 f"send rate recovered to {rate_control['rate_per_s']} UPPs/s")
+
+
+def restart(program, flash, checks):
+    """The UPPs, which are queued when the gateway stops, are delivered after its restart."""
+    # the outage starts in the measurement of the first run and ends in the warmup of the second
+    backend = Backend("--outage", "7,7")
+    try:
+        first = run(program, flash, "--erase-flash", "--sensors", "4", "--rate", "1", "--warmup", "6",
+                    "--duration", "4")
+        second = run(program, flash, "--sensors", "4", "--rate", "1", "--warmup", "6", "--duration", "8")
+    finally:
+        stats = backend.stop()
+    checks.check(stats.get("faults", 0) > 0, f"{stats.get('faults')} UPPs refused in the outage")
+    checks.check(stats.get("keys") == 4, f"backend registered {stats.get('keys')} keys, the contexts were kept")
+    # the backlog is the number of UPPs in the queue, at most a second of readings is in flight
+    checks.check(first["flash"]["upp_queue"]["bytes_written"] > 0 and second["rate_control"]["backlog"] <= 4,
+                 f"{first['flash']['upp_queue']['bytes_written']} bytes queued before the stop, "
+                 f"{second['rate_control']['backlog']} UPPs queued at the end")
+    generated = first["readings"]["generated"] + second["readings"]["generated"]
+    checks.check(stats.get("upps", 0) >= generated and stats.get("chain_breaks") == 0,
+                 f"backend verified {stats.get('upps')} UPPs of {generated} readings, "
+                 f"{stats.get('chain_breaks')} chain breaks")
+    checks.check(second["failed"] == 0 and second["readings"]["lost"] == 0,
+                 f"{second['readings']['lost']} readings lost, {second['failed']} failed after the restart")
+
+
+SCENARIOS = {
+    "anchor": anchor,
+    "budget": budget,
+    "fast_boot": fast_boot,
+    "faults": faults,
+    "ingest": ingest,
+    "journal_wear": journal_wear,
+    "key_pool": key_pool,
+    "key_update": key_update,
+    "outage": outage,
+    "pooled_keys": pooled_keys,
+    "restart": restart,
+    "sensor_index": sensor_index,
+    "warm_cache": warm_cache,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="test the gateway of the host build against the mock backend")
+    parser.add_argument("--program", required=True, help="the example-esp32-host program")
+    parser.add_argument("scenarios", nargs="*", help=f"of {', '.join(sorted(SCENARIOS))}, all if none is given")
+    args = parser.parse_args()
+    unknown = set(args.scenarios) - set(SCENARIOS)
+    if unknown:
+        parser.error(f"unknown scenarios: {', '.join(sorted(unknown))}")
+
+    failed = False
+    for name in args.scenarios or sorted(SCENARIOS):
+        checks = Checks(name)
+        with tempfile.TemporaryDirectory() as flash:
+            try:
+                SCENARIOS[name](args.program, flash, checks)
+            except (RuntimeError, subprocess.TimeoutExpired) as e:
+                checks.check(False, str(e))
+        failed |= checks.failed
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,229 @@
+/*!
+ * @file delta_apply.c
+ * @brief Apply a delta patch to an image file, like the firmware update task does.
+ *
+ * The patch is fed in chunks like the range requests of the device, and the
+ * progress is stored after every chunk. An interruption of the download
+ * every --drop bytes throws the state away and continues from the stored
+ * progress, like a restart of the device. --corrupt flips a bit of the patch
+ * in its first download, so the frame has to be downloaded again. The bytes
+ * downloaded in total are printed with the sizes of the patch and the image.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include <esp_err.h>
+
+#include "delta_patch.h"
+
+typedef struct {
+    size_t chunk;           //!< bytes per range request
+    size_t drop;            //!< bytes after which the download is interrupted, 0 for never
+    long corrupt;           //!< offset of the patch, which is broken in its first download, -1 for none
+    const char *old_path;
+    const char *patch_path;
+    const char *new_path;
+} apply_options_t;
+
+typedef struct {
+    FILE *old;
+    FILE *new;
+} apply_files_t;
+
+// like on the device, the state with its sector buffer is not on the stack
+static ubirch_delta_patch_t patch;
+
+static esp_err_t read_old(void *ctx, uint32_t offset, void *buffer, size_t len) {
+    FILE *old = ((apply_files_t *)ctx)->old;
+    if (fseek(old, offset, SEEK_SET) != 0 || fread(buffer, 1, len, old) != len) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t write_new(void *ctx, uint32_t offset, const void *data, size_t len) {
+    FILE *new = ((apply_files_t *)ctx)->new;
+    if (fseek(new, offset, SEEK_SET) != 0 || fwrite(data, 1, len, new) != len) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [options] OLD PATCH NEW\n"
+            "  --chunk BYTES       bytes per range request (default 16384)\n"
+            "  --drop BYTES        interrupt the download every BYTES bytes and continue like after a restart\n"
+            "  --corrupt OFFSET    flip a bit at OFFSET of the patch in its first download\n",
+            name);
+}
+
+static bool options_parse(int argc, char *argv[], apply_options_t *options) {
+    static const struct option long_options[] = {
+            {"chunk", required_argument, NULL, 'c'},
+            {"drop", required_argument, NULL, 'd'},
+            {"corrupt", required_argument, NULL, 'x'},
+            {"help", no_argument, NULL, 'h'},
+            {NULL, 0, NULL, 0},
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (option) {
+            case 'c': options->chunk = strtoul(optarg, NULL, 10); break;
+            case 'd': options->drop = strtoul(optarg, NULL, 10); break;
+            case 'x': options->corrupt = strtol(optarg, NULL, 10); break;
+            default: return false;
+        }
+    }
+    if (argc - optind != 3) {
+        return false;
+    }
+    options->old_path = argv[optind];
+    options->patch_path = argv[optind + 1];
+    options->new_path = argv[optind + 2];
+    return options->chunk > 0;
+}
+
+static uint8_t *file_load(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = malloc(*size + 1);
+    if (data != NULL && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+int main(int argc, char *argv[]) {
+    apply_options_t options = {
+            .chunk = 16384,
+            .drop = 0,
+            .corrupt = -1,
+    };
+    if (!options_parse(argc, argv, &options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    size_t patch_size;
+    uint8_t *patch_data = file_load(options.patch_path, &patch_size);
+    apply_files_t files = {
+            .old = fopen(options.old_path, "rb"),
+            .new = fopen(options.new_path, "w+b"),
+    };
+    if (patch_data == NULL || files.old == NULL || files.new == NULL) {
+        fprintf(stderr, "failed to open the files\n");
+        return EXIT_FAILURE;
+    }
+    fseek(files.old, 0, SEEK_END);
+    long old_size = ftell(files.old);
+    uint8_t *chunk = malloc(options.chunk);
+
+    // the progress, which the device stores in the NVS
+    uint32_t frame_offset = 0;
+    uint32_t out_offset = 0;
+    size_t transferred = 0;
+    unsigned int interruptions = 0;
+    unsigned int crc_errors = 0;
+    bool corrupted = false;
+    uint32_t retry_offset = 0;
+    esp_err_t err = ESP_OK;
+
+    while (err == ESP_OK) {
+        // a new start, which downloads the header and continues from the stored progress
+        ubirch_delta_patch_init(&patch, read_old, write_new, &files);
+        err = ubirch_delta_patch_feed(&patch, patch_data, MIN(patch_size, UBIRCH_DELTA_HEADER_SIZE));
+        transferred += MIN(patch_size, UBIRCH_DELTA_HEADER_SIZE);
+        if (err != ESP_OK || !patch.header_valid) {
+            fprintf(stderr, "no delta patch\n");
+            return EXIT_FAILURE;
+        }
+        if ((long)patch.header.old_size != old_size) {
+            fprintf(stderr, "patch is made for an image of %u bytes, not %ld\n",
+                    (unsigned int)patch.header.old_size, old_size);
+            return EXIT_FAILURE;
+        }
+        if (frame_offset != 0 && ubirch_delta_patch_resume(&patch, frame_offset, out_offset) != ESP_OK) {
+            fprintf(stderr, "failed to continue the patch\n");
+            return EXIT_FAILURE;
+        }
+        uint32_t start_offset = patch.frame_offset;
+
+        size_t since_start = 0;
+        while (!ubirch_delta_patch_done(&patch) && (options.drop == 0 || since_start < options.drop)) {
+            if (patch.received >= patch_size) {
+                err = ESP_ERR_INVALID_SIZE;
+                break;
+            }
+            size_t len = MIN(options.chunk, patch_size - patch.received);
+            if (options.drop != 0) {
+                len = MIN(len, options.drop - since_start);
+            }
+            memcpy(chunk, patch_data + patch.received, len);
+            if (!corrupted && options.corrupt >= (long)patch.received && options.corrupt < (long)(patch.received + len)) {
+                chunk[options.corrupt - patch.received] ^= 0x10;
+                corrupted = true;
+            }
+            transferred += len;
+            since_start += len;
+            err = ubirch_delta_patch_feed(&patch, chunk, len);
+            if (err == ESP_ERR_INVALID_CRC && patch.frame_offset != retry_offset) {
+                // the frame is downloaded again, a frame, which is broken twice, is broken in the patch
+                crc_errors++;
+                retry_offset = patch.frame_offset;
+                err = ESP_OK;
+            } else if (err != ESP_OK) {
+                break;
+            }
+            frame_offset = patch.frame_offset;
+            out_offset = patch.out_offset;
+        }
+        if (err != ESP_OK || ubirch_delta_patch_done(&patch)) {
+            break;
+        }
+        if (patch.frame_offset == start_offset) {
+            // not even one frame fits into the bytes between the interruptions
+            err = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        interruptions++;
+    }
+    fclose(files.new);
+    fclose(files.old);
+    free(chunk);
+    free(patch_data);
+    if (err != ESP_OK) {
+        fprintf(stderr, "failed at %u of the patch: %s\n", (unsigned int)patch.received, esp_err_to_name(err));
+        return EXIT_FAILURE;
+    }
+    printf("image=%u patch=%zu transferred=%zu interruptions=%u crc_errors=%u\n",
+            (unsigned int)patch.header.new_size, patch_size, transferred, interruptions, crc_errors);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,687 @@
+/*!
+ * @file host_main.c
+ * @brief Entry point of the host build, which benchmarks the gateway with simulated sensors.
+ *
+ * The gateway runs unchanged in its FreeRTOS tasks, app_main() is started in
+ * a task like on the target. After the warmup, in which the sensors are
+ * onboarded, the statistics of the gateway are recorded for the given
+ * duration and written as a report, optionally as JSON for
+ * report_compare.py.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "anchor.h"
+#include "boot.h"
+#include "breaker.h"
+#include "budget.h"
+#include "host_platform.h"
+#include "http_pool.h"
+#include "id_cache.h"
+#include "ingest.h"
+#include "key_pool.h"
+#include "loadgen.h"
+#include "metrics.h"
+#include "pipeline.h"
+#include "rate_control.h"
+#include "sensor_data.h"
+#include "sensor_index.h"
+#include "signer.h"
+
+static const char *TAG = "host";
+
+// partitions, whose wear is reported
+static const char *const flash_labels[] = {
+        "nvs",
+#if CONFIG_UBIRCH_JOURNAL
+        CONFIG_UBIRCH_JOURNAL_PARTITION_LABEL,
+#endif
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+        CONFIG_UBIRCH_QUEUE_PARTITION_LABEL,
+#endif
+};
+#define FLASH_LABELS (sizeof(flash_labels) / sizeof(flash_labels[0]))
+
+void app_main(void);
+
+typedef struct {
+    host_loadgen_config_t loadgen;
+    uint32_t duration_s;
+    uint32_t warmup_s;
+    const char *json_path;
+    bool verbose;
+} host_options_t;
+
+/*!
+ * All statistics at one point in time, the report shows the difference of two snapshots.
+ */
+typedef struct {
+    int64_t time_us;
+    host_loadgen_stats_t loadgen;
+    ubirch_anchor_stats_t anchor;
+    ubirch_id_cache_stats_t id_cache;
+    uint64_t nvs_context_loads;
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+    ubirch_http_pool_stats_t http_pool;
+#endif
+#if CONFIG_UBIRCH_PIPELINE
+    ubirch_pipeline_stats_t pipeline;
+#endif
+#if CONFIG_UBIRCH_SENSOR_INDEX
+    ubirch_sensor_index_stats_t sensor_index;
+#endif
+#if CONFIG_UBIRCH_RATE_CONTROL
+    ubirch_rate_control_stats_t rate_control;
+#endif
+#if CONFIG_UBIRCH_BREAKER
+    ubirch_breaker_stats_t breaker;
+#endif
+#if CONFIG_UBIRCH_FAST_BOOT
+    ubirch_boot_timeline_t boot;
+#endif
+#if CONFIG_UBIRCH_KEY_POOL
+    ubirch_key_pool_stats_t key_pool;
+#endif
+#if CONFIG_UBIRCH_INGEST
+    ubirch_ingest_stats_t ingest;
+#endif
+#if CONFIG_UBIRCH_FAST_SIGN
+    ubirch_signer_stats_t signer;
+#endif
+#if CONFIG_UBIRCH_METRICS
+    ubirch_metrics_stats_t metrics;
+    uint32_t metrics_overhead_ns;
+#endif
+    host_flash_stats_t flash[FLASH_LABELS];
+    host_heap_stats_t heap;
+    ubirch_budget_t budget;
+} host_snapshot_t;
+
+/*!
+ * Latency of a stage within the measurement, from two snapshots.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t avg_us;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} host_latency_t;
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --sensors N         number of simulated sensors (default 100)\n"
+            "  --id-prefix TEXT    beginning of the sensor ids, which are numbered (default sensor-)\n"
+            "  --rate HZ           readings per second of every sensor (default 1)\n"
+            "  --values N          values per reading (default %d)\n"
+            "  --duration S        duration of the measurement in seconds (default 30)\n"
+            "  --warmup S          time to onboard the sensors before the measurement (default 10)\n"
+            "  --block             wait for a free slot instead of losing readings\n"
+            "  --ingest tcp|udp    send the readings to the ingestion server over the loopback interface\n"
+            "  --connections N     TCP connections, which the sensors share (default 1)\n"
+            "  --json FILE         write the report as JSON\n"
+            "  --flash DIR         directory of the partition files (default flash)\n"
+            "  --erase-flash       erase the partitions at the start\n"
+            "  --nvs-latency-us N  simulated latency of an NVS access (default 0)\n"
+            "  --expire-keys       let the keys of the stored contexts expire, to update them\n"
+            "  -v, --verbose       log the gateway at info level\n",
+            name, CONFIG_UBIRCH_SENSOR_MAX_VALUES);
+}
+
+static bool options_parse(int argc, char *argv[], host_options_t *options) {
+    static const struct option long_options[] = {
+            { "sensors", required_argument, NULL, 's' },
+            { "id-prefix", required_argument, NULL, 'i' },
+            { "rate", required_argument, NULL, 'r' },
+            { "values", required_argument, NULL, 'n' },
+            { "duration", required_argument, NULL, 'd' },
+            { "warmup", required_argument, NULL, 'w' },
+            { "block", no_argument, NULL, 'b' },
+            { "ingest", required_argument, NULL, 'g' },
+            { "connections", required_argument, NULL, 'c' },
+            { "json", required_argument, NULL, 'j' },
+            { "flash", required_argument, NULL, 'f' },
+            { "erase-flash", no_argument, NULL, 'e' },
+            { "nvs-latency-us", required_argument, NULL, 'l' },
+            { "expire-keys", no_argument, NULL, 'x' },
+            { "verbose", no_argument, NULL, 'v' },
+            { "help", no_argument, NULL, 'h' },
+            { NULL, 0, NULL, 0 },
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "vh", long_options, NULL)) != -1) {
+        switch (option) {
+            case 's': options->loadgen.sensors = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'i': options->loadgen.id_prefix = optarg; break;
+            case 'r': options->loadgen.rate_hz = strtod(optarg, NULL); break;
+            case 'n': options->loadgen.values = (uint16_t)strtoul(optarg, NULL, 10); break;
+            case 'd': options->duration_s = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'w': options->warmup_s = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'b': options->loadgen.block = true; break;
+            case 'g':
+                if (strcmp(optarg, "tcp") == 0) {
+                    options->loadgen.transport = HOST_LOADGEN_TCP;
+                } else if (strcmp(optarg, "udp") == 0) {
+                    options->loadgen.transport = HOST_LOADGEN_UDP;
+                } else {
+                    return false;
+                }
+                break;
+            case 'c': options->loadgen.connections = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'j': options->json_path = optarg; break;
+            case 'f': host_platform_config.flash_dir = optarg; break;
+            case 'e': host_platform_config.flash_erase = true; break;
+            case 'l': host_platform_config.nvs_latency_us = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'x': host_platform_config.keys_expired = true; break;
+            case 'v': options->verbose = true; break;
+            default: return false;
+        }
+    }
+    return options->loadgen.sensors > 0 && options->loadgen.rate_hz > 0.0 && options->duration_s > 0;
+}
+
+static void snapshot_take(host_snapshot_t *snapshot) {
+    snapshot->time_us = esp_timer_get_time();
+    host_loadgen_stats_get(&snapshot->loadgen);
+    ubirch_anchor_stats_get(&snapshot->anchor);
+    ubirch_id_cache_stats_get(&snapshot->id_cache);
+    snapshot->nvs_context_loads = host_nvs_context_loads();
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+    ubirch_http_pool_stats_get(&snapshot->http_pool);
+#endif
+#if CONFIG_UBIRCH_PIPELINE
+    ubirch_pipeline_stats_get(&snapshot->pipeline);
+#endif
+#if CONFIG_UBIRCH_SENSOR_INDEX
+    ubirch_sensor_index_stats_get(&snapshot->sensor_index);
+#endif
+#if CONFIG_UBIRCH_RATE_CONTROL
+    ubirch_rate_control_stats_get(&snapshot->rate_control);
+#endif
+#if CONFIG_UBIRCH_BREAKER
+    ubirch_breaker_stats_get(&snapshot->breaker);
+#endif
+#if CONFIG_UBIRCH_FAST_BOOT
+    ubirch_boot_timeline_get(&snapshot->boot);
+#endif
+#if CONFIG_UBIRCH_KEY_POOL
+    ubirch_key_pool_stats_get(&snapshot->key_pool);
+#endif
+#if CONFIG_UBIRCH_INGEST
+    ubirch_ingest_stats_get(&snapshot->ingest);
+#endif
+#if CONFIG_UBIRCH_FAST_SIGN
+    ubirch_signer_stats_get(&snapshot->signer);
+#endif
+#if CONFIG_UBIRCH_METRICS
+    ubirch_metrics_stats_get(&snapshot->metrics);
+    snapshot->metrics_overhead_ns = ubirch_metrics_overhead_ns();
+#endif
+    for (size_t i = 0; i < FLASH_LABELS; ++i) {
+        host_flash_stats_get(flash_labels[i], &snapshot->flash[i]);
+    }
+    host_heap_stats_get(&snapshot->heap);
+    ubirch_budget_get(&snapshot->budget);
+}
+
+#if CONFIG_UBIRCH_PIPELINE
+static host_latency_t latency_delta(const ubirch_pipeline_latency_t *start, const ubirch_pipeline_latency_t *end) {
+    host_latency_t latency = { 0 };
+    latency.count = end->count - start->count;
+    if (latency.count == 0) {
+        return latency;
+    }
+    latency.avg_us = (uint32_t)((end->total_us - start->total_us) / latency.count);
+    latency.max_us = end->max_us;
+#if CONFIG_UBIRCH_PIPELINE_PERCENTILES
+    ubirch_pipeline_latency_t delta = { .max_us = end->max_us };
+    for (uint32_t i = 0; i < UBIRCH_PIPELINE_BUCKETS; ++i) {
+        delta.buckets[i] = end->buckets[i] - start->buckets[i];
+    }
+    latency.p50_us = ubirch_pipeline_percentile_us(&delta, 500);
+    latency.p99_us = ubirch_pipeline_percentile_us(&delta, 990);
+    // the maximum of the measurement, not of the warmup
+    latency.max_us = ubirch_pipeline_percentile_us(&delta, 1000);
+#endif
+    return latency;
+}
+#endif
+
+#if CONFIG_UBIRCH_METRICS
+static host_latency_t timer_delta(const ubirch_metrics_histogram_t *start, const ubirch_metrics_histogram_t *end) {
+    host_latency_t latency = { 0 };
+    latency.count = end->count - start->count;
+    if (latency.count == 0) {
+        return latency;
+    }
+    ubirch_metrics_histogram_t delta = { .count = latency.count, .max_us = end->max_us };
+    for (uint32_t i = 0; i < UBIRCH_METRICS_BUCKETS; ++i) {
+        delta.buckets[i] = end->buckets[i] - start->buckets[i];
+    }
+    latency.avg_us = (uint32_t)((end->total_us - start->total_us) / latency.count);
+    latency.p50_us = ubirch_metrics_percentile_us(&delta, 500);
+    latency.p99_us = ubirch_metrics_percentile_us(&delta, 990);
+    latency.max_us = end->max_us;
+    return latency;
+}
+#endif
+
+static void report_print(FILE *out, const host_options_t *options, const host_snapshot_t *start,
+        const host_snapshot_t *end, bool json) {
+    double seconds = (double)(end->time_us - start->time_us) / 1e6;
+    uint64_t generated = end->loadgen.generated - start->loadgen.generated;
+    uint64_t lost = end->loadgen.lost - start->loadgen.lost;
+    uint32_t upps = end->anchor.upps - start->anchor.upps;
+    uint64_t allocations = end->heap.allocations - start->heap.allocations;
+
+    if (json) {
+        fprintf(out, "{\n  \"config\": {\"sensors\": %u, \"rate_hz\": %.3f, \"values\": %u, \"block\": %s, "
+                "\"duration_s\": %.3f},\n",
+                (unsigned int)options->loadgen.sensors, options->loadgen.rate_hz, options->loadgen.values,
+                options->loadgen.block ? "true" : "false", seconds);
+        fprintf(out, "  \"readings\": {\"generated\": %llu, \"lost\": %llu},\n",
+                (unsigned long long)generated, (unsigned long long)lost);
+        fprintf(out, "  \"throughput\": {\"readings_per_s\": %.1f, \"upps_per_s\": %.1f},\n",
+                (double)generated / seconds, (double)upps / seconds);
+    } else {
+        fprintf(out, "\n%u sensors at %.3f Hz, %.1f s measured after %u s warmup\n",
+                (unsigned int)options->loadgen.sensors, options->loadgen.rate_hz, seconds,
+                (unsigned int)options->warmup_s);
+        fprintf(out, "readings    %llu generated (%.1f/s), %llu lost (%.2f%%)\n",
+                (unsigned long long)generated, (double)generated / seconds, (unsigned long long)lost,
+                (generated + lost > 0) ? 100.0 * (double)lost / (double)(generated + lost) : 0.0);
+        fprintf(out, "UPPs        %u signed (%.1f/s)\n", (unsigned int)upps, (double)upps / seconds);
+    }
+
+#if CONFIG_UBIRCH_PIPELINE
+    if (json) {
+        fprintf(out, "  \"stages\": {\n");
+    } else {
+        fprintf(out, "%-11s %8s %10s %10s %10s %10s\n", "stage", "count", "avg us", "p50 us", "p99 us", "max us");
+    }
+    for (int i = 0; i <= UBIRCH_PIPELINE_STAGES; ++i) {
+        bool total = (i == UBIRCH_PIPELINE_STAGES);
+        const char *name = total ? "end_to_end" : ubirch_pipeline_stage_name((ubirch_pipeline_stage_t)i);
+        host_latency_t latency = total ? latency_delta(&start->pipeline.end_to_end, &end->pipeline.end_to_end)
+                : latency_delta(&start->pipeline.stage[i], &end->pipeline.stage[i]);
+        if (json) {
+            fprintf(out, "    \"%s\": {\"count\": %u, \"avg_us\": %u, \"p50_us\": %u, \"p99_us\": %u, "
+                    "\"max_us\": %u}%s\n", name, latency.count, latency.avg_us, latency.p50_us,
+                    latency.p99_us, latency.max_us, total ? "" : ",");
+        } else {
+            fprintf(out, "%-11s %8u %10u %10u %10u %10u\n", name, latency.count, latency.avg_us,
+                    latency.p50_us, latency.p99_us, latency.max_us);
+        }
+    }
+    uint32_t failed = end->pipeline.failed - start->pipeline.failed;
+    uint32_t retried = end->pipeline.retried - start->pipeline.retried;
+    uint32_t sent = end->pipeline.sent - start->pipeline.sent;
+    uint32_t batches = end->pipeline.batches - start->pipeline.batches;
+    if (json) {
+        fprintf(out, "  },\n  \"failed\": %u,\n  \"retried\": %u,\n", (unsigned int)failed, (unsigned int)retried);
+        fprintf(out, "  \"batches\": {\"size\": %d, \"count\": %u, \"upps\": %u},\n",
+                CONFIG_UBIRCH_PIPELINE_BATCH_SIZE, (unsigned int)batches, (unsigned int)sent);
+    } else {
+        fprintf(out, "failed      %u, %u UPPs sent again\n", (unsigned int)failed, (unsigned int)retried);
+        fprintf(out, "batches     %u UPPs sent in %u batches (%.2f per batch)\n", (unsigned int)sent,
+                (unsigned int)batches, (batches > 0) ? (double)sent / (double)batches : 0.0);
+    }
+#endif
+
+    uint32_t hits = end->id_cache.hits - start->id_cache.hits;
+    uint32_t misses = end->id_cache.misses - start->id_cache.misses;
+    uint32_t write_backs = end->id_cache.write_backs - start->id_cache.write_backs;
+    uint64_t nvs_loads = end->nvs_context_loads - start->nvs_context_loads;
+    if (json) {
+        fprintf(out, "  \"id_cache\": {\"hits\": %u, \"misses\": %u, \"write_backs\": %u, \"nvs_loads\": %llu},\n",
+                (unsigned int)hits, (unsigned int)misses, (unsigned int)write_backs, (unsigned long long)nvs_loads);
+    } else {
+        fprintf(out, "id cache    %u hits, %u misses, %u write backs, %llu NVS loads\n",
+                (unsigned int)hits, (unsigned int)misses, (unsigned int)write_backs, (unsigned long long)nvs_loads);
+    }
+#if CONFIG_UBIRCH_FAST_SIGN
+    uint32_t signs = end->signer.signs - start->signer.signs;
+    uint32_t expansions = end->signer.expansions - start->signer.expansions;
+    if (json) {
+        fprintf(out, "  \"signer\": {\"signs\": %u, \"expansions\": %u},\n", (unsigned int)signs,
+                (unsigned int)expansions);
+    } else {
+        fprintf(out, "signer      %u signatures, %u secret keys expanded\n", (unsigned int)signs,
+                (unsigned int)expansions);
+    }
+#endif
+#if CONFIG_UBIRCH_SENSOR_INDEX
+    uint32_t lookups = end->sensor_index.lookups - start->sensor_index.lookups;
+    uint32_t filtered = end->sensor_index.filtered - start->sensor_index.filtered;
+    uint32_t false_positives = end->sensor_index.false_positives - start->sensor_index.false_positives;
+    double probes_per_lookup = (lookups > 0)
+            ? (double)(end->sensor_index.probes - start->sensor_index.probes) / lookups : 0.0;
+    double lookup_us = (lookups > 0)
+            ? (double)(end->sensor_index.lookup_us - start->sensor_index.lookup_us) / lookups : 0.0;
+    if (json) {
+        fprintf(out, "  \"sensor_index\": {\"sensors\": %u, \"slots\": %u, \"lookups\": %u, \"filtered\": %u, "
+                "\"false_positives\": %u, \"probes_per_lookup\": %.2f, \"lookup_us\": %.1f},\n",
+                (unsigned int)end->sensor_index.sensors, (unsigned int)end->sensor_index.slots,
+                (unsigned int)lookups, (unsigned int)filtered, (unsigned int)false_positives,
+                probes_per_lookup, lookup_us);
+    } else {
+        fprintf(out, "index       %u sensors in %u slots, %u lookups of %.1f us with %.2f probes, "
+                "%u unknown filtered, %u false positives\n",
+                (unsigned int)end->sensor_index.sensors, (unsigned int)end->sensor_index.slots,
+                (unsigned int)lookups, lookup_us, probes_per_lookup, (unsigned int)filtered,
+                (unsigned int)false_positives);
+    }
+#endif
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+    uint32_t requests = end->http_pool.requests - start->http_pool.requests;
+    uint32_t handshakes = end->http_pool.handshakes - start->http_pool.handshakes;
+    uint32_t reconnects = end->http_pool.reconnects - start->http_pool.reconnects;
+    if (json) {
+        fprintf(out, "  \"http_pool\": {\"requests\": %u, \"handshakes\": %u, \"reconnects\": %u},\n",
+                (unsigned int)requests, (unsigned int)handshakes, (unsigned int)reconnects);
+    } else {
+        fprintf(out, "http pool   %u requests, %u handshakes, %u reconnects\n",
+                (unsigned int)requests, (unsigned int)handshakes, (unsigned int)reconnects);
+    }
+#endif
+    uint32_t delivered = end->anchor.delivered - start->anchor.delivered;
+    uint32_t retries = end->anchor.retries - start->anchor.retries;
+    uint32_t refused = end->anchor.rejected - start->anchor.rejected;
+    uint32_t unverified = end->anchor.unverified - start->anchor.unverified;
+    uint32_t handed_off = end->anchor.handed_off - start->anchor.handed_off;
+    uint32_t dropped = end->anchor.dropped - start->anchor.dropped;
+    if (json) {
+        fprintf(out, "  \"delivery\": {\"delivered\": %u, \"retries\": %u, \"rejected\": %u, \"unverified\": %u, "
+                "\"handed_off\": %u, \"dropped\": %u},\n", (unsigned int)delivered, (unsigned int)retries,
+                (unsigned int)refused, (unsigned int)unverified, (unsigned int)handed_off, (unsigned int)dropped);
+    } else {
+        fprintf(out, "delivery    %u delivered, %u retries, %u rejected, %u unverified, %u kept for later, "
+                "%u dropped\n", (unsigned int)delivered, (unsigned int)retries, (unsigned int)refused,
+                (unsigned int)unverified, (unsigned int)handed_off, (unsigned int)dropped);
+    }
+#if CONFIG_UBIRCH_FAST_BOOT
+    // the start is before the measurement, so the timeline at the end is reported
+    const ubirch_boot_timeline_t *boot = &end->boot;
+    if (json) {
+        fprintf(out, "  \"boot\": {\"keys_loaded_ms\": %u, \"anchor_ready_ms\": %u, \"network_up_ms\": %u, "
+                "\"first_reading_ms\": %u, \"first_anchored_ms\": %u, \"prefetched\": %u},\n",
+                (unsigned int)boot->at_ms[UBIRCH_BOOT_KEYS_LOADED], (unsigned int)boot->at_ms[UBIRCH_BOOT_ANCHOR_READY],
+                (unsigned int)boot->at_ms[UBIRCH_BOOT_NETWORK_UP], (unsigned int)boot->at_ms[UBIRCH_BOOT_FIRST_READING],
+                (unsigned int)boot->at_ms[UBIRCH_BOOT_FIRST_ANCHORED], (unsigned int)boot->prefetched);
+    } else {
+        fprintf(out, "boot        first UPP anchored after %u ms, keys loaded %u ms, anchoring ready %u ms, "
+                "network up %u ms, first reading %u ms, %u contexts prefetched\n",
+                (unsigned int)boot->at_ms[UBIRCH_BOOT_FIRST_ANCHORED], (unsigned int)boot->at_ms[UBIRCH_BOOT_KEYS_LOADED],
+                (unsigned int)boot->at_ms[UBIRCH_BOOT_ANCHOR_READY], (unsigned int)boot->at_ms[UBIRCH_BOOT_NETWORK_UP],
+                (unsigned int)boot->at_ms[UBIRCH_BOOT_FIRST_READING], (unsigned int)boot->prefetched);
+    }
+#endif
+#if CONFIG_UBIRCH_KEY_POOL
+    uint32_t pool_taken = end->key_pool.taken - start->key_pool.taken;
+    uint32_t pool_missed = end->key_pool.missed - start->key_pool.missed;
+    uint32_t pool_generated = end->key_pool.generated - start->key_pool.generated;
+    if (json) {
+        fprintf(out, "  \"key_pool\": {\"taken\": %u, \"missed\": %u, \"generated\": %u, \"available\": %u, "
+                "\"min_available\": %u},\n", (unsigned int)pool_taken, (unsigned int)pool_missed,
+                (unsigned int)pool_generated, (unsigned int)end->key_pool.available,
+                (unsigned int)end->key_pool.min_available);
+    } else {
+        fprintf(out, "key pool    %u pairs taken, %u generated at once, %u generated, %u ready (min %u)\n",
+                (unsigned int)pool_taken, (unsigned int)pool_missed, (unsigned int)pool_generated,
+                (unsigned int)end->key_pool.available, (unsigned int)end->key_pool.min_available);
+    }
+#endif
+#if CONFIG_UBIRCH_INGEST
+    uint32_t ingest_frames = end->ingest.frames - start->ingest.frames;
+    uint64_t ingest_bytes = end->ingest.bytes - start->ingest.bytes;
+    uint32_t ingest_busy = end->ingest.busy - start->ingest.busy;
+    uint32_t ingest_invalid = end->ingest.invalid - start->ingest.invalid;
+    uint32_t ingest_pauses = end->ingest.pauses - start->ingest.pauses;
+    uint32_t ingest_refused = end->ingest.refused - start->ingest.refused;
+    uint32_t ingest_denied = end->ingest.denied - start->ingest.denied;
+    if (json) {
+        fprintf(out, "  \"ingest\": {\"frames\": %u, \"frames_per_s\": %.1f, \"bytes\": %llu, \"busy\": %u, "
+                "\"invalid\": %u, \"pauses\": %u, \"connections\": %u, \"refused\": %u, \"denied\": %u},\n",
+                (unsigned int)ingest_frames, (double)ingest_frames / seconds, (unsigned long long)ingest_bytes,
+                (unsigned int)ingest_busy, (unsigned int)ingest_invalid, (unsigned int)ingest_pauses,
+                (unsigned int)end->ingest.connections, (unsigned int)ingest_refused, (unsigned int)ingest_denied);
+    } else {
+        fprintf(out, "ingest      %u frames (%.1f/s, %.1f KiB/s), %u busy, %u invalid, %u pauses, "
+                "%u connections (%u refused), %u senders denied\n", (unsigned int)ingest_frames,
+                (double)ingest_frames / seconds, (double)ingest_bytes / 1024.0 / seconds, (unsigned int)ingest_busy,
+                (unsigned int)ingest_invalid, (unsigned int)ingest_pauses, (unsigned int)end->ingest.connections,
+                (unsigned int)ingest_refused, (unsigned int)ingest_denied);
+    }
+#endif
+#if CONFIG_UBIRCH_BREAKER
+    uint32_t trips = end->breaker.trips - start->breaker.trips;
+    uint32_t short_circuits = end->breaker.short_circuits - start->breaker.short_circuits;
+    uint32_t probes = end->breaker.probes - start->breaker.probes;
+    if (json) {
+        fprintf(out, "  \"breaker\": {\"open\": %u, \"trips\": %u, \"short_circuits\": %u, \"probes\": %u},\n",
+                (unsigned int)end->breaker.open, (unsigned int)trips, (unsigned int)short_circuits,
+                (unsigned int)probes);
+    } else {
+        fprintf(out, "breaker     %u of %u circuits open, %u trips, %u requests failed at once, %u probes\n",
+                (unsigned int)end->breaker.open, (unsigned int)end->breaker.endpoints, (unsigned int)trips,
+                (unsigned int)short_circuits, (unsigned int)probes);
+    }
+#endif
+#if CONFIG_UBIRCH_RATE_CONTROL
+    // the rate and round-trip times at the end, the events within the measurement
+    const ubirch_rate_control_stats_t *rate = &end->rate_control;
+    uint32_t rejected = rate->rejected - start->rate_control.rejected;
+    uint32_t server_errors = rate->server_errors - start->rate_control.server_errors;
+    uint32_t send_failures = rate->failures - start->rate_control.failures;
+    uint32_t decreases = rate->decreases - start->rate_control.decreases;
+    uint32_t backoffs = rate->backoffs - start->rate_control.backoffs;
+    if (json) {
+        fprintf(out, "  \"rate_control\": {\"state\": \"%s\", \"rate_per_s\": %.3f, \"interval_ms\": %u, "
+                "\"srtt_us\": %u, \"min_rtt_us\": %u, \"backlog\": %u, \"rejected\": %u, \"server_errors\": %u, "
+                "\"failures\": %u, \"decreases\": %u, \"backoffs\": %u},\n",
+                ubirch_rate_control_state_name(rate->state), (double)rate->rate_milli / 1000.0,
+                (unsigned int)rate->interval_ms, (unsigned int)rate->srtt_us, (unsigned int)rate->min_rtt_us,
+                (unsigned int)rate->backlog, (unsigned int)rejected, (unsigned int)server_errors,
+                (unsigned int)send_failures, (unsigned int)decreases, (unsigned int)backoffs);
+    } else {
+        fprintf(out, "rate        %s at %.3f UPPs/s, rtt %u us (min %u us), %u pending, %u rejected, "
+                "%u server errors, %u failures, %u decreases, %u backoffs\n",
+                ubirch_rate_control_state_name(rate->state), (double)rate->rate_milli / 1000.0,
+                (unsigned int)rate->srtt_us, (unsigned int)rate->min_rtt_us, (unsigned int)rate->backlog,
+                (unsigned int)rejected, (unsigned int)server_errors, (unsigned int)send_failures,
+                (unsigned int)decreases, (unsigned int)backoffs);
+    }
+#endif
+#if CONFIG_UBIRCH_METRICS
+    // the cost of all measurements within the measurement, relative to the time of the outermost timers,
+    // the signing is timed within the message
+    uint64_t spans = 0;
+    uint64_t measured_us = 0;
+    for (int i = 0; i < UBIRCH_METRICS_TIMERS; ++i) {
+        const ubirch_metrics_histogram_t *timer_start = &start->metrics.timers[i];
+        const ubirch_metrics_histogram_t *timer_end = &end->metrics.timers[i];
+        spans += timer_end->count - timer_start->count;
+        if (i != UBIRCH_METRICS_SIGN) {
+            measured_us += timer_end->total_us - timer_start->total_us;
+        }
+    }
+    double overhead_percent = (measured_us > 0)
+            ? 100.0 * (double)spans * end->metrics_overhead_ns / ((double)measured_us * 1000.0) : 0.0;
+    if (json) {
+        fprintf(out, "  \"metrics\": {\"overhead_ns\": %u, \"overhead_percent\": %.4f, \"timers\": {\n",
+                (unsigned int)end->metrics_overhead_ns, overhead_percent);
+    } else {
+        fprintf(out, "metrics     %llu measurements of %u ns, %.4f%% of the measured time\n",
+                (unsigned long long)spans, (unsigned int)end->metrics_overhead_ns, overhead_percent);
+    }
+    for (int i = 0; i < UBIRCH_METRICS_TIMERS; ++i) {
+        host_latency_t latency = timer_delta(&start->metrics.timers[i], &end->metrics.timers[i]);
+        const char *name = ubirch_metrics_timer_name((ubirch_metrics_timer_t)i);
+        if (json) {
+            fprintf(out, "    \"%s\": {\"count\": %u, \"avg_us\": %u, \"p50_us\": %u, \"p99_us\": %u, "
+                    "\"max_us\": %u}%s\n", name, latency.count, latency.avg_us, latency.p50_us,
+                    latency.p99_us, latency.max_us, (i + 1 < UBIRCH_METRICS_TIMERS) ? "," : "");
+        } else {
+            fprintf(out, "  %-9s %8u %10u %10u %10u %10u\n", name, latency.count, latency.avg_us,
+                    latency.p50_us, latency.p99_us, latency.max_us);
+        }
+    }
+    if (json) {
+        fprintf(out, "  }},\n");
+    }
+#endif
+
+    // the flash wear extrapolated to a million UPPs, the sectors of a partition wear evenly
+    if (json) {
+        fprintf(out, "  \"flash\": {\n");
+    }
+    for (size_t i = 0; i < FLASH_LABELS; ++i) {
+        uint64_t erases = end->flash[i].sector_erases - start->flash[i].sector_erases;
+        uint64_t written = end->flash[i].bytes_written - start->flash[i].bytes_written;
+        double erases_per_million = (upps > 0) ? (double)erases * 1e6 / upps : 0.0;
+        double cycles_per_million = (end->flash[i].sectors > 0) ? erases_per_million / end->flash[i].sectors : 0.0;
+        if (json) {
+            fprintf(out, "    \"%s\": {\"sectors\": %u, \"bytes_written\": %llu, \"erases\": %llu, "
+                    "\"erases_per_million_upps\": %.1f, \"cycles_per_million_upps\": %.1f}%s\n",
+                    flash_labels[i], (unsigned int)end->flash[i].sectors, (unsigned long long)written,
+                    (unsigned long long)erases, erases_per_million, cycles_per_million,
+                    (i + 1 < FLASH_LABELS) ? "," : "");
+        } else {
+            fprintf(out, "flash       %-10s %llu bytes, %llu erases, %.1f erases and %.1f cycles per sector "
+                    "per million UPPs\n", flash_labels[i], (unsigned long long)written,
+                    (unsigned long long)erases, erases_per_million, cycles_per_million);
+        }
+    }
+    if (json) {
+        fprintf(out, "  },\n");
+    }
+
+    // the lowest free stack of every task since the start, the stacks are sized for the ESP32
+    const ubirch_budget_t *budget = &end->budget;
+    if (json) {
+        fprintf(out, "  \"budget\": {\"static_bytes\": %u, \"heap_bytes\": %u, \"heap_minimum_free\": %u, "
+                "\"context_size\": %u, \"tasks\": {\n", (unsigned int)budget->static_bytes,
+                (unsigned int)budget->heap_bytes, (unsigned int)budget->heap_minimum_free,
+                (unsigned int)budget->context_size);
+    } else {
+        fprintf(out, "%-11s %8s %10s\n", "task", "stack", "min free");
+    }
+    for (uint32_t i = 0; i < budget->task_count; ++i) {
+        const ubirch_budget_task_t *task = &budget->tasks[i];
+        if (json) {
+            fprintf(out, "    \"%s\": {\"stack_size\": %u, \"stack_free_min\": %u}%s\n", task->name,
+                    (unsigned int)task->stack_size, (unsigned int)task->stack_free_min,
+                    (i + 1 < budget->task_count) ? "," : "");
+        } else {
+            fprintf(out, "  %-9s %8u %10u\n", task->name, (unsigned int)task->stack_size,
+                    (unsigned int)task->stack_free_min);
+        }
+    }
+    if (json) {
+        fprintf(out, "  }},\n");
+    } else {
+        fprintf(out, "budget      %u bytes static, %u bytes of task memory on the heap, lowest free heap %u bytes "
+                "(%u more ID contexts)\n", (unsigned int)budget->static_bytes, (unsigned int)budget->heap_bytes,
+                (unsigned int)budget->heap_minimum_free,
+                (unsigned int)(budget->heap_minimum_free / budget->context_size));
+    }
+
+    double allocations_per_upp = (upps > 0) ? (double)allocations / upps : 0.0;
+    if (json) {
+        fprintf(out, "  \"heap\": {\"allocated_bytes\": %zu, \"peak_bytes\": %zu, \"blocks\": %zu, "
+                "\"allocations_per_upp\": %.2f}\n}\n", end->heap.allocated_bytes, end->heap.peak_bytes,
+                end->heap.allocated_blocks, allocations_per_upp);
+    } else {
+        fprintf(out, "heap        %zu bytes in %zu blocks, peak %zu bytes (of %u), %.2f allocations per UPP\n",
+                end->heap.allocated_bytes, end->heap.allocated_blocks, end->heap.peak_bytes,
+                (unsigned int)HOST_HEAP_SIZE, allocations_per_upp);
+    }
+}
+
+static void app_main_task(void *pvParameters) {
+    (void)pvParameters;
+    app_main();
+}
+
+int main(int argc, char *argv[]) {
+    host_options_t options = {
+            .loadgen = {
+                    .sensors = 100,
+                    .id_prefix = "sensor-",
+                    .rate_hz = 1.0,
+                    .values = CONFIG_UBIRCH_SENSOR_MAX_VALUES,
+                    .block = false,
+                    .transport = HOST_LOADGEN_SLOTS,
+                    .connections = 1,
+            },
+            .duration_s = 30,
+            .warmup_s = 10,
+    };
+    if (!options_parse(argc, argv, &options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    esp_log_level_set("*", options.verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+
+    xTaskCreate(&app_main_task, "app_main", CONFIG_ESP_MAIN_TASK_STACK_SIZE, NULL, 1, NULL);
+
+    // app_main() creates the sensor data pool, before it starts the tasks
+    ubirch_sensor_pool_stats_t pool_stats = { 0 };
+    while (pool_stats.min_free == 0) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        ubirch_sensor_pool_stats_get(&pool_stats);
+    }
+    if (host_loadgen_start(&options.loadgen) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start the load generator");
+        return EXIT_FAILURE;
+    }
+
+    ESP_LOGW(TAG, "warmup for %u s", (unsigned int)options.warmup_s);
+    vTaskDelay(pdMS_TO_TICKS(options.warmup_s * 1000));
+    host_snapshot_t start;
+    snapshot_take(&start);
+    ESP_LOGW(TAG, "measure for %u s", (unsigned int)options.duration_s);
+    vTaskDelay(pdMS_TO_TICKS(options.duration_s * 1000));
+    host_snapshot_t end;
+    snapshot_take(&end);
+
+    report_print(stdout, &options, &start, &end, false);
+    if (options.json_path != NULL) {
+        FILE *file = fopen(options.json_path, "w");
+        if (file == NULL) {
+            ESP_LOGE(TAG, "failed to write %s", options.json_path);
+            return EXIT_FAILURE;
+        }
+        report_print(file, &options, &start, &end, true);
+        fclose(file);
+    }
+    fflush(stdout);
+    // the tasks of the gateway never end
+    exit(EXIT_SUCCESS);
+}
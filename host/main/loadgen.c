@@ -0,0 +1,216 @@
+/*!
+ * @file loadgen.c
+ * @brief Load generator, which simulates many sensors feeding the gateway.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "ingest.h"
+#include "sensor_data.h"
+#include "loadgen.h"
+
+static const char *TAG = "loadgen";
+
+#define LOADGEN_CONNECT_TRIES 50    // the ingestion server starts with the gateway
+#define LOADGEN_CONNECT_PAUSE_MS 100
+
+static host_loadgen_config_t config;
+static host_loadgen_stats_t stats = { 0 };
+
+static void reading_fill(sensor_data_t *data, uint32_t sensor, int32_t *value) {
+    snprintf(data->id, sizeof(data->id), "%s%05u", config.id_prefix, (unsigned int)sensor);
+    data->num = config.values;
+    for (uint16_t i = 0; i < data->num; ++i) {
+        data->values[i] = (*value)++;
+    }
+}
+
+static void slot_send(uint32_t sensor, int32_t *value) {
+    sensor_data_t *data = ubirch_sensor_slot_acquire(config.block ? portMAX_DELAY : 0);
+    if (data == NULL) {
+        stats.lost++;
+        return;
+    }
+    reading_fill(data, sensor, value);
+    ubirch_sensor_slot_commit(data);
+    stats.generated++;
+}
+
+#if CONFIG_UBIRCH_INGEST
+
+static int *sockets = NULL;         //!< the TCP connections, or the UDP socket
+static uint32_t socket_count = 0;
+
+static void frame_send(uint32_t sensor, int32_t *value) {
+    static sensor_data_t reading;
+    uint8_t frame[UBIRCH_INGEST_FRAME_MAX];
+    reading_fill(&reading, sensor, value);
+    size_t len = ubirch_ingest_encode(frame, (uint16_t)sensor, reading.id, reading.values, reading.num);
+
+    if (config.transport == HOST_LOADGEN_UDP) {
+        // the readings, which the server answered as busy, are lost after all
+        uint8_t status[UBIRCH_INGEST_STATUS_SIZE];
+        while (recv(sockets[0], status, sizeof(status), MSG_DONTWAIT) == sizeof(status)) {
+            if (status[2] == UBIRCH_INGEST_TYPE_STATUS && status[5] == UBIRCH_INGEST_STATUS_BUSY) {
+                stats.generated--;
+                stats.lost++;
+            }
+        }
+        if (send(sockets[0], frame, len, 0) == (ssize_t)len) {
+            stats.generated++;
+        } else {
+            stats.lost++;
+        }
+        return;
+    }
+
+    int fd = sockets[sensor % socket_count];
+    ssize_t sent = send(fd, frame, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && config.block) {
+        sent = 0;
+    }
+    if (sent < 0) {
+        stats.lost++;
+        return;
+    }
+    // the rest of a frame, which was sent in part, keeps the stream in order
+    while ((size_t)sent < len) {
+        ssize_t n = send(fd, frame + sent, len - (size_t)sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            stats.lost++;
+            return;
+        }
+        sent += n;
+    }
+    stats.generated++;
+}
+
+static int socket_connect(int type) {
+    struct sockaddr_in addr = {
+            .sin_family = AF_INET,
+            .sin_port = htons(CONFIG_UBIRCH_INGEST_PORT),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    for (int i = 0; i < LOADGEN_CONNECT_TRIES; ++i) {
+        int fd = socket(AF_INET, type, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        close(fd);
+        vTaskDelay(pdMS_TO_TICKS(LOADGEN_CONNECT_PAUSE_MS));
+    }
+    return -1;
+}
+
+static esp_err_t sockets_open(void) {
+    socket_count = (config.transport == HOST_LOADGEN_TCP) ? config.connections : 1;
+    sockets = calloc(socket_count, sizeof(int));
+    if (sockets == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint32_t i = 0; i < socket_count; ++i) {
+        sockets[i] = socket_connect(config.transport == HOST_LOADGEN_TCP ? SOCK_STREAM : SOCK_DGRAM);
+        if (sockets[i] < 0) {
+            ESP_LOGE(TAG, "failed to connect to port %d: %d", CONFIG_UBIRCH_INGEST_PORT, errno);
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+#endif
+
+static void loadgen_task(void *pvParameters) {
+    (void)pvParameters;
+    // all sensors together are due at this interval
+    double interval_us = 1000000.0 / ((double)config.sensors * config.rate_hz);
+    double due = (double)esp_timer_get_time();
+    int32_t value = 0;
+
+    for (uint32_t sensor = 0;; sensor = (sensor + 1) % config.sensors) {
+        due += interval_us;
+        int64_t now = esp_timer_get_time();
+        if ((double)now < due) {
+            uint32_t wait_us = (uint32_t)(due - (double)now);
+            // sleep for full ticks only, the rest is sent a little early
+            if (wait_us >= 1000) {
+                vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+            }
+        } else {
+            stats.late_us += (uint64_t)((double)now - due);
+        }
+
+#if CONFIG_UBIRCH_INGEST
+        if (config.transport != HOST_LOADGEN_SLOTS) {
+            frame_send(sensor, &value);
+            continue;
+        }
+#endif
+        slot_send(sensor, &value);
+    }
+}
+
+esp_err_t host_loadgen_start(const host_loadgen_config_t *new_config) {
+    memcpy(&config, new_config, sizeof(config));
+    if (config.sensors == 0 || config.rate_hz <= 0.0 || config.id_prefix == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config.values == 0 || config.values > CONFIG_UBIRCH_SENSOR_MAX_VALUES) {
+        config.values = CONFIG_UBIRCH_SENSOR_MAX_VALUES;
+    }
+    if (config.connections == 0) {
+        config.connections = 1;
+    }
+    ESP_LOGI(TAG, "%u sensors at %.3f Hz, %u values per reading", (unsigned int)config.sensors,
+            config.rate_hz, config.values);
+    memset(&stats, 0, sizeof(stats));
+    if (config.transport != HOST_LOADGEN_SLOTS) {
+#if CONFIG_UBIRCH_INGEST
+        esp_err_t err = sockets_open();
+        if (err != ESP_OK) {
+            return err;
+        }
+#else
+        return ESP_ERR_NOT_SUPPORTED;
+#endif
+    }
+    if (xTaskCreate(&loadgen_task, "loadgen", 4096, NULL, 6, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void host_loadgen_stats_get(host_loadgen_stats_t *out) {
+    memcpy(out, &stats, sizeof(host_loadgen_stats_t));
+}
@@ -0,0 +1,89 @@
+/*!
+ * @file loadgen.h
+ * @brief Load generator, which simulates many sensors feeding the gateway.
+ *
+ * The sensors send open loop: the readings are due at a fixed rate,
+ * independent of how fast the gateway takes them. A reading, for which no
+ * free slot of the sensor data pool is available, is lost, like a reading of
+ * a real sensor, which the gateway cannot receive in time. In blocking mode
+ * the generator waits for a free slot instead, which measures the maximum
+ * throughput.
+ *
+ * With the ingestion server, the readings can also be sent over the loopback
+ * interface, like by real sensors (see ingest.h). Over TCP, a reading, which
+ * does not fit into the send buffer of its connection, is lost, as the
+ * server stopped reading. Over UDP, a reading, which the server answers as
+ * busy, is lost. Blocking mode has no effect over UDP.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_LOADGEN_H
+#define HOST_LOADGEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * The way the readings reach the gateway.
+ */
+typedef enum {
+    HOST_LOADGEN_SLOTS = 0,     //!< directly into the slots of the sensor data pool
+    HOST_LOADGEN_TCP,           //!< to the ingestion server over TCP
+    HOST_LOADGEN_UDP,           //!< to the ingestion server over UDP
+} host_loadgen_transport_t;
+
+/*!
+ * Configuration of the simulated sensors.
+ */
+typedef struct {
+    uint32_t sensors;       //!< number of sensors, which send in turn
+    const char *id_prefix;  //!< beginning of the sensor ids, which are numbered
+    double rate_hz;         //!< readings per second of every sensor
+    uint16_t values;        //!< values per reading
+    bool block;             //!< wait for a free slot instead of losing the reading
+    host_loadgen_transport_t transport;
+    uint32_t connections;   //!< TCP connections, which the sensors share in turn
+} host_loadgen_config_t;
+
+/*!
+ * Statistics of the load generator.
+ */
+typedef struct {
+    uint64_t generated;     //!< readings handed over to the gateway
+    uint64_t lost;          //!< readings without a free slot, or not taken by the ingestion server
+    uint64_t late_us;       //!< total delay of the readings behind their schedule
+} host_loadgen_stats_t;
+
+/*!
+ * @brief Start the task, which generates the readings.
+ *
+ * The sensor data pool has to be initialized before.
+ *
+ * @param[in] config configuration, which is copied
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED if the ingestion server is not configured, ESP_FAIL if
+ *         it cannot be connected, or ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t host_loadgen_start(const host_loadgen_config_t *config);
+
+/*!
+ * @brief Get a copy of the statistics.
+ */
+void host_loadgen_stats_get(host_loadgen_stats_t *stats);
+
+#endif /* HOST_LOADGEN_H */
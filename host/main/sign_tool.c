@@ -0,0 +1,120 @@
+/*!
+ * @file sign_tool.c
+ * @brief Compare the signer with ed25519_sign_key() and measure both.
+ *
+ * After the known answer tests of ubirch_signer_init(), random key pairs
+ * sign random data with ed25519_sign_key() and with the signer, through
+ * ubirch_signer_sign_key() and, as the current context, ubirch_signer_sign().
+ * All signatures have to be the same and pass ed25519_verify_key().
+ * With --benchmark, the signatures and verifications per second follow:
+ * ```
+ * $ build-host/sign-check --keys 256 --benchmark 200
+ * ```
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_system.h>
+
+#include "signer.h"
+
+// ctest skips the test with this exit code
+#define SIGN_TOOL_SKIPPED 77
+
+#if CONFIG_UBIRCH_FAST_SIGN
+
+#define SIGN_TOOL_DATA_SIZE 256     //!< larger than the stack buffer of the signer
+
+/*!
+ * Sign random data with a random key pair in all three ways.
+ *
+ * @return true if the signatures are the same and valid
+ */
+static bool key_check(void) {
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+    unsigned char secret_key[crypto_sign_SECRETKEYBYTES];
+    unsigned char data[SIGN_TOOL_DATA_SIZE];
+    unsigned char expected[crypto_sign_BYTES];
+    unsigned char signature[crypto_sign_BYTES];
+    unsigned char current[crypto_sign_BYTES];
+    ubirch_signer_key_t key;
+    uint32_t len;
+
+    crypto_sign_keypair(public_key, secret_key);
+    esp_fill_random(&len, sizeof(len));
+    len %= SIGN_TOOL_DATA_SIZE + 1;
+    esp_fill_random(data, len);
+
+    ubirch_signer_key_expand(&key, secret_key);
+    memcpy(ed25519_secret_key, secret_key, sizeof(ed25519_secret_key));
+    return ed25519_sign_key(data, len, expected, secret_key) == 0
+            && ubirch_signer_sign_key(&key, data, len, signature) == 0
+            && ubirch_signer_sign(data, len, current) == 0
+            && memcmp(signature, expected, crypto_sign_BYTES) == 0
+            && memcmp(current, expected, crypto_sign_BYTES) == 0
+            && ed25519_verify_key(data, len, signature, public_key) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long keys = 64;
+    unsigned long benchmark = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            keys = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) {
+            benchmark = strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--keys N] [--benchmark N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (ubirch_signer_init() != ESP_OK) {
+        fprintf(stderr, "known answer tests failed\n");
+        return 1;
+    }
+    for (unsigned long i = 0; i < keys; ++i) {
+        if (!key_check()) {
+            fprintf(stderr, "key %lu: the signatures differ from ed25519_sign_key()\n", i);
+            return 1;
+        }
+    }
+    printf("known answer tests passed, %lu random keys sign like ed25519_sign_key()\n", keys);
+
+    if (benchmark > 0) {
+        ubirch_signer_benchmark_t rates;
+        ubirch_signer_benchmark(benchmark, &rates);
+        printf("%-26s %10s\n", "implementation", "per second");
+        printf("%-26s %10u\n", "ed25519_sign_key()", (unsigned int)rates.nacl_signs);
+        printf("%-26s %10u\n", "ubirch_signer_sign_key()", (unsigned int)rates.signs);
+        printf("%-26s %10u\n", "ed25519_verify_key()", (unsigned int)rates.verifies);
+    }
+    return 0;
+}
+
+#else
+
+int main(void) {
+    fprintf(stderr, "the signer is not configured\n");
+    return SIGN_TOOL_SKIPPED;
+}
+
+#endif
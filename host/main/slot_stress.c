@@ -0,0 +1,219 @@
+/*!
+ * @file slot_stress.c
+ * @brief Stress the sensor slot pool with many producers and one consumer.
+ *
+ * The producer tasks acquire, fill and commit slots as fast as they can,
+ * the consumer checks every slot it receives: it has to carry the next
+ * sequence number of its producer and values, which match the sequence. A
+ * slot, which is handed out twice, a reading, which is lost, duplicated or
+ * torn, a wrong count of the pool statistics or a slot, which does not
+ * return to the pool, fail the test.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "sensor_data.h"
+
+#define STRESS_MAX_PRODUCERS 32
+#define STRESS_VALUES 4
+// owner of a slot in the consumer, the producers are numbered from 1
+#define STRESS_CONSUMER UINT32_MAX
+
+typedef struct {
+    uint32_t producers;
+    uint32_t readings;          //!< readings per producer
+} stress_options_t;
+
+static stress_options_t options = { .producers = 8, .readings = 20000 };
+static sensor_data_t *base = NULL;          //!< the first slot of the pool
+static uint32_t owners[CONFIG_UBIRCH_SENSOR_SLOTS];
+static uint32_t errors = 0;
+static uint32_t acquire_retries = 0;
+
+static void error(const char *message, uint32_t producer, uint32_t sequence) {
+    if (__atomic_fetch_add(&errors, 1, __ATOMIC_RELAXED) < 10) {
+        fprintf(stderr, "producer %u, reading %u: %s\n", (unsigned int)producer, (unsigned int)sequence, message);
+    }
+}
+
+static int32_t value_of(uint32_t producer, uint32_t sequence, uint16_t index) {
+    return (int32_t)(sequence * 31 + index * 7 + producer);
+}
+
+/*!
+ * Take the ownership of \p slot from \p expected, a different owner means the slot is shared.
+ */
+static bool slot_claim(const sensor_data_t *slot, uint32_t expected, uint32_t owner) {
+    size_t index = (size_t)(slot - base);
+    if (index >= CONFIG_UBIRCH_SENSOR_SLOTS) {
+        return false;
+    }
+    return __atomic_compare_exchange_n(&owners[index], &expected, owner, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+static void producer_task(void *arg) {
+    uint32_t producer = (uint32_t)(uintptr_t)arg;
+    for (uint32_t sequence = 0; sequence < options.readings; ++sequence) {
+        sensor_data_t *slot = NULL;
+        while ((slot = ubirch_sensor_slot_acquire(pdMS_TO_TICKS(10))) == NULL) {
+            __atomic_fetch_add(&acquire_retries, 1, __ATOMIC_RELAXED);
+        }
+        if (!slot_claim(slot, 0, producer)) {
+            error("slot is not free", producer, sequence);
+        }
+        snprintf(slot->id, sizeof(slot->id), "producer-%u", (unsigned int)producer);
+        slot->num = STRESS_VALUES;
+        for (uint16_t i = 0; i < STRESS_VALUES; ++i) {
+            slot->values[i] = value_of(producer, sequence, i);
+        }
+        // the slot belongs to the queue, until the consumer receives it
+        if (!slot_claim(slot, producer, 0)) {
+            error("slot was taken from its producer", producer, sequence);
+        }
+        ubirch_sensor_slot_commit(slot);
+    }
+    vTaskDelete(NULL);
+}
+
+/*!
+ * Find the first slot, all slots have to be free at the start.
+ */
+static bool pool_check_free(const char *when) {
+    sensor_data_t *slots[CONFIG_UBIRCH_SENSOR_SLOTS];
+    size_t count = 0;
+    while (count < CONFIG_UBIRCH_SENSOR_SLOTS && (slots[count] = ubirch_sensor_slot_acquire(0)) != NULL) {
+        count++;
+    }
+    bool all = (count == CONFIG_UBIRCH_SENSOR_SLOTS && ubirch_sensor_slot_acquire(0) == NULL);
+    if (!all) {
+        fprintf(stderr, "%u of %u slots free %s\n", (unsigned int)count, CONFIG_UBIRCH_SENSOR_SLOTS, when);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (base == NULL || slots[i] < base) {
+            base = slots[i];
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        ubirch_sensor_slot_release(slots[i]);
+    }
+    return all;
+}
+
+static bool options_parse(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+            { "producers", required_argument, NULL, 'p' },
+            { "readings", required_argument, NULL, 'r' },
+            { NULL, 0, NULL, 0 },
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (option) {
+            case 'p': options.producers = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'r': options.readings = (uint32_t)strtoul(optarg, NULL, 10); break;
+            default: return false;
+        }
+    }
+    return options.producers > 0 && options.producers <= STRESS_MAX_PRODUCERS && options.readings > 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (!options_parse(argc, argv)) {
+        fprintf(stderr, "usage: %s [--producers N (at most %d)] [--readings N]\n", argv[0], STRESS_MAX_PRODUCERS);
+        return 2;
+    }
+    if (ubirch_sensor_pool_init() != ESP_OK || !pool_check_free("at the start")) {
+        return 1;
+    }
+
+    for (uint32_t producer = 1; producer <= options.producers; ++producer) {
+        if (xTaskCreate(producer_task, "producer", 4096, (void *)(uintptr_t)producer, 5, NULL) != pdPASS) {
+            fprintf(stderr, "failed to start producer %u\n", (unsigned int)producer);
+            return 1;
+        }
+    }
+
+    uint32_t next[STRESS_MAX_PRODUCERS + 1] = { 0 };
+    uint64_t expected = (uint64_t)options.producers * options.readings;
+    uint64_t received = 0;
+    while (received < expected) {
+        sensor_data_t *slot = ubirch_sensor_slot_receive(pdMS_TO_TICKS(5000));
+        if (slot == NULL) {
+            error("no more readings, the others are lost", 0, (uint32_t)received);
+            break;
+        }
+        received++;
+        unsigned int producer = 0;
+        if (sscanf(slot->id, "producer-%u", &producer) != 1 || producer == 0 || producer > options.producers) {
+            error("reading of an unknown producer", producer, 0);
+        } else {
+            uint32_t sequence = next[producer]++;
+            if (!slot_claim(slot, 0, STRESS_CONSUMER)) {
+                error("slot is used by a producer", producer, sequence);
+            }
+            if (slot->num != STRESS_VALUES || slot->committed < slot->acquired) {
+                error("reading is torn", producer, sequence);
+            }
+            for (uint16_t i = 0; i < STRESS_VALUES && i < slot->num; ++i) {
+                if (slot->values[i] != value_of(producer, sequence, i)) {
+                    error("reading is lost, duplicated or reordered", producer, sequence);
+                    // continue with the sequence of this reading
+                    next[producer] = (uint32_t)((slot->values[0] - (int32_t)producer) / 31) + 1;
+                    break;
+                }
+            }
+            slot_claim(slot, STRESS_CONSUMER, 0);
+        }
+        ubirch_sensor_slot_release(slot);
+    }
+
+    // the producers are done, when the last reading is received, give them time to delete themselves
+    vTaskDelay(pdMS_TO_TICKS(100));
+    if (ubirch_sensor_slot_receive(0) != NULL) {
+        error("more readings than produced", 0, (uint32_t)received);
+    }
+    if (!pool_check_free("at the end")) {
+        error("slots did not return to the pool", 0, (uint32_t)received);
+    }
+    ubirch_sensor_pool_stats_t stats;
+    ubirch_sensor_pool_stats_get(&stats);
+    if (stats.committed != expected) {
+        fprintf(stderr, "pool counted %u committed slots of %llu\n", (unsigned int)stats.committed,
+                (unsigned long long)expected);
+        errors++;
+    }
+    // the checks of the free slots failed one acquire each
+    if (stats.acquire_failed != acquire_retries + 2) {
+        fprintf(stderr, "pool counted %u failed acquires of %u\n", (unsigned int)stats.acquire_failed,
+                (unsigned int)acquire_retries + 2);
+        errors++;
+    }
+    printf("%u producers, %llu of %llu readings received, %u acquire retries, %u failed acquires counted, "
+           "at least %u of %u slots free, %u errors\n",
+            (unsigned int)options.producers, (unsigned long long)received, (unsigned long long)expected,
+            (unsigned int)acquire_retries, (unsigned int)stats.acquire_failed, (unsigned int)stats.min_free,
+            CONFIG_UBIRCH_SENSOR_SLOTS, (unsigned int)errors);
+    return errors == 0 ? 0 : 1;
+}
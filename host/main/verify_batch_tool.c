@@ -0,0 +1,135 @@
+/*!
+ * @file verify_batch_tool.c
+ * @brief Check batches of signatures with the batch verification and one by one.
+ *
+ * Every line of the input is a batch: the public key, followed by the items
+ * as signed data and signature, all in hex:
+ * ```
+ * <public key> <data>:<signature> <data>:<signature> ...
+ * ```
+ * For every batch, a line with the result of the batch equation (0 or -1),
+ * the results of ed25519_verify_key() for every item and the valid flags
+ * of ubirch_verify_batch() is printed, e.g. `-1 1101 1101`. host/verify_test.py
+ * generates the batches and compares the results.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "verify_batch.h"
+
+// ctest skips the test with this exit code
+#define VERIFY_TOOL_SKIPPED 77
+
+#if CONFIG_UBIRCH_VERIFY_BATCH
+
+#define VERIFY_TOOL_LINE_SIZE (2 * (crypto_sign_PUBLICKEYBYTES \
+        + CONFIG_UBIRCH_VERIFY_BATCH_SIZE * (UBIRCH_VERIFY_DATA_SIZE + crypto_sign_BYTES + 2)) + 2)
+
+static char line[VERIFY_TOOL_LINE_SIZE];
+static ubirch_verify_item_t items[CONFIG_UBIRCH_VERIFY_BATCH_SIZE];
+
+/*!
+ * Decode the hex digits of \p hex up to the first character of \p ends.
+ *
+ * @return the number of bytes, or -1 if the digits are invalid or too many
+ */
+static long hex_decode(const char **hex, const char *ends, unsigned char *out, size_t size) {
+    size_t len = 0;
+    const char *in = *hex;
+    while (*in != '\0' && strchr(ends, *in) == NULL) {
+        unsigned int byte;
+        if (len == size || sscanf(in, "%2x", &byte) != 1 || in[1] == '\0' || strchr(ends, in[1]) != NULL) {
+            return -1;
+        }
+        out[len++] = (unsigned char)byte;
+        in += 2;
+    }
+    *hex = in;
+    return (long)len;
+}
+
+/*!
+ * Parse a batch.
+ *
+ * @return the number of items, or -1 if the line is invalid
+ */
+static int batch_parse(const char *in, unsigned char public_key[crypto_sign_PUBLICKEYBYTES]) {
+    if (hex_decode(&in, " \n", public_key, crypto_sign_PUBLICKEYBYTES) != crypto_sign_PUBLICKEYBYTES) {
+        return -1;
+    }
+    int count = 0;
+    while (*in == ' ') {
+        in++;
+        if (count == CONFIG_UBIRCH_VERIFY_BATCH_SIZE) {
+            return -1;
+        }
+        ubirch_verify_item_t *item = &items[count++];
+        long len = hex_decode(&in, ":", item->data, sizeof(item->data));
+        if (len < 0 || *in++ != ':' || hex_decode(&in, " \n", item->signature, sizeof(item->signature))
+                != crypto_sign_BYTES) {
+            return -1;
+        }
+        item->len = (size_t)len;
+        item->valid = false;
+    }
+    return (*in == '\n' || *in == '\0') ? count : -1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 2 && strcmp(argv[1], "--batch-size") == 0) {
+        printf("%d\n", CONFIG_UBIRCH_VERIFY_BATCH_SIZE);
+        return 0;
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [--batch-size] < batches\n", argv[0]);
+        return 2;
+    }
+
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+    unsigned int number = 0;
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        number++;
+        int count = batch_parse(line, public_key);
+        if (count < 0) {
+            fprintf(stderr, "line %u: invalid batch\n", number);
+            return 2;
+        }
+        printf("%d ", ubirch_verify_batch_check(items, (size_t)count, public_key));
+        for (int i = 0; i < count; ++i) {
+            putchar(ed25519_verify_key(items[i].data, items[i].len, items[i].signature, public_key) == 0 ? '1' : '0');
+        }
+        putchar(' ');
+        ubirch_verify_batch(items, (size_t)count, public_key);
+        for (int i = 0; i < count; ++i) {
+            putchar(items[i].valid ? '1' : '0');
+        }
+        putchar('\n');
+    }
+    return 0;
+}
+
+#else
+
+int main(void) {
+    fprintf(stderr, "the batch verification is not configured\n");
+    return VERIFY_TOOL_SKIPPED;
+}
+
+#endif
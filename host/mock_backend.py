@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""
+Mock of the ubirch backend for the host build.
+
+Serves the key service, the thing registration and the niomon data service on
+one port. A key is registered as msgpack UPP and replaced by a JSON key update,
+which the new and the previous key sign. Every UPP is verified with the
+registered keys of its device, the
+chain of every device is followed and a signed, chained answer is sent back,
+like niomon does. A UPP, which is sent again, is counted as duplicate. The server key is the RFC 8032 test key, its public key is
+configured in sdkconfig.host.
+
+Faults of the data service can be injected: failed answers, dropped
+connections and an outage, to exercise the retries and the circuit breaker.
+"""
+
+import argparse
+import base64
+import hashlib
+import json
+import random
+import secrets
+import socket
+import sys
+import threading
+import time
+import uuid
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+import msgpack
+
+try:
+    from nacl.exceptions import BadSignatureError
+    from nacl.signing import SigningKey, VerifyKey
+except ImportError:
+    # slower, but enough for the tests
+    from ed25519_ref import BadSignatureError, SigningKey, VerifyKey
+
+SERVER_SEED = bytes.fromhex("9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60")
+SERVER_UUID = uuid.UUID("9d3c78ff-22f3-4441-a5d1-85c636d486ff").bytes
+
+PROTO_SIGNED = 0x22
+PROTO_CHAINED = 0x23
+TYPE_BIN = 0x00
+SIGNATURE_SIZE = 64
+
+
+class Backend:
+    def __init__(self, delay_ms, capacity, faults):
+        self.delay = delay_ms / 1000.0
+        self.capacity = capacity
+        self.in_flight = 0
+        self.faults = faults
+        self.started = time.monotonic()
+        self.signing_key = SigningKey(SERVER_SEED)
+        self.lock = threading.Lock()
+        self.keys = {}  # the keys of every device, the current one first
+        self.last_signature = {}
+        self.last_response = {}
+        self.anchored = set()
+        self.stats = {"keys": 0, "key_updates": 0, "things": 0, "upps": 0, "duplicates": 0, "chain_breaks": 0, "rejected": 0,
+                      "overloaded": 0, "faults": 0, "dropped": 0}
+
+    def count(self, name):
+        with self.lock:
+            self.stats[name] += 1
+
+    @staticmethod
+    def verify(key, message):
+        """Verify a UPP, the firmware signs either the message or its SHA-512."""
+        signed, signature = message[:-SIGNATURE_SIZE - 2], message[-SIGNATURE_SIZE:]
+        for data in (hashlib.sha512(signed).digest(), signed):
+            try:
+                key.verify(data, signature)
+                return True
+            except BadSignatureError:
+                pass
+        return False
+
+    def sign(self, fields):
+        message = msgpack.packb(fields + [b""], use_bin_type=True)
+        # the packed empty bin at the end is replaced by the signature
+        signed = message[:-2]
+        signature = self.signing_key.sign(hashlib.sha512(signed).digest()).signature
+        return signed + msgpack.packb(signature, use_bin_type=True)
+
+    def register_key(self, body):
+        upp = msgpack.unpackb(body, raw=False)
+        info = upp[3]
+        key = VerifyKey(info["pubKey"])
+        if not self.verify(key, body):
+            self.count("rejected")
+            return 400, "application/json", b'{"error":"invalid signature"}'
+        with self.lock:
+            keys = self.keys.get(upp[1], [])
+            if keys and bytes(keys[0]) != info["pubKey"]:
+                # only the owner of the registered key can replace it, with a key update
+                self.stats["rejected"] += 1
+                return 409, "application/json", b'{"error":"device has a key"}'
+            self.keys[upp[1]] = [key]
+            self.stats["keys"] += 1
+        return 200, "application/json", json.dumps({"pubKeyInfo": {"hwDeviceId": str(uuid.UUID(bytes=upp[1]))}}).encode()
+
+    def update_key(self, body):
+        """Replace the key of a device, the compact JSON of the key info with sorted members is signed by the new
+        and by the previous key."""
+        request = json.loads(body)
+        info = request["pubKeyInfo"]
+        signed = json.dumps(info, separators=(",", ":"), sort_keys=True).encode()
+        device = uuid.UUID(info["hwDeviceId"]).bytes
+        key = VerifyKey(base64.b64decode(info["pubKey"]))
+        with self.lock:
+            keys = self.keys.get(device, [])
+        previous = keys[0] if keys else None
+        try:
+            valid = (previous is not None and base64.b64decode(info["prevPubKeyId"]) == bytes(previous)
+                     and key.verify(signed, base64.b64decode(request["signature"])) is not None
+                     and previous.verify(signed, base64.b64decode(request["prevSignature"])) is not None)
+        except BadSignatureError:
+            valid = False
+        if not valid:
+            self.count("rejected")
+            return 400, "application/json", b'{"error":"invalid key update"}'
+        with self.lock:
+            # the UPPs, which were signed before, are still verified with the previous key
+            self.keys[device] = [key] + keys
+            self.stats["key_updates"] += 1
+        return 200, "application/json", json.dumps({"pubKeyInfo": info}).encode()
+
+    def create_thing(self, body):
+        self.count("things")
+        password = secrets.token_hex(16)
+        return 200, "application/json", json.dumps([{"hwDeviceId": "", "password": password}],
+                                                  separators=(",", ":")).encode()
+
+    def fault(self):
+        """Injected fault of the next anchoring: "drop" the connection, an http status, or None."""
+        faults = self.faults
+        outage = faults.outage
+        if outage and outage[0] <= time.monotonic() - self.started < outage[0] + outage[1]:
+            self.count("faults")
+            return 503
+        if faults.drop_rate and random.random() < faults.drop_rate:
+            self.count("dropped")
+            return "drop"
+        if faults.fail_rate and random.random() < faults.fail_rate:
+            self.count("faults")
+            return random.choice(faults.fail_status)
+        return None
+
+    def anchor(self, headers, body):
+        """Anchor a UPP, with more than capacity UPPs in progress the backend fails like an overloaded niomon."""
+        with self.lock:
+            if self.capacity and self.in_flight >= self.capacity:
+                self.stats["overloaded"] += 1
+                return 500, "text/plain", b"overloaded"
+            self.in_flight += 1
+        try:
+            return self.anchor_upp(headers, body)
+        finally:
+            with self.lock:
+                self.in_flight -= 1
+
+    def anchor_upp(self, headers, body):
+        try:
+            hardware_id = uuid.UUID(headers.get("X-Ubirch-Hardware-Id", "")).bytes
+        except ValueError:
+            hardware_id = None
+        if headers.get("X-Ubirch-Auth-Type") != "ubirch" or not headers.get("X-Ubirch-Credential"):
+            self.count("rejected")
+            return 401, "text/plain", b"missing credentials"
+        upp = msgpack.unpackb(body, raw=False)
+        with self.lock:
+            keys = self.keys.get(upp[1], [])
+        if upp[1] != hardware_id or not any(self.verify(key, body) for key in keys):
+            self.count("rejected")
+            return 400, "text/plain", b"invalid UPP"
+        signature = upp[-1]
+        with self.lock:
+            if signature in self.anchored:
+                # sent again, as the gateway stopped before it knew of the delivery, the chain goes on
+                self.stats["duplicates"] += 1
+            else:
+                previous = self.last_signature.get(upp[1])
+                if upp[0] == PROTO_CHAINED and previous is not None and upp[2] != previous:
+                    self.stats["chain_breaks"] += 1
+                self.stats["upps"] += 1
+                self.anchored.add(signature)
+                self.last_signature[upp[1]] = signature
+            previous_response = self.last_response.get(upp[1], bytes(SIGNATURE_SIZE))
+        if self.delay:
+            time.sleep(self.delay)
+        response = self.sign([PROTO_CHAINED, SERVER_UUID, previous_response, TYPE_BIN,
+                              hashlib.sha512(body).digest()])
+        with self.lock:
+            self.last_response[upp[1]] = response[-SIGNATURE_SIZE:]
+        return 200, "application/octet-stream", response
+
+
+def handler(backend, verbose):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def do_POST(self):
+            body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+            try:
+                if self.path.startswith("/api/keyService/") and self.path.endswith("/mpack"):
+                    status, content_type, answer = backend.register_key(body)
+                elif self.path.startswith("/api/keyService/"):
+                    status, content_type, answer = backend.update_key(body)
+                elif self.path.startswith("/ubirch-web-ui/api/v1/devices/create"):
+                    status, content_type, answer = backend.create_thing(body)
+                else:
+                    fault = backend.fault()
+                    if fault == "drop":
+                        # like a lost connection, the UPP is not anchored
+                        self.close_connection = True
+                        self.connection.shutdown(socket.SHUT_RDWR)
+                        return
+                    if fault is not None:
+                        status, content_type, answer = fault, "text/plain", b"injected fault"
+                    else:
+                        status, content_type, answer = backend.anchor(self.headers, body)
+            except (ValueError, IndexError, KeyError, TypeError, msgpack.UnpackException) as e:
+                backend.count("rejected")
+                status, content_type, answer = 400, "text/plain", str(e).encode()
+            self.send_response(status)
+            self.send_header("Content-Type", content_type)
+            self.send_header("Content-Length", str(len(answer)))
+            self.end_headers()
+            self.wfile.write(answer)
+
+        def log_message(self, format, *args):
+            if verbose:
+                super().log_message(format, *args)
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description="mock of the ubirch backend for the host build")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--delay-ms", type=float, default=0, help="latency added to every anchored UPP")
+    parser.add_argument("--capacity", type=int, default=0,
+                        help="UPPs anchored at the same time, more are answered with 500, 0 for no limit")
+    parser.add_argument("--fail-rate", type=float, default=0,
+                        help="share of the UPPs, which are answered with one of --fail-status, not anchored")
+    parser.add_argument("--fail-status", type=lambda v: [int(s) for s in v.split(",")], default=[500, 503],
+                        help="comma separated http status codes of the injected failures (default 500,503)")
+    parser.add_argument("--drop-rate", type=float, default=0,
+                        help="share of the UPPs, whose connection is closed without an answer")
+    parser.add_argument("--outage", type=lambda v: [float(s) for s in v.split(",")], default=None,
+                        metavar="START,DURATION", help="answer all UPPs with 503 for DURATION seconds after START")
+    parser.add_argument("--seed", type=int, default=None, help="seed of the injected faults, random if none is given")
+    parser.add_argument("--stats-interval", type=float, default=10, help="seconds between statistics, 0 for none")
+    parser.add_argument("-v", "--verbose", action="store_true", help="log every request")
+    args = parser.parse_args()
+    random.seed(args.seed)
+
+    backend = Backend(args.delay_ms, args.capacity, args)
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), handler(backend, args.verbose))
+    server.daemon_threads = True
+
+    def report():
+        while True:
+            time.sleep(args.stats_interval)
+            with backend.lock:
+                print(json.dumps(backend.stats), file=sys.stderr, flush=True)
+
+    if args.stats_interval > 0:
+        threading.Thread(target=report, daemon=True).start()
+    print(f"mock backend on http://127.0.0.1:{args.port}", file=sys.stderr, flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    with backend.lock:
+        print(json.dumps(backend.stats), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+Compare two JSON reports of the host benchmark.
+
+Fails if the current report is worse than the baseline by more than the
+tolerance: fewer UPPs per second, a higher p99 latency of a pipeline stage,
+more flash reads per sensor index lookup, more erase cycles of a flash
+partition or a higher heap peak. Also fails if the runtime metrics of the
+current report cost more than --max-metrics-overhead percent.
+"""
+
+import argparse
+import json
+import sys
+
+
+def metrics(report):
+    """Yield (name, value, higher_is_better) of the compared metrics."""
+    yield "throughput.upps_per_s", report["throughput"]["upps_per_s"], True
+    for stage, latency in sorted(report["stages"].items()):
+        if latency["count"] > 0:
+            yield f"stages.{stage}.p99_us", latency["p99_us"], False
+    index = report.get("sensor_index")
+    if index is not None and index["lookups"] > 0:
+        yield "sensor_index.probes_per_lookup", index["probes_per_lookup"], False
+    for label, wear in sorted(report.get("flash", {}).items()):
+        yield f"flash.{label}.cycles_per_million_upps", wear["cycles_per_million_upps"], False
+    yield "heap.peak_bytes", report["heap"]["peak_bytes"], False
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare two reports of the host benchmark")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--tolerance", type=float, default=10, help="allowed regression in percent")
+    parser.add_argument("--max-metrics-overhead", type=float, default=1.0,
+                        help="allowed cost of the runtime metrics in percent of the measured time")
+    args = parser.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = dict((name, value) for name, value, _ in metrics(json.load(f)))
+    with open(args.current) as f:
+        report = json.load(f)
+        current = list(metrics(report))
+
+    regressions = 0
+    for name, value, higher_is_better in current:
+        if name not in baseline:
+            continue
+        base = baseline[name]
+        change = (value - base) * 100.0 / base if base else 0.0
+        regressed = -change > args.tolerance if higher_is_better else change > args.tolerance
+        regressions += regressed
+        print(f"{'REGRESSION' if regressed else 'ok':10} {name:32} {base:>12} -> {value:>12} ({change:+.1f}%)")
+
+    # an absolute limit, the overhead is compared to the time it slows down and not to the baseline
+    if "metrics" in report:
+        overhead = report["metrics"]["overhead_percent"]
+        exceeded = overhead > args.max_metrics_overhead
+        regressions += exceeded
+        print(f"{'REGRESSION' if exceeded else 'ok':10} {'metrics.overhead_percent':32} "
+              f"{args.max_metrics_overhead:>12} >= {overhead:>12}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
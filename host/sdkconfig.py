@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""
+Generate the sdkconfig.h and the sdkconfig.cmake of the host build.
+
+The host build does not use the build system of ESP-IDF, so the Kconfig of
+the application is evaluated here: the defaults of the Kconfig, overridden
+by the sdkconfig defaults files, with the dependencies of the options.
+Options, which are only in the defaults files (e.g. of ESP-IDF), are
+written as they are.
+
+    python3 sdkconfig.py --kconfig main/Kconfig.projbuild \
+        --defaults sdkconfig.defaults --defaults host/sdkconfig.host \
+        --output build/config/sdkconfig.h --cmake build/config/sdkconfig.cmake
+"""
+
+import argparse
+import re
+import sys
+
+
+class Option:
+    def __init__(self, name):
+        self.name = name
+        self.type = None
+        self.defaults = []      # (value, condition)
+        self.depends = []       # conditions
+        self.range = None
+
+
+def parse_kconfig(path):
+    options = {}
+    current = None
+    with open(path) as f:
+        for line in f:
+            s = line.strip()
+            m = re.match(r"(?:menu)?config\s+(\w+)$", s)
+            if m:
+                current = options.setdefault(m.group(1), Option(m.group(1)))
+                continue
+            if s in ("menu", "endmenu") or s.startswith("menu ") or s.startswith("choice") or s == "endchoice":
+                current = None
+                continue
+            if current is None:
+                continue
+            m = re.match(r"(bool|int|hex|string)\b", s)
+            if m and current.type is None:
+                current.type = m.group(1)
+                continue
+            m = re.match(r"default\s+(\"[^\"]*\"|\S+)(?:\s+if\s+(.+))?$", s)
+            if m:
+                current.defaults.append((m.group(1), m.group(2)))
+                continue
+            m = re.match(r"depends on\s+(.+)$", s)
+            if m:
+                current.depends.append(m.group(1))
+                continue
+            m = re.match(r"range\s+(\S+)\s+(\S+)$", s)
+            if m:
+                current.range = (int(m.group(1), 0), int(m.group(2), 0))
+    return options
+
+
+def parse_defaults(paths):
+    values = {}
+    for path in paths:
+        with open(path) as f:
+            for number, line in enumerate(f, 1):
+                s = line.strip()
+                m = re.match(r"#\s*CONFIG_(\w+) is not set$", s)
+                if m:
+                    values[m.group(1)] = "n"
+                    continue
+                if not s or s.startswith("#"):
+                    continue
+                m = re.match(r"CONFIG_(\w+)=(\"(?:[^\"\\]|\\.)*\"|[^\s\"]+)$", s)
+                if not m:
+                    print("%s:%d: skipped malformed line: %s" % (path, number, s), file=sys.stderr)
+                    continue
+                values[m.group(1)] = m.group(2)
+    return values
+
+
+def evaluate(expression, values):
+    """Evaluate a Kconfig condition with !, &&, || and parentheses."""
+    tokens = re.findall(r"\w+|&&|\|\||!|\(|\)", expression)
+    position = 0
+
+    def peek():
+        return tokens[position] if position < len(tokens) else None
+
+    def take():
+        nonlocal position
+        position += 1
+        return tokens[position - 1]
+
+    def primary():
+        token = take()
+        if token == "!":
+            return not primary()
+        if token == "(":
+            value = disjunction()
+            take()
+            return value
+        return values.get(token, "n") not in ("n", "", "0")
+
+    def conjunction():
+        value = primary()
+        while peek() == "&&":
+            take()
+            value = primary() and value
+        return value
+
+    def disjunction():
+        value = conjunction()
+        while peek() == "||":
+            take()
+            value = conjunction() or value
+        return value
+
+    return disjunction()
+
+
+def resolve(options, overrides):
+    values = {}
+    # iterate, until the dependencies do not change the values anymore
+    for _ in range(len(options) + 1):
+        previous = dict(values)
+        for option in options.values():
+            if not all(evaluate(d, values) for d in option.depends):
+                values[option.name] = "n" if option.type == "bool" else None
+                continue
+            if option.name in overrides:
+                values[option.name] = overrides[option.name]
+                continue
+            value = "n" if option.type == "bool" else None
+            for default, condition in option.defaults:
+                if condition is None or evaluate(condition, values):
+                    value = default
+                    break
+            values[option.name] = value
+        if values == previous:
+            break
+    for option in options.values():
+        value = values.get(option.name)
+        if option.range and value is not None:
+            number = int(value, 0)
+            if not option.range[0] <= number <= option.range[1]:
+                sys.exit("CONFIG_%s=%s is out of range %d..%d" % (option.name, value, *option.range))
+    return values
+
+
+def define(name, value):
+    if value is None or value == "n":
+        return None
+    if value == "y":
+        value = "1"
+    return "#define CONFIG_%s %s" % (name, value)
+
+
+def cmake_set(name, value):
+    """The variable of the option, like in the sdkconfig.cmake of ESP-IDF."""
+    if value is None or value == "n":
+        value = ""
+    elif value.startswith("\""):
+        # the escapes of the C string are the same in CMake
+        value = value[1:-1]
+    return 'set(CONFIG_%s "%s")' % (name, value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--kconfig", required=True)
+    parser.add_argument("--defaults", action="append", default=[])
+    parser.add_argument("--output", required=True)
+    parser.add_argument("--cmake", help="also write the options as CMake variables")
+    args = parser.parse_args()
+
+    options = parse_kconfig(args.kconfig)
+    overrides = parse_defaults(args.defaults)
+    values = resolve(options, overrides)
+
+    lines = ["/* generated by host/sdkconfig.py, do not edit */", "#pragma once"]
+    cmake_lines = ["# generated by host/sdkconfig.py, do not edit"]
+    for name in sorted(set(values) | set(overrides)):
+        value = values[name] if name in options else overrides[name]
+        line = define(name, value)
+        if line:
+            lines.append(line)
+        cmake_lines.append(cmake_set(name, value))
+    with open(args.output, "w") as f:
+        f.write("\n".join(lines) + "\n")
+    if args.cmake:
+        with open(args.cmake, "w") as f:
+            f.write("\n".join(cmake_lines) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,187 @@
+/*!
+ * @file api_http.c
+ * @brief Backend API of the gateway for the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_http_client.h>
+#include <esp_log.h>
+#include <mbedtls/base64.h>
+#include <msgpack.h>
+
+#include "host_platform.h"
+#include "id_handling.h"
+#include "response.h"
+#include "ubirch_api.h"
+
+static const char *TAG = "api_http";
+
+#define API_CREDENTIAL_SIZE 96
+
+typedef struct {
+    msgpack_unpacker *unpacker;
+    char *response;
+    size_t response_size;
+    size_t response_len;
+} api_receiver_t;
+
+static esp_err_t api_event_handler(esp_http_client_event_t *evt) {
+    api_receiver_t *receiver = evt->user_data;
+    if (evt->event_id != HTTP_EVENT_ON_DATA) {
+        return ESP_OK;
+    }
+    if (receiver->unpacker != NULL) {
+        if (msgpack_unpacker_buffer_capacity(receiver->unpacker) < (size_t)evt->data_len
+                && !msgpack_unpacker_reserve_buffer(receiver->unpacker, (size_t)evt->data_len)) {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(msgpack_unpacker_buffer(receiver->unpacker), evt->data, (size_t)evt->data_len);
+        msgpack_unpacker_buffer_consumed(receiver->unpacker, (size_t)evt->data_len);
+    } else if (receiver->response != NULL) {
+        size_t len = (size_t)evt->data_len;
+        if (len > receiver->response_size - 1 - receiver->response_len) {
+            len = receiver->response_size - 1 - receiver->response_len;
+        }
+        memcpy(receiver->response + receiver->response_len, evt->data, len);
+        receiver->response_len += len;
+        receiver->response[receiver->response_len] = '\0';
+    }
+    return ESP_OK;
+}
+
+/*!
+ * Post \p data on a new connection, the response goes to \p receiver.
+ */
+static esp_err_t api_post(const char *url, const char *headers[][2], size_t header_count,
+        const char *data, size_t length, int *http_status, api_receiver_t *receiver) {
+    esp_http_client_config_t config = {
+            .url = url,
+            .method = HTTP_METHOD_POST,
+            .event_handler = api_event_handler,
+            .user_data = receiver,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < header_count; ++i) {
+        esp_http_client_set_header(client, headers[i][0], headers[i][1]);
+    }
+    esp_http_client_set_post_field(client, data, (int)length);
+    esp_err_t err = esp_http_client_perform(client);
+    if (err == ESP_OK) {
+        *http_status = esp_http_client_get_status_code(client);
+    } else {
+        ESP_LOGE(TAG, "request to %s failed: %s", url, esp_err_to_name(err));
+    }
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+esp_err_t host_http_post(const char *url, const char *content_type, const char *authorization,
+        const char *data, size_t length, int *http_status, char *response, size_t response_size,
+        size_t *response_len) {
+    const char *headers[][2] = {
+            { "Content-Type", content_type },
+            { "Authorization", authorization },
+    };
+    api_receiver_t receiver = {
+            .response = response,
+            .response_size = response_size,
+    };
+    if (response != NULL && response_size > 0) {
+        response[0] = '\0';
+    }
+    esp_err_t err = api_post(url, headers, (authorization != NULL) ? 2 : 1, data, length, http_status, &receiver);
+    if (response_len != NULL) {
+        *response_len = receiver.response_len;
+    }
+    return err;
+}
+
+ubirch_send_err_t ubirch_send(const char *url, const unsigned char *uuid, const char *data, const size_t length,
+        int *http_status, msgpack_unpacker *unpacker, ubirch_protocol_check verifier) {
+    char *password = NULL;
+    size_t password_len = 0;
+    if (ubirch_password_get(&password, &password_len) != ESP_OK) {
+        ESP_LOGE(TAG, "no password in current context");
+        return UBIRCH_SEND_ERROR;
+    }
+    unsigned char credential[API_CREDENTIAL_SIZE];
+    size_t credential_len = 0;
+    if (mbedtls_base64_encode(credential, sizeof(credential), &credential_len,
+                (const unsigned char *)password, password_len) != 0) {
+        return UBIRCH_SEND_ERROR;
+    }
+    char uuid_string[37];
+    uuid_to_string(uuid, uuid_string, sizeof(uuid_string));
+    const char *headers[][2] = {
+            { "Content-Type", "application/octet-stream" },
+            { "X-Ubirch-Hardware-Id", uuid_string },
+            { "X-Ubirch-Auth-Type", "ubirch" },
+            { "X-Ubirch-Credential", (const char *)credential },
+    };
+    api_receiver_t receiver = { .unpacker = unpacker };
+    if (api_post(url, headers, 4, data, length, http_status, &receiver) != ESP_OK) {
+        return UBIRCH_SEND_ERROR;
+    }
+    if (unpacker != NULL && verifier != NULL && *http_status >= 200 && *http_status < 300) {
+        if (ubirch_protocol_verify(unpacker->buffer + unpacker->off, unpacker->used - unpacker->off,
+                    verifier) != 0) {
+            return UBIRCH_SEND_VERIFICATION_FAILED;
+        }
+    }
+    return UBIRCH_SEND_OK;
+}
+
+bool match(const msgpack_object_kv *entry, const char *key, msgpack_object_type type) {
+    size_t len = strlen(key);
+    return entry->key.type == MSGPACK_OBJECT_STR && entry->key.via.str.size == len
+            && memcmp(entry->key.via.str.ptr, key, len) == 0 && entry->val.type == type;
+}
+
+int ubirch_parse_backend_response(msgpack_unpacker *unpacker, ubirch_bin_response_handler handler) {
+    msgpack_unpacked result;
+    msgpack_unpacked_init(&result);
+    int rc = UBIRCH_ESP32_API_HTTP_RESPONSE_ERROR;
+    if (msgpack_unpacker_next(unpacker, &result) == MSGPACK_UNPACK_SUCCESS
+            && result.data.type == MSGPACK_OBJECT_ARRAY && result.data.via.array.size >= 2) {
+        // the payload is in front of the signature
+        const msgpack_object *payload = &result.data.via.array.ptr[result.data.via.array.size - 2];
+        if (payload->type == MSGPACK_OBJECT_MAP) {
+            for (uint32_t i = 0; i < payload->via.map.size; ++i) {
+                response_handler(&payload->via.map.ptr[i]);
+            }
+            rc = UBIRCH_ESP32_API_HTTP_RESPONSE_SUCCESS;
+        } else if (payload->type == MSGPACK_OBJECT_BIN) {
+            if (handler != NULL) {
+                handler(payload->via.bin.ptr, payload->via.bin.size);
+            }
+            rc = UBIRCH_ESP32_API_HTTP_RESPONSE_SUCCESS;
+        }
+    }
+    if (rc != UBIRCH_ESP32_API_HTTP_RESPONSE_SUCCESS) {
+        ESP_LOGW(TAG, "unexpected response");
+    }
+    msgpack_unpacked_destroy(&result);
+    return rc;
+}
@@ -0,0 +1,28 @@
+/*!
+ * @file api-http-helper.h
+ * @brief HTTP helper of the backend API for the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_API_HTTP_HELPER_H
+#define HOST_API_HTTP_HELPER_H
+
+#include <stddef.h>
+#include <esp_err.h>
+
+#endif /* HOST_API_HTTP_HELPER_H */
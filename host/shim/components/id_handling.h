@@ -0,0 +1,68 @@
+/*!
+ * @file id_handling.h
+ * @brief ID contexts of the key storage for the host build.
+ *
+ * The contexts are kept in memory, see key_storage.c. The current context is
+ * a copy, which is only written to the storage by ubirch_id_context_store(),
+ * like on the target.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_ID_HANDLING_H
+#define HOST_ID_HANDLING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <esp_err.h>
+#include <esp_system.h>
+
+#define UBIRCH_ID_STATE_KEYS_CREATED 0
+#define UBIRCH_ID_STATE_PASSWORD_SET 1
+#define UBIRCH_ID_STATE_KEYS_REGISTERED 2
+#define UBIRCH_ID_STATE_ID_REGISTERED 3
+
+typedef unsigned char uuid_t[16];
+
+esp_err_t ubirch_id_context_add(const char *short_name);
+esp_err_t ubirch_id_context_delete(const char *short_name);
+esp_err_t ubirch_id_context_load(const char *short_name);
+esp_err_t ubirch_id_context_store(void);
+
+void ubirch_id_state_set(uint8_t state_bit, bool value);
+bool ubirch_id_state_get(uint8_t state_bit);
+
+esp_err_t ubirch_uuid_set(const unsigned char *uuid, size_t len);
+esp_err_t ubirch_uuid_get(unsigned char **uuid, size_t *len);
+esp_err_t ubirch_password_set(const char *password, size_t len);
+esp_err_t ubirch_password_get(char **password, size_t *len);
+esp_err_t ubirch_public_key_set(const unsigned char *key, size_t len);
+esp_err_t ubirch_public_key_get(unsigned char **key, size_t *len);
+esp_err_t ubirch_secret_key_set(const unsigned char *key, size_t len);
+esp_err_t ubirch_secret_key_get(unsigned char **key, size_t *len);
+esp_err_t ubirch_previous_signature_set(const unsigned char *signature, size_t len);
+esp_err_t ubirch_previous_signature_get(unsigned char **signature, size_t *len);
+esp_err_t ubirch_next_key_update_set(time_t next);
+esp_err_t ubirch_next_key_update_get(time_t *next);
+
+esp_err_t uuid_v5_create_derived_from_name(uuid_t *uuid, char *name_space, size_t name_space_len,
+        char *gateway, size_t gateway_len, char *name, size_t name_len);
+void uuid_to_string(const unsigned char *uuid, char *buffer, size_t len);
+
+#endif /* HOST_ID_HANDLING_H */
@@ -0,0 +1,46 @@
+/*!
+ * @file key_handling.h
+ * @brief Key handling of the key storage for the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_KEY_HANDLING_H
+#define HOST_KEY_HANDLING_H
+
+#include <esp_err.h>
+#include <ubirch_ed25519.h>
+
+extern unsigned char server_pub_key[crypto_sign_PUBLICKEYBYTES];
+
+/*!
+ * Create a new key pair in the current context.
+ */
+void create_keys(void);
+
+/*!
+ * Register the public key of the current context at the key server.
+ */
+esp_err_t register_keys(void);
+esp_err_t update_keys(void);
+
+/*!
+ * Load the public key of the backend from CONFIG_UBIRCH_BACKEND_PUBLIC_KEY.
+ */
+esp_err_t load_backend_key(void);
+
+#endif /* HOST_KEY_HANDLING_H */
@@ -0,0 +1,55 @@
+/*!
+ * @file networking.h
+ * @brief Networking of the gateway for the host build.
+ *
+ * The host is always connected, init_wifi() sets the connected bit at once.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_NETWORKING_H
+#define HOST_NETWORKING_H
+
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+#include <esp_err.h>
+
+#define WIFI_CONNECTED_BIT BIT0
+#define NETWORK_ETH_READY BIT1
+#define NETWORK_STA_READY BIT2
+
+#ifndef BIT0
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+#endif
+
+extern EventGroupHandle_t network_event_group;
+
+struct Wifi_login {
+    char *ssid;
+    size_t ssid_length;
+    char *pwd;
+    size_t pwd_length;
+};
+
+void init_wifi(void);
+esp_err_t wifi_join(struct Wifi_login wifi, int timeout_ms);
+
+#endif /* HOST_NETWORKING_H */
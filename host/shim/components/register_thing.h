@@ -0,0 +1,36 @@
+/*!
+ * @file register_thing.h
+ * @brief Registration of things for the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_REGISTER_THING_H
+#define HOST_REGISTER_THING_H
+
+typedef enum {
+    UBIRCH_ESP32_REGISTER_THING_SUCCESS,
+    UBIRCH_ESP32_REGISTER_THING_ALREADY_REGISTERED,
+    UBIRCH_ESP32_REGISTER_THING_ERROR,
+} ubirch_register_thing_t;
+
+/*!
+ * Register the UUID of the current context and store the password of the response.
+ */
+int ubirch_register_current_id(char *description);
+
+#endif /* HOST_REGISTER_THING_H */
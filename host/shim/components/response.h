@@ -0,0 +1,46 @@
+/*!
+ * @file response.h
+ * @brief Response parsing of the backend API for the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_RESPONSE_H
+#define HOST_RESPONSE_H
+
+#include <stdbool.h>
+#include <msgpack.h>
+
+#define UBIRCH_ESP32_API_HTTP_RESPONSE_SUCCESS 0
+#define UBIRCH_ESP32_API_HTTP_RESPONSE_ERROR (-1)
+
+typedef void (*ubirch_bin_response_handler)(const void *data, size_t len);
+
+/*!
+ * Handler of the map payloads, which the application has to define.
+ */
+void response_handler(const struct msgpack_object_kv *entry);
+
+bool match(const msgpack_object_kv *entry, const char *key, msgpack_object_type type);
+
+/*!
+ * Parse the response UPP, a map payload is given to response_handler(),
+ * a binary payload to \p handler.
+ */
+int ubirch_parse_backend_response(msgpack_unpacker *unpacker, ubirch_bin_response_handler handler);
+
+#endif /* HOST_RESPONSE_H */
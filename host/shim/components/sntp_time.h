@@ -0,0 +1,27 @@
+/*!
+ * @file sntp_time.h
+ * @brief Time synchronization of the gateway for the host build, the host clock is used.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_SNTP_TIME_H
+#define HOST_SNTP_TIME_H
+
+void sntp_update(void);
+
+#endif /* HOST_SNTP_TIME_H */
@@ -0,0 +1,38 @@
+/*!
+ * @file token_handling.h
+ * @brief Token of the key storage for the host build.
+ *
+ * The token is read from the environment variable UBIRCH_TOKEN, the mock
+ * backend accepts any token.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_TOKEN_HANDLING_H
+#define HOST_TOKEN_HANDLING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#define UBIRCH_TOKEN_STATE_VALID 0
+
+esp_err_t ubirch_token_load(void);
+bool ubirch_token_state_get(uint8_t state_bit);
+esp_err_t ubirch_token_get(const char **token);
+
+#endif /* HOST_TOKEN_HANDLING_H */
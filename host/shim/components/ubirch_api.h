@@ -0,0 +1,41 @@
+/*!
+ * @file ubirch_api.h
+ * @brief Backend API for the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_UBIRCH_API_H
+#define HOST_UBIRCH_API_H
+
+#include <msgpack.h>
+#include <ubirch_protocol.h>
+
+typedef enum {
+    UBIRCH_SEND_OK = 0,
+    UBIRCH_SEND_VERIFICATION_FAILED,
+    UBIRCH_SEND_ERROR,
+} ubirch_send_err_t;
+
+/*!
+ * Send \p data with the credentials of the current context and
+ * verify the response with \p verifier.
+ */
+ubirch_send_err_t ubirch_send(const char *url, const unsigned char *uuid, const char *data, const size_t length,
+        int *http_status, msgpack_unpacker *unpacker, ubirch_protocol_check verifier);
+
+#endif /* HOST_UBIRCH_API_H */
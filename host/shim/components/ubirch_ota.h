@@ -0,0 +1,29 @@
+/*!
+ * @file ubirch_ota.h
+ * @brief Firmware update for the host build, there is no firmware to update.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_UBIRCH_OTA_H
+#define HOST_UBIRCH_OTA_H
+
+#include <esp_err.h>
+
+esp_err_t ubirch_firmware_update(void);
+
+#endif /* HOST_UBIRCH_OTA_H */
@@ -0,0 +1,383 @@
+/*!
+ * @file esp_http_client.c
+ * @brief HTTP client of ESP-IDF on POSIX sockets.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <esp_http_client.h>
+#include <esp_log.h>
+
+static const char *TAG = "http_client";
+
+#define HTTP_HOST_SIZE 64
+#define HTTP_PATH_SIZE 192
+#define HTTP_HEADERS 12
+#define HTTP_HEADER_KEY_SIZE 32
+#define HTTP_HEADER_VALUE_SIZE 128
+#define HTTP_BUFFER_SIZE 2048
+#define HTTP_DEFAULT_TIMEOUT_MS 5000
+
+struct esp_http_client {
+    http_event_handle_cb event_handler;
+    void *user_data;
+    bool keep_alive;
+    int timeout_ms;
+    bool tls;                   //!< https was requested, which is not supported
+    char host[HTTP_HOST_SIZE];
+    char port[8];
+    char path[HTTP_PATH_SIZE];
+    esp_http_client_method_t method;
+    const char *post_data;
+    int post_len;
+    struct {
+        char key[HTTP_HEADER_KEY_SIZE];
+        char value[HTTP_HEADER_VALUE_SIZE];
+    } headers[HTTP_HEADERS];
+    size_t header_count;
+    int fd;
+    int status_code;
+    int content_length;
+    char buffer[HTTP_BUFFER_SIZE];
+};
+
+static void event_dispatch(esp_http_client_handle_t client, esp_http_client_event_id_t id, void *data, int len) {
+    if (client->event_handler == NULL) {
+        return;
+    }
+    esp_http_client_event_t event = {
+            .event_id = id,
+            .client = client,
+            .data = data,
+            .data_len = len,
+            .user_data = client->user_data,
+    };
+    client->event_handler(&event);
+}
+
+static void connection_close(esp_http_client_handle_t client) {
+    if (client->fd < 0) {
+        return;
+    }
+    close(client->fd);
+    client->fd = -1;
+    event_dispatch(client, HTTP_EVENT_DISCONNECTED, NULL, 0);
+}
+
+static esp_err_t connection_open(esp_http_client_handle_t client) {
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *addresses = NULL;
+    if (getaddrinfo(client->host, client->port, &hints, &addresses) != 0) {
+        ESP_LOGE(TAG, "failed to resolve %s", client->host);
+        return ESP_ERR_HTTP_CONNECT;
+    }
+    int fd = -1;
+    for (struct addrinfo *a = addresses; a != NULL && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+        if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "failed to connect to %s:%s", client->host, client->port);
+        return ESP_ERR_HTTP_CONNECT;
+    }
+    struct timeval timeout = {
+            .tv_sec = client->timeout_ms / 1000,
+            .tv_usec = (client->timeout_ms % 1000) * 1000,
+    };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    client->fd = fd;
+    event_dispatch(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+    return ESP_OK;
+}
+
+static bool send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static ssize_t receive(int fd, char *buffer, size_t size) {
+    ssize_t n;
+    do {
+        n = recv(fd, buffer, size, 0);
+    } while (n < 0 && errno == EINTR);
+    return n;
+}
+
+static esp_err_t request_send(esp_http_client_handle_t client) {
+    static const char *methods[] = { "GET", "POST", "PUT", "PATCH", "DELETE", "HEAD" };
+    int len = snprintf(client->buffer, HTTP_BUFFER_SIZE, "%s %s HTTP/1.1\r\nHost: %s:%s\r\n"
+            "User-Agent: ESP32 HTTP Client/1.0\r\nConnection: %s\r\n",
+            methods[client->method], client->path, client->host, client->port,
+            client->keep_alive ? "keep-alive" : "close");
+    for (size_t i = 0; i < client->header_count; ++i) {
+        len += snprintf(client->buffer + len, (size_t)(HTTP_BUFFER_SIZE - len), "%s: %s\r\n",
+                client->headers[i].key, client->headers[i].value);
+    }
+    if (client->method != HTTP_METHOD_GET && client->method != HTTP_METHOD_HEAD) {
+        len += snprintf(client->buffer + len, (size_t)(HTTP_BUFFER_SIZE - len), "Content-Length: %d\r\n",
+                client->post_data != NULL ? client->post_len : 0);
+    }
+    len += snprintf(client->buffer + len, (size_t)(HTTP_BUFFER_SIZE - len), "\r\n");
+    if (len >= HTTP_BUFFER_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!send_all(client->fd, client->buffer, (size_t)len)
+            || (client->post_data != NULL && !send_all(client->fd, client->post_data, (size_t)client->post_len))) {
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    event_dispatch(client, HTTP_EVENT_HEADERS_SENT, NULL, 0);
+    return ESP_OK;
+}
+
+/*!
+ * Receive the response and give the body to the event handler.
+ *
+ * @param[out] close the server closes the connection after the response
+ */
+static esp_err_t response_receive(esp_http_client_handle_t client, bool *close) {
+    size_t used = 0;
+    char *body = NULL;
+    while (body == NULL) {
+        if (used == HTTP_BUFFER_SIZE - 1) {
+            return ESP_ERR_HTTP_FETCH_HEADER;
+        }
+        ssize_t n = receive(client->fd, client->buffer + used, HTTP_BUFFER_SIZE - 1 - used);
+        if (n <= 0) {
+            // nothing received: the server closed the kept connection
+            return (used == 0) ? ESP_FAIL : ESP_ERR_HTTP_FETCH_HEADER;
+        }
+        used += (size_t)n;
+        client->buffer[used] = '\0';
+        body = strstr(client->buffer, "\r\n\r\n");
+    }
+    *body = '\0';
+    body += 4;
+
+    int minor = 0;
+    if (sscanf(client->buffer, "HTTP/1.%d %d", &minor, &client->status_code) != 2) {
+        return ESP_ERR_HTTP_FETCH_HEADER;
+    }
+    client->content_length = -1;
+    *close = (minor == 0);
+    char *save = NULL;
+    strtok_r(client->buffer, "\r\n", &save);
+    for (char *line = strtok_r(NULL, "\r\n", &save); line != NULL; line = strtok_r(NULL, "\r\n", &save)) {
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            client->content_length = atoi(line + 15);
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            *close = (strcasestr(line + 11, "close") != NULL);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strcasestr(line + 18, "chunked") != NULL) {
+            ESP_LOGE(TAG, "chunked responses are not supported");
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    }
+    if (client->content_length < 0) {
+        // the body ends with the connection
+        *close = true;
+    }
+
+    size_t received = used - (size_t)(body - client->buffer);
+    if (received > 0) {
+        memmove(client->buffer, body, received);
+        event_dispatch(client, HTTP_EVENT_ON_DATA, client->buffer, (int)received);
+    }
+    while (client->content_length < 0 || received < (size_t)client->content_length) {
+        size_t wanted = HTTP_BUFFER_SIZE;
+        if (client->content_length >= 0 && (size_t)client->content_length - received < wanted) {
+            wanted = (size_t)client->content_length - received;
+        }
+        ssize_t n = receive(client->fd, client->buffer, wanted);
+        if (n <= 0) {
+            if (client->content_length < 0 && n == 0) {
+                break;
+            }
+            return ESP_FAIL;
+        }
+        received += (size_t)n;
+        event_dispatch(client, HTTP_EVENT_ON_DATA, client->buffer, (int)n);
+    }
+    return ESP_OK;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config) {
+    esp_http_client_handle_t client = calloc(1, sizeof(struct esp_http_client));
+    if (client == NULL) {
+        return NULL;
+    }
+    client->event_handler = config->event_handler;
+    client->user_data = config->user_data;
+    client->keep_alive = config->keep_alive_enable;
+    client->timeout_ms = (config->timeout_ms > 0) ? config->timeout_ms : HTTP_DEFAULT_TIMEOUT_MS;
+    client->method = config->method;
+    client->fd = -1;
+    if (config->url != NULL && esp_http_client_set_url(client, config->url) != ESP_OK) {
+        free(client);
+        return NULL;
+    }
+    return client;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url) {
+    bool tls = (strncmp(url, "https://", 8) == 0);
+    if (!tls && strncmp(url, "http://", 7) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char *host = url + (tls ? 8 : 7);
+    const char *path = strchr(host, '/');
+    size_t host_len = (path != NULL) ? (size_t)(path - host) : strlen(host);
+    const char *port = memchr(host, ':', host_len);
+    size_t name_len = (port != NULL) ? (size_t)(port - host) : host_len;
+    if (name_len >= HTTP_HOST_SIZE || (path != NULL && strlen(path) >= HTTP_PATH_SIZE)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    char new_host[HTTP_HOST_SIZE];
+    char new_port[8];
+    memcpy(new_host, host, name_len);
+    new_host[name_len] = '\0';
+    if (port != NULL) {
+        snprintf(new_port, sizeof(new_port), "%.*s", (int)(host_len - name_len - 1), port + 1);
+    } else {
+        strcpy(new_port, tls ? "443" : "80");
+    }
+    // a connection to another server cannot be reused
+    if (strcmp(new_host, client->host) != 0 || strcmp(new_port, client->port) != 0 || tls != client->tls) {
+        connection_close(client);
+    }
+    strcpy(client->host, new_host);
+    strcpy(client->port, new_port);
+    strcpy(client->path, (path != NULL) ? path : "/");
+    client->tls = tls;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method) {
+    client->method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len) {
+    client->post_data = data;
+    client->post_len = len;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value) {
+    size_t i = 0;
+    while (i < client->header_count && strcasecmp(client->headers[i].key, key) != 0) {
+        ++i;
+    }
+    if (i == HTTP_HEADERS || strlen(key) >= HTTP_HEADER_KEY_SIZE || strlen(value) >= HTTP_HEADER_VALUE_SIZE) {
+        return ESP_ERR_NO_MEM;
+    }
+    strcpy(client->headers[i].key, key);
+    strcpy(client->headers[i].value, value);
+    if (i == client->header_count) {
+        client->header_count++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key) {
+    for (size_t i = 0; i < client->header_count; ++i) {
+        if (strcasecmp(client->headers[i].key, key) == 0) {
+            client->headers[i] = client->headers[--client->header_count];
+            return ESP_OK;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client) {
+    if (client->tls) {
+        ESP_LOGE(TAG, "https is not supported by the host build");
+        return ESP_ERR_HTTP_INVALID_TRANSPORT;
+    }
+    client->status_code = -1;
+    if (client->fd < 0) {
+        esp_err_t err = connection_open(client);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    bool close_after = false;
+    esp_err_t err = request_send(client);
+    if (err == ESP_OK) {
+        err = response_receive(client, &close_after);
+    }
+    if (err != ESP_OK) {
+        event_dispatch(client, HTTP_EVENT_ERROR, NULL, 0);
+        connection_close(client);
+        return err;
+    }
+    event_dispatch(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+    if (close_after || !client->keep_alive) {
+        connection_close(client);
+    }
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client) {
+    return client->status_code;
+}
+
+int esp_http_client_get_content_length(esp_http_client_handle_t client) {
+    return client->content_length;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client) {
+    connection_close(client);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client) {
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+    connection_close(client);
+    free(client);
+    return ESP_OK;
+}
@@ -0,0 +1,288 @@
+/*!
+ * @file esp_partition.c
+ * @brief Partitions of ESP-IDF on files of the host.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <esp_log.h>
+#include <esp_partition.h>
+
+#include "host_platform.h"
+
+static const char *TAG = "partition";
+
+#define PARTITION_TABLE_SIZE 16
+#define PARTITION_FIRST_OFFSET 0x9000
+#define PARTITION_APP_ALIGN 0x10000
+
+// NVS pages have 126 entries of 32 bytes, a blob has an index and a data header entry
+#define NVS_PAGE_ENTRIES 126
+#define NVS_ENTRY_SIZE 32
+#define NVS_BLOB_OVERHEAD_ENTRIES 2
+
+typedef struct {
+    esp_partition_t partition;
+    uint8_t *flash;             //!< mapped file of the partition
+    uint64_t bytes_written;
+    uint64_t sector_erases;
+} host_partition_t;
+
+static host_partition_t table[PARTITION_TABLE_SIZE];
+static size_t table_size = 0;
+static pthread_once_t table_once = PTHREAD_ONCE_INIT;
+static uint64_t nvs_bytes = 0;
+static uint64_t nvs_entries = 0;
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) {
+        ++s;
+    }
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+    return s;
+}
+
+static uint32_t parse_size(const char *s) {
+    char *end = NULL;
+    uint32_t value = (uint32_t)strtoul(s, &end, 0);
+    if (end != NULL && (*end == 'K' || *end == 'k')) {
+        value *= 1024;
+    } else if (end != NULL && (*end == 'M' || *end == 'm')) {
+        value *= 1024 * 1024;
+    }
+    return value;
+}
+
+static int parse_subtype(esp_partition_type_t type, const char *s) {
+    static const struct {
+        esp_partition_type_t type;
+        const char *name;
+        esp_partition_subtype_t subtype;
+    } names[] = {
+            { ESP_PARTITION_TYPE_APP, "factory", ESP_PARTITION_SUBTYPE_APP_FACTORY },
+            { ESP_PARTITION_TYPE_APP, "ota_0", ESP_PARTITION_SUBTYPE_APP_OTA_0 },
+            { ESP_PARTITION_TYPE_APP, "ota_1", ESP_PARTITION_SUBTYPE_APP_OTA_1 },
+            { ESP_PARTITION_TYPE_DATA, "ota", ESP_PARTITION_SUBTYPE_DATA_OTA },
+            { ESP_PARTITION_TYPE_DATA, "phy", ESP_PARTITION_SUBTYPE_DATA_PHY },
+            { ESP_PARTITION_TYPE_DATA, "nvs", ESP_PARTITION_SUBTYPE_DATA_NVS },
+            { ESP_PARTITION_TYPE_DATA, "coredump", ESP_PARTITION_SUBTYPE_DATA_COREDUMP },
+            { ESP_PARTITION_TYPE_DATA, "nvs_keys", ESP_PARTITION_SUBTYPE_DATA_NVS_KEYS },
+            { ESP_PARTITION_TYPE_DATA, "fat", ESP_PARTITION_SUBTYPE_DATA_FAT },
+            { ESP_PARTITION_TYPE_DATA, "spiffs", ESP_PARTITION_SUBTYPE_DATA_SPIFFS },
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        if (names[i].type == type && strcasecmp(names[i].name, s) == 0) {
+            return names[i].subtype;
+        }
+    }
+    return (int)strtol(s, NULL, 0);
+}
+
+/*!
+ * Map the file of \p partition, a new file is erased.
+ */
+static esp_err_t partition_map(host_partition_t *entry) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.bin", host_platform_config.flash_dir, entry->partition.label);
+    mkdir(host_platform_config.flash_dir, 0755);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "failed to open %s: %s", path, strerror(errno));
+        return ESP_FAIL;
+    }
+    struct stat st;
+    bool erase = host_platform_config.flash_erase
+            || fstat(fd, &st) != 0 || (size_t)st.st_size != entry->partition.size;
+    if (erase && ftruncate(fd, entry->partition.size) != 0) {
+        close(fd);
+        return ESP_FAIL;
+    }
+    entry->flash = mmap(NULL, entry->partition.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (entry->flash == MAP_FAILED) {
+        entry->flash = NULL;
+        return ESP_FAIL;
+    }
+    if (erase) {
+        memset(entry->flash, 0xff, entry->partition.size);
+    }
+    return ESP_OK;
+}
+
+/*!
+ * Read the partition table, the offsets are calculated like by the partition tool.
+ */
+static void table_load(void) {
+    FILE *file = fopen(HOST_PARTITION_TABLE, "r");
+    if (file == NULL) {
+        ESP_LOGE(TAG, "failed to open partition table %s", HOST_PARTITION_TABLE);
+        return;
+    }
+    uint32_t offset = PARTITION_FIRST_OFFSET;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL && table_size < PARTITION_TABLE_SIZE) {
+        char *content = trim(line);
+        if (*content == '#' || *content == '\0') {
+            continue;
+        }
+        char *fields[6] = { 0 };
+        size_t count = 0;
+        char *save = NULL;
+        for (char *field = strtok_r(content, ",", &save); field != NULL && count < 6;
+                field = strtok_r(NULL, ",", &save)) {
+            fields[count++] = trim(field);
+        }
+        if (count < 5) {
+            continue;
+        }
+        host_partition_t *entry = &table[table_size];
+        strncpy(entry->partition.label, fields[0], sizeof(entry->partition.label) - 1);
+        entry->partition.type = (strcasecmp(fields[1], "app") == 0) ? ESP_PARTITION_TYPE_APP
+                : (strcasecmp(fields[1], "data") == 0) ? ESP_PARTITION_TYPE_DATA
+                : (esp_partition_type_t)strtol(fields[1], NULL, 0);
+        entry->partition.subtype = (esp_partition_subtype_t)parse_subtype(entry->partition.type, fields[2]);
+        // without an offset, the partition follows the previous one
+        if (*fields[3] != '\0') {
+            offset = parse_size(fields[3]);
+        }
+        entry->partition.size = parse_size(fields[4]);
+        if (entry->partition.type == ESP_PARTITION_TYPE_APP) {
+            offset = (offset + PARTITION_APP_ALIGN - 1) & ~(uint32_t)(PARTITION_APP_ALIGN - 1);
+        }
+        entry->partition.address = offset;
+        offset += entry->partition.size;
+        table_size++;
+    }
+    fclose(file);
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+        const char *label) {
+    pthread_once(&table_once, table_load);
+    for (size_t i = 0; i < table_size; ++i) {
+        host_partition_t *entry = &table[i];
+        if ((type != ESP_PARTITION_TYPE_ANY && entry->partition.type != type)
+                || (subtype != ESP_PARTITION_SUBTYPE_ANY && entry->partition.subtype != subtype)
+                || (label != NULL && strcmp(entry->partition.label, label) != 0)) {
+            continue;
+        }
+        // the file is only mapped for partitions, which are used
+        if (entry->flash == NULL && partition_map(entry) != ESP_OK) {
+            return NULL;
+        }
+        return &entry->partition;
+    }
+    return NULL;
+}
+
+static host_partition_t *entry_of(const esp_partition_t *partition, size_t offset, size_t size) {
+    host_partition_t *entry = (host_partition_t *)partition;
+    if (entry < table || entry >= table + table_size || entry->flash == NULL
+            || offset > partition->size || size > partition->size - offset) {
+        return NULL;
+    }
+    return entry;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+    host_partition_t *entry = entry_of(partition, src_offset, size);
+    if (entry == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, entry->flash + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+    host_partition_t *entry = entry_of(partition, dst_offset, size);
+    if (entry == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // like the NOR flash, a write can only clear bits
+    const uint8_t *bytes = src;
+    for (size_t i = 0; i < size; ++i) {
+        entry->flash[dst_offset + i] &= bytes[i];
+    }
+    __atomic_fetch_add(&entry->bytes_written, size, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    host_partition_t *entry = entry_of(partition, offset, size);
+    if (entry == NULL || offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(entry->flash + offset, 0xff, size);
+    __atomic_fetch_add(&entry->sector_erases, size / SPI_FLASH_SEC_SIZE, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+void host_flash_nvs_write(size_t len) {
+    __atomic_fetch_add(&nvs_bytes, len, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&nvs_entries, NVS_BLOB_OVERHEAD_ENTRIES + (len + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE,
+            __ATOMIC_RELAXED);
+}
+
+FILE *host_flash_log_open(const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", host_platform_config.flash_dir, name);
+    mkdir(host_platform_config.flash_dir, 0755);
+    FILE *log = fopen(path, host_platform_config.flash_erase ? "w+b" : "a+b");
+    if (log == NULL) {
+        ESP_LOGE(TAG, "failed to open %s: %s", path, strerror(errno));
+        return NULL;
+    }
+    rewind(log);
+    return log;
+}
+
+void host_flash_stats_get(const char *label, host_flash_stats_t *stats) {
+    memset(stats, 0, sizeof(host_flash_stats_t));
+    pthread_once(&table_once, table_load);
+    for (size_t i = 0; i < table_size; ++i) {
+        host_partition_t *entry = &table[i];
+        if (strcmp(entry->partition.label, label) != 0) {
+            continue;
+        }
+        stats->sectors = entry->partition.size / SPI_FLASH_SEC_SIZE;
+        if (entry->partition.type == ESP_PARTITION_TYPE_DATA
+                && entry->partition.subtype == ESP_PARTITION_SUBTYPE_DATA_NVS) {
+            stats->bytes_written = __atomic_load_n(&nvs_bytes, __ATOMIC_RELAXED);
+            stats->sector_erases = __atomic_load_n(&nvs_entries, __ATOMIC_RELAXED) / NVS_PAGE_ENTRIES;
+        } else {
+            stats->bytes_written = __atomic_load_n(&entry->bytes_written, __ATOMIC_RELAXED);
+            stats->sector_erases = __atomic_load_n(&entry->sector_erases, __ATOMIC_RELAXED);
+        }
+        return;
+    }
+}
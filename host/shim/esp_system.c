@@ -0,0 +1,407 @@
+/*!
+ * @file esp_system.c
+ * @brief System functions of ESP-IDF on POSIX.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#define _GNU_SOURCE
+#include <malloc.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/random.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <esp_err.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mbedtls/base64.h>
+#include <nvs_flash.h>
+
+#include "host_platform.h"
+
+host_platform_config_t host_platform_config = {
+        .flash_dir = "flash",
+        .flash_erase = false,
+        .nvs_latency_us = 0,
+        .keys_expired = false,
+};
+
+static struct timespec start_time;
+
+__attribute__((constructor))
+static void timer_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+int64_t esp_timer_get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - start_time.tv_sec) * 1000000 + (now.tv_nsec - start_time.tv_nsec) / 1000;
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_NO_FREE_PAGES: return "ESP_ERR_NVS_NO_FREE_PAGES";
+        case 0x7002: return "ESP_ERR_HTTP_CONNECT";
+        case 0x7003: return "ESP_ERR_HTTP_WRITE_DATA";
+        case 0x7004: return "ESP_ERR_HTTP_FETCH_HEADER";
+        case 0x7005: return "ESP_ERR_HTTP_INVALID_TRANSPORT";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+// per tag log levels, the tags are compared by content
+#define LOG_TAGS 32
+
+static struct {
+    char tag[32];
+    esp_log_level_t level;
+} log_tags[LOG_TAGS];
+static size_t log_tag_count = 0;
+static esp_log_level_t log_default_level = CONFIG_LOG_DEFAULT_LEVEL;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    pthread_mutex_lock(&log_lock);
+    if (strcmp(tag, "*") == 0) {
+        log_default_level = level;
+        log_tag_count = 0;
+    } else {
+        size_t i = 0;
+        while (i < log_tag_count && strcmp(log_tags[i].tag, tag) != 0) {
+            ++i;
+        }
+        if (i < LOG_TAGS) {
+            if (i == log_tag_count) {
+                // not strdup(), its allocation would bypass the heap counters
+                strncpy(log_tags[i].tag, tag, sizeof(log_tags[i].tag) - 1);
+                log_tag_count++;
+            }
+            log_tags[i].level = level;
+        }
+    }
+    pthread_mutex_unlock(&log_lock);
+}
+
+esp_log_level_t esp_log_level_get(const char *tag) {
+    esp_log_level_t level = log_default_level;
+    if (log_tag_count == 0) {
+        return level;
+    }
+    pthread_mutex_lock(&log_lock);
+    for (size_t i = 0; i < log_tag_count; ++i) {
+        if (strcmp(log_tags[i].tag, tag) == 0) {
+            level = log_tags[i].level;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&log_lock);
+    return level;
+}
+
+uint32_t esp_log_timestamp(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    static const char letters[] = "NEWIDV";
+    char line[512];
+    int len = snprintf(line, sizeof(line), "%c (%u) [%s] %s: ", letters[level],
+            esp_log_timestamp(), pcTaskGetName(NULL), tag);
+    va_list args;
+    va_start(args, format);
+    if (len >= 0 && (size_t)len < sizeof(line)) {
+        vsnprintf(line + len, sizeof(line) - (size_t)len, format, args);
+    }
+    va_end(args);
+    // one write per line, so the lines of the tasks do not mix
+    fprintf(stderr, "%s\n", line);
+}
+
+void esp_log_buffer_hexdump_internal(const char *tag, const void *buffer, size_t length, esp_log_level_t level) {
+    const uint8_t *bytes = buffer;
+    for (size_t offset = 0; offset < length; offset += 16) {
+        char line[16 * 3 + 1] = { 0 };
+        for (size_t i = 0; i < 16 && offset + i < length; ++i) {
+            sprintf(line + i * 3, "%02x ", bytes[offset + i]);
+        }
+        esp_log_write(level, tag, "%p: %s", (const void *)(bytes + offset), line);
+    }
+}
+
+uint32_t esp_random(void) {
+    uint32_t value;
+    esp_fill_random(&value, sizeof(value));
+    return value;
+}
+
+void esp_fill_random(void *buffer, size_t length) {
+    uint8_t *bytes = buffer;
+    while (length > 0) {
+        ssize_t n = getrandom(bytes, length, 0);
+        if (n > 0) {
+            bytes += n;
+            length -= (size_t)n;
+        }
+    }
+}
+
+/*!
+ * Random source of the NaCl component, if it does not bring its own.
+ */
+__attribute__((weak))
+void randombytes(unsigned char *buffer, unsigned long long length) {
+    esp_fill_random(buffer, (size_t)length);
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac) {
+    char hostname[64] = "host";
+    gethostname(hostname, sizeof(hostname) - 1);
+    // FNV-1a of the hostname, with the locally administered bit set
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char *c = hostname; *c != '\0'; ++c) {
+        hash = (hash ^ (uint8_t)*c) * 0x100000001b3ULL;
+    }
+    for (int i = 0; i < 6; ++i) {
+        mac[i] = (uint8_t)(hash >> (8 * i));
+    }
+    mac[0] = (uint8_t)((mac[0] & 0xfe) | 0x02);
+    return ESP_OK;
+}
+
+esp_err_t esp_base_mac_addr_set(const uint8_t *mac) {
+    (void)mac;
+    return ESP_OK;
+}
+
+#define SHUTDOWN_HANDLERS_MAX 5
+
+static shutdown_handler_t shutdown_handlers[SHUTDOWN_HANDLERS_MAX];
+static size_t shutdown_handler_count = 0;
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle) {
+    if (shutdown_handler_count >= SHUTDOWN_HANDLERS_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    shutdown_handlers[shutdown_handler_count++] = handle;
+    return ESP_OK;
+}
+
+void esp_restart(void) {
+    ESP_LOGW("system", "restart requested, exit");
+    while (shutdown_handler_count > 0) {
+        shutdown_handlers[--shutdown_handler_count]();
+    }
+    exit(EXIT_FAILURE);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    crc = ~crc;
+    while (len-- > 0) {
+        crc ^= *buf++;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xedb88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+// malloc() and friends are wrapped by the linker (--wrap), to count the heap usage
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static atomic_size_t heap_allocated = 0;
+static atomic_size_t heap_peak = 0;
+static atomic_size_t heap_blocks = 0;
+static atomic_uint_least64_t heap_allocations = 0;
+
+static void heap_count_alloc(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    size_t allocated = atomic_fetch_add(&heap_allocated, malloc_usable_size(ptr)) + malloc_usable_size(ptr);
+    atomic_fetch_add(&heap_blocks, 1);
+    atomic_fetch_add(&heap_allocations, 1);
+    size_t peak = atomic_load(&heap_peak);
+    while (allocated > peak && !atomic_compare_exchange_weak(&heap_peak, &peak, allocated)) {
+    }
+}
+
+static void heap_count_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    atomic_fetch_sub(&heap_allocated, malloc_usable_size(ptr));
+    atomic_fetch_sub(&heap_blocks, 1);
+}
+
+void *__wrap_malloc(size_t size) {
+    void *ptr = __real_malloc(size);
+    heap_count_alloc(ptr);
+    return ptr;
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    void *ptr = __real_calloc(count, size);
+    heap_count_alloc(ptr);
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    heap_count_free(ptr);
+    void *moved = __real_realloc(ptr, size);
+    // on failure the old block is still allocated
+    heap_count_alloc(moved != NULL || size == 0 ? moved : ptr);
+    return moved;
+}
+
+void __wrap_free(void *ptr) {
+    heap_count_free(ptr);
+    __real_free(ptr);
+}
+
+void host_heap_stats_get(host_heap_stats_t *stats) {
+    stats->allocated_bytes = atomic_load(&heap_allocated);
+    stats->peak_bytes = atomic_load(&heap_peak);
+    stats->allocated_blocks = atomic_load(&heap_blocks);
+    stats->allocations = atomic_load(&heap_allocations);
+}
+
+static size_t heap_free(size_t allocated) {
+    return (allocated < HOST_HEAP_SIZE) ? HOST_HEAP_SIZE - allocated : 0;
+}
+
+size_t heap_caps_get_total_size(uint32_t caps) {
+    (void)caps;
+    return HOST_HEAP_SIZE;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    (void)caps;
+    return heap_free(atomic_load(&heap_allocated));
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    (void)caps;
+    return heap_free(atomic_load(&heap_peak));
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps) {
+    memset(info, 0, sizeof(multi_heap_info_t));
+    info->total_allocated_bytes = atomic_load(&heap_allocated);
+    info->total_free_bytes = heap_caps_get_free_size(caps);
+    info->largest_free_block = info->total_free_bytes;
+    info->minimum_free_bytes = heap_caps_get_minimum_free_size(caps);
+    info->allocated_blocks = atomic_load(&heap_blocks);
+    info->total_blocks = info->allocated_blocks;
+}
+
+uint32_t esp_get_free_heap_size(void) {
+    return (uint32_t)heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+    return (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+}
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    return ESP_OK;
+}
+
+static const char base64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen) {
+    size_t needed = ((slen + 2) / 3) * 4;
+    *olen = needed + 1;
+    if (dst == NULL || dlen < needed + 1) {
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    size_t o = 0;
+    for (size_t i = 0; i < slen; i += 3) {
+        uint32_t block = (uint32_t)src[i] << 16;
+        if (i + 1 < slen) block |= (uint32_t)src[i + 1] << 8;
+        if (i + 2 < slen) block |= src[i + 2];
+        dst[o++] = (unsigned char)base64_alphabet[(block >> 18) & 0x3f];
+        dst[o++] = (unsigned char)base64_alphabet[(block >> 12) & 0x3f];
+        dst[o++] = (unsigned char)((i + 1 < slen) ? base64_alphabet[(block >> 6) & 0x3f] : '=');
+        dst[o++] = (unsigned char)((i + 2 < slen) ? base64_alphabet[block & 0x3f] : '=');
+    }
+    dst[o] = '\0';
+    *olen = o;
+    return 0;
+}
+
+int mbedtls_base64_decode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen) {
+    uint32_t block = 0;
+    size_t bits = 0;
+    size_t o = 0;
+    for (size_t i = 0; i < slen; ++i) {
+        if (src[i] == '=' || src[i] == '\n' || src[i] == '\r') {
+            continue;
+        }
+        const char *c = (src[i] != '\0') ? strchr(base64_alphabet, src[i]) : NULL;
+        if (c == NULL) {
+            return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+        }
+        block = (block << 6) | (uint32_t)(c - base64_alphabet);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (dst != NULL && o < dlen) {
+                dst[o] = (unsigned char)(block >> bits);
+            }
+            o++;
+        }
+    }
+    *olen = o;
+    return (dst == NULL || o > dlen) ? MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL : 0;
+}
@@ -0,0 +1,590 @@
+/*!
+ * @file freertos.c
+ * @brief FreeRTOS tasks, queues and event groups on POSIX threads.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <esp_log.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+static const char *TAG = "freertos";
+
+#define HOST_TASK_STACK_SIZE (1024 * 1024)
+#define HOST_TASK_NAME_SIZE 16
+#define HOST_STACK_FILL 0xa5            // like tskSTACK_FILL_BYTE of FreeRTOS
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t function;
+    void *parameters;
+    char name[HOST_TASK_NAME_SIZE];
+    BaseType_t core;
+    pthread_mutex_t lock;
+    pthread_cond_t notified;
+    uint32_t notify_value;
+    uint8_t *stack;                     //!< the stack of the host, NULL if it is not watched
+    uint8_t *volatile stack_top;        //!< where the task function starts, below the TLS of the thread
+    uint32_t stack_depth;               //!< the stack size of the device
+    void *device_stack;                 //!< the stack of the device on the heap, NULL if static
+    bool is_static;
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t *items;
+    UBaseType_t item_size;
+    UBaseType_t length;
+    UBaseType_t count;
+    UBaseType_t head;
+    bool is_static;
+};
+
+struct host_event_group {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    EventBits_t bits;
+};
+
+static __thread struct host_task *current_task = NULL;
+static struct timespec boot_time;
+
+__attribute__((constructor))
+static void boot(void) {
+    clock_gettime(CLOCK_MONOTONIC, &boot_time);
+}
+
+/*!
+ * Initialize a condition, which waits with the monotonic clock.
+ */
+static void cond_init(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void deadline_get(TickType_t ticks, struct timespec *deadline) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    uint64_t ms = pdTICKS_TO_MS(ticks);
+    deadline->tv_sec += (time_t)(ms / 1000);
+    deadline->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/*!
+ * Wait on \p cond, until it is signaled or the deadline is over.
+ *
+ * @return false if the deadline is over
+ */
+static bool cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks,
+        const struct timespec *deadline) {
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+_Static_assert(sizeof(struct host_task) <= sizeof(StaticTask_t), "StaticTask_t too small");
+_Static_assert(sizeof(struct host_queue) <= sizeof(StaticQueue_t), "StaticQueue_t too small");
+
+/*!
+ * Create a task object, in \p buffer, or on the heap, if it is NULL.
+ */
+static struct host_task *task_new(const char *name, BaseType_t core, StaticTask_t *buffer) {
+    struct host_task *task = (struct host_task *)buffer;
+    if (task != NULL) {
+        memset(task, 0, sizeof(struct host_task));
+        task->is_static = true;
+    } else if ((task = calloc(1, sizeof(struct host_task))) == NULL) {
+        return NULL;
+    }
+    strncpy(task->name, name, HOST_TASK_NAME_SIZE - 1);
+    task->core = core;
+    pthread_mutex_init(&task->lock, NULL);
+    cond_init(&task->notified);
+    return task;
+}
+
+static struct host_task *task_current(void) {
+    if (current_task == NULL) {
+        // a thread, which was not started by xTaskCreate(), e.g. main()
+        current_task = task_new("host", tskNO_AFFINITY, NULL);
+        if (current_task != NULL) {
+            current_task->thread = pthread_self();
+        }
+    }
+    return current_task;
+}
+
+static void *task_run(void *arg) {
+    struct host_task *task = arg;
+    uint8_t top;
+    task->stack_top = &top;
+    current_task = task;
+    pthread_setname_np(pthread_self(), task->name);
+    task->function(task->parameters);
+    ESP_LOGE(TAG, "task \"%s\" returned", task->name);
+    return NULL;
+}
+
+static void task_free(struct host_task *task) {
+    if (task->stack != NULL) {
+        munmap(task->stack, HOST_TASK_STACK_SIZE);
+    }
+    free(task->device_stack);
+    if (!task->is_static) {
+        free(task);
+    }
+}
+
+/*!
+ * Run \p task in a thread, on a stack, which is filled with a pattern to find its high-water mark.
+ */
+static BaseType_t task_start(struct host_task *task, TaskFunction_t function, void *parameters,
+        uint32_t stack_depth, BaseType_t core) {
+    task->function = function;
+    task->parameters = parameters;
+    task->stack_depth = stack_depth;
+    task->stack = mmap(NULL, HOST_TASK_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (task->stack == MAP_FAILED) {
+        task->stack = NULL;
+        return pdFAIL;
+    }
+    memset(task->stack, HOST_STACK_FILL, HOST_TASK_STACK_SIZE);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stack, HOST_TASK_STACK_SIZE);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (core != tskNO_AFFINITY && cpus >= portNUM_PROCESSORS) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+    int err = pthread_create(&task->thread, &attr, task_run, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        ESP_LOGE(TAG, "failed to start task \"%s\": %s", task->name, strerror(err));
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth,
+        void *parameters, UBaseType_t priority, TaskHandle_t *created, BaseType_t core) {
+    (void)priority;
+    struct host_task *task = task_new(name, core, NULL);
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->device_stack = malloc(stack_depth);
+    if (task->device_stack == NULL) {
+        task_free(task);
+        return pdFAIL;
+    }
+    // the handle has to be valid before the task runs
+    if (created != NULL) {
+        *created = task;
+    }
+    if (task_start(task, function, parameters, stack_depth, core) != pdPASS) {
+        if (created != NULL) {
+            *created = NULL;
+        }
+        task_free(task);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth,
+        void *parameters, UBaseType_t priority, StackType_t *stack, StaticTask_t *buffer, BaseType_t core) {
+    (void)priority;
+    if (stack == NULL || buffer == NULL) {
+        return NULL;
+    }
+    struct host_task *task = task_new(name, core, buffer);
+    if (task_start(task, function, parameters, stack_depth, core) != pdPASS) {
+        task_free(task);
+        return NULL;
+    }
+    return task;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != NULL && task != task_current()) {
+        ESP_LOGE(TAG, "only the task itself can delete a task");
+        return;
+    }
+    // the handle stays valid, other tasks may still use it
+    pthread_exit(NULL);
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+    if (task != NULL && task != task_current()) {
+        ESP_LOGE(TAG, "only the task itself can suspend a task");
+        return;
+    }
+    for (;;) {
+        pause();
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    uint64_t ms = pdTICKS_TO_MS(ticks);
+    struct timespec delay = { .tv_sec = (time_t)(ms / 1000), .tv_nsec = (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+    TickType_t wake = *previous_wake + increment;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(wake - now) > 0) {
+        vTaskDelay(wake - now);
+    }
+    *previous_wake = wake;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t ms = (int64_t)(now.tv_sec - boot_time.tv_sec) * 1000
+            + (now.tv_nsec - boot_time.tv_nsec) / 1000000L;
+    return pdMS_TO_TICKS(ms);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return task_current();
+}
+
+char *pcTaskGetName(TaskHandle_t task) {
+    if (task == NULL) {
+        task = task_current();
+    }
+    return (task != NULL) ? task->name : "";
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    if (task == NULL) {
+        task = task_current();
+    }
+    if (task == NULL || task->stack == NULL) {
+        return 0;
+    }
+    if (task->stack_top == NULL) {
+        // not running yet
+        return task->stack_depth;
+    }
+    // the stack grows down, the pattern is left at its lowest addresses
+    size_t untouched = 0;
+    while (untouched < HOST_TASK_STACK_SIZE && task->stack[untouched] == HOST_STACK_FILL) {
+        untouched++;
+    }
+    size_t used = (size_t)(task->stack_top - (task->stack + untouched));
+    return (used < task->stack_depth) ? (UBaseType_t)(task->stack_depth - used) : 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->lock);
+    task->notify_value++;
+    pthread_cond_signal(&task->notified);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    struct host_task *task = task_current();
+    struct timespec deadline;
+    deadline_get(ticks, &deadline);
+    pthread_mutex_lock(&task->lock);
+    while (task->notify_value == 0) {
+        if (!cond_wait(&task->notified, &task->lock, ticks, &deadline)) {
+            break;
+        }
+    }
+    uint32_t value = task->notify_value;
+    if (value > 0) {
+        task->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+BaseType_t xPortGetCoreID(void) {
+    struct host_task *task = task_current();
+    return (task == NULL || task->core == tskNO_AFFINITY) ? 0 : task->core;
+}
+
+static void queue_init(struct host_queue *queue, UBaseType_t length, UBaseType_t item_size) {
+    queue->item_size = item_size;
+    queue->length = length;
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init(&queue->not_empty);
+    cond_init(&queue->not_full);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    if (length == 0) {
+        return NULL;
+    }
+    struct host_queue *queue = calloc(1, sizeof(struct host_queue));
+    if (queue == NULL) {
+        return NULL;
+    }
+    if (item_size > 0) {
+        queue->items = malloc((size_t)length * item_size);
+        if (queue->items == NULL) {
+            free(queue);
+            return NULL;
+        }
+    }
+    queue_init(queue, length, item_size);
+    return queue;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buffer) {
+    if (length == 0 || buffer == NULL || (item_size > 0 && storage == NULL)) {
+        return NULL;
+    }
+    struct host_queue *queue = (struct host_queue *)buffer;
+    memset(queue, 0, sizeof(struct host_queue));
+    queue->items = (item_size > 0) ? storage : NULL;
+    queue->is_static = true;
+    queue_init(queue, length, item_size);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    if (queue == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    if (!queue->is_static) {
+        free(queue->items);
+        free(queue);
+    }
+}
+
+static BaseType_t queue_send(QueueHandle_t queue, const void *item, TickType_t ticks, bool front) {
+    if (queue == NULL) {
+        return errQUEUE_FULL;
+    }
+    struct timespec deadline;
+    deadline_get(ticks, &deadline);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (!cond_wait(&queue->not_full, &queue->lock, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return errQUEUE_FULL;
+        }
+    }
+    UBaseType_t index;
+    if (front) {
+        queue->head = (queue->head + queue->length - 1) % queue->length;
+        index = queue->head;
+    } else {
+        index = (queue->head + queue->count) % queue->length;
+    }
+    // the semaphores are queues without items
+    if (queue->item_size > 0 && item != NULL) {
+        memcpy(queue->items + (size_t)index * queue->item_size, item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+static BaseType_t queue_receive(QueueHandle_t queue, void *item, TickType_t ticks, bool peek) {
+    if (queue == NULL) {
+        return errQUEUE_EMPTY;
+    }
+    struct timespec deadline;
+    deadline_get(ticks, &deadline);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!cond_wait(&queue->not_empty, &queue->lock, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return errQUEUE_EMPTY;
+        }
+    }
+    if (queue->item_size > 0 && item != NULL) {
+        memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+    }
+    if (!peek) {
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_send(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_receive(queue, item, ticks, true);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return spaces;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    // a mutex is a semaphore, which is given at the start
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+    if (mutex != NULL) {
+        xSemaphoreGive(mutex);
+    }
+    return mutex;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer) {
+    SemaphoreHandle_t mutex = xQueueCreateStatic(1, 0, NULL, buffer);
+    if (mutex != NULL) {
+        xSemaphoreGive(mutex);
+    }
+    return mutex;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    SemaphoreHandle_t semaphore = xQueueCreate(max_count, 0);
+    for (UBaseType_t i = 0; semaphore != NULL && i < initial_count; ++i) {
+        xSemaphoreGive(semaphore);
+    }
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t max_count, UBaseType_t initial_count,
+        StaticSemaphore_t *buffer) {
+    SemaphoreHandle_t semaphore = xQueueCreateStatic(max_count, 0, NULL, buffer);
+    for (UBaseType_t i = 0; semaphore != NULL && i < initial_count; ++i) {
+        xSemaphoreGive(semaphore);
+    }
+    return semaphore;
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    struct host_event_group *group = calloc(1, sizeof(struct host_event_group));
+    if (group == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&group->lock, NULL);
+    cond_init(&group->changed);
+    return group;
+}
+
+static bool bits_match(EventBits_t value, EventBits_t bits, BaseType_t wait_for_all) {
+    return wait_for_all ? (value & bits) == bits : (value & bits) != 0;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+        BaseType_t wait_for_all, TickType_t ticks) {
+    struct timespec deadline;
+    deadline_get(ticks, &deadline);
+    pthread_mutex_lock(&group->lock);
+    while (!bits_match(group->bits, bits, wait_for_all)) {
+        if (!cond_wait(&group->changed, &group->lock, ticks, &deadline)) {
+            break;
+        }
+    }
+    // like FreeRTOS, the bits before clearing are returned
+    EventBits_t value = group->bits;
+    if (clear_on_exit && bits_match(value, bits, wait_for_all)) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t value = group->bits;
+    pthread_cond_broadcast(&group->changed);
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t value = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t value = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
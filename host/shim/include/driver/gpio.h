@@ -0,0 +1,32 @@
+/*!
+ * @file gpio.h
+ * @brief GPIO driver of ESP-IDF for the host build, the host has no pins.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+#include "esp_err.h"
+
+typedef enum {
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_2 = 2,
+} gpio_num_t;
+
+#endif /* HOST_DRIVER_GPIO_H */
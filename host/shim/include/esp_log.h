@@ -0,0 +1,77 @@
+/*!
+ * @file esp_log.h
+ * @brief Logging of ESP-IDF for the host build.
+ *
+ * The log is written to stderr, so it does not mix with the report of the
+ * load generator. Like on the target, the format arguments are only
+ * evaluated if the level of the tag is enabled.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL CONFIG_LOG_DEFAULT_LEVEL
+#endif
+
+/*!
+ * Set the level of \p tag, "*" sets the level of all tags.
+ */
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+esp_log_level_t esp_log_level_get(const char *tag);
+uint32_t esp_log_timestamp(void);
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+        __attribute__((format(printf, 3, 4)));
+void esp_log_buffer_hexdump_internal(const char *tag, const void *buffer, size_t length,
+        esp_log_level_t level);
+
+#define ESP_LOG_LEVEL_LOCAL(level, tag, format, ...) do {                   \
+        if (LOG_LOCAL_LEVEL >= (level) && esp_log_level_get(tag) >= (level)) { \
+            esp_log_write((level), (tag), format, ##__VA_ARGS__);           \
+        }                                                                   \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#define ESP_LOG_BUFFER_HEXDUMP(tag, buffer, length, level) do {             \
+        if (LOG_LOCAL_LEVEL >= (level) && esp_log_level_get(tag) >= (level)) { \
+            esp_log_buffer_hexdump_internal((tag), (buffer), (length), (level)); \
+        }                                                                   \
+    } while (0)
+
+#define ESP_LOG_BUFFER_HEX(tag, buffer, length) ESP_LOG_BUFFER_HEXDUMP(tag, buffer, length, ESP_LOG_INFO)
+
+#endif /* HOST_ESP_LOG_H */
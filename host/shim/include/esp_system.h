@@ -0,0 +1,54 @@
+/*!
+ * @file esp_system.h
+ * @brief System functions of ESP-IDF for the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/*!
+ * The MAC address of the host is derived from the hostname, so the
+ * gateway UUID stays the same between the runs.
+ */
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac);
+esp_err_t esp_base_mac_addr_set(const uint8_t *mac);
+
+uint32_t esp_random(void);
+void esp_fill_random(void *buffer, size_t length);
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+
+typedef void (*shutdown_handler_t)(void);
+
+/*!
+ * The handlers are called by esp_restart(), in the reverse order of their registration.
+ */
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle);
+
+/*!
+ * There is nothing to restart on the host, the process exits.
+ */
+void esp_restart(void) __attribute__((noreturn));
+
+#endif /* HOST_ESP_SYSTEM_H */
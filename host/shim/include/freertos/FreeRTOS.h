@@ -0,0 +1,75 @@
+/*!
+ * @file FreeRTOS.h
+ * @brief FreeRTOS types of the host build.
+ *
+ * The host build runs the FreeRTOS tasks as POSIX threads, see freertos.c.
+ * One tick is one millisecond. Priorities are ignored, the Linux scheduler
+ * decides, and tasks pinned to a core are pinned to the same CPU of the
+ * host, if it has enough CPUs.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+typedef struct host_task *TaskHandle_t;
+typedef struct host_queue *QueueHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+/*!
+ * Memory of a statically created task or queue, which holds the object of the shim.
+ */
+typedef struct {
+    void *host[32];
+} StaticTask_t;
+
+typedef struct {
+    void *host[32];
+} StaticQueue_t;
+
+typedef StaticQueue_t StaticSemaphore_t;
+
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define portNUM_PROCESSORS 2
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks) ((uint32_t)(((uint64_t)(ticks) * 1000) / configTICK_RATE_HZ))
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_EMPTY pdFALSE
+#define errQUEUE_FULL pdFALSE
+
+#define tskIDLE_PRIORITY 0
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+#endif /* HOST_FREERTOS_H */
@@ -0,0 +1,82 @@
+/*!
+ * @file task.h
+ * @brief FreeRTOS tasks of the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+/*!
+ * Start a task in its own thread. The threads get the stack size of the
+ * host, as the host code needs more stack. A block of the stack depth (in
+ * bytes, like on the ESP32) is allocated, so the heap is used like on the
+ * device.
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth,
+        void *parameters, UBaseType_t priority, TaskHandle_t *created, BaseType_t core);
+
+/*!
+ * Start a task in its own thread, without the heap. The stack buffer is not
+ * used, the thread runs on a stack of the host, like above.
+ */
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth,
+        void *parameters, UBaseType_t priority, StackType_t *stack, StaticTask_t *buffer, BaseType_t core);
+
+#define xTaskCreate(function, name, stack_depth, parameters, priority, created) \
+    xTaskCreatePinnedToCore((function), (name), (stack_depth), (parameters), (priority), (created), tskNO_AFFINITY)
+#define xTaskCreateStatic(function, name, stack_depth, parameters, priority, stack, buffer) \
+    xTaskCreateStaticPinnedToCore((function), (name), (stack_depth), (parameters), (priority), (stack), (buffer), \
+            tskNO_AFFINITY)
+
+/*!
+ * Only the calling task can delete itself.
+ */
+void vTaskDelete(TaskHandle_t task);
+
+/*!
+ * Only the calling task can suspend itself, it is never resumed.
+ */
+void vTaskSuspend(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+char *pcTaskGetName(TaskHandle_t task);
+
+/*!
+ * Lowest free stack of the task in bytes, relative to the stack depth of the
+ * device: the stack of the host is filled with a pattern at the start, the
+ * bytes, which were overwritten, are used. The code of the host needs more
+ * stack than the ESP32, so this is an estimate, 0 if the stack depth was
+ * exceeded.
+ */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+/*!
+ * Core the task was pinned to, 0 if it was not pinned.
+ */
+BaseType_t xPortGetCoreID(void);
+
+#endif /* HOST_FREERTOS_TASK_H */
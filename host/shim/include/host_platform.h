@@ -0,0 +1,110 @@
+/*!
+ * @file host_platform.h
+ * @brief Settings of the host platform, which have no counterpart on the target.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef HOST_PLATFORM_H
+#define HOST_PLATFORM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <esp_err.h>
+
+/*!
+ * Settings of the host platform, set by the load generator before app_main() runs.
+ */
+typedef struct {
+    const char *flash_dir;      //!< directory of the partition files
+    bool flash_erase;           //!< erase the partitions at the start
+    uint32_t nvs_latency_us;    //!< simulated latency of every NVS access
+    bool keys_expired;          //!< the keys of the stored contexts are expired at the start
+} host_platform_config_t;
+
+extern host_platform_config_t host_platform_config;
+
+/*!
+ * Heap counters of the malloc() wrappers.
+ */
+typedef struct {
+    size_t allocated_bytes;
+    size_t peak_bytes;
+    size_t allocated_blocks;
+    uint64_t allocations;       //!< number of calls, which allocated memory
+} host_heap_stats_t;
+
+void host_heap_stats_get(host_heap_stats_t *stats);
+
+/*!
+ * Flash wear of a partition.
+ */
+typedef struct {
+    uint32_t sectors;           //!< sectors of the partition
+    uint64_t bytes_written;
+    uint64_t sector_erases;
+} host_flash_stats_t;
+
+/*!
+ * Get the flash wear of the partition \p label.
+ *
+ * The key storage of the host keeps the contexts in RAM, so the wear of the
+ * "nvs" partition is estimated from the stored blobs, see host_flash_nvs_write().
+ */
+void host_flash_stats_get(const char *label, host_flash_stats_t *stats);
+
+/*!
+ * Account a blob of \p len bytes written to NVS.
+ *
+ * NVS appends entries of 32 bytes to pages of one sector, a blob takes one
+ * entry for its index, one for its data header and one per 32 bytes of data.
+ * A full page is erased, when its live entries were moved by the garbage
+ * collection, so every page of entries costs one erase in the long run.
+ */
+void host_flash_nvs_write(size_t len);
+
+/*!
+ * Open the log \p name in the flash directory, which keeps the entries of NVS
+ * or the contexts of the key storage from one run to the next.
+ *
+ * Every change is appended as a record, the records of the previous runs are
+ * read from the returned file first, the last record of an entry wins. The
+ * log is emptied, if the flash is erased.
+ *
+ * @return the file, positioned at its start, or NULL
+ */
+FILE *host_flash_log_open(const char *name);
+
+/*!
+ * Get the number of ID context loads, every load reads the context from NVS on the target.
+ */
+uint64_t host_nvs_context_loads(void);
+
+/*!
+ * Post \p data to \p url on a new connection, for the thing registration
+ * of the key storage, which does not go through the connection pool.
+ *
+ * @param[out] response buffer for the body of the response, NULL terminated
+ * @return ESP_OK if the server responded, the status is in \p http_status
+ */
+esp_err_t host_http_post(const char *url, const char *content_type, const char *authorization,
+        const char *data, size_t length, int *http_status, char *response, size_t response_size,
+        size_t *response_len);
+
+#endif /* HOST_PLATFORM_H */
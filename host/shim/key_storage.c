@@ -0,0 +1,507 @@
+/*!
+ * @file key_storage.c
+ * @brief Key storage of the gateway for the host build.
+ *
+ * The ID contexts are stored in a hash table in memory instead of NVS, every
+ * stored or deleted context is appended to the log contexts.log in the flash
+ * directory, so the contexts are kept for the next run. An
+ * access to the stored contexts can be delayed by the simulated NVS latency,
+ * see host_platform.h, to show the effect of the ID context cache. Keys and
+ * things are registered at the backend like on the target, the key
+ * registration is a signed UPP.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <esp_log.h>
+#include <mbedtls/base64.h>
+#include <msgpack.h>
+#include <ubirch_ed25519.h>
+#include <ubirch_protocol.h>
+
+#include "host_platform.h"
+#include "id_handling.h"
+#include "key_handling.h"
+#include "register_thing.h"
+#include "token_handling.h"
+#include "ubirch_api.h"
+
+static const char *TAG = "key_storage";
+
+#ifndef UBIRCH_PROTOCOL_TYPE_REG
+#define UBIRCH_PROTOCOL_TYPE_REG 0x01
+#endif
+
+#define KEY_STORAGE_SHORT_NAME_SIZE 16
+#define KEY_STORAGE_PASSWORD_SIZE 64
+#define KEY_STORAGE_BUCKETS 1024
+#define KEY_STORAGE_DEFAULT_TOKEN "host-token"
+
+typedef struct key_storage_context {
+    struct key_storage_context *next;   //!< next context in the same bucket
+    char short_name[KEY_STORAGE_SHORT_NAME_SIZE];
+    unsigned char uuid[16];
+    char password[KEY_STORAGE_PASSWORD_SIZE];
+    size_t password_len;
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+    unsigned char secret_key[crypto_sign_SECRETKEYBYTES];
+    unsigned char previous_signature[crypto_sign_BYTES];
+    time_t next_key_update;
+    uint8_t state;
+} key_storage_context_t;
+
+// the keys and the UUID of the current context, used by ubirch-protocol
+unsigned char UUID[16];
+unsigned char ed25519_secret_key[crypto_sign_SECRETKEYBYTES];
+unsigned char ed25519_public_key[crypto_sign_PUBLICKEYBYTES];
+unsigned char server_pub_key[crypto_sign_PUBLICKEYBYTES];
+
+static key_storage_context_t current;
+static key_storage_context_t *buckets[KEY_STORAGE_BUCKETS];
+static pthread_mutex_t storage_lock = PTHREAD_MUTEX_INITIALIZER;
+static const char *token = NULL;
+static uint64_t context_loads = 0;
+static FILE *storage_log = NULL;
+static bool restored = false;
+
+/*!
+ * Record of a stored or deleted context in the log.
+ */
+typedef struct {
+    bool deleted;
+    key_storage_context_t context;  //!< without its link
+} key_storage_log_record_t;
+
+static void log_restore(void);
+
+static size_t bucket_of(const char *short_name) {
+    uint32_t hash = 2166136261U;
+    for (const char *c = short_name; *c != '\0'; ++c) {
+        hash = (hash ^ (uint8_t)*c) * 16777619U;
+    }
+    return hash % KEY_STORAGE_BUCKETS;
+}
+
+/*!
+ * Find the stored context \p short_name, the storage lock has to be held.
+ */
+static key_storage_context_t **find(const char *short_name) {
+    log_restore();
+    key_storage_context_t **link = &buckets[bucket_of(short_name)];
+    while (*link != NULL && strncmp((*link)->short_name, short_name, KEY_STORAGE_SHORT_NAME_SIZE) != 0) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/*!
+ * Store a copy of \p context, or delete it, if \p deleted is set. The storage lock has to be held.
+ */
+static esp_err_t context_put(const key_storage_context_t *context, bool deleted) {
+    key_storage_context_t **link = find(context->short_name);
+    key_storage_context_t *stored = *link;
+    if (deleted) {
+        if (stored != NULL) {
+            *link = stored->next;
+            free(stored);
+        }
+        return ESP_OK;
+    }
+    if (stored == NULL) {
+        stored = *link = calloc(1, sizeof(key_storage_context_t));
+        if (stored == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    key_storage_context_t *next = stored->next;
+    memcpy(stored, context, sizeof(key_storage_context_t));
+    stored->next = next;
+    return ESP_OK;
+}
+
+/*!
+ * Append a stored or deleted context to the log, the storage lock has to be held.
+ */
+static void log_append(const key_storage_context_t *context, bool deleted) {
+    if (storage_log == NULL) {
+        return;
+    }
+    key_storage_log_record_t record = { .deleted = deleted };
+    memcpy(&record.context, context, sizeof(key_storage_context_t));
+    record.context.next = NULL;
+    fwrite(&record, sizeof(record), 1, storage_log);
+    fflush(storage_log);
+}
+
+/*!
+ * Read the contexts of the previous runs from the log, at the first access. The storage lock has to be held.
+ */
+static void log_restore(void) {
+    if (restored) {
+        return;
+    }
+    restored = true;
+    storage_log = host_flash_log_open("contexts.log");
+    key_storage_log_record_t record;
+    while (storage_log != NULL && fread(&record, sizeof(record), 1, storage_log) == 1) {
+        record.context.short_name[KEY_STORAGE_SHORT_NAME_SIZE - 1] = '\0';
+        if (host_platform_config.keys_expired) {
+            record.context.next_key_update = time(NULL) - 1;
+        }
+        if (context_put(&record.context, record.deleted) != ESP_OK) {
+            break;
+        }
+    }
+}
+
+static void nvs_delay(void) {
+    if (host_platform_config.nvs_latency_us > 0) {
+        usleep(host_platform_config.nvs_latency_us);
+    }
+}
+
+esp_err_t ubirch_id_context_add(const char *short_name) {
+    memset(&current, 0, sizeof(current));
+    snprintf(current.short_name, sizeof(current.short_name), "%s", short_name);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_id_context_delete(const char *short_name) {
+    if (short_name == NULL) {
+        short_name = current.short_name;
+    }
+    nvs_delay();
+    key_storage_context_t deleted = { 0 };
+    snprintf(deleted.short_name, sizeof(deleted.short_name), "%s", short_name);
+    pthread_mutex_lock(&storage_lock);
+    context_put(&deleted, true);
+    log_append(&deleted, true);
+    pthread_mutex_unlock(&storage_lock);
+    return ESP_OK;
+}
+
+uint64_t host_nvs_context_loads(void) {
+    pthread_mutex_lock(&storage_lock);
+    uint64_t loads = context_loads;
+    pthread_mutex_unlock(&storage_lock);
+    return loads;
+}
+
+esp_err_t ubirch_id_context_load(const char *short_name) {
+    nvs_delay();
+    pthread_mutex_lock(&storage_lock);
+    context_loads++;
+    key_storage_context_t *context = *find(short_name);
+    if (context != NULL) {
+        memcpy(&current, context, sizeof(current));
+        current.next = NULL;
+    }
+    pthread_mutex_unlock(&storage_lock);
+    if (context == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    memcpy(UUID, current.uuid, sizeof(UUID));
+    memcpy(ed25519_public_key, current.public_key, sizeof(ed25519_public_key));
+    memcpy(ed25519_secret_key, current.secret_key, sizeof(ed25519_secret_key));
+    return ESP_OK;
+}
+
+esp_err_t ubirch_id_context_store(void) {
+    if (current.short_name[0] == '\0') {
+        return ESP_ERR_INVALID_STATE;
+    }
+    nvs_delay();
+    // the blob of a context on the target has the same fields, without the link
+    host_flash_nvs_write(sizeof(key_storage_context_t) - sizeof(key_storage_context_t *));
+    pthread_mutex_lock(&storage_lock);
+    esp_err_t err = context_put(&current, false);
+    if (err == ESP_OK) {
+        log_append(&current, false);
+    }
+    pthread_mutex_unlock(&storage_lock);
+    return err;
+}
+
+void ubirch_id_state_set(uint8_t state_bit, bool value) {
+    if (value) {
+        current.state |= (uint8_t)(1 << state_bit);
+    } else {
+        current.state &= (uint8_t)~(1 << state_bit);
+    }
+}
+
+bool ubirch_id_state_get(uint8_t state_bit) {
+    return (current.state & (1 << state_bit)) != 0;
+}
+
+static esp_err_t field_set(void *field, size_t size, const void *value, size_t len) {
+    if (len != size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(field, value, len);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_uuid_set(const unsigned char *uuid, size_t len) {
+    esp_err_t err = field_set(current.uuid, sizeof(current.uuid), uuid, len);
+    memcpy(UUID, current.uuid, sizeof(UUID));
+    return err;
+}
+
+esp_err_t ubirch_uuid_get(unsigned char **uuid, size_t *len) {
+    *uuid = current.uuid;
+    *len = sizeof(current.uuid);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_password_set(const char *password, size_t len) {
+    if (len > KEY_STORAGE_PASSWORD_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(current.password, password, len);
+    current.password_len = len;
+    ubirch_id_state_set(UBIRCH_ID_STATE_PASSWORD_SET, true);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_password_get(char **password, size_t *len) {
+    if (!ubirch_id_state_get(UBIRCH_ID_STATE_PASSWORD_SET)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *password = current.password;
+    *len = current.password_len;
+    return ESP_OK;
+}
+
+esp_err_t ubirch_public_key_set(const unsigned char *key, size_t len) {
+    esp_err_t err = field_set(current.public_key, sizeof(current.public_key), key, len);
+    memcpy(ed25519_public_key, current.public_key, sizeof(ed25519_public_key));
+    return err;
+}
+
+esp_err_t ubirch_public_key_get(unsigned char **key, size_t *len) {
+    *key = current.public_key;
+    *len = sizeof(current.public_key);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_secret_key_set(const unsigned char *key, size_t len) {
+    esp_err_t err = field_set(current.secret_key, sizeof(current.secret_key), key, len);
+    memcpy(ed25519_secret_key, current.secret_key, sizeof(ed25519_secret_key));
+    return err;
+}
+
+esp_err_t ubirch_secret_key_get(unsigned char **key, size_t *len) {
+    *key = current.secret_key;
+    *len = sizeof(current.secret_key);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_previous_signature_set(const unsigned char *signature, size_t len) {
+    return field_set(current.previous_signature, sizeof(current.previous_signature), signature, len);
+}
+
+esp_err_t ubirch_previous_signature_get(unsigned char **signature, size_t *len) {
+    *signature = current.previous_signature;
+    *len = sizeof(current.previous_signature);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_next_key_update_set(time_t next) {
+    current.next_key_update = next;
+    return ESP_OK;
+}
+
+esp_err_t ubirch_next_key_update_get(time_t *next) {
+    *next = current.next_key_update;
+    return ESP_OK;
+}
+
+esp_err_t uuid_v5_create_derived_from_name(uuid_t *uuid, char *name_space, size_t name_space_len,
+        char *gateway, size_t gateway_len, char *name, size_t name_len) {
+    // like a version 5 UUID, but with the SHA-512 of the NaCl component instead of SHA-1
+    size_t len = name_space_len + gateway_len + name_len;
+    unsigned char *input = malloc(len);
+    if (input == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(input, name_space, name_space_len);
+    memcpy(input + name_space_len, gateway, gateway_len);
+    memcpy(input + name_space_len + gateway_len, name, name_len);
+    unsigned char hash[crypto_hash_sha512_BYTES];
+    crypto_hash_sha512(hash, input, len);
+    free(input);
+    memcpy(*uuid, hash, sizeof(uuid_t));
+    (*uuid)[6] = (unsigned char)(((*uuid)[6] & 0x0f) | 0x50);
+    (*uuid)[8] = (unsigned char)(((*uuid)[8] & 0x3f) | 0x80);
+    return ESP_OK;
+}
+
+void uuid_to_string(const unsigned char *uuid, char *buffer, size_t len) {
+    snprintf(buffer, len, "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+            uuid[0], uuid[1], uuid[2], uuid[3], uuid[4], uuid[5], uuid[6], uuid[7],
+            uuid[8], uuid[9], uuid[10], uuid[11], uuid[12], uuid[13], uuid[14], uuid[15]);
+}
+
+void create_keys(void) {
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+    unsigned char secret_key[crypto_sign_SECRETKEYBYTES];
+    crypto_sign_keypair(public_key, secret_key);
+    ubirch_public_key_set(public_key, sizeof(public_key));
+    ubirch_secret_key_set(secret_key, sizeof(secret_key));
+    ubirch_next_key_update_set(time(NULL) + (time_t)CONFIG_UBIRCH_KEY_LIFETIME_YEARS * 365 * 24 * 3600);
+    ubirch_id_state_set(UBIRCH_ID_STATE_KEYS_CREATED, true);
+    ubirch_id_state_set(UBIRCH_ID_STATE_KEYS_REGISTERED, false);
+}
+
+static void pack_str(msgpack_packer *pk, const char *str) {
+    size_t len = strlen(str);
+    msgpack_pack_str(pk, len);
+    msgpack_pack_str_body(pk, str, len);
+}
+
+static void pack_bin(msgpack_packer *pk, const unsigned char *bin, size_t len) {
+    msgpack_pack_bin(pk, len);
+    msgpack_pack_bin_body(pk, bin, len);
+}
+
+/*!
+ * Pack the key registration of the current context into \p sbuf.
+ */
+static void pack_key_registration(msgpack_sbuffer *sbuf) {
+    time_t now = time(NULL);
+    msgpack_packer pk;
+    msgpack_packer_init(&pk, sbuf, msgpack_sbuffer_write);
+    msgpack_pack_map(&pk, 7);
+    pack_str(&pk, "algorithm");
+    pack_str(&pk, "ECC_ED25519");
+    pack_str(&pk, "created");
+    msgpack_pack_uint64(&pk, (uint64_t)now);
+    pack_str(&pk, "hwDeviceId");
+    pack_bin(&pk, current.uuid, sizeof(current.uuid));
+    pack_str(&pk, "pubKey");
+    pack_bin(&pk, current.public_key, sizeof(current.public_key));
+    pack_str(&pk, "pubKeyId");
+    pack_bin(&pk, current.public_key, sizeof(current.public_key));
+    pack_str(&pk, "validNotAfter");
+    msgpack_pack_uint64(&pk, (uint64_t)current.next_key_update);
+    pack_str(&pk, "validNotBefore");
+    msgpack_pack_uint64(&pk, (uint64_t)now);
+}
+
+esp_err_t register_keys(void) {
+    msgpack_sbuffer sbuf;
+    msgpack_sbuffer_init(&sbuf);
+    pack_key_registration(&sbuf);
+
+    // the registration is signed with the new key
+    esp_err_t err = ESP_FAIL;
+    ubirch_protocol *upp = ubirch_protocol_new(current.uuid, ed25519_sign);
+    if (upp != NULL && ubirch_protocol_message(upp, proto_signed, UBIRCH_PROTOCOL_TYPE_REG,
+                sbuf.data, sbuf.size) == 0) {
+        // sent like by the key storage of the target, through the pool, if it wraps ubirch_send()
+        int http_status = 0;
+        if (ubirch_send(CONFIG_UBIRCH_BACKEND_KEY_SERVER_URL, current.uuid, upp->data, upp->size,
+                    &http_status, NULL, NULL) != UBIRCH_SEND_OK) {
+            ESP_LOGW(TAG, "key registration failed");
+        } else if (http_status != 200) {
+            ESP_LOGW(TAG, "key registration failed: %d", http_status);
+        } else {
+            err = ESP_OK;
+        }
+    }
+    if (upp != NULL) {
+        ubirch_protocol_free(upp);
+    }
+    msgpack_sbuffer_destroy(&sbuf);
+    if (err == ESP_OK) {
+        ubirch_id_state_set(UBIRCH_ID_STATE_KEYS_REGISTERED, true);
+    }
+    return err;
+}
+
+esp_err_t update_keys(void) {
+    create_keys();
+    return register_keys();
+}
+
+esp_err_t load_backend_key(void) {
+    size_t len = 0;
+    const char *key = CONFIG_UBIRCH_BACKEND_PUBLIC_KEY;
+    if (mbedtls_base64_decode(server_pub_key, sizeof(server_pub_key), &len,
+                (const unsigned char *)key, strlen(key)) != 0 || len != sizeof(server_pub_key)) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ubirch_token_load(void) {
+    token = getenv("UBIRCH_TOKEN");
+    if (token == NULL || token[0] == '\0') {
+        token = KEY_STORAGE_DEFAULT_TOKEN;
+    }
+    return ESP_OK;
+}
+
+bool ubirch_token_state_get(uint8_t state_bit) {
+    return state_bit == UBIRCH_TOKEN_STATE_VALID && token != NULL;
+}
+
+esp_err_t ubirch_token_get(const char **out) {
+    *out = token;
+    return (token != NULL) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+int ubirch_register_current_id(char *description) {
+    char uuid_string[37];
+    uuid_to_string(current.uuid, uuid_string, sizeof(uuid_string));
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+            "{\"reqType\":\"creation\",\"tags\":[],\"prefix\":\"\",\"devices\":"
+            "[{\"hwDeviceId\":\"%s\",\"description\":\"%s\"}]}", uuid_string, description);
+    char authorization[256];
+    snprintf(authorization, sizeof(authorization), "Bearer %s", token);
+
+    int http_status = 0;
+    char response[512];
+    if (len >= (int)sizeof(request)
+            || host_http_post(CONFIG_UBIRCH_REGISTER_THING_URL, "application/json", authorization,
+                    request, (size_t)len, &http_status, response, sizeof(response), NULL) != ESP_OK) {
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    }
+    if (http_status == 409) {
+        return UBIRCH_ESP32_REGISTER_THING_ALREADY_REGISTERED;
+    }
+    const char *password = strstr(response, "\"password\":\"");
+    if (http_status != 200 || password == NULL) {
+        ESP_LOGW(TAG, "thing registration failed: %d %s", http_status, response);
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    }
+    password += strlen("\"password\":\"");
+    const char *end = strchr(password, '"');
+    if (end == NULL || ubirch_password_set(password, (size_t)(end - password)) != ESP_OK) {
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    }
+    return UBIRCH_ESP32_REGISTER_THING_SUCCESS;
+}
@@ -0,0 +1,270 @@
+/*!
+ * @file nvs.c
+ * @brief NVS of ESP-IDF for the host build.
+ *
+ * The entries of all namespaces are kept in one list in memory, like the ID
+ * contexts of the key storage. A handle is the index of its namespace, with
+ * the write permission in its upper half. Every change is appended to the log
+ * nvs.log in the flash directory, so the entries are kept for the next run.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nvs.h>
+
+#include "host_platform.h"
+
+#define NVS_NAME_SIZE 16
+#define NVS_NAMESPACES 32
+#define NVS_HANDLE_WRITE 0x10000
+// length of the log record of an erased entry
+#define NVS_LOG_ERASED UINT32_MAX
+
+typedef struct nvs_entry {
+    struct nvs_entry *next;
+    size_t namespace_index;
+    char key[NVS_NAME_SIZE];
+    size_t length;
+    uint8_t value[];
+} nvs_entry_t;
+
+static char namespaces[NVS_NAMESPACES][NVS_NAME_SIZE];
+static size_t namespace_count = 0;
+static nvs_entry_t *entries = NULL;
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *nvs_log = NULL;
+static bool restored = false;
+
+/*!
+ * Record of a change in the log, followed by the value.
+ */
+typedef struct {
+    char namespace_name[NVS_NAME_SIZE];
+    char key[NVS_NAME_SIZE];
+    uint32_t length;            //!< NVS_LOG_ERASED for an erased entry
+} nvs_log_record_t;
+
+/*!
+ * Find the entry \p key of a namespace, the NVS lock has to be held.
+ */
+static nvs_entry_t **find(size_t namespace_index, const char *key) {
+    nvs_entry_t **link = &entries;
+    while (*link != NULL && ((*link)->namespace_index != namespace_index
+            || strncmp((*link)->key, key, NVS_NAME_SIZE) != 0)) {
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/*!
+ * Get the index of the namespace \p name, create it, if \p create is set. The NVS lock has to be held.
+ */
+static esp_err_t namespace_index_get(const char *name, bool create, size_t *index) {
+    *index = 0;
+    while (*index < namespace_count && strcmp(namespaces[*index], name) != 0) {
+        (*index)++;
+    }
+    if (*index < namespace_count) {
+        return ESP_OK;
+    }
+    if (!create) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (namespace_count == NVS_NAMESPACES) {
+        return ESP_ERR_NO_MEM;
+    }
+    strcpy(namespaces[namespace_count++], name);
+    return ESP_OK;
+}
+
+/*!
+ * Replace the entry of \p key by \p entry, or remove it, if \p entry is NULL. The NVS lock has to be held.
+ *
+ * @return the replaced entry, which has to be freed
+ */
+static nvs_entry_t *entry_replace(size_t namespace_index, const char *key, nvs_entry_t *entry) {
+    nvs_entry_t **link = find(namespace_index, key);
+    nvs_entry_t *old = *link;
+    if (entry != NULL) {
+        entry->next = (old != NULL) ? old->next : NULL;
+        *link = entry;
+    } else if (old != NULL) {
+        *link = old->next;
+    }
+    return old;
+}
+
+/*!
+ * Append a change to the log, the NVS lock has to be held.
+ */
+static void log_append(size_t namespace_index, const char *key, const void *value, uint32_t length) {
+    if (nvs_log == NULL) {
+        return;
+    }
+    nvs_log_record_t record = { .length = length };
+    strcpy(record.namespace_name, namespaces[namespace_index]);
+    strcpy(record.key, key);
+    fwrite(&record, sizeof(record), 1, nvs_log);
+    if (length != NVS_LOG_ERASED) {
+        fwrite(value, 1, length, nvs_log);
+    }
+    fflush(nvs_log);
+}
+
+/*!
+ * Read the entries of the previous runs from the log, at the first access. The NVS lock has to be held.
+ */
+static void log_restore(void) {
+    if (restored) {
+        return;
+    }
+    restored = true;
+    nvs_log = host_flash_log_open("nvs.log");
+    nvs_log_record_t record;
+    while (nvs_log != NULL && fread(&record, sizeof(record), 1, nvs_log) == 1) {
+        record.namespace_name[NVS_NAME_SIZE - 1] = '\0';
+        record.key[NVS_NAME_SIZE - 1] = '\0';
+        size_t namespace_index = 0;
+        if (namespace_index_get(record.namespace_name, true, &namespace_index) != ESP_OK) {
+            break;
+        }
+        nvs_entry_t *entry = NULL;
+        if (record.length != NVS_LOG_ERASED) {
+            entry = malloc(sizeof(nvs_entry_t) + record.length);
+            if (entry == NULL || fread(entry->value, 1, record.length, nvs_log) != record.length) {
+                // the last record is incomplete, like after a power failure
+                free(entry);
+                break;
+            }
+            entry->namespace_index = namespace_index;
+            strcpy(entry->key, record.key);
+            entry->length = record.length;
+        }
+        free(entry_replace(namespace_index, record.key, entry));
+    }
+}
+
+static bool handle_valid(nvs_handle_t handle) {
+    return (handle & ~NVS_HANDLE_WRITE) < namespace_count;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    if (name == NULL || strlen(name) >= NVS_NAME_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    log_restore();
+    // like on the target, a namespace is created by the first write access
+    size_t index = 0;
+    esp_err_t err = namespace_index_get(name, open_mode == NVS_READWRITE, &index);
+    pthread_mutex_unlock(&nvs_lock);
+    if (err == ESP_OK) {
+        *out_handle = (nvs_handle_t)index | (open_mode == NVS_READWRITE ? NVS_HANDLE_WRITE : 0);
+    }
+    return err;
+}
+
+void nvs_close(nvs_handle_t handle) {
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return handle_valid(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    if (!handle_valid(handle)) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = *find(handle & ~NVS_HANDLE_WRITE, key);
+    if (entry == NULL) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out_value == NULL) {
+        *length = entry->length;
+    } else if (*length < entry->length) {
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out_value, entry->value, entry->length);
+        *length = entry->length;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    if (!handle_valid(handle)) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!(handle & NVS_HANDLE_WRITE)) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (key == NULL || strlen(key) >= NVS_NAME_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    nvs_entry_t *entry = malloc(sizeof(nvs_entry_t) + length);
+    if (entry == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->namespace_index = handle & ~NVS_HANDLE_WRITE;
+    strcpy(entry->key, key);
+    entry->length = length;
+    memcpy(entry->value, value, length);
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *old = entry_replace(entry->namespace_index, key, entry);
+    log_append(entry->namespace_index, key, value, (uint32_t)length);
+    pthread_mutex_unlock(&nvs_lock);
+    free(old);
+    host_flash_nvs_write(length);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char *key, int64_t *out_value) {
+    size_t length = sizeof(int64_t);
+    return nvs_get_blob(handle, key, out_value, &length);
+}
+
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char *key, int64_t value) {
+    return nvs_set_blob(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    if (!handle_valid(handle)) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!(handle & NVS_HANDLE_WRITE)) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = entry_replace(handle & ~NVS_HANDLE_WRITE, key, NULL);
+    if (entry != NULL) {
+        log_append(handle & ~NVS_HANDLE_WRITE, key, NULL, NVS_LOG_ERASED);
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    free(entry);
+    return ESP_OK;
+}
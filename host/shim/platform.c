@@ -0,0 +1,63 @@
+/*!
+ * @file platform.c
+ * @brief Networking, storage and firmware update of the gateway for the host build.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+
+#include "networking.h"
+#include "sntp_time.h"
+#include "storage.h"
+#include "ubirch_ota.h"
+#include "ubirch_ota_task.h"
+
+static const char *TAG = "platform";
+
+EventGroupHandle_t network_event_group = NULL;
+
+void init_wifi(void) {
+    network_event_group = xEventGroupCreate();
+}
+
+esp_err_t wifi_join(struct Wifi_login wifi, int timeout_ms) {
+    (void)wifi;
+    (void)timeout_ms;
+    // the network of the host is always up
+    xEventGroupSetBits(network_event_group, WIFI_CONNECTED_BIT);
+    return ESP_OK;
+}
+
+void sntp_update(void) {
+    ESP_LOGD(TAG, "the host clock is used");
+}
+
+void init_nvs(void) {
+}
+
+esp_err_t ubirch_firmware_update(void) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void ubirch_ota_task(void *pvParameters) {
+    (void)pvParameters;
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""
+Compare the batch verification of the verify stage with the single verification.
+
+Generates batches of signatures with ed25519_ref.py and checks them with the
+verify-batch tool, which runs the batch equation, ed25519_verify_key() for
+every item and ubirch_verify_batch(). The valid flags of ubirch_verify_batch()
+have to be the results of the single verification, and the batch equation
+has to pass only for valid batches, with one documented exception:
+
+    valid          random keys, data and batch sizes pass the batch
+    modified       a changed bit of the data, R or s fails the batch
+    s >= L         s + L fails the batch, like a non-canonical scalar
+    R/A encoding   non-canonical encodings of R and the public key fail the batch
+    small order    R or a public key of small order fails the batch
+    mixed order    R with a small-order component, signed with the key, passes
+                   the batch and fails alone, as the batch multiplies by the
+                   cofactor (see main/verify_batch.h)
+
+    $ python3 host/verify_test.py --tool build-host/verify-batch
+"""
+
+import argparse
+import hashlib
+import random
+import subprocess
+import sys
+
+from ed25519_ref import G, L, P, SigningKey, _add, _compress, _decompress, _mul
+
+# the signed data of a UPP is its SHA-512
+DATA_SIZE = 64
+# the exit code of the tool, when the batch verification is not configured
+SKIPPED = 77
+
+
+def _hash(r, a, data):
+    return int.from_bytes(hashlib.sha512(r + a + data).digest(), "little") % L
+
+
+def _scalar(s):
+    return int.to_bytes(s, 32, "little")
+
+
+class Signer:
+    """A key pair, which also makes the signatures an honest signer does not make."""
+
+    def __init__(self, rng):
+        key = SigningKey(rng.randbytes(32))
+        self.a = key._scalar
+        self.public_key = bytes(key.verify_key)
+        self.rng = rng
+
+    def sign(self, data, torsion=None):
+        """Sign with a random nonce, R gets the small-order component torsion."""
+        r = self.rng.randrange(1, L)
+        point = _mul(r, G)
+        if torsion is not None:
+            point = _add(point, torsion)
+        encoded = _compress(point)
+        s = (r + _hash(encoded, self.public_key, data) * self.a) % L
+        return encoded + _scalar(s)
+
+
+def small_order_points():
+    """The 8 points, which the cofactor turns into the identity, the first has order 8."""
+    rng = random.Random(8)
+    while True:
+        point = _decompress(rng.randbytes(32))
+        if point is None:
+            continue
+        torsion = _mul(L, point)
+        if _compress(_mul(4, torsion)) != _compress((0, 1, 1, 0)):
+            return [_mul(k, torsion) for k in range(1, 9)]
+
+
+def flip(data, rng):
+    data = bytearray(data)
+    bit = rng.randrange(8 * len(data))
+    data[bit // 8] ^= 1 << (bit % 8)
+    return bytes(data)
+
+
+def cases(rng, batch_size, rounds):
+    """(name, public key, items, expected result of the batch equation) of every batch."""
+    torsion = small_order_points()
+    identity = _compress(torsion[-1])
+    non_canonical_identity = _scalar(P + 1)
+
+    for _ in range(rounds):
+        signer = Signer(rng)
+        items = []
+        for _ in range(rng.randint(2, batch_size)):
+            data = rng.randbytes(rng.choice([DATA_SIZE, rng.randint(0, DATA_SIZE)]))
+            items.append((data, signer.sign(data)))
+        yield "valid", signer.public_key, items, 0
+
+        modified = list(items)
+        for i in rng.sample(range(len(items)), rng.randint(1, len(items))):
+            data, signature = items[i]
+            part = rng.choice(["data", "R", "s"])
+            if part == "data" and data:
+                data = flip(data, rng)
+            elif part == "R":
+                signature = flip(signature[:32], rng) + signature[32:]
+            else:
+                # keep s below 2^253, so it is not the same scalar plus L
+                signature = signature[:32] + flip(signature[32:63], rng) + signature[63:]
+            modified[i] = (data, signature)
+        if modified != items:
+            yield "modified", signer.public_key, modified, -1
+
+        i = rng.randrange(len(items))
+        data, signature = items[i]
+        s = int.from_bytes(signature[32:], "little") + L
+        yield "s >= L", signer.public_key, items[:i] + [(data, signature[:32] + _scalar(s))] + items[i + 1:], -1
+
+        # R is the identity: s = h a
+        data = rng.randbytes(DATA_SIZE)
+        for encoding in (non_canonical_identity, identity):
+            s = _hash(encoding, signer.public_key, data) * signer.a % L
+            yield "R/A encoding", signer.public_key, items[1:] + [(data, encoding + _scalar(s))], -1
+
+        # R of small order
+        point = rng.choice(torsion)
+        data = rng.randbytes(DATA_SIZE)
+        encoding = _compress(point)
+        s = _hash(encoding, signer.public_key, data) * signer.a % L
+        yield "small order", signer.public_key, items[1:] + [(data, encoding + _scalar(s))], -1
+
+        # the public key has small order, everyone can sign with R = [s]B
+        for public_key in (_compress(rng.choice(torsion)), non_canonical_identity):
+            forged = []
+            for _ in range(rng.randint(2, batch_size)):
+                s = rng.randrange(L)
+                forged.append((rng.randbytes(DATA_SIZE), _compress(_mul(s, G)) + _scalar(s)))
+            yield "small order" if public_key != non_canonical_identity else "R/A encoding", public_key, forged, -1
+
+        i = rng.randrange(len(items))
+        data = rng.randbytes(DATA_SIZE)
+        mixed = items[:i] + [(data, signer.sign(data, torsion=rng.choice(torsion[:-1])))] + items[i + 1:]
+        yield "mixed order", signer.public_key, mixed, 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare the batch verification with the single verification")
+    parser.add_argument("--tool", required=True, help="the verify-batch program")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--rounds", type=int, default=30, help="rounds of the cases, every round makes a batch of each")
+    args = parser.parse_args()
+
+    result = subprocess.run([args.tool, "--batch-size"], capture_output=True, text=True)
+    if result.returncode == SKIPPED:
+        print(result.stderr.strip())
+        sys.exit(SKIPPED)
+    batch_size = int(result.stdout)
+
+    batches = list(cases(random.Random(args.seed), batch_size, args.rounds))
+    lines = "".join(f"{key.hex()} {' '.join(f'{d.hex()}:{s.hex()}' for d, s in items)}\n"
+                    for _, key, items, _ in batches)
+    result = subprocess.run([args.tool], input=lines, capture_output=True, text=True, check=True)
+    results = result.stdout.splitlines()
+    if len(results) != len(batches):
+        print(f"FAIL {len(results)} results of {len(batches)} batches", file=sys.stderr)
+        sys.exit(1)
+
+    counts, failures = {}, {}
+    for (name, _, items, expected), line in zip(batches, results):
+        check, single, flags = line.split()
+        counts[name] = counts.get(name, 0) + 1
+        if name == "mixed order":
+            # the documented exception: the batch passes, the single verification refuses the item
+            ok = check == "0" and flags == "1" * len(items) and single.count("0") == 1
+        else:
+            ok = int(check) == expected and flags == single and (check != "0" or single == "1" * len(items))
+        if not ok:
+            failures[name] = failures.get(name, 0) + 1
+            if failures[name] <= 3:
+                print(f"FAIL {name}: batch {check}, single {single}, flags {flags}", file=sys.stderr)
+
+    for name, count in counts.items():
+        print(f"{'FAIL' if failures.get(name) else 'ok  '} {name}: {count - failures.get(name, 0)} of {count} batches")
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -26,16 +26,33 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <msgpack.h>
-#include <message.h>
 #include <ubirch_api.h>
 #include <response.h>
 #include <esp_log.h>
 #include "driver/gpio.h"
 #include <ubirch_protocol.h>
 #include <ubirch_ed25519.h>
+#include <time.h>
+#include <sys/param.h>
+#include <esp_timer.h>
+#include <esp_system.h>
 #include "anchor.h"
+#include "binlog.h"
+#include "boot.h"
+#include "breaker.h"
+#include "budget.h"
+#include "http_pool.h"
+#include "id_cache.h"
+#include "journal.h"
+#include "upp_queue.h"
+#include "id_handling.h"
 #include "key_handling.h"
+#include "metrics.h"
+#include "rate_control.h"
+#include "signer.h"
+#include "verify_batch.h"
 
 //#define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
 
@@ -47,6 +64,36 @@ extern unsigned char server_pub_key[crypto_sign_PUBLICKEYBYTES];
 
 unsigned int interval = CONFIG_UBIRCH_DEFAULT_INTERVAL;
 
+// allocated once by ubirch_anchor_init() and reused for every message
+static ubirch_protocol *protocol = NULL;        //!< send buffer of the UPPs
+static msgpack_sbuffer payload_buffer;          //!< packed data, before it is hashed
+static msgpack_unpacker *receiver = NULL;       //!< receive unpacker, if the response is handled directly
+
+static ubirch_anchor_stats_t stats = { 0 };
+// the stages of the pipeline count at the same time
+static SemaphoreHandle_t stats_lock = NULL;
+UBIRCH_SEMAPHORE_DEFINE(stats_lock);
+
+/*!
+ * Count \p n in the \p counter of the statistics.
+ */
+#define ANCHOR_COUNT(counter, n) do { \
+        if (stats_lock != NULL) xSemaphoreTake(stats_lock, portMAX_DELAY); \
+        stats.counter += (n); \
+        if (stats_lock != NULL) xSemaphoreGive(stats_lock); \
+    } while (0)
+
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+static bool queue_ready = false;
+#elif CONFIG_UBIRCH_ANCHOR_PENDING > 0
+// UPPs, which could not be delivered, in the order they were signed
+static ubirch_anchor_upp_t pending[CONFIG_UBIRCH_ANCHOR_PENDING];
+static size_t pending_first = 0;
+static size_t pending_count = 0;
+static uint32_t pending_failures = 0;   //!< failed attempts to send the first pending UPP
+static int64_t pending_due = 0;         //!< time of the next attempt
+#endif
+
 /*!
  * This function handles responses from the backend, where we can set parameters.
  * @param entry a msgpack entry as received
@@ -54,6 +101,9 @@ unsigned int interval = CONFIG_UBIRCH_DEFAULT_INTERVAL;
 void response_handler(const struct msgpack_object_kv *entry) {
     if (match(entry, "i", MSGPACK_OBJECT_POSITIVE_INTEGER)) {
         interval = (unsigned int) (entry->val.via.u64);
+#if CONFIG_UBIRCH_RATE_CONTROL
+        ubirch_rate_control_interval_set(interval);
+#endif
     } else {
         ESP_LOGW(__func__, "unknown configuration received: %.*s", entry->key.via.str.size, entry->key.via.str.ptr);
     }
@@ -65,7 +115,7 @@ void response_handler(const struct msgpack_object_kv *entry) {
  * @param len length of received data
  */
 void bin_response_handler(const void* data, size_t len) {
-    ESP_LOG_BUFFER_HEXDUMP("response UPP payload", data, len, ESP_LOG_DEBUG);
+    UBIRCH_LOG_BUFFER_HEXDUMP("response UPP payload", data, len, ESP_LOG_DEBUG);
 }
 
 /*!
@@ -77,51 +127,676 @@ static int ed25519_verify_backend_response(const unsigned char *data,
     return ed25519_verify_key(data, len, signature, server_pub_key);
 }
 
-esp_err_t ubirch_anchor_data(int32_t* values, uint16_t num) {
-    // create a ubirch protocol context
-    ubirch_protocol *upp = ubirch_protocol_new(UUID, ed25519_sign); //!< send buffer
-    msgpack_unpacker *unpacker = msgpack_unpacker_new(128); //!< receive unpacker
+/*!
+ * Pack the timestamp and the values into the payload buffer.
+ */
+static void anchor_pack_values(const int32_t *values, uint16_t num) {
+    msgpack_sbuffer_clear(&payload_buffer);
+    msgpack_packer pk;
+    msgpack_packer_init(&pk, &payload_buffer, msgpack_sbuffer_write);
+    msgpack_pack_array(&pk, 2);
+    msgpack_pack_uint64(&pk, (uint64_t)time(NULL));
+    msgpack_pack_array(&pk, num);
+    for (uint16_t i = 0; i < num; ++i) {
+        msgpack_pack_int32(&pk, values[i]);
+    }
+}
 
-    ubirch_message(upp, values, num);
-    ESP_LOGI("UBIRCH SEND", " to %s , len: %d",CONFIG_UBIRCH_BACKEND_DATA_URL, upp->size);
-    ESP_LOG_BUFFER_HEXDUMP("UPP", upp->data,upp->size, ESP_LOG_DEBUG);
-    int http_status;
-    switch (ubirch_send(CONFIG_UBIRCH_BACKEND_DATA_URL, UUID, upp->data, upp->size,
-            &http_status, unpacker, ed25519_verify_backend_response))
-    {
-        case UBIRCH_SEND_OK:
-            switch (http_status) {
-                case 200:
-                    ESP_LOGI("UBIRCH SEND", " http status of response: %d", http_status);
-                    if (ubirch_parse_backend_response(unpacker, bin_response_handler)
-                            != UBIRCH_ESP32_API_HTTP_RESPONSE_SUCCESS) {
-                        ESP_LOGW("UBIRCH SEND", " verified response broken");
-                    }
-                    break;
-                case 400:
-                case 401:
-                case 403:
-                case 404:
-                case 405:
-                case 409:
-                case 500:
-                    ESP_LOGW("UBIRCH SEND", " http status of response: %d", http_status);
-                    break;
-                default:
-                    ESP_LOGW("UBIRCH SEND", " enexpected http status: %d", http_status);
-                    break;
-            }
+/*!
+ * Create a chained UPP from the hash of the payload, like ubirch_message() does.
+ *
+ * In contrast to ubirch_message(), the new previous signature is not stored
+ * in NVS directly, but handed to the ID context cache, which writes it back.
+ */
+static esp_err_t anchor_message(ubirch_protocol *upp, const char *payload, size_t len) {
+    // load the signature of the previous message
+    unsigned char *prev_sig = NULL;
+    size_t prev_sig_len = 0;
+    if (ubirch_previous_signature_get(&prev_sig, &prev_sig_len) != ESP_OK
+            || prev_sig_len != UBIRCH_PROTOCOL_SIGN_SIZE) {
+        ESP_LOGE(__func__, "failed to load previous signature");
+        return ESP_FAIL;
+    }
+    memcpy(upp->signature, prev_sig, UBIRCH_PROTOCOL_SIGN_SIZE);
+
+    // only the hash of the payload is anchored
+    unsigned char hash[crypto_hash_sha512_BYTES];
+    crypto_hash_sha512(hash, (const unsigned char *)payload, len);
+
+    // create the chained message, the signature is stored in upp->signature
+    if (ubirch_protocol_message(upp, proto_chained, UBIRCH_PROTOCOL_TYPE_BIN,
+                (const char *)hash, sizeof(hash)) != 0) {
+        ESP_LOGE(__func__, "failed to create UPP");
+        return ESP_FAIL;
+    }
+    if (ubirch_previous_signature_set(upp->signature, UBIRCH_PROTOCOL_SIGN_SIZE) != ESP_OK) {
+        ESP_LOGE(__func__, "failed to set previous signature");
+        return ESP_FAIL;
+    }
+    return ubirch_id_cache_commit(NULL, true);
+}
+
+/*!
+ * Log the http status of a response and parse the content of a verified response.
+ */
+static void anchor_response_status(int http_status, msgpack_unpacker *unpacker) {
+    switch (http_status) {
+        case 200:
+            UBIRCH_LOGI("UBIRCH SEND", " http status of response: %d", http_status);
+            UBIRCH_BOOT_MARK(UBIRCH_BOOT_FIRST_ANCHORED);
             // as the response was verified we parse it
+            {
+                UBIRCH_METRICS_SPAN(parse);
+                if (ubirch_parse_backend_response(unpacker, bin_response_handler)
+                        != UBIRCH_ESP32_API_HTTP_RESPONSE_SUCCESS) {
+                    ESP_LOGW("UBIRCH SEND", " verified response broken");
+                }
+                UBIRCH_METRICS_STOP(UBIRCH_METRICS_PARSE, parse);
+            }
+            break;
+        case 400:
+        case 401:
+        case 403:
+        case 404:
+        case 405:
+        case 409:
+        case 500:
+            ESP_LOGW("UBIRCH SEND", " http status of response: %d", http_status);
+            break;
+        default:
+            ESP_LOGW("UBIRCH SEND", " enexpected http status: %d", http_status);
+            break;
+    }
+}
+
+#if CONFIG_UBIRCH_RATE_CONTROL
+/*!
+ * Wait until the rate control allows to send the next UPP.
+ */
+static void anchor_pace(void) {
+    uint32_t delay_ms = ubirch_rate_control_send_delay_ms();
+    if (delay_ms > 0) {
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+    }
+}
+#endif
+
+/*!
+ * Map the result of ubirch_send() to the result of the anchoring.
+ *
+ * @return ESP_OK, UBIRCH_ANCHOR_RETRY, UBIRCH_ANCHOR_REJECTED or UBIRCH_ANCHOR_UNVERIFIED
+ */
+static esp_err_t anchor_result(ubirch_send_err_t send_err, int http_status) {
+    if (send_err != UBIRCH_SEND_OK && send_err != UBIRCH_SEND_VERIFICATION_FAILED) {
+        return UBIRCH_ANCHOR_RETRY;
+    }
+    if (http_status >= 500 || http_status == 408 || http_status == 429) {
+        return UBIRCH_ANCHOR_RETRY;
+    }
+    if (http_status < 200 || http_status >= 300) {
+        return UBIRCH_ANCHOR_REJECTED;
+    }
+    return (send_err == UBIRCH_SEND_VERIFICATION_FAILED) ? UBIRCH_ANCHOR_UNVERIFIED : ESP_OK;
+}
+
+/*!
+ * Send a UPP to the backend once, unless the circuit of the backend is open.
+ *
+ * Without the connection pool, ubirch_send() uses the credentials of the
+ * current context, so the ID context of the UPP has to be the current context.
+ *
+ * @param[out] http_status the http status of the response, 0 if there is none
+ * @param verifier function to verify the response signature, or NULL
+ * @return ESP_OK, UBIRCH_ANCHOR_RETRY, UBIRCH_ANCHOR_REJECTED or UBIRCH_ANCHOR_UNVERIFIED
+ */
+static esp_err_t anchor_post(const ubirch_anchor_upp_t *upp, int *http_status, msgpack_unpacker *unpacker,
+        ubirch_protocol_check verifier) {
+    *http_status = 0;
+#if CONFIG_UBIRCH_BREAKER
+    if (!ubirch_breaker_allow(CONFIG_UBIRCH_BACKEND_DATA_URL)) {
+        return UBIRCH_ANCHOR_RETRY;
+    }
+#endif
+#if CONFIG_UBIRCH_RATE_CONTROL
+    anchor_pace();
+    int64_t sent = esp_timer_get_time();
+#endif
+    UBIRCH_LOGI("UBIRCH SEND", " to " CONFIG_UBIRCH_BACKEND_DATA_URL " , len: %d", upp->size);
+    UBIRCH_LOG_BUFFER_HEXDUMP("UPP", upp->data, upp->size, ESP_LOG_DEBUG);
+    UBIRCH_METRICS_SPAN(send);
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+    ubirch_send_err_t send_err = ubirch_http_pool_send_auth(CONFIG_UBIRCH_BACKEND_DATA_URL, upp->uuid,
+            upp->password, upp->password_len, upp->data, upp->size, http_status, unpacker, verifier);
+#else
+    ubirch_send_err_t send_err = ubirch_send(CONFIG_UBIRCH_BACKEND_DATA_URL, upp->uuid, upp->data, upp->size,
+            http_status, unpacker, verifier);
+#endif
+    UBIRCH_METRICS_STOP(UBIRCH_METRICS_SEND, send);
+    UBIRCH_METRICS_COUNT(UBIRCH_METRICS_SENDS, 1);
+    UBIRCH_METRICS_COUNT(UBIRCH_METRICS_BYTES_SENT, upp->size);
+    esp_err_t err = anchor_result(send_err, *http_status);
+    if (send_err != UBIRCH_SEND_OK && send_err != UBIRCH_SEND_VERIFICATION_FAILED) {
+        ESP_LOGE("UBIRCH_SEND", " ubirch_send failed");
+        UBIRCH_METRICS_COUNT(UBIRCH_METRICS_SEND_FAILURES, 1);
+        *http_status = 0;
+    }
+#if CONFIG_UBIRCH_RATE_CONTROL
+    ubirch_rate_control_result(*http_status, esp_timer_get_time() - sent);
+#endif
+#if CONFIG_UBIRCH_BREAKER
+    ubirch_breaker_result(CONFIG_UBIRCH_BACKEND_DATA_URL, err != UBIRCH_ANCHOR_RETRY);
+#endif
+    return err;
+}
+
+/*!
+ * Delay before the retry, which follows \p failures failed attempts.
+ *
+ * The delay doubles with every failure and is drawn from its upper half,
+ * so gateways, which lost the backend at the same time, do not retry in step.
+ */
+static uint32_t anchor_retry_delay_ms(uint32_t failures) {
+    uint32_t delay_ms = CONFIG_UBIRCH_ANCHOR_RETRY_DELAY_MS;
+    for (uint32_t i = 1; i < failures && delay_ms < CONFIG_UBIRCH_ANCHOR_RETRY_MAX_DELAY_MS; ++i) {
+        delay_ms *= 2;
+    }
+    delay_ms = MIN(delay_ms, CONFIG_UBIRCH_ANCHOR_RETRY_MAX_DELAY_MS);
+    return delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+}
+
+/*!
+ * Send a UPP and repeat it up to \p retries times after transient failures.
+ *
+ * The retries stop early, when the circuit of the backend opened, as they
+ * would fail at once.
+ *
+ * @return ESP_OK, UBIRCH_ANCHOR_RETRY, UBIRCH_ANCHOR_REJECTED or UBIRCH_ANCHOR_UNVERIFIED
+ */
+static esp_err_t anchor_deliver(const ubirch_anchor_upp_t *upp, int *http_status, msgpack_unpacker *unpacker,
+        ubirch_protocol_check verifier, uint32_t retries) {
+    esp_err_t err;
+    for (uint32_t attempt = 1;; ++attempt) {
+        err = anchor_post(upp, http_status, unpacker, verifier);
+        if (err != UBIRCH_ANCHOR_RETRY || attempt > retries) {
+            break;
+        }
+#if CONFIG_UBIRCH_BREAKER
+        if (ubirch_breaker_state(CONFIG_UBIRCH_BACKEND_DATA_URL) != UBIRCH_BREAKER_CLOSED) {
+            break;
+        }
+#endif
+        uint32_t delay_ms = anchor_retry_delay_ms(attempt);
+        ESP_LOGW("UBIRCH SEND", " attempt %u failed, retry in %u ms", (unsigned int)attempt, (unsigned int)delay_ms);
+        ANCHOR_COUNT(retries, 1);
+        ubirch_anchor_unpacker_reset(unpacker);
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+    }
+
+    switch (err) {
+        case ESP_OK:
+            ANCHOR_COUNT(delivered, 1);
             break;
-        case UBIRCH_SEND_VERIFICATION_FAILED:
+        case UBIRCH_ANCHOR_REJECTED:
+            ANCHOR_COUNT(rejected, 1);
+            break;
+        case UBIRCH_ANCHOR_UNVERIFIED:
+            ANCHOR_COUNT(unverified, 1);
+            break;
+        default:
+            break;
+    }
+    return err;
+}
+
+/*!
+ * Send a UPP to the backend and handle the (verified) response.
+ *
+ * @param retries number of retries after transient failures
+ * @return ESP_OK, UBIRCH_ANCHOR_RETRY, UBIRCH_ANCHOR_REJECTED or UBIRCH_ANCHOR_UNVERIFIED
+ */
+static esp_err_t anchor_send(const ubirch_anchor_upp_t *upp, msgpack_unpacker *unpacker, uint32_t retries) {
+    int http_status;
+    esp_err_t err = anchor_deliver(upp, &http_status, unpacker, ed25519_verify_backend_response, retries);
+    switch (err) {
+        case ESP_OK:
+        case UBIRCH_ANCHOR_REJECTED:
+            anchor_response_status(http_status, unpacker);
+            break;
+        case UBIRCH_ANCHOR_UNVERIFIED:
             ESP_LOGW("UBIRCH SEND", " response signature not verifiable, http status of response: %d", http_status);
             break;
         default:
-            ESP_LOGE("UBIRCH_SEND", " ubirch_send failed");
+            ESP_LOGW("UBIRCH SEND", " UPP not delivered, http status of response: %d", http_status);
+            break;
+    }
+    return err;
+}
+
+#if !CONFIG_UBIRCH_HTTP_KEEP_ALIVE && (CONFIG_UBIRCH_OFFLINE_QUEUE || CONFIG_UBIRCH_ANCHOR_PENDING > 0)
+/*!
+ * Make the ID context of \p upp the current context, which ubirch_send() needs.
+ */
+static esp_err_t anchor_activate(const ubirch_anchor_upp_t *upp) {
+    if (ubirch_id_cache_activate(upp->short_name) != ESP_OK) {
+        ESP_LOGE(__func__, "context \"%s\" not available, UPP dropped", upp->short_name);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+#endif
+
+esp_err_t ubirch_anchor_init(void) {
+    if (protocol == NULL) {
+#if CONFIG_UBIRCH_FAST_SIGN
+        if (ubirch_signer_init() != ESP_OK) {
+            ESP_LOGE(__func__, "signer not available, UPPs are signed with ed25519_sign()");
+        }
+        protocol = ubirch_protocol_new(UUID, ubirch_signer_sign);
+#else
+        protocol = ubirch_protocol_new(UUID, ed25519_sign);
+#endif
+        msgpack_sbuffer_init(&payload_buffer);
+    }
+    if (receiver == NULL) {
+        receiver = msgpack_unpacker_new(128);
+    }
+    if (stats_lock == NULL) {
+        stats_lock = UBIRCH_MUTEX_CREATE(stats_lock);
+    }
+    return (protocol != NULL && receiver != NULL && stats_lock != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t ubirch_anchor_pack(const int32_t *values, uint16_t num, const char **payload, size_t *len) {
+    if (protocol == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    anchor_pack_values(values, num);
+    *payload = payload_buffer.data;
+    *len = payload_buffer.size;
+    return ESP_OK;
+}
+
+void ubirch_anchor_unpacker_reset(msgpack_unpacker *unpacker) {
+    if (unpacker == NULL) {
+        return;
+    }
+    // drop the old response, the next response is appended, or the buffer
+    // is rewound without allocation, when it is reserved for the next response
+    msgpack_unpacker_reset(unpacker);
+    unpacker->off = unpacker->used;
+}
+
+esp_err_t ubirch_anchor_sign(int32_t* values, uint16_t num, ubirch_anchor_upp_t *out) {
+    if (protocol == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    anchor_pack_values(values, num);
+    return ubirch_anchor_sign_payload(payload_buffer.data, payload_buffer.size, out);
+}
+
+esp_err_t ubirch_anchor_sign_payload(const char *payload, size_t len, ubirch_anchor_upp_t *out) {
+    if (protocol == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // reset the protocol context, it keeps its buffer, and set the current UUID
+    protocol->size = 0;
+    memcpy(protocol->uuid, UUID, UBIRCH_PROTOCOL_UUID_SIZE);
+
+    UBIRCH_METRICS_SPAN(message);
+    esp_err_t err = anchor_message(protocol, payload, len);
+    UBIRCH_METRICS_STOP(UBIRCH_METRICS_MESSAGE, message);
+    if (err == ESP_OK && protocol->size > UBIRCH_ANCHOR_UPP_MAX_SIZE) {
+        ESP_LOGE(__func__, "UPP too large: %u", (unsigned int)protocol->size);
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    memcpy(out->data, protocol->data, protocol->size);
+    out->size = (uint16_t)protocol->size;
+    if (stats_lock != NULL) {
+        xSemaphoreTake(stats_lock, portMAX_DELAY);
+    }
+    stats.upps++;
+    stats.upp_bytes += protocol->size;
+    stats.payload_bytes += len;
+    if (stats_lock != NULL) {
+        xSemaphoreGive(stats_lock);
+    }
+    UBIRCH_METRICS_COUNT(UBIRCH_METRICS_UPPS, 1);
+
+    // keep the credentials, to send the UPP independent of the current context
+    const char *short_name = ubirch_id_cache_current();
+    memset(out->short_name, 0, UBIRCH_ANCHOR_SHORT_NAME_SIZE);
+    if (short_name != NULL) {
+        strncpy(out->short_name, short_name, UBIRCH_ANCHOR_SHORT_NAME_SIZE - 1);
+    }
+    memcpy(out->uuid, UUID, sizeof(out->uuid));
+    char *password = NULL;
+    size_t password_len = 0;
+    out->password_len = 0;
+    if (ubirch_password_get(&password, &password_len) == ESP_OK
+            && password_len <= UBIRCH_ANCHOR_PASSWORD_SIZE) {
+        memcpy(out->password, password, password_len);
+        out->password_len = (uint8_t)password_len;
+    }
+    return ESP_OK;
+}
+
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+esp_err_t ubirch_anchor_transmit(const ubirch_anchor_upp_t *upp, int *http_status,
+        msgpack_unpacker *unpacker) {
+    // the response is verified later, by ubirch_anchor_response_handle()
+    return anchor_deliver(upp, http_status, unpacker, NULL, CONFIG_UBIRCH_ANCHOR_RETRIES);
+}
+#endif
+
+void ubirch_anchor_stats_get(ubirch_anchor_stats_t *out) {
+    if (stats_lock != NULL) {
+        xSemaphoreTake(stats_lock, portMAX_DELAY);
+    }
+    memcpy(out, &stats, sizeof(ubirch_anchor_stats_t));
+    if (stats_lock != NULL) {
+        xSemaphoreGive(stats_lock);
+    }
+}
+
+void ubirch_anchor_stats_log(uint32_t samples) {
+    if (samples == 0) {
+        return;
+    }
+    ubirch_anchor_stats_t current;
+    ubirch_anchor_stats_get(&current);
+    uint32_t milli_signatures = (uint32_t)(((uint64_t)current.upps * 1000) / samples);
+    ESP_LOGI(__func__, "%u samples in %u UPPs: %u.%03u signatures, %u UPP bytes, %u payload bytes per sample",
+            (unsigned int)samples, (unsigned int)current.upps,
+            (unsigned int)(milli_signatures / 1000), (unsigned int)(milli_signatures % 1000),
+            (unsigned int)(current.upp_bytes / samples), (unsigned int)(current.payload_bytes / samples));
+}
+
+esp_err_t ubirch_anchor_response_handle(int http_status, msgpack_unpacker *unpacker) {
+    if (http_status >= 200 && http_status < 300
+            && ubirch_protocol_verify(unpacker->buffer + unpacker->off, unpacker->used - unpacker->off,
+                    ed25519_verify_backend_response) != 0) {
+        ESP_LOGW("UBIRCH SEND", " response signature not verifiable, http status of response: %d", http_status);
+        return ESP_FAIL;
+    }
+    anchor_response_status(http_status, unpacker);
+    return ESP_OK;
+}
+
+#if CONFIG_UBIRCH_VERIFY_BATCH
+esp_err_t ubirch_anchor_responses_handle(const int *http_status, msgpack_unpacker *const *unpackers, size_t count) {
+    static ubirch_verify_item_t items[CONFIG_UBIRCH_VERIFY_BATCH_SIZE];
+    size_t item_index[CONFIG_UBIRCH_VERIFY_BATCH_SIZE];
+    size_t item_count = 0;
+    esp_err_t err = ESP_OK;
+
+    if (count > CONFIG_UBIRCH_VERIFY_BATCH_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // only successful responses are signed
+    for (size_t i = 0; i < count; ++i) {
+        item_index[i] = SIZE_MAX;
+        if (http_status[i] >= 200 && http_status[i] < 300
+                && ubirch_verify_item_collect(&items[item_count], unpackers[i]->buffer + unpackers[i]->off,
+                        unpackers[i]->used - unpackers[i]->off) == ESP_OK) {
+            item_index[i] = item_count++;
+        }
+    }
+    ubirch_verify_batch(items, item_count, server_pub_key);
+
+    // the responses are parsed only after their signatures are verified
+    for (size_t i = 0; i < count; ++i) {
+        if (http_status[i] >= 200 && http_status[i] < 300 && item_index[i] == SIZE_MAX) {
+            // not packed like the responses of the backend, the protocol finds the signature
+            if (ubirch_anchor_response_handle(http_status[i], unpackers[i]) != ESP_OK) {
+                err = ESP_FAIL;
+            }
+            continue;
+        }
+        if (http_status[i] >= 200 && http_status[i] < 300 && !items[item_index[i]].valid) {
+            ESP_LOGW("UBIRCH SEND", " response signature not verifiable, http status of response: %d",
+                    http_status[i]);
+            err = ESP_FAIL;
+            continue;
+        }
+        anchor_response_status(http_status[i], unpackers[i]);
+    }
+    return err;
+}
+#endif
+
+/*!
+ * Keep a UPP, which could not be delivered, for a later attempt, in the
+ * offline queue or with the pending UPPs.
+ *
+ * @return ESP_OK if the UPP is kept, UBIRCH_ANCHOR_RETRY if it is lost
+ */
+static esp_err_t anchor_hand_off(const ubirch_anchor_upp_t *upp) {
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+    if (queue_ready && ubirch_queue_push(upp->short_name, upp, UBIRCH_ANCHOR_UPP_USED_SIZE(upp)) == ESP_OK) {
+        ANCHOR_COUNT(handed_off, 1);
+        return ESP_OK;
+    }
+#elif CONFIG_UBIRCH_ANCHOR_PENDING > 0
+    if (pending_count < CONFIG_UBIRCH_ANCHOR_PENDING) {
+        memcpy(&pending[(pending_first + pending_count) % CONFIG_UBIRCH_ANCHOR_PENDING], upp,
+                UBIRCH_ANCHOR_UPP_USED_SIZE(upp));
+        if (pending_count++ == 0) {
+            pending_failures = 1;
+            pending_due = esp_timer_get_time() + (int64_t)anchor_retry_delay_ms(pending_failures) * 1000;
+        }
+        ANCHOR_COUNT(handed_off, 1);
+        return ESP_OK;
+    }
+#endif
+    ESP_LOGE(__func__, "UPP of \"%s\" not delivered, dropped", upp->short_name);
+    ANCHOR_COUNT(dropped, 1);
+    return UBIRCH_ANCHOR_RETRY;
+}
+
+/*!
+ * Send a UPP with retries, and keep it for later if the backend is not available.
+ */
+static esp_err_t anchor_send_or_keep(const ubirch_anchor_upp_t *upp) {
+#if !CONFIG_UBIRCH_OFFLINE_QUEUE && CONFIG_UBIRCH_ANCHOR_PENDING > 0
+    if (pending_count > 0) {
+        // the chain is delivered in order, so the UPP waits behind the pending ones
+        return anchor_hand_off(upp);
+    }
+#endif
+    esp_err_t err = anchor_send(upp, receiver, CONFIG_UBIRCH_ANCHOR_RETRIES);
+    ubirch_anchor_unpacker_reset(receiver);
+    if (err == UBIRCH_ANCHOR_RETRY) {
+        err = anchor_hand_off(upp);
+    }
+    return err;
+}
+
+esp_err_t ubirch_anchor_data(int32_t* values, uint16_t num) {
+    anchor_pack_values(values, num);
+    return ubirch_anchor_data_payload(payload_buffer.data, payload_buffer.size);
+}
+
+esp_err_t ubirch_anchor_data_payload(const char *payload, size_t len) {
+    static ubirch_anchor_upp_t upp; //!< send buffer
+
+    esp_err_t err = ubirch_anchor_sign_payload(payload, len, &upp);
+    if (err == ESP_OK) {
+        err = anchor_send_or_keep(&upp);
+    }
+    return err;
+}
+
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+/*!
+ * Restore the chain of the ID context of a queued UPP.
+ *
+ * The records are replayed in the order they were written, so after the
+ * replay every context continues with the signature of its last UPP, even
+ * if this was not yet written back to NVS before a reboot. This is only
+ * needed without the journal, which has these signatures already and the
+ * ones of later UPPs as well.
+ */
+static void queue_replay(const char *short_name, const void *data, size_t len) {
+    // the signature is the last element of the UPP, which is the end of the record
+    if (len < offsetof(ubirch_anchor_upp_t, data) + UBIRCH_PROTOCOL_SIGN_SIZE) {
+        return;
+    }
+    if (ubirch_id_cache_activate(short_name) != ESP_OK) {
+        ESP_LOGW(__func__, "context \"%s\" of queued UPP not found", short_name);
+        return;
+    }
+    const unsigned char *signature = (const unsigned char *)data + len - UBIRCH_PROTOCOL_SIGN_SIZE;
+    if (ubirch_previous_signature_set(signature, UBIRCH_PROTOCOL_SIGN_SIZE) == ESP_OK) {
+        ubirch_id_cache_commit(NULL, true);
+    }
+}
+
+esp_err_t ubirch_anchor_queue_init(void) {
+#if CONFIG_UBIRCH_JOURNAL
+    // the journal was replayed before, the queue would only set the chains back
+    ubirch_queue_replay_cb replay = ubirch_journal_ready() ? NULL : queue_replay;
+#else
+    ubirch_queue_replay_cb replay = queue_replay;
+#endif
+    // before delivered UPPs are erased, their signatures have to be in NVS
+    esp_err_t err = ubirch_queue_init(replay, ubirch_id_cache_flush);
+    if (err != ESP_OK) {
+        ESP_LOGE(__func__, "offline queue not available, UPPs are sent directly");
+        return err;
+    }
+    queue_ready = true;
+    return ubirch_id_cache_flush();
+}
+
+esp_err_t ubirch_anchor_enqueue(int32_t* values, uint16_t num) {
+    anchor_pack_values(values, num);
+    return ubirch_anchor_enqueue_payload(payload_buffer.data, payload_buffer.size);
+}
+
+esp_err_t ubirch_anchor_enqueue_payload(const char *payload, size_t len) {
+    static ubirch_anchor_upp_t upp;
+
+    if (!queue_ready || ubirch_id_cache_current() == NULL) {
+        return ubirch_anchor_data_payload(payload, len);
+    }
+
+    // keep the previous signature, to undo the chain step if the queue is full
+    unsigned char *prev_sig = NULL;
+    size_t prev_sig_len = 0;
+    unsigned char chain_head[UBIRCH_PROTOCOL_SIGN_SIZE];
+    if (ubirch_previous_signature_get(&prev_sig, &prev_sig_len) != ESP_OK
+            || prev_sig_len != UBIRCH_PROTOCOL_SIGN_SIZE) {
+        return ESP_FAIL;
+    }
+    memcpy(chain_head, prev_sig, UBIRCH_PROTOCOL_SIGN_SIZE);
+
+    esp_err_t err = ubirch_anchor_sign_payload(payload, len, &upp);
+    if (err == ESP_OK) {
+        // the record keeps the credentials, so it can be sent without activating the context
+        err = ubirch_queue_push(upp.short_name, &upp, UBIRCH_ANCHOR_UPP_USED_SIZE(&upp));
+        if (err != ESP_OK) {
+            ESP_LOGE(__func__, "failed to queue UPP (%s)", esp_err_to_name(err));
+            ubirch_previous_signature_set(chain_head, UBIRCH_PROTOCOL_SIGN_SIZE);
+            ubirch_id_cache_commit(NULL, true);
+        }
+    }
+    return err;
+}
+
+esp_err_t ubirch_anchor_queue_peek(size_t index, ubirch_anchor_upp_t *upp) {
+    static char short_name[UBIRCH_QUEUE_SHORT_NAME_SIZE];
+    static char record[UBIRCH_QUEUE_MAX_RECORD_SIZE];
+    size_t len = 0;
+
+    if (!queue_ready) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = ubirch_queue_peek(index, short_name, record, &len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (len < offsetof(ubirch_anchor_upp_t, data) || len > sizeof(ubirch_anchor_upp_t)) {
+        ESP_LOGE(__func__, "invalid UPP record of \"%s\", dropped", short_name);
+        ubirch_queue_pop(index);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(upp, record, len);
+    if (UBIRCH_ANCHOR_UPP_USED_SIZE(upp) != len) {
+        ESP_LOGE(__func__, "invalid UPP record of \"%s\", dropped", short_name);
+        ubirch_queue_pop(index);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ubirch_anchor_queue_forward(size_t max) {
+    static ubirch_anchor_upp_t upp;
+
+    for (size_t i = 0; i < max; ++i) {
+#if CONFIG_UBIRCH_RATE_CONTROL
+        // end the burst, the main loop continues it when the next UPP is due
+        if (ubirch_rate_control_send_delay_ms() > 0) {
+            break;
+        }
+#endif
+        esp_err_t err = ubirch_anchor_queue_peek(0, &upp);
+        if (err == ESP_ERR_INVALID_SIZE) {
+            continue;
+        } else if (err != ESP_OK) {
             break;
+        }
+#if !CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+        if (anchor_activate(&upp) != ESP_OK) {
+            ubirch_queue_pop(0);
+            continue;
+        }
+#endif
+        // the queue is the retry, so a failed UPP is not repeated here
+        err = anchor_send(&upp, receiver, 0);
+        ubirch_anchor_unpacker_reset(receiver);
+        if (err == UBIRCH_ANCHOR_RETRY) {
+            // keep the UPP, the backend is not available
+            return err;
+        }
+        // delivered, or refused for good
+        ubirch_queue_pop(0);
+    }
+    return ESP_OK;
+}
+#endif // CONFIG_UBIRCH_OFFLINE_QUEUE
+
+#if CONFIG_UBIRCH_ANCHOR_PENDING > 0
+int32_t ubirch_anchor_pending_timeout_ms(void) {
+    if (pending_count == 0) {
+        return -1;
     }
-    ubirch_protocol_free(upp);
-    msgpack_unpacker_free(unpacker);
+    int64_t remaining_ms = (pending_due - esp_timer_get_time() + 999) / 1000;
+    return (remaining_ms > 0) ? (int32_t)remaining_ms : 0;
+}
 
+esp_err_t ubirch_anchor_pending_forward(void) {
+    while (pending_count > 0) {
+        const ubirch_anchor_upp_t *upp = &pending[pending_first];
+        esp_err_t err = ESP_OK;
+#if !CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+        err = anchor_activate(upp);
+#endif
+        if (err == ESP_OK) {
+            err = anchor_send(upp, receiver, 0);
+            ubirch_anchor_unpacker_reset(receiver);
+            if (err == UBIRCH_ANCHOR_RETRY) {
+                pending_failures++;
+                pending_due = esp_timer_get_time() + (int64_t)anchor_retry_delay_ms(pending_failures) * 1000;
+                return err;
+            }
+        }
+        pending_first = (pending_first + 1) % CONFIG_UBIRCH_ANCHOR_PENDING;
+        pending_count--;
+        pending_failures = 0;
+    }
     return ESP_OK;
 }
+#endif // CONFIG_UBIRCH_ANCHOR_PENDING > 0
@@ -26,20 +26,288 @@
 #ifndef EXAMPLE_ESP32_ANCHOR_H
 #define EXAMPLE_ESP32_ANCHOR_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <msgpack.h>
+
+#define UBIRCH_ANCHOR_SHORT_NAME_SIZE 16
+#define UBIRCH_ANCHOR_PASSWORD_SIZE 48
+#define UBIRCH_ANCHOR_UPP_MAX_SIZE 256
+
+/*!
+ * The UPP was not delivered, but a later attempt can succeed: the backend
+ * was not reachable, answered with 408, 429 or 5xx, or its circuit is open.
+ */
+#define UBIRCH_ANCHOR_RETRY ESP_ERR_TIMEOUT
+
+/*!
+ * The backend refused the UPP with a 4xx status, sending it again does not help.
+ */
+#define UBIRCH_ANCHOR_REJECTED ESP_ERR_INVALID_RESPONSE
+
+/*!
+ * The backend accepted the UPP, but the signature of its response is not valid.
+ */
+#define UBIRCH_ANCHOR_UNVERIFIED ESP_ERR_INVALID_CRC
+
+/*!
+ * Signed UPP together with the credentials of its ID context.
+ *
+ * It can be sent without its ID context being the current context of
+ * the key storage, so signing and sending can happen in different tasks.
+ * The data is the last member, only the used part has to be stored.
+ */
+typedef struct {
+    char short_name[UBIRCH_ANCHOR_SHORT_NAME_SIZE];
+    unsigned char uuid[16];
+    char password[UBIRCH_ANCHOR_PASSWORD_SIZE];
+    uint8_t password_len;
+    uint16_t size;
+    char data[UBIRCH_ANCHOR_UPP_MAX_SIZE];
+} ubirch_anchor_upp_t;
+
+/*!
+ * Number of bytes of \p upp, which have to be stored to keep it.
+ */
+#define UBIRCH_ANCHOR_UPP_USED_SIZE(upp) (offsetof(ubirch_anchor_upp_t, data) + (upp)->size)
+
+/*!
+ * Statistics of the signed UPPs.
+ */
+typedef struct {
+    uint32_t upps;              //!< signed UPPs (signatures)
+    uint64_t upp_bytes;         //!< size of all signed UPPs, which are sent to the backend
+    uint64_t payload_bytes;     //!< size of all anchored payloads, of which the hash is in the UPP
+    uint32_t delivered;         //!< UPPs accepted by the backend
+    uint32_t retries;           //!< repeated attempts after transient failures
+    uint32_t rejected;          //!< UPPs refused by the backend
+    uint32_t unverified;        //!< UPPs accepted with a response, which is not verifiable
+    uint32_t handed_off;        //!< UPPs kept for a later attempt
+    uint32_t dropped;           //!< UPPs lost after transient failures
+} ubirch_anchor_stats_t;
+
+/*!
+ * Allocate the protocol context and the receive unpacker, which are
+ * reused for all messages, so anchoring does not allocate memory.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_anchor_init(void);
+
+/*!
+ * Drop the response in \p unpacker, so it can receive the next response
+ * without new allocation.
+ *
+ * @param unpacker the unpacker to reuse
+ */
+void ubirch_anchor_unpacker_reset(msgpack_unpacker *unpacker);
+
+/*!
+ * Pack the timestamp and the values into the payload, which is anchored
+ * by the value functions, e.g. ubirch_anchor_data().
+ *
+ * The payload stays valid until the next call of this function, or of
+ * one of the value functions.
+ *
+ * @param values Array fo 32-bit integers
+ * @param num Length of values array
+ * @param[out] payload the packed data
+ * @param[out] len length of the packed data
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE before ubirch_anchor_init()
+ */
+esp_err_t ubirch_anchor_pack(const int32_t *values, uint16_t num, const char **payload, size_t *len);
+
 /*!
  * Create UPP from array of 32-bit integers and send the UPP (including
  * a hash value of your data) to the ubirch backend.
  *
  * This is an example implementation of how to create and send requests
- * to the ubirch backend. Information about the response is logged but
- * not properly handled (the function always returns ESP_OK).
- * The implementation and the error handling should be adapted to your
- * needs and the data you want to anchor.
+ * to the ubirch backend. After transient failures the UPP is sent again,
+ * up to CONFIG_UBIRCH_ANCHOR_RETRIES times with a growing delay. If it
+ * still could not be delivered, it is kept in the offline queue, or with
+ * the pending UPPs, see ubirch_anchor_pending_forward().
+ *
+ * The new previous signature is handed to the ID context cache, see
+ * ubirch_id_cache_commit().
  *
  * @param values Array fo 32-bit integers
  * @param num Length of values array
- * @return ESP_OK
+ * @return ESP_OK if the UPP was delivered or kept for a later attempt,
+ *         UBIRCH_ANCHOR_RETRY if it was lost, UBIRCH_ANCHOR_REJECTED,
+ *         UBIRCH_ANCHOR_UNVERIFIED, or ESP_FAIL if the UPP could not be created
  */
 esp_err_t ubirch_anchor_data(int32_t* values, uint16_t num);
 
+/*!
+ * Like ubirch_anchor_data(), but for a payload, which is already packed.
+ *
+ * @param payload the data, of which the hash is anchored
+ * @param len length of the payload
+ * @return see ubirch_anchor_data()
+ */
+esp_err_t ubirch_anchor_data_payload(const char *payload, size_t len);
+
+/*!
+ * Create UPP from array of 32-bit integers with the current ID context.
+ *
+ * The UPP is chained to the previous UPP of the context, the new previous
+ * signature is handed to the ID context cache, see ubirch_id_cache_commit().
+ *
+ * @param values Array fo 32-bit integers
+ * @param num Length of values array
+ * @param[out] upp the signed UPP and the credentials of the current context
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before ubirch_anchor_init(),
+ *         or ESP_FAIL if the UPP could not be created
+ */
+esp_err_t ubirch_anchor_sign(int32_t* values, uint16_t num, ubirch_anchor_upp_t *upp);
+
+/*!
+ * Like ubirch_anchor_sign(), but for a payload, which is already packed.
+ *
+ * @param payload the data, of which the hash is anchored
+ * @param len length of the payload
+ * @param[out] upp the signed UPP and the credentials of the current context
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before ubirch_anchor_init(),
+ *         or ESP_FAIL if the UPP could not be created
+ */
+esp_err_t ubirch_anchor_sign_payload(const char *payload, size_t len, ubirch_anchor_upp_t *upp);
+
+/*!
+ * Get a copy of the statistics of the signed UPPs.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_anchor_stats_get(ubirch_anchor_stats_t *stats);
+
+/*!
+ * Log the signatures and bytes per sample, to compare the payload modes.
+ *
+ * @param samples number of sensor samples, which are anchored in the UPPs
+ */
+void ubirch_anchor_stats_log(uint32_t samples);
+
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+/*!
+ * Send a signed UPP to the ubirch backend, without handling the response.
+ *
+ * The credentials of the UPP are used, the current ID context is neither
+ * used nor changed, so this can be called from another task than the
+ * one signing UPPs. The response is checked with ubirch_anchor_response_handle().
+ * With CONFIG_UBIRCH_RATE_CONTROL the call waits, until the UPP is due.
+ *
+ * Transient failures are retried like in ubirch_anchor_data().
+ *
+ * @param upp the signed UPP
+ * @param[out] http_status the http status of the response
+ * @param[in,out] unpacker the unpacker, which receives the response
+ * @return ESP_OK, UBIRCH_ANCHOR_RETRY if the UPP was not delivered,
+ *         or UBIRCH_ANCHOR_REJECTED if the backend refused it
+ */
+esp_err_t ubirch_anchor_transmit(const ubirch_anchor_upp_t *upp, int *http_status,
+        msgpack_unpacker *unpacker);
+#endif
+
+/*!
+ * Verify the response to a UPP with the backend key and log its content.
+ *
+ * @param http_status the http status of the response
+ * @param unpacker the unpacker, which contains the response
+ * @return ESP_OK, or ESP_FAIL if the response signature is not verifiable
+ */
+esp_err_t ubirch_anchor_response_handle(int http_status, msgpack_unpacker *unpacker);
+
+#if CONFIG_UBIRCH_VERIFY_BATCH
+/*!
+ * Verify the responses to several UPPs in one batch and log their content.
+ *
+ * The responses are handled like with ubirch_anchor_response_handle(), in
+ * their order, after all signatures are verified.
+ *
+ * @param http_status the http status of every response
+ * @param unpackers the unpackers, which contain the responses
+ * @param count number of responses, at most CONFIG_UBIRCH_VERIFY_BATCH_SIZE
+ * @return ESP_OK, ESP_FAIL if a response signature is not verifiable,
+ *         or ESP_ERR_INVALID_SIZE if there are too many responses
+ */
+esp_err_t ubirch_anchor_responses_handle(const int *http_status, msgpack_unpacker *const *unpackers, size_t count);
+#endif
+
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+/*!
+ * Initialize the offline queue and restore the chains of all ID contexts
+ * with UPPs in the queue.
+ *
+ * @return ESP_OK, or error code if the queue is not available
+ */
+esp_err_t ubirch_anchor_queue_init(void);
+
+/*!
+ * Create UPP from array of 32-bit integers and store it in the offline queue.
+ *
+ * The UPP is signed with the current ID context and stays in the queue
+ * until it was delivered with ubirch_anchor_queue_forward(). If the queue
+ * is not available, the UPP is sent directly with ubirch_anchor_data().
+ *
+ * @param values Array fo 32-bit integers
+ * @param num Length of values array
+ * @return ESP_OK, or error code if the UPP could not be created or stored
+ */
+esp_err_t ubirch_anchor_enqueue(int32_t* values, uint16_t num);
+
+/*!
+ * Like ubirch_anchor_enqueue(), but for a payload, which is already packed.
+ */
+esp_err_t ubirch_anchor_enqueue_payload(const char *payload, size_t len);
+
+/*!
+ * Send up to \p max UPPs from the offline queue to the ubirch backend.
+ *
+ * Sending stops at the first UPP, which could not be delivered, this UPP
+ * stays in the queue, and with CONFIG_UBIRCH_RATE_CONTROL when the next
+ * UPP is not yet due. Without CONFIG_UBIRCH_HTTP_KEEP_ALIVE the current
+ * ID context is changed by this function.
+ *
+ * UPPs, which the backend refused, are removed from the queue.
+ *
+ * @param max maximum number of UPPs to send
+ * @return ESP_OK, or UBIRCH_ANCHOR_RETRY if the backend is not available
+ */
+esp_err_t ubirch_anchor_queue_forward(size_t max);
+
+/*!
+ * Read a UPP of the offline queue, without removing it.
+ *
+ * The UPP is removed with ubirch_queue_pop() after it was delivered.
+ * An invalid record is removed at once.
+ *
+ * @param index position of the UPP in the queue, 0 is the oldest
+ * @param[out] upp the queued UPP
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE if the record was invalid,
+ *         or ESP_ERR_NOT_FOUND if there are not more than \p index UPPs
+ */
+esp_err_t ubirch_anchor_queue_peek(size_t index, ubirch_anchor_upp_t *upp);
+#endif
+
+#if CONFIG_UBIRCH_ANCHOR_PENDING > 0
+/*!
+ * Get the time until the next attempt to send the pending UPPs.
+ *
+ * @return -1 if no UPP is pending, remaining time in ms otherwise
+ */
+int32_t ubirch_anchor_pending_timeout_ms(void);
+
+/*!
+ * Send the pending UPPs, which could not be delivered before, in the
+ * order they were signed.
+ *
+ * Sending stops at the first UPP, which fails again, its next attempt is
+ * delayed further. Without CONFIG_UBIRCH_HTTP_KEEP_ALIVE the current ID
+ * context is changed by this function.
+ *
+ * @return ESP_OK, or UBIRCH_ANCHOR_RETRY if the backend is not available
+ */
+esp_err_t ubirch_anchor_pending_forward(void);
+#endif
+
 #endif //EXAMPLE_ESP32_ANCHOR_H
@@ -0,0 +1,274 @@
+/*!
+ * @file binlog.c
+ * @brief Compile-time log levels and a binary log ring for the anchoring.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_cpu.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+
+#include "binlog.h"
+#include "budget.h"
+
+#if CONFIG_UBIRCH_BINLOG
+
+static const char *TAG = "binlog";
+
+#define BINLOG_MASK (CONFIG_UBIRCH_BINLOG_RECORDS - 1)
+_Static_assert((CONFIG_UBIRCH_BINLOG_RECORDS & BINLOG_MASK) == 0, "the number of records must be a power of two");
+
+// fixed part of a printed record: index, ticks, cycles, format, tag, level, core, argc, string length
+#define BINLOG_HEADER_SIZE 24
+#define BINLOG_LINE_SIZE (2 * (BINLOG_HEADER_SIZE + 4 * UBIRCH_BINLOG_ARGS + UBIRCH_BINLOG_STR_SIZE) + 1)
+
+/*!
+ * Record in the ring.
+ */
+typedef struct {
+    uint32_t seq;               //!< index of the record + 1, written last, 0 while it is written
+    uint32_t ticks;
+    uint32_t cycles;
+    const char *format;
+    const char *tag;
+    uint8_t level;
+    uint8_t core;
+    uint8_t argc;
+    uint8_t str_len;
+    uint32_t args[UBIRCH_BINLOG_ARGS];
+    char str[UBIRCH_BINLOG_STR_SIZE];
+} binlog_record_t;
+
+static binlog_record_t ring[CONFIG_UBIRCH_BINLOG_RECORDS];
+static uint32_t head = 0;       //!< index of the next record to write
+static uint32_t tail = 0;       //!< index of the next record to print
+static SemaphoreHandle_t flush_lock = NULL;
+UBIRCH_SEMAPHORE_DEFINE(flush_lock);
+UBIRCH_TASK_DEFINE(binlog_task, 3072);
+static ubirch_binlog_stats_t stats = { 0 };
+
+// format strings and tags, which were printed already
+static const char *strings[CONFIG_UBIRCH_BINLOG_STRINGS];
+static size_t string_count = 0;
+
+void ubirch_binlog_write(esp_log_level_t level, const char *tag, const char *format, const char *str,
+        uint32_t argc, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+    uint32_t index = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+    binlog_record_t *record = &ring[index & BINLOG_MASK];
+    // invalidate the record, before its content is overwritten
+    __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    record->ticks = xTaskGetTickCount();
+    record->cycles = esp_cpu_get_ccount();
+    record->format = format;
+    record->tag = tag;
+    record->level = (uint8_t)level;
+    record->core = (uint8_t)xPortGetCoreID();
+    record->argc = (uint8_t)((argc < UBIRCH_BINLOG_ARGS) ? argc : UBIRCH_BINLOG_ARGS);
+    record->args[0] = a0;
+    record->args[1] = a1;
+    record->args[2] = a2;
+    record->args[3] = a3;
+    record->str_len = 0;
+    if (str != NULL) {
+        // the end of a long string is kept, the sensor ids often start alike
+        size_t len = strlen(str);
+        if (len > UBIRCH_BINLOG_STR_SIZE - 1) {
+            str += len - (UBIRCH_BINLOG_STR_SIZE - 2);
+            len = UBIRCH_BINLOG_STR_SIZE - 2;
+            record->str[record->str_len++] = '~';
+        }
+        memcpy(&record->str[record->str_len], str, len);
+        record->str_len += (uint8_t)len;
+    }
+    __atomic_store_n(&record->seq, index + 1, __ATOMIC_RELEASE);
+}
+
+/*!
+ * Append \p len bytes of \p value as little-endian hex.
+ */
+static char *hex_put(char *out, uint32_t value, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; ++i, value >>= 8) {
+        *out++ = digits[(value >> 4) & 0xf];
+        *out++ = digits[value & 0xf];
+    }
+    return out;
+}
+
+/*!
+ * Print a format string or tag the first time, so the decoder knows it.
+ */
+static void string_print(const char *string) {
+    for (size_t i = 0; i < string_count; ++i) {
+        if (strings[i] == string) {
+            return;
+        }
+    }
+    // when the table is full, the strings are printed again with every record
+    if (string_count < CONFIG_UBIRCH_BINLOG_STRINGS) {
+        strings[string_count++] = string;
+    }
+    stats.strings++;
+    ESP_LOGI(TAG, "s %08x %s", (unsigned int)(uintptr_t)string, string);
+}
+
+/*!
+ * Print a record as hex, the layout is documented in binlog_decode.py.
+ */
+static void record_print(uint32_t index, const binlog_record_t *record) {
+    string_print(record->tag);
+    string_print(record->format);
+
+    char line[BINLOG_LINE_SIZE];
+    char *out = line;
+    out = hex_put(out, index, 4);
+    out = hex_put(out, record->ticks, 4);
+    out = hex_put(out, record->cycles, 4);
+    out = hex_put(out, (uint32_t)(uintptr_t)record->format, 4);
+    out = hex_put(out, (uint32_t)(uintptr_t)record->tag, 4);
+    out = hex_put(out, record->level, 1);
+    out = hex_put(out, record->core, 1);
+    out = hex_put(out, record->argc, 1);
+    out = hex_put(out, record->str_len, 1);
+    for (uint8_t i = 0; i < record->argc; ++i) {
+        out = hex_put(out, record->args[i], 4);
+    }
+    for (uint8_t i = 0; i < record->str_len; ++i) {
+        out = hex_put(out, (uint8_t)record->str[i], 1);
+    }
+    *out = '\0';
+    ESP_LOGI(TAG, "r %s", line);
+    stats.printed++;
+}
+
+void ubirch_binlog_flush(void) {
+    if (flush_lock != NULL) {
+        xSemaphoreTake(flush_lock, portMAX_DELAY);
+    }
+    uint32_t end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    if (end - tail > CONFIG_UBIRCH_BINLOG_RECORDS) {
+        uint32_t lost = end - tail - CONFIG_UBIRCH_BINLOG_RECORDS;
+        stats.lost += lost;
+        tail = end - CONFIG_UBIRCH_BINLOG_RECORDS;
+        ESP_LOGW(TAG, "lost %u records", (unsigned int)lost);
+    }
+    // records, which were overwritten while they were printed
+    uint32_t overwritten = 0;
+    while (tail != end) {
+        binlog_record_t *slot = &ring[tail & BINLOG_MASK];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq != tail + 1) {
+            if (seq != 0 && (int32_t)(seq - (tail + 1)) > 0) {
+                // a writer went round the ring
+                overwritten++;
+                tail++;
+                continue;
+            }
+            // the record is still written, it is printed with the next flush
+            break;
+        }
+        binlog_record_t copy = *slot;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) {
+            overwritten++;
+        } else {
+            record_print(tail, &copy);
+        }
+        tail++;
+    }
+    if (overwritten > 0) {
+        stats.lost += overwritten;
+        ESP_LOGW(TAG, "lost %u records", (unsigned int)overwritten);
+    }
+    if (flush_lock != NULL) {
+        xSemaphoreGive(flush_lock);
+    }
+}
+
+/*!
+ * Print the log ring periodically, with a low priority.
+ */
+static void binlog_task(void __unused *pvParameters) {
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_UBIRCH_BINLOG_FLUSH_MS));
+        ubirch_binlog_flush();
+    }
+}
+
+esp_err_t ubirch_binlog_start(void) {
+    if (flush_lock != NULL) {
+        return ESP_OK;
+    }
+    flush_lock = UBIRCH_MUTEX_CREATE(flush_lock);
+    if (flush_lock == NULL
+            || UBIRCH_TASK_CREATE(binlog_task, &binlog_task, "binlog", 1, NULL, tskNO_AFFINITY) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to create the log task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void ubirch_binlog_stats_get(ubirch_binlog_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_binlog_stats_t));
+    out->written = __atomic_load_n(&head, __ATOMIC_RELAXED);
+}
+
+#if CONFIG_UBIRCH_BINLOG_BENCHMARK
+
+#define BINLOG_BENCHMARK_MESSAGES 32
+
+void ubirch_binlog_benchmark(void) {
+    static const char *sensor = "test_alpha";
+    // the statements of the anchoring of one message, formatted and printed, this takes too long for the cycles
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BINLOG_BENCHMARK_MESSAGES; ++i) {
+        ESP_LOGI(TAG, "sensor (%s): %u values received", sensor, 3u);
+        ESP_LOGI("UBIRCH SEND", " to " CONFIG_UBIRCH_BACKEND_DATA_URL " , len: %d", 187);
+        ESP_LOGI("UBIRCH SEND", " http status of response: %d", 200);
+    }
+    int64_t esp_log_us = esp_timer_get_time() - start;
+
+    // the same statements into the log ring
+    start = esp_timer_get_time();
+    uint32_t cycles = esp_cpu_get_ccount();
+    for (int i = 0; i < BINLOG_BENCHMARK_MESSAGES; ++i) {
+        ubirch_binlog_write(ESP_LOG_INFO, TAG, "sensor (%s): %u values received", sensor, 1, 3u, 0, 0, 0);
+        ubirch_binlog_write(ESP_LOG_INFO, "UBIRCH SEND", " to " CONFIG_UBIRCH_BACKEND_DATA_URL " , len: %d", NULL,
+                1, 187, 0, 0, 0);
+        ubirch_binlog_write(ESP_LOG_INFO, "UBIRCH SEND", " http status of response: %d", NULL, 1, 200, 0, 0, 0);
+    }
+    cycles = esp_cpu_get_ccount() - cycles;
+    int64_t binlog_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "per message: ESP_LOG %u us, log ring %u ns (%u cycles)",
+            (unsigned int)(esp_log_us / BINLOG_BENCHMARK_MESSAGES),
+            (unsigned int)(binlog_us * 1000 / BINLOG_BENCHMARK_MESSAGES),
+            (unsigned int)(cycles / BINLOG_BENCHMARK_MESSAGES));
+}
+
+#endif // CONFIG_UBIRCH_BINLOG_BENCHMARK
+
+#endif // CONFIG_UBIRCH_BINLOG
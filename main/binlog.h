@@ -0,0 +1,159 @@
+/*!
+ * @file binlog.h
+ * @brief Compile-time log levels and a binary log ring for the anchoring.
+ *
+ * The log statements of the anchoring, which run for every message, use the
+ * UBIRCH_LOGx() macros instead of ESP_LOGx(). Statements above the level of
+ * the file are removed at compile time, a file sets its own level by
+ * defining UBIRCH_LOG_LOCAL_LEVEL before it includes this header.
+ *
+ * With CONFIG_UBIRCH_BINLOG, a log statement does not format its message.
+ * It writes a record with the address of the format string and up to four
+ * integer arguments into a ring in RAM, which takes a few hundred cycles.
+ * A low-priority task prints the records as hex later, together with every
+ * format string and tag once. binlog_decode.py formats them on the host:
+ * ```
+ * I (12345) binlog: s 3f40a1b0 UBIRCH SEND
+ * I (12345) binlog: r 2a000000e8030000...
+ * ```
+ * The arguments are passed as 32 bit integers, so only integer conversions
+ * (%d, %u, %x, %c, ...) and pointers (%p) can be used. A string, e.g. the
+ * sensor id, is copied into the record with UBIRCH_LOG_STR(), it has to be
+ * the first argument of the format. Records up to
+ * CONFIG_UBIRCH_BINLOG_ECHO_LEVEL, by default errors and warnings, are also
+ * printed at once with ESP_LOG.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_BINLOG_H
+#define EXAMPLE_ESP32_BINLOG_H
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_log.h>
+
+#ifndef UBIRCH_LOG_LOCAL_LEVEL
+#define UBIRCH_LOG_LOCAL_LEVEL CONFIG_UBIRCH_LOG_LEVEL
+#endif
+
+#define UBIRCH_BINLOG_ARGS 4            //!< maximum number of integer arguments of a record
+#define UBIRCH_BINLOG_STR_SIZE 24       //!< maximum length of the string of a record, with the terminating zero
+
+// number of arguments and the arguments padded to four, as 32 bit integers
+#define UBIRCH_LOG_ARGC_(x, a0, a1, a2, a3, n, ...) (n)
+#define UBIRCH_LOG_ARGS_(x, a0, a1, a2, a3, ...) \
+        (uint32_t)(uintptr_t)(a0), (uint32_t)(uintptr_t)(a1), (uint32_t)(uintptr_t)(a2), (uint32_t)(uintptr_t)(a3)
+
+#if CONFIG_UBIRCH_BINLOG
+#define UBIRCH_LOG(level, tag, format, ...) do {                                                    \
+        if (UBIRCH_LOG_LOCAL_LEVEL >= (level)) {                                                    \
+            ubirch_binlog_write((level), (tag), (format), NULL,                                     \
+                    UBIRCH_LOG_ARGC_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0),                              \
+                    UBIRCH_LOG_ARGS_(0, ##__VA_ARGS__, 0, 0, 0, 0));                                \
+            if (CONFIG_UBIRCH_BINLOG_ECHO_LEVEL >= (level)) {                                       \
+                ESP_LOG_LEVEL_LOCAL((level), (tag), format, ##__VA_ARGS__);                         \
+            }                                                                                       \
+        }                                                                                           \
+    } while (0)
+#define UBIRCH_LOG_STR(level, tag, format, str, ...) do {                                           \
+        if (UBIRCH_LOG_LOCAL_LEVEL >= (level)) {                                                    \
+            ubirch_binlog_write((level), (tag), (format), (str),                                    \
+                    UBIRCH_LOG_ARGC_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0),                              \
+                    UBIRCH_LOG_ARGS_(0, ##__VA_ARGS__, 0, 0, 0, 0));                                \
+            if (CONFIG_UBIRCH_BINLOG_ECHO_LEVEL >= (level)) {                                       \
+                ESP_LOG_LEVEL_LOCAL((level), (tag), format, (str), ##__VA_ARGS__);                  \
+            }                                                                                       \
+        }                                                                                           \
+    } while (0)
+#else
+#define UBIRCH_LOG(level, tag, format, ...) do {                                                    \
+        if (UBIRCH_LOG_LOCAL_LEVEL >= (level)) {                                                    \
+            ESP_LOG_LEVEL_LOCAL((level), (tag), format, ##__VA_ARGS__);                             \
+        }                                                                                           \
+    } while (0)
+#define UBIRCH_LOG_STR(level, tag, format, str, ...) UBIRCH_LOG(level, tag, format, (str), ##__VA_ARGS__)
+#endif
+
+#define UBIRCH_LOGE(tag, format, ...) UBIRCH_LOG(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define UBIRCH_LOGW(tag, format, ...) UBIRCH_LOG(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define UBIRCH_LOGI(tag, format, ...) UBIRCH_LOG(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define UBIRCH_LOGD(tag, format, ...) UBIRCH_LOG(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define UBIRCH_LOGV(tag, format, ...) UBIRCH_LOG(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+/*!
+ * @brief Hexdump a buffer, if the level is enabled at compile time.
+ */
+#define UBIRCH_LOG_BUFFER_HEXDUMP(tag, buffer, length, level) do {                                  \
+        if (UBIRCH_LOG_LOCAL_LEVEL >= (level)) {                                                    \
+            ESP_LOG_BUFFER_HEXDUMP((tag), (buffer), (length), (level));                             \
+        }                                                                                           \
+    } while (0)
+
+/*!
+ * Statistics of the log ring.
+ */
+typedef struct {
+    uint32_t written;           //!< records written
+    uint32_t printed;           //!< records printed
+    uint32_t lost;              //!< records overwritten before they were printed
+    uint32_t strings;           //!< format strings and tags printed
+} ubirch_binlog_stats_t;
+
+/*!
+ * @brief Write a record into the log ring, use the UBIRCH_LOGx() macros instead.
+ *
+ * @param[in] level the log level of the record
+ * @param[in] tag the tag, it has to stay valid, e.g. a string literal
+ * @param[in] format the format string, it has to stay valid, e.g. a string literal
+ * @param[in] str a string, which is copied into the record, or NULL
+ * @param[in] argc the number of integer arguments
+ */
+void ubirch_binlog_write(esp_log_level_t level, const char *tag, const char *format, const char *str,
+        uint32_t argc, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+/*!
+ * @brief Start the task, which prints the log ring periodically.
+ *
+ * Records are written into the ring also before, they are kept until the
+ * ring is full.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t ubirch_binlog_start(void);
+
+/*!
+ * @brief Print all records of the log ring, e.g. before a restart.
+ */
+void ubirch_binlog_flush(void);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_binlog_stats_get(ubirch_binlog_stats_t *stats);
+
+/*!
+ * @brief Compare the time of logging a message with ESP_LOG and with the log ring.
+ *
+ * Logs the same statements as the anchoring of one message, first with
+ * ESP_LOG, as it is printed on the console, then into the log ring.
+ */
+void ubirch_binlog_benchmark(void);
+
+#endif /* EXAMPLE_ESP32_BINLOG_H */
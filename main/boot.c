@@ -0,0 +1,284 @@
+/*!
+ * @file boot.c
+ * @brief Fast start to the first anchored message, with a boot timeline.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+#include <sys/time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <networking.h>
+
+#include "budget.h"
+#include "id_cache.h"
+#include "boot.h"
+
+#if CONFIG_UBIRCH_FAST_BOOT
+
+#include <nvs.h>
+
+static const char *TAG = "boot";
+
+#define BOOT_NVS_NAMESPACE "boot"
+#define BOOT_NVS_KEY_TIME "time"
+#define BOOT_NVS_KEY_CONTEXTS "contexts"
+#define BOOT_SHORT_NAME_SIZE 16
+#define BOOT_PREFETCH MIN(CONFIG_UBIRCH_FAST_BOOT_PREFETCH, CONFIG_UBIRCH_ID_CACHE_SIZE)
+#define BOOT_CLOCK_VALID 1483228800     // 2017-01-01, contexts are not created before
+#define BOOT_CLOCK_JUMP_S 2             // a change of the clock against the timer, which is a synchronization
+#define BOOT_POLL_MS 1000
+#define BOOT_TASK_PRIORITY 1
+
+static const char *step_names[UBIRCH_BOOT_STEPS] = {
+        "NVS ready",
+        "clock restored",
+        "keys loaded",
+        "contexts prefetched",
+        "anchoring ready",
+        "network up",
+        "clock synced",
+        "first reading",
+        "first UPP anchored",
+};
+
+static ubirch_boot_timeline_t timeline = { 0 };
+static int64_t clock_offset = 0;        //!< wall clock - timer (s) of the provisional clock, 0 if there is none
+// the most recently cached context first
+static char recent[MAX(BOOT_PREFETCH, 1)][BOOT_SHORT_NAME_SIZE];
+static size_t recent_count = 0;
+static bool recent_changed = false;
+static SemaphoreHandle_t recent_lock = NULL;
+static TaskHandle_t boot_task_handle = NULL;
+UBIRCH_SEMAPHORE_DEFINE(recent_lock);
+UBIRCH_TASK_DEFINE(boot_task, 3072);
+
+static void timeline_log(void) {
+    ESP_LOGI(TAG, "first UPP anchored %u ms after the start", timeline.at_ms[UBIRCH_BOOT_FIRST_ANCHORED]);
+    for (size_t step = 0; step < UBIRCH_BOOT_STEPS; ++step) {
+        if (timeline.at_ms[step] != 0) {
+            ESP_LOGI(TAG, "%8u ms  %s", timeline.at_ms[step], step_names[step]);
+        } else {
+            ESP_LOGI(TAG, "       -     %s", step_names[step]);
+        }
+    }
+}
+
+void ubirch_boot_mark(ubirch_boot_step_t step) {
+    // the first readings and responses pass here, so a step, which is marked, is only read
+    if (__atomic_load_n(&timeline.at_ms[step], __ATOMIC_RELAXED) != 0) {
+        return;
+    }
+    uint32_t expected = 0;
+    uint32_t now = MAX((uint32_t)(esp_timer_get_time() / 1000), 1);
+    if (__atomic_compare_exchange_n(&timeline.at_ms[step], &expected, now, false,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED) && step == UBIRCH_BOOT_FIRST_ANCHORED) {
+        timeline_log();
+    }
+}
+
+esp_err_t ubirch_boot_clock_restore(void) {
+    time_t now = time(NULL);
+    if (now >= BOOT_CLOCK_VALID) {
+        // kept over a restart, it is synchronized again like a provisional clock
+        clock_offset = now - esp_timer_get_time() / 1000000;
+        return ESP_OK;
+    }
+    nvs_handle_t handle;
+    if (nvs_open(BOOT_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    int64_t stored = 0;
+    esp_err_t err = nvs_get_i64(handle, BOOT_NVS_KEY_TIME, &stored);
+    nvs_close(handle);
+    if (err != ESP_OK || stored < BOOT_CLOCK_VALID) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    struct timeval tv = { .tv_sec = (time_t)stored, .tv_usec = 0 };
+    if (settimeofday(&tv, NULL) != 0) {
+        return ESP_FAIL;
+    }
+    clock_offset = stored - esp_timer_get_time() / 1000000;
+    timeline.restored_time = stored;
+    ubirch_boot_mark(UBIRCH_BOOT_CLOCK_RESTORED);
+    ESP_LOGI(TAG, "provisional clock from the stored time %lld", (long long)stored);
+    return ESP_OK;
+}
+
+size_t ubirch_boot_contexts_prefetch(void) {
+    char names[MAX(BOOT_PREFETCH, 1)][BOOT_SHORT_NAME_SIZE];
+    size_t size = sizeof(names);
+    nvs_handle_t handle;
+    if (BOOT_PREFETCH == 0 || nvs_open(BOOT_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        ubirch_boot_mark(UBIRCH_BOOT_CONTEXTS_PREFETCHED);
+        return 0;
+    }
+    esp_err_t err = nvs_get_blob(handle, BOOT_NVS_KEY_CONTEXTS, names, &size);
+    nvs_close(handle);
+    size_t count = (err == ESP_OK) ? size / BOOT_SHORT_NAME_SIZE : 0;
+
+    // the most recent one last, so it ends up at the front of the remembered contexts again
+    size_t loaded = 0;
+    for (size_t i = count; i-- > 0;) {
+        names[i][BOOT_SHORT_NAME_SIZE - 1] = '\0';
+        if (ubirch_id_cache_activate(names[i]) == ESP_OK) {
+            loaded++;
+        } else {
+            ESP_LOGW(TAG, "context \"%s\" not found", names[i]);
+        }
+    }
+    timeline.prefetched = loaded;
+    ubirch_boot_mark(UBIRCH_BOOT_CONTEXTS_PREFETCHED);
+    ESP_LOGI(TAG, "%u of %u recently used contexts loaded", (unsigned int)loaded, (unsigned int)count);
+    return loaded;
+}
+
+void ubirch_boot_context_cached(const char *short_name) {
+    if (BOOT_PREFETCH == 0 || recent_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(recent_lock, portMAX_DELAY);
+    size_t i = 0;
+    while (i < recent_count && strncmp(recent[i], short_name, BOOT_SHORT_NAME_SIZE) != 0) {
+        i++;
+    }
+    if (i == recent_count && recent_count < BOOT_PREFETCH) {
+        recent_count++;
+    }
+    // move the entries before it, or all, if it is new, one back
+    memmove(recent[1], recent[0], MIN(i, recent_count - 1) * BOOT_SHORT_NAME_SIZE);
+    memset(recent[0], 0, BOOT_SHORT_NAME_SIZE);
+    strncpy(recent[0], short_name, BOOT_SHORT_NAME_SIZE - 1);
+    recent_changed = true;
+    xSemaphoreGive(recent_lock);
+}
+
+/*!
+ * Store the time, if the clock is set, and the recently used contexts, if they changed.
+ */
+static void state_store(void) {
+    time_t now = time(NULL);
+    char names[MAX(BOOT_PREFETCH, 1)][BOOT_SHORT_NAME_SIZE];
+    size_t count = 0;
+    if (recent_lock != NULL) {
+        xSemaphoreTake(recent_lock, portMAX_DELAY);
+        if (recent_changed) {
+            count = recent_count;
+            memcpy(names, recent, count * BOOT_SHORT_NAME_SIZE);
+            recent_changed = false;
+        }
+        xSemaphoreGive(recent_lock);
+    }
+    if (now < BOOT_CLOCK_VALID && count == 0) {
+        return;
+    }
+    nvs_handle_t handle;
+    if (nvs_open(BOOT_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "failed to open the NVS");
+        return;
+    }
+    esp_err_t err = ESP_OK;
+    if (now >= BOOT_CLOCK_VALID) {
+        err = nvs_set_i64(handle, BOOT_NVS_KEY_TIME, (int64_t)now);
+    }
+    if (err == ESP_OK && count > 0) {
+        err = nvs_set_blob(handle, BOOT_NVS_KEY_CONTEXTS, names, count * BOOT_SHORT_NAME_SIZE);
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "failed to store the time and the contexts");
+    }
+}
+
+/*!
+ * @return true, if SNTP set the clock
+ */
+static bool clock_synced(void) {
+    time_t now = time(NULL);
+    if (clock_offset == 0) {
+        return now >= BOOT_CLOCK_VALID;
+    }
+    // the provisional clock runs with the timer, until the synchronization changes it
+    int64_t offset = now - esp_timer_get_time() / 1000000;
+    return llabs(offset - clock_offset) >= BOOT_CLOCK_JUMP_S;
+}
+
+static void boot_shutdown(void) {
+    state_store();
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-noreturn"
+
+static void boot_task(void __unused *pvParameters) {
+    TickType_t last_store = xTaskGetTickCount();
+    for (;;) {
+        bool starting = timeline.at_ms[UBIRCH_BOOT_NETWORK_UP] == 0 || timeline.at_ms[UBIRCH_BOOT_CLOCK_SYNCED] == 0;
+        vTaskDelay(pdMS_TO_TICKS(starting ? BOOT_POLL_MS : CONFIG_UBIRCH_FAST_BOOT_SAVE_S * 1000));
+
+        if (xEventGroupGetBits(network_event_group) & (WIFI_CONNECTED_BIT | NETWORK_ETH_READY)) {
+            ubirch_boot_mark(UBIRCH_BOOT_NETWORK_UP);
+        }
+        bool synced = timeline.at_ms[UBIRCH_BOOT_CLOCK_SYNCED] == 0 && clock_synced();
+        if (synced) {
+            ubirch_boot_mark(UBIRCH_BOOT_CLOCK_SYNCED);
+            ESP_LOGI(TAG, "clock synchronized");
+        }
+        // the synchronized time is stored at once, a provisional one is kept going
+        if (synced || xTaskGetTickCount() - last_store >= pdMS_TO_TICKS(CONFIG_UBIRCH_FAST_BOOT_SAVE_S * 1000)) {
+            state_store();
+            last_store = xTaskGetTickCount();
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+esp_err_t ubirch_boot_start(void) {
+    recent_lock = UBIRCH_MUTEX_CREATE(recent_lock);
+    if (recent_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (esp_register_shutdown_handler(boot_shutdown) != ESP_OK) {
+        ESP_LOGW(TAG, "failed to register shutdown handler");
+    }
+    if (UBIRCH_TASK_CREATE(boot_task, &boot_task, "boot", BOOT_TASK_PRIORITY, &boot_task_handle,
+            tskNO_AFFINITY) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void ubirch_boot_timeline_get(ubirch_boot_timeline_t *out) {
+    memcpy(out, &timeline, sizeof(ubirch_boot_timeline_t));
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*!
+ * @file boot.h
+ * @brief Fast start to the first anchored message, with a boot timeline.
+ *
+ * The start does not wait for the Wifi: it connects in its own task, while
+ * the keys and the token are loaded and the anchoring is set up, and the
+ * SNTP task waits for the network in the background. NVS is initialized
+ * first, as the keys and the Wifi need it.
+ *
+ * Until the SNTP synchronization, the last stored time is used as a
+ * provisional clock, so contexts can be created and UPPs get a plausible
+ * timestamp. The time is stored after the synchronization, every
+ * CONFIG_UBIRCH_FAST_BOOT_SAVE_S and before a restart.
+ *
+ * The contexts, which were loaded into the ID context cache last, are
+ * stored with the time and loaded again at the next start, before the
+ * first reading arrives.
+ *
+ * Every step of the start is marked with its time since the start, once.
+ * The timeline is logged, when the first UPP is accepted by the backend.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_BOOT_H
+#define EXAMPLE_ESP32_BOOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * Steps of the start, in their usual order.
+ */
+typedef enum {
+    UBIRCH_BOOT_NVS_READY,              //!< NVS initialized
+    UBIRCH_BOOT_CLOCK_RESTORED,         //!< provisional clock set from the stored time
+    UBIRCH_BOOT_KEYS_LOADED,            //!< backend key and token loaded
+    UBIRCH_BOOT_CONTEXTS_PREFETCHED,    //!< recently used contexts loaded into the cache
+    UBIRCH_BOOT_ANCHOR_READY,           //!< anchoring set up, readings are processed
+    UBIRCH_BOOT_NETWORK_UP,             //!< Wifi or Ethernet connected
+    UBIRCH_BOOT_CLOCK_SYNCED,           //!< time set by SNTP
+    UBIRCH_BOOT_FIRST_READING,          //!< first reading of a sensor committed
+    UBIRCH_BOOT_FIRST_ANCHORED,         //!< first UPP accepted by the backend
+    UBIRCH_BOOT_STEPS
+} ubirch_boot_step_t;
+
+/*!
+ * Timeline of the start.
+ */
+typedef struct {
+    uint32_t at_ms[UBIRCH_BOOT_STEPS];  //!< time of every step since the start, 0 if not (yet) reached
+    int64_t restored_time;              //!< stored time used as provisional clock, 0 if none
+    uint32_t prefetched;                //!< contexts loaded before the first reading
+} ubirch_boot_timeline_t;
+
+#if CONFIG_UBIRCH_FAST_BOOT
+#define UBIRCH_BOOT_MARK(step) ubirch_boot_mark(step)
+#else
+#define UBIRCH_BOOT_MARK(step)
+#endif
+
+/*!
+ * @brief Mark the first time of \p step, later marks of the step are ignored.
+ *
+ * The mark of UBIRCH_BOOT_FIRST_ANCHORED logs the timeline.
+ */
+void ubirch_boot_mark(ubirch_boot_step_t step);
+
+/*!
+ * @brief Set the clock to the stored time, if it is not set.
+ *
+ * Has to be called after the initialization of NVS.
+ *
+ * @return ESP_OK if the clock is set, ESP_ERR_NOT_FOUND if there is no stored time
+ */
+esp_err_t ubirch_boot_clock_restore(void);
+
+/*!
+ * @brief Load the stored recently used contexts into the ID context cache.
+ *
+ * Has to be called after ubirch_id_cache_init(), before the readings are processed.
+ *
+ * @return the number of contexts loaded
+ */
+size_t ubirch_boot_contexts_prefetch(void);
+
+/*!
+ * @brief Remember a context, which was loaded into the ID context cache.
+ *
+ * Called by the ID context cache, the last CONFIG_UBIRCH_FAST_BOOT_PREFETCH
+ * contexts are stored for the next start.
+ */
+void ubirch_boot_context_cached(const char *short_name);
+
+/*!
+ * @brief Start the task, which marks the network and the clock synchronization
+ * and stores the time and the recently used contexts.
+ */
+esp_err_t ubirch_boot_start(void);
+
+/*!
+ * @brief Get a copy of the timeline.
+ *
+ * @param[out] timeline pointer to the timeline to fill
+ */
+void ubirch_boot_timeline_get(ubirch_boot_timeline_t *timeline);
+
+#endif /* EXAMPLE_ESP32_BOOT_H */
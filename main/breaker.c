@@ -0,0 +1,170 @@
+/*!
+ * @file breaker.c
+ * @brief Circuit breaker per backend URL.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+
+#include "breaker.h"
+#include "budget.h"
+
+#if CONFIG_UBIRCH_BREAKER
+
+static const char *TAG = "breaker";
+
+/*!
+ * Circuit of one backend URL.
+ */
+typedef struct {
+    const char *url;
+    ubirch_breaker_state_t state;
+    uint32_t failures;          //!< consecutive transient failures
+    uint32_t open_ms;           //!< duration of the current open state
+    int64_t open_until;
+} breaker_circuit_t;
+
+static breaker_circuit_t circuits[CONFIG_UBIRCH_BREAKER_ENDPOINTS];
+static SemaphoreHandle_t breaker_lock = NULL;
+UBIRCH_SEMAPHORE_DEFINE(breaker_lock);
+static ubirch_breaker_stats_t stats = { 0 };
+
+/*!
+ * Find the circuit of \p url, or create it if \p create is set.
+ */
+static breaker_circuit_t *circuit_find(const char *url, bool create) {
+    for (size_t i = 0; i < stats.endpoints; ++i) {
+        if (circuits[i].url == url || strcmp(circuits[i].url, url) == 0) {
+            return &circuits[i];
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    if (stats.endpoints >= CONFIG_UBIRCH_BREAKER_ENDPOINTS) {
+        ESP_LOGW(TAG, "no circuit left for %s", url);
+        return NULL;
+    }
+    breaker_circuit_t *circuit = &circuits[stats.endpoints++];
+    memset(circuit, 0, sizeof(breaker_circuit_t));
+    circuit->url = url;
+    circuit->open_ms = CONFIG_UBIRCH_BREAKER_OPEN_MS;
+    return circuit;
+}
+
+/*!
+ * Open the circuit, the open time doubles with every failed probe.
+ */
+static void circuit_open(breaker_circuit_t *circuit, int64_t now) {
+    if (circuit->state == UBIRCH_BREAKER_HALF_OPEN) {
+        circuit->open_ms = (circuit->open_ms < CONFIG_UBIRCH_BREAKER_OPEN_MAX_MS / 2)
+                ? circuit->open_ms * 2 : CONFIG_UBIRCH_BREAKER_OPEN_MAX_MS;
+    } else {
+        stats.open++;
+        stats.trips++;
+    }
+    circuit->state = UBIRCH_BREAKER_OPEN;
+    circuit->open_until = now + (int64_t)circuit->open_ms * 1000;
+    ESP_LOGW(TAG, "%s open for %u ms after %u failures", circuit->url, (unsigned int)circuit->open_ms,
+            (unsigned int)circuit->failures);
+}
+
+esp_err_t ubirch_breaker_init(void) {
+    memset(circuits, 0, sizeof(circuits));
+    memset(&stats, 0, sizeof(stats));
+
+    breaker_lock = UBIRCH_MUTEX_CREATE(breaker_lock);
+    return (breaker_lock != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+bool ubirch_breaker_allow(const char *url) {
+    if (breaker_lock == NULL) {
+        return true;
+    }
+    bool allow = true;
+    xSemaphoreTake(breaker_lock, portMAX_DELAY);
+    breaker_circuit_t *circuit = circuit_find(url, true);
+    if (circuit != NULL && circuit->state != UBIRCH_BREAKER_CLOSED) {
+        if (circuit->state == UBIRCH_BREAKER_OPEN && esp_timer_get_time() >= circuit->open_until) {
+            // this request is the probe, all others fail until its result is known
+            circuit->state = UBIRCH_BREAKER_HALF_OPEN;
+            stats.probes++;
+        } else {
+            stats.short_circuits++;
+            allow = false;
+        }
+    }
+    xSemaphoreGive(breaker_lock);
+    return allow;
+}
+
+void ubirch_breaker_result(const char *url, bool success) {
+    if (breaker_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(breaker_lock, portMAX_DELAY);
+    breaker_circuit_t *circuit = circuit_find(url, false);
+    if (circuit != NULL) {
+        if (success) {
+            if (circuit->state != UBIRCH_BREAKER_CLOSED) {
+                ESP_LOGI(TAG, "%s closed", circuit->url);
+                stats.open--;
+            }
+            circuit->state = UBIRCH_BREAKER_CLOSED;
+            circuit->failures = 0;
+            circuit->open_ms = CONFIG_UBIRCH_BREAKER_OPEN_MS;
+        } else {
+            circuit->failures++;
+            // results of requests, which were sent before the circuit opened, do not extend it
+            if (circuit->state == UBIRCH_BREAKER_HALF_OPEN
+                    || (circuit->state == UBIRCH_BREAKER_CLOSED
+                            && circuit->failures >= CONFIG_UBIRCH_BREAKER_FAILURES)) {
+                circuit_open(circuit, esp_timer_get_time());
+            }
+        }
+    }
+    xSemaphoreGive(breaker_lock);
+}
+
+ubirch_breaker_state_t ubirch_breaker_state(const char *url) {
+    if (breaker_lock == NULL) {
+        return UBIRCH_BREAKER_CLOSED;
+    }
+    xSemaphoreTake(breaker_lock, portMAX_DELAY);
+    breaker_circuit_t *circuit = circuit_find(url, false);
+    ubirch_breaker_state_t state = (circuit != NULL) ? circuit->state : UBIRCH_BREAKER_CLOSED;
+    xSemaphoreGive(breaker_lock);
+    return state;
+}
+
+void ubirch_breaker_stats_get(ubirch_breaker_stats_t *out) {
+    if (breaker_lock == NULL) {
+        memcpy(out, &stats, sizeof(ubirch_breaker_stats_t));
+        return;
+    }
+    xSemaphoreTake(breaker_lock, portMAX_DELAY);
+    memcpy(out, &stats, sizeof(ubirch_breaker_stats_t));
+    xSemaphoreGive(breaker_lock);
+}
+
+#endif // CONFIG_UBIRCH_BREAKER
@@ -0,0 +1,94 @@
+/*!
+ * @file breaker.h
+ * @brief Circuit breaker per backend URL.
+ *
+ * After a number of consecutive transient failures (no connection, 408, 429
+ * or 5xx) the circuit of a URL opens and requests to it fail at once, so an
+ * outage of the backend does not turn into a storm of retries. When the open
+ * time is over, a single probe request is let through: if it succeeds the
+ * circuit closes, if not it opens again for twice the time.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_BREAKER_H
+#define EXAMPLE_ESP32_BREAKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * State of the circuit of a URL.
+ */
+typedef enum {
+    UBIRCH_BREAKER_CLOSED = 0,      //!< requests are sent
+    UBIRCH_BREAKER_OPEN,            //!< requests fail at once
+    UBIRCH_BREAKER_HALF_OPEN,       //!< a probe request is in progress
+} ubirch_breaker_state_t;
+
+/*!
+ * Statistics of all circuits.
+ */
+typedef struct {
+    uint32_t endpoints;         //!< URLs with a circuit
+    uint32_t open;              //!< circuits, which are open or half open
+    uint32_t trips;             //!< times a circuit opened
+    uint32_t short_circuits;    //!< requests, which failed at once
+    uint32_t probes;            //!< probe requests of half open circuits
+} ubirch_breaker_stats_t;
+
+/*!
+ * @brief Initialize the circuits, all are closed.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_breaker_init(void);
+
+/*!
+ * @brief Check if a request to \p url may be sent.
+ *
+ * When the open time of the circuit is over, the first caller gets true
+ * and its request is the probe, which has to be reported with
+ * ubirch_breaker_result() like every other request.
+ *
+ * @param[in] url the backend url, it has to stay valid, e.g. a configured url
+ * @return true if the request may be sent
+ */
+bool ubirch_breaker_allow(const char *url);
+
+/*!
+ * @brief Report the result of a request to \p url.
+ *
+ * @param[in] url the backend url
+ * @param[in] success false if the request failed transiently, true otherwise
+ */
+void ubirch_breaker_result(const char *url, bool success);
+
+/*!
+ * @brief Get the state of the circuit of \p url, without probing it.
+ */
+ubirch_breaker_state_t ubirch_breaker_state(const char *url);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_breaker_stats_get(ubirch_breaker_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_BREAKER_H */
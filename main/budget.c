@@ -0,0 +1,203 @@
+/*!
+ * @file budget.c
+ * @brief RAM budget of the gateway, with the static allocation of its tasks and queues.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+
+#include "id_cache.h"
+#include "budget.h"
+
+static const char *TAG = "budget";
+
+#define BUDGET_STACK_WARN_DIVISOR 8     // a free stack below 1/8 of its size is logged as a warning
+
+/*!
+ * A watched task. The entries are only appended, the handle is set last, so
+ * the budget is read without a lock.
+ */
+typedef struct {
+    TaskHandle_t handle;            //!< NULL if the entry is not used (yet)
+    ubirch_budget_task_t task;
+} budget_entry_t;
+
+static budget_entry_t entries[UBIRCH_BUDGET_MAX_TASKS];
+static uint32_t entry_count = 0;
+static uint32_t static_bytes = 0;
+static uint32_t heap_bytes = 0;
+
+static void bytes_add(bool is_static, uint32_t bytes) {
+    __atomic_fetch_add(is_static ? &static_bytes : &heap_bytes, bytes, __ATOMIC_RELAXED);
+}
+
+static void task_watch(TaskHandle_t handle, const char *name, uint32_t stack_size, bool is_static) {
+    bytes_add(is_static, stack_size + sizeof(StaticTask_t));
+    uint32_t index = __atomic_fetch_add(&entry_count, 1, __ATOMIC_RELAXED);
+    if (index >= UBIRCH_BUDGET_MAX_TASKS) {
+        ESP_LOGW(TAG, "stack of task %s not watched", name);
+        return;
+    }
+    budget_entry_t *entry = &entries[index];
+    strncpy(entry->task.name, name, UBIRCH_BUDGET_NAME_SIZE - 1);
+    entry->task.stack_size = stack_size;
+    entry->task.is_static = is_static;
+    __atomic_store_n(&entry->handle, handle, __ATOMIC_RELEASE);
+}
+
+esp_err_t ubirch_budget_task_create(TaskFunction_t function, const char *name, uint32_t stack_size,
+        UBaseType_t priority, TaskHandle_t *handle, BaseType_t core, StackType_t *stack, StaticTask_t *tcb) {
+    TaskHandle_t created = NULL;
+#if CONFIG_UBIRCH_STATIC_ALLOCATION
+    if (stack != NULL) {
+        // the stack depth is in bytes on the ESP32
+        created = xTaskCreateStaticPinnedToCore(function, name, stack_size, NULL, priority, stack, tcb, core);
+    }
+#else
+    (void)tcb;
+#endif
+    if (stack == NULL
+            && xTaskCreatePinnedToCore(function, name, stack_size, NULL, priority, &created, core) != pdPASS) {
+        created = NULL;
+    }
+    if (handle != NULL) {
+        *handle = created;
+    }
+    if (created == NULL) {
+        ESP_LOGE(TAG, "failed to create task %s with %u bytes of stack", name, (unsigned int)stack_size);
+        return ESP_ERR_NO_MEM;
+    }
+    task_watch(created, name, stack_size, stack != NULL);
+    return ESP_OK;
+}
+
+void ubirch_budget_task_remove(TaskHandle_t task) {
+    uint32_t count = MIN(__atomic_load_n(&entry_count, __ATOMIC_RELAXED), UBIRCH_BUDGET_MAX_TASKS);
+    for (uint32_t i = 0; i < count; ++i) {
+        TaskHandle_t expected = task;
+        if (__atomic_compare_exchange_n(&entries[i].handle, &expected, NULL, false,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED) && !entries[i].task.is_static) {
+            // the stack of a dynamic task goes back to the heap
+            __atomic_fetch_sub(&heap_bytes, entries[i].task.stack_size + sizeof(StaticTask_t), __ATOMIC_RELAXED);
+        }
+    }
+}
+
+QueueHandle_t ubirch_budget_queue_create(UBaseType_t length, UBaseType_t item_size, uint8_t *storage,
+        StaticQueue_t *buffer) {
+    QueueHandle_t queue = NULL;
+#if CONFIG_UBIRCH_STATIC_ALLOCATION
+    if (buffer != NULL) {
+        queue = xQueueCreateStatic(length, item_size, storage, buffer);
+    }
+#else
+    (void)storage;
+#endif
+    if (buffer == NULL) {
+        queue = xQueueCreate(length, item_size);
+    }
+    if (queue != NULL) {
+        bytes_add(buffer != NULL, length * item_size + sizeof(StaticQueue_t));
+    }
+    return queue;
+}
+
+SemaphoreHandle_t ubirch_budget_mutex_create(StaticSemaphore_t *buffer) {
+    SemaphoreHandle_t mutex = NULL;
+#if CONFIG_UBIRCH_STATIC_ALLOCATION
+    if (buffer != NULL) {
+        mutex = xSemaphoreCreateMutexStatic(buffer);
+    }
+#endif
+    if (buffer == NULL) {
+        mutex = xSemaphoreCreateMutex();
+    }
+    if (mutex != NULL) {
+        bytes_add(buffer != NULL, sizeof(StaticSemaphore_t));
+    }
+    return mutex;
+}
+
+SemaphoreHandle_t ubirch_budget_counting_create(UBaseType_t max_count, UBaseType_t initial_count,
+        StaticSemaphore_t *buffer) {
+    SemaphoreHandle_t semaphore = NULL;
+#if CONFIG_UBIRCH_STATIC_ALLOCATION
+    if (buffer != NULL) {
+        semaphore = xSemaphoreCreateCountingStatic(max_count, initial_count, buffer);
+    }
+#endif
+    if (buffer == NULL) {
+        semaphore = xSemaphoreCreateCounting(max_count, initial_count);
+    }
+    if (semaphore != NULL) {
+        bytes_add(buffer != NULL, sizeof(StaticSemaphore_t));
+    }
+    return semaphore;
+}
+
+void ubirch_budget_get(ubirch_budget_t *budget) {
+    memset(budget, 0, sizeof(ubirch_budget_t));
+    uint32_t count = MIN(__atomic_load_n(&entry_count, __ATOMIC_RELAXED), UBIRCH_BUDGET_MAX_TASKS);
+    for (uint32_t i = 0; i < count; ++i) {
+        TaskHandle_t handle = __atomic_load_n(&entries[i].handle, __ATOMIC_ACQUIRE);
+        if (handle == NULL) {
+            continue;
+        }
+        ubirch_budget_task_t *task = &budget->tasks[budget->task_count++];
+        memcpy(task, &entries[i].task, sizeof(ubirch_budget_task_t));
+        // the high-water mark is in bytes on the ESP32
+        task->stack_free_min = (uint32_t)uxTaskGetStackHighWaterMark(handle);
+    }
+    budget->static_bytes = __atomic_load_n(&static_bytes, __ATOMIC_RELAXED);
+    budget->heap_bytes = __atomic_load_n(&heap_bytes, __ATOMIC_RELAXED);
+    budget->heap_free = esp_get_free_heap_size();
+    budget->heap_minimum_free = esp_get_minimum_free_heap_size();
+    budget->heap_largest_free = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+    budget->context_size = (uint32_t)ubirch_id_cache_entry_size();
+}
+
+void ubirch_budget_log(void) {
+    static ubirch_budget_t budget;
+    ubirch_budget_get(&budget);
+    ESP_LOGI(TAG, "%-12s %7s %10s", "task", "stack", "min free");
+    for (uint32_t i = 0; i < budget.task_count; ++i) {
+        const ubirch_budget_task_t *task = &budget.tasks[i];
+        if (task->stack_free_min < task->stack_size / BUDGET_STACK_WARN_DIVISOR) {
+            ESP_LOGW(TAG, "%-12s %7u %10u  nearly used up", task->name, (unsigned int)task->stack_size,
+                    (unsigned int)task->stack_free_min);
+        } else {
+            ESP_LOGI(TAG, "%-12s %7u %10u", task->name, (unsigned int)task->stack_size,
+                    (unsigned int)task->stack_free_min);
+        }
+    }
+    ESP_LOGI(TAG, "heap free %u (min %u, largest block %u), %u bytes static, %u bytes on the heap",
+            (unsigned int)budget.heap_free, (unsigned int)budget.heap_minimum_free,
+            (unsigned int)budget.heap_largest_free, (unsigned int)budget.static_bytes,
+            (unsigned int)budget.heap_bytes);
+    ESP_LOGI(TAG, "the lowest free heap takes %u more cached ID contexts (%u bytes each)",
+            (unsigned int)(budget.heap_minimum_free / budget.context_size), (unsigned int)budget.context_size);
+}
@@ -0,0 +1,175 @@
+/*!
+ * @file budget.h
+ * @brief RAM budget of the gateway, with the static allocation of its tasks and queues.
+ *
+ * The tasks, queues and mutexes of the gateway, which run as long as the
+ * gateway, are created with the functions below. With
+ * CONFIG_UBIRCH_STATIC_ALLOCATION, their stacks, control blocks and queue
+ * storage are reserved at link time, sized by the capacities configured in
+ * the Kconfig: the stack sizes, the sensor slots, the pipeline depth. A
+ * configuration, which does not fit, fails to link, instead of running out
+ * of heap with many sensors, and the heap is left to the network, TLS and
+ * the buffers, whose size is only known at run time. Without it, they are
+ * allocated on the heap like before.
+ *
+ * Every task created here is watched. The report shows its stack size and
+ * its lowest free stack (high-water mark), the free heap with its lowest
+ * value and largest block, and how many more ID contexts would fit into the
+ * lowest free heap:
+ * ```
+ * I (60123) budget: task          stack   min free
+ * I (60123) budget: sign           8192       3412
+ * ...
+ * I (60123) budget: heap free 96120 (min 81344, largest block 65524), 38912 bytes static, 0 bytes on the heap
+ * I (60123) budget: the lowest free heap takes 292 more cached ID contexts (278 bytes each)
+ * ```
+ * The host build measures the same under the load generator.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_BUDGET_H
+#define EXAMPLE_ESP32_BUDGET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#define UBIRCH_BUDGET_MAX_TASKS 24
+#define UBIRCH_BUDGET_NAME_SIZE 16
+
+/*
+ * UBIRCH_TASK_DEFINE() and UBIRCH_QUEUE_DEFINE() reserve the memory of a
+ * task or queue at file scope, in the static profile only, the matching
+ * _CREATE() creates it in this memory, or on the heap. UBIRCH_TASKS_DEFINE()
+ * reserves \p count tasks, which run the same function.
+ */
+#if CONFIG_UBIRCH_STATIC_ALLOCATION
+#define UBIRCH_TASK_DEFINE(task, stack_size) \
+        static StackType_t task##_stack[(stack_size) / sizeof(StackType_t)]; \
+        static StaticTask_t task##_tcb
+#define UBIRCH_TASK_CREATE(task, function, name, priority, handle, core) \
+        ubirch_budget_task_create((function), (name), sizeof(task##_stack), (priority), (handle), (core), \
+                task##_stack, &task##_tcb)
+#define UBIRCH_TASKS_DEFINE(task, count, stack_size) \
+        static StackType_t task##_stack[count][(stack_size) / sizeof(StackType_t)]; \
+        static StaticTask_t task##_tcb[count]
+#define UBIRCH_TASKS_CREATE(task, index, function, name, priority, handle, core) \
+        ubirch_budget_task_create((function), (name), sizeof(task##_stack[0]), (priority), (handle), (core), \
+                task##_stack[index], &task##_tcb[index])
+#define UBIRCH_QUEUE_DEFINE(queue, length, item_size) \
+        static uint8_t queue##_storage[(length) * (item_size)]; \
+        static StaticQueue_t queue##_buffer
+#define UBIRCH_QUEUE_CREATE(queue, length, item_size) \
+        ubirch_budget_queue_create((length), (item_size), queue##_storage, &queue##_buffer)
+#define UBIRCH_SEMAPHORE_DEFINE(semaphore) static StaticSemaphore_t semaphore##_buffer
+#define UBIRCH_MUTEX_CREATE(mutex) ubirch_budget_mutex_create(&mutex##_buffer)
+#define UBIRCH_COUNTING_CREATE(semaphore, max_count, initial_count) \
+        ubirch_budget_counting_create((max_count), (initial_count), &semaphore##_buffer)
+#else
+#define UBIRCH_TASK_DEFINE(task, stack_size) enum { task##_stack_size = (stack_size) }
+#define UBIRCH_TASK_CREATE(task, function, name, priority, handle, core) \
+        ubirch_budget_task_create((function), (name), task##_stack_size, (priority), (handle), (core), NULL, NULL)
+#define UBIRCH_TASKS_DEFINE(task, count, stack_size) enum { task##_stack_size = (stack_size) }
+#define UBIRCH_TASKS_CREATE(task, index, function, name, priority, handle, core) \
+        ubirch_budget_task_create((function), (name), task##_stack_size, (priority), (handle), (core), NULL, NULL)
+#define UBIRCH_QUEUE_DEFINE(queue, length, item_size) enum { queue##_static = 0 }
+#define UBIRCH_QUEUE_CREATE(queue, length, item_size) \
+        ubirch_budget_queue_create((length), (item_size), NULL, NULL)
+#define UBIRCH_SEMAPHORE_DEFINE(semaphore) enum { semaphore##_static = 0 }
+#define UBIRCH_MUTEX_CREATE(mutex) ubirch_budget_mutex_create(NULL)
+#define UBIRCH_COUNTING_CREATE(semaphore, max_count, initial_count) \
+        ubirch_budget_counting_create((max_count), (initial_count), NULL)
+#endif
+
+/*!
+ * Stack of a watched task.
+ */
+typedef struct {
+    char name[UBIRCH_BUDGET_NAME_SIZE];
+    uint32_t stack_size;        //!< bytes
+    uint32_t stack_free_min;    //!< lowest free stack in bytes (high-water mark)
+    bool is_static;
+} ubirch_budget_task_t;
+
+/*!
+ * RAM budget at one point in time.
+ */
+typedef struct {
+    ubirch_budget_task_t tasks[UBIRCH_BUDGET_MAX_TASKS];
+    uint32_t task_count;
+    uint32_t static_bytes;      //!< stacks, control blocks and queue storage reserved at link time
+    uint32_t heap_bytes;        //!< the same, allocated on the heap
+    uint32_t heap_free;
+    uint32_t heap_minimum_free; //!< lowest free heap since the start
+    uint32_t heap_largest_free; //!< largest free block
+    uint32_t context_size;      //!< RAM of one cached ID context
+} ubirch_budget_t;
+
+/*!
+ * @brief Create a task, which runs as long as the gateway, and watch its stack.
+ *
+ * The task gets no parameters.
+ *
+ * @param[in] stack_size stack size in bytes
+ * @param[out] handle handle of the task, may be NULL
+ * @param[in] core core to pin the task to, or tskNO_AFFINITY
+ * @param[in] stack stack of \p stack_size bytes, or NULL to allocate it on the heap, with \p tcb
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_budget_task_create(TaskFunction_t function, const char *name, uint32_t stack_size,
+        UBaseType_t priority, TaskHandle_t *handle, BaseType_t core, StackType_t *stack, StaticTask_t *tcb);
+
+/*!
+ * @brief Stop watching a task, which deletes itself.
+ */
+void ubirch_budget_task_remove(TaskHandle_t task);
+
+/*!
+ * @brief Create a queue, in \p storage and \p buffer, or on the heap if they are NULL.
+ */
+QueueHandle_t ubirch_budget_queue_create(UBaseType_t length, UBaseType_t item_size, uint8_t *storage,
+        StaticQueue_t *buffer);
+
+/*!
+ * @brief Create a mutex, in \p buffer, or on the heap if it is NULL.
+ */
+SemaphoreHandle_t ubirch_budget_mutex_create(StaticSemaphore_t *buffer);
+
+/*!
+ * @brief Create a counting semaphore, in \p buffer, or on the heap if it is NULL.
+ */
+SemaphoreHandle_t ubirch_budget_counting_create(UBaseType_t max_count, UBaseType_t initial_count,
+        StaticSemaphore_t *buffer);
+
+/*!
+ * @brief Measure the stacks of the watched tasks and the heap.
+ *
+ * @param[out] budget pointer to the budget to fill
+ */
+void ubirch_budget_get(ubirch_budget_t *budget);
+
+/*!
+ * @brief Log the budget, with a warning for every stack, which is nearly used up.
+ */
+void ubirch_budget_log(void);
+
+#endif /* EXAMPLE_ESP32_BUDGET_H */
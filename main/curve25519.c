@@ -0,0 +1,526 @@
+/*!
+ * @file curve25519.c
+ * @brief Arithmetic of the field, the points and the scalars of ed25519.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+
+#include "curve25519.h"
+
+// d = -121665/121666, 2 * d, sqrt(-1) and the base point, from RFC 8032
+static const fe fe_d = {
+        56195235, 13857412, 51736253, 6949390, 114729, 24766616, 60832955, 30306712, 48412415, 21499315
+};
+static const fe fe_d2 = {
+        45281625, 27714825, 36363642, 13898781, 229458, 15978800, 54557047, 27058993, 29715967, 9444199
+};
+static const fe fe_sqrtm1 = {
+        34513072, 25610706, 9377949, 3500415, 12389472, 33281959, 41962654, 31548777, 326685, 11406482
+};
+const ge ge_base_point = {
+        .X = { 52811034, 25909283, 16144682, 17082669, 27570973, 30858332, 40966398, 8378388, 20764389, 8758491 },
+        .Y = { 40265304, 26843545, 13421772, 20132659, 26843545, 6710886, 53687091, 13421772, 40265318, 26843545 },
+        .Z = { 1 },
+        .T = { 28827043, 27438313, 39759291, 244362, 8635006, 11264893, 19351346, 13413597, 16611511, 27139452 },
+};
+
+const uint32_t sc_order[8] = {
+        0x5cf5d3ed, 0x5812631a, 0xa2f79cd6, 0x14def9de, 0x00000000, 0x00000000, 0x00000000, 0x10000000
+};
+
+#define LIMB_BITS(i) (((i) & 1) ? 25 : 26)
+
+/*!
+ * Carry \p h into the limbs of \p out, every limb is rounded into
+ * [-2^25, 2^25) or [-2^24, 2^24).
+ */
+static void fe_carry(fe out, int64_t h[10]) {
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < 10; ++i) {
+            int64_t carry = (h[i] + ((int64_t)1 << (LIMB_BITS(i) - 1))) >> LIMB_BITS(i);
+            h[i] -= carry * ((int64_t)1 << LIMB_BITS(i));
+            if (i < 9) {
+                h[i + 1] += carry;
+            } else {
+                h[0] += 19 * carry;
+            }
+        }
+    }
+    for (int i = 0; i < 10; ++i) {
+        out[i] = (int32_t)h[i];
+    }
+}
+
+static void fe_zero(fe out) {
+    memset(out, 0, sizeof(fe));
+}
+
+static void fe_one(fe out) {
+    memset(out, 0, sizeof(fe));
+    out[0] = 1;
+}
+
+static void fe_add(fe out, const fe f, const fe g) {
+    int64_t h[10];
+    for (int i = 0; i < 10; ++i) {
+        h[i] = (int64_t)f[i] + g[i];
+    }
+    fe_carry(out, h);
+}
+
+static void fe_sub(fe out, const fe f, const fe g) {
+    int64_t h[10];
+    for (int i = 0; i < 10; ++i) {
+        h[i] = (int64_t)f[i] - g[i];
+    }
+    fe_carry(out, h);
+}
+
+static void fe_mul(fe out, const fe f, const fe g) {
+    int32_t g19[10];
+    int64_t h[10] = { 0 };
+    for (int j = 0; j < 10; ++j) {
+        g19[j] = 19 * g[j];
+    }
+    for (int i = 0; i < 10; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            // limbs beyond 2^255 wrap around as 19 times their value
+            int64_t product = (int64_t)f[i] * ((i + j < 10) ? g[j] : g19[j]);
+            // two odd limbs lose half a bit of their weights
+            if (i & j & 1) {
+                product *= 2;
+            }
+            h[(i + j < 10) ? i + j : i + j - 10] += product;
+        }
+    }
+    fe_carry(out, h);
+}
+
+static void fe_sq(fe out, const fe f) {
+    int64_t h[10] = { 0 };
+    for (int i = 0; i < 10; ++i) {
+        for (int j = i; j < 10; ++j) {
+            int64_t product = (int64_t)f[i] * f[j];
+            if (i & j & 1) {
+                product *= 2;
+            }
+            if (i != j) {
+                product *= 2;
+            }
+            if (i + j < 10) {
+                h[i + j] += product;
+            } else {
+                h[i + j - 10] += 19 * product;
+            }
+        }
+    }
+    fe_carry(out, h);
+}
+
+static void fe_sq_times(fe out, const fe f, int times) {
+    fe_sq(out, f);
+    for (int i = 1; i < times; ++i) {
+        fe_sq(out, out);
+    }
+}
+
+/*!
+ * \p out = \p z^((p - 5) / 8) = \p z^(2^252 - 3), for the square root.
+ */
+static void fe_pow22523(fe out, const fe z) {
+    fe t, z2, z9, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0;
+    fe_sq(z2, z);
+    fe_sq_times(t, z2, 2);
+    fe_mul(z9, t, z);
+    fe_mul(t, z9, z2);                  // z^11
+    fe_sq(t, t);
+    fe_mul(z2_5_0, t, z9);              // z^(2^5 - 1)
+    fe_sq_times(t, z2_5_0, 5);
+    fe_mul(z2_10_0, t, z2_5_0);
+    fe_sq_times(t, z2_10_0, 10);
+    fe_mul(z2_20_0, t, z2_10_0);
+    fe_sq_times(t, z2_20_0, 20);
+    fe_mul(t, t, z2_20_0);              // z^(2^40 - 1)
+    fe_sq_times(t, t, 10);
+    fe_mul(z2_50_0, t, z2_10_0);
+    fe_sq_times(t, z2_50_0, 50);
+    fe_mul(z2_100_0, t, z2_50_0);
+    fe_sq_times(t, z2_100_0, 100);
+    fe_mul(t, t, z2_100_0);             // z^(2^200 - 1)
+    fe_sq_times(t, t, 50);
+    fe_mul(t, t, z2_50_0);              // z^(2^250 - 1)
+    fe_sq_times(t, t, 2);
+    fe_mul(out, t, z);
+}
+
+/*!
+ * Encode \p f as 32 bytes, fully reduced modulo p.
+ */
+static void fe_tobytes(unsigned char s[32], const fe f) {
+    int64_t h[10];
+    for (int i = 0; i < 10; ++i) {
+        h[i] = f[i];
+    }
+    // q is 1 if the value is at least p, -1 if it is negative, 0 otherwise
+    int64_t q = (19 * h[9] + ((int64_t)1 << 24)) >> 25;
+    for (int i = 0; i < 10; ++i) {
+        q = (h[i] + q) >> LIMB_BITS(i);
+    }
+    h[0] += 19 * q;
+    for (int i = 0; i < 9; ++i) {
+        int64_t carry = h[i] >> LIMB_BITS(i);
+        h[i + 1] += carry;
+        h[i] -= carry * ((int64_t)1 << LIMB_BITS(i));
+    }
+    h[9] &= ((int64_t)1 << 25) - 1;
+
+    uint64_t bits = 0;
+    int count = 0;
+    size_t out = 0;
+    for (int i = 0; i < 10; ++i) {
+        bits |= (uint64_t)h[i] << count;
+        count += LIMB_BITS(i);
+        while (count >= 8) {
+            s[out++] = (unsigned char)bits;
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+    s[out] = (unsigned char)bits;
+}
+
+/*!
+ * Decode the lower 255 bits of \p s.
+ */
+static void fe_frombytes(fe out, const unsigned char s[32]) {
+    uint64_t bits = 0;
+    int count = 0;
+    size_t in = 0;
+    for (int i = 0; i < 10; ++i) {
+        while (count < LIMB_BITS(i)) {
+            bits |= (uint64_t)s[in++] << count;
+            count += 8;
+        }
+        out[i] = (int32_t)(bits & ((1u << LIMB_BITS(i)) - 1));
+        bits >>= LIMB_BITS(i);
+        count -= LIMB_BITS(i);
+    }
+}
+
+static bool fe_iszero(const fe f) {
+    unsigned char s[32];
+    fe_tobytes(s, f);
+    unsigned char bits = 0;
+    for (size_t i = 0; i < sizeof(s); ++i) {
+        bits |= s[i];
+    }
+    return bits == 0;
+}
+
+static int fe_isnegative(const fe f) {
+    unsigned char s[32];
+    fe_tobytes(s, f);
+    return s[0] & 1;
+}
+
+/*!
+ * \p out = \p z^(p - 2) = \p z^(2^255 - 21), the inverse of \p z.
+ */
+static void fe_invert(fe out, const fe z) {
+    fe t, z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0;
+    fe_sq(z2, z);
+    fe_sq_times(t, z2, 2);
+    fe_mul(z9, t, z);
+    fe_mul(z11, z9, z2);
+    fe_sq(t, z11);
+    fe_mul(z2_5_0, t, z9);              // z^(2^5 - 1)
+    fe_sq_times(t, z2_5_0, 5);
+    fe_mul(z2_10_0, t, z2_5_0);
+    fe_sq_times(t, z2_10_0, 10);
+    fe_mul(z2_20_0, t, z2_10_0);
+    fe_sq_times(t, z2_20_0, 20);
+    fe_mul(t, t, z2_20_0);              // z^(2^40 - 1)
+    fe_sq_times(t, t, 10);
+    fe_mul(z2_50_0, t, z2_10_0);
+    fe_sq_times(t, z2_50_0, 50);
+    fe_mul(z2_100_0, t, z2_50_0);
+    fe_sq_times(t, z2_100_0, 100);
+    fe_mul(t, t, z2_100_0);             // z^(2^200 - 1)
+    fe_sq_times(t, t, 50);
+    fe_mul(t, t, z2_50_0);              // z^(2^250 - 1)
+    fe_sq_times(t, t, 5);
+    fe_mul(out, t, z11);
+}
+
+/*!
+ * \p f = \p g, if \p flag is 1, without a branch.
+ */
+static void fe_cmov(fe f, const fe g, uint32_t flag) {
+    int32_t mask = -(int32_t)flag;
+    for (int i = 0; i < 10; ++i) {
+        f[i] ^= mask & (f[i] ^ g[i]);
+    }
+}
+
+bool ge_frombytes(ge *p, const unsigned char s[32]) {
+    fe u, v, v3, vxx, check;
+    unsigned char y[32];
+
+    fe_frombytes(p->Y, s);
+    fe_tobytes(y, p->Y);
+    if (memcmp(y, s, 31) != 0 || y[31] != (s[31] & 0x7f)) {
+        return false;
+    }
+    fe_one(p->Z);
+    // x^2 = u / v = (y^2 - 1) / (d y^2 + 1)
+    fe_sq(u, p->Y);
+    fe_mul(v, u, fe_d);
+    fe_sub(u, u, p->Z);
+    fe_add(v, v, p->Z);
+    // x = u v^3 (u v^7)^((p - 5) / 8)
+    fe_sq(v3, v);
+    fe_mul(v3, v3, v);
+    fe_sq(p->X, v3);
+    fe_mul(p->X, p->X, v);
+    fe_mul(p->X, p->X, u);
+    fe_pow22523(p->X, p->X);
+    fe_mul(p->X, p->X, v3);
+    fe_mul(p->X, p->X, u);
+
+    fe_sq(vxx, p->X);
+    fe_mul(vxx, vxx, v);
+    fe_sub(check, vxx, u);
+    if (!fe_iszero(check)) {
+        fe_add(check, vxx, u);
+        if (!fe_iszero(check)) {
+            return false;
+        }
+        fe_mul(p->X, p->X, fe_sqrtm1);
+    }
+    if (fe_isnegative(p->X) != (s[31] >> 7)) {
+        if (fe_iszero(p->X)) {
+            return false;
+        }
+        fe_zero(check);
+        fe_sub(p->X, check, p->X);
+    }
+    fe_mul(p->T, p->X, p->Y);
+    return true;
+}
+
+void ge_identity(ge *p) {
+    fe_zero(p->X);
+    fe_one(p->Y);
+    fe_one(p->Z);
+    fe_zero(p->T);
+}
+
+void ge_to_cached(ge_cached *c, const ge *p) {
+    fe_add(c->YplusX, p->Y, p->X);
+    fe_sub(c->YminusX, p->Y, p->X);
+    fe_add(c->Z2, p->Z, p->Z);
+    fe_mul(c->T2d, p->T, fe_d2);
+}
+
+void ge_add(ge *r, const ge *p, const ge_cached *q, bool subtract) {
+    fe a, b, c, d, e, f, g, h;
+    // -q swaps Y + X and Y - X and negates T
+    fe_sub(a, p->Y, p->X);
+    fe_mul(a, a, subtract ? q->YplusX : q->YminusX);
+    fe_add(b, p->Y, p->X);
+    fe_mul(b, b, subtract ? q->YminusX : q->YplusX);
+    fe_mul(c, p->T, q->T2d);
+    fe_mul(d, p->Z, q->Z2);
+    fe_sub(e, b, a);
+    fe_add(h, b, a);
+    if (subtract) {
+        fe_add(f, d, c);
+        fe_sub(g, d, c);
+    } else {
+        fe_sub(f, d, c);
+        fe_add(g, d, c);
+    }
+    fe_mul(r->X, e, f);
+    fe_mul(r->Y, g, h);
+    fe_mul(r->Z, f, g);
+    fe_mul(r->T, e, h);
+}
+
+void ge_double(ge *r, const ge *p) {
+    fe a, b, c, e, f, g, h;
+    fe_sq(a, p->X);
+    fe_sq(b, p->Y);
+    fe_sq(c, p->Z);
+    fe_add(c, c, c);
+    fe_add(h, a, b);
+    fe_add(e, p->X, p->Y);
+    fe_sq(e, e);
+    fe_sub(e, h, e);
+    fe_sub(g, a, b);
+    fe_add(f, c, g);
+    fe_mul(r->X, e, f);
+    fe_mul(r->Y, g, h);
+    fe_mul(r->Z, f, g);
+    fe_mul(r->T, e, h);
+}
+
+bool ge_is_identity(const ge *p) {
+    fe diff;
+    fe_sub(diff, p->Y, p->Z);
+    return fe_iszero(p->X) && fe_iszero(diff);
+}
+
+bool ge_has_small_order(const ge *p) {
+    ge q;
+    ge_double(&q, p);
+    ge_double(&q, &q);
+    ge_double(&q, &q);
+    return ge_is_identity(&q);
+}
+
+void ge_tobytes(unsigned char s[32], const ge *p) {
+    fe recip, x, y;
+    fe_invert(recip, p->Z);
+    fe_mul(x, p->X, recip);
+    fe_mul(y, p->Y, recip);
+    fe_tobytes(s, y);
+    s[31] ^= (unsigned char)(fe_isnegative(x) << 7);
+}
+
+void ge_to_precomp(ge_precomp *c, const ge *p) {
+    fe recip, x, y;
+    fe_invert(recip, p->Z);
+    fe_mul(x, p->X, recip);
+    fe_mul(y, p->Y, recip);
+    fe_add(c->yplusx, y, x);
+    fe_sub(c->yminusx, y, x);
+    fe_mul(c->xy2d, x, y);
+    fe_mul(c->xy2d, c->xy2d, fe_d2);
+}
+
+void ge_madd(ge *r, const ge *p, const ge_precomp *q) {
+    fe a, b, c, d, e, f, g, h;
+    fe_sub(a, p->Y, p->X);
+    fe_mul(a, a, q->yminusx);
+    fe_add(b, p->Y, p->X);
+    fe_mul(b, b, q->yplusx);
+    fe_mul(c, p->T, q->xy2d);
+    fe_add(d, p->Z, p->Z);
+    fe_sub(e, b, a);
+    fe_add(h, b, a);
+    fe_sub(f, d, c);
+    fe_add(g, d, c);
+    fe_mul(r->X, e, f);
+    fe_mul(r->Y, g, h);
+    fe_mul(r->Z, f, g);
+    fe_mul(r->T, e, h);
+}
+
+void ge_precomp_identity(ge_precomp *p) {
+    fe_one(p->yplusx);
+    fe_one(p->yminusx);
+    fe_zero(p->xy2d);
+}
+
+void ge_precomp_cmov(ge_precomp *r, const ge_precomp *p, uint32_t flag) {
+    fe_cmov(r->yplusx, p->yplusx, flag);
+    fe_cmov(r->yminusx, p->yminusx, flag);
+    fe_cmov(r->xy2d, p->xy2d, flag);
+}
+
+void ge_precomp_neg(ge_precomp *r, const ge_precomp *p) {
+    fe zero;
+    fe_zero(zero);
+    // -p swaps y + x and y - x and negates x * y
+    memcpy(r->yplusx, p->yminusx, sizeof(fe));
+    memcpy(r->yminusx, p->yplusx, sizeof(fe));
+    fe_sub(r->xy2d, zero, p->xy2d);
+}
+
+void sc_load(uint32_t *words, const unsigned char *s, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        words[i] = (uint32_t)s[4 * i] | (uint32_t)s[4 * i + 1] << 8
+                | (uint32_t)s[4 * i + 2] << 16 | (uint32_t)s[4 * i + 3] << 24;
+    }
+}
+
+void sc_store(unsigned char s[32], const uint32_t words[8]) {
+    for (size_t i = 0; i < 32; ++i) {
+        s[i] = (unsigned char)(words[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+bool sc_is_reduced(const uint32_t s[8]) {
+    for (int i = 7; i >= 0; --i) {
+        if (s[i] != sc_order[i]) {
+            return s[i] < sc_order[i];
+        }
+    }
+    return false;
+}
+
+uint32_t sc_sub(uint32_t out[8], const uint32_t a[8], const uint32_t b[8]) {
+    uint32_t borrow = 0;
+    for (int i = 0; i < 8; ++i) {
+        uint64_t diff = (uint64_t)a[i] - b[i] - borrow;
+        out[i] = (uint32_t)diff;
+        borrow = (uint32_t)(diff >> 63);
+    }
+    return borrow;
+}
+
+void sc_reduce(uint32_t out[8], const uint32_t *x, size_t count) {
+    uint32_t r[8] = { 0 };
+    for (size_t bit = count * 32; bit-- > 0;) {
+        // r < L < 2^253, so 2r + 1 fits and needs at most one subtraction
+        uint32_t carry = (x[bit / 32] >> (bit % 32)) & 1;
+        for (int i = 0; i < 8; ++i) {
+            uint32_t next = r[i] >> 31;
+            r[i] = (r[i] << 1) | carry;
+            carry = next;
+        }
+        // the signer reduces secret scalars, so L is subtracted without a branch
+        uint32_t t[8];
+        uint32_t keep = 0 - sc_sub(t, r, sc_order);
+        for (int i = 0; i < 8; ++i) {
+            r[i] = (r[i] & keep) | (t[i] & ~keep);
+        }
+    }
+    memcpy(out, r, sizeof(r));
+}
+
+void sc_muladd(uint32_t out[8], const uint32_t a[8], const uint32_t b[8], const uint32_t c[8]) {
+    // a * b + c < 2^512, as a and b are below 2^256 and c is reduced
+    uint32_t x[16] = { 0 };
+    memcpy(x, c, 8 * sizeof(uint32_t));
+    for (int i = 0; i < 8; ++i) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 8; ++j) {
+            uint64_t t = (uint64_t)a[i] * b[j] + x[i + j] + carry;
+            x[i + j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        for (int k = i + 8; k < 16; ++k) {
+            uint64_t t = (uint64_t)x[k] + carry;
+            x[k] = (uint32_t)t;
+            carry = t >> 32;
+        }
+    }
+    sc_reduce(out, x, 16);
+}
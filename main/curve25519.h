@@ -0,0 +1,157 @@
+/*!
+ * @file curve25519.h
+ * @brief Arithmetic of the field, the points and the scalars of ed25519.
+ *
+ * Shared by the batch verification and the signer. The field elements have
+ * ten signed limbs of alternately 26 and 25 bits, which a 32 bit CPU
+ * multiplies without carries in between, unlike the 16 limbs of 16 bits of
+ * the NaCl implementation. The scalars are eight 32 bit words.
+ *
+ * The functions, which the signer calls with secret data, ge_madd(),
+ * ge_precomp_cmov(), ge_precomp_neg(), ge_double(), ge_tobytes(),
+ * sc_reduce() and sc_muladd(), run in constant time.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_CURVE25519_H
+#define EXAMPLE_ESP32_CURVE25519_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * Element of GF(2^255 - 19) in ten signed limbs of alternately 26 and 25
+ * bits, limb i has the weight 2^ceil(25.5 * i).
+ */
+typedef int32_t fe[10];
+
+/*!
+ * Point in extended coordinates, x = X/Z, y = Y/Z and x * y = T/Z.
+ */
+typedef struct {
+    fe X;
+    fe Y;
+    fe Z;
+    fe T;
+} ge;
+
+/*!
+ * Point prepared to be added, Y + X, Y - X, 2 * Z and 2 * d * T.
+ */
+typedef struct {
+    fe YplusX;
+    fe YminusX;
+    fe Z2;
+    fe T2d;
+} ge_cached;
+
+/*!
+ * Point with Z = 1 prepared to be added, y + x, y - x and 2 * d * x * y.
+ */
+typedef struct {
+    fe yplusx;
+    fe yminusx;
+    fe xy2d;
+} ge_precomp;
+
+//! the base point B of RFC 8032
+extern const ge ge_base_point;
+
+//! the group order L = 2^252 + 27742317777372353535851937790883648493, little endian
+extern const uint32_t sc_order[8];
+
+/*!
+ * Decode a point as in RFC 8032, section 5.1.3.
+ *
+ * @return false if \p s is no point of the curve, or y is not reduced
+ */
+bool ge_frombytes(ge *p, const unsigned char s[32]);
+
+/*!
+ * Encode \p p as in RFC 8032, section 5.1.2.
+ */
+void ge_tobytes(unsigned char s[32], const ge *p);
+
+void ge_identity(ge *p);
+
+void ge_to_cached(ge_cached *c, const ge *p);
+
+/*!
+ * Convert \p p to Z = 1, this needs an inversion.
+ */
+void ge_to_precomp(ge_precomp *c, const ge *p);
+
+/*!
+ * \p r = \p p + \p q, or \p p - \p q, with the formulas of Hisil, Wong, Carter and Dawson.
+ */
+void ge_add(ge *r, const ge *p, const ge_cached *q, bool subtract);
+
+/*!
+ * \p r = \p p + \p q, with one multiplication less than ge_add().
+ */
+void ge_madd(ge *r, const ge *p, const ge_precomp *q);
+
+void ge_double(ge *r, const ge *p);
+
+bool ge_is_identity(const ge *p);
+
+/*!
+ * Check if \p p is one of the 8 points, which the cofactor turns into the identity.
+ */
+bool ge_has_small_order(const ge *p);
+
+void ge_precomp_identity(ge_precomp *p);
+
+/*!
+ * \p r = \p p, if \p flag is 1, without a branch. \p flag has to be 0 or 1.
+ */
+void ge_precomp_cmov(ge_precomp *r, const ge_precomp *p, uint32_t flag);
+
+/*!
+ * \p r = -\p p.
+ */
+void ge_precomp_neg(ge_precomp *r, const ge_precomp *p);
+
+/*!
+ * Load \p count little endian 32 bit words from \p s.
+ */
+void sc_load(uint32_t *words, const unsigned char *s, size_t count);
+
+void sc_store(unsigned char s[32], const uint32_t words[8]);
+
+bool sc_is_reduced(const uint32_t s[8]);
+
+/*!
+ * \p out = \p a - \p b.
+ *
+ * @return the borrow, 1 if \p b is larger than \p a
+ */
+uint32_t sc_sub(uint32_t out[8], const uint32_t a[8], const uint32_t b[8]);
+
+/*!
+ * \p out = \p x mod L, bit by bit, \p x has \p count 32 bit words.
+ */
+void sc_reduce(uint32_t out[8], const uint32_t *x, size_t count);
+
+/*!
+ * \p out = \p a * \p b + \p c mod L.
+ */
+void sc_muladd(uint32_t out[8], const uint32_t a[8], const uint32_t b[8], const uint32_t c[8]);
+
+#endif /* EXAMPLE_ESP32_CURVE25519_H */
@@ -0,0 +1,407 @@
+/*!
+ * @file delta_ota.c
+ * @brief Resumable firmware updates with delta patches.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_idf_version.h>
+#include <esp_http_client.h>
+#include <esp_partition.h>
+#include <networking.h>
+#include <ubirch_ota.h>
+
+#include "delta_patch.h"
+#include "rate_control.h"
+#include "delta_ota.h"
+
+#if CONFIG_UBIRCH_DELTA_OTA
+
+// the host build has no OTA partitions
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <nvs.h>
+
+static const char *TAG = "delta_ota";
+
+#define DELTA_OTA_URL_SIZE 256
+#define DELTA_OTA_READ_SIZE 512
+#define DELTA_OTA_TIMEOUT_MS 10000
+#define DELTA_OTA_ATTEMPTS 5            // failed requests in a row, before the download waits for the next check
+#define DELTA_OTA_RETRY_MS 2000
+#define DELTA_OTA_PAUSE_MS 1000
+#define DELTA_OTA_NVS_NAMESPACE "delta_ota"
+#define DELTA_OTA_NVS_KEY "checkpoint"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <esp_app_desc.h>
+#define delta_ota_app_description esp_app_get_description
+#define delta_ota_sha256_starts mbedtls_sha256_starts
+#define delta_ota_sha256_update mbedtls_sha256_update
+#define delta_ota_sha256_finish mbedtls_sha256_finish
+#else
+#define delta_ota_app_description esp_ota_get_app_description
+#define delta_ota_sha256_starts mbedtls_sha256_starts_ret
+#define delta_ota_sha256_update mbedtls_sha256_update_ret
+#define delta_ota_sha256_finish mbedtls_sha256_finish_ret
+#endif
+
+/*!
+ * The progress of a download, stored in the NVS after every range request.
+ */
+typedef struct {
+    uint8_t new_sha256[UBIRCH_DELTA_HASH_SIZE];     //!< the image of the patch
+    uint32_t frame_offset;
+    uint32_t out_offset;
+} delta_ota_checkpoint_t;
+
+/*!
+ * The partitions of the old and the new image.
+ */
+typedef struct {
+    const esp_partition_t *running;
+    const esp_partition_t *target;
+} delta_ota_partitions_t;
+
+// the patch state contains the sector being built, it is too large for the stack of the task
+static ubirch_delta_patch_t patch;
+static uint8_t read_buffer[DELTA_OTA_READ_SIZE];
+static char url[DELTA_OTA_URL_SIZE];
+static uint8_t running_sha256[UBIRCH_DELTA_HASH_SIZE];
+static uint32_t running_hashed_size = 0;
+static int64_t pace_next_us = 0;
+static ubirch_delta_ota_stats_t stats;
+
+static esp_err_t read_old(void *ctx, uint32_t offset, void *buffer, size_t len) {
+    return esp_partition_read(((delta_ota_partitions_t *)ctx)->running, offset, buffer, len);
+}
+
+static esp_err_t write_new(void *ctx, uint32_t offset, const void *data, size_t len) {
+    const esp_partition_t *target = ((delta_ota_partitions_t *)ctx)->target;
+    // every frame is a whole sector, so a sector, which is written again after a restart, is erased first
+    esp_err_t err = esp_partition_erase_range(target, offset, UBIRCH_DELTA_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return esp_partition_write(target, offset, data, len);
+}
+
+/*!
+ * SHA-256 of the first \p size bytes of \p partition.
+ */
+static esp_err_t partition_sha256(const esp_partition_t *partition, uint32_t size,
+        uint8_t hash[UBIRCH_DELTA_HASH_SIZE]) {
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    delta_ota_sha256_starts(&sha, 0);
+    esp_err_t err = ESP_OK;
+    for (uint32_t offset = 0; offset < size && err == ESP_OK; offset += sizeof(read_buffer)) {
+        size_t len = MIN(sizeof(read_buffer), size - offset);
+        err = esp_partition_read(partition, offset, read_buffer, len);
+        if (err == ESP_OK) {
+            delta_ota_sha256_update(&sha, read_buffer, len);
+        }
+    }
+    delta_ota_sha256_finish(&sha, hash);
+    mbedtls_sha256_free(&sha);
+    return err;
+}
+
+static void checkpoint_store(void) {
+    delta_ota_checkpoint_t checkpoint = {
+            .frame_offset = patch.frame_offset,
+            .out_offset = patch.out_offset,
+    };
+    memcpy(checkpoint.new_sha256, patch.header.new_sha256, UBIRCH_DELTA_HASH_SIZE);
+    nvs_handle_t handle;
+    if (nvs_open(DELTA_OTA_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        ESP_LOGW(TAG, "failed to store the checkpoint");
+        return;
+    }
+    if (nvs_set_blob(handle, DELTA_OTA_NVS_KEY, &checkpoint, sizeof(checkpoint)) != ESP_OK
+            || nvs_commit(handle) != ESP_OK) {
+        ESP_LOGW(TAG, "failed to store the checkpoint");
+    }
+    nvs_close(handle);
+}
+
+static bool checkpoint_load(delta_ota_checkpoint_t *checkpoint) {
+    nvs_handle_t handle;
+    if (nvs_open(DELTA_OTA_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t size = sizeof(delta_ota_checkpoint_t);
+    esp_err_t err = nvs_get_blob(handle, DELTA_OTA_NVS_KEY, checkpoint, &size);
+    nvs_close(handle);
+    return err == ESP_OK && size == sizeof(delta_ota_checkpoint_t);
+}
+
+static void checkpoint_clear(void) {
+    nvs_handle_t handle;
+    if (nvs_open(DELTA_OTA_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_erase_key(handle, DELTA_OTA_NVS_KEY) == ESP_OK) {
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+}
+
+/*!
+ * Delay the download to CONFIG_UBIRCH_DELTA_OTA_RATE_KBPS, after \p len bytes were received.
+ */
+static void pace(size_t len) {
+    int64_t now = esp_timer_get_time();
+    // the time, in which nothing was downloaded, does not allow a burst later
+    pace_next_us = MAX(pace_next_us, now)
+            + (int64_t)len * 1000000 / (CONFIG_UBIRCH_DELTA_OTA_RATE_KBPS * 1024);
+    if (pace_next_us - now >= 1000 * portTICK_PERIOD_MS) {
+        vTaskDelay(pdMS_TO_TICKS((pace_next_us - now) / 1000));
+    }
+}
+
+/*!
+ * Pause the download, while UPPs are waiting to be sent.
+ */
+static void backlog_wait(esp_http_client_handle_t client) {
+#if CONFIG_UBIRCH_RATE_CONTROL
+    ubirch_rate_control_stats_t rate;
+    ubirch_rate_control_stats_get(&rate);
+    if (rate.backlog == 0) {
+        return;
+    }
+    stats.pauses++;
+    ESP_LOGD(TAG, "%" PRIu32 " UPPs waiting, download paused", rate.backlog);
+    // the server would close the idle connection anyway
+    esp_http_client_close(client);
+    while (rate.backlog > 0) {
+        vTaskDelay(pdMS_TO_TICKS(DELTA_OTA_PAUSE_MS));
+        ubirch_rate_control_stats_get(&rate);
+    }
+#endif
+}
+
+/*!
+ * Download the next \p length bytes of the patch with a range request and feed them.
+ */
+static esp_err_t chunk_download(esp_http_client_handle_t client, uint32_t length) {
+    char range[32];
+    snprintf(range, sizeof(range), "bytes=%" PRIu32 "-%" PRIu32, patch.received, patch.received + length - 1);
+    esp_http_client_set_header(client, "Range", range);
+    stats.requests++;
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (esp_http_client_fetch_headers(client) < 0) {
+        esp_http_client_close(client);
+        return ESP_FAIL;
+    }
+    int status = esp_http_client_get_status_code(client);
+    if (status != 206) {
+        esp_http_client_close(client);
+        return (status == 404) ? ESP_ERR_NOT_FOUND : ESP_ERR_INVALID_RESPONSE;
+    }
+    while (!ubirch_delta_patch_done(&patch)) {
+        int len = esp_http_client_read(client, (char *)read_buffer, sizeof(read_buffer));
+        if (len <= 0) {
+            err = (len < 0) ? ESP_FAIL : ESP_OK;
+            break;
+        }
+        stats.bytes += len;
+        pace(len);
+        err = ubirch_delta_patch_feed(&patch, read_buffer, len);
+        if (err != ESP_OK) {
+            break;
+        }
+    }
+    // the connection is kept for the next range, unless there is unread data
+    if (err != ESP_OK || !esp_http_client_is_complete_data_received(client)) {
+        esp_http_client_close(client);
+    }
+    return err;
+}
+
+/*!
+ * Check that the patch fits the running image and the partitions.
+ */
+static esp_err_t header_check(const delta_ota_partitions_t *partitions) {
+    const ubirch_delta_header_t *header = &patch.header;
+    if (header->old_size > partitions->running->size || header->new_size > partitions->target->size) {
+        ESP_LOGW(TAG, "patch does not fit the partitions");
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (running_hashed_size != header->old_size) {
+        esp_err_t err = partition_sha256(partitions->running, header->old_size, running_sha256);
+        if (err != ESP_OK) {
+            return err;
+        }
+        running_hashed_size = header->old_size;
+    }
+    if (memcmp(running_sha256, header->old_sha256, UBIRCH_DELTA_HASH_SIZE) != 0) {
+        ESP_LOGW(TAG, "patch is made for another image");
+        return ESP_ERR_INVALID_VERSION;
+    }
+    return ESP_OK;
+}
+
+/*!
+ * Download the frames of the patch, with a few attempts for every range.
+ */
+static esp_err_t patch_download(esp_http_client_handle_t client) {
+    unsigned int attempts = 0;
+    while (!ubirch_delta_patch_done(&patch)) {
+        backlog_wait(client);
+        uint32_t frame_offset = patch.frame_offset;
+        esp_err_t err = chunk_download(client, CONFIG_UBIRCH_DELTA_OTA_CHUNK_KB * 1024);
+        if (patch.frame_offset != frame_offset) {
+            checkpoint_store();
+            attempts = 0;
+        } else if (err == ESP_OK) {
+            // a range always contains a complete frame, unless the patch ends
+            err = ESP_ERR_INVALID_SIZE;
+        }
+        if (err == ESP_OK) {
+            continue;
+        }
+        if (err == ESP_ERR_INVALID_CRC) {
+            stats.crc_errors++;
+        }
+        if (++attempts == DELTA_OTA_ATTEMPTS) {
+            return err;
+        }
+        ESP_LOGW(TAG, "range at %" PRIu32 " failed: %s", patch.received, esp_err_to_name(err));
+        vTaskDelay(pdMS_TO_TICKS(DELTA_OTA_RETRY_MS * attempts));
+    }
+    return ESP_OK;
+}
+
+/*!
+ * Check the new image and boot it.
+ */
+static esp_err_t image_finish(const delta_ota_partitions_t *partitions) {
+    uint8_t hash[UBIRCH_DELTA_HASH_SIZE];
+    esp_err_t err = partition_sha256(partitions->target, patch.header.new_size, hash);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // the download starts again from the beginning
+    checkpoint_clear();
+    if (memcmp(hash, patch.header.new_sha256, UBIRCH_DELTA_HASH_SIZE) != 0) {
+        ESP_LOGE(TAG, "hash of the new image is wrong");
+        return ESP_ERR_INVALID_CRC;
+    }
+    err = esp_ota_set_boot_partition(partitions->target);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "new image not accepted: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "updated with %" PRIu32 " bytes downloaded for a %" PRIu32 " byte image, restarting",
+            stats.bytes, patch.header.new_size);
+    esp_restart();
+    return ESP_OK;
+}
+
+esp_err_t ubirch_delta_ota_update(void) {
+    delta_ota_partitions_t partitions;
+    partitions.running = esp_ota_get_running_partition();
+    partitions.target = esp_ota_get_next_update_partition(NULL);
+    if (partitions.running == NULL || partitions.target == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    stats.checks++;
+    snprintf(url, sizeof(url), "%s/%s/%s.patch", CONFIG_FIRMWARE_UPGRADE_BASE_URL, CONFIG_UBIRCH_DELTA_OTA_PATH,
+            delta_ota_app_description()->version);
+    ESP_LOGD(TAG, "checking %s", url);
+
+    esp_http_client_config_t config = {
+            .url = url,
+            .timeout_ms = DELTA_OTA_TIMEOUT_MS,
+            .keep_alive_enable = true,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ubirch_delta_patch_init(&patch, read_old, write_new, &partitions);
+    esp_err_t err = chunk_download(client, UBIRCH_DELTA_HEADER_SIZE);
+    if (err == ESP_OK && !patch.header_valid) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    if (err == ESP_OK) {
+        err = header_check(&partitions);
+    }
+    if (err == ESP_OK) {
+        stats.image_size = patch.header.new_size;
+        delta_ota_checkpoint_t checkpoint;
+        if (checkpoint_load(&checkpoint)
+                && memcmp(checkpoint.new_sha256, patch.header.new_sha256, UBIRCH_DELTA_HASH_SIZE) == 0
+                && ubirch_delta_patch_resume(&patch, checkpoint.frame_offset, checkpoint.out_offset) == ESP_OK) {
+            stats.resumes++;
+            ESP_LOGI(TAG, "continuing the patch at %" PRIu32 ", %" PRIu32 " of %" PRIu32 " bytes written",
+                    checkpoint.frame_offset, checkpoint.out_offset, patch.header.new_size);
+        }
+        err = patch_download(client);
+    }
+    esp_http_client_cleanup(client);
+    if (err != ESP_OK) {
+        return err;
+    }
+    stats.patch_size = patch.received;
+    return image_finish(&partitions);
+}
+
+void ubirch_delta_ota_task(void __unused *pvParameters) {
+    bool first = true;
+    while (1) {
+        xEventGroupWaitBits(network_event_group, WIFI_CONNECTED_BIT | NETWORK_ETH_READY,
+                false, false, portMAX_DELAY);
+        esp_err_t err = ubirch_delta_ota_update();
+        // without a patch, the full image is checked once after the start, like ubirch_ota_task() does
+        if (err == ESP_ERR_INVALID_VERSION || (err == ESP_ERR_NOT_FOUND && first)) {
+            stats.fallbacks++;
+            ESP_LOGI(TAG, "no patch for the running image, checking the full image");
+            // the full image overwrites the sectors of an interrupted patch
+            checkpoint_clear();
+            ubirch_firmware_update();
+        } else if (err != ESP_OK && err != ESP_ERR_NOT_FOUND) {
+            ESP_LOGW(TAG, "update interrupted: %s", esp_err_to_name(err));
+        }
+        first = false;
+        for (int minute = 0; minute < CONFIG_UBIRCH_DELTA_OTA_INTERVAL_MIN; minute++) {
+            vTaskDelay(pdMS_TO_TICKS(60 * 1000));
+        }
+    }
+}
+
+void ubirch_delta_ota_stats_get(ubirch_delta_ota_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_delta_ota_stats_t));
+}
+
+#endif // CONFIG_UBIRCH_DELTA_OTA
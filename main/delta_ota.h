@@ -0,0 +1,85 @@
+/*!
+ * @file delta_ota.h
+ * @brief Resumable firmware updates with delta patches.
+ *
+ * Instead of the full image, the firmware update task downloads a delta
+ * patch from the running version to the new one (see delta_patch.h):
+ * ```
+ * <CONFIG_FIRMWARE_UPGRADE_BASE_URL>/<CONFIG_UBIRCH_DELTA_OTA_PATH>/<running version>.patch
+ * ```
+ * The patch is applied while it is downloaded, with the running partition
+ * as the old image, into the next OTA partition, one flash sector per frame.
+ * It is downloaded in range requests of CONFIG_UBIRCH_DELTA_OTA_CHUNK_KB,
+ * after every request the next frame is stored in the NVS, so a download,
+ * which is interrupted by the network or a restart, continues there. The
+ * download is paced to CONFIG_UBIRCH_DELTA_OTA_RATE_KBPS and pauses, while
+ * UPPs are waiting to be sent, so it never delays the anchoring.
+ *
+ * If there is no patch for the running version, or it is made for another
+ * image, the full image is downloaded with ubirch_firmware_update().
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_DELTA_OTA_H
+#define EXAMPLE_ESP32_DELTA_OTA_H
+
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * Statistics of the delta updates.
+ */
+typedef struct {
+    uint32_t checks;            //!< checks for a patch
+    uint32_t resumes;           //!< downloads continued from a stored frame
+    uint32_t requests;          //!< range requests
+    uint32_t bytes;             //!< bytes of patches downloaded, including repeated ones
+    uint32_t crc_errors;        //!< frames downloaded again, because of a wrong CRC
+    uint32_t pauses;            //!< pauses, because UPPs were waiting
+    uint32_t fallbacks;         //!< updates with the full image
+    uint32_t patch_size;        //!< size of the last patch
+    uint32_t image_size;        //!< size of the image of the last patch
+} ubirch_delta_ota_stats_t;
+
+/*!
+ * @brief Update the firmware with a delta patch, if there is one.
+ *
+ * On success, the device restarts with the new firmware.
+ *
+ * @return ESP_ERR_NOT_FOUND if there is no patch for the running version,
+ *         ESP_ERR_INVALID_VERSION if the patch is made for another image,
+ *         or the error, which interrupted the download, it continues
+ *         with the next call
+ */
+esp_err_t ubirch_delta_ota_update(void);
+
+/*!
+ * @brief Task, which checks for updates every CONFIG_UBIRCH_DELTA_OTA_INTERVAL_MIN.
+ *
+ * It replaces ubirch_ota_task() as the fw_update task.
+ */
+void ubirch_delta_ota_task(void *pvParameters);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_delta_ota_stats_get(ubirch_delta_ota_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_DELTA_OTA_H */
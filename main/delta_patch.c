@@ -0,0 +1,269 @@
+/*!
+ * @file delta_patch.c
+ * @brief Streaming application of delta patches to firmware images.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include <esp_rom_crc.h>
+
+#include "delta_patch.h"
+
+// the patch format does not depend on the configuration, the host tool uses it, too
+
+/*!
+ * Parser states.
+ */
+enum {
+    DELTA_STATE_HEADER = 0,
+    DELTA_STATE_FRAME_HEADER,
+    DELTA_STATE_OP,             //!< header of the next op
+    DELTA_STATE_INSERT,         //!< data of an insert op
+    DELTA_STATE_DONE,
+};
+
+static uint32_t le16(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8;
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/*!
+ * Size of the op header, which starts with \p op.
+ */
+static size_t op_header_size(uint8_t op) {
+    switch (op) {
+        case UBIRCH_DELTA_OP_COPY:
+            return 7;
+        case UBIRCH_DELTA_OP_INSERT:
+            return 3;
+        case UBIRCH_DELTA_OP_FILL:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static void frame_start(ubirch_delta_patch_t *patch) {
+    patch->state = DELTA_STATE_FRAME_HEADER;
+    patch->head_fill = 0;
+    patch->received = patch->frame_offset;
+}
+
+/*!
+ * Drop the frame, it is fed again.
+ */
+static esp_err_t frame_broken(ubirch_delta_patch_t *patch) {
+    frame_start(patch);
+    return ESP_ERR_INVALID_CRC;
+}
+
+void ubirch_delta_patch_init(ubirch_delta_patch_t *patch, ubirch_delta_read_t read_old,
+        ubirch_delta_write_t write_new, void *ctx) {
+    memset(patch, 0, offsetof(ubirch_delta_patch_t, sector));
+    patch->read_old = read_old;
+    patch->write_new = write_new;
+    patch->ctx = ctx;
+    patch->state = DELTA_STATE_HEADER;
+}
+
+esp_err_t ubirch_delta_patch_resume(ubirch_delta_patch_t *patch, uint32_t frame_offset, uint32_t out_offset) {
+    if (!patch->header_valid) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (frame_offset < UBIRCH_DELTA_HEADER_SIZE || out_offset > patch->header.new_size
+            || (out_offset % UBIRCH_DELTA_SECTOR_SIZE != 0 && out_offset != patch->header.new_size)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    patch->frame_offset = frame_offset;
+    patch->out_offset = out_offset;
+    frame_start(patch);
+    if (out_offset == patch->header.new_size) {
+        patch->state = DELTA_STATE_DONE;
+    }
+    return ESP_OK;
+}
+
+bool ubirch_delta_patch_done(const ubirch_delta_patch_t *patch) {
+    return patch->state == DELTA_STATE_DONE;
+}
+
+static esp_err_t header_parse(ubirch_delta_patch_t *patch) {
+    const uint8_t *head = patch->head;
+    if (memcmp(head, "UBDP", 4) != 0 || head[4] != UBIRCH_DELTA_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    patch->header.old_size = le32(head + 8);
+    patch->header.new_size = le32(head + 12);
+    memcpy(patch->header.old_sha256, head + 16, UBIRCH_DELTA_HASH_SIZE);
+    memcpy(patch->header.new_sha256, head + 16 + UBIRCH_DELTA_HASH_SIZE, UBIRCH_DELTA_HASH_SIZE);
+    if (patch->header.new_size == 0) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    patch->header_valid = true;
+    patch->frame_offset = UBIRCH_DELTA_HEADER_SIZE;
+    patch->out_offset = 0;
+    frame_start(patch);
+    return ESP_OK;
+}
+
+/*!
+ * Apply the op in the head buffer, except the data of an insert.
+ */
+static esp_err_t op_apply(ubirch_delta_patch_t *patch) {
+    const uint8_t *head = patch->head;
+    size_t space = patch->frame_size - patch->sector_fill;
+    switch (head[0]) {
+        case UBIRCH_DELTA_OP_COPY: {
+            uint32_t offset = le32(head + 1);
+            uint32_t len = le16(head + 5);
+            if (len > space || offset > patch->header.old_size || len > patch->header.old_size - offset) {
+                return frame_broken(patch);
+            }
+            esp_err_t err = patch->read_old(patch->ctx, offset, patch->sector + patch->sector_fill, len);
+            if (err != ESP_OK) {
+                return err;
+            }
+            patch->sector_fill += len;
+            break;
+        }
+        case UBIRCH_DELTA_OP_INSERT:
+            patch->insert_remaining = le16(head + 1);
+            if (patch->insert_remaining > space) {
+                return frame_broken(patch);
+            }
+            patch->state = DELTA_STATE_INSERT;
+            break;
+        case UBIRCH_DELTA_OP_FILL:
+            if (le16(head + 1) > space) {
+                return frame_broken(patch);
+            }
+            memset(patch->sector + patch->sector_fill, head[3], le16(head + 1));
+            patch->sector_fill += le16(head + 1);
+            break;
+        default:
+            return frame_broken(patch);
+    }
+    patch->head_fill = 0;
+    return ESP_OK;
+}
+
+/*!
+ * Check the complete frame and write its sector.
+ */
+static esp_err_t frame_finish(ubirch_delta_patch_t *patch) {
+    if (patch->state != DELTA_STATE_OP || patch->head_fill != 0 || patch->sector_fill != patch->frame_size
+            || patch->crc != patch->crc_expected) {
+        return frame_broken(patch);
+    }
+    esp_err_t err = patch->write_new(patch->ctx, patch->out_offset, patch->sector, patch->frame_size);
+    if (err != ESP_OK) {
+        return err;
+    }
+    patch->out_offset += patch->frame_size;
+    patch->frame_offset = patch->received;
+    if (patch->out_offset == patch->header.new_size) {
+        patch->state = DELTA_STATE_DONE;
+    } else {
+        patch->state = DELTA_STATE_FRAME_HEADER;
+        patch->head_fill = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ubirch_delta_patch_feed(ubirch_delta_patch_t *patch, const uint8_t *data, size_t len) {
+    while (len > 0 && patch->state != DELTA_STATE_DONE) {
+        size_t take;
+        esp_err_t err = ESP_OK;
+        switch (patch->state) {
+            case DELTA_STATE_HEADER:
+                take = MIN(len, UBIRCH_DELTA_HEADER_SIZE - patch->head_fill);
+                memcpy(patch->head + patch->head_fill, data, take);
+                patch->head_fill += take;
+                patch->received += take;
+                if (patch->head_fill == UBIRCH_DELTA_HEADER_SIZE) {
+                    err = header_parse(patch);
+                }
+                break;
+            case DELTA_STATE_FRAME_HEADER:
+                take = MIN(len, UBIRCH_DELTA_FRAME_HEADER_SIZE - patch->head_fill);
+                memcpy(patch->head + patch->head_fill, data, take);
+                patch->head_fill += take;
+                patch->received += take;
+                if (patch->head_fill == UBIRCH_DELTA_FRAME_HEADER_SIZE) {
+                    patch->payload_len = le16(patch->head);
+                    patch->crc_expected = le32(patch->head + 2);
+                    patch->payload_done = 0;
+                    patch->crc = 0;
+                    patch->frame_size = MIN(UBIRCH_DELTA_SECTOR_SIZE, patch->header.new_size - patch->out_offset);
+                    patch->sector_fill = 0;
+                    patch->head_fill = 0;
+                    patch->state = DELTA_STATE_OP;
+                    if (patch->payload_len == 0) {
+                        err = frame_broken(patch);
+                    }
+                }
+                break;
+            case DELTA_STATE_OP:
+                // an op header is collected byte by byte, its size depends on the first byte
+                take = 1;
+                patch->head[patch->head_fill++] = data[0];
+                if (op_header_size(patch->head[0]) == 0) {
+                    err = frame_broken(patch);
+                    break;
+                }
+                patch->crc = esp_rom_crc32_le(patch->crc, data, 1);
+                patch->payload_done++;
+                patch->received++;
+                if (patch->head_fill == op_header_size(patch->head[0])) {
+                    err = op_apply(patch);
+                }
+                break;
+            case DELTA_STATE_INSERT:
+                take = MIN(len, MIN(patch->insert_remaining, patch->payload_len - patch->payload_done));
+                memcpy(patch->sector + patch->sector_fill, data, take);
+                patch->crc = esp_rom_crc32_le(patch->crc, data, (uint32_t)take);
+                patch->sector_fill += take;
+                patch->insert_remaining -= take;
+                patch->payload_done += take;
+                patch->received += take;
+                if (patch->insert_remaining == 0) {
+                    patch->state = DELTA_STATE_OP;
+                }
+                break;
+            default:
+                return ESP_ERR_INVALID_STATE;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        data += take;
+        len -= take;
+        if ((patch->state == DELTA_STATE_OP || patch->state == DELTA_STATE_INSERT)
+                && patch->payload_done == patch->payload_len) {
+            err = frame_finish(patch);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,159 @@
+/*!
+ * @file delta_patch.h
+ * @brief Streaming application of delta patches to firmware images.
+ *
+ * A delta patch describes the new firmware image by copies from the old
+ * image, which is the running partition, and inserted bytes. It is created
+ * on the host with host/delta_patch.py. All numbers are little endian:
+ * ```
+ * header: "UBDP", version (1 byte), 3 reserved bytes, old size (4), new size (4),
+ *         SHA-256 of the old image (32), SHA-256 of the new image (32)
+ * frame:  payload length (2), CRC-32 of the payload (4), payload
+ * op:     1 = copy: old offset (4), length (2)
+ *         2 = insert: length (2), the bytes
+ *         3 = fill: length (2), the byte
+ * ```
+ * The payload of a frame consists of ops, which produce exactly one sector
+ * of the new image, the last frame the rest. A frame is checked with its
+ * CRC before its sector is written, so after every frame the patch can be
+ * resumed from the next frame, e.g. with a HTTP range request.
+ *
+ * The patch is fed in pieces of any size, the parser keeps only the sector
+ * being built, the data of an insert op is not buffered.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_DELTA_PATCH_H
+#define EXAMPLE_ESP32_DELTA_PATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#define UBIRCH_DELTA_VERSION 1
+#define UBIRCH_DELTA_HEADER_SIZE 80
+#define UBIRCH_DELTA_FRAME_HEADER_SIZE 6
+#define UBIRCH_DELTA_SECTOR_SIZE 4096       //!< bytes of the new image per frame, the flash sector size
+#define UBIRCH_DELTA_HASH_SIZE 32
+
+/*!
+ * Ops of the payload of a frame.
+ */
+typedef enum {
+    UBIRCH_DELTA_OP_COPY = 1,
+    UBIRCH_DELTA_OP_INSERT = 2,
+    UBIRCH_DELTA_OP_FILL = 3,
+} ubirch_delta_op_t;
+
+/*!
+ * Header of a delta patch.
+ */
+typedef struct {
+    uint32_t old_size;
+    uint32_t new_size;
+    uint8_t old_sha256[UBIRCH_DELTA_HASH_SIZE];
+    uint8_t new_sha256[UBIRCH_DELTA_HASH_SIZE];
+} ubirch_delta_header_t;
+
+/*!
+ * Read \p len bytes at \p offset of the old image.
+ */
+typedef esp_err_t (*ubirch_delta_read_t)(void *ctx, uint32_t offset, void *buffer, size_t len);
+
+/*!
+ * Write the sector at \p offset of the new image, \p len is the sector size,
+ * only the last sector can be shorter.
+ */
+typedef esp_err_t (*ubirch_delta_write_t)(void *ctx, uint32_t offset, const void *data, size_t len);
+
+/*!
+ * State of the application of a patch.
+ *
+ * The header and the offsets can be read, the other members are private.
+ */
+typedef struct {
+    ubirch_delta_header_t header;
+    bool header_valid;
+    uint32_t frame_offset;      //!< offset of the next frame in the patch, all frames before are applied
+    uint32_t out_offset;        //!< bytes of the new image written
+    uint32_t received;          //!< offset of the next byte to feed
+
+    ubirch_delta_read_t read_old;
+    ubirch_delta_write_t write_new;
+    void *ctx;
+
+    int state;
+    uint8_t head[UBIRCH_DELTA_HEADER_SIZE];     //!< the patch header, a frame header or an op header
+    size_t head_fill;
+    uint32_t payload_len;
+    uint32_t payload_done;
+    uint32_t crc_expected;
+    uint32_t crc;
+    uint32_t insert_remaining;
+    size_t frame_size;
+    size_t sector_fill;
+    uint8_t sector[UBIRCH_DELTA_SECTOR_SIZE];
+} ubirch_delta_patch_t;
+
+/*!
+ * @brief Prepare the application of a patch, which is fed from its start.
+ *
+ * @param[out] patch the state to initialize
+ * @param[in] read_old function, which reads the old image
+ * @param[in] write_new function, which writes a sector of the new image
+ * @param[in] ctx the context of the functions
+ */
+void ubirch_delta_patch_init(ubirch_delta_patch_t *patch, ubirch_delta_read_t read_old,
+        ubirch_delta_write_t write_new, void *ctx);
+
+/*!
+ * @brief Continue an interrupted application at a frame.
+ *
+ * The header has to be fed before, then the patch is fed from \p frame_offset.
+ *
+ * @param[in,out] patch the state with a valid header
+ * @param[in] frame_offset the frame_offset of the interrupted application
+ * @param[in] out_offset the out_offset of the interrupted application
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE without a header, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t ubirch_delta_patch_resume(ubirch_delta_patch_t *patch, uint32_t frame_offset, uint32_t out_offset);
+
+/*!
+ * @brief Feed the next \p len bytes of the patch, which start at patch->received.
+ *
+ * If a frame fails its CRC check, the rest of \p data is dropped and the
+ * patch has to be fed again from patch->received, which is then the start of
+ * the frame. Bytes after the last frame are ignored.
+ *
+ * @param[in,out] patch the state
+ * @param[in] data the bytes of the patch
+ * @param[in] len number of bytes
+ * @return ESP_OK,
+ *         ESP_ERR_INVALID_CRC if a frame is broken and has to be fed again,
+ *         ESP_ERR_INVALID_VERSION if the header is no delta patch of this version,
+ *         or the error of reading the old or writing the new image
+ */
+esp_err_t ubirch_delta_patch_feed(ubirch_delta_patch_t *patch, const uint8_t *data, size_t len);
+
+/*!
+ * @brief Check if the new image is complete.
+ */
+bool ubirch_delta_patch_done(const ubirch_delta_patch_t *patch);
+
+#endif /* EXAMPLE_ESP32_DELTA_PATCH_H */
@@ -0,0 +1,98 @@
+/*!
+ * @file heap_audit.c
+ * @brief Heap usage of the anchoring, per message.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_heap_caps.h>
+#if CONFIG_HEAP_TRACING_STANDALONE
+#include <esp_heap_trace.h>
+#endif
+
+#include "heap_audit.h"
+
+#if CONFIG_UBIRCH_HEAP_AUDIT
+
+static const char *TAG = "heap_audit";
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+// with HEAP_TRACE_ALL every allocation uses a record, also if it is freed again
+#define HEAP_AUDIT_RECORDS 64
+static heap_trace_record_t records[HEAP_AUDIT_RECORDS];
+static bool tracing = false;
+#endif
+
+static uint32_t window_messages = 0;
+static ubirch_heap_audit_stats_t stats = { .allocations = -1 };
+
+void ubirch_heap_audit_init(void) {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+    memset(&stats, 0, sizeof(stats));
+    stats.allocated_blocks = info.allocated_blocks;
+    stats.allocations = -1;
+    window_messages = 0;
+#if CONFIG_HEAP_TRACING_STANDALONE
+    tracing = (heap_trace_init_standalone(records, HEAP_AUDIT_RECORDS) == ESP_OK
+            && heap_trace_start(HEAP_TRACE_ALL) == ESP_OK);
+#endif
+}
+
+void ubirch_heap_audit_message(void) {
+    stats.messages++;
+    if (++window_messages < CONFIG_UBIRCH_HEAP_AUDIT_WINDOW) {
+        return;
+    }
+    window_messages = 0;
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (tracing) {
+        heap_trace_stop();
+        stats.allocations = (int32_t)heap_trace_get_count();
+    }
+#endif
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+    stats.blocks_delta = (int32_t)info.allocated_blocks - (int32_t)stats.allocated_blocks;
+    stats.allocated_blocks = info.allocated_blocks;
+    stats.free_size = info.total_free_bytes;
+    stats.minimum_free_size = info.minimum_free_bytes;
+
+    ESP_LOGI(TAG, "%d messages: %d allocations, %d blocks, free %u (min %u)",
+            CONFIG_UBIRCH_HEAP_AUDIT_WINDOW, stats.allocations, stats.blocks_delta,
+            (unsigned int)stats.free_size, (unsigned int)stats.minimum_free_size);
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (tracing && stats.allocations >= HEAP_AUDIT_RECORDS) {
+        ESP_LOGW(TAG, "more allocations than trace records");
+    }
+    // the trace buffer is cleared by the start
+    if (tracing) {
+        tracing = (heap_trace_start(HEAP_TRACE_ALL) == ESP_OK);
+    }
+#endif
+}
+
+void ubirch_heap_audit_stats_get(ubirch_heap_audit_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_heap_audit_stats_t));
+}
+
+#endif // CONFIG_UBIRCH_HEAP_AUDIT
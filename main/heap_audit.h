@@ -0,0 +1,64 @@
+/*!
+ * @file heap_audit.h
+ * @brief Heap usage of the anchoring, per message.
+ *
+ * The heap is checked after every window of anchored messages. In steady
+ * state, the number of allocated blocks must not grow. With the standalone
+ * heap tracing (CONFIG_HEAP_TRACING_STANDALONE), also every allocation in
+ * the window is counted, which has to be zero for the anchoring itself.
+ * Allocations of other tasks in the same time, e.g. of the network stack,
+ * are counted, too.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_HEAP_AUDIT_H
+#define EXAMPLE_ESP32_HEAP_AUDIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * Heap statistics of the last window.
+ */
+typedef struct {
+    uint32_t messages;          //!< messages anchored since the start
+    size_t free_size;           //!< free heap at the end of the window
+    size_t minimum_free_size;   //!< lowest free heap since the start (high-water mark)
+    size_t allocated_blocks;    //!< allocated blocks at the end of the window
+    int32_t blocks_delta;       //!< change of the allocated blocks during the window
+    int32_t allocations;        //!< allocations during the window, -1 without heap tracing
+} ubirch_heap_audit_stats_t;
+
+/*!
+ * @brief Start the audit, call it before the first message.
+ */
+void ubirch_heap_audit_init(void);
+
+/*!
+ * @brief Count an anchored message, the heap is checked after every window.
+ */
+void ubirch_heap_audit_message(void);
+
+/*!
+ * @brief Get a copy of the statistics of the last window.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_heap_audit_stats_get(ubirch_heap_audit_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_HEAP_AUDIT_H */
@@ -0,0 +1,345 @@
+/*!
+ * @file http_pool.c
+ * @brief Pool of persistent (keep-alive) HTTP connections to the ubirch backend.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <esp_http_client.h>
+#include <esp_idf_version.h>
+#include <mbedtls/base64.h>
+
+#include "budget.h"
+#include "id_handling.h"
+
+#include "http_pool.h"
+
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+
+static const char *TAG = "http_pool";
+
+// number of different backend hosts (data, key server, ...)
+#define HTTP_POOL_MAX_HOSTS 2
+#define HTTP_POOL_CONNECTIONS (CONFIG_UBIRCH_HTTP_POOL_SIZE * HTTP_POOL_MAX_HOSTS)
+#define HTTP_POOL_HOST_SIZE 64
+#define HTTP_POOL_URL_SIZE 128
+#define HTTP_POOL_CREDENTIAL_SIZE 96
+#define HTTP_POOL_BORROW_TIMEOUT_MS 10000
+
+/*!
+ * One pooled client, which keeps its connection open between requests.
+ */
+typedef struct {
+    esp_http_client_handle_t client;
+    char host[HTTP_POOL_HOST_SIZE];     //!< scheme, host and port of the connection
+    bool in_use;
+    bool connected;
+    bool handshake;                     //!< a new connection was opened in this request
+    int64_t last_used;
+    msgpack_unpacker *unpacker;         //!< receiver of the current response
+    // the client copies url and headers on every set, so they are only set when they change
+    char url[HTTP_POOL_URL_SIZE];
+    unsigned char uuid[16];
+    char credential[HTTP_POOL_CREDENTIAL_SIZE];
+} http_pool_conn_t;
+
+static http_pool_conn_t pool[HTTP_POOL_CONNECTIONS];
+static SemaphoreHandle_t pool_lock = NULL;
+static SemaphoreHandle_t pool_free = NULL;
+UBIRCH_SEMAPHORE_DEFINE(pool_lock);
+UBIRCH_SEMAPHORE_DEFINE(pool_free);
+// the connections are used by several tasks, the counters are updated atomically
+static ubirch_http_pool_stats_t stats = { 0 };
+
+#define HTTP_POOL_COUNT(counter) __atomic_fetch_add(&stats.counter, 1, __ATOMIC_RELAXED)
+
+/*!
+ * Extract "scheme://host:port" from \p url.
+ */
+static esp_err_t host_from_url(const char *url, char *host, size_t size) {
+    const char *start = strstr(url, "://");
+    if (start == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char *end = strchr(start + 3, '/');
+    size_t len = (end != NULL) ? (size_t)(end - url) : strlen(url);
+    if (len >= size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(host, url, len);
+    host[len] = '\0';
+    return ESP_OK;
+}
+
+static esp_err_t http_pool_event_handler(esp_http_client_event_t *evt) {
+    http_pool_conn_t *conn = (http_pool_conn_t *)evt->user_data;
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            conn->connected = true;
+            conn->handshake = true;
+            break;
+        case HTTP_EVENT_ON_DATA:
+            if (conn->unpacker == NULL) {
+                break;
+            }
+            if (msgpack_unpacker_buffer_capacity(conn->unpacker) < (size_t)evt->data_len
+                    && !msgpack_unpacker_reserve_buffer(conn->unpacker, (size_t)evt->data_len)) {
+                ESP_LOGE(TAG, "response too large");
+                return ESP_ERR_NO_MEM;
+            }
+            memcpy(msgpack_unpacker_buffer(conn->unpacker), evt->data, (size_t)evt->data_len);
+            msgpack_unpacker_buffer_consumed(conn->unpacker, (size_t)evt->data_len);
+            break;
+        case HTTP_EVENT_DISCONNECTED:
+            conn->connected = false;
+            break;
+        default:
+            break;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t connection_create(http_pool_conn_t *conn, const char *url, const char *host) {
+    esp_http_client_config_t config = {
+            .url = url,
+            .method = HTTP_METHOD_POST,
+            .event_handler = http_pool_event_handler,
+            .user_data = conn,
+            .keep_alive_enable = true,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+            // resume the TLS session, if the connection has to be opened again,
+            // the HTTP client of the ESP-IDF v4.3 cannot resume sessions, there
+            // every reopened connection costs a full handshake
+            .save_client_session = true,
+#endif
+    };
+    conn->client = esp_http_client_init(&config);
+    if (conn->client == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    snprintf(conn->host, sizeof(conn->host), "%s", host);
+    snprintf(conn->url, sizeof(conn->url), "%s", url);
+    conn->connected = false;
+    return ESP_OK;
+}
+
+static void connection_destroy(http_pool_conn_t *conn) {
+    if (conn->client != NULL) {
+        esp_http_client_cleanup(conn->client);
+    }
+    memset(conn, 0, sizeof(http_pool_conn_t));
+}
+
+/*!
+ * Get a connection for \p host, preferably one which is already open.
+ */
+static http_pool_conn_t *connection_borrow(const char *url, const char *host) {
+    if (xSemaphoreTake(pool_free, pdMS_TO_TICKS(HTTP_POOL_BORROW_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "no connection available");
+        return NULL;
+    }
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    http_pool_conn_t *conn = NULL;
+    http_pool_conn_t *empty = NULL;
+    http_pool_conn_t *oldest = NULL;
+    for (size_t i = 0; i < HTTP_POOL_CONNECTIONS; ++i) {
+        if (pool[i].in_use) {
+            continue;
+        }
+        if (pool[i].client == NULL) {
+            empty = (empty == NULL) ? &pool[i] : empty;
+        } else if (strcmp(pool[i].host, host) == 0) {
+            if (conn == NULL || pool[i].connected) {
+                conn = &pool[i];
+            }
+        } else if (oldest == NULL || pool[i].last_used < oldest->last_used) {
+            oldest = &pool[i];
+        }
+    }
+    if (conn == NULL) {
+        // use a free slot, or give up the oldest connection to another host
+        conn = (empty != NULL) ? empty : oldest;
+        connection_destroy(conn);
+        if (connection_create(conn, url, host) != ESP_OK) {
+            xSemaphoreGive(pool_lock);
+            xSemaphoreGive(pool_free);
+            return NULL;
+        }
+    }
+    conn->in_use = true;
+    xSemaphoreGive(pool_lock);
+
+    if (conn->connected
+            && (esp_timer_get_time() - conn->last_used) > (int64_t)CONFIG_UBIRCH_HTTP_IDLE_TIMEOUT_MS * 1000) {
+        // the server has probably closed the connection already
+        esp_http_client_close(conn->client);
+        conn->connected = false;
+        HTTP_POOL_COUNT(idle_closes);
+    }
+    return conn;
+}
+
+static void connection_return(http_pool_conn_t *conn, bool keep) {
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    if (!keep && conn->connected) {
+        esp_http_client_close(conn->client);
+        conn->connected = false;
+    }
+    conn->unpacker = NULL;
+    conn->last_used = esp_timer_get_time();
+    conn->in_use = false;
+    xSemaphoreGive(pool_lock);
+    xSemaphoreGive(pool_free);
+}
+
+/*!
+ * Set the ubirch authentication headers from the given credentials,
+ * if they differ from the credentials of the previous request.
+ */
+static esp_err_t set_auth_headers(http_pool_conn_t *conn, const unsigned char *uuid,
+        const char *password, size_t password_len) {
+    unsigned char credential[HTTP_POOL_CREDENTIAL_SIZE];
+    size_t credential_len = 0;
+    if (mbedtls_base64_encode(credential, sizeof(credential) - 1, &credential_len,
+                (const unsigned char *)password, password_len) != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    credential[credential_len] = '\0';
+    if (memcmp(conn->uuid, uuid, sizeof(conn->uuid)) == 0
+            && strcmp(conn->credential, (const char *)credential) == 0) {
+        return ESP_OK;
+    }
+
+    char uuid_string[37];
+    uuid_to_string(uuid, uuid_string, sizeof(uuid_string));
+    esp_http_client_set_header(conn->client, "Content-Type", "application/octet-stream");
+    esp_http_client_set_header(conn->client, "X-Ubirch-Hardware-Id", uuid_string);
+    esp_http_client_set_header(conn->client, "X-Ubirch-Auth-Type", "ubirch");
+    esp_http_client_set_header(conn->client, "X-Ubirch-Credential", (const char *)credential);
+    memcpy(conn->uuid, uuid, sizeof(conn->uuid));
+    memcpy(conn->credential, credential, credential_len + 1);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_http_pool_init(void) {
+    memset(pool, 0, sizeof(pool));
+    pool_lock = UBIRCH_MUTEX_CREATE(pool_lock);
+    pool_free = UBIRCH_COUNTING_CREATE(pool_free, HTTP_POOL_CONNECTIONS, HTTP_POOL_CONNECTIONS);
+    if (pool_lock == NULL || pool_free == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+ubirch_send_err_t ubirch_http_pool_send(const char *url, const unsigned char *uuid,
+        const char *data, size_t length, int *http_status,
+        msgpack_unpacker *unpacker, ubirch_protocol_check verifier) {
+    char *password = NULL;
+    size_t password_len = 0;
+    if (ubirch_password_get(&password, &password_len) != ESP_OK) {
+        ESP_LOGE(TAG, "no password in current context");
+        return UBIRCH_SEND_ERROR;
+    }
+    return ubirch_http_pool_send_auth(url, uuid, password, password_len, data, length,
+            http_status, unpacker, verifier);
+}
+
+ubirch_send_err_t ubirch_http_pool_send_auth(const char *url, const unsigned char *uuid,
+        const char *password, size_t password_len, const char *data, size_t length,
+        int *http_status, msgpack_unpacker *unpacker, ubirch_protocol_check verifier) {
+    char host[HTTP_POOL_HOST_SIZE];
+    if (host_from_url(url, host, sizeof(host)) != ESP_OK) {
+        ESP_LOGE(TAG, "invalid url: %s", url);
+        return UBIRCH_SEND_ERROR;
+    }
+    http_pool_conn_t *conn = connection_borrow(url, host);
+    if (conn == NULL) {
+        return UBIRCH_SEND_ERROR;
+    }
+
+    if (strncmp(conn->url, url, HTTP_POOL_URL_SIZE) != 0) {
+        esp_http_client_set_url(conn->client, url);
+        snprintf(conn->url, sizeof(conn->url), "%s", url);
+    }
+    esp_http_client_set_method(conn->client, HTTP_METHOD_POST);
+    esp_http_client_set_post_field(conn->client, data, (int)length);
+    if (set_auth_headers(conn, uuid, password, password_len) != ESP_OK) {
+        connection_return(conn, true);
+        return UBIRCH_SEND_ERROR;
+    }
+    conn->unpacker = unpacker;
+
+    HTTP_POOL_COUNT(requests);
+    conn->handshake = false;
+    esp_err_t err = esp_http_client_perform(conn->client);
+    if (err != ESP_OK && !conn->handshake) {
+        // the reused connection was probably closed by the server, try once more
+        ESP_LOGD(TAG, "reconnect to %s", host);
+        esp_http_client_close(conn->client);
+        conn->connected = false;
+        HTTP_POOL_COUNT(reconnects);
+        err = esp_http_client_perform(conn->client);
+    }
+    if (conn->handshake) {
+        HTTP_POOL_COUNT(handshakes);
+    } else {
+        HTTP_POOL_COUNT(handshakes_avoided);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "request to %s failed: %s", host, esp_err_to_name(err));
+        connection_return(conn, false);
+        return UBIRCH_SEND_ERROR;
+    }
+
+    *http_status = esp_http_client_get_status_code(conn->client);
+    connection_return(conn, true);
+
+    if (unpacker != NULL && verifier != NULL && *http_status >= 200 && *http_status < 300) {
+        if (ubirch_protocol_verify(unpacker->buffer + unpacker->off,
+                    unpacker->used - unpacker->off, verifier) != 0) {
+            return UBIRCH_SEND_VERIFICATION_FAILED;
+        }
+    }
+    return UBIRCH_SEND_OK;
+}
+
+void ubirch_http_pool_close_all(void) {
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    for (size_t i = 0; i < HTTP_POOL_CONNECTIONS; ++i) {
+        if (!pool[i].in_use) {
+            connection_destroy(&pool[i]);
+        }
+    }
+    xSemaphoreGive(pool_lock);
+}
+
+void ubirch_http_pool_stats_get(ubirch_http_pool_stats_t *out) {
+    out->requests = __atomic_load_n(&stats.requests, __ATOMIC_RELAXED);
+    out->handshakes = __atomic_load_n(&stats.handshakes, __ATOMIC_RELAXED);
+    out->handshakes_avoided = __atomic_load_n(&stats.handshakes_avoided, __ATOMIC_RELAXED);
+    out->reconnects = __atomic_load_n(&stats.reconnects, __ATOMIC_RELAXED);
+    out->idle_closes = __atomic_load_n(&stats.idle_closes, __ATOMIC_RELAXED);
+}
+
+#endif // CONFIG_UBIRCH_HTTP_KEEP_ALIVE
@@ -0,0 +1,108 @@
+/*!
+ * @file http_pool.h
+ * @brief Pool of persistent (keep-alive) HTTP connections to the ubirch backend.
+ *
+ * ubirch_send() creates a new HTTP client for every request, which means
+ * a complete TLS handshake for every UPP. The pool keeps the clients
+ * (and their connections) open, so following requests to the same host
+ * reuse the connection. Connections which were idle for too long are
+ * closed and connections which fail are reconnected once.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_HTTP_POOL_H
+#define EXAMPLE_ESP32_HTTP_POOL_H
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <msgpack.h>
+#include <ubirch_protocol.h>
+#include <ubirch_api.h>
+
+/*!
+ * Statistics of the connection pool.
+ */
+typedef struct {
+    uint32_t requests;              //!< requests performed through the pool
+    uint32_t handshakes;            //!< new connections (TLS handshakes)
+    uint32_t handshakes_avoided;    //!< requests on an already open connection
+    uint32_t reconnects;            //!< requests repeated on a fresh connection
+    uint32_t idle_closes;           //!< connections closed due to the idle timeout
+} ubirch_http_pool_stats_t;
+
+/*!
+ * @brief Initialize the connection pool.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_http_pool_init(void);
+
+/*!
+ * @brief Send data to the ubirch backend over a pooled connection.
+ *
+ * This is a drop-in replacement for ubirch_send(), which borrows a
+ * connection for the host of \p url instead of opening a new one.
+ * The credentials of the current ID context are used for authentication.
+ *
+ * @param[in] url the backend url
+ * @param[in] uuid the UUID of the sender (16 bytes)
+ * @param[in] data the data to send
+ * @param[in] length the length of the data
+ * @param[out] http_status the http status of the response
+ * @param[in,out] unpacker the unpacker, which receives the response, or NULL
+ * @param[in] verifier function to verify the response signature, or NULL
+ * @return UBIRCH_SEND_OK, UBIRCH_SEND_VERIFICATION_FAILED, or UBIRCH_SEND_ERROR
+ */
+ubirch_send_err_t ubirch_http_pool_send(const char *url, const unsigned char *uuid,
+        const char *data, size_t length, int *http_status,
+        msgpack_unpacker *unpacker, ubirch_protocol_check verifier);
+
+/*!
+ * @brief Send data to the ubirch backend over a pooled connection, with explicit credentials.
+ *
+ * Like ubirch_http_pool_send(), but independent of the current ID context,
+ * so it can be used in parallel to a task, which changes the current context.
+ *
+ * @param[in] url the backend url
+ * @param[in] uuid the UUID of the sender (16 bytes)
+ * @param[in] password the password of the sender
+ * @param[in] password_len the length of the password
+ * @param[in] data the data to send
+ * @param[in] length the length of the data
+ * @param[out] http_status the http status of the response
+ * @param[in,out] unpacker the unpacker, which receives the response, or NULL
+ * @param[in] verifier function to verify the response signature, or NULL
+ * @return UBIRCH_SEND_OK, UBIRCH_SEND_VERIFICATION_FAILED, or UBIRCH_SEND_ERROR
+ */
+ubirch_send_err_t ubirch_http_pool_send_auth(const char *url, const unsigned char *uuid,
+        const char *password, size_t password_len, const char *data, size_t length,
+        int *http_status, msgpack_unpacker *unpacker, ubirch_protocol_check verifier);
+
+/*!
+ * @brief Close all idle connections.
+ */
+void ubirch_http_pool_close_all(void);
+
+/*!
+ * @brief Get a copy of the pool statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_http_pool_stats_get(ubirch_http_pool_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_HTTP_POOL_H */
@@ -0,0 +1,431 @@
+/*!
+ * @file id_cache.c
+ * @brief RAM cache of loaded identity contexts.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+#include <esp_err.h>
+
+#include "id_handling.h"
+#include "keys.h"
+
+#include "boot.h"
+#include "id_cache.h"
+#include "journal.h"
+#include "signer.h"
+
+static const char *TAG = "id_cache";
+
+#define ID_CACHE_SHORT_NAME_SIZE 16
+#define ID_CACHE_UUID_SIZE 16
+#define ID_CACHE_PASSWORD_SIZE 48
+#define ID_CACHE_SIGNATURE_SIZE 64
+#define ID_CACHE_STATE_BITS 8
+
+/*!
+ * Complete copy of one identity context.
+ */
+typedef struct {
+    char short_name[ID_CACHE_SHORT_NAME_SIZE];
+    unsigned char uuid[ID_CACHE_UUID_SIZE];
+    char password[ID_CACHE_PASSWORD_SIZE];
+    size_t password_len;
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+    unsigned char secret_key[crypto_sign_SECRETKEYBYTES];
+#if CONFIG_UBIRCH_FAST_SIGN
+    ubirch_signer_key_t signer_key; //!< the expanded secret key
+#endif
+    unsigned char previous_signature[ID_CACHE_SIGNATURE_SIZE];
+    uint8_t state;
+    time_t next_key_update;
+    uint32_t last_used;     //!< LRU stamp, 0 means the entry is empty
+    uint16_t dirty_updates; //!< number of updates, which are not yet in NVS
+} id_cache_entry_t;
+
+static id_cache_entry_t cache[CONFIG_UBIRCH_ID_CACHE_SIZE];
+static id_cache_entry_t *active = NULL;
+static char current_name[ID_CACHE_SHORT_NAME_SIZE];    //!< short name of the current context, also if it is not cached
+static uint32_t lru_clock = 0;
+static ubirch_id_cache_stats_t stats = { 0 };
+
+static id_cache_entry_t *find(const char *short_name) {
+    for (size_t i = 0; i < CONFIG_UBIRCH_ID_CACHE_SIZE; ++i) {
+        if (cache[i].last_used != 0
+                && strncmp(cache[i].short_name, short_name, ID_CACHE_SHORT_NAME_SIZE) == 0) {
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * Copy the current context of the key storage into \p entry.
+ */
+static esp_err_t capture(id_cache_entry_t *entry) {
+    unsigned char *buffer = NULL;
+    size_t len = 0;
+
+    if (ubirch_uuid_get(&buffer, &len) != ESP_OK || len != ID_CACHE_UUID_SIZE) {
+        return ESP_FAIL;
+    }
+    memcpy(entry->uuid, buffer, ID_CACHE_UUID_SIZE);
+
+    char *password = NULL;
+    entry->password_len = 0;
+    if (ubirch_password_get(&password, &len) == ESP_OK && len <= ID_CACHE_PASSWORD_SIZE) {
+        memcpy(entry->password, password, len);
+        entry->password_len = len;
+    }
+
+    if (ubirch_public_key_get(&buffer, &len) != ESP_OK || len != crypto_sign_PUBLICKEYBYTES) {
+        return ESP_FAIL;
+    }
+    memcpy(entry->public_key, buffer, crypto_sign_PUBLICKEYBYTES);
+
+    if (ubirch_secret_key_get(&buffer, &len) != ESP_OK || len != crypto_sign_SECRETKEYBYTES) {
+        return ESP_FAIL;
+    }
+#if CONFIG_UBIRCH_FAST_SIGN
+    // a context is committed after every UPP, the key is only expanded, when it changed
+    if (memcmp(entry->secret_key, buffer, crypto_sign_SECRETKEYBYTES) != 0) {
+        ubirch_signer_key_expand(&entry->signer_key, buffer);
+    }
+#endif
+    memcpy(entry->secret_key, buffer, crypto_sign_SECRETKEYBYTES);
+
+    if (ubirch_previous_signature_get(&buffer, &len) != ESP_OK || len != ID_CACHE_SIGNATURE_SIZE) {
+        return ESP_FAIL;
+    }
+    memcpy(entry->previous_signature, buffer, ID_CACHE_SIGNATURE_SIZE);
+
+    entry->state = 0;
+    for (uint8_t bit = 0; bit < ID_CACHE_STATE_BITS; ++bit) {
+        if (ubirch_id_state_get(bit)) {
+            entry->state |= (uint8_t)(1 << bit);
+        }
+    }
+
+    if (ubirch_next_key_update_get(&entry->next_key_update) != ESP_OK) {
+        entry->next_key_update = 0;
+    }
+    return ESP_OK;
+}
+
+/*!
+ * Make \p entry the current context of the key storage, without NVS access.
+ *
+ * ubirch_id_context_add() only resets the current context in RAM and sets
+ * its short name, the content is then restored with the setters.
+ */
+static esp_err_t restore(const id_cache_entry_t *entry) {
+    if (ubirch_id_context_add(entry->short_name) != ESP_OK
+            || ubirch_uuid_set(entry->uuid, ID_CACHE_UUID_SIZE) != ESP_OK
+            || ubirch_public_key_set(entry->public_key, crypto_sign_PUBLICKEYBYTES) != ESP_OK
+            || ubirch_secret_key_set(entry->secret_key, crypto_sign_SECRETKEYBYTES) != ESP_OK
+            || ubirch_previous_signature_set(entry->previous_signature, ID_CACHE_SIGNATURE_SIZE) != ESP_OK
+            || ubirch_next_key_update_set(entry->next_key_update) != ESP_OK) {
+        return ESP_FAIL;
+    }
+#if CONFIG_UBIRCH_FAST_SIGN
+    ubirch_signer_key_set(&entry->signer_key);
+#endif
+    if (entry->password_len > 0
+            && ubirch_password_set(entry->password, entry->password_len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    for (uint8_t bit = 0; bit < ID_CACHE_STATE_BITS; ++bit) {
+        ubirch_id_state_set(bit, (entry->state & (1 << bit)) != 0);
+    }
+    return ESP_OK;
+}
+
+/*!
+ * Write a dirty entry to NVS. This changes the current context.
+ */
+static esp_err_t write_back(id_cache_entry_t *entry) {
+    if (restore(entry) != ESP_OK || ubirch_id_context_store() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to write back \"%s\"", entry->short_name);
+        return ESP_FAIL;
+    }
+    entry->dirty_updates = 0;
+    stats.write_backs++;
+    return ESP_OK;
+}
+
+/*!
+ * Get an empty entry, evict the least recently used entry if necessary.
+ */
+static id_cache_entry_t *allocate(void) {
+    id_cache_entry_t *victim = &cache[0];
+    for (size_t i = 0; i < CONFIG_UBIRCH_ID_CACHE_SIZE; ++i) {
+        if (cache[i].last_used == 0) {
+            return &cache[i];
+        }
+        if (cache[i].last_used < victim->last_used) {
+            victim = &cache[i];
+        }
+    }
+    if (victim->dirty_updates > 0 && write_back(victim) != ESP_OK) {
+        // keep the entry, otherwise the chain of this context would be broken
+        return NULL;
+    }
+    ESP_LOGD(TAG, "evict \"%s\"", victim->short_name);
+    stats.evictions++;
+    memset(victim, 0, sizeof(id_cache_entry_t));
+    return victim;
+}
+
+/*!
+ * Put a copy of \p fresh, which is the current context, into the cache.
+ *
+ * An eviction writes back the victim, which changes the current context, so
+ * the current context is restored afterwards.
+ *
+ * @return the entry or NULL, if no entry is available
+ */
+static id_cache_entry_t *insert(const id_cache_entry_t *fresh) {
+    uint32_t write_backs = stats.write_backs;
+    id_cache_entry_t *entry = allocate();
+    if (entry == NULL) {
+        return NULL;
+    }
+    memcpy(entry, fresh, sizeof(id_cache_entry_t));
+    if (stats.write_backs != write_backs && restore(entry) != ESP_OK) {
+        memset(entry, 0, sizeof(id_cache_entry_t));
+        return NULL;
+    }
+    return entry;
+}
+
+#if CONFIG_UBIRCH_JOURNAL
+/*!
+ * Append the previous signature of the current context to the journal.
+ */
+static esp_err_t journal_append(const char *short_name) {
+    unsigned char *signature = NULL;
+    size_t len = 0;
+    if (ubirch_previous_signature_get(&signature, &len) != ESP_OK || len != ID_CACHE_SIGNATURE_SIZE) {
+        return ESP_FAIL;
+    }
+    return ubirch_journal_append(short_name, signature);
+}
+
+/*!
+ * Continue the context of a journal record with its signature. The
+ * journal writes the replayed contexts to NVS afterwards.
+ */
+static void journal_replay(const char *short_name, const unsigned char *signature) {
+    if (ubirch_id_cache_activate(short_name) != ESP_OK) {
+        ESP_LOGW(TAG, "context \"%s\" of journal record not found", short_name);
+        return;
+    }
+    unsigned char *current = NULL;
+    size_t len = 0;
+    if (ubirch_previous_signature_get(&current, &len) == ESP_OK && len == ID_CACHE_SIGNATURE_SIZE
+            && memcmp(current, signature, ID_CACHE_SIGNATURE_SIZE) == 0) {
+        return;
+    }
+    if (ubirch_previous_signature_set(signature, ID_CACHE_SIGNATURE_SIZE) == ESP_OK) {
+        ubirch_id_cache_commit(NULL, true);
+    }
+}
+#endif
+
+void ubirch_id_cache_init(void) {
+    memset(cache, 0, sizeof(cache));
+    memset(&stats, 0, sizeof(stats));
+    memset(current_name, 0, sizeof(current_name));
+    active = NULL;
+    lru_clock = 0;
+#if CONFIG_UBIRCH_JOURNAL
+    // the chain heads, which were not yet written to NVS, are in the journal
+    if (ubirch_journal_init(journal_replay, ubirch_id_cache_flush) != ESP_OK) {
+        ESP_LOGE(TAG, "journal not available, contexts are written every %d messages",
+                CONFIG_UBIRCH_ID_CACHE_MAX_DIRTY_UPDATES);
+    }
+#endif
+}
+
+esp_err_t ubirch_id_cache_activate(const char *short_name) {
+    strncpy(current_name, short_name, ID_CACHE_SHORT_NAME_SIZE - 1);
+    id_cache_entry_t *entry = find(short_name);
+    if (entry != NULL) {
+        if (restore(entry) != ESP_OK) {
+            ESP_LOGE(TAG, "failed to restore \"%s\"", short_name);
+            return ESP_FAIL;
+        }
+        entry->last_used = ++lru_clock;
+        active = entry;
+        stats.hits++;
+        return ESP_OK;
+    }
+    stats.misses++;
+    active = NULL;
+
+    // load into a scratch entry first, an entry is only evicted for a context, which exists
+    if (ubirch_id_context_load(short_name) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    stats.nvs_loads++;
+    id_cache_entry_t fresh = { 0 };
+    strncpy(fresh.short_name, short_name, ID_CACHE_SHORT_NAME_SIZE - 1);
+    if (capture(&fresh) != ESP_OK) {
+        // an incomplete context, e.g. without keys, stays uncached
+        return ESP_OK;
+    }
+    entry = insert(&fresh);
+    if (entry == NULL) {
+        ESP_LOGW(TAG, "no cache entry available for \"%s\"", short_name);
+        return restore(&fresh);
+    }
+    entry->last_used = ++lru_clock;
+    active = entry;
+#if CONFIG_UBIRCH_FAST_BOOT
+    ubirch_boot_context_cached(short_name);
+#endif
+    return ESP_OK;
+}
+
+/*!
+ * Write the current context, which is not cached, directly to NVS.
+ */
+static esp_err_t store_uncached(const char *short_name, bool dirty) {
+    if (dirty && ubirch_id_context_store() != ESP_OK) {
+        return ESP_FAIL;
+    }
+#if CONFIG_UBIRCH_JOURNAL
+    // a record of the stored signature, so an older record is never replayed,
+    // the context is kept aside, as a compaction changes the current context
+    id_cache_entry_t current = { 0 };
+    strncpy(current.short_name, short_name, ID_CACHE_SHORT_NAME_SIZE - 1);
+    if (capture(&current) == ESP_OK) {
+        journal_append(short_name);
+        return restore(&current);
+    }
+#endif
+    return ESP_OK;
+}
+
+esp_err_t ubirch_id_cache_commit(const char *short_name, bool dirty) {
+    id_cache_entry_t *entry = (short_name == NULL) ? active : find(short_name);
+    if (entry == NULL && short_name == NULL) {
+        // the current context is not cached, so it has to be written directly
+        return store_uncached(current_name, dirty);
+    }
+    if (short_name != NULL) {
+        strncpy(current_name, short_name, ID_CACHE_SHORT_NAME_SIZE - 1);
+    }
+    if (entry == NULL) {
+        // capture before allocating, a write back of the victim changes the current context
+        id_cache_entry_t fresh = { 0 };
+        strncpy(fresh.short_name, short_name, ID_CACHE_SHORT_NAME_SIZE - 1);
+        if (capture(&fresh) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        entry = insert(&fresh);
+        if (entry == NULL) {
+            if (restore(&fresh) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            return store_uncached(short_name, dirty);
+        }
+#if CONFIG_UBIRCH_FAST_BOOT
+        // a new context, which is loaded at the next start
+        ubirch_boot_context_cached(short_name);
+#endif
+    } else if (capture(entry) != ESP_OK) {
+        memset(entry, 0, sizeof(id_cache_entry_t));
+        active = NULL;
+        return ESP_FAIL;
+    }
+    entry->last_used = ++lru_clock;
+    active = entry;
+    if (!dirty) {
+        entry->dirty_updates = 0;
+#if CONFIG_UBIRCH_JOURNAL
+        // a record of the stored signature, so an older record is never replayed
+        journal_append(entry->short_name);
+#endif
+        return ESP_OK;
+    }
+    if (entry->dirty_updates < UINT16_MAX) {
+        entry->dirty_updates++;
+    }
+#if CONFIG_UBIRCH_JOURNAL
+    // the signature is in the journal, the entry is written on eviction or compaction
+    if (journal_append(entry->short_name) == ESP_OK) {
+        return ESP_OK;
+    }
+#endif
+    // limit the number of messages, which get lost on a power failure
+    if (entry->dirty_updates >= CONFIG_UBIRCH_ID_CACHE_MAX_DIRTY_UPDATES) {
+        if (ubirch_id_context_store() != ESP_OK) {
+            ESP_LOGE(TAG, "failed to store \"%s\"", entry->short_name);
+            return ESP_FAIL;
+        }
+        entry->dirty_updates = 0;
+        stats.write_backs++;
+    }
+    return ESP_OK;
+}
+
+const char *ubirch_id_cache_current(void) {
+    return (active != NULL) ? active->short_name : NULL;
+}
+
+void ubirch_id_cache_remove(const char *short_name) {
+    id_cache_entry_t *entry = find(short_name);
+    if (entry != NULL) {
+        if (entry == active) {
+            active = NULL;
+        }
+        memset(entry, 0, sizeof(id_cache_entry_t));
+    }
+}
+
+esp_err_t ubirch_id_cache_flush(void) {
+    esp_err_t err = ESP_OK;
+    id_cache_entry_t *current = NULL;
+    for (size_t i = 0; i < CONFIG_UBIRCH_ID_CACHE_SIZE; ++i) {
+        if (cache[i].last_used == 0) {
+            continue;
+        }
+        if (current == NULL || cache[i].last_used > current->last_used) {
+            current = &cache[i];
+        }
+        if (cache[i].dirty_updates > 0 && write_back(&cache[i]) != ESP_OK) {
+            err = ESP_FAIL;
+        }
+    }
+    // the most recently used entry is the current context
+    if (current != NULL && restore(current) != ESP_OK) {
+        err = ESP_FAIL;
+    }
+    return err;
+}
+
+void ubirch_id_cache_stats_get(ubirch_id_cache_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_id_cache_stats_t));
+}
+
+size_t ubirch_id_cache_entry_size(void) {
+    return sizeof(id_cache_entry_t);
+}
@@ -0,0 +1,118 @@
+/*!
+ * @file id_cache.h
+ * @brief RAM cache of loaded identity contexts.
+ *
+ * The key storage only holds one identity context (the current context)
+ * in RAM, which means every change of the sensor results in a NVS read
+ * and decode of the context. This cache keeps the most recently used
+ * contexts in RAM, so switching between known sensors does not touch
+ * the flash anymore.
+ *
+ * Changes which are only relevant for the chaining of messages (previous
+ * signature) are marked as dirty and written back to NVS, when the entry
+ * is evicted, or when it was updated too often without being written.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_ID_CACHE_H
+#define EXAMPLE_ESP32_ID_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * Statistics of the identity context cache.
+ */
+typedef struct {
+    uint32_t hits;          //!< activations served from RAM
+    uint32_t misses;        //!< activations which required a NVS load
+    uint32_t nvs_loads;     //!< successful context loads from NVS
+    uint32_t evictions;     //!< entries removed to make room for a new context
+    uint32_t write_backs;   //!< dirty entries written to NVS
+} ubirch_id_cache_stats_t;
+
+/*!
+ * @brief Initialize the (empty) identity context cache.
+ */
+void ubirch_id_cache_init(void);
+
+/*!
+ * @brief Make the context with \p short_name the current context.
+ *
+ * If the context is cached it is restored from RAM, otherwise it is
+ * loaded from NVS and inserted into the cache, which can evict the
+ * least recently used entry (and write it back if it is dirty).
+ *
+ * @param[in] short_name short name of the context
+ * @return ESP_OK if the context is current,
+ *         ESP_ERR_NOT_FOUND if it is neither cached, nor stored in NVS,
+ *         ESP_FAIL on other errors
+ */
+esp_err_t ubirch_id_cache_activate(const char *short_name);
+
+/*!
+ * @brief Take over the current context into the cache.
+ *
+ * Has to be called after the current context was modified.
+ *
+ * @param[in] short_name short name of the current context, or NULL for the
+ *                       context of the last ubirch_id_cache_activate() call
+ * @param[in] dirty true, if the modification is not yet stored in NVS,
+ *                  false, if ubirch_id_context_store() was just called
+ * @return ESP_OK, or ESP_FAIL if the context could not be read
+ */
+esp_err_t ubirch_id_cache_commit(const char *short_name, bool dirty);
+
+/*!
+ * @brief Get the short name of the current context, if it is cached.
+ *
+ * @return short name, or NULL if the current context is not in the cache
+ */
+const char *ubirch_id_cache_current(void);
+
+/*!
+ * @brief Remove the entry of \p short_name from the cache, without writing it.
+ *
+ * @param[in] short_name short name of the context
+ */
+void ubirch_id_cache_remove(const char *short_name);
+
+/*!
+ * @brief Write all dirty entries to NVS.
+ *
+ * After this call the current context is the one which was current before.
+ *
+ * @return ESP_OK, or ESP_FAIL if at least one entry could not be written
+ */
+esp_err_t ubirch_id_cache_flush(void);
+
+/*!
+ * @brief Get a copy of the cache statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_id_cache_stats_get(ubirch_id_cache_stats_t *stats);
+
+/*!
+ * @brief RAM of one cached context, by which CONFIG_UBIRCH_ID_CACHE_SIZE grows.
+ */
+size_t ubirch_id_cache_entry_size(void);
+
+#endif /* EXAMPLE_ESP32_ID_CACHE_H */
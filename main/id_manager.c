@@ -28,18 +28,35 @@
  * ```
  */
 
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include <freertos/FreeRTOS.h>
 #include <esp_log.h>
 #include <esp_err.h>
+#include <esp_http_client.h>
+#include <esp_timer.h>
+#include <mbedtls/base64.h>
+#include <msgpack.h>
+#include <ubirch_protocol.h>
+#include <ubirch_ed25519.h>
 
 #include "keys.h"
 #include "id_handling.h"
-#include "key_handling.h"
 #include "token_handling.h"
 #include "api-http-helper.h"
 #include "register_thing.h"
 
+#include "sensor_data.h"
+#include "sensor_index.h"
+#include "id_cache.h"
 #include "id_manager.h"
+#include "metrics.h"
+#include "onboarding.h"
+#include "key_rotation.h"
+#include "key_pool.h"
+#include "http_pool.h"
 
 static const char *TAG = "id_manager";
 
@@ -47,84 +64,657 @@ static const char *TAG = "id_manager";
 static const char *NAMESPACE = "example_namespace";
 // <<<
 
-esp_err_t ubirch_id_context_manage(char *id){
-    
-    char gateway_uuid_string[37];
-
-    // generate short-name from id 
-    char short_name[16];
+/*!
+ * Get the short name of the context of the sensor \p id from the sensor
+ * index. If \p add is true, a new sensor is added to the index.
+ *
+ * Without the index, the short name is the beginning of the sensor id.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the sensor is new, or ESP_FAIL
+ */
+static esp_err_t short_name_get(const char *id, char short_name[16], bool add) {
+#if CONFIG_UBIRCH_SENSOR_INDEX
+    esp_err_t err = add ? ubirch_sensor_index_add(id, short_name) : ubirch_sensor_index_lookup(id, short_name);
+    if (err == ESP_OK || err == ESP_ERR_NOT_FOUND) {
+        return err;
+    } else if (err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "failed to index \"%s\"", id);
+        return ESP_FAIL;
+    }
+#endif
     snprintf(short_name, 15, "%s", id);
-    ESP_LOGI(TAG, "deriving short name: %s", short_name);
-        
-    // load id-context by short-name
-    if (ubirch_id_context_load(short_name) == ESP_OK) {
-        ESP_LOGI(TAG, "context \"%s\" could be loaded", short_name);
-    } 
-    else {
-        ESP_LOGI(TAG, "context \"%s\" not found, generate it", short_name);
-
-        // check if we have a valid token
-        if (!ubirch_token_state_get(UBIRCH_TOKEN_STATE_VALID)) {
-            ESP_LOGW(TAG, "token not valid");
-            // we cannot decide here if the token was used successfully before
-            return ESP_FAIL; 
-        }
+    ESP_LOGD(TAG, "deriving short name: %s", short_name);
+    return ESP_OK;
+}
+
+/*!
+ * Get the gateway UUID as string, it is part of the sensor description.
+ */
+static void gateway_uuid_get(uuid_t gateway_uuid, char gateway_uuid_string[37]) {
+    // >>> HERE THE GATEWAY ID IS SET, this part can be adapted to the needs of the user
+    // load gateway-uuid
+    memset(gateway_uuid, 0, sizeof(uuid_t));
+    esp_efuse_mac_get_default(gateway_uuid);
+    esp_base_mac_addr_set(gateway_uuid);
+
+    // gateway uuid string, will be later used for the name in UBIRCH console
+    uuid_to_string(gateway_uuid, gateway_uuid_string, 37);
+    ESP_LOGI(TAG, "gateway uuid: %s", gateway_uuid_string);
+    // <<<
+}
+
+#if CONFIG_UBIRCH_INGEST
+#define NEW_SENSORS_WINDOW_US (3600 * 1000000LL)
 
-        // check that we have current time before trying to generate/register keys
-        time_t now = 0;
-        struct tm timeinfo = {0};
-        time(&now);
-        localtime_r(&now, &timeinfo);
-        // update time
-        if (timeinfo.tm_year < (2017 - 1900)) {
-            return ESP_FAIL; 
+static int64_t new_sensors_window_start = 0;
+static uint32_t new_sensors_count = 0;
+static uint32_t new_sensors_refused = 0;
+
+/*!
+ * Count a new sensor, whose id was received over the network and is not authenticated. At most
+ * CONFIG_UBIRCH_INGEST_NEW_SENSORS get a context per hour, so a sender cannot fill the flash and
+ * the account with contexts.
+ *
+ * @return true, if the context of the sensor can be created
+ */
+static bool new_sensor_allowed(const char *id) {
+    int64_t now = esp_timer_get_time();
+    if (new_sensors_count == 0 || now - new_sensors_window_start >= NEW_SENSORS_WINDOW_US) {
+        if (new_sensors_refused > 0) {
+            ESP_LOGW(TAG, "%u readings of new sensors refused within the last hour",
+                    (unsigned int)new_sensors_refused);
         }
+        new_sensors_window_start = now;
+        new_sensors_count = 0;
+        new_sensors_refused = 0;
+    }
+    if (new_sensors_count >= CONFIG_UBIRCH_INGEST_NEW_SENSORS) {
+        // logged once, a sender of new ids would fill the log too
+        if (new_sensors_refused++ == 0) {
+            ESP_LOGW(TAG, "sensor \"%s\" refused, %d new sensors within an hour", id,
+                    CONFIG_UBIRCH_INGEST_NEW_SENSORS);
+        }
+        return false;
+    }
+    new_sensors_count++;
+    return true;
+}
+#endif
+
+#if CONFIG_UBIRCH_ONBOARDING
+// the worker holds the current context only to load and to store a context, not across a round trip
+#define CONTEXT_LOCK() ubirch_onboarding_lock()
+#define CONTEXT_UNLOCK() ubirch_onboarding_unlock()
+#else
+// without the worker, the data path onboards its sensors itself
+#define CONTEXT_LOCK()
+#define CONTEXT_UNLOCK()
+#endif
+
+#define REGISTRATION_PASSWORD_SIZE 48
+// the answer of the thing registration also carries the API configuration of the thing
+#define REGISTRATION_RESPONSE_SIZE 2048
+#define REGISTRATION_REQUEST_SIZE 1024
+#define REGISTRATION_NAME_SIZE 16       //!< longest member name, which json_string_get() finds
+#define REGISTRATION_BASE64_SIZE(len) ((((len) + 2) / 3) * 4 + 1)
+
+/*!
+ * The parts of a context, which a registration needs. They are copied from
+ * the current context, so the round trip does not need the current context.
+ */
+typedef struct {
+    char short_name[16];
+    uuid_t uuid;
+    char password[REGISTRATION_PASSWORD_SIZE];
+    size_t password_len;
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+    unsigned char secret_key[crypto_sign_SECRETKEYBYTES];
+    time_t next_key_update;
+    bool id_registered;
+    bool keys_registered;
+} registration_t;
+
+/*!
+ * Response of a registration, cut to the size of the buffer.
+ */
+typedef struct {
+    char buffer[REGISTRATION_RESPONSE_SIZE];
+    size_t len;
+    bool truncated;     //!< the response did not fit into the buffer
+} registration_response_t;
+
+// the key, which signs a key registration, only one task registers keys
+static const unsigned char *registration_secret_key = NULL;
+static registration_response_t registration_response;
+static char registration_request[REGISTRATION_REQUEST_SIZE];
+
+/*!
+ * Copy the parts of the current context \p short_name, which a registration needs, into \p reg.
+ */
+static esp_err_t registration_load(const char *short_name, registration_t *reg) {
+    unsigned char *buffer = NULL;
+    size_t len = 0;
+
+    memset(reg, 0, sizeof(registration_t));
+    strncpy(reg->short_name, short_name, sizeof(reg->short_name) - 1);
+    if (ubirch_uuid_get(&buffer, &len) != ESP_OK || len != sizeof(uuid_t)) {
+        return ESP_FAIL;
+    }
+    memcpy(reg->uuid, buffer, sizeof(uuid_t));
+    if (ubirch_public_key_get(&buffer, &len) != ESP_OK || len != crypto_sign_PUBLICKEYBYTES) {
+        return ESP_FAIL;
+    }
+    memcpy(reg->public_key, buffer, crypto_sign_PUBLICKEYBYTES);
+    if (ubirch_secret_key_get(&buffer, &len) != ESP_OK || len != crypto_sign_SECRETKEYBYTES) {
+        return ESP_FAIL;
+    }
+    memcpy(reg->secret_key, buffer, crypto_sign_SECRETKEYBYTES);
+
+    // the password is set by the registration of the identity
+    char *password = NULL;
+    if (ubirch_password_get(&password, &len) == ESP_OK && len <= REGISTRATION_PASSWORD_SIZE) {
+        memcpy(reg->password, password, len);
+        reg->password_len = len;
+    }
+    if (ubirch_next_key_update_get(&reg->next_key_update) != ESP_OK) {
+        reg->next_key_update = 0;
+    }
+    reg->id_registered = ubirch_id_state_get(UBIRCH_ID_STATE_ID_REGISTERED);
+    reg->keys_registered = ubirch_id_state_get(UBIRCH_ID_STATE_KEYS_REGISTERED);
+    return ESP_OK;
+}
+
+/*!
+ * Create a new key pair in \p reg, which is valid for CONFIG_UBIRCH_KEY_LIFETIME_YEARS.
+ */
+static void registration_keys_create(registration_t *reg) {
+#if CONFIG_UBIRCH_KEY_POOL
+    // only an empty pool lets the onboarding wait for the generation
+    if (ubirch_key_pool_take(reg->public_key, reg->secret_key) != ESP_OK) {
+        crypto_sign_keypair(reg->public_key, reg->secret_key);
+    }
+#else
+    crypto_sign_keypair(reg->public_key, reg->secret_key);
+#endif
+    reg->next_key_update = time(NULL) + (time_t)CONFIG_UBIRCH_KEY_LIFETIME_YEARS * 365 * 24 * 3600;
+}
+
+/*!
+ * Store the current context \p short_name, after the registration step \p step changed it.
+ */
+static esp_err_t context_store(const char *short_name, const char *step) {
+    if (ubirch_id_context_store() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store ID context after %s", step);
+        return ESP_FAIL;
+    }
+    ubirch_id_cache_commit(short_name, false);
+    return ESP_OK;
+}
 
-        // add new context
-        if (ubirch_id_context_add(short_name) != ESP_OK) {
-            ESP_LOGE(TAG, "failed to add context \"%s\"", short_name);
-            return ESP_FAIL; 
+static esp_err_t registration_event_handler(esp_http_client_event_t *evt) {
+    registration_response_t *response = (registration_response_t *)evt->user_data;
+    if (evt->event_id == HTTP_EVENT_ON_DATA) {
+        size_t len = (size_t)evt->data_len;
+        if (len > sizeof(response->buffer) - 1 - response->len) {
+            len = sizeof(response->buffer) - 1 - response->len;
+            response->truncated = true;
         }
+        memcpy(response->buffer + response->len, evt->data, len);
+        response->len += len;
+        response->buffer[response->len] = '\0';
+    }
+    return ESP_OK;
+}
 
-        // >>> HERE THE GATEWAY ID IS SET, this part can be adapted to the needs of the user
-        // load gateway-uuid
-        uuid_t gateway_uuid;
-        esp_efuse_mac_get_default(gateway_uuid);
-        esp_base_mac_addr_set(gateway_uuid);
+/*!
+ * Post \p body to \p url on a connection of its own, the response is kept in registration_response.
+ */
+static esp_err_t registration_post(const char *url, const char *content_type, const char *authorization,
+        const char *body, size_t len, int *http_status) {
+    memset(&registration_response, 0, sizeof(registration_response));
+    esp_http_client_config_t config = {
+            .url = url,
+            .method = HTTP_METHOD_POST,
+            .event_handler = registration_event_handler,
+            .user_data = &registration_response,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_http_client_set_header(client, "Content-Type", content_type);
+    if (authorization != NULL) {
+        esp_http_client_set_header(client, "Authorization", authorization);
+    }
+    esp_http_client_set_post_field(client, body, (int)len);
+    esp_err_t err = esp_http_client_perform(client);
+    if (err == ESP_OK) {
+        *http_status = esp_http_client_get_status_code(client);
+    } else {
+        ESP_LOGE(TAG, "request to %s failed: %s", url, esp_err_to_name(err));
+    }
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+/*!
+ * Write \p str as the content of a JSON string into \p out of \p size bytes.
+ *
+ * @return the length of the escaped string, or -1 if it does not fit
+ */
+static int json_escape(char *out, size_t size, const char *str) {
+    size_t len = 0;
+    for (const unsigned char *c = (const unsigned char *)str; *c != '\0'; ++c) {
+        char escaped[7] = { (char)*c, '\0' };
+        if (*c == '"' || *c == '\\') {
+            snprintf(escaped, sizeof(escaped), "\\%c", *c);
+        } else if (*c < 0x20) {
+            snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+        }
+        size_t escaped_len = strlen(escaped);
+        if (len + escaped_len >= size) {
+            return -1;
+        }
+        memcpy(out + len, escaped, escaped_len);
+        len += escaped_len;
+    }
+    out[len] = '\0';
+    return (int)len;
+}
 
-        // gateway uuid string, will be later used for the name in UBIRCH console
-        uuid_to_string(gateway_uuid, gateway_uuid_string, sizeof(gateway_uuid_string));
-        ESP_LOGI(TAG, "gateway uuid: %s", gateway_uuid_string);
-        // <<<
+/*!
+ * Read the JSON string, which starts with the quote at \p p, into \p out of \p size bytes.
+ * Escaped characters outside of ASCII are not kept, like a string, which does not fit.
+ *
+ * @param[out] len length of the string, or SIZE_MAX if it was not kept
+ * @return the position after the string, or NULL if it is no valid JSON string
+ */
+static const char *json_string_read(const char *p, const char *end, char *out, size_t size, size_t *len) {
+    size_t n = 0;
+    bool kept = true;
+    for (++p; p < end && *p != '"'; ++p) {
+        char c = *p;
+        if ((unsigned char)c < 0x20) {
+            return NULL;
+        } else if (c == '\\') {
+            if (++p >= end) {
+                return NULL;
+            }
+            switch (*p) {
+                case '"':
+                case '\\':
+                case '/':
+                    c = *p;
+                    break;
+                case 'b':
+                    c = '\b';
+                    break;
+                case 'f':
+                    c = '\f';
+                    break;
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'u': {
+                    unsigned int code = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        if (++p >= end || !isxdigit((unsigned char)*p)) {
+                            return NULL;
+                        }
+                        code = code * 16 + (unsigned int)(isdigit((unsigned char)*p) ? *p - '0'
+                                : tolower((unsigned char)*p) - 'a' + 10);
+                    }
+                    kept = kept && code < 0x80;
+                    c = (char)code;
+                    break;
+                }
+                default:
+                    return NULL;
+            }
+        }
+        if (n + 1 < size) {
+            out[n] = c;
+        } else {
+            kept = false;
+        }
+        n++;
+    }
+    if (p >= end) {
+        return NULL;
+    }
+    if (kept) {
+        out[n] = '\0';
+    }
+    *len = kept ? n : SIZE_MAX;
+    return p + 1;
+}
 
-        // derive sensor UUID
-        uuid_t sensor_uuid;
-        if (uuid_v5_create_derived_from_name(&sensor_uuid, 
-                    (char*)NAMESPACE, sizeof(NAMESPACE),
-                    (char*)gateway_uuid, sizeof(gateway_uuid),
-                    short_name, sizeof(short_name)
-                    ) != ESP_OK) {
-            ESP_LOGE(TAG, "failed to generate uuid");
-            return ESP_FAIL; 
+/*!
+ * Find the string value of the member \p name in the JSON text \p json of \p len bytes, at any depth.
+ * Every string is read as a whole, so a name within a string value is not taken for a member.
+ *
+ * @param[out] value buffer of \p size bytes for the value, terminated
+ * @param[out] value_len length of the value
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_SIZE if the value does not fit,
+ *         or ESP_ERR_INVALID_RESPONSE if the text is no valid JSON or the value is no string
+ */
+static esp_err_t json_string_get(const char *json, size_t len, const char *name, char *value, size_t size,
+        size_t *value_len) {
+    const char *end = json + len;
+    char member[REGISTRATION_NAME_SIZE];
+    size_t member_len = 0;
+    const char *p = json;
+    while (p < end) {
+        if (*p != '"') {
+            ++p;
+            continue;
+        }
+        p = json_string_read(p, end, member, sizeof(member), &member_len);
+        if (p == NULL) {
+            return ESP_ERR_INVALID_RESPONSE;
         }
-        if (ubirch_uuid_set(sensor_uuid, sizeof(sensor_uuid)) != ESP_OK) {
-            ESP_LOGE(TAG, "failed to set uuid");
-            return ESP_FAIL; 
+        while (p < end && isspace((unsigned char)*p)) {
+            ++p;
         }
-        char sensor_uuid_string[37];
-        uuid_to_string(sensor_uuid, sensor_uuid_string, sizeof(sensor_uuid_string));
-        ESP_LOGI(TAG, "derived uuid: %s", sensor_uuid_string);
+        if (p >= end || *p != ':' || member_len == SIZE_MAX || strcmp(member, name) != 0) {
+            continue;
+        }
+        for (++p; p < end && isspace((unsigned char)*p); ++p) {
+        }
+        if (p >= end || *p != '"' || json_string_read(p, end, value, size, value_len) == NULL) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        return (*value_len == SIZE_MAX) ? ESP_ERR_INVALID_SIZE : ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/*!
+ * Register the identity of \p reg as thing with the \p description in the
+ * ubirch console, the password of the thing is copied into \p reg.
+ *
+ * @return UBIRCH_ESP32_REGISTER_THING_SUCCESS, UBIRCH_ESP32_REGISTER_THING_ALREADY_REGISTERED,
+ *         or UBIRCH_ESP32_REGISTER_THING_ERROR
+ */
+static int thing_register(registration_t *reg, const char *description) {
+    const char *token = NULL;
+    if (ubirch_token_get(&token) != ESP_OK) {
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    }
+    char uuid_string[37];
+    uuid_to_string(reg->uuid, uuid_string, sizeof(uuid_string));
+    // the description contains the sensor id, which is received from the sensor
+    int len = snprintf(registration_request, sizeof(registration_request),
+            "{\"reqType\":\"creation\",\"tags\":[],\"prefix\":\"\",\"devices\":"
+            "[{\"hwDeviceId\":\"%s\",\"description\":\"", uuid_string);
+    int description_len = json_escape(registration_request + len, sizeof(registration_request) - (size_t)len,
+            description);
+    if (description_len < 0) {
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    }
+    len += description_len;
+    len += snprintf(registration_request + len, sizeof(registration_request) - (size_t)len, "\"}]}");
+    char authorization[256];
+    int authorization_len = snprintf(authorization, sizeof(authorization), "Bearer %s", token);
+    if (len >= (int)sizeof(registration_request) || authorization_len >= (int)sizeof(authorization)) {
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    }
+
+    int http_status = 0;
+    if (registration_post(CONFIG_UBIRCH_REGISTER_THING_URL, "application/json", authorization,
+                registration_request, (size_t)len, &http_status) != ESP_OK) {
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    } else if (http_status == 409) {
+        return UBIRCH_ESP32_REGISTER_THING_ALREADY_REGISTERED;
+    } else if (http_status != 200) {
+        ESP_LOGW(TAG, "thing registration failed: %d %s", http_status, registration_response.buffer);
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    } else if (registration_response.truncated) {
+        // a cut response could end within the password
+        ESP_LOGW(TAG, "thing registration failed: response longer than %d bytes", REGISTRATION_RESPONSE_SIZE - 1);
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    }
+    char password[REGISTRATION_PASSWORD_SIZE + 1];
+    size_t password_len = 0;
+    esp_err_t err = json_string_get(registration_response.buffer, registration_response.len, "password",
+            password, sizeof(password), &password_len);
+    if (err != ESP_OK || password_len == 0) {
+        ESP_LOGW(TAG, "thing registration failed, no password: %s", esp_err_to_name(err));
+        return UBIRCH_ESP32_REGISTER_THING_ERROR;
+    }
+    memcpy(reg->password, password, password_len);
+    reg->password_len = password_len;
+    return UBIRCH_ESP32_REGISTER_THING_SUCCESS;
+}
+
+static int registration_sign(const unsigned char *buf, size_t len, unsigned char signature[UBIRCH_PROTOCOL_SIGN_SIZE]) {
+    return ed25519_sign_key(buf, len, signature, registration_secret_key);
+}
 
-        // create new key pair in current context
-        create_keys();
+static void pack_str(msgpack_packer *pk, const char *str) {
+    size_t len = strlen(str);
+    msgpack_pack_str(pk, len);
+    msgpack_pack_str_body(pk, str, len);
+}
 
-        // set initial value for previous signature
-        unsigned char prev_sig[64] = { 0 };
-        if (ubirch_previous_signature_set(prev_sig, sizeof(prev_sig)) != ESP_OK) {
-            ESP_LOGE(TAG, "failed to initialize previous signature");
-            return ESP_FAIL; 
+static void pack_bin(msgpack_packer *pk, const unsigned char *bin, size_t len) {
+    msgpack_pack_bin(pk, len);
+    msgpack_pack_bin_body(pk, bin, len);
+}
+
+/*!
+ * Register the public key of \p reg at the key service, the registration is
+ * signed with the secret key of \p reg.
+ */
+static esp_err_t keys_register(const registration_t *reg) {
+    time_t now = time(NULL);
+    msgpack_sbuffer sbuf;
+    msgpack_sbuffer_init(&sbuf);
+    msgpack_packer pk;
+    msgpack_packer_init(&pk, &sbuf, msgpack_sbuffer_write);
+    msgpack_pack_map(&pk, 7);
+    pack_str(&pk, "algorithm");
+    pack_str(&pk, "ECC_ED25519");
+    pack_str(&pk, "created");
+    msgpack_pack_uint64(&pk, (uint64_t)now);
+    pack_str(&pk, "hwDeviceId");
+    pack_bin(&pk, reg->uuid, sizeof(uuid_t));
+    pack_str(&pk, "pubKey");
+    pack_bin(&pk, reg->public_key, crypto_sign_PUBLICKEYBYTES);
+    pack_str(&pk, "pubKeyId");
+    pack_bin(&pk, reg->public_key, crypto_sign_PUBLICKEYBYTES);
+    pack_str(&pk, "validNotAfter");
+    msgpack_pack_uint64(&pk, (uint64_t)reg->next_key_update);
+    pack_str(&pk, "validNotBefore");
+    msgpack_pack_uint64(&pk, (uint64_t)now);
+
+    esp_err_t err = ESP_FAIL;
+    registration_secret_key = reg->secret_key;
+    ubirch_protocol *upp = ubirch_protocol_new(reg->uuid, registration_sign);
+    if (upp != NULL && ubirch_protocol_message(upp, proto_signed, UBIRCH_PROTOCOL_TYPE_REG,
+                sbuf.data, sbuf.size) == 0) {
+        int http_status = 0;
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+        bool sent = ubirch_http_pool_send_auth(CONFIG_UBIRCH_BACKEND_KEY_SERVER_URL, reg->uuid,
+                reg->password, reg->password_len, upp->data, upp->size, &http_status, NULL, NULL) == UBIRCH_SEND_OK;
+#else
+        bool sent = registration_post(CONFIG_UBIRCH_BACKEND_KEY_SERVER_URL, "application/octet-stream", NULL,
+                upp->data, upp->size, &http_status) == ESP_OK;
+#endif
+        if (!sent) {
+            ESP_LOGW(TAG, "key registration failed");
+        } else if (http_status != 200) {
+            ESP_LOGW(TAG, "key registration failed: %d", http_status);
+        } else {
+            err = ESP_OK;
         }
+    }
+    registration_secret_key = NULL;
+    if (upp != NULL) {
+        ubirch_protocol_free(upp);
+    }
+    msgpack_sbuffer_destroy(&sbuf);
+    return err;
+}
+
+/*!
+ * Write the time \p t in UTC as ISO 8601 into \p out, like the key service writes it.
+ */
+static void iso_time(time_t t, char out[25]) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(out, 25, "%Y-%m-%dT%H:%M:%S.000Z", &tm);
+}
+
+/*!
+ * Write \p len bytes of \p data as base64 into \p out of \p size bytes.
+ */
+static esp_err_t base64_write(char *out, size_t size, const unsigned char *data, size_t len) {
+    size_t written = 0;
+    return (mbedtls_base64_encode((unsigned char *)out, size, &written, data, len) == 0) ? ESP_OK : ESP_FAIL;
+}
+
+/*!
+ * Sign \p len bytes of \p data with \p secret_key, the signature is written as base64 into \p out.
+ */
+static esp_err_t signature_write(char out[REGISTRATION_BASE64_SIZE(crypto_sign_BYTES)], const char *data,
+        size_t len, const unsigned char *secret_key) {
+    unsigned char signature[crypto_sign_BYTES];
+    if (ed25519_sign_key((const unsigned char *)data, len, signature, secret_key) != 0) {
+        return ESP_FAIL;
+    }
+    return base64_write(out, REGISTRATION_BASE64_SIZE(crypto_sign_BYTES), signature, sizeof(signature));
+}
+
+/*!
+ * Replace the public key of \p old at the key service by the one of \p reg.
+ *
+ * The update is a JSON public key info with the previous key id, which is
+ * signed by the new key and by the old one, so only the owner of the
+ * registered key can replace it. The key service verifies both signatures
+ * over the compact JSON of the key info, with its members in alphabetical
+ * order.
+ */
+static esp_err_t keys_update(const registration_t *old, const registration_t *reg) {
+    char uuid_string[37];
+    char created[25];
+    char not_after[25];
+    char public_key[REGISTRATION_BASE64_SIZE(crypto_sign_PUBLICKEYBYTES)];
+    char previous_key[REGISTRATION_BASE64_SIZE(crypto_sign_PUBLICKEYBYTES)];
+    char signature[REGISTRATION_BASE64_SIZE(crypto_sign_BYTES)];
+    char previous_signature[REGISTRATION_BASE64_SIZE(crypto_sign_BYTES)];
+
+    uuid_to_string(reg->uuid, uuid_string, sizeof(uuid_string));
+    iso_time(time(NULL), created);
+    iso_time(reg->next_key_update, not_after);
+    if (base64_write(public_key, sizeof(public_key), reg->public_key, crypto_sign_PUBLICKEYBYTES) != ESP_OK
+            || base64_write(previous_key, sizeof(previous_key), old->public_key,
+                    crypto_sign_PUBLICKEYBYTES) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    // the key info is written into the request, where it is signed
+    char *request = registration_request;
+    size_t size = sizeof(registration_request);
+    int prefix_len = snprintf(request, size, "{\"pubKeyInfo\":");
+    char *info = request + prefix_len;
+    int info_len = snprintf(info, size - (size_t)prefix_len,
+            "{\"algorithm\":\"ECC_ED25519\",\"created\":\"%s\",\"hwDeviceId\":\"%s\",\"prevPubKeyId\":\"%s\","
+            "\"pubKey\":\"%s\",\"pubKeyId\":\"%s\",\"validNotAfter\":\"%s\",\"validNotBefore\":\"%s\"}",
+            created, uuid_string, previous_key, public_key, public_key, not_after, created);
+    if (info_len >= (int)(size - (size_t)prefix_len)
+            || signature_write(signature, info, (size_t)info_len, reg->secret_key) != ESP_OK
+            || signature_write(previous_signature, info, (size_t)info_len, old->secret_key) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    size_t len = (size_t)(prefix_len + info_len);
+    int rest_len = snprintf(request + len, size - len, ",\"signature\":\"%s\",\"prevSignature\":\"%s\"}",
+            signature, previous_signature);
+    if (rest_len >= (int)(size - len)) {
+        return ESP_FAIL;
+    }
+    len += (size_t)rest_len;
+
+    // a key update is rare, it does not take a connection of the pool
+    int http_status = 0;
+    if (registration_post(CONFIG_UBIRCH_BACKEND_UPDATE_KEY_SERVER_URL, "application/json", NULL,
+                request, len, &http_status) != ESP_OK) {
+        ESP_LOGW(TAG, "key update failed");
+        return ESP_FAIL;
+    } else if (http_status != 200) {
+        ESP_LOGW(TAG, "key update failed: %d %s", http_status, registration_response.buffer);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/*!
+ * Create the context \p short_name of the sensor \p id with a new key pair and store it.
+ * The key pair is created without holding the current context.
+ */
+static esp_err_t context_create(const char *id, char *short_name) {
+    ESP_LOGI(TAG, "context \"%s\" not found, generate it", short_name);
+
+    // check if we have a valid token
+    if (!ubirch_token_state_get(UBIRCH_TOKEN_STATE_VALID)) {
+        ESP_LOGW(TAG, "token not valid");
+        // we cannot decide here if the token was used successfully before
+        return ESP_FAIL;
+    }
+
+    // check that we have current time before trying to generate/register keys
+    time_t now = 0;
+    struct tm timeinfo = {0};
+    time(&now);
+    localtime_r(&now, &timeinfo);
+    // update time
+    if (timeinfo.tm_year < (2017 - 1900)) {
+        return ESP_FAIL;
+    }
+
+    uuid_t gateway_uuid;
+    char gateway_uuid_string[37];
+    gateway_uuid_get(gateway_uuid, gateway_uuid_string);
 
+    // derive sensor UUID from the complete sensor id, the short name can be shorter
+    registration_t reg = { 0 };
+    if (uuid_v5_create_derived_from_name(&reg.uuid,
+                (char*)NAMESPACE, sizeof(NAMESPACE),
+                (char*)gateway_uuid, sizeof(gateway_uuid),
+                (char*)id, strlen(id)
+                ) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to generate uuid");
+        return ESP_FAIL;
+    }
+    char sensor_uuid_string[37];
+    uuid_to_string(reg.uuid, sensor_uuid_string, sizeof(sensor_uuid_string));
+    ESP_LOGI(TAG, "derived uuid: %s", sensor_uuid_string);
+
+    // create new key pair
+    registration_keys_create(&reg);
+
+    // set initial value for previous signature
+    unsigned char prev_sig[64] = { 0 };
+    esp_err_t err = ESP_FAIL;
+    CONTEXT_LOCK();
+    // add new context
+    if (ubirch_id_context_add(short_name) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to add context \"%s\"", short_name);
+    } else if (ubirch_uuid_set(reg.uuid, sizeof(reg.uuid)) != ESP_OK
+            || ubirch_public_key_set(reg.public_key, sizeof(reg.public_key)) != ESP_OK
+            || ubirch_secret_key_set(reg.secret_key, sizeof(reg.secret_key)) != ESP_OK
+            || ubirch_next_key_update_set(reg.next_key_update) != ESP_OK
+            || ubirch_previous_signature_set(prev_sig, sizeof(prev_sig)) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to initialize context \"%s\"", short_name);
+    } else {
+        ubirch_id_state_set(UBIRCH_ID_STATE_KEYS_CREATED, true);
+        ubirch_id_state_set(UBIRCH_ID_STATE_KEYS_REGISTERED, false);
         // store current context
         if (ubirch_id_context_store() != ESP_OK) {
             // probably not enough space on gateway
@@ -133,80 +723,278 @@ esp_err_t ubirch_id_context_manage(char *id){
                 ESP_LOGE(TAG, "Failed to remove basic ID context");
             }
             // we cannot decide here if the token was used successfully before
-            return ESP_FAIL; 
+        } else {
+            ubirch_id_cache_commit(short_name, false);
+            // --> here a new key is stored, but not yet registered
+            err = ESP_OK;
         }
-        // --> here a new key is stored, but not yet registered
     }
+    CONTEXT_UNLOCK();
+    return err;
+}
 
-    // check if id is registered
-    if (!ubirch_id_state_get(UBIRCH_ID_STATE_ID_REGISTERED)) {
-        // check if token is valid
-        if (!ubirch_token_state_get(UBIRCH_TOKEN_STATE_VALID)) {
-            // we cannot decide here if the token was used successfully before
-            return ESP_FAIL; 
-        }
-        // call id registering function with token
-        // >>> HERE THE DESCRIPTION FOR THE SENSOR IN THE UBIRCH CONSOLE IS CREATED
-        char description[15 + 12 + 37];
-        // chose an arbitrary description
-        sprintf(description, "%s on gateway %s", short_name, gateway_uuid_string);
-        // <<<
-        switch (ubirch_register_current_id(description)) {
-            case UBIRCH_ESP32_REGISTER_THING_SUCCESS:
-                ESP_LOGI(TAG, "id creation successfull");
-                break;
-            case UBIRCH_ESP32_REGISTER_THING_ALREADY_REGISTERED:
-                ESP_LOGE(TAG, "id was already created");
-                break;
-            case UBIRCH_ESP32_REGISTER_THING_ERROR:
-                ESP_LOGE(TAG, "id registration failed");
-                if (ubirch_id_context_delete(NULL) != ESP_OK) {
-                    ESP_LOGE(TAG, "Failed to remove basic ID context");
-                }
-            default:
-                // we cannot decide here if the token was used successfully before
-                return ESP_FAIL; 
-        }
+/*!
+ * Register the context \p reg of the sensor \p id as thing in the ubirch console.
+ */
+static esp_err_t context_register_id(const char *id, registration_t *reg) {
+    // check if token is valid
+    if (!ubirch_token_state_get(UBIRCH_TOKEN_STATE_VALID)) {
+        // we cannot decide here if the token was used successfully before
+        return ESP_FAIL;
+    }
+    uuid_t gateway_uuid;
+    char gateway_uuid_string[37];
+    gateway_uuid_get(gateway_uuid, gateway_uuid_string);
 
+    // call id registering function with token
+    // >>> HERE THE DESCRIPTION FOR THE SENSOR IN THE UBIRCH CONSOLE IS CREATED
+    char description[UBIRCH_SENSOR_ID_SIZE + 12 + 37];
+    // chose an arbitrary description
+    sprintf(description, "%s on gateway %s", id, gateway_uuid_string);
+    // <<<
+    int registered = thing_register(reg, description);
+
+    CONTEXT_LOCK();
+    esp_err_t err = ubirch_id_cache_activate(reg->short_name);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to load context \"%s\"", reg->short_name);
+        registered = -1;
+    }
+    switch (registered) {
+        case UBIRCH_ESP32_REGISTER_THING_SUCCESS:
+            ESP_LOGI(TAG, "id creation successfull");
+            err = ubirch_password_set(reg->password, reg->password_len);
+            break;
+        case UBIRCH_ESP32_REGISTER_THING_ALREADY_REGISTERED:
+            ESP_LOGE(TAG, "id was already created");
+            break;
+        case UBIRCH_ESP32_REGISTER_THING_ERROR:
+            ESP_LOGE(TAG, "id registration failed");
+            ubirch_id_cache_remove(reg->short_name);
+            if (ubirch_id_context_delete(NULL) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to remove basic ID context");
+            }
+            // fall through
+        default:
+            // we cannot decide here if the token was used successfully before
+            err = ESP_FAIL;
+    }
+    if (err == ESP_OK) {
         ubirch_id_state_set(UBIRCH_ID_STATE_ID_REGISTERED, true);
-        if (ubirch_id_context_store() != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to store ID context after id registration");
-            return ESP_FAIL; 
-        }
+        err = context_store(reg->short_name, "id registration");
     }
+    CONTEXT_UNLOCK();
+    return err;
+}
 
-    // check if device from current context is registered
-    if (!ubirch_id_state_get(UBIRCH_ID_STATE_KEYS_REGISTERED)) {
-        // check if the existing token is valid
-        if (register_keys() != ESP_OK) {
-            ESP_LOGW(TAG, "failed to register keys, try later");
-            return ESP_FAIL; 
-        }
-        if (ubirch_id_context_store() != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to store ID context after key registration");
-            return ESP_FAIL; 
-        }
+/*!
+ * Register the public key of the context \p reg at the key service.
+ */
+static esp_err_t context_register_keys(const registration_t *reg) {
+    if (keys_register(reg) != ESP_OK) {
+        ESP_LOGW(TAG, "failed to register keys, try later");
+        return ESP_FAIL;
+    }
+    CONTEXT_LOCK();
+    esp_err_t err = ubirch_id_cache_activate(reg->short_name);
+    if (err == ESP_OK) {
+        ubirch_id_state_set(UBIRCH_ID_STATE_KEYS_REGISTERED, true);
+        err = context_store(reg->short_name, "key registration");
     }
+    CONTEXT_UNLOCK();
+    return err;
+}
 
+/*!
+ * Check, if the key of the current context of the sensor \p id has to be updated.
+ */
+static bool key_update_due(const char __unused *id) {
+#if CONFIG_UBIRCH_KEY_ROTATION
+    // the scheduler rotates keys before they expire
+    if (ubirch_key_rotation_get(id) == UBIRCH_KEY_ROTATION_PENDING) {
+        return true;
+    }
+#endif
     // get next key update timestamp
-    time_t next_key_update;
+    time_t next_key_update = 0;
     if (ubirch_next_key_update_get(&next_key_update) != ESP_OK) {
         ESP_LOGW(TAG, "Failed to read next key update");
     }
+    return next_key_update < time(NULL);
+}
 
-    // check if update necessary
-    time_t now = time(NULL);
-    if (next_key_update < now) {
-        ESP_LOGI(TAG, "Your key is about to expire. Trigger key update");
-        if (update_keys() != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to update keys");
+#if CONFIG_UBIRCH_KEY_ROTATION
+/*!
+ * Take the current context of the sensor \p id into the key rotation schedule.
+ */
+static esp_err_t key_rotation_schedule(const char *id, bool rotated) {
+    time_t next_key_update = 0;
+    if (ubirch_next_key_update_get(&next_key_update) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to read next key update");
+    }
+    return ubirch_key_rotation_schedule(id, next_key_update, rotated);
+}
+#endif
+
+esp_err_t ubirch_id_context_onboard(const char *id) {
+    char short_name[16];
+    registration_t reg;
+
+    CONTEXT_LOCK();
+#if CONFIG_UBIRCH_INGEST
+    // a new sensor is counted, before it is added to the index
+    esp_err_t err = short_name_get(id, short_name, false);
+    if (err == ESP_OK) {
+        err = ubirch_id_cache_activate(short_name);
+    }
+    if (err == ESP_ERR_NOT_FOUND) {
+        if (!new_sensor_allowed(id)) {
+            CONTEXT_UNLOCK();
+            return ESP_FAIL;
         }
-        if (ubirch_id_context_store() != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to store ID context after key update");
+        err = short_name_get(id, short_name, true);
+        if (err == ESP_OK) {
+            err = ubirch_id_cache_activate(short_name);
+        }
+    }
+    if (err == ESP_OK) {
+        err = registration_load(short_name, &reg);
+    }
+#else
+    esp_err_t err = short_name_get(id, short_name, true);
+    if (err == ESP_OK) {
+        // load id-context by short-name, from RAM if it was used recently
+        err = ubirch_id_cache_activate(short_name);
+        if (err == ESP_OK) {
+            err = registration_load(short_name, &reg);
         }
     }
+#endif
+    CONTEXT_UNLOCK();
+
+    if (err == ESP_ERR_NOT_FOUND) {
+        UBIRCH_METRICS_SPAN(create);
+        err = context_create(id, short_name);
+        UBIRCH_METRICS_STOP(UBIRCH_METRICS_CREATE, create);
+        return (err == ESP_OK) ? UBIRCH_ID_CONTEXT_PENDING : ESP_FAIL;
+    } else if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to load context \"%s\"", short_name);
+        return ESP_FAIL;
+    }
+
+    // check if id is registered
+    if (!reg.id_registered) {
+        return (context_register_id(id, &reg) == ESP_OK) ? UBIRCH_ID_CONTEXT_PENDING : ESP_FAIL;
+    }
 
+    // check if device from current context is registered
+    if (!reg.keys_registered) {
+        return (context_register_keys(&reg) == ESP_OK) ? UBIRCH_ID_CONTEXT_PENDING : ESP_FAIL;
+    }
     return ESP_OK;
 }
 
+esp_err_t ubirch_id_context_key_update(const char *id) {
+    char short_name[16];
+    registration_t reg;
+    bool due = false;
+
+    CONTEXT_LOCK();
+    esp_err_t err = short_name_get(id, short_name, false);
+    if (err == ESP_OK) {
+        err = ubirch_id_cache_activate(short_name);
+    }
+    if (err == ESP_OK) {
+        due = key_update_due(id);
+#if CONFIG_UBIRCH_KEY_ROTATION
+        if (!due && ubirch_key_rotation_get(id) == UBIRCH_KEY_ROTATION_UNKNOWN) {
+            key_rotation_schedule(id, false);
+        }
+#endif
+        if (due) {
+            err = registration_load(short_name, &reg);
+        }
+    }
+    CONTEXT_UNLOCK();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to load context of \"%s\"", id);
+        return ESP_FAIL;
+    } else if (!due) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Your key is about to expire. Trigger key update");
+    // the old key stays in use, until the new one is registered
+    registration_t update;
+    memcpy(&update, &reg, sizeof(registration_t));
+    registration_keys_create(&update);
+    if (keys_update(&reg, &update) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to update keys");
+        return ESP_FAIL;
+    }
+
+    CONTEXT_LOCK();
+    err = ubirch_id_cache_activate(short_name);
+    if (err == ESP_OK && (ubirch_public_key_set(update.public_key, sizeof(update.public_key)) != ESP_OK
+            || ubirch_secret_key_set(update.secret_key, sizeof(update.secret_key)) != ESP_OK
+            || ubirch_next_key_update_set(update.next_key_update) != ESP_OK)) {
+        err = ESP_FAIL;
+    }
+    if (err == ESP_OK) {
+        err = context_store(short_name, "key update");
+    }
+#if CONFIG_UBIRCH_KEY_ROTATION
+    if (err == ESP_OK) {
+        key_rotation_schedule(id, true);
+    }
+#endif
+    CONTEXT_UNLOCK();
+    return err;
+}
+
+esp_err_t ubirch_id_context_manage(char *id){
+#if CONFIG_UBIRCH_ONBOARDING
+    char short_name[16];
+    // a new sensor is added to the index by the onboarding worker
+    esp_err_t err = short_name_get(id, short_name, false);
+    if (err == ESP_OK) {
+        err = ubirch_id_cache_activate(short_name);
+    }
 
+    // only a complete context is used, everything else is left to the onboarding worker
+    if (err == ESP_ERR_NOT_FOUND
+            || (err == ESP_OK && (!ubirch_id_state_get(UBIRCH_ID_STATE_ID_REGISTERED)
+                    || !ubirch_id_state_get(UBIRCH_ID_STATE_KEYS_REGISTERED)))) {
+        ubirch_onboarding_request(id);
+        return UBIRCH_ID_CONTEXT_PENDING;
+    } else if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to load context of \"%s\"", id);
+        return ESP_FAIL;
+    }
+#if CONFIG_UBIRCH_KEY_ROTATION
+    // the scheduler requests the key update from the worker, the old key stays valid until then
+    if (ubirch_key_rotation_get(id) == UBIRCH_KEY_ROTATION_UNKNOWN
+            && key_rotation_schedule(id, false) != ESP_OK && key_update_due(id)) {
+        ubirch_onboarding_request(id);
+    }
+#else
+    // the old key stays valid until the worker updated it
+    if (key_update_due(id)) {
+        ubirch_onboarding_request(id);
+    }
+#endif
+    return ESP_OK;
+#else
+    // create the context, register the id and the keys, then the context is complete
+    esp_err_t err = UBIRCH_ID_CONTEXT_PENDING;
+    for (int step = 0; step <= 3 && err == UBIRCH_ID_CONTEXT_PENDING; ++step) {
+        err = ubirch_id_context_onboard(id);
+    }
+    if (err != ESP_OK) {
+        return ESP_FAIL;
+    }
+    // a failed key update is tried again with the next message
+    ubirch_id_context_key_update(id);
+    return ESP_OK;
+#endif
+}
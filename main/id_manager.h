@@ -31,13 +31,60 @@
 #ifndef EXAMPLE_ESP32_IDENTITY_MANAGER_H
 #define EXAMPLE_ESP32_IDENTITY_MANAGER_H
 
+#include <esp_err.h>
+
+/*!
+ * Result of ubirch_id_context_manage() and ubirch_id_context_onboard(),
+ * if the identity is not completely onboarded yet.
+ */
+#define UBIRCH_ID_CONTEXT_PENDING ESP_ERR_INVALID_STATE
+
 /*!
  * @brief manage identity context, given by the \p id
  *
+ * Makes the context of \p id the current context. Without the onboarding
+ * worker, a new identity is created and registered right away. With the
+ * onboarding worker, this is left to the worker and the call returns
+ * immediately.
+ *
  * @param[in] id pointer to the identity to manage
- * @return ESP_OK if it works, ESP_FAIL if error occurs
+ * @return ESP_OK if it works,
+ *         UBIRCH_ID_CONTEXT_PENDING if the identity waits for its onboarding,
+ *         ESP_FAIL if error occurs
  */
 esp_err_t ubirch_id_context_manage(char *id);
 
+/*!
+ * @brief Do the next step of the onboarding of the identity \p id.
+ *
+ * The steps are: create the context with a new key pair, register the
+ * identity in the ubirch console and register the public key. The
+ * registrations are a round trip to the backend each, which works on a
+ * copy of the context. With the onboarding worker, the current context is
+ * only held to load and to store the context, without it, the context of
+ * \p id is the current context afterwards.
+ *
+ * @param[in] id pointer to the identity to onboard
+ * @return ESP_OK if the identity is completely onboarded,
+ *         UBIRCH_ID_CONTEXT_PENDING if a step was done and more steps are needed,
+ *         ESP_FAIL if the step failed
+ */
+esp_err_t ubirch_id_context_onboard(const char *id);
+
+/*!
+ * @brief Update the key of the context \p id, if it is about to expire.
+ *
+ * The new key is registered at the key service, before it replaces the
+ * old key in the context. Like ubirch_id_context_onboard(), the current
+ * context is not held across the round trip.
+ *
+ * With the key rotation scheduler, the key is also updated, if the scheduler
+ * marked its rotation as pending, and the context is scheduled afterwards.
+ *
+ * @param[in] id pointer to the identity
+ * @return ESP_OK if no update was necessary or the update succeeded, ESP_FAIL otherwise
+ */
+esp_err_t ubirch_id_context_key_update(const char *id);
+
 
 #endif /* EXAMPLE_ESP32_IDENTITY_MANAGER_H */
\ No newline at end of file
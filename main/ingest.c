@@ -0,0 +1,443 @@
+/*!
+ * @file ingest.c
+ * @brief Server, which receives the readings of the sensors over the network.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_err.h>
+
+#include "budget.h"
+#include "metrics.h"
+#include "rate_control.h"
+#include "ingest.h"
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void put_u16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+esp_err_t ubirch_ingest_decode(const uint8_t *frame, size_t len, sensor_data_t *data, uint16_t *seq) {
+    if (len < UBIRCH_INGEST_HEADER_SIZE || get_u16(frame) != len - UBIRCH_INGEST_LENGTH_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *seq = get_u16(frame + 3);
+    if (frame[2] != UBIRCH_INGEST_TYPE_READING || len < UBIRCH_INGEST_HEADER_SIZE + 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t *body = frame + UBIRCH_INGEST_HEADER_SIZE;
+    size_t id_len = body[0];
+    if (id_len == 0 || id_len >= UBIRCH_SENSOR_ID_SIZE || len < UBIRCH_INGEST_HEADER_SIZE + 2 + id_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t num = body[1 + id_len];
+    if (num > CONFIG_UBIRCH_SENSOR_MAX_VALUES || len != UBIRCH_INGEST_HEADER_SIZE + 2 + id_len + 4 * (size_t)num) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(data->id, body + 1, id_len);
+    data->id[id_len] = '\0';
+    const uint8_t *value = body + 2 + id_len;
+    for (uint8_t i = 0; i < num; ++i, value += 4) {
+        data->values[i] = (int32_t)(((uint32_t)value[0] << 24) | ((uint32_t)value[1] << 16)
+                | ((uint32_t)value[2] << 8) | value[3]);
+    }
+    data->num = num;
+    return ESP_OK;
+}
+
+size_t ubirch_ingest_encode(uint8_t *buffer, uint16_t seq, const char *id, const int32_t *values, uint16_t num) {
+    size_t id_len = strlen(id);
+    if (id_len == 0 || id_len >= UBIRCH_SENSOR_ID_SIZE || num > CONFIG_UBIRCH_SENSOR_MAX_VALUES) {
+        return 0;
+    }
+    size_t len = UBIRCH_INGEST_HEADER_SIZE + 2 + id_len + 4 * (size_t)num;
+    put_u16(buffer, (uint16_t)(len - UBIRCH_INGEST_LENGTH_SIZE));
+    buffer[2] = UBIRCH_INGEST_TYPE_READING;
+    put_u16(buffer + 3, seq);
+    uint8_t *body = buffer + UBIRCH_INGEST_HEADER_SIZE;
+    body[0] = (uint8_t)id_len;
+    memcpy(body + 1, id, id_len);
+    body[1 + id_len] = (uint8_t)num;
+    uint8_t *value = body + 2 + id_len;
+    for (uint16_t i = 0; i < num; ++i, value += 4) {
+        uint32_t v = (uint32_t)values[i];
+        value[0] = (uint8_t)(v >> 24);
+        value[1] = (uint8_t)(v >> 16);
+        value[2] = (uint8_t)(v >> 8);
+        value[3] = (uint8_t)v;
+    }
+    return len;
+}
+
+#if CONFIG_UBIRCH_INGEST
+
+static const char *TAG = "ingest";
+
+#define INGEST_PRIORITY 6
+#define INGEST_SELECT_MS 1000
+#define INGEST_PAUSE_MS 10      // retry of a frame, which waits for a slot
+#define INGEST_UDP_BURST 16     // datagrams received in a row
+#define INGEST_BACKLOG 4
+
+// the sockets of the backend: the pooled connections to the data and the key server, or the one of the
+// anchoring, and the ones of the onboarding and the firmware update
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+#define INGEST_BACKEND_SOCKETS (2 * CONFIG_UBIRCH_HTTP_POOL_SIZE + 2)
+#else
+#define INGEST_BACKEND_SOCKETS 3
+#endif
+#if defined(CONFIG_LWIP_MAX_SOCKETS) \
+        && CONFIG_UBIRCH_INGEST_MAX_CONNECTIONS + 2 + INGEST_BACKEND_SOCKETS > CONFIG_LWIP_MAX_SOCKETS
+#error "the connections of the sensors and of the backend need more sockets than CONFIG_LWIP_MAX_SOCKETS"
+#endif
+
+/*!
+ * A TCP connection of a sensor, with the bytes of its incomplete frames.
+ */
+typedef struct {
+    int fd;                     //!< -1 if the entry is free
+    size_t len;
+    uint8_t buffer[UBIRCH_INGEST_FRAME_MAX];
+} ingest_connection_t;
+
+static ingest_connection_t connections[CONFIG_UBIRCH_INGEST_MAX_CONNECTIONS];
+static int listen_fd = -1;
+static int udp_fd = -1;
+static bool paused = false;     //!< a frame waits for a free slot
+static bool stalled = false;    //!< a frame waited for a free slot in the previous round
+static uint32_t allowed_network = 0;    //!< CONFIG_UBIRCH_INGEST_ALLOWED_NETWORK, in host byte order
+static uint32_t allowed_mask = 0;
+static ubirch_ingest_stats_t stats = { 0 };
+UBIRCH_TASK_DEFINE(ingest_task, 4096);
+
+static esp_err_t nonblocking_set(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return (flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0) ? ESP_OK : ESP_FAIL;
+}
+
+/*!
+ * Parse CONFIG_UBIRCH_INGEST_ALLOWED_NETWORK.
+ */
+static esp_err_t allowed_network_parse(void) {
+    unsigned int a, b, c, d, bits;
+    char end;
+    if (sscanf(CONFIG_UBIRCH_INGEST_ALLOWED_NETWORK, "%u.%u.%u.%u/%u%c", &a, &b, &c, &d, &bits, &end) != 5
+            || a > 255 || b > 255 || c > 255 || d > 255 || bits > 32) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    allowed_mask = (bits == 0) ? 0 : UINT32_MAX << (32 - bits);
+    allowed_network = ((a << 24) | (b << 16) | (c << 8) | d) & allowed_mask;
+    return ESP_OK;
+}
+
+/*!
+ * Check if the sender \p from is in the network of the sensors.
+ */
+static bool sender_allowed(const struct sockaddr_storage *from) {
+    if (from->ss_family != AF_INET) {
+        return false;
+    }
+    uint32_t address = ntohl(((const struct sockaddr_in *)from)->sin_addr.s_addr);
+    return (address & allowed_mask) == allowed_network;
+}
+
+/*!
+ * Time after which a sensor should send a dropped reading again.
+ */
+static uint16_t retry_ms(void) {
+#if CONFIG_UBIRCH_RATE_CONTROL
+    // the UPPs, which are waiting, are sent first
+    uint32_t delay_ms = MAX(CONFIG_UBIRCH_INGEST_RETRY_MS, ubirch_rate_control_send_delay_ms());
+    return (uint16_t)MIN(delay_ms, UINT16_MAX);
+#else
+    return CONFIG_UBIRCH_INGEST_RETRY_MS;
+#endif
+}
+
+/*!
+ * Answer the frame \p seq with \p status, to the TCP connection \p fd or to the UDP sender \p to.
+ */
+static void status_send(int fd, const struct sockaddr *to, socklen_t to_len, uint16_t seq, uint8_t status) {
+    uint8_t frame[UBIRCH_INGEST_STATUS_SIZE];
+    put_u16(frame, UBIRCH_INGEST_STATUS_SIZE - UBIRCH_INGEST_LENGTH_SIZE);
+    frame[2] = UBIRCH_INGEST_TYPE_STATUS;
+    put_u16(frame + 3, seq);
+    frame[5] = status;
+    put_u16(frame + 6, (status == UBIRCH_INGEST_STATUS_BUSY) ? retry_ms() : 0);
+    // a status, which does not fit into the send buffer, is not worth waiting for
+    sendto(fd, frame, sizeof(frame), MSG_DONTWAIT, to, to_len);
+}
+
+/*!
+ * Decode a frame into \p slot and commit it, or answer it as invalid.
+ */
+static void frame_handle(sensor_data_t *slot, const uint8_t *frame, size_t len,
+        int fd, const struct sockaddr *from, socklen_t from_len) {
+    uint16_t seq = 0;
+    if (ubirch_ingest_decode(frame, len, slot, &seq) != ESP_OK) {
+        stats.invalid++;
+        ubirch_sensor_slot_release(slot);
+        status_send(fd, from, from_len, seq, UBIRCH_INGEST_STATUS_INVALID);
+        return;
+    }
+    ubirch_sensor_slot_commit(slot);
+    stats.frames++;
+}
+
+static void connection_close(ingest_connection_t *conn) {
+    close(conn->fd);
+    conn->fd = -1;
+    conn->len = 0;
+    stats.connections--;
+}
+
+/*!
+ * Hand the complete frames of \p conn to the anchoring, as long as there are free slots.
+ *
+ * @return false, if the connection lost the framing and has to be closed
+ */
+static bool connection_process(ingest_connection_t *conn) {
+    size_t offset = 0;
+    while (!paused && conn->len - offset >= UBIRCH_INGEST_LENGTH_SIZE) {
+        size_t frame_len = UBIRCH_INGEST_LENGTH_SIZE + get_u16(conn->buffer + offset);
+        if (frame_len < UBIRCH_INGEST_HEADER_SIZE || frame_len > sizeof(conn->buffer)) {
+            stats.invalid++;
+            return false;
+        }
+        if (conn->len - offset < frame_len) {
+            break;
+        }
+        sensor_data_t *slot = ubirch_sensor_slot_acquire(0);
+        if (slot == NULL) {
+            // the rest waits, until a slot is free
+            if (!paused && !stalled) {
+                stats.pauses++;
+            }
+            paused = true;
+            break;
+        }
+        frame_handle(slot, conn->buffer + offset, frame_len, conn->fd, NULL, 0);
+        offset += frame_len;
+    }
+    if (offset > 0) {
+        memmove(conn->buffer, conn->buffer + offset, conn->len - offset);
+        conn->len -= offset;
+    }
+    return true;
+}
+
+static void connection_receive(ingest_connection_t *conn) {
+    ssize_t n = recv(conn->fd, conn->buffer + conn->len, sizeof(conn->buffer) - conn->len, MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        connection_close(conn);
+        return;
+    }
+    if (n > 0) {
+        conn->len += (size_t)n;
+        stats.bytes += (uint64_t)n;
+        if (!connection_process(conn)) {
+            ESP_LOGW(TAG, "connection lost its framing, closed");
+            connection_close(conn);
+        }
+    }
+}
+
+static void connections_accept(void) {
+    for (;;) {
+        struct sockaddr_storage from;
+        socklen_t from_len = sizeof(from);
+        int fd = accept(listen_fd, (struct sockaddr *)&from, &from_len);
+        if (fd < 0) {
+            return;
+        }
+        if (!sender_allowed(&from)) {
+            stats.denied++;
+            close(fd);
+            continue;
+        }
+        ingest_connection_t *conn = NULL;
+        for (size_t i = 0; i < CONFIG_UBIRCH_INGEST_MAX_CONNECTIONS && conn == NULL; ++i) {
+            if (connections[i].fd < 0) {
+                conn = &connections[i];
+            }
+        }
+        if (conn == NULL || nonblocking_set(fd) != ESP_OK) {
+            stats.refused++;
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->len = 0;
+        stats.accepted++;
+        stats.connections++;
+    }
+}
+
+static void udp_receive(void) {
+    uint8_t frame[UBIRCH_INGEST_FRAME_MAX];
+    for (int i = 0; i < INGEST_UDP_BURST; ++i) {
+        struct sockaddr_storage from;
+        socklen_t from_len = sizeof(from);
+        ssize_t n = recvfrom(udp_fd, frame, sizeof(frame), MSG_DONTWAIT, (struct sockaddr *)&from, &from_len);
+        if (n <= 0) {
+            return;
+        }
+        if (!sender_allowed(&from)) {
+            stats.denied++;
+            continue;
+        }
+        stats.bytes += (uint64_t)n;
+        sensor_data_t *slot = ubirch_sensor_slot_acquire(0);
+        if (slot == NULL) {
+            // a datagram cannot wait, the sensor sends it again later
+            stats.busy++;
+            uint16_t seq = (n >= UBIRCH_INGEST_HEADER_SIZE) ? get_u16(frame + 3) : 0;
+            status_send(udp_fd, (struct sockaddr *)&from, from_len, seq, UBIRCH_INGEST_STATUS_BUSY);
+            continue;
+        }
+        frame_handle(slot, frame, (size_t)n, udp_fd, (struct sockaddr *)&from, from_len);
+    }
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-noreturn"
+
+static void ingest_task(void __unused *pvParameters) {
+    UBIRCH_METRICS_TASK_ADD();
+    for (;;) {
+        // the frames, which waited for a slot, before anything new is read
+        stalled = paused;
+        paused = false;
+        for (size_t i = 0; i < CONFIG_UBIRCH_INGEST_MAX_CONNECTIONS; ++i) {
+            if (connections[i].fd >= 0 && connections[i].len > 0 && !connection_process(&connections[i])) {
+                connection_close(&connections[i]);
+            }
+        }
+
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listen_fd, &readable);
+        FD_SET(udp_fd, &readable);
+        int max_fd = MAX(listen_fd, udp_fd);
+        for (size_t i = 0; i < CONFIG_UBIRCH_INGEST_MAX_CONNECTIONS && !paused; ++i) {
+            if (connections[i].fd >= 0) {
+                FD_SET(connections[i].fd, &readable);
+                max_fd = MAX(max_fd, connections[i].fd);
+            }
+        }
+        struct timeval timeout = {
+                .tv_sec = 0,
+                .tv_usec = (paused ? INGEST_PAUSE_MS : INGEST_SELECT_MS) * 1000,
+        };
+        int ready = select(max_fd + 1, &readable, NULL, NULL, &timeout);
+        if (ready < 0) {
+            if (errno != EINTR) {
+                ESP_LOGE(TAG, "select failed: %d", errno);
+                vTaskDelay(pdMS_TO_TICKS(INGEST_SELECT_MS));
+            }
+            continue;
+        }
+        if (ready == 0) {
+            continue;
+        }
+        if (FD_ISSET(listen_fd, &readable)) {
+            connections_accept();
+        }
+        if (FD_ISSET(udp_fd, &readable)) {
+            udp_receive();
+        }
+        for (size_t i = 0; i < CONFIG_UBIRCH_INGEST_MAX_CONNECTIONS && !paused; ++i) {
+            if (connections[i].fd >= 0 && FD_ISSET(connections[i].fd, &readable)) {
+                connection_receive(&connections[i]);
+            }
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+/*!
+ * Open a socket of \p type, bound to the port of the server.
+ */
+static int socket_open(int type) {
+    int fd = socket(AF_INET, type, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr = {
+            .sin_family = AF_INET,
+            .sin_port = htons(CONFIG_UBIRCH_INGEST_PORT),
+            .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || nonblocking_set(fd) != ESP_OK
+            || (type == SOCK_STREAM && listen(fd, INGEST_BACKLOG) != 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+esp_err_t ubirch_ingest_start(void) {
+    if (strlen(CONFIG_UBIRCH_INGEST_ALLOWED_NETWORK) == 0) {
+        ESP_LOGE(TAG, "the network of the sensors is not set");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (allowed_network_parse() != ESP_OK) {
+        ESP_LOGE(TAG, "invalid network of the sensors: %s", CONFIG_UBIRCH_INGEST_ALLOWED_NETWORK);
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < CONFIG_UBIRCH_INGEST_MAX_CONNECTIONS; ++i) {
+        connections[i].fd = -1;
+    }
+    listen_fd = socket_open(SOCK_STREAM);
+    udp_fd = socket_open(SOCK_DGRAM);
+    if (listen_fd < 0 || udp_fd < 0) {
+        ESP_LOGE(TAG, "failed to open port %d: %d", CONFIG_UBIRCH_INGEST_PORT, errno);
+        return ESP_FAIL;
+    }
+    if (UBIRCH_TASK_CREATE(ingest_task, &ingest_task, "ingest", INGEST_PRIORITY, NULL, tskNO_AFFINITY) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "receiving readings of %s on port %d (TCP and UDP)", CONFIG_UBIRCH_INGEST_ALLOWED_NETWORK,
+            CONFIG_UBIRCH_INGEST_PORT);
+    return ESP_OK;
+}
+
+void ubirch_ingest_stats_get(ubirch_ingest_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_ingest_stats_t));
+}
+
+#endif
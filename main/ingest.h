@@ -0,0 +1,118 @@
+/*!
+ * @file ingest.h
+ * @brief Server, which receives the readings of the sensors over the network.
+ *
+ * The sensors send their readings to CONFIG_UBIRCH_INGEST_PORT, over TCP or
+ * UDP, as frames with a length prefix. All numbers are in network byte order:
+ * ```
+ * frame:   length (2) | type (1) | sequence number (2) | body
+ * reading: type 1, body: id length (1) | id | number of values (1) | values (4 each, signed)
+ * status:  type 2, body: status (1) | retry after (2, ms)
+ * ```
+ * The length counts the bytes after it. A TCP connection is a stream of
+ * frames, a UDP datagram is one frame.
+ *
+ * One task serves all connections with select(). Every reading is decoded
+ * directly into a slot of the sensor data pool and committed to the
+ * anchoring. If no slot is free, the task stops reading from the TCP
+ * connections, so their sensors are slowed down by the flow control of TCP,
+ * and answers a reading over UDP with the status "busy", with the time after
+ * which it can be sent again. A frame, which cannot be decoded, is answered
+ * with the status "invalid", a TCP connection, whose length prefix is out of
+ * range, is closed.
+ *
+ * The frames are not authenticated. Connections and datagrams of senders
+ * outside of CONFIG_UBIRCH_INGEST_ALLOWED_NETWORK, which has to be set, are
+ * dropped without an answer. The ID manager creates the contexts of at most
+ * CONFIG_UBIRCH_INGEST_NEW_SENSORS new sensor ids per hour.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_INGEST_H
+#define EXAMPLE_ESP32_INGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#include "sensor_data.h"
+
+#define UBIRCH_INGEST_TYPE_READING 1
+#define UBIRCH_INGEST_TYPE_STATUS 2
+
+#define UBIRCH_INGEST_STATUS_BUSY 1         //!< the reading was dropped, send it again after the retry time
+#define UBIRCH_INGEST_STATUS_INVALID 2      //!< the frame was not decoded
+
+#define UBIRCH_INGEST_LENGTH_SIZE 2
+#define UBIRCH_INGEST_HEADER_SIZE 5
+#define UBIRCH_INGEST_STATUS_SIZE 8
+#define UBIRCH_INGEST_FRAME_MAX (UBIRCH_INGEST_HEADER_SIZE + 1 + UBIRCH_SENSOR_ID_SIZE + 1 \
+        + 4 * CONFIG_UBIRCH_SENSOR_MAX_VALUES)
+
+/*!
+ * Statistics of the ingestion server.
+ */
+typedef struct {
+    uint32_t connections;   //!< open TCP connections
+    uint32_t accepted;      //!< TCP connections accepted
+    uint32_t refused;       //!< TCP connections closed at once, as all were in use
+    uint32_t denied;        //!< TCP connections and UDP readings of senders outside of the network of the sensors
+    uint32_t frames;        //!< readings committed to the anchoring
+    uint64_t bytes;         //!< bytes received
+    uint32_t busy;          //!< UDP readings dropped, as no slot was free
+    uint32_t invalid;       //!< frames, which were not decoded
+    uint32_t pauses;        //!< times the TCP connections were not read, as no slot was free
+} ubirch_ingest_stats_t;
+
+/*!
+ * @brief Open the TCP and UDP sockets and start the server task.
+ *
+ * The sensor data pool has to be initialized before.
+ *
+ * @return ESP_OK, ESP_FAIL if a socket could not be opened, ESP_ERR_INVALID_ARG if
+ *         CONFIG_UBIRCH_INGEST_ALLOWED_NETWORK is invalid, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_ingest_start(void);
+
+/*!
+ * @brief Decode a reading frame into \p data.
+ *
+ * @param[in] frame the frame, with its length prefix
+ * @param[in] len the size of the frame
+ * @param[out] data the slot to fill
+ * @param[out] seq the sequence number of the frame, if the header is complete
+ * @return ESP_OK, or ESP_ERR_INVALID_SIZE or ESP_ERR_INVALID_ARG if the frame is broken
+ */
+esp_err_t ubirch_ingest_decode(const uint8_t *frame, size_t len, sensor_data_t *data, uint16_t *seq);
+
+/*!
+ * @brief Encode a reading frame, like a sensor does.
+ *
+ * @param[out] buffer buffer of at least UBIRCH_INGEST_FRAME_MAX bytes
+ * @return the size of the frame, or 0 if the id or the values are too long
+ */
+size_t ubirch_ingest_encode(uint8_t *buffer, uint16_t seq, const char *id, const int32_t *values, uint16_t num);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_ingest_stats_get(ubirch_ingest_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_INGEST_H */
@@ -0,0 +1,352 @@
+/*!
+ * @file journal.c
+ * @brief Journal of the previous signatures in a flash partition.
+ *
+ * Layout of every sector of the partition:
+ *
+ *     | sector header | record | record | ... | erased (0xFF) |
+ *
+ * The sector header contains a sequence number, which gives the order of
+ * the sectors after a reboot, like in the offline queue. All records have
+ * the same size: a signature record holds the short name of a context and
+ * its new previous signature, a checkpoint record marks, that all contexts
+ * were written to NVS.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_system.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+
+#include "budget.h"
+#include "journal.h"
+#include "onboarding.h"
+
+#if CONFIG_UBIRCH_JOURNAL
+
+static const char *TAG = "journal";
+
+#define JOURNAL_SECTOR_SIZE SPI_FLASH_SEC_SIZE
+#define JOURNAL_SECTOR_MAGIC 0x4a425531
+#define JOURNAL_RECORD_MAGIC 0x4a52
+#define JOURNAL_RECORD_SIGNATURE 0x0001
+#define JOURNAL_RECORD_CHECKPOINT 0x0002
+// time the shutdown waits for the current context, before it leaves the journal to the replay
+#define JOURNAL_SHUTDOWN_WAIT_MS 1000
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+} journal_sector_header_t;
+
+typedef struct {
+    uint16_t magic;
+    uint16_t type;      //!< JOURNAL_RECORD_SIGNATURE or JOURNAL_RECORD_CHECKPOINT
+    uint32_t crc;       //!< CRC32 of type, short name and signature
+    char short_name[UBIRCH_JOURNAL_SHORT_NAME_SIZE];
+    unsigned char signature[UBIRCH_JOURNAL_SIGNATURE_SIZE];
+} journal_record_t;
+
+#define JOURNAL_FIRST_RECORD sizeof(journal_sector_header_t)
+
+static const esp_partition_t *partition = NULL;
+static uint32_t sector_count = 0;
+static uint32_t *sector_seq = NULL;     //!< sequence number of every sector, 0 if unused
+static uint32_t last_seq = 0;
+static uint32_t checkpoint_seq = 0;     //!< sequence number of the sector with the last checkpoint
+static uint32_t head_sector = 0;        //!< sector, which is written
+static size_t head_offset = 0;
+static bool replaying = false;
+static SemaphoreHandle_t journal_lock = NULL;
+UBIRCH_SEMAPHORE_DEFINE(journal_lock);
+static ubirch_journal_reclaim_cb reclaim_cb = NULL;
+static ubirch_journal_stats_t stats = { 0 };
+
+static inline size_t sector_address(uint32_t sector) {
+    return (size_t)sector * JOURNAL_SECTOR_SIZE;
+}
+
+static uint32_t record_crc(const journal_record_t *record) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&record->type, sizeof(record->type));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)record->short_name, UBIRCH_JOURNAL_SHORT_NAME_SIZE);
+    return esp_rom_crc32_le(crc, record->signature, UBIRCH_JOURNAL_SIGNATURE_SIZE);
+}
+
+/*!
+ * Read the record at \p offset of \p sector.
+ *
+ * @return ESP_OK if the record is valid, ESP_ERR_INVALID_CRC if it is
+ *         corrupted, or ESP_ERR_NOT_FOUND if there are no more records
+ */
+static esp_err_t record_read(uint32_t sector, size_t offset, journal_record_t *record) {
+    if (offset + sizeof(journal_record_t) > JOURNAL_SECTOR_SIZE
+            || esp_partition_read(partition, sector_address(sector) + offset,
+                record, sizeof(journal_record_t)) != ESP_OK
+            || record->magic != JOURNAL_RECORD_MAGIC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return (record_crc(record) == record->crc) ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+static esp_err_t sector_open(uint32_t sector) {
+    journal_sector_header_t header = { .magic = JOURNAL_SECTOR_MAGIC, .seq = last_seq + 1 };
+    stats.erases++;
+    if (esp_partition_erase_range(partition, sector_address(sector), JOURNAL_SECTOR_SIZE) != ESP_OK
+            || esp_partition_write(partition, sector_address(sector), &header, sizeof(header)) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open sector %u", sector);
+        sector_seq[sector] = 0;
+        return ESP_FAIL;
+    }
+    last_seq = header.seq;
+    sector_seq[sector] = header.seq;
+    return ESP_OK;
+}
+
+static esp_err_t record_write(journal_record_t *record);
+
+/*!
+ * Write a checkpoint, the contexts have to be stored before.
+ */
+static esp_err_t checkpoint_write(void) {
+    journal_record_t record = { .type = JOURNAL_RECORD_CHECKPOINT };
+    if (record_write(&record) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    checkpoint_seq = sector_seq[head_sector];
+    stats.compactions++;
+    return ESP_OK;
+}
+
+/*!
+ * Continue writing in the next sector, which is the oldest one.
+ *
+ * If the oldest sector holds records after the last checkpoint, the
+ * contexts are stored and a checkpoint is written to the new sector.
+ */
+static esp_err_t head_advance(void) {
+    uint32_t next = (head_sector + 1) % sector_count;
+    bool compact = sector_seq[next] != 0 && sector_seq[next] >= checkpoint_seq;
+    if (compact && reclaim_cb != NULL && reclaim_cb() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to store the contexts, journal full");
+        return ESP_FAIL;
+    }
+    if (sector_open(next) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    head_sector = next;
+    head_offset = JOURNAL_FIRST_RECORD;
+    return compact ? checkpoint_write() : ESP_OK;
+}
+
+static esp_err_t record_write(journal_record_t *record) {
+    if (head_offset + sizeof(journal_record_t) > JOURNAL_SECTOR_SIZE) {
+        esp_err_t err = head_advance();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    record->magic = JOURNAL_RECORD_MAGIC;
+    record->crc = record_crc(record);
+    if (esp_partition_write(partition, sector_address(head_sector) + head_offset,
+                record, sizeof(journal_record_t)) != ESP_OK) {
+        // do not try this part of the sector again
+        head_offset = JOURNAL_SECTOR_SIZE;
+        return ESP_FAIL;
+    }
+    head_offset += sizeof(journal_record_t);
+    return ESP_OK;
+}
+
+/*!
+ * Scan the sectors from the oldest to the newest and find the head and the
+ * last checkpoint, then replay the records after the checkpoint.
+ */
+static void recover(ubirch_journal_replay_cb replay) {
+    uint32_t oldest = 0;
+    uint32_t newest = 0;
+    for (uint32_t sector = 0; sector < sector_count; ++sector) {
+        journal_sector_header_t header;
+        if (esp_partition_read(partition, sector_address(sector), &header, sizeof(header)) != ESP_OK
+                || header.magic != JOURNAL_SECTOR_MAGIC) {
+            continue;
+        }
+        sector_seq[sector] = header.seq;
+        if (header.seq > last_seq) {
+            last_seq = header.seq;
+            newest = sector;
+        }
+        if (sector_seq[oldest] == 0 || header.seq < sector_seq[oldest]) {
+            oldest = sector;
+        }
+    }
+    if (last_seq == 0) {
+        head_sector = sector_count - 1;
+        head_advance();
+        return;
+    }
+
+    journal_record_t record;
+    uint32_t replay_sector = oldest;
+    size_t replay_offset = JOURNAL_FIRST_RECORD;
+    for (uint32_t sector = oldest;; sector = (sector + 1) % sector_count) {
+        size_t offset = JOURNAL_FIRST_RECORD;
+        esp_err_t err;
+        while ((err = record_read(sector, offset, &record)) != ESP_ERR_NOT_FOUND) {
+            offset += sizeof(journal_record_t);
+            if (err == ESP_OK && record.type == JOURNAL_RECORD_CHECKPOINT) {
+                replay_sector = sector;
+                replay_offset = offset;
+                checkpoint_seq = sector_seq[sector];
+            }
+        }
+        if (sector == newest) {
+            head_sector = sector;
+            head_offset = offset;
+            break;
+        }
+    }
+
+    for (uint32_t sector = replay_sector;; sector = (sector + 1) % sector_count) {
+        size_t offset = (sector == replay_sector) ? replay_offset : JOURNAL_FIRST_RECORD;
+        esp_err_t err;
+        while ((err = record_read(sector, offset, &record)) != ESP_ERR_NOT_FOUND) {
+            if (err == ESP_OK && record.type == JOURNAL_RECORD_SIGNATURE) {
+                record.short_name[UBIRCH_JOURNAL_SHORT_NAME_SIZE - 1] = '\0';
+                if (replay != NULL) {
+                    replay(record.short_name, record.signature);
+                }
+                stats.replayed++;
+            } else if (err == ESP_ERR_INVALID_CRC) {
+                ESP_LOGW(TAG, "skip corrupted record");
+            }
+            offset += sizeof(journal_record_t);
+        }
+        if (sector == newest) {
+            break;
+        }
+    }
+
+    // a write could have been interrupted, never write over non-erased flash
+    uint32_t erased[sizeof(journal_record_t) / sizeof(uint32_t)];
+    if (head_offset + sizeof(erased) <= JOURNAL_SECTOR_SIZE
+            && esp_partition_read(partition, sector_address(head_sector) + head_offset,
+                erased, sizeof(erased)) == ESP_OK) {
+        for (size_t i = 0; i < sizeof(erased) / sizeof(uint32_t); ++i) {
+            if (erased[i] != 0xFFFFFFFF) {
+                head_offset = JOURNAL_SECTOR_SIZE;
+                break;
+            }
+        }
+    }
+}
+
+/*!
+ * Store the contexts before a restart, so the next start has nothing to replay.
+ */
+static void journal_shutdown(void) {
+#if CONFIG_UBIRCH_ONBOARDING
+    // the compaction changes the current context, which another task can hold
+    if (!ubirch_onboarding_lock_wait(JOURNAL_SHUTDOWN_WAIT_MS)) {
+        ESP_LOGW(TAG, "current context in use, the journal is replayed at the next start");
+        return;
+    }
+    ubirch_journal_compact();
+    ubirch_onboarding_unlock();
+#else
+    ubirch_journal_compact();
+#endif
+}
+
+esp_err_t ubirch_journal_init(ubirch_journal_replay_cb replay, ubirch_journal_reclaim_cb reclaim) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+            CONFIG_UBIRCH_JOURNAL_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "partition \"%s\" not found", CONFIG_UBIRCH_JOURNAL_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    sector_count = partition->size / JOURNAL_SECTOR_SIZE;
+    sector_seq = calloc(sector_count, sizeof(uint32_t));
+    journal_lock = UBIRCH_MUTEX_CREATE(journal_lock);
+    if (sector_seq == NULL || journal_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    reclaim_cb = reclaim;
+
+    xSemaphoreTake(journal_lock, portMAX_DELAY);
+    replaying = true;
+    recover(replay);
+    replaying = false;
+    xSemaphoreGive(journal_lock);
+    ESP_LOGI(TAG, "%u sectors, %u records replayed", sector_count, (unsigned int)stats.replayed);
+
+    if (esp_register_shutdown_handler(journal_shutdown) != ESP_OK) {
+        ESP_LOGW(TAG, "failed to register shutdown handler");
+    }
+    // the replayed signatures are only in RAM yet
+    return (stats.replayed > 0) ? ubirch_journal_compact() : ESP_OK;
+}
+
+bool ubirch_journal_ready(void) {
+    return journal_lock != NULL;
+}
+
+esp_err_t ubirch_journal_append(const char *short_name, const unsigned char *signature) {
+    if (replaying) {
+        // called by the replay, the lock is taken by ubirch_journal_init()
+        return ESP_OK;
+    } else if (journal_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(journal_lock, portMAX_DELAY);
+    journal_record_t record = { .type = JOURNAL_RECORD_SIGNATURE };
+    strncpy(record.short_name, short_name, UBIRCH_JOURNAL_SHORT_NAME_SIZE - 1);
+    memcpy(record.signature, signature, UBIRCH_JOURNAL_SIGNATURE_SIZE);
+    esp_err_t err = record_write(&record);
+    if (err == ESP_OK) {
+        stats.appends++;
+    }
+    xSemaphoreGive(journal_lock);
+    return err;
+}
+
+esp_err_t ubirch_journal_compact(void) {
+    if (journal_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(journal_lock, portMAX_DELAY);
+    esp_err_t err = (reclaim_cb != NULL) ? reclaim_cb() : ESP_OK;
+    if (err == ESP_OK) {
+        err = checkpoint_write();
+    }
+    xSemaphoreGive(journal_lock);
+    return err;
+}
+
+void ubirch_journal_stats_get(ubirch_journal_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_journal_stats_t));
+}
+
+#endif // CONFIG_UBIRCH_JOURNAL
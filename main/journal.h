@@ -0,0 +1,107 @@
+/*!
+ * @file journal.h
+ * @brief Journal of the previous signatures in a flash partition.
+ *
+ * Every UPP changes the previous signature of its ID context. Instead of
+ * writing the complete context to NVS, the new signature is appended as a
+ * small record to the journal partition. The contexts are written to NVS
+ * by the compaction, before the oldest sector of the journal is reused and
+ * at a restart, which is marked by a checkpoint record. After a reboot, the
+ * records after the last checkpoint are replayed, so every context
+ * continues with the signature of its last UPP.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_JOURNAL_H
+#define EXAMPLE_ESP32_JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#define UBIRCH_JOURNAL_SHORT_NAME_SIZE 16
+#define UBIRCH_JOURNAL_SIGNATURE_SIZE 64
+
+/*!
+ * Function, which is called during ubirch_journal_init() for every record
+ * after the last checkpoint, in the order the records were written.
+ */
+typedef void (*ubirch_journal_replay_cb)(const char *short_name, const unsigned char *signature);
+
+/*!
+ * Function, which writes all contexts with unstored signatures to NVS. It is
+ * called by the compaction, afterwards the records before are not needed anymore.
+ * If it does not return ESP_OK, the journal is not compacted.
+ */
+typedef esp_err_t (*ubirch_journal_reclaim_cb)(void);
+
+/*!
+ * Statistics of the journal.
+ */
+typedef struct {
+    uint32_t appends;       //!< signature records written
+    uint32_t compactions;   //!< checkpoints written after the contexts were stored
+    uint32_t erases;        //!< sectors erased
+    uint32_t replayed;      //!< records replayed at the start
+} ubirch_journal_stats_t;
+
+/*!
+ * @brief Open the journal partition and replay the records after the last checkpoint.
+ *
+ * Appends during the replay are ignored, as the records are in the journal
+ * already. If records were replayed, the journal is compacted afterwards.
+ *
+ * @param[in] replay called for every record after the last checkpoint
+ * @param[in] reclaim called by the compaction
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if there is no journal partition
+ */
+esp_err_t ubirch_journal_init(ubirch_journal_replay_cb replay, ubirch_journal_reclaim_cb reclaim);
+
+/*!
+ * @brief Check, if the journal is available.
+ * @return true, if ubirch_journal_init() opened the journal partition
+ */
+bool ubirch_journal_ready(void);
+
+/*!
+ * @brief Append the new previous signature of a context.
+ *
+ * If the journal is full, it is compacted first.
+ *
+ * @param[in] short_name short name of the context
+ * @param[in] signature the signature of UBIRCH_JOURNAL_SIGNATURE_SIZE bytes
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if the journal is not available,
+ *         or ESP_FAIL on flash errors
+ */
+esp_err_t ubirch_journal_append(const char *short_name, const unsigned char *signature);
+
+/*!
+ * @brief Store all contexts and write a checkpoint.
+ *
+ * @return ESP_OK, or ESP_FAIL if the contexts or the checkpoint could not be written
+ */
+esp_err_t ubirch_journal_compact(void);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_journal_stats_get(ubirch_journal_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_JOURNAL_H */
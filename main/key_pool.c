@@ -0,0 +1,145 @@
+/*!
+ * @file key_pool.c
+ * @brief Pool of key pairs, which are generated in the background.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <ubirch_ed25519.h>
+
+#include "budget.h"
+#include "key_pool.h"
+
+#if CONFIG_UBIRCH_KEY_POOL
+
+static const char *TAG = "key_pool";
+
+#define KEY_POOL_PRIORITY tskIDLE_PRIORITY
+
+/*!
+ * One pre-generated key pair.
+ */
+typedef struct {
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+    unsigned char secret_key[crypto_sign_SECRETKEYBYTES];
+} key_pool_pair_t;
+
+static key_pool_pair_t pairs[CONFIG_UBIRCH_KEY_POOL_SIZE];
+static size_t count = 0;
+static bool filled = false;
+static SemaphoreHandle_t pool_lock = NULL;
+static TaskHandle_t pool_task_handle = NULL;
+UBIRCH_SEMAPHORE_DEFINE(pool_lock);
+UBIRCH_TASK_DEFINE(key_pool_task, 4096);
+static ubirch_key_pool_stats_t stats = { 0 };
+
+/*!
+ * Erase a secret, which the compiler must not leave out.
+ */
+static void key_pool_wipe(void *secret, size_t len) {
+    volatile unsigned char *p = secret;
+    while (len-- > 0) {
+        *p++ = 0;
+    }
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-noreturn"
+
+static void key_pool_task(void __unused *pvParameters) {
+    key_pool_pair_t pair;
+    for (;;) {
+        xSemaphoreTake(pool_lock, portMAX_DELAY);
+        bool full = (count == CONFIG_UBIRCH_KEY_POOL_SIZE);
+        xSemaphoreGive(pool_lock);
+        if (full) {
+            // a taken pair wakes the task up
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        crypto_sign_keypair(pair.public_key, pair.secret_key);
+        xSemaphoreTake(pool_lock, portMAX_DELAY);
+        memcpy(&pairs[count++], &pair, sizeof(pair));
+        stats.generated++;
+        if (count == CONFIG_UBIRCH_KEY_POOL_SIZE && !filled) {
+            filled = true;
+            stats.min_available = CONFIG_UBIRCH_KEY_POOL_SIZE;
+            ESP_LOGI(TAG, "%u key pairs ready", CONFIG_UBIRCH_KEY_POOL_SIZE);
+        }
+        xSemaphoreGive(pool_lock);
+        key_pool_wipe(&pair, sizeof(pair));
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_UBIRCH_KEY_POOL_REFILL_MS));
+    }
+}
+
+#pragma GCC diagnostic pop
+
+esp_err_t ubirch_key_pool_start(void) {
+    pool_lock = UBIRCH_MUTEX_CREATE(pool_lock);
+    if (pool_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (UBIRCH_TASK_CREATE(key_pool_task, &key_pool_task, "key_pool", KEY_POOL_PRIORITY, &pool_task_handle,
+            tskNO_AFFINITY) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ubirch_key_pool_take(unsigned char *public_key, unsigned char *secret_key) {
+    if (pool_task_handle == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    if (count == 0) {
+        stats.missed++;
+        xSemaphoreGive(pool_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    key_pool_pair_t *pair = &pairs[--count];
+    memcpy(public_key, pair->public_key, crypto_sign_PUBLICKEYBYTES);
+    memcpy(secret_key, pair->secret_key, crypto_sign_SECRETKEYBYTES);
+    key_pool_wipe(pair, sizeof(key_pool_pair_t));
+    stats.taken++;
+    if (filled && count < stats.min_available) {
+        stats.min_available = count;
+    }
+    xSemaphoreGive(pool_lock);
+    xTaskNotifyGive(pool_task_handle);
+    return ESP_OK;
+}
+
+void ubirch_key_pool_stats_get(ubirch_key_pool_stats_t *out) {
+    if (pool_lock != NULL) {
+        xSemaphoreTake(pool_lock, portMAX_DELAY);
+    }
+    memcpy(out, &stats, sizeof(ubirch_key_pool_stats_t));
+    out->available = count;
+    if (pool_lock != NULL) {
+        xSemaphoreGive(pool_lock);
+    }
+}
+
+#endif
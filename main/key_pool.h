@@ -0,0 +1,74 @@
+/*!
+ * @file key_pool.h
+ * @brief Pool of key pairs, which are generated in the background.
+ *
+ * The ID manager needs a key pair for every new context and every key
+ * update, which the onboarding would wait for. It takes the pair from the
+ * pool instead, which a task at idle priority fills up again. Only if the
+ * pool is empty, the pair is generated at once, like before.
+ *
+ * The pairs are kept in RAM only, like the secret keys in the ID context
+ * cache, so a pair never reaches the flash before it belongs to a context,
+ * which is then stored like every other context. A taken pair is erased
+ * from the pool. The pool is generated again after a restart.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_KEY_POOL_H
+#define EXAMPLE_ESP32_KEY_POOL_H
+
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * Statistics of the key pool.
+ */
+typedef struct {
+    uint32_t generated;     //!< pairs generated by the pool task
+    uint32_t taken;         //!< pairs taken from the pool
+    uint32_t missed;        //!< pairs generated at once, as the pool was empty
+    uint32_t available;     //!< pairs in the pool
+    uint32_t min_available; //!< lowest number of pairs in the pool, after it was filled once
+} ubirch_key_pool_stats_t;
+
+/*!
+ * @brief Start the task, which fills the pool.
+ *
+ * Until then, the key pairs are generated at once.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_key_pool_start(void);
+
+/*!
+ * @brief Take a key pair from the pool.
+ *
+ * @param[out] public_key buffer of crypto_sign_PUBLICKEYBYTES
+ * @param[out] secret_key buffer of crypto_sign_SECRETKEYBYTES
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if the pool is empty
+ */
+esp_err_t ubirch_key_pool_take(unsigned char *public_key, unsigned char *secret_key);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_key_pool_stats_get(ubirch_key_pool_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_KEY_POOL_H */
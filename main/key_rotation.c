@@ -0,0 +1,257 @@
+/*!
+ * @file key_rotation.c
+ * @brief Scheduler of the key rotations of the identity contexts.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_system.h>
+
+#include "budget.h"
+#include "metrics.h"
+#include "sensor_data.h"
+#include "onboarding.h"
+#include "key_rotation.h"
+
+#if CONFIG_UBIRCH_KEY_ROTATION
+
+static const char *TAG = "key_rotation";
+
+#define KEY_ROTATION_PRIORITY 4
+#define KEY_ROTATION_POLL_MS 60000
+// open addressing with linear probing, at most half of the slots are used
+#define KEY_ROTATION_INDEX_SIZE (2 * CONFIG_UBIRCH_KEY_ROTATION_CONTEXTS)
+
+/*!
+ * Scheduled key rotation of a context.
+ */
+typedef struct {
+    char id[UBIRCH_SENSOR_ID_SIZE];
+    time_t due;             //!< time of the rotation, or of the next request, if it is pending
+    uint16_t heap_pos;      //!< position of the entry in the heap
+    bool pending;           //!< the rotation was handed to the onboarding worker
+} key_rotation_entry_t;
+
+static key_rotation_entry_t entries[CONFIG_UBIRCH_KEY_ROTATION_CONTEXTS];
+static uint16_t heap[CONFIG_UBIRCH_KEY_ROTATION_CONTEXTS];     //!< entry indexes, ordered by due
+static uint16_t index_slots[KEY_ROTATION_INDEX_SIZE];           //!< entry index + 1, 0 if the slot is free
+static uint16_t entry_count = 0;
+
+static SemaphoreHandle_t table_lock = NULL;
+static TaskHandle_t scheduler_handle = NULL;
+UBIRCH_SEMAPHORE_DEFINE(table_lock);
+UBIRCH_TASK_DEFINE(key_rotation_task, 3072);
+static ubirch_key_rotation_stats_t stats = { 0 };
+
+/*!
+ * FNV-1a hash of the sensor id.
+ */
+static uint32_t id_hash(const char *id) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < UBIRCH_SENSOR_ID_SIZE && id[i] != '\0'; ++i) {
+        hash = (hash ^ (uint8_t)id[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/*!
+ * Find the index slot of \p id, which is either its entry or the free slot,
+ * where it belongs.
+ */
+static uint16_t *index_find(const char *id) {
+    size_t slot = id_hash(id) % KEY_ROTATION_INDEX_SIZE;
+    while (index_slots[slot] != 0
+            && strncmp(entries[index_slots[slot] - 1].id, id, UBIRCH_SENSOR_ID_SIZE) != 0) {
+        slot = (slot + 1) % KEY_ROTATION_INDEX_SIZE;
+    }
+    return &index_slots[slot];
+}
+
+static void heap_set(uint16_t pos, uint16_t entry) {
+    heap[pos] = entry;
+    entries[entry].heap_pos = pos;
+}
+
+static void heap_sift_up(uint16_t pos) {
+    uint16_t entry = heap[pos];
+    while (pos > 0) {
+        uint16_t parent = (uint16_t)((pos - 1) / 2);
+        if (entries[heap[parent]].due <= entries[entry].due) {
+            break;
+        }
+        heap_set(pos, heap[parent]);
+        pos = parent;
+    }
+    heap_set(pos, entry);
+}
+
+static void heap_sift_down(uint16_t pos) {
+    uint16_t entry = heap[pos];
+    for (;;) {
+        uint16_t child = (uint16_t)(2 * pos + 1);
+        if (child >= entry_count) {
+            break;
+        }
+        if (child + 1 < entry_count && entries[heap[child + 1]].due < entries[heap[child]].due) {
+            child++;
+        }
+        if (entries[entry].due <= entries[heap[child]].due) {
+            break;
+        }
+        heap_set(pos, heap[child]);
+        pos = child;
+    }
+    heap_set(pos, entry);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-noreturn"
+
+/*!
+ * Scheduler task: hand the due rotations to the onboarding worker, one per interval.
+ */
+static void key_rotation_task(void __unused *pvParameters) {
+    TickType_t last_request = 0;
+    bool requested = false;
+    UBIRCH_METRICS_TASK_ADD();
+    for (;;) {
+        char id[UBIRCH_SENSOR_ID_SIZE];
+        bool request = false;
+        // the system time can jump with its synchronization, so the heap is checked regularly
+        TickType_t wait = pdMS_TO_TICKS(KEY_ROTATION_POLL_MS);
+        time_t now = time(NULL);
+
+        xSemaphoreTake(table_lock, portMAX_DELAY);
+        if (entry_count > 0) {
+            key_rotation_entry_t *entry = &entries[heap[0]];
+            TickType_t since = xTaskGetTickCount() - last_request;
+            if (entry->due > now) {
+                if ((int64_t)(entry->due - now) * 1000 < KEY_ROTATION_POLL_MS) {
+                    wait = pdMS_TO_TICKS((entry->due - now) * 1000);
+                }
+            } else if (requested && since < pdMS_TO_TICKS(CONFIG_UBIRCH_KEY_ROTATION_INTERVAL_MS)) {
+                wait = pdMS_TO_TICKS(CONFIG_UBIRCH_KEY_ROTATION_INTERVAL_MS) - since;
+            } else {
+                // the rotation is requested again, if the worker did not do it until then
+                entry->pending = true;
+                entry->due = now + CONFIG_UBIRCH_KEY_ROTATION_RETRY_S;
+                heap_sift_down(0);
+                memcpy(id, entry->id, UBIRCH_SENSOR_ID_SIZE);
+                request = true;
+                stats.requested++;
+            }
+        }
+        xSemaphoreGive(table_lock);
+
+        if (request) {
+            ESP_LOGI(TAG, "key rotation of \"%s\" is due", id);
+            if (ubirch_onboarding_request(id) != ESP_OK) {
+                ESP_LOGW(TAG, "onboarding queue full, key rotation of \"%s\" postponed", id);
+            }
+            last_request = xTaskGetTickCount();
+            requested = true;
+            continue;
+        }
+        // a new context at the top of the heap wakes the scheduler up earlier
+        ulTaskNotifyTake(pdTRUE, wait + 1);
+    }
+}
+
+#pragma GCC diagnostic pop
+
+esp_err_t ubirch_key_rotation_start(void) {
+    memset(entries, 0, sizeof(entries));
+    memset(index_slots, 0, sizeof(index_slots));
+    memset(&stats, 0, sizeof(stats));
+    entry_count = 0;
+
+    table_lock = UBIRCH_MUTEX_CREATE(table_lock);
+    if (table_lock == NULL) {
+        ESP_LOGE(TAG, "failed to create lock");
+        return ESP_ERR_NO_MEM;
+    }
+    if (UBIRCH_TASK_CREATE(key_rotation_task, &key_rotation_task, "key_rotation", KEY_ROTATION_PRIORITY,
+            &scheduler_handle, tskNO_AFFINITY) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+ubirch_key_rotation_state_t ubirch_key_rotation_get(const char *id) {
+    if (table_lock == NULL) {
+        return UBIRCH_KEY_ROTATION_UNKNOWN;
+    }
+    xSemaphoreTake(table_lock, portMAX_DELAY);
+    uint16_t slot = *index_find(id);
+    ubirch_key_rotation_state_t state = (slot == 0) ? UBIRCH_KEY_ROTATION_UNKNOWN
+            : (entries[slot - 1].pending ? UBIRCH_KEY_ROTATION_PENDING : UBIRCH_KEY_ROTATION_SCHEDULED);
+    xSemaphoreGive(table_lock);
+    return state;
+}
+
+esp_err_t ubirch_key_rotation_schedule(const char *id, time_t next_key_update, bool rotated) {
+    if (table_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // rotating a key early is fine, so the rotations are spread before the expiry
+    time_t due = next_key_update - (time_t)(esp_random() % (CONFIG_UBIRCH_KEY_ROTATION_JITTER_S + 1u));
+
+    xSemaphoreTake(table_lock, portMAX_DELAY);
+    uint16_t *slot = index_find(id);
+    if (*slot == 0) {
+        if (entry_count >= CONFIG_UBIRCH_KEY_ROTATION_CONTEXTS) {
+            stats.rejected++;
+            xSemaphoreGive(table_lock);
+            ESP_LOGW(TAG, "schedule full, \"%s\" is checked with every message", id);
+            return ESP_ERR_NO_MEM;
+        }
+        key_rotation_entry_t *entry = &entries[entry_count];
+        memset(entry, 0, sizeof(key_rotation_entry_t));
+        strncpy(entry->id, id, UBIRCH_SENSOR_ID_SIZE - 1);
+        heap_set(entry_count, entry_count);
+        *slot = (uint16_t)(++entry_count);
+        stats.scheduled++;
+    }
+    key_rotation_entry_t *entry = &entries[*slot - 1];
+    entry->due = due;
+    entry->pending = false;
+    heap_sift_up(entry->heap_pos);
+    heap_sift_down(entry->heap_pos);
+    bool first = (heap[0] == *slot - 1);
+    if (rotated) {
+        stats.rotated++;
+    }
+    xSemaphoreGive(table_lock);
+
+    if (first) {
+        xTaskNotifyGive(scheduler_handle);
+    }
+    return ESP_OK;
+}
+
+void ubirch_key_rotation_stats_get(ubirch_key_rotation_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_key_rotation_stats_t));
+}
+
+#endif // CONFIG_UBIRCH_KEY_ROTATION
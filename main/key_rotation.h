@@ -0,0 +1,96 @@
+/*!
+ * @file key_rotation.h
+ * @brief Scheduler of the key rotations of the identity contexts.
+ *
+ * The times of the next key updates are kept in a min-heap in RAM. A
+ * scheduler task marks the context, which is due next, as "rotation
+ * pending" and hands the key update to the onboarding worker. The data path
+ * only looks up the state of its context and keeps signing with the old
+ * key, until the worker rotated it.
+ *
+ * Keys of contexts, which were created at the same time, also expire at the
+ * same time. Every rotation is therefore moved forward by a random part,
+ * and the scheduler requests one rotation per interval at most.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_KEY_ROTATION_H
+#define EXAMPLE_ESP32_KEY_ROTATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <esp_err.h>
+
+/*!
+ * State of the key rotation of a context.
+ */
+typedef enum {
+    UBIRCH_KEY_ROTATION_UNKNOWN = 0,    //!< the context is not scheduled
+    UBIRCH_KEY_ROTATION_SCHEDULED,      //!< the key is valid, its rotation is scheduled
+    UBIRCH_KEY_ROTATION_PENDING,        //!< the key is due, the worker rotates it
+} ubirch_key_rotation_state_t;
+
+/*!
+ * Statistics of the key rotation scheduler.
+ */
+typedef struct {
+    uint32_t scheduled;     //!< contexts taken into the schedule
+    uint32_t rejected;      //!< contexts not scheduled, as the schedule was full
+    uint32_t requested;     //!< rotations handed to the onboarding worker
+    uint32_t rotated;       //!< rotations done
+} ubirch_key_rotation_stats_t;
+
+/*!
+ * @brief Start the scheduler task.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_key_rotation_start(void);
+
+/*!
+ * @brief Get the state of the key rotation of the sensor \p id.
+ *
+ * This is a hash table lookup, which is cheap enough for every message.
+ *
+ * @param[in] id the sensor id
+ * @return the state of the rotation
+ */
+ubirch_key_rotation_state_t ubirch_key_rotation_get(const char *id);
+
+/*!
+ * @brief Schedule the next key rotation of the sensor \p id.
+ *
+ * Takes the context into the schedule, or moves it to the new time after
+ * its key was updated. The pending mark of the context is cleared.
+ *
+ * @param[in] id the sensor id
+ * @param[in] next_key_update time of the next key update of the context
+ * @param[in] rotated true, if the key of the context was just rotated
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the schedule is full
+ */
+esp_err_t ubirch_key_rotation_schedule(const char *id, time_t next_key_update, bool rotated);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_key_rotation_stats_get(ubirch_key_rotation_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_KEY_ROTATION_H */
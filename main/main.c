@@ -26,20 +26,43 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
-#include <freertos/ringbuf.h>
 #include <esp_log.h>
 #include <networking.h>
 #include <sntp_time.h>
 #include <nvs_flash.h>
 #include <ubirch_ota_task.h>
 #include <ubirch_ota.h>
+#include <stdio.h>
 #include <time.h>
+#include <sys/param.h>
 
 #include "storage.h"
 #include "key_handling.h"
 #include "token_handling.h"
 #include "anchor.h"
+#include "binlog.h"
+#include "boot.h"
+#include "breaker.h"
+#include "budget.h"
+#include "delta_ota.h"
+#include "heap_audit.h"
+#include "http_pool.h"
+#include "id_cache.h"
 #include "id_manager.h"
+#include "ingest.h"
+#include "key_pool.h"
+#include "merkle.h"
+#include "metrics.h"
+#include "onboarding.h"
+#include "key_rotation.h"
+#include "pipeline.h"
+#include "rate_control.h"
+#include "sensor_data.h"
+#include "sensor_index.h"
+#include "series.h"
+#include "signer.h"
+#include "upp_queue.h"
+#include "verify_batch.h"
 
 char *TAG = "example-gateway";
 
@@ -47,63 +70,169 @@ char *TAG = "example-gateway";
 static TaskHandle_t fw_update_task_handle = NULL;
 static TaskHandle_t net_config_handle = NULL;
 static TaskHandle_t main_task_handle = NULL;
+#if !CONFIG_IDF_TARGET_LINUX && !CONFIG_UBIRCH_INGEST
 static TaskHandle_t sensor_simulator_task_handle = NULL;
+UBIRCH_TASK_DEFINE(sensor_simulator_task, 2048);
+#endif
+#if !CONFIG_UBIRCH_PIPELINE
+// with the pipeline, main_task ends after the start and its stack goes back to the heap
+UBIRCH_TASK_DEFINE(main_task, CONFIG_UBIRCH_STACK_MAIN);
+#endif
+#if CONFIG_UBIRCH_DELTA_OTA
+UBIRCH_TASK_DEFINE(fw_update_task, 4096);
+#endif
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmissing-noreturn"
 
-/*!
- * Simulation data
- */
-typedef struct {
-    char id[16];
-    int32_t data;
-} sensor_data_t;
-
+#if !CONFIG_IDF_TARGET_LINUX && !CONFIG_UBIRCH_INGEST
 static int32_t dummy_data = 0;
 
 /*!
  * Sensor simulator task simulates incoming sensor data.
  */
-static void sensor_simulator_task(void *pvParameters) {
-    RingbufHandle_t buf_handle = *(RingbufHandle_t*)pvParameters;
-
+static void sensor_simulator_task(void __unused *pvParameters) {
     // TODO: at startup create a set of sensor-id's, or use a fix set
     char sensors[2][15] = {"test_alpha", "test_beta"};
     size_t number_of_sensors = ((sizeof sensors) / (sizeof *sensors));
 
-    EventBits_t event_bits;
-
     // give system some time to start up
     vTaskDelay(pdMS_TO_TICKS(6000));
+    UBIRCH_METRICS_TASK_ADD();
 
     // loop through the sensors
     for (size_t sensor_index = 0;; sensor_index = (sensor_index + 1) % number_of_sensors) {
-        // check if network connection is up
-        event_bits = xEventGroupWaitBits(network_event_group, WIFI_CONNECTED_BIT | NETWORK_ETH_READY,
+#if !CONFIG_UBIRCH_OFFLINE_QUEUE && !CONFIG_UBIRCH_PIPELINE
+        // check if network connection is up, the offline queue and the pipeline accept data without
+        EventBits_t event_bits = xEventGroupWaitBits(network_event_group, WIFI_CONNECTED_BIT | NETWORK_ETH_READY,
                                          false, false, portMAX_DELAY);
         if ((event_bits & WIFI_CONNECTED_BIT) != WIFI_CONNECTED_BIT) {
             ESP_LOGW(TAG, "network not ready");
             vTaskDelay(pdMS_TO_TICKS(2000));
             continue;
         }
+#endif
 
-        ESP_LOGI(TAG, "Simulate sensor data from sensor %s", sensors[sensor_index]);
-        sensor_data_t data = {};
-        strcpy(data.id, sensors[sensor_index]);
-        data.data = dummy_data++;
-
-        // send it to main task
-        UBaseType_t res =  xRingbufferSend(buf_handle, &data, sizeof(sensor_data_t),
-                pdMS_TO_TICKS(1000));
-        if (res != pdTRUE) {
+        UBIRCH_LOG_STR(ESP_LOG_INFO, TAG, "Simulate sensor data from sensor %s", sensors[sensor_index]);
+        // fill the data directly into a slot of the pool
+        sensor_data_t *data = ubirch_sensor_slot_acquire(pdMS_TO_TICKS(1000));
+        if (data == NULL) {
             ESP_LOGE(TAG, "Failed to send sensor data");
+            vTaskDelay(pdMS_TO_TICKS(6000));
+            continue;
         }
+        strcpy(data->id, sensors[sensor_index]);
+        // every sensor has a different number of channels
+        data->num = (uint16_t)MIN(sensor_index + 1, CONFIG_UBIRCH_SENSOR_MAX_VALUES);
+        for (uint16_t i = 0; i < data->num; ++i) {
+            data->values[i] = dummy_data++;
+        }
+
+        // send it to main task
+        ubirch_sensor_slot_commit(data);
 
+#if CONFIG_UBIRCH_RATE_CONTROL
+        // every sensor sends once per interval of the backend, or less often if the backend is busy
+        vTaskDelay(pdMS_TO_TICKS(ubirch_rate_control_sensor_interval_ms(number_of_sensors) / number_of_sensors));
+#else
         vTaskDelay(pdMS_TO_TICKS(6000));
+#endif
+    }
+}
+#endif
+
+/*!
+ * Anchor a payload with the ID context of the sensor \p id, see anchor_payload().
+ *
+ * @return ESP_OK, UBIRCH_ID_CONTEXT_PENDING if the sensor waits for its onboarding, or an error
+ */
+static esp_err_t anchor_in_context(const char *id, const char *payload, size_t len) {
+    // manage the current ID context
+    char context_id[UBIRCH_SENSOR_ID_SIZE];
+    snprintf(context_id, sizeof(context_id), "%s", id);
+    UBIRCH_METRICS_SPAN(manage);
+    esp_err_t err = ubirch_id_context_manage(context_id);
+    UBIRCH_METRICS_STOP(UBIRCH_METRICS_MANAGE, manage);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // note: if we end up here we have a valid context that we can use
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+    // create UPP, sign it and store it until it is delivered
+    err = ubirch_anchor_enqueue_payload(payload, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to queue UPP");
+    }
+#else
+    // create UPP, sign it and send it to the ubirch backend
+    UBIRCH_LOGI(TAG, "create, sign and send UPP to backend");
+    err = ubirch_anchor_data_payload(payload, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "failed to anchor at ubirch backend");
+    }
+#endif
+#if CONFIG_UBIRCH_HEAP_AUDIT
+    ubirch_heap_audit_message();
+#endif
+    return err;
+}
+
+/*!
+ * Anchor a payload with the ID context of the sensor \p id.
+ *
+ * This is also the sink of the time series, which anchors complete windows,
+ * of the Merkle aggregation, which anchors the roots of the epochs, and of
+ * the payloads, which were parked during the onboarding of their sensor.
+ */
+static esp_err_t anchor_payload(const char *id, const char *payload, size_t len, int64_t __unused started) {
+#if CONFIG_UBIRCH_ONBOARDING
+    // the onboarding worker must not change the current context, until the UPP is signed
+    ubirch_onboarding_lock();
+    esp_err_t err = anchor_in_context(id, payload, len);
+    ubirch_onboarding_unlock();
+    if (err == UBIRCH_ID_CONTEXT_PENDING) {
+        // the sensor is new, its payload is anchored when its onboarding is done
+        err = ubirch_onboarding_park(id, payload, len, started);
     }
+    return err;
+#else
+    return anchor_in_context(id, payload, len);
+#endif
 }
 
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+/*!
+ * Forward a burst of queued UPPs, which can change the current context.
+ */
+static esp_err_t queue_forward(void) {
+#if CONFIG_UBIRCH_ONBOARDING
+    ubirch_onboarding_lock();
+    esp_err_t err = ubirch_anchor_queue_forward(CONFIG_UBIRCH_QUEUE_FORWARD_BURST);
+    ubirch_onboarding_unlock();
+    return err;
+#else
+    return ubirch_anchor_queue_forward(CONFIG_UBIRCH_QUEUE_FORWARD_BURST);
+#endif
+}
+#endif
+
+#if CONFIG_UBIRCH_ANCHOR_PENDING > 0
+/*!
+ * Send the UPPs, which could not be delivered before, which can change the current context.
+ */
+static esp_err_t pending_forward(void) {
+#if CONFIG_UBIRCH_ONBOARDING
+    ubirch_onboarding_lock();
+    esp_err_t err = ubirch_anchor_pending_forward();
+    ubirch_onboarding_unlock();
+    return err;
+#else
+    return ubirch_anchor_pending_forward();
+#endif
+}
+#endif
+
 /*!
  * Main task performs the main functionality of the application,
  * when the network is set up.
@@ -115,10 +244,15 @@ static void sensor_simulator_task(void *pvParameters) {
  *
  * @param pvParameters are currently not used, but part of the task declaration.
  */
-static void main_task(void *pvParameters) {
-    RingbufHandle_t buf_handle = *(RingbufHandle_t*)pvParameters;
+static void main_task(void __unused *pvParameters) {
     EventBits_t event_bits;
 
+#if CONFIG_UBIRCH_METRICS
+    if (ubirch_metrics_init() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start the metrics log");
+    }
+#endif
+
     // load backend key
     if (load_backend_key() != ESP_OK) {
         ESP_LOGW(TAG, "unable to load backend key");
@@ -128,8 +262,119 @@ static void main_task(void *pvParameters) {
     if (ubirch_token_load() != ESP_OK) {
         ESP_LOGE(TAG, "failed to load token");
     }
+    UBIRCH_BOOT_MARK(UBIRCH_BOOT_KEYS_LOADED);
+#if CONFIG_UBIRCH_KEY_POOL
+    // the pool is filled while the network connects, so the first new sensors find their key pairs
+    if (ubirch_key_pool_start() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start the key pool, key pairs are generated on demand");
+    }
+#endif
+
+    ubirch_id_cache_init();
+#if CONFIG_UBIRCH_SENSOR_INDEX
+    if (ubirch_sensor_index_init() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open the sensor index, the short names are the beginning of the sensor ids");
+    }
+#endif
+#if CONFIG_UBIRCH_FAST_BOOT
+    // the contexts of the sensors, which sent last, are ready before their first reading
+    ubirch_boot_contexts_prefetch();
+#endif
+    if (ubirch_anchor_init() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to allocate the anchoring buffers");
+    }
+#if CONFIG_UBIRCH_RATE_CONTROL
+    if (ubirch_rate_control_init() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to initialize the rate control, UPPs are sent unpaced");
+    }
+#endif
+#if CONFIG_UBIRCH_BREAKER
+    if (ubirch_breaker_init() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to initialize the circuit breaker");
+    }
+#endif
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+    if (ubirch_http_pool_init() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to create connection pool");
+    }
+#endif
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+    ubirch_anchor_queue_init();
+#endif
+#if CONFIG_UBIRCH_SERIES
+    ubirch_series_init();
+#elif CONFIG_UBIRCH_MERKLE
+    if (ubirch_merkle_init() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open the Merkle proof partition");
+    }
+#if CONFIG_UBIRCH_MERKLE_BENCHMARK
+    ubirch_merkle_benchmark_start();
+#endif
+#endif
+#if CONFIG_UBIRCH_BINLOG_BENCHMARK
+    ubirch_binlog_benchmark();
+#endif
+#if CONFIG_UBIRCH_VERIFY_BATCH_BENCHMARK
+    ubirch_verify_batch_benchmark();
+#endif
+#if CONFIG_UBIRCH_FAST_SIGN_BENCHMARK
+    ubirch_signer_benchmark_t sign_rates;
+    ubirch_signer_benchmark(32, &sign_rates);
+    ESP_LOGI(TAG, "ed25519: %u signs/s with NaCl, %u signs/s with the signer, %u verifies/s",
+            (unsigned int)sign_rates.nacl_signs, (unsigned int)sign_rates.signs, (unsigned int)sign_rates.verifies);
+#endif
+
+#if CONFIG_UBIRCH_HEAP_AUDIT
+    ubirch_heap_audit_init();
+#endif
 
+#if CONFIG_UBIRCH_ONBOARDING
+    // new sensors are onboarded by the worker, the queued UPPs are replayed before
+    if (ubirch_onboarding_start() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start the onboarding worker");
+    }
+#endif
+#if CONFIG_UBIRCH_KEY_ROTATION
+    if (ubirch_key_rotation_start() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start the key rotation scheduler");
+    }
+#endif
+
+#if CONFIG_UBIRCH_PIPELINE
+    // the pipeline stages take over the anchoring
+    if (ubirch_pipeline_start() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start the anchoring pipeline");
+    }
+    UBIRCH_BOOT_MARK(UBIRCH_BOOT_ANCHOR_READY);
+    ubirch_budget_task_remove(main_task_handle);
+    main_task_handle = NULL;
+    vTaskDelete(NULL);
+#endif
+
+    UBIRCH_BOOT_MARK(UBIRCH_BOOT_ANCHOR_READY);
+    UBIRCH_METRICS_TASK_ADD();
     for (;;) {
+        TickType_t receive_timeout = pdMS_TO_TICKS(30000);
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+        // sensor data is queued while the network is down,
+        // the queued UPPs are forwarded in bursts as soon as it is up again
+        event_bits = xEventGroupGetBits(network_event_group);
+        if (ubirch_queue_count() > 0) {
+            receive_timeout = pdMS_TO_TICKS(2000);
+            if ((event_bits & WIFI_CONNECTED_BIT) == WIFI_CONNECTED_BIT
+                    && queue_forward() == ESP_OK) {
+                receive_timeout = pdMS_TO_TICKS(CONFIG_UBIRCH_QUEUE_FORWARD_PAUSE_MS);
+            }
+#if CONFIG_UBIRCH_RATE_CONTROL
+            // the next burst starts, when the next UPP is due
+            receive_timeout = MAX(receive_timeout, pdMS_TO_TICKS(ubirch_rate_control_send_delay_ms()));
+#endif
+        }
+#if CONFIG_UBIRCH_RATE_CONTROL
+        ubirch_rate_control_backlog_set(ubirch_queue_count());
+#endif
+        UBIRCH_METRICS_GAUGE(UBIRCH_METRICS_BACKLOG, ubirch_queue_count());
+#else
         // check if network connection is up
         event_bits = xEventGroupWaitBits(network_event_group, WIFI_CONNECTED_BIT | NETWORK_ETH_READY,
                                          false, false, portMAX_DELAY);
@@ -138,31 +383,132 @@ static void main_task(void *pvParameters) {
             vTaskDelay(pdMS_TO_TICKS(2000));
             continue;
         }
+#endif
+
+#if CONFIG_UBIRCH_ONBOARDING
+        // payloads of sensors, which were onboarded in the meantime
+        int32_t onboarding_timeout = ubirch_onboarding_timeout_ms();
+        if (onboarding_timeout == 0) {
+            ubirch_onboarding_replay(anchor_payload);
+        } else if (onboarding_timeout > 0) {
+            receive_timeout = MIN(receive_timeout, pdMS_TO_TICKS(onboarding_timeout));
+        }
+#endif
+
+#if CONFIG_UBIRCH_SERIES
+        // windows of sensors, which stopped sending, are anchored when they get too old
+        int32_t series_timeout = ubirch_series_timeout_ms();
+        if (series_timeout == 0) {
+            ubirch_series_flush(anchor_payload, false);
+        } else if (series_timeout > 0) {
+            receive_timeout = MIN(receive_timeout, pdMS_TO_TICKS(series_timeout));
+        }
+#elif CONFIG_UBIRCH_MERKLE
+        // epochs of sensors, which stopped sending, are closed when they are over
+        int32_t merkle_timeout = ubirch_merkle_timeout_ms();
+        if (merkle_timeout == 0) {
+            ubirch_merkle_flush(anchor_payload, false);
+        } else if (merkle_timeout > 0) {
+            receive_timeout = MIN(receive_timeout, pdMS_TO_TICKS(merkle_timeout));
+        }
+#endif
+
+#if CONFIG_UBIRCH_ANCHOR_PENDING > 0
+        // UPPs, which could not be delivered, are sent again when their next attempt is due
+        int32_t pending_timeout = ubirch_anchor_pending_timeout_ms();
+        if (pending_timeout == 0) {
+            if (pending_forward() != ESP_OK) {
+                ESP_LOGW(TAG, "backend still not available, pending UPPs kept");
+            }
+            continue;
+        } else if (pending_timeout > 0) {
+            receive_timeout = MIN(receive_timeout, pdMS_TO_TICKS(pending_timeout));
+        }
+#endif
 
         // wait for incoming sensor data
-        size_t data_size = 0;
-        sensor_data_t* sensor_data = (sensor_data_t*)xRingbufferReceive(buf_handle,
-                &data_size, pdMS_TO_TICKS(30000));
+        sensor_data_t* sensor_data = ubirch_sensor_slot_receive(receive_timeout);
         if (sensor_data == NULL) {
+#if CONFIG_UBIRCH_ONBOARDING
+            if (onboarding_timeout >= 0) {
+                continue;
+            }
+#endif
+#if CONFIG_UBIRCH_SERIES
+            if (series_timeout >= 0) {
+                continue;
+            }
+#elif CONFIG_UBIRCH_MERKLE
+            if (merkle_timeout >= 0) {
+                continue;
+            }
+#endif
+#if CONFIG_UBIRCH_ANCHOR_PENDING > 0
+            if (pending_timeout >= 0) {
+                continue;
+            }
+#endif
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+            if (ubirch_queue_count() > 0) {
+                continue;
+            }
+#endif
             ESP_LOGE(TAG, "data receive timeout");
             continue;
-        } else {
-            // free the ringbuffer
-            vRingbufferReturnItem(buf_handle, (void*)sensor_data);
         }
-        ESP_LOGI(TAG, "received sensor data (%d) from sensor (%s)", sensor_data->data, sensor_data->id);
+        UBIRCH_LOG_STR(ESP_LOG_INFO, TAG, "sensor (%s): %u values received", sensor_data->id, sensor_data->num);
 
-        // manage the current ID context
-        if (ubirch_id_context_manage(sensor_data->id) != ESP_OK) {
-            continue;
+#if CONFIG_UBIRCH_SERIES
+        // collect the sample, the window is anchored when it is complete
+        while (ubirch_series_add(sensor_data) == ESP_ERR_NO_MEM) {
+            ubirch_series_flush(anchor_payload, false);
         }
-
-        // note: if we end up here we have a valid context that we can use
-        // create UPP, sign it and send it to the ubirch backend
-        ESP_LOGI(TAG, "create, sign and send UPP to backend");
-        if (ubirch_anchor_data(&sensor_data->data, 1) != ESP_OK) {
-            ESP_LOGE(TAG, "failed to anchor at ubirch backend");
+        ubirch_sensor_slot_release(sensor_data);
+        if (ubirch_series_flush(anchor_payload, false) > 0) {
+            ubirch_series_stats_t series_stats;
+            ubirch_series_stats_get(&series_stats);
+            ubirch_anchor_stats_log(series_stats.samples);
+        }
+#elif CONFIG_UBIRCH_MERKLE
+        // hash the reading into the tree of its sensor, the root is anchored when the epoch is over
+        const char *payload = NULL;
+        size_t len = 0;
+        if (ubirch_anchor_pack(sensor_data->values, sensor_data->num, &payload, &len) == ESP_OK) {
+            esp_err_t err;
+            while ((err = ubirch_merkle_add(sensor_data->id, payload, len, NULL)) == ESP_ERR_NO_MEM) {
+                ubirch_merkle_flush(anchor_payload, false);
+            }
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "failed to add reading to Merkle tree");
+            }
         }
+        ubirch_sensor_slot_release(sensor_data);
+        if (ubirch_merkle_flush(anchor_payload, false) > 0) {
+            ubirch_merkle_stats_t merkle_stats;
+            ubirch_merkle_stats_get(&merkle_stats);
+            ubirch_anchor_stats_log(merkle_stats.readings);
+        }
+#else
+        const char *payload = NULL;
+        size_t len = 0;
+        if (ubirch_anchor_pack(sensor_data->values, sensor_data->num, &payload, &len) == ESP_OK) {
+            anchor_payload(sensor_data->id, payload, len, sensor_data->committed);
+        }
+        // the data is signed, the slot can be used again
+        ubirch_sensor_slot_release(sensor_data);
+#endif
+
+        ubirch_id_cache_stats_t cache_stats;
+        ubirch_id_cache_stats_get(&cache_stats);
+        ESP_LOGD(TAG, "id cache: %u hits, %u misses, %u NVS loads, %u write backs",
+                cache_stats.hits, cache_stats.misses, cache_stats.nvs_loads, cache_stats.write_backs);
+#if CONFIG_UBIRCH_HTTP_KEEP_ALIVE
+        ubirch_http_pool_stats_t pool_stats;
+        ubirch_http_pool_stats_get(&pool_stats);
+        ESP_LOGD(TAG, "http pool: %u requests, %u handshakes, %u handshakes avoided, %u reconnects",
+                pool_stats.requests, pool_stats.handshakes, pool_stats.handshakes_avoided,
+                pool_stats.reconnects);
+#endif
     }
 }
 
@@ -183,6 +529,38 @@ static void update_time_task(void __unused *pvParameter) {
     }
 }
 
+/*!
+ * Connect to the Wifi with the credentials of the Kconfig.
+ */
+static void wifi_connect(void) {
+    // load wifi credentials with Kconfig
+    ESP_LOGI(TAG, "connecting to wifi");
+    struct Wifi_login wifi;
+    wifi.ssid = CONFIG_UBIRCH_WIFI_SSID;
+    wifi.ssid_length = strlen(wifi.ssid);
+    wifi.pwd = CONFIG_UBIRCH_WIFI_PWD;
+    wifi.pwd_length = strlen(wifi.pwd);
+
+    ESP_LOGD(TAG, "SSID: %.*s", (int)wifi.ssid_length, wifi.ssid);
+    if (wifi_join(wifi, 5000) == ESP_OK) {
+        ESP_LOGI(TAG, "established");
+    } else { // no connection possible
+        ESP_LOGW(TAG, "no valid Wifi");
+    }
+}
+
+#if CONFIG_UBIRCH_FAST_BOOT
+/*!
+ * Connect to the Wifi, while the other tasks start.
+ *
+ * @param pvParameters are currently not used, but part of the task declaration.
+ */
+static void wifi_join_task(void __unused *pvParameters) {
+    wifi_connect();
+    vTaskDelete(NULL);
+}
+#endif
+
 #pragma GCC diagnostic pop
 
 /**
@@ -228,36 +606,55 @@ void app_main() {
 
     // initialize the system
     init_system();
+    UBIRCH_BOOT_MARK(UBIRCH_BOOT_NVS_READY);
+#if CONFIG_UBIRCH_BINLOG
+    ubirch_binlog_start();
+#endif
 
-    // load wifi credentials with Kconfig
-    ESP_LOGI(TAG, "connecting to wifi");
-    struct Wifi_login wifi;
-    wifi.ssid = CONFIG_UBIRCH_WIFI_SSID;
-    wifi.ssid_length = strlen(wifi.ssid);
-    wifi.pwd = CONFIG_UBIRCH_WIFI_PWD;
-    wifi.pwd_length = strlen(wifi.pwd);
-
-    ESP_LOGD(TAG, "SSID: %.*s", wifi.ssid_length, wifi.ssid);
-    if (wifi_join(wifi, 5000) == ESP_OK) {
-        ESP_LOGI(TAG, "established");
-    } else { // no connection possible
-        ESP_LOGW(TAG, "no valid Wifi");
+#if CONFIG_UBIRCH_FAST_BOOT
+    // until SNTP is done, the stored time is the clock
+    if (ubirch_boot_clock_restore() != ESP_OK) {
+        ESP_LOGW(TAG, "no stored time, contexts are created after the time synchronization");
     }
+    if (ubirch_boot_start() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start the boot task");
+    }
+    // the keys and the contexts are loaded, while the Wifi connects
+    xTaskCreate(&wifi_join_task, "wifi_join", 4096, NULL, 5, NULL);
+#else
+    wifi_connect();
+#endif
 
-    // create ringbuffer for sensor_simulator_task - main_task communication
-    RingbufHandle_t buf_handle;
-    buf_handle = xRingbufferCreate(1028, RINGBUF_TYPE_NOSPLIT);
-    if (buf_handle == NULL) {
-        printf("Failed to create ring buffer\n");
-        ESP_LOGE(TAG, "failed to create ring buffer");
+    // create the slot pool for the communication of the sensors with main_task
+    if (ubirch_sensor_pool_init() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to create sensor data pool");
     }
 
     // create the system tasks to be executed
     xTaskCreate(&update_time_task, "sntp", 4096, NULL, 4, &net_config_handle);
+#if CONFIG_UBIRCH_DELTA_OTA
+    // the patch is paced and pauses for the anchoring, so it runs below the other tasks
+    UBIRCH_TASK_CREATE(fw_update_task, &ubirch_delta_ota_task, "fw_update", 2, &fw_update_task_handle,
+            tskNO_AFFINITY);
+#else
     xTaskCreate(&ubirch_ota_task, "fw_update", 4096, NULL, 5, &fw_update_task_handle);
-    xTaskCreate(&main_task, "main", 8192, &buf_handle, 6, &main_task_handle);
-    xTaskCreate(&sensor_simulator_task, "sensor_sim", 2048, &buf_handle, 6,
-            &sensor_simulator_task_handle);
+#endif
+#if CONFIG_UBIRCH_PIPELINE
+    ubirch_budget_task_create(&main_task, "main", CONFIG_UBIRCH_STACK_MAIN, 6, &main_task_handle, tskNO_AFFINITY,
+            NULL, NULL);
+#else
+    UBIRCH_TASK_CREATE(main_task, &main_task, "main", 6, &main_task_handle, tskNO_AFFINITY);
+#endif
+#if CONFIG_UBIRCH_INGEST
+    // the sensors send their readings over the network
+    if (ubirch_ingest_start() != ESP_OK) {
+        ESP_LOGE(TAG, "failed to start the ingestion server");
+    }
+#elif !CONFIG_IDF_TARGET_LINUX
+    // on the host, the load generator of the host build simulates the sensors
+    UBIRCH_TASK_CREATE(sensor_simulator_task, &sensor_simulator_task, "sensor_sim", 6,
+            &sensor_simulator_task_handle, tskNO_AFFINITY);
+#endif
 
     ESP_LOGI(TAG, "all tasks created");
 
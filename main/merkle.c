@@ -0,0 +1,559 @@
+/*!
+ * @file merkle.c
+ * @brief Merkle tree aggregation of sensor readings, of which only the root is anchored.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+#include <msgpack.h>
+#include <ubirch_ed25519.h>
+
+#include "budget.h"
+#include "sensor_data.h"
+#include "merkle.h"
+
+#if CONFIG_UBIRCH_MERKLE
+
+static const char *TAG = "merkle";
+
+#define MERKLE_HASH_SIZE crypto_hash_sha512_BYTES
+#define MERKLE_LEAF_PREFIX 0x00
+#define MERKLE_NODE_PREFIX 0x01
+// the header changed with the size of the sensor id
+#define MERKLE_MAGIC 0x4d4b4c32
+#define MERKLE_READING_MAX_SIZE 256
+#define MERKLE_PAYLOAD_MAX_SIZE 128
+// a tree of up to 2^14 leaves has at most 15 subtrees in the frontier and 14 siblings in a path
+#define MERKLE_FRONTIER_SIZE 16
+#define MERKLE_HEADER_SIZE 256
+#define MERKLE_SLOT_SIZE ((MERKLE_HEADER_SIZE + CONFIG_UBIRCH_MERKLE_EPOCH_LEAVES * MERKLE_HASH_SIZE \
+        + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE)
+
+#if CONFIG_UBIRCH_MERKLE_EPOCH_LEAVES > 16384
+#error "UBIRCH_MERKLE_EPOCH_LEAVES is larger than the frontier"
+#endif
+
+/*!
+ * Header of a closed epoch on flash, it is followed by the leaf hashes.
+ * The header is written, when the epoch is closed, so epochs without
+ * valid header were never anchored.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t epoch;
+    char id[UBIRCH_SENSOR_ID_SIZE];
+    uint32_t leaves;
+    uint16_t payload_len;
+    uint16_t reserved;
+    char payload[MERKLE_PAYLOAD_MAX_SIZE];    //!< the anchored payload with the root
+    uint32_t crc;                               //!< CRC32 of all fields before
+} merkle_header_t;
+
+_Static_assert(sizeof(merkle_header_t) <= MERKLE_HEADER_SIZE, "merkle header too large");
+
+/*!
+ * Roots of the perfect subtrees of an incomplete tree, from left to right.
+ */
+typedef struct {
+    uint8_t hash[MERKLE_FRONTIER_SIZE][MERKLE_HASH_SIZE];
+    uint8_t height[MERKLE_FRONTIER_SIZE];
+    uint8_t size;
+} merkle_frontier_t;
+
+/*!
+ * Open epoch of one sensor.
+ */
+typedef struct {
+    char id[UBIRCH_SENSOR_ID_SIZE];     //!< empty, if the epoch is not used
+    bool ready;                         //!< the tree is full, or the slot is needed
+    uint32_t epoch;
+    uint32_t leaves;
+    int64_t started;                    //!< esp_timer time of the first reading
+    uint64_t start_ms;                  //!< wall clock time of the first reading
+    merkle_frontier_t frontier;
+} merkle_epoch_t;
+
+/*!
+ * Bounded buffer, which is written by a msgpack packer.
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t used;
+} merkle_buffer_t;
+
+static const esp_partition_t *partition = NULL;
+static uint32_t slot_count = 0;
+static uint32_t next_epoch = 1;
+static merkle_epoch_t epochs[CONFIG_UBIRCH_MERKLE_CONTEXTS];
+static SemaphoreHandle_t merkle_lock = NULL;
+UBIRCH_SEMAPHORE_DEFINE(merkle_lock);
+static ubirch_merkle_stats_t stats = { 0 };
+
+// only used while merkle_lock is taken
+static uint8_t leaf_buffer[1 + MERKLE_READING_MAX_SIZE];
+static merkle_header_t header_buffer;
+static merkle_frontier_t proof_frontier;
+static uint8_t proof_path[MERKLE_FRONTIER_SIZE][MERKLE_HASH_SIZE];
+
+static int merkle_buffer_write(void *data, const char *buf, size_t len) {
+    merkle_buffer_t *buffer = (merkle_buffer_t *)data;
+    if (buffer->used + len > buffer->size) {
+        return -1;
+    }
+    memcpy(buffer->data + buffer->used, buf, len);
+    buffer->used += len;
+    return 0;
+}
+
+static inline size_t slot_address(uint32_t epoch) {
+    return (size_t)(epoch % slot_count) * MERKLE_SLOT_SIZE;
+}
+
+static inline size_t leaf_address(uint32_t epoch, uint32_t leaf) {
+    return slot_address(epoch) + MERKLE_HEADER_SIZE + (size_t)leaf * MERKLE_HASH_SIZE;
+}
+
+static uint32_t header_crc(const merkle_header_t *header) {
+    return esp_rom_crc32_le(0, (const uint8_t *)header, offsetof(merkle_header_t, crc));
+}
+
+static void node_hash(uint8_t *out, const uint8_t *left, const uint8_t *right) {
+    uint8_t node[1 + 2 * MERKLE_HASH_SIZE];
+    node[0] = MERKLE_NODE_PREFIX;
+    memcpy(node + 1, left, MERKLE_HASH_SIZE);
+    memcpy(node + 1 + MERKLE_HASH_SIZE, right, MERKLE_HASH_SIZE);
+    crypto_hash_sha512(out, node, sizeof(node));
+}
+
+/*!
+ * Append a leaf and merge the perfect subtrees of the same height.
+ */
+static void frontier_add(merkle_frontier_t *frontier, const uint8_t *leaf) {
+    memcpy(frontier->hash[frontier->size], leaf, MERKLE_HASH_SIZE);
+    frontier->height[frontier->size] = 0;
+    frontier->size++;
+    while (frontier->size >= 2
+            && frontier->height[frontier->size - 1] == frontier->height[frontier->size - 2]) {
+        uint8_t top = frontier->size - 1;
+        node_hash(frontier->hash[top - 1], frontier->hash[top - 1], frontier->hash[top]);
+        frontier->height[top - 1]++;
+        frontier->size--;
+    }
+}
+
+/*!
+ * Fold the subtrees from right to left, which gives the root of RFC 6962.
+ */
+static void frontier_root(const merkle_frontier_t *frontier, uint8_t *root) {
+    memcpy(root, frontier->hash[frontier->size - 1], MERKLE_HASH_SIZE);
+    for (int i = frontier->size - 2; i >= 0; --i) {
+        node_hash(root, frontier->hash[i], root);
+    }
+}
+
+/*!
+ * Compute the root of the leaves [first, first + count) of a closed epoch from flash.
+ */
+static esp_err_t subtree_root(uint32_t epoch, uint32_t first, uint32_t count, uint8_t *root) {
+    uint8_t leaf[MERKLE_HASH_SIZE];
+    memset(&proof_frontier, 0, sizeof(proof_frontier));
+    for (uint32_t i = first; i < first + count; ++i) {
+        if (esp_partition_read(partition, leaf_address(epoch, i), leaf, MERKLE_HASH_SIZE) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        frontier_add(&proof_frontier, leaf);
+    }
+    frontier_root(&proof_frontier, root);
+    return ESP_OK;
+}
+
+static merkle_epoch_t *find(const char *id) {
+    for (size_t i = 0; i < CONFIG_UBIRCH_MERKLE_CONTEXTS; ++i) {
+        if (epochs[i].id[0] != '\0' && strncmp(epochs[i].id, id, UBIRCH_SENSOR_ID_SIZE) == 0) {
+            return &epochs[i];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * Start a new epoch for \p id in the next flash slot.
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM if an epoch has to be closed first, or ESP_FAIL
+ */
+static esp_err_t epoch_open(const char *id, merkle_epoch_t **out) {
+    merkle_epoch_t *free_epoch = NULL;
+    merkle_epoch_t *oldest = NULL;
+    for (size_t i = 0; i < CONFIG_UBIRCH_MERKLE_CONTEXTS; ++i) {
+        merkle_epoch_t *epoch = &epochs[i];
+        if (epoch->id[0] == '\0') {
+            free_epoch = epoch;
+        } else if (oldest == NULL || epoch->started < oldest->started) {
+            oldest = epoch;
+        }
+        // an open epoch of another sensor still uses the slot, after the numbers wrapped around
+        if (epoch->id[0] != '\0' && epoch->epoch % slot_count == next_epoch % slot_count) {
+            epoch->ready = true;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (free_epoch == NULL) {
+        oldest->ready = true;
+        return ESP_ERR_NO_MEM;
+    }
+    // the oldest closed epoch and its proofs are dropped
+    if (esp_partition_erase_range(partition, slot_address(next_epoch), MERKLE_SLOT_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to erase slot of epoch %u", next_epoch);
+        return ESP_FAIL;
+    }
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    memset(free_epoch, 0, sizeof(merkle_epoch_t));
+    strncpy(free_epoch->id, id, UBIRCH_SENSOR_ID_SIZE - 1);
+    free_epoch->epoch = next_epoch++;
+    free_epoch->started = esp_timer_get_time();
+    free_epoch->start_ms = (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_usec / 1000;
+    *out = free_epoch;
+    return ESP_OK;
+}
+
+/*!
+ * Write the header of \p epoch with the packed root into header_buffer and to flash.
+ */
+static esp_err_t epoch_close(const merkle_epoch_t *epoch) {
+    uint8_t root[MERKLE_HASH_SIZE];
+    frontier_root(&epoch->frontier, root);
+
+    memset(&header_buffer, 0, sizeof(header_buffer));
+    header_buffer.magic = MERKLE_MAGIC;
+    header_buffer.epoch = epoch->epoch;
+    memcpy(header_buffer.id, epoch->id, UBIRCH_SENSOR_ID_SIZE);
+    header_buffer.leaves = epoch->leaves;
+
+    merkle_buffer_t buffer = { .data = header_buffer.payload, .size = MERKLE_PAYLOAD_MAX_SIZE, .used = 0 };
+    msgpack_packer pk;
+    msgpack_packer_init(&pk, &buffer, merkle_buffer_write);
+    msgpack_pack_array(&pk, 5);
+    msgpack_pack_uint8(&pk, UBIRCH_MERKLE_FORMAT);
+    msgpack_pack_uint32(&pk, epoch->epoch);
+    msgpack_pack_uint64(&pk, epoch->start_ms);
+    msgpack_pack_uint32(&pk, epoch->leaves);
+    msgpack_pack_bin(&pk, MERKLE_HASH_SIZE);
+    msgpack_pack_bin_body(&pk, root, MERKLE_HASH_SIZE);
+    header_buffer.payload_len = (uint16_t)buffer.used;
+    header_buffer.crc = header_crc(&header_buffer);
+
+    return esp_partition_write(partition, slot_address(epoch->epoch), &header_buffer, sizeof(header_buffer));
+}
+
+static bool expired(const merkle_epoch_t *epoch, int64_t now) {
+    return (now - epoch->started) >= (int64_t)CONFIG_UBIRCH_MERKLE_EPOCH_MS * 1000;
+}
+
+#if CONFIG_UBIRCH_MERKLE_LOG_PROOFS
+/*!
+ * Log the proof of the first reading of an epoch as hex, for merkle_verify.py.
+ */
+static void proof_log(uint32_t epoch) {
+    static char proof[UBIRCH_MERKLE_PROOF_MAX_SIZE];
+    static char hex[2 * UBIRCH_MERKLE_PROOF_MAX_SIZE + 1];
+    ubirch_merkle_receipt_t receipt = { .epoch = epoch, .leaf = 0 };
+    size_t len = 0;
+    if (ubirch_merkle_proof_export(&receipt, proof, sizeof(proof), &len) != ESP_OK) {
+        return;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        sprintf(hex + 2 * i, "%02x", (uint8_t)proof[i]);
+    }
+    ESP_LOGI(TAG, "proof %u/0: %s", epoch, hex);
+}
+#endif
+
+esp_err_t ubirch_merkle_init(void) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+            CONFIG_UBIRCH_MERKLE_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "partition \"%s\" not found", CONFIG_UBIRCH_MERKLE_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    slot_count = partition->size / MERKLE_SLOT_SIZE;
+    if (slot_count <= CONFIG_UBIRCH_MERKLE_CONTEXTS) {
+        ESP_LOGE(TAG, "partition too small for %d epochs of %d readings",
+                CONFIG_UBIRCH_MERKLE_CONTEXTS + 1, CONFIG_UBIRCH_MERKLE_EPOCH_LEAVES);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (merkle_lock == NULL) {
+        merkle_lock = UBIRCH_MUTEX_CREATE(merkle_lock);
+        if (merkle_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    memset(epochs, 0, sizeof(epochs));
+    memset(&stats, 0, sizeof(stats));
+
+    // continue after the newest closed epoch
+    xSemaphoreTake(merkle_lock, portMAX_DELAY);
+    uint32_t last_epoch = 0;
+    for (uint32_t slot = 0; slot < slot_count; ++slot) {
+        if (esp_partition_read(partition, (size_t)slot * MERKLE_SLOT_SIZE,
+                    &header_buffer, sizeof(header_buffer)) == ESP_OK
+                && header_buffer.magic == MERKLE_MAGIC
+                && header_crc(&header_buffer) == header_buffer.crc
+                && header_buffer.epoch > last_epoch) {
+            last_epoch = header_buffer.epoch;
+        }
+    }
+    next_epoch = last_epoch + 1;
+    xSemaphoreGive(merkle_lock);
+    ESP_LOGI(TAG, "%u slots, next epoch %u", slot_count, next_epoch);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_merkle_add(const char *id, const char *reading, size_t len, ubirch_merkle_receipt_t *receipt) {
+    if (len > MERKLE_READING_MAX_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(merkle_lock, portMAX_DELAY);
+    merkle_epoch_t *epoch = find(id);
+    if (epoch != NULL && epoch->leaves >= CONFIG_UBIRCH_MERKLE_EPOCH_LEAVES) {
+        // the tree is full, it has to be closed first
+        xSemaphoreGive(merkle_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    if (epoch == NULL) {
+        esp_err_t err = epoch_open(id, &epoch);
+        if (err != ESP_OK) {
+            xSemaphoreGive(merkle_lock);
+            return err;
+        }
+    }
+
+    uint8_t leaf[MERKLE_HASH_SIZE];
+    leaf_buffer[0] = MERKLE_LEAF_PREFIX;
+    memcpy(leaf_buffer + 1, reading, len);
+    crypto_hash_sha512(leaf, leaf_buffer, 1 + len);
+    if (esp_partition_write(partition, leaf_address(epoch->epoch, epoch->leaves), leaf, MERKLE_HASH_SIZE) != ESP_OK) {
+        xSemaphoreGive(merkle_lock);
+        return ESP_FAIL;
+    }
+    frontier_add(&epoch->frontier, leaf);
+    if (receipt != NULL) {
+        receipt->epoch = epoch->epoch;
+        receipt->leaf = epoch->leaves;
+    }
+    epoch->leaves++;
+    if (epoch->leaves >= CONFIG_UBIRCH_MERKLE_EPOCH_LEAVES) {
+        epoch->ready = true;
+    }
+    stats.readings++;
+    stats.add_us += (uint64_t)(esp_timer_get_time() - start);
+    xSemaphoreGive(merkle_lock);
+    return ESP_OK;
+}
+
+size_t ubirch_merkle_flush(ubirch_merkle_sink_t sink, bool all) {
+    static char payload[MERKLE_PAYLOAD_MAX_SIZE];
+    size_t flushed = 0;
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < CONFIG_UBIRCH_MERKLE_CONTEXTS; ++i) {
+        merkle_epoch_t *epoch = &epochs[i];
+        if (epoch->id[0] == '\0' || (!epoch->ready && !expired(epoch, now) && !all)) {
+            continue;
+        }
+        if (epoch->leaves == 0) {
+            // the first reading could not be stored
+            epoch->id[0] = '\0';
+            continue;
+        }
+
+        xSemaphoreTake(merkle_lock, portMAX_DELAY);
+        esp_err_t err = epoch_close(epoch);
+        size_t len = header_buffer.payload_len;
+        memcpy(payload, header_buffer.payload, len);
+        xSemaphoreGive(merkle_lock);
+        if (err != ESP_OK) {
+            // the proofs of the epoch are lost, but the root can still be anchored
+            ESP_LOGE(TAG, "failed to store epoch %u", epoch->epoch);
+        }
+
+        ESP_LOGI(TAG, "epoch %u of %s: %u readings", epoch->epoch, epoch->id, epoch->leaves);
+        if (sink(epoch->id, payload, len, epoch->started) != ESP_OK) {
+            ESP_LOGE(TAG, "failed to anchor root of epoch %u", epoch->epoch);
+        }
+#if CONFIG_UBIRCH_MERKLE_LOG_PROOFS
+        proof_log(epoch->epoch);
+#endif
+        stats.epochs++;
+        epoch->id[0] = '\0';
+        flushed++;
+    }
+    return flushed;
+}
+
+int32_t ubirch_merkle_timeout_ms(void) {
+    int64_t now = esp_timer_get_time();
+    int32_t timeout = -1;
+    for (size_t i = 0; i < CONFIG_UBIRCH_MERKLE_CONTEXTS; ++i) {
+        const merkle_epoch_t *epoch = &epochs[i];
+        if (epoch->id[0] == '\0') {
+            continue;
+        }
+        if (epoch->ready || expired(epoch, now)) {
+            return 0;
+        }
+        int32_t remaining = (int32_t)(CONFIG_UBIRCH_MERKLE_EPOCH_MS - (now - epoch->started) / 1000);
+        if (timeout < 0 || remaining < timeout) {
+            timeout = remaining;
+        }
+    }
+    return timeout;
+}
+
+esp_err_t ubirch_merkle_proof_export(const ubirch_merkle_receipt_t *receipt, char *buffer, size_t size, size_t *len) {
+    if (partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(merkle_lock, portMAX_DELAY);
+    if (esp_partition_read(partition, slot_address(receipt->epoch), &header_buffer, sizeof(header_buffer)) != ESP_OK
+            || header_buffer.magic != MERKLE_MAGIC
+            || header_buffer.epoch != receipt->epoch
+            || header_crc(&header_buffer) != header_buffer.crc) {
+        xSemaphoreGive(merkle_lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (receipt->leaf >= header_buffer.leaves) {
+        xSemaphoreGive(merkle_lock);
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t leaf[MERKLE_HASH_SIZE];
+    if (esp_partition_read(partition, leaf_address(receipt->epoch, receipt->leaf), leaf, MERKLE_HASH_SIZE) != ESP_OK) {
+        xSemaphoreGive(merkle_lock);
+        return ESP_FAIL;
+    }
+
+    // walk down from the root, the sibling of every step is the root of the other subtree
+    size_t path_len = 0;
+    uint32_t first = 0;
+    uint32_t count = header_buffer.leaves;
+    uint32_t index = receipt->leaf;
+    while (count > 1) {
+        uint32_t split = 1;
+        while (split * 2 < count) {
+            split *= 2;
+        }
+        esp_err_t err;
+        if (index < split) {
+            err = subtree_root(receipt->epoch, first + split, count - split, proof_path[path_len]);
+            count = split;
+        } else {
+            err = subtree_root(receipt->epoch, first, split, proof_path[path_len]);
+            first += split;
+            index -= split;
+            count -= split;
+        }
+        if (err != ESP_OK) {
+            xSemaphoreGive(merkle_lock);
+            return err;
+        }
+        path_len++;
+    }
+
+    merkle_buffer_t out = { .data = buffer, .size = size, .used = 0 };
+    msgpack_packer pk;
+    msgpack_packer_init(&pk, &out, merkle_buffer_write);
+    int failed = msgpack_pack_array(&pk, 5);
+    failed |= msgpack_pack_str(&pk, strnlen(header_buffer.id, UBIRCH_SENSOR_ID_SIZE));
+    failed |= msgpack_pack_str_body(&pk, header_buffer.id, strnlen(header_buffer.id, UBIRCH_SENSOR_ID_SIZE));
+    failed |= msgpack_pack_bin(&pk, header_buffer.payload_len);
+    failed |= msgpack_pack_bin_body(&pk, header_buffer.payload, header_buffer.payload_len);
+    failed |= msgpack_pack_uint32(&pk, receipt->leaf);
+    failed |= msgpack_pack_bin(&pk, MERKLE_HASH_SIZE);
+    failed |= msgpack_pack_bin_body(&pk, leaf, MERKLE_HASH_SIZE);
+    failed |= msgpack_pack_array(&pk, path_len);
+    // the path was collected from the root down, the proof starts at the leaf
+    for (size_t i = path_len; i > 0; --i) {
+        failed |= msgpack_pack_bin(&pk, MERKLE_HASH_SIZE);
+        failed |= msgpack_pack_bin_body(&pk, proof_path[i - 1], MERKLE_HASH_SIZE);
+    }
+    xSemaphoreGive(merkle_lock);
+    if (failed) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *len = out.used;
+    return ESP_OK;
+}
+
+void ubirch_merkle_stats_get(ubirch_merkle_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_merkle_stats_t));
+}
+
+#if CONFIG_UBIRCH_MERKLE_BENCHMARK
+
+#define MERKLE_BENCHMARK_READINGS 4096
+
+static void benchmark_task(void __unused *pvParameters) {
+    static merkle_frontier_t frontiers[2];
+    merkle_frontier_t *frontier = &frontiers[xPortGetCoreID() % 2];
+    uint8_t reading[1 + 24] = { MERKLE_LEAF_PREFIX };
+    uint8_t leaf[MERKLE_HASH_SIZE];
+
+    memset(frontier, 0, sizeof(merkle_frontier_t));
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < MERKLE_BENCHMARK_READINGS; ++i) {
+        memcpy(reading + 1, &i, sizeof(i));
+        crypto_hash_sha512(leaf, reading, sizeof(reading));
+        frontier_add(frontier, leaf);
+    }
+    frontier_root(frontier, leaf);
+    int64_t duration = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "core %d: %u readings in %u ms, %u readings/s", xPortGetCoreID(),
+            MERKLE_BENCHMARK_READINGS, (unsigned int)(duration / 1000),
+            (unsigned int)((int64_t)MERKLE_BENCHMARK_READINGS * 1000000 / duration));
+    vTaskDelete(NULL);
+}
+
+void ubirch_merkle_benchmark_start(void) {
+#if CONFIG_FREERTOS_UNICORE
+    xTaskCreatePinnedToCore(&benchmark_task, "merkle_bench", 4096, NULL, 1, NULL, 0);
+#else
+    xTaskCreatePinnedToCore(&benchmark_task, "merkle_bench0", 4096, NULL, 1, NULL, 0);
+    xTaskCreatePinnedToCore(&benchmark_task, "merkle_bench1", 4096, NULL, 1, NULL, 1);
+#endif
+}
+
+#endif // CONFIG_UBIRCH_MERKLE_BENCHMARK
+
+#endif // CONFIG_UBIRCH_MERKLE
@@ -0,0 +1,158 @@
+/*!
+ * @file merkle.h
+ * @brief Merkle tree aggregation of sensor readings, of which only the root is anchored.
+ *
+ * The readings of every sensor are hashed into a Merkle tree per epoch.
+ * When the epoch is over, only the root of the tree is anchored in a UPP.
+ * The leaf hashes stay on flash, so an inclusion proof can be exported
+ * for every reading later, see ubirch_merkle_proof_export().
+ *
+ * The tree is built like the Merkle Hash Tree of RFC 6962, with SHA-512:
+ *
+ *     leaf = SHA512(0x00 || reading)
+ *     node = SHA512(0x01 || left || right)
+ *
+ * The anchored payload of an epoch is packed with msgpack:
+ *
+ *     [format, epoch, start, leaves, root]
+ *
+ * - format: UBIRCH_MERKLE_FORMAT
+ * - epoch: number of the epoch on this gateway
+ * - start: time of the first reading, in ms since the epoch
+ * - leaves: number of readings
+ * - root: root hash of the tree (64 bytes)
+ *
+ * An exported proof is packed with msgpack:
+ *
+ *     [id, payload, leaf, leaf hash, [sibling, ...]]
+ *
+ * The siblings are ordered from the leaf to the root, like the audit path
+ * of RFC 9162. The proof is verified with `merkle_verify.py`.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_MERKLE_H
+#define EXAMPLE_ESP32_MERKLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#define UBIRCH_MERKLE_FORMAT 2
+#define UBIRCH_MERKLE_PROOF_MAX_SIZE 1536
+
+/*!
+ * Function, which anchors the payload with the root of an epoch.
+ *
+ * @param id the sensor id of the epoch
+ * @param payload the packed root
+ * @param len the length of the payload
+ * @param started time of the first reading (esp_timer_get_time())
+ */
+typedef esp_err_t (*ubirch_merkle_sink_t)(const char *id, const char *payload, size_t len, int64_t started);
+
+/*!
+ * Position of a reading in the trees, to export its proof.
+ */
+typedef struct {
+    uint32_t epoch;
+    uint32_t leaf;
+} ubirch_merkle_receipt_t;
+
+/*!
+ * Statistics of the Merkle aggregation.
+ */
+typedef struct {
+    uint32_t readings;      //!< readings added to a tree
+    uint32_t epochs;        //!< roots handed to the sink
+    uint64_t add_us;        //!< time spent in ubirch_merkle_add(), including the flash writes
+} ubirch_merkle_stats_t;
+
+/*!
+ * @brief Open the proof partition and find the last epoch.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if there is no proof partition,
+ *         or ESP_ERR_INVALID_SIZE if it is too small
+ */
+esp_err_t ubirch_merkle_init(void);
+
+/*!
+ * @brief Add a reading to the tree of its sensor.
+ *
+ * If the tree of the sensor is full, or no tree is available for it, an
+ * epoch is marked for flushing and ESP_ERR_NO_MEM is returned. The reading
+ * has to be added again after ubirch_merkle_flush().
+ *
+ * @param[in] id the sensor id
+ * @param[in] reading the packed reading
+ * @param[in] len length of the reading
+ * @param[out] receipt position of the reading, or NULL
+ * @return ESP_OK, ESP_ERR_NO_MEM if the reading does not fit into a tree,
+ *         ESP_ERR_INVALID_SIZE if the reading is too large, or ESP_FAIL on flash errors
+ */
+esp_err_t ubirch_merkle_add(const char *id, const char *reading, size_t len, ubirch_merkle_receipt_t *receipt);
+
+/*!
+ * @brief Close the epochs, which are over, store them and hand their roots to \p sink.
+ *
+ * @param[in] sink function, which anchors the root
+ * @param[in] all close all epochs, also the ones, which are not over
+ * @return number of closed epochs
+ */
+size_t ubirch_merkle_flush(ubirch_merkle_sink_t sink, bool all);
+
+/*!
+ * @brief Get the time until the oldest epoch is over.
+ *
+ * @return -1 if there is no epoch, remaining time in ms otherwise
+ */
+int32_t ubirch_merkle_timeout_ms(void);
+
+/*!
+ * @brief Export the inclusion proof of a reading of a closed epoch.
+ *
+ * @param[in] receipt position of the reading
+ * @param[out] buffer the packed proof, UBIRCH_MERKLE_PROOF_MAX_SIZE bytes are sufficient
+ * @param[in] size size of the buffer
+ * @param[out] len length of the proof
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the epoch is not on flash (anymore),
+ *         ESP_ERR_INVALID_ARG if the leaf is not part of the epoch,
+ *         or ESP_ERR_INVALID_SIZE if the buffer is too small
+ */
+esp_err_t ubirch_merkle_proof_export(const ubirch_merkle_receipt_t *receipt, char *buffer, size_t size, size_t *len);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_merkle_stats_get(ubirch_merkle_stats_t *stats);
+
+#if CONFIG_UBIRCH_MERKLE_BENCHMARK
+/*!
+ * @brief Measure the readings per second, which are hashed into a tree, on every core.
+ *
+ * A task is started on every core, which logs the result. The trees are
+ * kept in memory, so the flash writes are not part of the measurement,
+ * see ubirch_merkle_stats_t for the time including them.
+ */
+void ubirch_merkle_benchmark_start(void);
+#endif
+
+#endif /* EXAMPLE_ESP32_MERKLE_H */
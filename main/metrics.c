@@ -0,0 +1,278 @@
+/*!
+ * @file metrics.c
+ * @brief Runtime metrics of the gateway: timers, counters and gauges.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include "budget.h"
+#include "metrics.h"
+
+#if CONFIG_UBIRCH_METRICS
+
+static const char *TAG = "metrics";
+
+#if CONFIG_IDF_TARGET_LINUX
+// the cycle counter of the host counts nanoseconds
+#define METRICS_CYCLES_PER_US 1000
+#else
+#define METRICS_CYCLES_PER_US CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ
+#endif
+#define METRICS_MAX_TASKS 12
+#define METRICS_SNAPSHOT_VERSION 1
+#define METRICS_OVERHEAD_ROUNDS 10000
+
+static ubirch_metrics_stats_t metrics = { 0 };
+static TaskHandle_t tasks[METRICS_MAX_TASKS];
+static size_t task_count = 0;
+
+static const char *timer_names[UBIRCH_METRICS_TIMERS] = {
+        "manage", "message", "sign", "send", "parse", "create"
+};
+static const char *counter_names[UBIRCH_METRICS_COUNTERS] = {
+        "readings", "upps", "sends", "send_failures", "bytes_sent"
+};
+static const char *gauge_names[UBIRCH_METRICS_GAUGES] = {
+        "slots", "backlog"
+};
+
+/*!
+ * Add a duration to a histogram, the bucket is the number of significant bits.
+ */
+static void histogram_add(ubirch_metrics_histogram_t *histogram, uint32_t cycles) {
+    uint32_t us = cycles / METRICS_CYCLES_PER_US;
+    uint32_t bucket = (us == 0) ? 0 : 32 - (uint32_t)__builtin_clz(us);
+    histogram->buckets[(bucket < UBIRCH_METRICS_BUCKETS) ? bucket : UBIRCH_METRICS_BUCKETS - 1]++;
+    histogram->count++;
+    histogram->total_us += us;
+    if (us > histogram->max_us) {
+        histogram->max_us = us;
+    }
+}
+
+void ubirch_metrics_stop(ubirch_metrics_timer_t timer, ubirch_metrics_span_t span) {
+    uint32_t cycles = esp_cpu_get_ccount() - span.cycles;
+    if (xPortGetCoreID() != span.core) {
+        metrics.timers[timer].migrated++;
+        return;
+    }
+    histogram_add(&metrics.timers[timer], cycles);
+}
+
+void ubirch_metrics_count(ubirch_metrics_counter_t counter, uint32_t n) {
+    // the send tasks of the pipeline count at the same time
+    __atomic_fetch_add(&metrics.counters[counter], n, __ATOMIC_RELAXED);
+}
+
+void ubirch_metrics_gauge_set(ubirch_metrics_gauge_t gauge, uint32_t value) {
+    metrics.gauges[gauge].value = value;
+    if (value > metrics.gauges[gauge].max) {
+        metrics.gauges[gauge].max = value;
+    }
+}
+
+#if CONFIG_UBIRCH_METRICS_LOG_INTERVAL_S > 0
+UBIRCH_TASK_DEFINE(metrics_task, 3072);
+
+/*!
+ * Log the metrics and the RAM budget periodically.
+ */
+static void metrics_task(void __unused *pvParameters) {
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_UBIRCH_METRICS_LOG_INTERVAL_S * 1000));
+        ubirch_metrics_log();
+        ubirch_budget_log();
+    }
+}
+#endif
+
+esp_err_t ubirch_metrics_init(void) {
+    memset(&metrics, 0, sizeof(metrics));
+#if CONFIG_UBIRCH_METRICS_LOG_INTERVAL_S > 0
+    static TaskHandle_t metrics_task_handle = NULL;
+    if (metrics_task_handle == NULL
+            && UBIRCH_TASK_CREATE(metrics_task, &metrics_task, "metrics", 1, &metrics_task_handle,
+                tskNO_AFFINITY) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    ubirch_metrics_task_add(metrics_task_handle);
+#endif
+    return ESP_OK;
+}
+
+void ubirch_metrics_task_add(TaskHandle_t task) {
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    for (size_t i = 0; i < task_count; ++i) {
+        if (tasks[i] == task) {
+            return;
+        }
+    }
+    if (task_count >= METRICS_MAX_TASKS) {
+        ESP_LOGW(TAG, "stack of task %s not monitored", pcTaskGetName(task));
+        return;
+    }
+    tasks[task_count++] = task;
+}
+
+void ubirch_metrics_stats_get(ubirch_metrics_stats_t *out) {
+    metrics.heap_free = esp_get_free_heap_size();
+    metrics.heap_minimum_free = esp_get_minimum_free_heap_size();
+    memcpy(out, &metrics, sizeof(ubirch_metrics_stats_t));
+}
+
+/*!
+ * Pack a string key, for the names of the metrics.
+ */
+static int pack_key(msgpack_packer *pk, const char *key) {
+    size_t len = strlen(key);
+    return msgpack_pack_str(pk, len) | msgpack_pack_str_body(pk, key, len);
+}
+
+esp_err_t ubirch_metrics_snapshot(msgpack_sbuffer *buffer) {
+    static ubirch_metrics_stats_t copy;
+    ubirch_metrics_stats_get(&copy);
+
+    msgpack_packer pk;
+    msgpack_packer_init(&pk, buffer, msgpack_sbuffer_write);
+    int failed = msgpack_pack_map(&pk, 7);
+    failed |= pack_key(&pk, "v") | msgpack_pack_uint8(&pk, METRICS_SNAPSHOT_VERSION);
+    failed |= pack_key(&pk, "t") | msgpack_pack_uint64(&pk, (uint64_t)(esp_timer_get_time() / 1000));
+
+    failed |= pack_key(&pk, "h") | msgpack_pack_map(&pk, UBIRCH_METRICS_TIMERS);
+    for (size_t i = 0; i < UBIRCH_METRICS_TIMERS; ++i) {
+        const ubirch_metrics_histogram_t *histogram = &copy.timers[i];
+        uint32_t used = UBIRCH_METRICS_BUCKETS;
+        while (used > 0 && histogram->buckets[used - 1] == 0) {
+            used--;
+        }
+        failed |= pack_key(&pk, timer_names[i]) | msgpack_pack_array(&pk, 5);
+        failed |= msgpack_pack_uint32(&pk, histogram->count) | msgpack_pack_uint64(&pk, histogram->total_us);
+        failed |= msgpack_pack_uint32(&pk, histogram->max_us) | msgpack_pack_uint32(&pk, histogram->migrated);
+        failed |= msgpack_pack_array(&pk, used);
+        for (uint32_t b = 0; b < used; ++b) {
+            failed |= msgpack_pack_uint32(&pk, histogram->buckets[b]);
+        }
+    }
+
+    failed |= pack_key(&pk, "c") | msgpack_pack_map(&pk, UBIRCH_METRICS_COUNTERS);
+    for (size_t i = 0; i < UBIRCH_METRICS_COUNTERS; ++i) {
+        failed |= pack_key(&pk, counter_names[i]) | msgpack_pack_uint64(&pk, copy.counters[i]);
+    }
+
+    failed |= pack_key(&pk, "g") | msgpack_pack_map(&pk, UBIRCH_METRICS_GAUGES);
+    for (size_t i = 0; i < UBIRCH_METRICS_GAUGES; ++i) {
+        failed |= pack_key(&pk, gauge_names[i]) | msgpack_pack_array(&pk, 2);
+        failed |= msgpack_pack_uint32(&pk, copy.gauges[i].value) | msgpack_pack_uint32(&pk, copy.gauges[i].max);
+    }
+
+    failed |= pack_key(&pk, "m") | msgpack_pack_array(&pk, 2);
+    failed |= msgpack_pack_uint32(&pk, copy.heap_free) | msgpack_pack_uint32(&pk, copy.heap_minimum_free);
+
+    failed |= pack_key(&pk, "s") | msgpack_pack_map(&pk, task_count);
+    for (size_t i = 0; i < task_count; ++i) {
+        // the high-water mark is in bytes on the ESP32
+        failed |= pack_key(&pk, pcTaskGetName(tasks[i]))
+                | msgpack_pack_uint32(&pk, (uint32_t)uxTaskGetStackHighWaterMark(tasks[i]));
+    }
+    return failed ? ESP_ERR_NO_MEM : ESP_OK;
+}
+
+uint32_t ubirch_metrics_percentile_us(const ubirch_metrics_histogram_t *histogram, uint32_t permille) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+    uint64_t rank = ((uint64_t)histogram->count * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < UBIRCH_METRICS_BUCKETS - 1; ++i) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            // the upper bound of the bucket, not above the maximum
+            uint32_t upper_us = (i == 0) ? 0 : (1u << i) - 1;
+            return (upper_us < histogram->max_us) ? upper_us : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+uint32_t ubirch_metrics_overhead_ns(void) {
+    static ubirch_metrics_histogram_t scratch;
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < METRICS_OVERHEAD_ROUNDS; ++i) {
+        ubirch_metrics_span_t span = ubirch_metrics_start();
+        // the same work as ubirch_metrics_stop(), on a histogram, which is not reported
+        uint32_t cycles = esp_cpu_get_ccount() - span.cycles;
+        if (xPortGetCoreID() != span.core) {
+            scratch.migrated++;
+            continue;
+        }
+        histogram_add(&scratch, cycles);
+    }
+    return (uint32_t)((esp_timer_get_time() - start) * 1000 / METRICS_OVERHEAD_ROUNDS);
+}
+
+void ubirch_metrics_log(void) {
+    static ubirch_metrics_stats_t copy;
+    ubirch_metrics_stats_get(&copy);
+    for (size_t i = 0; i < UBIRCH_METRICS_TIMERS; ++i) {
+        const ubirch_metrics_histogram_t *histogram = &copy.timers[i];
+        if (histogram->count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-8s %u x, avg %u us, p50 %u us, p99 %u us, max %u us, %u migrated", timer_names[i],
+                (unsigned int)histogram->count, (unsigned int)(histogram->total_us / histogram->count),
+                (unsigned int)ubirch_metrics_percentile_us(histogram, 500),
+                (unsigned int)ubirch_metrics_percentile_us(histogram, 990),
+                (unsigned int)histogram->max_us, (unsigned int)histogram->migrated);
+    }
+    ESP_LOGI(TAG, "slots %u (max %u), backlog %u (max %u), heap free %u (min %u)",
+            (unsigned int)copy.gauges[UBIRCH_METRICS_SLOTS].value,
+            (unsigned int)copy.gauges[UBIRCH_METRICS_SLOTS].max,
+            (unsigned int)copy.gauges[UBIRCH_METRICS_BACKLOG].value,
+            (unsigned int)copy.gauges[UBIRCH_METRICS_BACKLOG].max,
+            (unsigned int)copy.heap_free, (unsigned int)copy.heap_minimum_free);
+
+    msgpack_sbuffer buffer;
+    msgpack_sbuffer_init(&buffer);
+    if (ubirch_metrics_snapshot(&buffer) == ESP_OK) {
+        ESP_LOG_BUFFER_HEX(TAG, buffer.data, buffer.size);
+    }
+    msgpack_sbuffer_destroy(&buffer);
+}
+
+const char *ubirch_metrics_timer_name(ubirch_metrics_timer_t timer) {
+    return (timer < UBIRCH_METRICS_TIMERS) ? timer_names[timer] : "?";
+}
+
+const char *ubirch_metrics_counter_name(ubirch_metrics_counter_t counter) {
+    return (counter < UBIRCH_METRICS_COUNTERS) ? counter_names[counter] : "?";
+}
+
+const char *ubirch_metrics_gauge_name(ubirch_metrics_gauge_t gauge) {
+    return (gauge < UBIRCH_METRICS_GAUGES) ? gauge_names[gauge] : "?";
+}
+
+#endif // CONFIG_UBIRCH_METRICS
@@ -0,0 +1,232 @@
+/*!
+ * @file metrics.h
+ * @brief Runtime metrics of the gateway: timers, counters and gauges.
+ *
+ * The timers measure the steps of the anchoring with the cycle counter of
+ * the core and sort the durations into a histogram with one bucket per
+ * power of two microseconds. The counters count events, the gauges keep
+ * the last value and the maximum of a level, e.g. the used sensor slots.
+ * The free heap and the stack high-water marks of the registered tasks
+ * are sampled, when the metrics are read.
+ *
+ * All metrics are updated without a lock, a copy taken during an update
+ * can miss this update. The cycle counters of the two cores are not in
+ * sync, so a measurement, which started on the other core, is only counted
+ * as migrated. Tasks, which are pinned to a core, are measured completely.
+ *
+ * The snapshot is a msgpack map, small enough to be logged periodically or
+ * sent to the backend along with the data:
+ * ```
+ * {"v": 1, "t": uptime_ms,
+ *  "h": {timer: [count, total_us, max_us, migrated, [buckets...]]},
+ *  "c": {counter: value},
+ *  "g": {gauge: [value, max]},
+ *  "m": [free heap, lowest free heap],
+ *  "s": {task: free stack bytes}}
+ * ```
+ * The bucket i of a histogram counts durations below 2^i us, which are not
+ * in bucket i-1, trailing empty buckets are left out.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_METRICS_H
+#define EXAMPLE_ESP32_METRICS_H
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_cpu.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <msgpack.h>
+
+/*!
+ * Timed steps of the anchoring.
+ */
+typedef enum {
+    UBIRCH_METRICS_MANAGE = 0,      //!< ubirch_id_context_manage()
+    UBIRCH_METRICS_MESSAGE,         //!< ubirch_message(), creating and signing a UPP
+    UBIRCH_METRICS_SIGN,            //!< the signature, part of the message
+    UBIRCH_METRICS_SEND,            //!< sending a UPP and receiving the response
+    UBIRCH_METRICS_PARSE,           //!< verifying and parsing the response
+    UBIRCH_METRICS_CREATE,          //!< creating the context of a new sensor, with its key pair
+    UBIRCH_METRICS_TIMERS
+} ubirch_metrics_timer_t;
+
+/*!
+ * Counted events.
+ */
+typedef enum {
+    UBIRCH_METRICS_READINGS = 0,    //!< sensor readings handed over by the sensors
+    UBIRCH_METRICS_UPPS,            //!< signed UPPs
+    UBIRCH_METRICS_SENDS,           //!< requests to the data service
+    UBIRCH_METRICS_SEND_FAILURES,   //!< requests without a response
+    UBIRCH_METRICS_BYTES_SENT,      //!< UPP bytes sent
+    UBIRCH_METRICS_COUNTERS
+} ubirch_metrics_counter_t;
+
+/*!
+ * Levels, of which the last value and the maximum are kept.
+ */
+typedef enum {
+    UBIRCH_METRICS_SLOTS = 0,       //!< sensor data slots in use
+    UBIRCH_METRICS_BACKLOG,         //!< UPPs waiting to be sent
+    UBIRCH_METRICS_GAUGES
+} ubirch_metrics_gauge_t;
+
+// bucket i takes the durations in [2^(i-1), 2^i) us, the last one takes the rest
+#define UBIRCH_METRICS_BUCKETS 24
+
+/*!
+ * Histogram of the durations of one timer.
+ */
+typedef struct {
+    uint32_t count;         //!< number of measurements
+    uint32_t migrated;      //!< measurements, which ended on another core
+    uint32_t max_us;        //!< longest duration
+    uint64_t total_us;      //!< sum of all durations, for the average
+    uint32_t buckets[UBIRCH_METRICS_BUCKETS];
+} ubirch_metrics_histogram_t;
+
+/*!
+ * Last value and maximum of a gauge.
+ */
+typedef struct {
+    uint32_t value;
+    uint32_t max;
+} ubirch_metrics_level_t;
+
+/*!
+ * Copy of all timers, counters and gauges.
+ */
+typedef struct {
+    ubirch_metrics_histogram_t timers[UBIRCH_METRICS_TIMERS];
+    uint64_t counters[UBIRCH_METRICS_COUNTERS];
+    ubirch_metrics_level_t gauges[UBIRCH_METRICS_GAUGES];
+    uint32_t heap_free;             //!< free heap, sampled
+    uint32_t heap_minimum_free;     //!< lowest free heap since the start
+} ubirch_metrics_stats_t;
+
+/*!
+ * Start of a measurement, see ubirch_metrics_start().
+ */
+typedef struct {
+    uint32_t cycles;
+    BaseType_t core;
+} ubirch_metrics_span_t;
+
+/*!
+ * @brief Start a measurement.
+ */
+static inline ubirch_metrics_span_t ubirch_metrics_start(void) {
+    ubirch_metrics_span_t span = { .cycles = esp_cpu_get_ccount(), .core = xPortGetCoreID() };
+    return span;
+}
+
+/*!
+ * @brief Finish a measurement and add its duration to the histogram of \p timer.
+ */
+void ubirch_metrics_stop(ubirch_metrics_timer_t timer, ubirch_metrics_span_t span);
+
+/*!
+ * @brief Add \p n to a counter.
+ */
+void ubirch_metrics_count(ubirch_metrics_counter_t counter, uint32_t n);
+
+/*!
+ * @brief Set the value of a gauge.
+ */
+void ubirch_metrics_gauge_set(ubirch_metrics_gauge_t gauge, uint32_t value);
+
+#if CONFIG_UBIRCH_METRICS
+#define UBIRCH_METRICS_SPAN(span) ubirch_metrics_span_t span = ubirch_metrics_start()
+#define UBIRCH_METRICS_STOP(timer, span) ubirch_metrics_stop((timer), (span))
+#define UBIRCH_METRICS_COUNT(counter, n) ubirch_metrics_count((counter), (n))
+#define UBIRCH_METRICS_GAUGE(gauge, value) ubirch_metrics_gauge_set((gauge), (value))
+#define UBIRCH_METRICS_TASK_ADD() ubirch_metrics_task_add(NULL)
+#else
+#define UBIRCH_METRICS_SPAN(span)
+#define UBIRCH_METRICS_STOP(timer, span) ((void)0)
+#define UBIRCH_METRICS_COUNT(counter, n) ((void)0)
+#define UBIRCH_METRICS_GAUGE(gauge, value) ((void)0)
+#define UBIRCH_METRICS_TASK_ADD() ((void)0)
+#endif
+
+/*!
+ * @brief Reset all metrics and start the periodic log, if it is configured.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the log task could not be created
+ */
+esp_err_t ubirch_metrics_init(void);
+
+/*!
+ * @brief Add a task, whose stack high-water mark is part of the snapshot.
+ *
+ * The task has to run until the end, tasks which delete themselves must
+ * not be added.
+ *
+ * @param[in] task the task, or NULL for the calling task
+ */
+void ubirch_metrics_task_add(TaskHandle_t task);
+
+/*!
+ * @brief Get a copy of all metrics, the heap is sampled for it.
+ *
+ * @param[out] stats pointer to the metrics to fill
+ */
+void ubirch_metrics_stats_get(ubirch_metrics_stats_t *stats);
+
+/*!
+ * @brief Pack a snapshot of all metrics into \p buffer.
+ *
+ * @param[in,out] buffer the snapshot is appended to the buffer
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the buffer could not grow
+ */
+esp_err_t ubirch_metrics_snapshot(msgpack_sbuffer *buffer);
+
+/*!
+ * @brief Log the timers and gauges and the snapshot as hex.
+ */
+void ubirch_metrics_log(void);
+
+/*!
+ * @brief Get a percentile of a timer from its histogram.
+ *
+ * The result is the upper bound of the bucket, which contains the
+ * percentile, so it is at most twice the exact value.
+ *
+ * @param[in] histogram the histogram, e.g. of a copy of the metrics
+ * @param[in] permille the percentile in 1/1000, e.g. 990 for the 99th percentile
+ * @return the percentile in us, or 0 without measurements
+ */
+uint32_t ubirch_metrics_percentile_us(const ubirch_metrics_histogram_t *histogram, uint32_t permille);
+
+/*!
+ * @brief Measure the cost of one measurement, a start and a stop.
+ *
+ * @return the cost in ns
+ */
+uint32_t ubirch_metrics_overhead_ns(void);
+
+/*!
+ * @brief Get the name of a timer, counter or gauge, as used in the snapshot.
+ */
+const char *ubirch_metrics_timer_name(ubirch_metrics_timer_t timer);
+const char *ubirch_metrics_counter_name(ubirch_metrics_counter_t counter);
+const char *ubirch_metrics_gauge_name(ubirch_metrics_gauge_t gauge);
+
+#endif /* EXAMPLE_ESP32_METRICS_H */
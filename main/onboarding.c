@@ -0,0 +1,363 @@
+/*!
+ * @file onboarding.c
+ * @brief Onboarding worker, which creates and registers new identities.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <networking.h>
+
+#include "budget.h"
+#include "id_manager.h"
+#include "metrics.h"
+#include "sensor_data.h"
+#include "onboarding.h"
+
+#if CONFIG_UBIRCH_ONBOARDING
+
+static const char *TAG = "onboarding";
+
+#define ONBOARDING_PRIORITY 5
+#define ONBOARDING_POLL_MS 1000
+#define ONBOARDING_MAX_BACKOFF_SHIFT 16
+
+#if CONFIG_UBIRCH_SERIES
+// a window of the time series with its header
+#define ONBOARDING_PAYLOAD_SIZE (32 + CONFIG_UBIRCH_SERIES_MAX_BYTES)
+#elif CONFIG_UBIRCH_MERKLE
+// the root of an epoch
+#define ONBOARDING_PAYLOAD_SIZE 128
+#else
+// the timestamp and the values of one reading
+#define ONBOARDING_PAYLOAD_SIZE (16 + 5 * CONFIG_UBIRCH_SENSOR_MAX_VALUES)
+#endif
+
+/*!
+ * Identity, which waits for its onboarding.
+ */
+typedef struct {
+    char id[UBIRCH_SENSOR_ID_SIZE];     //!< empty, if the entry is unused
+    uint32_t attempts;      //!< failed attempts of the current step
+    int64_t next_attempt;   //!< time of the next attempt (esp_timer_get_time())
+} onboarding_entry_t;
+
+/*!
+ * Payload of a sensor, which waits for its onboarding.
+ */
+typedef struct {
+    char id[UBIRCH_SENSOR_ID_SIZE];
+    bool ready;             //!< the onboarding is done, the payload can be signed
+    uint16_t len;           //!< 0, if the buffer is unused
+    int64_t started;
+    char payload[ONBOARDING_PAYLOAD_SIZE];
+} onboarding_parked_t;
+
+static onboarding_entry_t pending[CONFIG_UBIRCH_ONBOARDING_PENDING];
+#if CONFIG_UBIRCH_ONBOARDING_PARKED > 0
+static onboarding_parked_t parked[CONFIG_UBIRCH_ONBOARDING_PARKED];
+#endif
+static uint32_t ready_count = 0;
+
+static SemaphoreHandle_t context_lock = NULL;   //!< the current context of the key storage
+static SemaphoreHandle_t table_lock = NULL;     //!< the pending identities and the parked payloads
+static TaskHandle_t worker_handle = NULL;
+UBIRCH_SEMAPHORE_DEFINE(context_lock);
+UBIRCH_SEMAPHORE_DEFINE(table_lock);
+UBIRCH_TASK_DEFINE(onboarding_task, CONFIG_UBIRCH_STACK_ONBOARDING);
+static ubirch_onboarding_stats_t stats = { 0 };
+
+static onboarding_entry_t *pending_find(const char *id) {
+    for (size_t i = 0; i < CONFIG_UBIRCH_ONBOARDING_PENDING; ++i) {
+        if (pending[i].id[0] != '\0' && strncmp(pending[i].id, id, UBIRCH_SENSOR_ID_SIZE) == 0) {
+            return &pending[i];
+        }
+    }
+    return NULL;
+}
+
+/*!
+ * Get the identity, which is due next.
+ */
+static onboarding_entry_t *pending_next(void) {
+    onboarding_entry_t *next = NULL;
+    for (size_t i = 0; i < CONFIG_UBIRCH_ONBOARDING_PENDING; ++i) {
+        if (pending[i].id[0] != '\0'
+                && (next == NULL || pending[i].next_attempt < next->next_attempt)) {
+            next = &pending[i];
+        }
+    }
+    return next;
+}
+
+/*!
+ * Remove an onboarded identity, its parked payloads can be signed now.
+ */
+static void pending_done(onboarding_entry_t *entry) {
+#if CONFIG_UBIRCH_ONBOARDING_PARKED > 0
+    for (size_t i = 0; i < CONFIG_UBIRCH_ONBOARDING_PARKED; ++i) {
+        if (parked[i].len > 0 && !parked[i].ready
+                && strncmp(parked[i].id, entry->id, UBIRCH_SENSOR_ID_SIZE) == 0) {
+            parked[i].ready = true;
+            ready_count++;
+        }
+    }
+#endif
+    memset(entry, 0, sizeof(onboarding_entry_t));
+}
+
+/*!
+ * Schedule the next attempt of a failed step, the delay doubles with every
+ * failed attempt. The random part spreads the retries of sensors, which
+ * failed at the same time, e.g. because the network was down.
+ */
+static void pending_retry(onboarding_entry_t *entry) {
+    uint32_t shift = (entry->attempts < ONBOARDING_MAX_BACKOFF_SHIFT) ? entry->attempts : ONBOARDING_MAX_BACKOFF_SHIFT;
+    int64_t delay_ms = (int64_t)CONFIG_UBIRCH_ONBOARDING_RETRY_MS << shift;
+    if (delay_ms > CONFIG_UBIRCH_ONBOARDING_RETRY_MAX_MS) {
+        delay_ms = CONFIG_UBIRCH_ONBOARDING_RETRY_MAX_MS;
+    }
+    delay_ms += (int64_t)(esp_random() % (uint32_t)(delay_ms / 4 + 1));
+    entry->attempts++;
+    entry->next_attempt = esp_timer_get_time() + delay_ms * 1000;
+    ESP_LOGW(TAG, "onboarding of \"%s\" failed %u times, retry in %lld ms", entry->id,
+            (unsigned int)entry->attempts, (long long)delay_ms);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-noreturn"
+
+/*!
+ * Worker task: onboard the pending identities, one step at a time.
+ */
+static void onboarding_task(void __unused *pvParameters) {
+    UBIRCH_METRICS_TASK_ADD();
+    for (;;) {
+        char id[UBIRCH_SENSOR_ID_SIZE];
+        xSemaphoreTake(table_lock, portMAX_DELAY);
+        onboarding_entry_t *entry = pending_next();
+        int64_t wait_us = (entry != NULL) ? entry->next_attempt - esp_timer_get_time() : -1;
+        if (entry != NULL) {
+            memcpy(id, entry->id, UBIRCH_SENSOR_ID_SIZE);
+        }
+        xSemaphoreGive(table_lock);
+
+        if (entry == NULL) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        } else if (wait_us > 0) {
+            // a new request wakes the worker up earlier
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_us / 1000) + 1);
+            continue;
+        }
+
+        // the registrations need the network
+        xEventGroupWaitBits(network_event_group, WIFI_CONNECTED_BIT, false, false, portMAX_DELAY);
+
+        // the steps hold the current context only to load and to store the context, not across their round trip
+        esp_err_t err = ubirch_id_context_onboard(id);
+        if (err == ESP_OK) {
+            // an identity, which is onboarded already, is queued for its key update
+            err = ubirch_id_context_key_update(id);
+        }
+
+        xSemaphoreTake(table_lock, portMAX_DELAY);
+        stats.steps++;
+        entry = pending_find(id);
+        if (entry != NULL) {
+            if (err == ESP_OK) {
+                ESP_LOGI(TAG, "\"%s\" onboarded", id);
+                pending_done(entry);
+                stats.onboarded++;
+            } else if (err == UBIRCH_ID_CONTEXT_PENDING) {
+                // continue with the next step of this identity, so it is complete soon
+                entry->attempts = 0;
+            } else {
+                pending_retry(entry);
+                stats.retries++;
+            }
+        }
+        xSemaphoreGive(table_lock);
+
+        // spread the round trips of the onboarding, a burst of new sensors does not load the backend at once
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_UBIRCH_ONBOARDING_STEP_PAUSE_MS) + 1);
+    }
+}
+
+#pragma GCC diagnostic pop
+
+esp_err_t ubirch_onboarding_start(void) {
+    memset(pending, 0, sizeof(pending));
+#if CONFIG_UBIRCH_ONBOARDING_PARKED > 0
+    memset(parked, 0, sizeof(parked));
+#endif
+    memset(&stats, 0, sizeof(stats));
+    ready_count = 0;
+
+    context_lock = UBIRCH_MUTEX_CREATE(context_lock);
+    table_lock = UBIRCH_MUTEX_CREATE(table_lock);
+    if (context_lock == NULL || table_lock == NULL) {
+        ESP_LOGE(TAG, "failed to create locks");
+        return ESP_ERR_NO_MEM;
+    }
+    if (UBIRCH_TASK_CREATE(onboarding_task, &onboarding_task, "onboarding", ONBOARDING_PRIORITY, &worker_handle,
+            tskNO_AFFINITY) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void ubirch_onboarding_lock(void) {
+    if (context_lock != NULL) {
+        xSemaphoreTake(context_lock, portMAX_DELAY);
+    }
+}
+
+bool ubirch_onboarding_lock_wait(uint32_t timeout_ms) {
+    return context_lock == NULL || xSemaphoreTake(context_lock, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void ubirch_onboarding_unlock(void) {
+    if (context_lock != NULL) {
+        xSemaphoreGive(context_lock);
+    }
+}
+
+esp_err_t ubirch_onboarding_request(const char *id) {
+    if (table_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(table_lock, portMAX_DELAY);
+    if (pending_find(id) != NULL) {
+        xSemaphoreGive(table_lock);
+        return ESP_OK;
+    }
+    onboarding_entry_t *entry = NULL;
+    uint32_t count = 0;
+    for (size_t i = 0; i < CONFIG_UBIRCH_ONBOARDING_PENDING; ++i) {
+        if (pending[i].id[0] == '\0') {
+            entry = (entry == NULL) ? &pending[i] : entry;
+        } else {
+            count++;
+        }
+    }
+    if (entry == NULL) {
+        stats.rejected++;
+        xSemaphoreGive(table_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    strncpy(entry->id, id, UBIRCH_SENSOR_ID_SIZE - 1);
+    entry->attempts = 0;
+    entry->next_attempt = esp_timer_get_time();
+    stats.requested++;
+    if (count + 1 > stats.max_pending) {
+        stats.max_pending = count + 1;
+    }
+    xSemaphoreGive(table_lock);
+
+    ESP_LOGI(TAG, "\"%s\" queued for onboarding", id);
+    xTaskNotifyGive(worker_handle);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_onboarding_park(const char *id, const char *payload, size_t len, int64_t started) {
+#if CONFIG_UBIRCH_ONBOARDING_PARKED > 0
+    xSemaphoreTake(table_lock, portMAX_DELAY);
+    // a payload of an identity, which is not queued, would never be signed
+    if (len <= ONBOARDING_PAYLOAD_SIZE && pending_find(id) != NULL) {
+        for (size_t i = 0; i < CONFIG_UBIRCH_ONBOARDING_PARKED; ++i) {
+            if (parked[i].len == 0) {
+                strncpy(parked[i].id, id, UBIRCH_SENSOR_ID_SIZE - 1);
+                parked[i].id[UBIRCH_SENSOR_ID_SIZE - 1] = '\0';
+                memcpy(parked[i].payload, payload, len);
+                parked[i].len = (uint16_t)len;
+                parked[i].started = started;
+                parked[i].ready = false;
+                stats.parked++;
+                xSemaphoreGive(table_lock);
+                return ESP_OK;
+            }
+        }
+    }
+    stats.dropped++;
+    xSemaphoreGive(table_lock);
+#else
+    stats.dropped++;
+#endif
+    ESP_LOGW(TAG, "payload of \"%s\" dropped during its onboarding", id);
+    return ESP_ERR_NO_MEM;
+}
+
+size_t ubirch_onboarding_replay(ubirch_onboarding_sink_t sink) {
+    size_t replayed = 0;
+#if CONFIG_UBIRCH_ONBOARDING_PARKED > 0
+    static onboarding_parked_t payload;
+
+    for (size_t i = 0; i < CONFIG_UBIRCH_ONBOARDING_PARKED; ++i) {
+        xSemaphoreTake(table_lock, portMAX_DELAY);
+        bool ready = parked[i].len > 0 && parked[i].ready;
+        if (ready) {
+            // the buffer is free again, before the sink possibly parks the payload again
+            memcpy(&payload, &parked[i], sizeof(onboarding_parked_t));
+            parked[i].len = 0;
+            ready_count--;
+            stats.replayed++;
+        }
+        xSemaphoreGive(table_lock);
+        if (ready) {
+            sink(payload.id, payload.payload, payload.len, payload.started);
+            replayed++;
+        }
+    }
+#endif
+    return replayed;
+}
+
+int32_t ubirch_onboarding_timeout_ms(void) {
+    int32_t timeout_ms = -1;
+#if CONFIG_UBIRCH_ONBOARDING_PARKED > 0
+    xSemaphoreTake(table_lock, portMAX_DELAY);
+    if (ready_count > 0) {
+        timeout_ms = 0;
+    } else {
+        for (size_t i = 0; i < CONFIG_UBIRCH_ONBOARDING_PARKED; ++i) {
+            if (parked[i].len > 0) {
+                // the worker does not wake up the data path, so check again later
+                timeout_ms = ONBOARDING_POLL_MS;
+                break;
+            }
+        }
+    }
+    xSemaphoreGive(table_lock);
+#endif
+    return timeout_ms;
+}
+
+void ubirch_onboarding_stats_get(ubirch_onboarding_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_onboarding_stats_t));
+}
+
+#endif // CONFIG_UBIRCH_ONBOARDING
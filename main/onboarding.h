@@ -0,0 +1,144 @@
+/*!
+ * @file onboarding.h
+ * @brief Onboarding worker, which creates and registers new identities.
+ *
+ * The onboarding of a new sensor takes several round trips to the backend:
+ * the thing registration in the ubirch console and the registration of its
+ * public key. Instead of doing this in the data path, the data path queues
+ * the identity and continues with the next reading. The worker task
+ * onboards the queued identities one step at a time and retries failed
+ * steps with an exponential backoff.
+ *
+ * The key storage has only one current context, so the data path and the
+ * worker share it with ubirch_onboarding_lock(). The worker gives the
+ * context back after every step, so a known sensor waits at most for one
+ * round trip instead of the complete onboarding of all new sensors.
+ *
+ * Payloads of sensors, which wait for their onboarding, are parked in a few
+ * buffers and handed to the data path again, when the onboarding is done.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_ONBOARDING_H
+#define EXAMPLE_ESP32_ONBOARDING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * Function, which anchors a parked payload.
+ *
+ * @param id the sensor id of the payload
+ * @param payload the payload
+ * @param len the length of the payload
+ * @param started time the payload entered the gateway (esp_timer_get_time())
+ */
+typedef esp_err_t (*ubirch_onboarding_sink_t)(const char *id, const char *payload, size_t len, int64_t started);
+
+/*!
+ * Statistics of the onboarding worker.
+ */
+typedef struct {
+    uint32_t requested;     //!< identities queued for onboarding
+    uint32_t rejected;      //!< identities not queued, as the queue was full
+    uint32_t onboarded;     //!< identities, which completed their onboarding
+    uint32_t steps;         //!< onboarding steps done, one round trip each
+    uint32_t retries;       //!< failed steps, which are tried again later
+    uint32_t parked;        //!< payloads parked until their identity was onboarded
+    uint32_t replayed;      //!< parked payloads handed to the sink
+    uint32_t dropped;       //!< payloads dropped, as no buffer was free
+    uint32_t max_pending;   //!< highest number of identities in the queue
+} ubirch_onboarding_stats_t;
+
+/*!
+ * @brief Start the onboarding worker task.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_onboarding_start(void);
+
+/*!
+ * @brief Take the current context of the key storage.
+ *
+ * Everything, which uses or changes the current context, has to hold it.
+ */
+void ubirch_onboarding_lock(void);
+
+/*!
+ * @brief Take the current context of the key storage, if it is free within \p timeout_ms.
+ *
+ * @param[in] timeout_ms the time to wait
+ * @return true, if the current context was taken, or the worker is not started
+ */
+bool ubirch_onboarding_lock_wait(uint32_t timeout_ms);
+
+/*!
+ * @brief Give the current context of the key storage back.
+ */
+void ubirch_onboarding_unlock(void);
+
+/*!
+ * @brief Queue the identity of the sensor \p id for its onboarding.
+ *
+ * The identity is onboarded, or its key is updated, if it is due. If it is
+ * already queued, nothing changes.
+ *
+ * @param[in] id the sensor id
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the queue is full
+ */
+esp_err_t ubirch_onboarding_request(const char *id);
+
+/*!
+ * @brief Keep a payload of a sensor, which waits for its onboarding.
+ *
+ * @param[in] id the sensor id
+ * @param[in] payload the payload, which is copied
+ * @param[in] len the length of the payload
+ * @param[in] started time the payload entered the gateway
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the payload was dropped
+ */
+esp_err_t ubirch_onboarding_park(const char *id, const char *payload, size_t len, int64_t started);
+
+/*!
+ * @brief Hand the parked payloads of onboarded sensors to \p sink.
+ *
+ * Has to be called by the data path, without holding the lock.
+ *
+ * @param[in] sink function, which anchors the payload
+ * @return number of payloads handed to the sink
+ */
+size_t ubirch_onboarding_replay(ubirch_onboarding_sink_t sink);
+
+/*!
+ * @brief Get the time until the parked payloads should be checked again.
+ *
+ * @return 0 if there are payloads to replay, the time in ms until the next
+ *         check, if payloads wait for their onboarding, -1 otherwise
+ */
+int32_t ubirch_onboarding_timeout_ms(void);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_onboarding_stats_get(ubirch_onboarding_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_ONBOARDING_H */
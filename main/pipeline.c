@@ -0,0 +1,736 @@
+/*!
+ * @file pipeline.c
+ * @brief Anchoring pipeline, which spreads the work over both cores.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <msgpack.h>
+#include <networking.h>
+
+#include "anchor.h"
+#include "binlog.h"
+#include "budget.h"
+#include "heap_audit.h"
+#include "id_manager.h"
+#include "merkle.h"
+#include "metrics.h"
+#include "onboarding.h"
+#include "rate_control.h"
+#include "sensor_data.h"
+#include "series.h"
+#include "upp_queue.h"
+#include "verify_batch.h"
+
+#include "pipeline.h"
+
+#if CONFIG_UBIRCH_PIPELINE
+
+static const char *TAG = "pipeline";
+
+#if CONFIG_FREERTOS_UNICORE
+#define PIPELINE_CORE(core) 0
+#else
+#define PIPELINE_CORE(core) (core)
+#endif
+
+#define PIPELINE_DEPTH CONFIG_UBIRCH_PIPELINE_DEPTH
+#define PIPELINE_PRIORITY 6
+#define PIPELINE_STATS_INTERVAL 16
+
+// the transmit stage holds at most the jobs of the pipeline
+#define PIPELINE_BATCH_SIZE MIN(CONFIG_UBIRCH_PIPELINE_BATCH_SIZE, PIPELINE_DEPTH)
+// the transmit task sends the first UPP of a batch itself
+#define PIPELINE_SENDERS (PIPELINE_BATCH_SIZE - 1)
+
+#if CONFIG_UBIRCH_VERIFY_BATCH
+// the verify stage holds at most the jobs of the pipeline
+#define VERIFY_BATCH_SIZE MIN(CONFIG_UBIRCH_VERIFY_BATCH_SIZE, PIPELINE_DEPTH)
+#else
+#define VERIFY_BATCH_SIZE 1
+#endif
+
+/*!
+ * Signed UPP on its way from the sign stage to the verify stage.
+ */
+typedef struct {
+    ubirch_anchor_upp_t upp;
+    msgpack_unpacker *unpacker;     //!< receiver of the response, reused for every UPP
+    int http_status;
+    esp_err_t err;                  //!< result of the transmission
+    int64_t ingested;
+    int64_t handed_over;
+} pipeline_job_t;
+
+static pipeline_job_t jobs[PIPELINE_DEPTH];
+
+static QueueHandle_t free_queue = NULL;         //!< pipeline_job_t *, unused jobs
+static QueueHandle_t transmit_queue = NULL;     //!< pipeline_job_t *, sign -> transmit
+static QueueHandle_t verify_queue = NULL;       //!< pipeline_job_t *, transmit -> verify
+static TaskHandle_t transmit_task_handle = NULL;
+UBIRCH_QUEUE_DEFINE(free_queue, PIPELINE_DEPTH, sizeof(pipeline_job_t *));
+UBIRCH_QUEUE_DEFINE(transmit_queue, PIPELINE_DEPTH, sizeof(pipeline_job_t *));
+UBIRCH_QUEUE_DEFINE(verify_queue, PIPELINE_DEPTH, sizeof(pipeline_job_t *));
+UBIRCH_TASK_DEFINE(sign_task, CONFIG_UBIRCH_STACK_SIGN);
+UBIRCH_TASK_DEFINE(transmit_task, CONFIG_UBIRCH_STACK_TRANSMIT);
+UBIRCH_TASK_DEFINE(verify_task, CONFIG_UBIRCH_STACK_VERIFY);
+#if PIPELINE_SENDERS > 0
+static QueueHandle_t send_queue = NULL;         //!< pipeline_job_t *, transmit -> send
+static SemaphoreHandle_t sent = NULL;           //!< given by the send tasks for every sent job
+UBIRCH_QUEUE_DEFINE(send_queue, PIPELINE_SENDERS, sizeof(pipeline_job_t *));
+UBIRCH_SEMAPHORE_DEFINE(sent);
+UBIRCH_TASKS_DEFINE(send_task, PIPELINE_SENDERS, CONFIG_UBIRCH_STACK_TRANSMIT);
+#endif
+#if CONFIG_UBIRCH_VERIFY_BATCH
+static bool verify_batch_ready = false;    //!< the batch verification passed its known answer tests
+#endif
+
+static ubirch_pipeline_stats_t stats = { 0 };
+
+static const char *stage_names[UBIRCH_PIPELINE_STAGES] = {
+        "ingest", "resolve", "sign", "transmit", "verify"
+};
+
+#if CONFIG_UBIRCH_PIPELINE_PERCENTILES
+/*!
+ * Histogram bucket of \p us: below 4 us one bucket per us, above four
+ * buckets per power of two, selected by the two bits after the highest.
+ */
+static uint32_t bucket_index(uint32_t us) {
+    if (us < 4) {
+        return us;
+    }
+    uint32_t exponent = 31 - (uint32_t)__builtin_clz(us);
+    uint32_t index = 4 + (exponent - 2) * 4 + ((us >> (exponent - 2)) & 3);
+    return (index < UBIRCH_PIPELINE_BUCKETS) ? index : UBIRCH_PIPELINE_BUCKETS - 1;
+}
+
+/*!
+ * Largest latency in the bucket \p index.
+ */
+static uint32_t bucket_upper_us(uint32_t index) {
+    if (index < 4) {
+        return index;
+    }
+    uint32_t exponent = (index - 4) / 4 + 2;
+    return ((5 + (index - 4) % 4) << (exponent - 2)) - 1;
+}
+#endif
+
+static void latency_record(ubirch_pipeline_latency_t *latency, uint32_t us) {
+    latency->count++;
+    latency->last_us = us;
+    latency->total_us += us;
+    if (us > latency->max_us) {
+        latency->max_us = us;
+    }
+#if CONFIG_UBIRCH_PIPELINE_PERCENTILES
+    latency->buckets[bucket_index(us)]++;
+#endif
+}
+
+/*!
+ * Add the time since \p start to the latency \p latency and return the current time.
+ */
+static int64_t latency_add(ubirch_pipeline_latency_t *latency, int64_t start) {
+    int64_t now = esp_timer_get_time();
+    latency_record(latency, (uint32_t)(now - start));
+    return now;
+}
+
+static void job_release(pipeline_job_t *job) {
+    ubirch_anchor_unpacker_reset(job->unpacker);
+    xQueueSend(free_queue, &job, portMAX_DELAY);
+}
+
+static void stats_log(void) {
+    for (int i = 0; i < UBIRCH_PIPELINE_STAGES; ++i) {
+        const ubirch_pipeline_latency_t *latency = &stats.stage[i];
+        if (latency->count == 0) {
+            continue;
+        }
+#if CONFIG_UBIRCH_PIPELINE_PERCENTILES
+        ESP_LOGI(TAG, "%-8s avg %u us, p50 %u us, p99 %u us, max %u us", stage_names[i],
+                (unsigned int)(latency->total_us / latency->count),
+                (unsigned int)ubirch_pipeline_percentile_us(latency, 500),
+                (unsigned int)ubirch_pipeline_percentile_us(latency, 990), (unsigned int)latency->max_us);
+#else
+        ESP_LOGI(TAG, "%-8s avg %u us, max %u us", stage_names[i],
+                (unsigned int)(latency->total_us / latency->count), (unsigned int)latency->max_us);
+#endif
+    }
+    if (stats.end_to_end.count > 0) {
+        ESP_LOGI(TAG, "total    avg %u us, max %u us, %u failed",
+                (unsigned int)(stats.end_to_end.total_us / stats.end_to_end.count),
+                (unsigned int)stats.end_to_end.max_us, (unsigned int)stats.failed);
+    }
+#if CONFIG_UBIRCH_SERIES
+    ubirch_series_stats_t series_stats;
+    ubirch_series_stats_get(&series_stats);
+    ubirch_anchor_stats_log(series_stats.samples);
+#elif CONFIG_UBIRCH_MERKLE
+    ubirch_merkle_stats_t merkle_stats;
+    ubirch_merkle_stats_get(&merkle_stats);
+    ubirch_anchor_stats_log(merkle_stats.readings);
+#else
+    ubirch_anchor_stats_log(stats.stage[UBIRCH_PIPELINE_INGEST].count);
+#endif
+}
+
+/*!
+ * Make the context of \p id the current context, sign the payload and hand
+ * the UPP over to the transmit stage.
+ *
+ * @param ingested time the data entered the pipeline
+ * @param received time the sign stage got the data
+ * @return ESP_OK, UBIRCH_ID_CONTEXT_PENDING if the sensor waits for its onboarding, or ESP_FAIL
+ */
+static esp_err_t sign_in_context(char *id, const char *payload, size_t len, int64_t ingested, int64_t received) {
+    // manage the current ID context
+    UBIRCH_METRICS_SPAN(manage);
+    esp_err_t err = ubirch_id_context_manage(id);
+    UBIRCH_METRICS_STOP(UBIRCH_METRICS_MANAGE, manage);
+    if (err != ESP_OK) {
+        return err;
+    }
+    int64_t resolved = latency_add(&stats.stage[UBIRCH_PIPELINE_RESOLVE], received);
+
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+    // create UPP, sign it and store it, the transmit stage takes it from there
+    if (ubirch_anchor_enqueue_payload(payload, len) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to queue UPP");
+        return ESP_FAIL;
+    }
+    latency_add(&stats.stage[UBIRCH_PIPELINE_SIGN], resolved);
+    xTaskNotifyGive(transmit_task_handle);
+#else
+    // waits while all jobs are in the transmit or verify stage
+    pipeline_job_t *job = NULL;
+    xQueueReceive(free_queue, &job, portMAX_DELAY);
+
+    // create UPP and sign it
+    if (ubirch_anchor_sign_payload(payload, len, &job->upp) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to create UPP");
+        job_release(job);
+        return ESP_FAIL;
+    }
+    job->ingested = ingested;
+    job->handed_over = latency_add(&stats.stage[UBIRCH_PIPELINE_SIGN], resolved);
+    xQueueSend(transmit_queue, &job, portMAX_DELAY);
+#endif
+    return ESP_OK;
+}
+
+/*!
+ * Sign the payload in the context of \p id, see sign_in_context().
+ */
+static void sign_payload(char *id, const char *payload, size_t len, int64_t ingested, int64_t received) {
+#if CONFIG_UBIRCH_ONBOARDING
+    // the onboarding worker must not change the current context, until the UPP is signed
+    ubirch_onboarding_lock();
+    esp_err_t err = sign_in_context(id, payload, len, ingested, received);
+    ubirch_onboarding_unlock();
+    if (err == UBIRCH_ID_CONTEXT_PENDING) {
+        // the sensor is new, its payload is signed when its onboarding is done
+        err = ubirch_onboarding_park(id, payload, len, ingested);
+    }
+#else
+    esp_err_t err = sign_in_context(id, payload, len, ingested, received);
+#endif
+    if (err != ESP_OK) {
+        stats.failed++;
+    }
+}
+
+#if CONFIG_UBIRCH_SERIES || CONFIG_UBIRCH_MERKLE || CONFIG_UBIRCH_ONBOARDING
+/*!
+ * Sign a complete window of the time series, the root of a Merkle tree,
+ * or a payload, which was parked during the onboarding of its sensor.
+ */
+static esp_err_t sign_window(const char *id, const char *payload, size_t len, int64_t started) {
+    char window_id[UBIRCH_SENSOR_ID_SIZE];
+    snprintf(window_id, sizeof(window_id), "%s", id);
+    sign_payload(window_id, payload, len, started, esp_timer_get_time());
+    return ESP_OK;
+}
+#endif
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-noreturn"
+
+/*!
+ * Context resolve and sign stage: both use the current context of the key
+ * storage, so they have to run in the same task.
+ */
+static void sign_task(void __unused *pvParameters) {
+    UBIRCH_METRICS_TASK_ADD();
+    for (;;) {
+        TickType_t receive_timeout = portMAX_DELAY;
+#if CONFIG_UBIRCH_ONBOARDING
+        // payloads of sensors, which were onboarded in the meantime
+        int32_t onboarding_timeout = ubirch_onboarding_timeout_ms();
+        if (onboarding_timeout == 0) {
+            ubirch_onboarding_replay(sign_window);
+            continue;
+        } else if (onboarding_timeout > 0) {
+            receive_timeout = pdMS_TO_TICKS(onboarding_timeout);
+        }
+#endif
+#if CONFIG_UBIRCH_SERIES
+        // windows of sensors, which stopped sending, are signed when they get too old
+        int32_t series_timeout = ubirch_series_timeout_ms();
+        if (series_timeout == 0) {
+            ubirch_series_flush(sign_window, false);
+            continue;
+        } else if (series_timeout > 0) {
+            receive_timeout = MIN(receive_timeout, pdMS_TO_TICKS(series_timeout));
+        }
+#elif CONFIG_UBIRCH_MERKLE
+        // epochs of sensors, which stopped sending, are closed when they are over
+        int32_t merkle_timeout = ubirch_merkle_timeout_ms();
+        if (merkle_timeout == 0) {
+            ubirch_merkle_flush(sign_window, false);
+            continue;
+        } else if (merkle_timeout > 0) {
+            receive_timeout = MIN(receive_timeout, pdMS_TO_TICKS(merkle_timeout));
+        }
+#endif
+        // the ingest stage is the producer, between acquiring and committing the slot
+        sensor_data_t *sensor_data = ubirch_sensor_slot_receive(receive_timeout);
+        if (sensor_data == NULL) {
+            continue;
+        }
+        latency_record(&stats.stage[UBIRCH_PIPELINE_INGEST],
+                (uint32_t)(sensor_data->committed - sensor_data->acquired));
+        UBIRCH_LOG_STR(ESP_LOG_INFO, TAG, "sensor (%s): %u values received", sensor_data->id, sensor_data->num);
+
+#if CONFIG_UBIRCH_SERIES
+        // collect the sample, the window is signed when it is complete
+        while (ubirch_series_add(sensor_data) == ESP_ERR_NO_MEM) {
+            ubirch_series_flush(sign_window, false);
+        }
+        ubirch_sensor_slot_release(sensor_data);
+        ubirch_series_flush(sign_window, false);
+#elif CONFIG_UBIRCH_MERKLE
+        // hash the reading into the tree of its sensor, the root is signed when the epoch is over
+        const char *payload = NULL;
+        size_t len = 0;
+        esp_err_t err = ubirch_anchor_pack(sensor_data->values, sensor_data->num, &payload, &len);
+        while (err == ESP_OK && (err = ubirch_merkle_add(sensor_data->id, payload, len, NULL)) == ESP_ERR_NO_MEM) {
+            ubirch_merkle_flush(sign_window, false);
+        }
+        if (err != ESP_OK) {
+            stats.failed++;
+        }
+        ubirch_sensor_slot_release(sensor_data);
+        ubirch_merkle_flush(sign_window, false);
+#else
+        const char *payload = NULL;
+        size_t len = 0;
+        if (ubirch_anchor_pack(sensor_data->values, sensor_data->num, &payload, &len) == ESP_OK) {
+            sign_payload(sensor_data->id, payload, len, sensor_data->acquired, sensor_data->committed);
+        } else {
+            stats.failed++;
+        }
+        // the data is part of the signed UPP now
+        ubirch_sensor_slot_release(sensor_data);
+#endif
+    }
+}
+
+/*!
+ * Check if the batch contains a UPP of the ID context of \p job.
+ */
+static bool batch_has_context(pipeline_job_t *const *batch, size_t count, const pipeline_job_t *job) {
+    for (size_t i = 0; i < count; ++i) {
+        if (memcmp(batch[i]->upp.uuid, job->upp.uuid, sizeof(job->upp.uuid)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+/*!
+ * Read the next UPPs of the offline queue into a batch, up to the first UPP
+ * of a context, which is in the batch already. The UPP at position i of the
+ * batch is at position i of the queue.
+ *
+ * @return number of UPPs in the batch
+ */
+static size_t batch_collect(pipeline_job_t **batch) {
+    size_t count = 0;
+    int64_t deadline = 0;
+    while (count < PIPELINE_BATCH_SIZE) {
+        if (ubirch_queue_count() <= count) {
+            int64_t remaining_us = deadline - esp_timer_get_time();
+            if (count > 0 && remaining_us <= 0) {
+                break;
+            }
+            // wait for the sign stage, check the network again from time to time
+            ulTaskNotifyTake(pdTRUE, (count == 0) ? pdMS_TO_TICKS(2000) : pdMS_TO_TICKS((remaining_us + 999) / 1000));
+            if (count == 0 && ubirch_queue_count() == 0) {
+                break;
+            }
+            continue;
+        }
+        // the first job waits for the verify stage, the others are taken if they are free
+        pipeline_job_t *job = NULL;
+        if (xQueueReceive(free_queue, &job, (count == 0) ? portMAX_DELAY : 0) != pdTRUE) {
+            break;
+        }
+        esp_err_t err = ubirch_anchor_queue_peek(count, &job->upp);
+        if (err != ESP_OK || batch_has_context(batch, count, job)) {
+            job_release(job);
+            if (err == ESP_ERR_INVALID_SIZE) {
+                // the invalid record was removed, the next one moved up
+                continue;
+            }
+            break;
+        }
+        // the time in the offline queue is not part of the latency
+        job->ingested = esp_timer_get_time();
+        job->handed_over = job->ingested;
+        if (count == 0) {
+            deadline = job->ingested + CONFIG_UBIRCH_PIPELINE_BATCH_WINDOW_MS * 1000LL;
+        }
+        batch[count++] = job;
+    }
+    return count;
+}
+#else
+// UPPs, which could not be delivered, and the UPP, which ended the last batch, in their order
+static pipeline_job_t *held[PIPELINE_BATCH_SIZE + 1];
+static size_t held_count = 0;
+
+/*!
+ * Take the next UPPs of the transmit stage into a batch, up to the first
+ * UPP of a context, which is in the batch already.
+ *
+ * @return number of UPPs in the batch
+ */
+static size_t batch_collect(pipeline_job_t **batch) {
+    size_t count = 0;
+    int64_t deadline = 0;
+    while (count < PIPELINE_BATCH_SIZE) {
+        if (held_count == 0) {
+            int64_t remaining_us = deadline - esp_timer_get_time();
+            TickType_t timeout = (count == 0) ? pdMS_TO_TICKS(2000)
+                    : (remaining_us > 0) ? pdMS_TO_TICKS((remaining_us + 999) / 1000) : 0;
+            if (xQueueReceive(transmit_queue, &held[0], timeout) != pdTRUE) {
+                break;
+            }
+            held_count = 1;
+        }
+        pipeline_job_t *job = held[0];
+        if (batch_has_context(batch, count, job)) {
+            // the UPP follows the one in the batch in its chain, it is sent with the next batch
+            break;
+        }
+        memmove(&held[0], &held[1], --held_count * sizeof(held[0]));
+        if (count == 0) {
+            deadline = esp_timer_get_time() + CONFIG_UBIRCH_PIPELINE_BATCH_WINDOW_MS * 1000LL;
+        }
+        batch[count++] = job;
+    }
+    return count;
+}
+
+/*!
+ * Keep the UPPs, which could not be delivered, for the next batch, in front
+ * of the UPPs, which follow them in their chains.
+ */
+static void batch_hold(pipeline_job_t *const *retried, size_t count) {
+    memmove(&held[count], &held[0], held_count * sizeof(held[0]));
+    memcpy(&held[0], retried, count * sizeof(held[0]));
+    held_count += count;
+}
+#endif
+
+#if PIPELINE_SENDERS > 0
+/*!
+ * Send task: send the UPPs of a batch, which the transmit stage hands over.
+ */
+static void send_task(void __unused *pvParameters) {
+    UBIRCH_METRICS_TASK_ADD();
+    for (;;) {
+        pipeline_job_t *job = NULL;
+        if (xQueueReceive(send_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        job->err = ubirch_anchor_transmit(&job->upp, &job->http_status, job->unpacker);
+        xSemaphoreGive(sent);
+    }
+}
+#endif
+
+/*!
+ * Send the UPPs of a batch at the same time, each over its own pooled
+ * connection, and wait for all of them.
+ */
+static void batch_send(pipeline_job_t *const *batch, size_t count) {
+#if PIPELINE_SENDERS > 0
+    for (size_t i = 1; i < count; ++i) {
+        xQueueSend(send_queue, &batch[i], portMAX_DELAY);
+    }
+#endif
+    batch[0]->err = ubirch_anchor_transmit(&batch[0]->upp, &batch[0]->http_status, batch[0]->unpacker);
+#if PIPELINE_SENDERS > 0
+    for (size_t i = 1; i < count; ++i) {
+        xSemaphoreTake(sent, portMAX_DELAY);
+    }
+#endif
+}
+
+/*!
+ * Transmit stage: send the signed UPPs to the backend, in batches of UPPs of
+ * different ID contexts.
+ */
+static void transmit_task(void __unused *pvParameters) {
+    UBIRCH_METRICS_TASK_ADD();
+    pipeline_job_t *batch[PIPELINE_BATCH_SIZE];
+    for (;;) {
+        // check if network connection is up
+        EventBits_t event_bits = xEventGroupWaitBits(network_event_group, WIFI_CONNECTED_BIT | NETWORK_ETH_READY,
+                                         false, false, portMAX_DELAY);
+        if ((event_bits & WIFI_CONNECTED_BIT) != WIFI_CONNECTED_BIT) {
+            ESP_LOGW(TAG, "network not ready");
+            vTaskDelay(pdMS_TO_TICKS(2000));
+            continue;
+        }
+
+        size_t count = batch_collect(batch);
+        if (count == 0) {
+            continue;
+        }
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+        uint32_t backlog = ubirch_queue_count();
+#else
+        uint32_t backlog = uxQueueMessagesWaiting(transmit_queue) + held_count + count;
+#endif
+#if CONFIG_UBIRCH_RATE_CONTROL
+        ubirch_rate_control_backlog_set(backlog);
+#endif
+        UBIRCH_METRICS_GAUGE(UBIRCH_METRICS_BACKLOG, backlog);
+        batch_send(batch, count);
+        stats.sent += count;
+        stats.batches++;
+
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+        // remove the delivered and refused UPPs from the back, so the positions of the others stay valid
+        for (size_t i = count; i-- > 0;) {
+            if (batch[i]->err != UBIRCH_ANCHOR_RETRY) {
+                ubirch_queue_pop(i);
+            }
+        }
+#else
+        pipeline_job_t *retried[PIPELINE_BATCH_SIZE];
+#endif
+        size_t retried_count = 0;
+        for (size_t i = 0; i < count; ++i) {
+            pipeline_job_t *job = batch[i];
+            if (job->err == UBIRCH_ANCHOR_RETRY) {
+                stats.retried++;
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+                // keep the UPP in the offline queue, the backend is not available
+                job_release(job);
+                retried_count++;
+#else
+                // keep the UPP in RAM, when the transmit queue is full, the sign stage waits
+                ubirch_anchor_unpacker_reset(job->unpacker);
+                retried[retried_count++] = job;
+#endif
+                continue;
+            }
+            if (job->err != ESP_OK) {
+                ESP_LOGW(TAG, "UPP refused, http status %d", job->http_status);
+                job_release(job);
+                stats.failed++;
+                continue;
+            }
+            job->handed_over = latency_add(&stats.stage[UBIRCH_PIPELINE_TRANSMIT], job->handed_over);
+            xQueueSend(verify_queue, &job, portMAX_DELAY);
+        }
+        if (retried_count > 0) {
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+            vTaskDelay(pdMS_TO_TICKS(2000));
+#else
+            batch_hold(retried, retried_count);
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_UBIRCH_ANCHOR_RETRY_DELAY_MS));
+#endif
+        }
+    }
+}
+
+/*!
+ * Verify the signatures of the responses of \p count jobs and parse the responses.
+ */
+static void responses_handle(pipeline_job_t **batch, size_t count) {
+#if CONFIG_UBIRCH_VERIFY_BATCH
+    if (verify_batch_ready) {
+        int http_status[VERIFY_BATCH_SIZE];
+        msgpack_unpacker *unpackers[VERIFY_BATCH_SIZE];
+        for (size_t i = 0; i < count; ++i) {
+            http_status[i] = batch[i]->http_status;
+            unpackers[i] = batch[i]->unpacker;
+        }
+        ubirch_anchor_responses_handle(http_status, unpackers, count);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        ubirch_anchor_response_handle(batch[i]->http_status, batch[i]->unpacker);
+    }
+}
+
+/*!
+ * Verify stage: verify the response signatures and parse the responses.
+ */
+static void verify_task(void __unused *pvParameters) {
+    UBIRCH_METRICS_TASK_ADD();
+    pipeline_job_t *batch[VERIFY_BATCH_SIZE];
+    for (;;) {
+        if (xQueueReceive(verify_queue, &batch[0], portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        // the responses, which arrived meanwhile, are verified together, without waiting for more
+        size_t count = 1;
+        while (count < VERIFY_BATCH_SIZE && xQueueReceive(verify_queue, &batch[count], 0) == pdTRUE) {
+            ++count;
+        }
+        responses_handle(batch, count);
+        for (size_t i = 0; i < count; ++i) {
+            pipeline_job_t *job = batch[i];
+            latency_add(&stats.stage[UBIRCH_PIPELINE_VERIFY], job->handed_over);
+            latency_add(&stats.end_to_end, job->ingested);
+            job_release(job);
+#if CONFIG_UBIRCH_HEAP_AUDIT
+            ubirch_heap_audit_message();
+#endif
+
+            if (stats.end_to_end.count % PIPELINE_STATS_INTERVAL == 0) {
+                stats_log();
+            }
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+esp_err_t ubirch_pipeline_start(void) {
+    memset(jobs, 0, sizeof(jobs));
+    memset(&stats, 0, sizeof(stats));
+
+    free_queue = UBIRCH_QUEUE_CREATE(free_queue, PIPELINE_DEPTH, sizeof(pipeline_job_t *));
+    transmit_queue = UBIRCH_QUEUE_CREATE(transmit_queue, PIPELINE_DEPTH, sizeof(pipeline_job_t *));
+    verify_queue = UBIRCH_QUEUE_CREATE(verify_queue, PIPELINE_DEPTH, sizeof(pipeline_job_t *));
+    if (free_queue == NULL || transmit_queue == NULL || verify_queue == NULL) {
+        ESP_LOGE(TAG, "failed to create queues");
+        return ESP_ERR_NO_MEM;
+    }
+#if PIPELINE_SENDERS > 0
+    send_queue = UBIRCH_QUEUE_CREATE(send_queue, PIPELINE_SENDERS, sizeof(pipeline_job_t *));
+    sent = UBIRCH_COUNTING_CREATE(sent, PIPELINE_SENDERS, 0);
+    if (send_queue == NULL || sent == NULL) {
+        ESP_LOGE(TAG, "failed to create queues");
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+#if CONFIG_UBIRCH_VERIFY_BATCH
+    verify_batch_ready = (ubirch_verify_batch_selftest() == ESP_OK);
+    if (!verify_batch_ready) {
+        ESP_LOGW(TAG, "verifying every response on its own");
+    }
+#endif
+    for (size_t i = 0; i < PIPELINE_DEPTH; ++i) {
+        pipeline_job_t *job = &jobs[i];
+        // every job keeps its unpacker, so the pipeline does not allocate per message
+        job->unpacker = msgpack_unpacker_new(128);
+        if (job->unpacker == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        xQueueSend(free_queue, &job, 0);
+    }
+
+    // the transmit stage has to exist, before the sign stage notifies it
+    if (UBIRCH_TASK_CREATE(transmit_task, &transmit_task, "transmit", PIPELINE_PRIORITY,
+                &transmit_task_handle, PIPELINE_CORE(CONFIG_UBIRCH_PIPELINE_TRANSMIT_CORE)) != ESP_OK
+            || UBIRCH_TASK_CREATE(verify_task, &verify_task, "verify", PIPELINE_PRIORITY,
+                NULL, PIPELINE_CORE(CONFIG_UBIRCH_PIPELINE_VERIFY_CORE)) != ESP_OK
+            || UBIRCH_TASK_CREATE(sign_task, &sign_task, "sign", PIPELINE_PRIORITY,
+                NULL, PIPELINE_CORE(CONFIG_UBIRCH_PIPELINE_SIGN_CORE)) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to create tasks");
+        return ESP_ERR_NO_MEM;
+    }
+#if PIPELINE_SENDERS > 0
+    for (size_t i = 0; i < PIPELINE_SENDERS; ++i) {
+        char name[UBIRCH_BUDGET_NAME_SIZE];
+        snprintf(name, sizeof(name), "send%u", (unsigned int)i);
+        if (UBIRCH_TASKS_CREATE(send_task, i, &send_task, name, PIPELINE_PRIORITY,
+                    NULL, PIPELINE_CORE(CONFIG_UBIRCH_PIPELINE_TRANSMIT_CORE)) != ESP_OK) {
+            ESP_LOGE(TAG, "failed to create tasks");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+#endif
+    ESP_LOGI(TAG, "started with depth %d, batches of %d UPPs", PIPELINE_DEPTH, PIPELINE_BATCH_SIZE);
+    return ESP_OK;
+}
+
+void ubirch_pipeline_stats_get(ubirch_pipeline_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_pipeline_stats_t));
+}
+
+#if CONFIG_UBIRCH_PIPELINE_PERCENTILES
+uint32_t ubirch_pipeline_percentile_us(const ubirch_pipeline_latency_t *latency, uint32_t permille) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < UBIRCH_PIPELINE_BUCKETS; ++i) {
+        count += latency->buckets[i];
+    }
+    if (count == 0) {
+        return 0;
+    }
+    // rank of the percentile, rounded up
+    uint64_t rank = ((uint64_t)count * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < UBIRCH_PIPELINE_BUCKETS; ++i) {
+        seen += latency->buckets[i];
+        if (seen >= rank && latency->buckets[i] > 0) {
+            uint32_t upper = bucket_upper_us(i);
+            return (i == UBIRCH_PIPELINE_BUCKETS - 1 || upper > latency->max_us) ? latency->max_us : upper;
+        }
+    }
+    return latency->max_us;
+}
+#endif
+
+const char *ubirch_pipeline_stage_name(ubirch_pipeline_stage_t stage) {
+    return (stage < UBIRCH_PIPELINE_STAGES) ? stage_names[stage] : "unknown";
+}
+
+#endif // CONFIG_UBIRCH_PIPELINE
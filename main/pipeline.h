@@ -0,0 +1,126 @@
+/*!
+ * @file pipeline.h
+ * @brief Anchoring pipeline, which spreads the work over both cores.
+ *
+ * The anchoring of sensor data is split into stages, which run in their
+ * own tasks and are connected by bounded queues:
+ *
+ * - ingest: a producer fills a slot of the sensor data pool
+ * - context resolve: make the ID context of the sensor the current context
+ * - encode and sign: create and sign the chained UPP
+ * - transmit: send the UPP to the backend
+ * - verify response: verify and parse the response
+ *
+ * Context resolve and signing run in the same task, as the key storage
+ * has only one current context. Signed UPPs carry their credentials, so
+ * the UPP of one sensor can be signed while the UPP of another sensor
+ * waits for the network. If a queue is full, the stage before it waits,
+ * until finally the sensors cannot get a free slot anymore.
+ *
+ * With the offline queue, the signed UPPs are stored in the queue and the
+ * transmit stage forwards them from there. With the time series, the sign
+ * stage collects the samples in windows and signs each window as a whole.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_PIPELINE_H
+#define EXAMPLE_ESP32_PIPELINE_H
+
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * Stages of the pipeline.
+ */
+typedef enum {
+    UBIRCH_PIPELINE_INGEST = 0,
+    UBIRCH_PIPELINE_RESOLVE,
+    UBIRCH_PIPELINE_SIGN,
+    UBIRCH_PIPELINE_TRANSMIT,
+    UBIRCH_PIPELINE_VERIFY,
+    UBIRCH_PIPELINE_STAGES
+} ubirch_pipeline_stage_t;
+
+#if CONFIG_UBIRCH_PIPELINE_PERCENTILES
+// four buckets per power of two up to 2^27 us, the last bucket takes the rest
+#define UBIRCH_PIPELINE_BUCKETS 104
+#endif
+
+/*!
+ * Latency of one stage, including the time the data waited in the
+ * queue in front of the stage.
+ */
+typedef struct {
+    uint32_t count;         //!< number of measurements
+    uint32_t last_us;       //!< latest latency
+    uint32_t max_us;        //!< maximum latency
+    uint64_t total_us;      //!< sum of all latencies, for the average
+#if CONFIG_UBIRCH_PIPELINE_PERCENTILES
+    uint32_t buckets[UBIRCH_PIPELINE_BUCKETS];  //!< histogram of the latencies
+#endif
+} ubirch_pipeline_latency_t;
+
+/*!
+ * Statistics of the pipeline.
+ */
+typedef struct {
+    ubirch_pipeline_latency_t stage[UBIRCH_PIPELINE_STAGES];
+    ubirch_pipeline_latency_t end_to_end;   //!< from ingest until the response is verified
+    uint32_t failed;                        //!< sensor data, which was not anchored
+    uint32_t retried;                       //!< UPPs sent again after a transient failure
+    uint32_t sent;                          //!< UPPs sent by the transmit stage, also the retried ones
+    uint32_t batches;                       //!< batches, in which they were sent
+} ubirch_pipeline_stats_t;
+
+/*!
+ * @brief Create the queues and start the tasks of all stages.
+ *
+ * The sensor data pool, the ID context cache, the connection pool and
+ * (if enabled) the offline queue have to be initialized before.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if a queue or task could not be created
+ */
+esp_err_t ubirch_pipeline_start(void);
+
+/*!
+ * @brief Get a copy of the pipeline statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_pipeline_stats_get(ubirch_pipeline_stats_t *stats);
+
+#if CONFIG_UBIRCH_PIPELINE_PERCENTILES
+/*!
+ * @brief Get a percentile of a latency from its histogram.
+ *
+ * The result is the upper bound of the bucket, which contains the
+ * percentile, so it is at most 25% above the exact value.
+ *
+ * @param[in] latency the latency, e.g. of a copy of the statistics
+ * @param[in] permille the percentile in 1/1000, e.g. 990 for the 99th percentile
+ * @return the percentile in us, or 0 without measurements
+ */
+uint32_t ubirch_pipeline_percentile_us(const ubirch_pipeline_latency_t *latency, uint32_t permille);
+#endif
+
+/*!
+ * @brief Get the name of a stage, for logging.
+ */
+const char *ubirch_pipeline_stage_name(ubirch_pipeline_stage_t stage);
+
+#endif /* EXAMPLE_ESP32_PIPELINE_H */
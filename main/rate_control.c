@@ -0,0 +1,245 @@
+/*!
+ * @file rate_control.c
+ * @brief Adaptive rate control of the UPPs sent to the backend.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+
+#include "budget.h"
+#include "rate_control.h"
+
+#if CONFIG_UBIRCH_RATE_CONTROL
+
+static const char *TAG = "rate_control";
+
+#define RATE_CONTROL_MAX_RATE ((uint32_t)CONFIG_UBIRCH_RATE_CONTROL_MAX_RATE * 1000)
+// one UPP in 10 s
+#define RATE_CONTROL_MIN_RATE 100
+// the sensor interval is stretched at most by this factor by the backlog
+#define RATE_CONTROL_MAX_STRETCH 8
+
+static SemaphoreHandle_t rate_lock = NULL;
+UBIRCH_SEMAPHORE_DEFINE(rate_lock);
+static ubirch_rate_control_stats_t stats = { 0 };
+static int64_t next_send_us = 0;        //!< time the next UPP can be sent
+static int64_t backoff_until_us = 0;    //!< time the sending continues after a failure
+static int64_t last_update_us = 0;      //!< time of the last result
+static int64_t last_decrease_us = 0;
+static uint32_t consecutive_failures = 0;
+
+/*!
+ * Change the state and log it, the log shows every change of the send rate,
+ * which is not a linear increase.
+ */
+static void state_set(ubirch_rate_control_state_t state) {
+    if (state != stats.state || state != UBIRCH_RATE_CONTROL_OPEN) {
+        ESP_LOGI(TAG, "%s, %u.%03u UPPs/s, rtt %u us (min %u us), %u pending", ubirch_rate_control_state_name(state),
+                (unsigned int)(stats.rate_milli / 1000), (unsigned int)(stats.rate_milli % 1000),
+                (unsigned int)stats.srtt_us, (unsigned int)stats.min_rtt_us, (unsigned int)stats.backlog);
+    }
+    stats.state = state;
+}
+
+/*!
+ * Halve the send rate, at most once per round-trip time, as the answers of
+ * the UPPs in flight were sent with the old rate.
+ */
+static void rate_decrease(int64_t now) {
+    if (now - last_decrease_us < (int64_t)stats.srtt_us) {
+        return;
+    }
+    last_decrease_us = now;
+    stats.rate_milli = (stats.rate_milli / 2 > RATE_CONTROL_MIN_RATE) ? stats.rate_milli / 2 : RATE_CONTROL_MIN_RATE;
+    stats.decreases++;
+    state_set(UBIRCH_RATE_CONTROL_THROTTLED);
+}
+
+/*!
+ * Stop sending for a delay, which doubles with every consecutive failure.
+ */
+static void backoff(int64_t now) {
+    uint32_t shift = (consecutive_failures < 16) ? consecutive_failures : 16;
+    int64_t delay_ms = (int64_t)CONFIG_UBIRCH_RATE_CONTROL_BACKOFF_MS << shift;
+    if (delay_ms > CONFIG_UBIRCH_RATE_CONTROL_BACKOFF_MAX_MS) {
+        delay_ms = CONFIG_UBIRCH_RATE_CONTROL_BACKOFF_MAX_MS;
+    }
+    consecutive_failures++;
+    backoff_until_us = now + delay_ms * 1000;
+    stats.backoffs++;
+    rate_decrease(now);
+    state_set(UBIRCH_RATE_CONTROL_BACKOFF);
+}
+
+esp_err_t ubirch_rate_control_init(void) {
+    memset(&stats, 0, sizeof(stats));
+    stats.rate_milli = RATE_CONTROL_MAX_RATE;
+    stats.interval_ms = CONFIG_UBIRCH_DEFAULT_INTERVAL;
+    next_send_us = 0;
+    backoff_until_us = 0;
+    last_update_us = esp_timer_get_time();
+    last_decrease_us = 0;
+    consecutive_failures = 0;
+
+    rate_lock = UBIRCH_MUTEX_CREATE(rate_lock);
+    return (rate_lock != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void ubirch_rate_control_interval_set(uint32_t interval_ms) {
+    if (rate_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(rate_lock, portMAX_DELAY);
+    bool changed = (interval_ms != stats.interval_ms);
+    stats.interval_ms = interval_ms;
+    xSemaphoreGive(rate_lock);
+    if (changed) {
+        ESP_LOGI(TAG, "backend interval %u ms", (unsigned int)interval_ms);
+    }
+}
+
+void ubirch_rate_control_backlog_set(uint32_t backlog) {
+    if (rate_lock == NULL) {
+        stats.backlog = backlog;
+        return;
+    }
+    xSemaphoreTake(rate_lock, portMAX_DELAY);
+    stats.backlog = backlog;
+    xSemaphoreGive(rate_lock);
+}
+
+uint32_t ubirch_rate_control_send_delay_ms(void) {
+    if (rate_lock == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(rate_lock, portMAX_DELAY);
+    int64_t due_us = (backoff_until_us > next_send_us) ? backoff_until_us : next_send_us;
+    xSemaphoreGive(rate_lock);
+    int64_t delay_us = due_us - esp_timer_get_time();
+    return (delay_us > 0) ? (uint32_t)((delay_us + 999) / 1000) : 0;
+}
+
+void ubirch_rate_control_result(int http_status, int64_t rtt_us) {
+    if (rate_lock == NULL) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(rate_lock, portMAX_DELAY);
+    // the send slot of this UPP started, when it was sent
+    int64_t sent_us = now - rtt_us;
+    next_send_us = ((next_send_us > sent_us) ? next_send_us : sent_us) + 1000000000LL / stats.rate_milli;
+
+    if (http_status == 0) {
+        stats.failures++;
+        backoff(now);
+    } else if (http_status >= 500) {
+        // not timed, a server error is answered without the work of an anchoring
+        stats.responses++;
+        stats.server_errors++;
+        backoff(now);
+    } else {
+        uint32_t rtt = (rtt_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)rtt_us;
+        stats.responses++;
+        stats.srtt_us = (stats.srtt_us == 0) ? rtt : stats.srtt_us - stats.srtt_us / 8 + rtt / 8;
+        // the minimum ages, so it follows a slower route to the backend
+        stats.min_rtt_us += stats.min_rtt_us / 256;
+        if (stats.min_rtt_us == 0 || rtt < stats.min_rtt_us) {
+            stats.min_rtt_us = rtt;
+        }
+
+        if (http_status == 409) {
+            stats.rejected++;
+            consecutive_failures = 0;
+            rate_decrease(now);
+        } else if ((uint64_t)stats.srtt_us * 100 > (uint64_t)stats.min_rtt_us * CONFIG_UBIRCH_RATE_CONTROL_RTT_LIMIT) {
+            // the UPPs queue up somewhere on the way to the backend
+            consecutive_failures = 0;
+            rate_decrease(now);
+        } else {
+            consecutive_failures = 0;
+            uint64_t increase = (uint64_t)CONFIG_UBIRCH_RATE_CONTROL_STEP * 1000 * (uint64_t)(now - last_update_us) / 1000000;
+            stats.rate_milli = (stats.rate_milli + increase < RATE_CONTROL_MAX_RATE)
+                    ? (uint32_t)(stats.rate_milli + increase) : RATE_CONTROL_MAX_RATE;
+            if (stats.state == UBIRCH_RATE_CONTROL_BACKOFF
+                    || (stats.state == UBIRCH_RATE_CONTROL_THROTTLED && stats.rate_milli == RATE_CONTROL_MAX_RATE)) {
+                state_set((stats.rate_milli == RATE_CONTROL_MAX_RATE)
+                        ? UBIRCH_RATE_CONTROL_OPEN : UBIRCH_RATE_CONTROL_THROTTLED);
+            }
+        }
+    }
+    last_update_us = now;
+    xSemaphoreGive(rate_lock);
+}
+
+uint32_t ubirch_rate_control_sensor_interval_ms(uint32_t sensors) {
+    if (rate_lock == NULL) {
+        return CONFIG_UBIRCH_DEFAULT_INTERVAL;
+    }
+    xSemaphoreTake(rate_lock, portMAX_DELAY);
+    uint32_t interval_ms = stats.interval_ms;
+#if !CONFIG_UBIRCH_SERIES && !CONFIG_UBIRCH_MERKLE
+    uint32_t rate_milli = stats.rate_milli;
+#endif
+    uint32_t backlog = stats.backlog;
+    xSemaphoreGive(rate_lock);
+#if !CONFIG_UBIRCH_SERIES && !CONFIG_UBIRCH_MERKLE
+    // every reading is a UPP, so all sensors together have to stay within the send rate
+    uint64_t round_ms = (rate_milli > 0) ? (uint64_t)sensors * 1000000 / rate_milli : 0;
+    if (round_ms > interval_ms) {
+        interval_ms = (round_ms < UINT32_MAX) ? (uint32_t)round_ms : UINT32_MAX;
+    }
+#endif
+    // the pending UPPs are sent first
+    if (backlog > CONFIG_UBIRCH_RATE_CONTROL_BACKLOG) {
+        uint64_t stretched = (uint64_t)interval_ms * backlog / CONFIG_UBIRCH_RATE_CONTROL_BACKLOG;
+        uint64_t limit = (uint64_t)interval_ms * RATE_CONTROL_MAX_STRETCH;
+        stretched = (stretched < limit) ? stretched : limit;
+        interval_ms = (stretched < UINT32_MAX) ? (uint32_t)stretched : UINT32_MAX;
+    }
+    return interval_ms;
+}
+
+const char *ubirch_rate_control_state_name(ubirch_rate_control_state_t state) {
+    switch (state) {
+        case UBIRCH_RATE_CONTROL_OPEN:
+            return "open";
+        case UBIRCH_RATE_CONTROL_THROTTLED:
+            return "throttled";
+        case UBIRCH_RATE_CONTROL_BACKOFF:
+            return "backoff";
+        default:
+            return "?";
+    }
+}
+
+void ubirch_rate_control_stats_get(ubirch_rate_control_stats_t *out) {
+    if (rate_lock == NULL) {
+        memcpy(out, &stats, sizeof(ubirch_rate_control_stats_t));
+        return;
+    }
+    xSemaphoreTake(rate_lock, portMAX_DELAY);
+    memcpy(out, &stats, sizeof(ubirch_rate_control_stats_t));
+    xSemaphoreGive(rate_lock);
+}
+
+#endif // CONFIG_UBIRCH_RATE_CONTROL
@@ -0,0 +1,122 @@
+/*!
+ * @file rate_control.h
+ * @brief Adaptive rate control of the UPPs sent to the backend.
+ *
+ * The UPPs are paced with a send rate, which grows linearly, while the
+ * backend answers in time, and is halved, if the backend rejects a UPP (409),
+ * fails (5xx) or its round-trip time grows over a multiple of the lowest
+ * one seen. Server errors and UPPs, which cannot be sent at all, also stop
+ * the sending for a delay, which doubles with every failed attempt.
+ *
+ * The sensors are paced by the interval of the backend. If every reading is
+ * anchored on its own, the interval is stretched, so all sensors together
+ * stay within the send rate, and it is stretched further, while UPPs are
+ * pending in the queues.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_RATE_CONTROL_H
+#define EXAMPLE_ESP32_RATE_CONTROL_H
+
+#include <stdint.h>
+#include <esp_err.h>
+
+/*!
+ * State of the rate control.
+ */
+typedef enum {
+    UBIRCH_RATE_CONTROL_OPEN = 0,       //!< UPPs are sent with the maximum rate
+    UBIRCH_RATE_CONTROL_THROTTLED,      //!< the send rate was reduced and grows again
+    UBIRCH_RATE_CONTROL_BACKOFF,        //!< sending is stopped after a failure
+} ubirch_rate_control_state_t;
+
+/*!
+ * Current values and statistics of the rate control.
+ */
+typedef struct {
+    ubirch_rate_control_state_t state;
+    uint32_t rate_milli;        //!< current send rate in UPPs per 1000 s
+    uint32_t interval_ms;       //!< interval of the backend
+    uint32_t srtt_us;           //!< smoothed round-trip time
+    uint32_t min_rtt_us;        //!< lowest round-trip time, which ages slowly
+    uint32_t backlog;           //!< UPPs waiting to be sent
+    uint32_t responses;         //!< answers of the backend
+    uint32_t rejected;          //!< answers with status 409
+    uint32_t server_errors;     //!< answers with status 5xx
+    uint32_t failures;          //!< UPPs, which could not be sent
+    uint32_t decreases;         //!< reductions of the send rate
+    uint32_t backoffs;          //!< times the sending was stopped
+} ubirch_rate_control_stats_t;
+
+/*!
+ * @brief Initialize the rate control with the maximum rate.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_rate_control_init(void);
+
+/*!
+ * @brief Set the interval, which the backend sent in its response.
+ *
+ * @param[in] interval_ms the interval of the sensor readings
+ */
+void ubirch_rate_control_interval_set(uint32_t interval_ms);
+
+/*!
+ * @brief Set the number of UPPs, which wait to be sent.
+ *
+ * @param[in] backlog UPPs in the offline queue or the transmit queue
+ */
+void ubirch_rate_control_backlog_set(uint32_t backlog);
+
+/*!
+ * @brief Get the time until the next UPP can be sent.
+ *
+ * @return 0 if a UPP can be sent now, otherwise the delay in ms
+ */
+uint32_t ubirch_rate_control_send_delay_ms(void);
+
+/*!
+ * @brief Take the result of a sent UPP into account.
+ *
+ * @param[in] http_status http status of the response, 0 if the UPP could not be sent
+ * @param[in] rtt_us time from sending the UPP to its response
+ */
+void ubirch_rate_control_result(int http_status, int64_t rtt_us);
+
+/*!
+ * @brief Get the interval, in which each of \p sensors sensors should send a reading.
+ *
+ * @param[in] sensors number of sensors
+ * @return the interval in ms
+ */
+uint32_t ubirch_rate_control_sensor_interval_ms(uint32_t sensors);
+
+/*!
+ * @brief Get the name of a state, for the log.
+ */
+const char *ubirch_rate_control_state_name(ubirch_rate_control_state_t state);
+
+/*!
+ * @brief Get a copy of the current values and statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_rate_control_stats_get(ubirch_rate_control_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_RATE_CONTROL_H */
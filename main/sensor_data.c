@@ -0,0 +1,112 @@
+/*!
+ * @file sensor_data.c
+ * @brief Pool of slots for the sensor data, which is anchored by the gateway.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+
+#include "boot.h"
+#include "budget.h"
+#include "metrics.h"
+#include "sensor_data.h"
+
+static const char *TAG = "sensor_data";
+
+#define SENSOR_SLOTS CONFIG_UBIRCH_SENSOR_SLOTS
+
+static sensor_data_t slots[SENSOR_SLOTS];
+// only pointers to the slots are passed through the queues
+static QueueHandle_t free_slots = NULL;
+static QueueHandle_t ready_slots = NULL;
+UBIRCH_QUEUE_DEFINE(free_slots, SENSOR_SLOTS, sizeof(sensor_data_t *));
+UBIRCH_QUEUE_DEFINE(ready_slots, SENSOR_SLOTS, sizeof(sensor_data_t *));
+static ubirch_sensor_pool_stats_t stats = { 0 };
+
+esp_err_t ubirch_sensor_pool_init(void) {
+    free_slots = UBIRCH_QUEUE_CREATE(free_slots, SENSOR_SLOTS, sizeof(sensor_data_t *));
+    ready_slots = UBIRCH_QUEUE_CREATE(ready_slots, SENSOR_SLOTS, sizeof(sensor_data_t *));
+    if (free_slots == NULL || ready_slots == NULL) {
+        ESP_LOGE(TAG, "failed to create slot queues");
+        return ESP_ERR_NO_MEM;
+    }
+    memset(slots, 0, sizeof(slots));
+    for (size_t i = 0; i < SENSOR_SLOTS; ++i) {
+        sensor_data_t *slot = &slots[i];
+        xQueueSend(free_slots, &slot, 0);
+    }
+    memset(&stats, 0, sizeof(stats));
+    stats.min_free = SENSOR_SLOTS;
+    return ESP_OK;
+}
+
+sensor_data_t *ubirch_sensor_slot_acquire(TickType_t timeout) {
+    sensor_data_t *slot = NULL;
+    // the statistics are shared by all producers
+    if (xQueueReceive(free_slots, &slot, timeout) != pdTRUE) {
+        __atomic_fetch_add(&stats.acquire_failed, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    uint32_t free = (uint32_t)uxQueueMessagesWaiting(free_slots);
+    uint32_t min_free = __atomic_load_n(&stats.min_free, __ATOMIC_RELAXED);
+    while (free < min_free
+            && !__atomic_compare_exchange_n(&stats.min_free, &min_free, free, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    UBIRCH_METRICS_GAUGE(UBIRCH_METRICS_SLOTS, SENSOR_SLOTS - free);
+    slot->id[0] = '\0';
+    slot->num = 0;
+    slot->acquired = esp_timer_get_time();
+    return slot;
+}
+
+void ubirch_sensor_slot_commit(sensor_data_t *slot) {
+    slot->id[UBIRCH_SENSOR_ID_SIZE - 1] = '\0';
+    if (slot->num > CONFIG_UBIRCH_SENSOR_MAX_VALUES) {
+        slot->num = CONFIG_UBIRCH_SENSOR_MAX_VALUES;
+    }
+    slot->committed = esp_timer_get_time();
+    __atomic_fetch_add(&stats.committed, 1, __ATOMIC_RELAXED);
+    UBIRCH_METRICS_COUNT(UBIRCH_METRICS_READINGS, 1);
+    UBIRCH_BOOT_MARK(UBIRCH_BOOT_FIRST_READING);
+    // there is a place for every slot, so this does not block
+    xQueueSend(ready_slots, &slot, portMAX_DELAY);
+}
+
+sensor_data_t *ubirch_sensor_slot_receive(TickType_t timeout) {
+    sensor_data_t *slot = NULL;
+    if (xQueueReceive(ready_slots, &slot, timeout) != pdTRUE) {
+        return NULL;
+    }
+    return slot;
+}
+
+void ubirch_sensor_slot_release(sensor_data_t *slot) {
+    if (slot == NULL) {
+        return;
+    }
+    xQueueSend(free_slots, &slot, portMAX_DELAY);
+}
+
+void ubirch_sensor_pool_stats_get(ubirch_sensor_pool_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_sensor_pool_stats_t));
+}
@@ -0,0 +1,114 @@
+/*!
+ * @file sensor_data.h
+ * @brief Data of the (simulated) sensors, which is anchored by the gateway.
+ *
+ * Sensor data is passed from the producers (sensor tasks) to the anchoring
+ * in slots of a preallocated pool, without copying it:
+ *
+ * - a producer acquires a free slot with ubirch_sensor_slot_acquire(),
+ *   fills it in place and hands it over with ubirch_sensor_slot_commit()
+ * - the consumer takes committed slots with ubirch_sensor_slot_receive()
+ *   and gives them back with ubirch_sensor_slot_release(), when the UPP
+ *   is signed and the data is not needed anymore
+ *
+ * If no slot is free, the producers have to wait or drop their data.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_SENSOR_DATA_H
+#define EXAMPLE_ESP32_SENSOR_DATA_H
+
+#include <stdint.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+// size of the sensor id with its terminator, a UUID string fits easily
+#define UBIRCH_SENSOR_ID_SIZE 48
+
+/*!
+ * Sensor data in a slot of the pool.
+ */
+typedef struct {
+    char id[UBIRCH_SENSOR_ID_SIZE];
+    uint16_t num;                                       //!< number of used values
+    int32_t values[CONFIG_UBIRCH_SENSOR_MAX_VALUES];
+    int64_t acquired;       //!< time the producer acquired the slot, set by the pool
+    int64_t committed;      //!< time the producer committed the slot, set by the pool
+} sensor_data_t;
+
+/*!
+ * Statistics of the slot pool.
+ */
+typedef struct {
+    uint32_t committed;         //!< slots handed over to the consumer
+    uint32_t acquire_failed;    //!< acquire attempts without a free slot
+    uint32_t min_free;          //!< lowest number of free slots seen
+} ubirch_sensor_pool_stats_t;
+
+/*!
+ * @brief Initialize the slot pool, all slots are free.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_sensor_pool_init(void);
+
+/*!
+ * @brief Get a free slot, to fill it with sensor data.
+ *
+ * The slot has to be given to ubirch_sensor_slot_commit(), or back to
+ * ubirch_sensor_slot_release(), if the data is discarded.
+ *
+ * @param[in] timeout maximum time to wait for a free slot
+ * @return the slot, or NULL if no slot got free within the timeout
+ */
+sensor_data_t *ubirch_sensor_slot_acquire(TickType_t timeout);
+
+/*!
+ * @brief Hand a filled slot over to the consumer.
+ *
+ * The producer must not access the slot anymore.
+ *
+ * @param[in] slot the slot from ubirch_sensor_slot_acquire()
+ */
+void ubirch_sensor_slot_commit(sensor_data_t *slot);
+
+/*!
+ * @brief Get the oldest committed slot.
+ *
+ * The slot stays valid until it is given back with ubirch_sensor_slot_release().
+ *
+ * @param[in] timeout maximum time to wait for sensor data
+ * @return the slot, or NULL if no data arrived within the timeout
+ */
+sensor_data_t *ubirch_sensor_slot_receive(TickType_t timeout);
+
+/*!
+ * @brief Give a slot back to the pool.
+ *
+ * @param[in] slot the slot, which is not used anymore
+ */
+void ubirch_sensor_slot_release(sensor_data_t *slot);
+
+/*!
+ * @brief Get a copy of the pool statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_sensor_pool_stats_get(ubirch_sensor_pool_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_SENSOR_DATA_H */
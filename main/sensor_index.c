@@ -0,0 +1,315 @@
+/*!
+ * @file sensor_index.c
+ * @brief Index of the sensor IDs and the short names of their contexts.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+
+#include "budget.h"
+#include "sensor_data.h"
+#include "sensor_index.h"
+
+#if CONFIG_UBIRCH_SENSOR_INDEX
+
+static const char *TAG = "sensor_index";
+
+#define SENSOR_INDEX_FREE 0xFFFFFFFF
+#define SENSOR_INDEX_RECORD_PREFIX 0x5301   //!< sensor, whose context is named by the prefix of its id
+#define SENSOR_INDEX_RECORD_SLOT 0x5302     //!< sensor, whose context is named by its slot
+#define SENSOR_INDEX_RECORD_CLAIM 0x5303    //!< prefix of a longer id, which names the context of that sensor
+// length of the short names, which were derived from the sensor id before the index existed
+#define SENSOR_INDEX_PREFIX_LENGTH 14
+// the filter has a false positive rate of about 2 % with 8 bits per slot and 5 hashes, if the index is full
+#define SENSOR_INDEX_FILTER_BITS_PER_SLOT 8
+#define SENSOR_INDEX_FILTER_HASHES 5
+
+/*!
+ * Record of the index, the records of a slot are never written twice.
+ */
+typedef struct {
+    uint32_t hash;      //!< hash of the id, SENSOR_INDEX_FREE if the slot is free
+    uint16_t type;
+    char id[UBIRCH_SENSOR_ID_SIZE];
+    uint8_t reserved[6];
+    uint32_t crc;       //!< CRC32 of type and id
+} sensor_index_record_t;
+
+_Static_assert(SPI_FLASH_SEC_SIZE % sizeof(sensor_index_record_t) == 0, "sensor index record size");
+
+static const esp_partition_t *partition = NULL;
+static uint32_t slot_count = 0;
+static uint32_t used_count = 0;     //!< written slots, including the claims and the corrupted ones
+static uint8_t *filter = NULL;
+static uint32_t filter_bits = 0;
+static SemaphoreHandle_t index_lock = NULL;
+UBIRCH_SEMAPHORE_DEFINE(index_lock);
+static ubirch_sensor_index_stats_t stats = { 0 };
+
+/*!
+ * FNV-1a hash of the id, which never marks a free slot.
+ */
+static uint32_t id_hash(const char *id) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < UBIRCH_SENSOR_ID_SIZE - 1 && id[i] != '\0'; ++i) {
+        hash = (hash ^ (uint8_t)id[i]) * 16777619u;
+    }
+    return (hash == SENSOR_INDEX_FREE) ? SENSOR_INDEX_FREE - 1 : hash;
+}
+
+static uint32_t record_crc(const sensor_index_record_t *record) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&record->type, sizeof(record->type));
+    return esp_rom_crc32_le(crc, (const uint8_t *)record->id, UBIRCH_SENSOR_ID_SIZE);
+}
+
+/*!
+ * Bit positions of \p hash in the filter, by double hashing.
+ */
+static uint32_t filter_position(uint32_t hash, uint32_t i) {
+    // the second hash is the finalizer of MurmurHash3
+    uint32_t step = hash;
+    step ^= step >> 16;
+    step *= 0x85ebca6bu;
+    step ^= step >> 13;
+    step *= 0xc2b2ae35u;
+    step ^= step >> 16;
+    return (hash + i * (step | 1u)) % filter_bits;
+}
+
+static void filter_add(uint32_t hash) {
+    for (uint32_t i = 0; i < SENSOR_INDEX_FILTER_HASHES; ++i) {
+        uint32_t bit = filter_position(hash, i);
+        filter[bit / 8] |= (uint8_t)(1u << (bit % 8));
+    }
+}
+
+static bool filter_contains(uint32_t hash) {
+    for (uint32_t i = 0; i < SENSOR_INDEX_FILTER_HASHES; ++i) {
+        uint32_t bit = filter_position(hash, i);
+        if ((filter[bit / 8] & (1u << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static esp_err_t record_read(uint32_t slot, sensor_index_record_t *record) {
+    stats.probes++;
+    return esp_partition_read(partition, slot * sizeof(sensor_index_record_t), record, sizeof(sensor_index_record_t));
+}
+
+static bool record_is_sensor(const sensor_index_record_t *record) {
+    return record->type == SENSOR_INDEX_RECORD_PREFIX || record->type == SENSOR_INDEX_RECORD_SLOT;
+}
+
+/*!
+ * Find the record of \p id, either of the sensor, or of the claim of the
+ * prefix \p id, which can also be the record of a sensor with this id.
+ *
+ * @param[out] slot slot of the record, or the first free slot, where it
+ *                  belongs, UINT32_MAX if there is none
+ * @param[out] type type of the record
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, or ESP_FAIL on flash errors
+ */
+static esp_err_t record_find(const char *id, uint32_t hash, bool claim, uint32_t *slot, uint16_t *type) {
+    sensor_index_record_t record;
+    uint32_t probe = hash % slot_count;
+    for (uint32_t i = 0; i < slot_count; ++i, probe = (probe + 1) % slot_count) {
+        if (record_read(probe, &record) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (record.hash == SENSOR_INDEX_FREE) {
+            *slot = probe;
+            return ESP_ERR_NOT_FOUND;
+        }
+        bool match = claim ? (record.type == SENSOR_INDEX_RECORD_CLAIM || record.type == SENSOR_INDEX_RECORD_PREFIX)
+                : record_is_sensor(&record);
+        if (match && record.hash == hash && strncmp(record.id, id, UBIRCH_SENSOR_ID_SIZE) == 0
+                && record_crc(&record) == record.crc) {
+            *slot = probe;
+            *type = record.type;
+            return ESP_OK;
+        }
+    }
+    *slot = UINT32_MAX;
+    return ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t record_write(uint32_t slot, uint16_t type, const char *id, uint32_t hash) {
+    sensor_index_record_t record;
+    memset(&record, 0xFF, sizeof(record));
+    record.hash = hash;
+    record.type = type;
+    memset(record.id, 0, UBIRCH_SENSOR_ID_SIZE);
+    strncpy(record.id, id, UBIRCH_SENSOR_ID_SIZE - 1);
+    record.crc = record_crc(&record);
+    // a failed write leaves the slot unusable, it is counted anyway
+    used_count++;
+    if (esp_partition_write(partition, slot * sizeof(sensor_index_record_t), &record, sizeof(record)) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to write slot %u", slot);
+        return ESP_FAIL;
+    }
+    if (type != SENSOR_INDEX_RECORD_CLAIM) {
+        filter_add(hash);
+        stats.sensors++;
+    }
+    return ESP_OK;
+}
+
+static void short_name_get(const char *id, uint32_t slot, uint16_t type,
+        char short_name[UBIRCH_SENSOR_INDEX_SHORT_NAME_SIZE]) {
+    if (type == SENSOR_INDEX_RECORD_PREFIX) {
+        snprintf(short_name, SENSOR_INDEX_PREFIX_LENGTH + 1, "%s", id);
+    } else {
+        snprintf(short_name, UBIRCH_SENSOR_INDEX_SHORT_NAME_SIZE, "#%05u", (unsigned int)slot);
+    }
+}
+
+/*!
+ * Find the sensor \p id, the index has to be locked.
+ */
+static esp_err_t sensor_find(const char *id, uint32_t hash, uint32_t *slot, uint16_t *type) {
+    stats.lookups++;
+    if (!filter_contains(hash)) {
+        stats.filtered++;
+        *slot = UINT32_MAX;
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = record_find(id, hash, false, slot, type);
+    if (err == ESP_ERR_NOT_FOUND) {
+        stats.false_positives++;
+    }
+    return err;
+}
+
+esp_err_t ubirch_sensor_index_init(void) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+            CONFIG_UBIRCH_SENSOR_INDEX_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "partition \"%s\" not found", CONFIG_UBIRCH_SENSOR_INDEX_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    slot_count = partition->size / sizeof(sensor_index_record_t);
+    filter_bits = slot_count * SENSOR_INDEX_FILTER_BITS_PER_SLOT;
+    filter = calloc(filter_bits / 8, 1);
+    index_lock = UBIRCH_MUTEX_CREATE(index_lock);
+    if (filter == NULL || index_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    sensor_index_record_t record;
+    for (uint32_t slot = 0; slot < slot_count; ++slot) {
+        if (record_read(slot, &record) != ESP_OK || record.hash == SENSOR_INDEX_FREE) {
+            continue;
+        }
+        used_count++;
+        if (record_is_sensor(&record) && record_crc(&record) == record.crc) {
+            filter_add(record.hash);
+            stats.sensors++;
+        }
+    }
+    stats.slots = slot_count;
+    stats.probes = 0;
+    ESP_LOGI(TAG, "%u sensors in %u slots", (unsigned int)stats.sensors, (unsigned int)slot_count);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_sensor_index_lookup(const char *id, char short_name[UBIRCH_SENSOR_INDEX_SHORT_NAME_SIZE]) {
+    if (index_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t started = esp_timer_get_time();
+    uint32_t hash = id_hash(id);
+    uint32_t slot;
+    uint16_t type;
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    esp_err_t err = sensor_find(id, hash, &slot, &type);
+    if (err == ESP_OK) {
+        short_name_get(id, slot, type, short_name);
+    }
+    stats.lookup_us += (uint64_t)(esp_timer_get_time() - started);
+    xSemaphoreGive(index_lock);
+    return err;
+}
+
+esp_err_t ubirch_sensor_index_add(const char *id, char short_name[UBIRCH_SENSOR_INDEX_SHORT_NAME_SIZE]) {
+    if (index_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t started = esp_timer_get_time();
+    uint32_t hash = id_hash(id);
+    uint32_t slot;
+    uint16_t type;
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    esp_err_t err = sensor_find(id, hash, &slot, &type);
+    if (err == ESP_ERR_NOT_FOUND) {
+        // the probe sequences degrade, if the table is almost full
+        if (used_count + 2 > slot_count - slot_count / 8) {
+            xSemaphoreGive(index_lock);
+            ESP_LOGE(TAG, "index full, \"%s\" not added", id);
+            return ESP_ERR_NO_MEM;
+        }
+        // the first sensor with a prefix keeps the context, which was named by the prefix before
+        char prefix[SENSOR_INDEX_PREFIX_LENGTH + 1];
+        snprintf(prefix, sizeof(prefix), "%s", id);
+        uint32_t prefix_hash = id_hash(prefix);
+        uint32_t prefix_slot;
+        uint16_t prefix_type;
+        err = record_find(prefix, prefix_hash, true, &prefix_slot, &prefix_type);
+        type = SENSOR_INDEX_RECORD_SLOT;
+        if (err == ESP_ERR_NOT_FOUND) {
+            type = SENSOR_INDEX_RECORD_PREFIX;
+            // the claim is written first, so an interrupted addition never names two contexts alike
+            err = (strcmp(prefix, id) == 0) ? ESP_OK
+                    : record_write(prefix_slot, SENSOR_INDEX_RECORD_CLAIM, prefix, prefix_hash);
+        }
+        if (err == ESP_OK) {
+            // the claim can take the slot, which was free for the id
+            uint16_t found_type;
+            err = record_find(id, hash, false, &slot, &found_type);
+            err = (err == ESP_ERR_NOT_FOUND && slot != UINT32_MAX) ? record_write(slot, type, id, hash) : ESP_FAIL;
+        }
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "\"%s\" added to slot %u", id, (unsigned int)slot);
+        }
+    }
+    if (err == ESP_OK) {
+        short_name_get(id, slot, type, short_name);
+    }
+    stats.lookup_us += (uint64_t)(esp_timer_get_time() - started);
+    xSemaphoreGive(index_lock);
+    return err;
+}
+
+void ubirch_sensor_index_stats_get(ubirch_sensor_index_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_sensor_index_stats_t));
+}
+
+#endif // CONFIG_UBIRCH_SENSOR_INDEX
@@ -0,0 +1,92 @@
+/*!
+ * @file sensor_index.h
+ * @brief Index of the sensor IDs and the short names of their contexts.
+ *
+ * The key storage names the ID contexts by short names of at most 14
+ * characters, so the sensor ID cannot be used as name, if it is longer.
+ * The index maps the complete sensor ID to the short name of its context.
+ * It is a hash table with open addressing in a flash partition, whose
+ * records are written once and never moved, so a lookup reads about one
+ * record, independent of the number of sensors.
+ *
+ * The first sensor, which starts with a 14 character prefix, gets the
+ * prefix as short name, as before the index existed. Every other sensor
+ * with this prefix gets a name of its own, which is derived from its slot
+ * in the table. A bloom filter of all IDs in RAM answers most lookups of
+ * unknown sensors without a flash read.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_SENSOR_INDEX_H
+#define EXAMPLE_ESP32_SENSOR_INDEX_H
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#define UBIRCH_SENSOR_INDEX_SHORT_NAME_SIZE 16
+
+/*!
+ * Statistics of the sensor index.
+ */
+typedef struct {
+    uint32_t slots;             //!< records, which fit into the partition
+    uint32_t sensors;           //!< sensors in the index
+    uint32_t lookups;           //!< lookups and additions
+    uint32_t filtered;          //!< lookups of unknown sensors, which the filter answered
+    uint32_t false_positives;   //!< lookups of unknown sensors, which passed the filter
+    uint32_t probes;            //!< records read by the lookups
+    uint64_t lookup_us;         //!< total time of the lookups
+} ubirch_sensor_index_stats_t;
+
+/*!
+ * @brief Open the index partition and fill the filter with the indexed sensors.
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if there is no index partition,
+ *         or ESP_ERR_NO_MEM
+ */
+esp_err_t ubirch_sensor_index_init(void);
+
+/*!
+ * @brief Get the short name of the context of the sensor \p id.
+ *
+ * @param[in] id the sensor id
+ * @param[out] short_name the short name of the context
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the sensor is not in the index,
+ *         or ESP_ERR_INVALID_STATE if the index is not available
+ */
+esp_err_t ubirch_sensor_index_lookup(const char *id, char short_name[UBIRCH_SENSOR_INDEX_SHORT_NAME_SIZE]);
+
+/*!
+ * @brief Get the short name of the context of the sensor \p id, and add the
+ * sensor to the index, if it is not in there yet.
+ *
+ * @param[in] id the sensor id
+ * @param[out] short_name the short name of the context
+ * @return ESP_OK, ESP_ERR_NO_MEM if the index is full, ESP_FAIL on flash
+ *         errors, or ESP_ERR_INVALID_STATE if the index is not available
+ */
+esp_err_t ubirch_sensor_index_add(const char *id, char short_name[UBIRCH_SENSOR_INDEX_SHORT_NAME_SIZE]);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_sensor_index_stats_get(ubirch_sensor_index_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_SENSOR_INDEX_H */
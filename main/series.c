@@ -0,0 +1,248 @@
+/*!
+ * @file series.c
+ * @brief Time series of sensor samples, which are anchored together in one UPP.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <string.h>
+#include <sys/time.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <msgpack.h>
+
+#include "series.h"
+
+#if CONFIG_UBIRCH_SERIES
+
+static const char *TAG = "series";
+
+// worst case of one sample: array header, dt and a 64-bit delta for every channel
+#define SERIES_SAMPLE_MAX_SIZE (3 + 5 + 9 * CONFIG_UBIRCH_SENSOR_MAX_VALUES)
+// worst case of the window header: array header, format, start and samples array header
+#define SERIES_HEADER_MAX_SIZE (1 + 1 + 9 + 3)
+
+#if CONFIG_UBIRCH_SERIES_MAX_BYTES < SERIES_SAMPLE_MAX_SIZE
+#error "UBIRCH_SERIES_MAX_BYTES is too small for UBIRCH_SENSOR_MAX_VALUES"
+#endif
+
+typedef enum {
+    SERIES_OPEN = 0,
+    SERIES_FULL,
+    SERIES_BUDGET,
+    SERIES_EVICTED,
+} series_state_t;
+
+/*!
+ * Window of one sensor.
+ */
+typedef struct {
+    char id[UBIRCH_SENSOR_ID_SIZE];     //!< empty, if the window is not used
+    series_state_t state;
+    uint16_t samples;
+    uint16_t num;                       //!< number of channels of the previous sample
+    int32_t previous[CONFIG_UBIRCH_SENSOR_MAX_VALUES];
+    int64_t started;                    //!< esp_timer time of the first sample
+    int64_t last;                       //!< esp_timer time of the previous sample
+    uint64_t start_ms;                  //!< wall clock time of the first sample
+    size_t size;
+    char data[CONFIG_UBIRCH_SERIES_MAX_BYTES];
+} series_window_t;
+
+/*!
+ * Bounded buffer, which is written by a msgpack packer.
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t used;
+} series_buffer_t;
+
+static series_window_t windows[CONFIG_UBIRCH_SERIES_SENSORS];
+static char payload[SERIES_HEADER_MAX_SIZE + CONFIG_UBIRCH_SERIES_MAX_BYTES];
+static ubirch_series_stats_t stats = { 0 };
+
+static int series_buffer_write(void *data, const char *buf, size_t len) {
+    series_buffer_t *buffer = (series_buffer_t *)data;
+    if (buffer->used + len > buffer->size) {
+        return -1;
+    }
+    memcpy(buffer->data + buffer->used, buf, len);
+    buffer->used += len;
+    return 0;
+}
+
+static series_window_t *find(const char *id) {
+    for (size_t i = 0; i < CONFIG_UBIRCH_SERIES_SENSORS; ++i) {
+        if (windows[i].id[0] != '\0' && strncmp(windows[i].id, id, UBIRCH_SENSOR_ID_SIZE) == 0) {
+            return &windows[i];
+        }
+    }
+    return NULL;
+}
+
+static series_window_t *open_window(const char *id) {
+    series_window_t *oldest = NULL;
+    for (size_t i = 0; i < CONFIG_UBIRCH_SERIES_SENSORS; ++i) {
+        series_window_t *window = &windows[i];
+        if (window->id[0] == '\0') {
+            memset(window, 0, sizeof(series_window_t));
+            strncpy(window->id, id, UBIRCH_SENSOR_ID_SIZE - 1);
+            return window;
+        }
+        if (oldest == NULL || window->started < oldest->started) {
+            oldest = window;
+        }
+    }
+    if (oldest->state == SERIES_OPEN) {
+        oldest->state = SERIES_EVICTED;
+    }
+    return NULL;
+}
+
+static bool expired(const series_window_t *window, int64_t now) {
+    return (now - window->started) >= (int64_t)CONFIG_UBIRCH_SERIES_MAX_AGE_MS * 1000;
+}
+
+void ubirch_series_init(void) {
+    memset(windows, 0, sizeof(windows));
+    memset(&stats, 0, sizeof(stats));
+}
+
+esp_err_t ubirch_series_add(const sensor_data_t *sample) {
+    series_window_t *window = find(sample->id);
+    if (window == NULL) {
+        window = open_window(sample->id);
+        if (window == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (window->samples == 0) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        window->start_ms = (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_usec / 1000;
+        window->started = sample->committed;
+        window->last = sample->committed;
+    }
+
+    series_buffer_t buffer = { .data = window->data, .size = sizeof(window->data), .used = window->size };
+    msgpack_packer pk;
+    msgpack_packer_init(&pk, &buffer, series_buffer_write);
+    msgpack_pack_array(&pk, 1 + sample->num);
+    msgpack_pack_uint32(&pk, (uint32_t)((sample->committed - window->last) / 1000));
+    for (uint16_t i = 0; i < sample->num; ++i) {
+        int64_t previous = (i < window->num) ? window->previous[i] : 0;
+        msgpack_pack_int64(&pk, (int64_t)sample->values[i] - previous);
+        window->previous[i] = sample->values[i];
+    }
+    window->num = sample->num;
+    window->size = buffer.used;
+    window->last = sample->committed;
+    window->samples++;
+    stats.samples++;
+
+    if (window->samples >= CONFIG_UBIRCH_SERIES_MAX_SAMPLES) {
+        window->state = SERIES_FULL;
+    } else if (window->size + SERIES_SAMPLE_MAX_SIZE > sizeof(window->data)) {
+        // the next sample might not fit anymore
+        window->state = SERIES_BUDGET;
+    }
+    return ESP_OK;
+}
+
+size_t ubirch_series_flush(ubirch_series_sink_t sink, bool all) {
+    size_t flushed = 0;
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < CONFIG_UBIRCH_SERIES_SENSORS; ++i) {
+        series_window_t *window = &windows[i];
+        if (window->id[0] == '\0') {
+            continue;
+        }
+        if (window->samples == 0) {
+            // evicted before it got its first sample
+            window->id[0] = '\0';
+            continue;
+        }
+        bool aged = expired(window, now);
+        if (window->state == SERIES_OPEN && !aged && !all) {
+            continue;
+        }
+        switch (window->state) {
+            case SERIES_FULL:
+                stats.full++;
+                break;
+            case SERIES_BUDGET:
+                stats.budget++;
+                break;
+            case SERIES_EVICTED:
+                stats.evicted++;
+                break;
+            default:
+                if (aged) {
+                    stats.aged++;
+                }
+                break;
+        }
+
+        series_buffer_t buffer = { .data = payload, .size = sizeof(payload), .used = 0 };
+        msgpack_packer pk;
+        msgpack_packer_init(&pk, &buffer, series_buffer_write);
+        msgpack_pack_array(&pk, 3);
+        msgpack_pack_uint8(&pk, UBIRCH_SERIES_FORMAT);
+        msgpack_pack_uint64(&pk, window->start_ms);
+        msgpack_pack_array(&pk, window->samples);
+        memcpy(payload + buffer.used, window->data, window->size);
+        buffer.used += window->size;
+
+        ESP_LOGD(TAG, "%u samples of %s in %u bytes", window->samples, window->id, (unsigned int)buffer.used);
+        if (sink(window->id, payload, buffer.used, window->started) != ESP_OK) {
+            ESP_LOGE(TAG, "failed to anchor %u samples of %s", window->samples, window->id);
+        }
+        stats.windows++;
+        stats.payload_bytes += buffer.used;
+        // the next window starts with absolute values again
+        window->id[0] = '\0';
+        flushed++;
+    }
+    return flushed;
+}
+
+int32_t ubirch_series_timeout_ms(void) {
+    int64_t now = esp_timer_get_time();
+    int32_t timeout = -1;
+    for (size_t i = 0; i < CONFIG_UBIRCH_SERIES_SENSORS; ++i) {
+        const series_window_t *window = &windows[i];
+        if (window->id[0] == '\0') {
+            continue;
+        }
+        if (window->state != SERIES_OPEN || window->samples == 0 || expired(window, now)) {
+            return 0;
+        }
+        int32_t remaining = (int32_t)(CONFIG_UBIRCH_SERIES_MAX_AGE_MS - (now - window->started) / 1000);
+        if (timeout < 0 || remaining < timeout) {
+            timeout = remaining;
+        }
+    }
+    return timeout;
+}
+
+void ubirch_series_stats_get(ubirch_series_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_series_stats_t));
+}
+
+#endif // CONFIG_UBIRCH_SERIES
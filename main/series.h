@@ -0,0 +1,115 @@
+/*!
+ * @file series.h
+ * @brief Time series of sensor samples, which are anchored together in one UPP.
+ *
+ * The samples of every sensor are collected in a window, which is anchored
+ * when it holds enough samples, when its byte budget is used up, or when
+ * its first sample gets too old. This needs one signature and one request
+ * per window instead of one per sample.
+ *
+ * The payload of a window is packed with msgpack:
+ *
+ *     [format, start, [[dt, d1, d2, ...], [dt, d1, d2, ...], ...]]
+ *
+ * - format: UBIRCH_SERIES_FORMAT
+ * - start: time of the first sample, in ms since the epoch
+ * - dt: time since the previous sample in ms (0 for the first sample)
+ * - dN: value of channel N, minus the value of channel N in the previous
+ *   sample (the value itself for the first sample)
+ *
+ * As msgpack packs small integers into one byte, slowly changing values
+ * need only little space.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_SERIES_H
+#define EXAMPLE_ESP32_SERIES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#include "sensor_data.h"
+
+#define UBIRCH_SERIES_FORMAT 1
+
+/*!
+ * Function, which anchors the payload of a window.
+ *
+ * @param id the sensor id of the window
+ * @param payload the packed window
+ * @param len the length of the payload
+ * @param started time of the first sample (esp_timer_get_time())
+ */
+typedef esp_err_t (*ubirch_series_sink_t)(const char *id, const char *payload, size_t len, int64_t started);
+
+/*!
+ * Statistics of the time series.
+ */
+typedef struct {
+    uint32_t samples;           //!< samples added to a window
+    uint32_t windows;           //!< windows handed to the sink
+    uint32_t full;              //!< windows flushed due to the sample count
+    uint32_t budget;            //!< windows flushed due to the byte budget
+    uint32_t aged;              //!< windows flushed due to their age
+    uint32_t evicted;           //!< windows flushed to make room for another sensor
+    uint64_t payload_bytes;     //!< size of all flushed payloads
+} ubirch_series_stats_t;
+
+/*!
+ * @brief Clear all windows.
+ */
+void ubirch_series_init(void);
+
+/*!
+ * @brief Add a sample to the window of its sensor.
+ *
+ * If all windows are in use by other sensors, the oldest window is marked
+ * for flushing and ESP_ERR_NO_MEM is returned. The sample has to be added
+ * again after ubirch_series_flush().
+ *
+ * @param[in] sample the sensor data
+ * @return ESP_OK, or ESP_ERR_NO_MEM if no window is available
+ */
+esp_err_t ubirch_series_add(const sensor_data_t *sample);
+
+/*!
+ * @brief Hand the windows, which are complete, to \p sink and clear them.
+ *
+ * @param[in] sink function, which anchors the payload
+ * @param[in] all flush all windows, also the incomplete ones
+ * @return number of flushed windows
+ */
+size_t ubirch_series_flush(ubirch_series_sink_t sink, bool all);
+
+/*!
+ * @brief Get the time until the oldest window has to be flushed.
+ *
+ * @return -1 if there is no window, remaining time in ms otherwise
+ */
+int32_t ubirch_series_timeout_ms(void);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_series_stats_get(ubirch_series_stats_t *stats);
+
+#endif /* EXAMPLE_ESP32_SERIES_H */
@@ -0,0 +1,361 @@
+/*!
+ * @file signer.c
+ * @brief ed25519 signatures of the UPPs with per-context expanded keys.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+
+#include "curve25519.h"
+#include "signer.h"
+
+#if CONFIG_UBIRCH_FAST_SIGN
+
+static const char *TAG = "signer";
+
+#define SIGNER_TABLE_ROWS 4                 //!< [2^(64 i)]B for i = 0 to 3
+#define SIGNER_TABLE_MULTIPLES 8            //!< [j 2^(64 i)]B for j = 1 to 8
+#define SIGNER_TABLE_COLUMNS 16             //!< radix 16 digits per row
+#define SIGNER_STACK_DATA_SIZE crypto_hash_sha512_BYTES    //!< the signed data of a UPP is hashed on the stack
+
+// [j 2^(64 i)]B in table[i][j - 1], 3.8 kB
+static ge_precomp table[SIGNER_TABLE_ROWS][SIGNER_TABLE_MULTIPLES];
+static bool ready = false;
+static ubirch_signer_key_t current;     //!< the key of the current context
+static ubirch_signer_stats_t stats = { 0 };
+
+
+/*!
+ * Known answer test vector.
+ */
+typedef struct {
+    unsigned char secret_key[crypto_sign_SECRETKEYBYTES];   //!< seed and public key
+    size_t len;
+    unsigned char message[100];
+    unsigned char signature[crypto_sign_BYTES];
+} sign_vector_t;
+
+// RFC 8032, section 7.1, TEST 2 and TEST 3, and a 100 byte message with the key of TEST 1
+static const sign_vector_t vectors[] = {
+        {
+                .secret_key = {
+                        0x4c, 0xcd, 0x08, 0x9b, 0x28, 0xff, 0x96, 0xda, 0x9d, 0xb6, 0xc3, 0x46, 0xec, 0x11, 0x4e, 0x0f,
+                        0x5b, 0x8a, 0x31, 0x9f, 0x35, 0xab, 0xa6, 0x24, 0xda, 0x8c, 0xf6, 0xed, 0x4f, 0xb8, 0xa6, 0xfb,
+                        0x3d, 0x40, 0x17, 0xc3, 0xe8, 0x43, 0x89, 0x5a, 0x92, 0xb7, 0x0a, 0xa7, 0x4d, 0x1b, 0x7e, 0xbc,
+                        0x9c, 0x98, 0x2c, 0xcf, 0x2e, 0xc4, 0x96, 0x8c, 0xc0, 0xcd, 0x55, 0xf1, 0x2a, 0xf4, 0x66, 0x0c,
+                },
+                .len = 1,
+                .message = { 0x72 },
+                .signature = {
+                        0x92, 0xa0, 0x09, 0xa9, 0xf0, 0xd4, 0xca, 0xb8, 0x72, 0x0e, 0x82, 0x0b, 0x5f, 0x64, 0x25, 0x40,
+                        0xa2, 0xb2, 0x7b, 0x54, 0x16, 0x50, 0x3f, 0x8f, 0xb3, 0x76, 0x22, 0x23, 0xeb, 0xdb, 0x69, 0xda,
+                        0x08, 0x5a, 0xc1, 0xe4, 0x3e, 0x15, 0x99, 0x6e, 0x45, 0x8f, 0x36, 0x13, 0xd0, 0xf1, 0x1d, 0x8c,
+                        0x38, 0x7b, 0x2e, 0xae, 0xb4, 0x30, 0x2a, 0xee, 0xb0, 0x0d, 0x29, 0x16, 0x12, 0xbb, 0x0c, 0x00,
+                },
+        },
+        {
+                .secret_key = {
+                        0xc5, 0xaa, 0x8d, 0xf4, 0x3f, 0x9f, 0x83, 0x7b, 0xed, 0xb7, 0x44, 0x2f, 0x31, 0xdc, 0xb7, 0xb1,
+                        0x66, 0xd3, 0x85, 0x35, 0x07, 0x6f, 0x09, 0x4b, 0x85, 0xce, 0x3a, 0x2e, 0x0b, 0x44, 0x58, 0xf7,
+                        0xfc, 0x51, 0xcd, 0x8e, 0x62, 0x18, 0xa1, 0xa3, 0x8d, 0xa4, 0x7e, 0xd0, 0x02, 0x30, 0xf0, 0x58,
+                        0x08, 0x16, 0xed, 0x13, 0xba, 0x33, 0x03, 0xac, 0x5d, 0xeb, 0x91, 0x15, 0x48, 0x90, 0x80, 0x25,
+                },
+                .len = 2,
+                .message = { 0xaf, 0x82 },
+                .signature = {
+                        0x62, 0x91, 0xd6, 0x57, 0xde, 0xec, 0x24, 0x02, 0x48, 0x27, 0xe6, 0x9c, 0x3a, 0xbe, 0x01, 0xa3,
+                        0x0c, 0xe5, 0x48, 0xa2, 0x84, 0x74, 0x3a, 0x44, 0x5e, 0x36, 0x80, 0xd7, 0xdb, 0x5a, 0xc3, 0xac,
+                        0x18, 0xff, 0x9b, 0x53, 0x8d, 0x16, 0xf2, 0x90, 0xae, 0x67, 0xf7, 0x60, 0x98, 0x4d, 0xc6, 0x59,
+                        0x4a, 0x7c, 0x15, 0xe9, 0x71, 0x6e, 0xd2, 0x8d, 0xc0, 0x27, 0xbe, 0xce, 0xea, 0x1e, 0xc4, 0x0a,
+                },
+        },
+        {
+                .secret_key = {
+                        0x9d, 0x61, 0xb1, 0x9d, 0xef, 0xfd, 0x5a, 0x60, 0xba, 0x84, 0x4a, 0xf4, 0x92, 0xec, 0x2c, 0xc4,
+                        0x44, 0x49, 0xc5, 0x69, 0x7b, 0x32, 0x69, 0x19, 0x70, 0x3b, 0xac, 0x03, 0x1c, 0xae, 0x7f, 0x60,
+                        0xd7, 0x5a, 0x98, 0x01, 0x82, 0xb1, 0x0a, 0xb7, 0xd5, 0x4b, 0xfe, 0xd3, 0xc9, 0x64, 0x07, 0x3a,
+                        0x0e, 0xe1, 0x72, 0xf3, 0xda, 0xa6, 0x23, 0x25, 0xaf, 0x02, 0x1a, 0x68, 0xf7, 0x07, 0x51, 0x1a,
+                },
+                .len = 100,
+                .message = {
+                        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+                        0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+                        0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+                        0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+                        0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+                        0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+                        0x60, 0x61, 0x62, 0x63,
+                },
+                .signature = {
+                        0xe2, 0x47, 0xcf, 0x43, 0x5f, 0xf4, 0x24, 0xc5, 0x74, 0xcd, 0xa2, 0x20, 0x16, 0x6f, 0x83, 0x24,
+                        0x37, 0x36, 0xde, 0x77, 0x53, 0x04, 0x40, 0x54, 0xa6, 0x25, 0xe8, 0xf1, 0x9c, 0x7e, 0x79, 0x57,
+                        0x84, 0x46, 0x6d, 0x20, 0x6a, 0xed, 0x83, 0x47, 0xb4, 0x08, 0xe8, 0x15, 0xb0, 0xfe, 0xd3, 0x4a,
+                        0x38, 0x9a, 0xab, 0x16, 0xac, 0xd5, 0xfa, 0xb0, 0xf9, 0x08, 0xc0, 0xeb, 0xf0, 0x93, 0xd4, 0x03,
+                },
+        },
+};
+
+#define SIGN_VECTORS (sizeof(vectors) / sizeof(vectors[0]))
+
+#define SIGN_VECTORS (sizeof(vectors) / sizeof(vectors[0]))
+
+static void table_fill(void) {
+    ge row = ge_base_point;
+    for (int i = 0; i < SIGNER_TABLE_ROWS; ++i) {
+        ge multiple = row;
+        ge_cached row_cached;
+        ge_to_cached(&row_cached, &row);
+        for (int j = 0; j < SIGNER_TABLE_MULTIPLES; ++j) {
+            ge_to_precomp(&table[i][j], &multiple);
+            ge_add(&multiple, &multiple, &row_cached, false);
+        }
+        for (int k = 0; k < 4 * SIGNER_TABLE_COLUMNS; ++k) {
+            ge_double(&row, &row);
+        }
+    }
+}
+
+/*!
+ * \p t = [\p digit 2^(64 \p row)]B, without a branch or a table index, which depends on the digit.
+ */
+static void table_select(ge_precomp *t, int row, int8_t digit) {
+    uint32_t negative = (uint32_t)digit >> 31;
+    uint32_t magnitude = ((uint32_t)digit ^ (0 - negative)) + negative;
+    ge_precomp minus;
+
+    ge_precomp_identity(t);
+    for (uint32_t j = 1; j <= SIGNER_TABLE_MULTIPLES; ++j) {
+        ge_precomp_cmov(t, &table[row][j - 1], ((magnitude ^ j) - 1) >> 31);
+    }
+    ge_precomp_neg(&minus, t);
+    ge_precomp_cmov(t, &minus, negative);
+}
+
+/*!
+ * \p r = [\p s]B, \p s has to be below 2^255.
+ *
+ * With the radix 16 digits e of s, [s]B is the sum of [16^k sum(e[16 i + k] 2^(64 i))]B
+ * for k = 0 to 15, the inner sums come from the table.
+ */
+static void base_multiply(ge *r, const unsigned char s[32]) {
+    int8_t digits[SIGNER_TABLE_ROWS * SIGNER_TABLE_COLUMNS];
+    ge_precomp t;
+
+    // signed digits in [-8, 8]
+    for (int i = 0; i < 32; ++i) {
+        digits[2 * i] = (int8_t)(s[i] & 15);
+        digits[2 * i + 1] = (int8_t)(s[i] >> 4);
+    }
+    int carry = 0;
+    for (size_t i = 0; i < sizeof(digits) - 1; ++i) {
+        int digit = digits[i] + carry;
+        carry = (digit + 8) >> 4;
+        digits[i] = (int8_t)(digit - carry * 16);
+    }
+    digits[sizeof(digits) - 1] = (int8_t)(digits[sizeof(digits) - 1] + carry);
+
+    ge_identity(r);
+    for (int k = SIGNER_TABLE_COLUMNS - 1; k >= 0; --k) {
+        if (k < SIGNER_TABLE_COLUMNS - 1) {
+            for (int i = 0; i < 4; ++i) {
+                ge_double(r, r);
+            }
+        }
+        for (int i = 0; i < SIGNER_TABLE_ROWS; ++i) {
+            table_select(&t, i, digits[SIGNER_TABLE_COLUMNS * i + k]);
+            ge_madd(r, r, &t);
+        }
+    }
+}
+
+esp_err_t ubirch_signer_init(void) {
+    if (!ready) {
+        table_fill();
+        ready = (ubirch_signer_selftest() == ESP_OK);
+    }
+    return ready ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+void ubirch_signer_key_expand(ubirch_signer_key_t *key, const unsigned char secret_key[crypto_sign_SECRETKEYBYTES]) {
+    unsigned char hash[crypto_hash_sha512_BYTES];
+    crypto_hash_sha512(hash, secret_key, 32);
+    hash[0] &= 248;
+    hash[31] &= 127;
+    hash[31] |= 64;
+    memcpy(key->scalar, hash, 32);
+    memcpy(key->prefix, hash + 32, 32);
+    // like ed25519_sign(), the public key is the second half of the secret key
+    memcpy(key->public_key, secret_key + crypto_sign_SECRETKEYBYTES - crypto_sign_PUBLICKEYBYTES,
+            crypto_sign_PUBLICKEYBYTES);
+    memset(hash, 0, sizeof(hash));
+    stats.expansions++;
+}
+
+void ubirch_signer_key_set(const ubirch_signer_key_t *key) {
+    memcpy(&current, key, sizeof(ubirch_signer_key_t));
+}
+
+int ubirch_signer_sign_key(const ubirch_signer_key_t *key, const unsigned char *data, size_t len,
+        unsigned char signature[crypto_sign_BYTES]) {
+    unsigned char stack_buffer[64 + SIGNER_STACK_DATA_SIZE];
+    unsigned char *buffer = stack_buffer;
+    unsigned char hash[crypto_hash_sha512_BYTES];
+    unsigned char bytes[32];
+    uint32_t words[crypto_hash_sha512_BYTES / 4];
+    uint32_t r[8], h[8], a[8], s[8];
+    ge point;
+
+    if (len > SIGNER_STACK_DATA_SIZE) {
+        buffer = malloc(64 + len);
+        if (buffer == NULL) {
+            return -1;
+        }
+    }
+    // r = SHA-512(prefix || M) mod L
+    memcpy(buffer + 32, key->prefix, 32);
+    memcpy(buffer + 64, data, len);
+    crypto_hash_sha512(hash, buffer + 32, 32 + len);
+    sc_load(words, hash, crypto_hash_sha512_BYTES / 4);
+    sc_reduce(r, words, crypto_hash_sha512_BYTES / 4);
+    // R = [r]B
+    sc_store(bytes, r);
+    base_multiply(&point, bytes);
+    ge_tobytes(signature, &point);
+    // h = SHA-512(R || A || M) mod L
+    memcpy(buffer, signature, 32);
+    memcpy(buffer + 32, key->public_key, 32);
+    crypto_hash_sha512(hash, buffer, 64 + len);
+    sc_load(words, hash, crypto_hash_sha512_BYTES / 4);
+    sc_reduce(h, words, crypto_hash_sha512_BYTES / 4);
+    // S = r + h a mod L
+    sc_load(a, key->scalar, 8);
+    sc_muladd(s, h, a, r);
+    sc_store(signature + 32, s);
+
+    if (buffer != stack_buffer) {
+        free(buffer);
+    }
+    return 0;
+}
+
+int ubirch_signer_sign(const unsigned char *data, size_t len, unsigned char signature[crypto_sign_BYTES]) {
+    if (!ready) {
+        return ed25519_sign(data, len, signature);
+    }
+    // the key storage changes the current context also without the ID cache, e.g. for a registration
+    if (memcmp(current.public_key, ed25519_secret_key + crypto_sign_SECRETKEYBYTES - crypto_sign_PUBLICKEYBYTES,
+            crypto_sign_PUBLICKEYBYTES) != 0) {
+        ubirch_signer_key_expand(&current, ed25519_secret_key);
+    }
+    stats.signs++;
+    return ubirch_signer_sign_key(&current, data, len, signature);
+}
+
+/*!
+ * Sign the message of \p vector with the signer and with ed25519_sign_key().
+ */
+static bool vector_check(const sign_vector_t *vector) {
+    ubirch_signer_key_t key;
+    unsigned char signature[crypto_sign_BYTES];
+    unsigned char nacl_signature[crypto_sign_BYTES];
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+    ge point;
+
+    // the table makes the public key from the scalar, like R from the nonce
+    ubirch_signer_key_expand(&key, vector->secret_key);
+    base_multiply(&point, key.scalar);
+    ge_tobytes(public_key, &point);
+    if (memcmp(public_key, key.public_key, crypto_sign_PUBLICKEYBYTES) != 0
+            || ubirch_signer_sign_key(&key, vector->message, vector->len, signature) != 0
+            || ed25519_sign_key(vector->message, vector->len, nacl_signature, vector->secret_key) != 0) {
+        return false;
+    }
+    // ed25519 signatures are deterministic, the signer and NaCl make the signature of the vector
+    if (memcmp(signature, vector->signature, crypto_sign_BYTES) != 0
+            || memcmp(nacl_signature, vector->signature, crypto_sign_BYTES) != 0
+            || ed25519_verify_key(vector->message, vector->len, signature, key.public_key) != 0) {
+        return false;
+    }
+    // a modified signature must not verify
+    signature[0] ^= 0x01;
+    return ed25519_verify_key(vector->message, vector->len, signature, key.public_key) != 0;
+}
+
+esp_err_t ubirch_signer_selftest(void) {
+    ubirch_signer_stats_t saved = stats;
+    bool passed = true;
+    for (size_t i = 0; i < SIGN_VECTORS; ++i) {
+        passed = passed && vector_check(&vectors[i]);
+    }
+    stats = saved;
+    if (!passed) {
+        ESP_LOGE(TAG, "failed the known answer tests");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+
+void ubirch_signer_stats_get(ubirch_signer_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_signer_stats_t));
+}
+
+static uint32_t benchmark_rate(size_t count, int64_t start) {
+    int64_t elapsed = esp_timer_get_time() - start;
+    return (uint32_t)((int64_t)count * 1000000 / ((elapsed > 0) ? elapsed : 1));
+}
+
+void ubirch_signer_benchmark(size_t count, ubirch_signer_benchmark_t *result) {
+    // the key of the mock backend signs the SHA-512 of a message, like ubirch_protocol signs a UPP
+    const sign_vector_t *vector = &vectors[SIGN_VECTORS - 1];
+    const unsigned char *public_key = vector->secret_key + crypto_sign_SECRETKEYBYTES - crypto_sign_PUBLICKEYBYTES;
+    unsigned char data[crypto_hash_sha512_BYTES];
+    unsigned char signature[crypto_sign_BYTES];
+    ubirch_signer_key_t key;
+    ubirch_signer_stats_t saved = stats;
+
+    crypto_hash_sha512(data, vector->message, vector->len);
+    ubirch_signer_key_expand(&key, vector->secret_key);
+
+    int64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < count; ++i) {
+        ed25519_sign_key(data, sizeof(data), signature, vector->secret_key);
+    }
+    result->nacl_signs = benchmark_rate(count, start);
+
+    start = esp_timer_get_time();
+    for (size_t i = 0; i < count; ++i) {
+        ubirch_signer_sign_key(&key, data, sizeof(data), signature);
+    }
+    result->signs = benchmark_rate(count, start);
+
+    start = esp_timer_get_time();
+    for (size_t i = 0; i < count; ++i) {
+        if (ed25519_verify_key(data, sizeof(data), signature, public_key) != 0) {
+            ESP_LOGE(TAG, "signature of the benchmark is invalid");
+        }
+    }
+    result->verifies = benchmark_rate(count, start);
+    stats = saved;
+}
+
+#endif // CONFIG_UBIRCH_FAST_SIGN
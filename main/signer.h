@@ -0,0 +1,141 @@
+/*!
+ * @file signer.h
+ * @brief ed25519 signatures of the UPPs with per-context expanded keys.
+ *
+ * ed25519_sign() of NaCl hashes the secret key for every signature and
+ * computes R = [r]B with 256 doublings and additions of the NaCl field
+ * arithmetic. The signer keeps the expanded key of a context, the clamped
+ * scalar a, the prefix of the nonce and the public key, from the moment the
+ * context is loaded: the ID cache expands it once and keeps it with the
+ * context. R is computed with the field arithmetic of curve25519.h and a
+ * table of [j 2^(64 i)]B for j = 1 to 8 and i = 0 to 3, which is filled at
+ * startup, with 60 doublings and 64 additions.
+ *
+ * The signatures are the same as those of ed25519_sign(), as ed25519
+ * signatures are deterministic. The known answer tests at startup compare
+ * them with RFC 8032 and with ed25519_sign_key(), host/main/sign_tool.c
+ * compares them for random keys and measures the signatures per second.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_SIGNER_H
+#define EXAMPLE_ESP32_SIGNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <ubirch_ed25519.h>
+
+/*!
+ * Secret key of a context, expanded as in RFC 8032, section 5.1.5.
+ */
+typedef struct {
+    unsigned char scalar[32];       //!< a, the clamped lower half of the SHA-512 of the seed
+    unsigned char prefix[32];       //!< the upper half, hashed with the data into the nonce r
+    unsigned char public_key[crypto_sign_PUBLICKEYBYTES];
+} ubirch_signer_key_t;
+
+/*!
+ * Statistics of the signer.
+ */
+typedef struct {
+    uint32_t signs;         //!< signatures of ubirch_signer_sign()
+    uint32_t expansions;    //!< secret keys expanded, by the ID cache or for a context, which is not cached
+} ubirch_signer_stats_t;
+
+/*!
+ * Result of ubirch_signer_benchmark().
+ */
+typedef struct {
+    uint32_t nacl_signs;    //!< signatures per second of ed25519_sign_key()
+    uint32_t signs;         //!< signatures per second of ubirch_signer_sign_key()
+    uint32_t verifies;      //!< verifications per second of ed25519_verify_key()
+} ubirch_signer_benchmark_t;
+
+/*!
+ * @brief Fill the table of the base point and run the known answer tests.
+ *
+ * Until the tests passed, ubirch_signer_sign() signs with ed25519_sign().
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_RESPONSE if a test failed
+ */
+esp_err_t ubirch_signer_init(void);
+
+/*!
+ * @brief Expand \p secret_key, a seed followed by the public key, like crypto_sign_keypair() makes it.
+ *
+ * @param[out] key the expanded key
+ * @param[in] secret_key the secret key of a context
+ */
+void ubirch_signer_key_expand(ubirch_signer_key_t *key, const unsigned char secret_key[crypto_sign_SECRETKEYBYTES]);
+
+/*!
+ * @brief Make \p key the key of ubirch_signer_sign(), it has to belong to ed25519_secret_key.
+ *
+ * The ID cache sets the key, when it restores a context. If the current
+ * context changes otherwise, ubirch_signer_sign() expands the new key.
+ *
+ * @param[in] key the expanded key of the current context
+ */
+void ubirch_signer_key_set(const ubirch_signer_key_t *key);
+
+/*!
+ * @brief Sign \p data with \p key.
+ *
+ * @return 0, or -1 if the memory for the hashes is not available
+ */
+int ubirch_signer_sign_key(const ubirch_signer_key_t *key, const unsigned char *data, size_t len,
+        unsigned char signature[crypto_sign_BYTES]);
+
+/*!
+ * @brief Sign \p data with the key of the current context, a replacement of ed25519_sign().
+ *
+ * @return 0, or -1 if the signature failed
+ */
+int ubirch_signer_sign(const unsigned char *data, size_t len, unsigned char signature[crypto_sign_BYTES]);
+
+/*!
+ * @brief Run the known answer tests.
+ *
+ * The vectors of RFC 8032 and signatures of ed25519_sign_key() with the key
+ * of the mock backend have to be made, and the signatures have to pass
+ * ed25519_verify_key(), a modified signature must not.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_RESPONSE if a test failed
+ */
+esp_err_t ubirch_signer_selftest(void);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_signer_stats_get(ubirch_signer_stats_t *stats);
+
+/*!
+ * @brief Measure the signatures and verifications per second.
+ *
+ * Every implementation signs or verifies the signed data of a UPP, a
+ * SHA-512, \p count times. This blocks the calling task for some seconds.
+ *
+ * @param[in] count number of signatures and verifications per implementation
+ * @param[out] result the rates
+ */
+void ubirch_signer_benchmark(size_t count, ubirch_signer_benchmark_t *result);
+
+#endif /* EXAMPLE_ESP32_SIGNER_H */
@@ -0,0 +1,405 @@
+/*!
+ * @file upp_queue.c
+ * @brief Persistent store-and-forward queue on a dedicated flash partition.
+ *
+ * Layout of every sector of the partition:
+ *
+ *     | sector header | record | record | ... | erased (0xFF) |
+ *
+ * The sector header contains a sequence number, which gives the order of
+ * the sectors after a reboot. Every record consists of a header (magic,
+ * length, CRC, state and short name) and the data. The state is written
+ * from pending (0xFFFFFFFF) to done (0) without erasing the sector.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+
+#include "budget.h"
+#include "upp_queue.h"
+
+#if CONFIG_UBIRCH_OFFLINE_QUEUE
+
+static const char *TAG = "upp_queue";
+
+#define QUEUE_SECTOR_SIZE SPI_FLASH_SEC_SIZE
+#define QUEUE_SECTOR_MAGIC 0x51425531
+#define QUEUE_RECORD_MAGIC 0x5552
+#define QUEUE_RECORD_PENDING 0xFFFFFFFF
+#define QUEUE_RECORD_DONE 0x00000000
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+} queue_sector_header_t;
+
+typedef struct {
+    uint16_t magic;
+    uint16_t len;
+    uint32_t crc;       //!< CRC32 of short name and data
+    uint32_t state;     //!< QUEUE_RECORD_PENDING or QUEUE_RECORD_DONE
+    char short_name[UBIRCH_QUEUE_SHORT_NAME_SIZE];
+} queue_record_header_t;
+
+#define QUEUE_RECORD_SIZE(len) ((sizeof(queue_record_header_t) + (len) + 3) & ~3u)
+#define QUEUE_FIRST_RECORD sizeof(queue_sector_header_t)
+
+static const esp_partition_t *partition = NULL;
+static uint32_t sector_count = 0;
+static uint32_t *sector_seq = NULL;     //!< sequence number of every sector, 0 if unused
+static uint32_t last_seq = 0;
+static uint32_t head_sector = 0;        //!< sector, which is written
+static size_t head_offset = 0;
+static uint32_t tail_sector = 0;        //!< sector of the oldest pending record
+static size_t tail_offset = 0;
+static size_t pending = 0;
+static SemaphoreHandle_t queue_lock = NULL;
+UBIRCH_SEMAPHORE_DEFINE(queue_lock);
+static ubirch_queue_reclaim_cb reclaim_cb = NULL;
+
+// record buffer, only used while queue_lock is taken
+static uint8_t record_buffer[QUEUE_RECORD_SIZE(UBIRCH_QUEUE_MAX_RECORD_SIZE)];
+
+static inline size_t sector_address(uint32_t sector) {
+    return (size_t)sector * QUEUE_SECTOR_SIZE;
+}
+
+static uint32_t record_crc(const queue_record_header_t *header, const void *data) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)header->short_name, UBIRCH_QUEUE_SHORT_NAME_SIZE);
+    return esp_rom_crc32_le(crc, (const uint8_t *)data, header->len);
+}
+
+/*!
+ * Read the record at \p offset of \p sector into record_buffer.
+ *
+ * @return ESP_OK if the record is valid, ESP_ERR_INVALID_CRC if it is
+ *         corrupted, or ESP_ERR_NOT_FOUND if there are no more records
+ */
+static esp_err_t record_read(uint32_t sector, size_t offset) {
+    queue_record_header_t *header = (queue_record_header_t *)record_buffer;
+    if (offset + sizeof(queue_record_header_t) > QUEUE_SECTOR_SIZE
+            || esp_partition_read(partition, sector_address(sector) + offset,
+                header, sizeof(queue_record_header_t)) != ESP_OK
+            || header->magic != QUEUE_RECORD_MAGIC
+            || header->len > UBIRCH_QUEUE_MAX_RECORD_SIZE
+            || offset + QUEUE_RECORD_SIZE(header->len) > QUEUE_SECTOR_SIZE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint8_t *data = record_buffer + sizeof(queue_record_header_t);
+    if (esp_partition_read(partition, sector_address(sector) + offset + sizeof(queue_record_header_t),
+                data, header->len) != ESP_OK
+            || record_crc(header, data) != header->crc) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t record_mark_done(uint32_t sector, size_t offset) {
+    const uint32_t done = QUEUE_RECORD_DONE;
+    return esp_partition_write(partition,
+            sector_address(sector) + offset + offsetof(queue_record_header_t, state),
+            &done, sizeof(done));
+}
+
+static esp_err_t sector_open(uint32_t sector) {
+    queue_sector_header_t header = { .magic = QUEUE_SECTOR_MAGIC, .seq = last_seq + 1 };
+    if (esp_partition_erase_range(partition, sector_address(sector), QUEUE_SECTOR_SIZE) != ESP_OK
+            || esp_partition_write(partition, sector_address(sector), &header, sizeof(header)) != ESP_OK) {
+        ESP_LOGE(TAG, "failed to open sector %u", sector);
+        sector_seq[sector] = 0;
+        return ESP_FAIL;
+    }
+    last_seq = header.seq;
+    sector_seq[sector] = header.seq;
+    return ESP_OK;
+}
+
+/*!
+ * Continue writing in the next sector, which is the oldest one.
+ */
+static esp_err_t head_advance(void) {
+    uint32_t next = (head_sector + 1) % sector_count;
+    if (sector_seq[next] != 0) {
+        // the oldest sector can only be reused, if all its records were delivered
+        if (pending > 0 && tail_sector == next) {
+            return ESP_ERR_NO_MEM;
+        }
+        if (reclaim_cb != NULL && reclaim_cb() != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    if (sector_open(next) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    head_sector = next;
+    head_offset = QUEUE_FIRST_RECORD;
+    if (pending == 0) {
+        tail_sector = head_sector;
+        tail_offset = head_offset;
+    }
+    return ESP_OK;
+}
+
+/*!
+ * Move the tail to the oldest pending record and read it into record_buffer.
+ */
+static esp_err_t tail_seek(void) {
+    while (pending > 0) {
+        esp_err_t err = record_read(tail_sector, tail_offset);
+        if (err == ESP_ERR_NOT_FOUND) {
+            if (tail_sector == head_sector) {
+                ESP_LOGE(TAG, "%u records lost", (unsigned int)pending);
+                pending = 0;
+                break;
+            }
+            tail_sector = (tail_sector + 1) % sector_count;
+            tail_offset = QUEUE_FIRST_RECORD;
+            continue;
+        }
+        const queue_record_header_t *header = (const queue_record_header_t *)record_buffer;
+        if (err == ESP_OK && header->state == QUEUE_RECORD_PENDING) {
+            return ESP_OK;
+        }
+        if (err == ESP_ERR_INVALID_CRC) {
+            // corrupted records are not counted as pending
+            ESP_LOGW(TAG, "skip corrupted record");
+        }
+        tail_offset += QUEUE_RECORD_SIZE(header->len);
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/*!
+ * Move \p sector and \p offset to the next pending record at or behind them
+ * and read it into record_buffer.
+ */
+static esp_err_t pending_seek(uint32_t *sector, size_t *offset) {
+    for (;;) {
+        esp_err_t err = record_read(*sector, *offset);
+        if (err == ESP_ERR_NOT_FOUND) {
+            if (*sector == head_sector) {
+                return ESP_ERR_NOT_FOUND;
+            }
+            *sector = (*sector + 1) % sector_count;
+            *offset = QUEUE_FIRST_RECORD;
+            continue;
+        }
+        const queue_record_header_t *header = (const queue_record_header_t *)record_buffer;
+        if (err == ESP_OK && header->state == QUEUE_RECORD_PENDING) {
+            return ESP_OK;
+        }
+        *offset += QUEUE_RECORD_SIZE(header->len);
+    }
+}
+
+/*!
+ * Find the pending record, which follows \p index pending records behind
+ * the oldest one, and read it into record_buffer.
+ */
+static esp_err_t record_seek(size_t index, uint32_t *sector, size_t *offset) {
+    if (index >= pending) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = tail_seek();
+    *sector = tail_sector;
+    *offset = tail_offset;
+    for (; err == ESP_OK && index > 0; --index) {
+        const queue_record_header_t *header = (const queue_record_header_t *)record_buffer;
+        *offset += QUEUE_RECORD_SIZE(header->len);
+        err = pending_seek(sector, offset);
+    }
+    return err;
+}
+
+/*!
+ * Scan the sectors from the oldest to the newest and recover the queue state.
+ */
+static void recover(ubirch_queue_replay_cb replay) {
+    uint32_t oldest = 0;
+    uint32_t newest = 0;
+    for (uint32_t sector = 0; sector < sector_count; ++sector) {
+        queue_sector_header_t header;
+        if (esp_partition_read(partition, sector_address(sector), &header, sizeof(header)) != ESP_OK
+                || header.magic != QUEUE_SECTOR_MAGIC) {
+            continue;
+        }
+        sector_seq[sector] = header.seq;
+        if (header.seq > last_seq) {
+            last_seq = header.seq;
+            newest = sector;
+        }
+        if (sector_seq[oldest] == 0 || header.seq < sector_seq[oldest]) {
+            oldest = sector;
+        }
+    }
+    if (last_seq == 0) {
+        head_sector = sector_count - 1;
+        head_advance();
+        return;
+    }
+
+    bool tail_found = false;
+    for (uint32_t sector = oldest;; sector = (sector + 1) % sector_count) {
+        size_t offset = QUEUE_FIRST_RECORD;
+        esp_err_t err;
+        while ((err = record_read(sector, offset)) != ESP_ERR_NOT_FOUND) {
+            const queue_record_header_t *header = (const queue_record_header_t *)record_buffer;
+            if (err == ESP_OK) {
+                if (replay != NULL) {
+                    replay(header->short_name, record_buffer + sizeof(queue_record_header_t), header->len);
+                }
+                if (header->state == QUEUE_RECORD_PENDING) {
+                    if (!tail_found) {
+                        tail_sector = sector;
+                        tail_offset = offset;
+                        tail_found = true;
+                    }
+                    pending++;
+                }
+            }
+            offset += QUEUE_RECORD_SIZE(header->len);
+        }
+        if (sector == newest) {
+            head_sector = sector;
+            head_offset = offset;
+            break;
+        }
+    }
+    if (!tail_found) {
+        tail_sector = head_sector;
+        tail_offset = head_offset;
+    }
+
+    // a write could have been interrupted, never write over non-erased flash
+    uint32_t erased[sizeof(queue_record_header_t) / sizeof(uint32_t)];
+    if (head_offset + sizeof(erased) <= QUEUE_SECTOR_SIZE
+            && esp_partition_read(partition, sector_address(head_sector) + head_offset,
+                erased, sizeof(erased)) == ESP_OK) {
+        for (size_t i = 0; i < sizeof(erased) / sizeof(uint32_t); ++i) {
+            if (erased[i] != 0xFFFFFFFF) {
+                head_offset = QUEUE_SECTOR_SIZE;
+                break;
+            }
+        }
+    }
+}
+
+esp_err_t ubirch_queue_init(ubirch_queue_replay_cb replay, ubirch_queue_reclaim_cb reclaim) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+            CONFIG_UBIRCH_QUEUE_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "partition \"%s\" not found", CONFIG_UBIRCH_QUEUE_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    sector_count = partition->size / QUEUE_SECTOR_SIZE;
+    sector_seq = calloc(sector_count, sizeof(uint32_t));
+    queue_lock = UBIRCH_MUTEX_CREATE(queue_lock);
+    if (sector_seq == NULL || queue_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    reclaim_cb = reclaim;
+
+    xSemaphoreTake(queue_lock, portMAX_DELAY);
+    recover(replay);
+    xSemaphoreGive(queue_lock);
+    ESP_LOGI(TAG, "%u sectors, %u pending records", sector_count, (unsigned int)pending);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_queue_push(const char *short_name, const void *data, size_t len) {
+    if (len > UBIRCH_QUEUE_MAX_RECORD_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t size = QUEUE_RECORD_SIZE(len);
+    xSemaphoreTake(queue_lock, portMAX_DELAY);
+    if (head_offset + size > QUEUE_SECTOR_SIZE) {
+        esp_err_t err = head_advance();
+        if (err != ESP_OK) {
+            xSemaphoreGive(queue_lock);
+            return err;
+        }
+    }
+    queue_record_header_t *header = (queue_record_header_t *)record_buffer;
+    memset(record_buffer, 0xFF, size);
+    header->magic = QUEUE_RECORD_MAGIC;
+    header->len = (uint16_t)len;
+    header->state = QUEUE_RECORD_PENDING;
+    memset(header->short_name, 0, UBIRCH_QUEUE_SHORT_NAME_SIZE);
+    strncpy(header->short_name, short_name, UBIRCH_QUEUE_SHORT_NAME_SIZE - 1);
+    memcpy(record_buffer + sizeof(queue_record_header_t), data, len);
+    header->crc = record_crc(header, data);
+
+    if (esp_partition_write(partition, sector_address(head_sector) + head_offset,
+                record_buffer, size) != ESP_OK) {
+        // do not try this part of the sector again
+        head_offset = QUEUE_SECTOR_SIZE;
+        xSemaphoreGive(queue_lock);
+        return ESP_FAIL;
+    }
+    head_offset += size;
+    pending++;
+    xSemaphoreGive(queue_lock);
+    return ESP_OK;
+}
+
+esp_err_t ubirch_queue_peek(size_t index, char *short_name, void *data, size_t *len) {
+    uint32_t sector;
+    size_t offset;
+    xSemaphoreTake(queue_lock, portMAX_DELAY);
+    esp_err_t err = record_seek(index, &sector, &offset);
+    if (err == ESP_OK) {
+        const queue_record_header_t *header = (const queue_record_header_t *)record_buffer;
+        memcpy(short_name, header->short_name, UBIRCH_QUEUE_SHORT_NAME_SIZE);
+        short_name[UBIRCH_QUEUE_SHORT_NAME_SIZE - 1] = '\0';
+        memcpy(data, record_buffer + sizeof(queue_record_header_t), header->len);
+        *len = header->len;
+    }
+    xSemaphoreGive(queue_lock);
+    return err;
+}
+
+esp_err_t ubirch_queue_pop(size_t index) {
+    uint32_t sector;
+    size_t offset;
+    xSemaphoreTake(queue_lock, portMAX_DELAY);
+    esp_err_t err = record_seek(index, &sector, &offset);
+    if (err == ESP_OK) {
+        err = record_mark_done(sector, offset);
+        if (index == 0) {
+            const queue_record_header_t *header = (const queue_record_header_t *)record_buffer;
+            tail_offset += QUEUE_RECORD_SIZE(header->len);
+        }
+        pending--;
+    }
+    xSemaphoreGive(queue_lock);
+    return err;
+}
+
+size_t ubirch_queue_count(void) {
+    return pending;
+}
+
+#endif // CONFIG_UBIRCH_OFFLINE_QUEUE
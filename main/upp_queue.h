@@ -0,0 +1,100 @@
+/*!
+ * @file upp_queue.h
+ * @brief Persistent store-and-forward queue on a dedicated flash partition.
+ *
+ * The queue keeps records (e.g. signed UPPs) until they are delivered to
+ * the backend, also over reboots. It is an append-only log over the
+ * sectors of the partition, which are used as a ring, so every sector is
+ * erased equally often. Delivered records are only marked as done, the
+ * sector is erased when the writer needs it again.
+ *
+ * Each record belongs to an ID context, given by its short name.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_UPP_QUEUE_H
+#define EXAMPLE_ESP32_UPP_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+#define UBIRCH_QUEUE_SHORT_NAME_SIZE 16
+#define UBIRCH_QUEUE_MAX_RECORD_SIZE 512
+
+/*!
+ * Function, which is called for every record found on flash during
+ * ubirch_queue_init(), in the order the records were written.
+ * Delivered records, which are not yet erased, are included.
+ */
+typedef void (*ubirch_queue_replay_cb)(const char *short_name, const void *data, size_t len);
+
+/*!
+ * Function, which is called before a sector with delivered records is erased.
+ * If it does not return ESP_OK, the sector is not erased and the push fails.
+ */
+typedef esp_err_t (*ubirch_queue_reclaim_cb)(void);
+
+/*!
+ * @brief Open the queue partition and recover the queue state.
+ *
+ * @param[in] replay called for every record on flash, or NULL
+ * @param[in] reclaim called before a sector is erased, or NULL
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if there is no queue partition
+ */
+esp_err_t ubirch_queue_init(ubirch_queue_replay_cb replay, ubirch_queue_reclaim_cb reclaim);
+
+/*!
+ * @brief Append a record to the queue.
+ *
+ * @param[in] short_name short name of the ID context of the record
+ * @param[in] data record data
+ * @param[in] len length of the data, at most UBIRCH_QUEUE_MAX_RECORD_SIZE
+ * @return ESP_OK, ESP_ERR_NO_MEM if the queue is full, or ESP_FAIL on flash errors
+ */
+esp_err_t ubirch_queue_push(const char *short_name, const void *data, size_t len);
+
+/*!
+ * @brief Read an undelivered record, without removing it.
+ *
+ * @param[in] index position of the record among the undelivered records, 0 is the oldest
+ * @param[out] short_name buffer of UBIRCH_QUEUE_SHORT_NAME_SIZE bytes
+ * @param[out] data buffer of UBIRCH_QUEUE_MAX_RECORD_SIZE bytes
+ * @param[out] len length of the record data
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if there are not more than \p index records
+ */
+esp_err_t ubirch_queue_peek(size_t index, char *short_name, void *data, size_t *len);
+
+/*!
+ * @brief Mark an undelivered record as delivered.
+ *
+ * The following records move up by one position. Records, which are
+ * delivered out of order, are skipped like the others, when the oldest
+ * record is delivered.
+ *
+ * @param[in] index position of the record among the undelivered records, 0 is the oldest
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if there are not more than \p index records
+ */
+esp_err_t ubirch_queue_pop(size_t index);
+
+/*!
+ * @brief Get the number of undelivered records.
+ */
+size_t ubirch_queue_count(void);
+
+#endif /* EXAMPLE_ESP32_UPP_QUEUE_H */
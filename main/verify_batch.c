@@ -0,0 +1,416 @@
+/*!
+ * @file verify_batch.c
+ * @brief Batch verification of the ed25519 signatures of backend responses.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <sys/param.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include "curve25519.h"
+#include "verify_batch.h"
+
+#if CONFIG_UBIRCH_VERIFY_BATCH
+
+static const char *TAG = "verify batch";
+
+#define BATCH_SIZE CONFIG_UBIRCH_VERIFY_BATCH_SIZE
+#define BATCH_POINTS (BATCH_SIZE + 2)   //!< R of every signature, the public key and the base point
+#define BATCH_DIGITS 256
+#define SCALAR_SUM_WORDS 13             //!< sum of up to 32 products of 253 and 128 bit
+
+// the verification is not reentrant, the tables are too large for the stack of the verify task
+static int8_t digits[BATCH_POINTS][BATCH_DIGITS];
+static ge_cached table[BATCH_POINTS][4];        //!< P, 3P, 5P and 7P of every point
+
+static ubirch_verify_batch_stats_t stats = { 0 };
+
+/*!
+ * Fill the table of the odd multiples of \p p.
+ */
+static void table_fill(ge_cached t[4], const ge *p) {
+    ge p2, q;
+    ge_cached p2_cached;
+    ge_double(&p2, p);
+    ge_to_cached(&p2_cached, &p2);
+    ge_to_cached(&t[0], p);
+    q = *p;
+    for (int i = 1; i < 4; ++i) {
+        ge_add(&q, &q, &p2_cached, false);
+        ge_to_cached(&t[i], &q);
+    }
+}
+
+/*!
+ * \p sum += \p a * \p z.
+ */
+static void sc_mul_add(uint32_t sum[SCALAR_SUM_WORDS], const uint32_t a[8], const uint32_t z[4]) {
+    for (int i = 0; i < 4; ++i) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 8; ++j) {
+            uint64_t t = (uint64_t)z[i] * a[j] + sum[i + j] + carry;
+            sum[i + j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        for (int k = i + 8; carry != 0 && k < SCALAR_SUM_WORDS; ++k) {
+            uint64_t t = (uint64_t)sum[k] + carry;
+            sum[k] = (uint32_t)t;
+            carry = t >> 32;
+        }
+    }
+}
+
+/*!
+ * Recode \p s into odd digits in [-7, 7], at most one of four following
+ * digits is not zero. \p s has to be below 2^255.
+ */
+static void scalar_digits(int8_t r[BATCH_DIGITS], const unsigned char s[32]) {
+    for (int i = 0; i < BATCH_DIGITS; ++i) {
+        r[i] = (int8_t)(1 & (s[i >> 3] >> (i & 7)));
+    }
+    for (int i = 0; i < BATCH_DIGITS; ++i) {
+        if (r[i] == 0) {
+            continue;
+        }
+        for (int b = 1; b <= 3 && i + b < BATCH_DIGITS; ++b) {
+            if (r[i + b] == 0) {
+                continue;
+            }
+            if (r[i] + (r[i + b] << b) <= 7) {
+                r[i] = (int8_t)(r[i] + (r[i + b] << b));
+                r[i + b] = 0;
+            } else if (r[i] - (r[i + b] << b) >= -7) {
+                r[i] = (int8_t)(r[i] - (r[i + b] << b));
+                for (int k = i + b; k < BATCH_DIGITS; ++k) {
+                    if (r[k] == 0) {
+                        r[k] = 1;
+                        break;
+                    }
+                    r[k] = 0;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+}
+
+esp_err_t ubirch_verify_item_collect(ubirch_verify_item_t *item, const char *upp, size_t len) {
+    // the signature is packed as bin 8 with 64 bytes, at the end of the UPP
+    if (len < crypto_sign_BYTES + 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t signed_len = len - crypto_sign_BYTES - 2;
+    if ((unsigned char)upp[signed_len] != 0xc4 || (unsigned char)upp[signed_len + 1] != crypto_sign_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    crypto_hash_sha512(item->data, (const unsigned char *)upp, signed_len);
+    item->len = UBIRCH_VERIFY_DATA_SIZE;
+    memcpy(item->signature, upp + len - crypto_sign_BYTES, crypto_sign_BYTES);
+    item->valid = false;
+    return ESP_OK;
+}
+
+int ubirch_verify_batch_check(const ubirch_verify_item_t *items, size_t count,
+        const unsigned char public_key[crypto_sign_PUBLICKEYBYTES]) {
+    uint32_t sum_h[SCALAR_SUM_WORDS] = { 0 };
+    uint32_t sum_s[SCALAR_SUM_WORDS] = { 0 };
+    unsigned char hash_input[2 * 32 + UBIRCH_VERIFY_DATA_SIZE];
+    unsigned char hash[crypto_hash_sha512_BYTES];
+    unsigned char bytes[32];
+    uint32_t words[crypto_hash_sha512_BYTES / 4];
+    uint32_t h[8], s[8];
+    uint32_t z[8] = { 0 };          //!< 128 bit factor, the upper words stay zero
+    ge point;
+
+    if (count == 0) {
+        return 0;
+    }
+    // small-order points pass the batch equation, but not always the single verification
+    if (count > BATCH_SIZE || !ge_frombytes(&point, public_key) || ge_has_small_order(&point)) {
+        return -1;
+    }
+    table_fill(table[count], &point);
+    table_fill(table[count + 1], &ge_base_point);
+
+    for (size_t i = 0; i < count; ++i) {
+        const ubirch_verify_item_t *item = &items[i];
+        sc_load(s, item->signature + 32, 8);
+        if (item->len > UBIRCH_VERIFY_DATA_SIZE || !sc_is_reduced(s) || !ge_frombytes(&point, item->signature)
+                || ge_has_small_order(&point)) {
+            return -1;
+        }
+        table_fill(table[i], &point);
+
+        // h = SHA-512(R || A || M) mod L
+        memcpy(hash_input, item->signature, 32);
+        memcpy(hash_input + 32, public_key, 32);
+        memcpy(hash_input + 64, item->data, item->len);
+        crypto_hash_sha512(hash, hash_input, 64 + item->len);
+        sc_load(words, hash, crypto_hash_sha512_BYTES / 4);
+        sc_reduce(h, words, crypto_hash_sha512_BYTES / 4);
+
+        // a forger, who does not know z, can not make the invalid signatures cancel out
+        do {
+            esp_fill_random(z, 4 * sizeof(uint32_t));
+        } while ((z[0] | z[1] | z[2] | z[3]) == 0);
+        sc_mul_add(sum_h, h, z);
+        sc_mul_add(sum_s, s, z);
+        sc_store(bytes, z);
+        scalar_digits(digits[i], bytes);
+    }
+    // [sum(z h) mod L]A
+    sc_reduce(h, sum_h, SCALAR_SUM_WORDS);
+    sc_store(bytes, h);
+    scalar_digits(digits[count], bytes);
+    // [-sum(z s) mod L]B
+    sc_reduce(s, sum_s, SCALAR_SUM_WORDS);
+    if ((s[0] | s[1] | s[2] | s[3] | s[4] | s[5] | s[6] | s[7]) != 0) {
+        sc_sub(s, sc_order, s);
+    }
+    sc_store(bytes, s);
+    scalar_digits(digits[count + 1], bytes);
+
+    // one multi-scalar multiplication, all points share the doublings
+    size_t points = count + 2;
+    int top = BATCH_DIGITS - 1;
+    for (; top >= 0; --top) {
+        size_t j = 0;
+        while (j < points && digits[j][top] == 0) {
+            ++j;
+        }
+        if (j < points) {
+            break;
+        }
+    }
+    ge_identity(&point);
+    for (int bit = top; bit >= 0; --bit) {
+        ge_double(&point, &point);
+        for (size_t j = 0; j < points; ++j) {
+            int8_t digit = digits[j][bit];
+            if (digit > 0) {
+                ge_add(&point, &point, &table[j][digit / 2], false);
+            } else if (digit < 0) {
+                ge_add(&point, &point, &table[j][-digit / 2], true);
+            }
+        }
+    }
+    // the cofactor removes the small-order components
+    for (int i = 0; i < 3; ++i) {
+        ge_double(&point, &point);
+    }
+    return ge_is_identity(&point) ? 0 : -1;
+}
+
+esp_err_t ubirch_verify_batch(ubirch_verify_item_t *items, size_t count,
+        const unsigned char public_key[crypto_sign_PUBLICKEYBYTES]) {
+    esp_err_t err = ESP_OK;
+    for (size_t start = 0; start < count; start += BATCH_SIZE) {
+        ubirch_verify_item_t *batch = &items[start];
+        size_t batch_count = MIN(count - start, BATCH_SIZE);
+        bool batch_valid = false;
+        // a single signature is checked faster by the backend
+        if (batch_count > 1) {
+            stats.batches++;
+            stats.items += batch_count;
+            batch_valid = (ubirch_verify_batch_check(batch, batch_count, public_key) == 0);
+            if (!batch_valid) {
+                stats.fallbacks++;
+            }
+        }
+        for (size_t i = 0; i < batch_count; ++i) {
+            batch[i].valid = batch_valid
+                    || ed25519_verify_key(batch[i].data, batch[i].len, batch[i].signature, public_key) == 0;
+            if (!batch[i].valid) {
+                stats.invalid++;
+                err = ESP_ERR_INVALID_RESPONSE;
+            }
+        }
+    }
+    return err;
+}
+
+// public key of the mock backend, the key of TEST 1 of RFC 8032
+static const unsigned char kat_public_key[crypto_sign_PUBLICKEYBYTES] = {
+        0xd7, 0x5a, 0x98, 0x01, 0x82, 0xb1, 0x0a, 0xb7, 0xd5, 0x4b, 0xfe, 0xd3, 0xc9, 0x64, 0x07, 0x3a,
+        0x0e, 0xe1, 0x72, 0xf3, 0xda, 0xa6, 0x23, 0x25, 0xaf, 0x02, 0x1a, 0x68, 0xf7, 0x07, 0x51, 0x1a,
+};
+
+#define KAT_RESPONSES 4
+#define KAT_RESPONSE_SIZE 219
+
+// chained responses of host/mock_backend.py to the UPPs "upp 0" to "upp 3"
+static const char kat_responses[KAT_RESPONSES][KAT_RESPONSE_SIZE] = {
+        {
+                0x96, 0x23, 0xc4, 0x10, 0x9d, 0x3c, 0x78, 0xff, 0x22, 0xf3, 0x44, 0x41, 0xa5, 0xd1, 0x85, 0xc6,
+                0x36, 0xd4, 0x86, 0xff, 0xc4, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc4, 0x40, 0x6f, 0xa6, 0x2f, 0x49, 0xd5, 0x31, 0x17,
+                0x62, 0xa0, 0x74, 0x3d, 0xc7, 0x8f, 0x50, 0x23, 0x5b, 0x94, 0xf0, 0xcf, 0x37, 0xff, 0x63, 0x4b,
+                0x27, 0xea, 0x2f, 0xc3, 0xd0, 0x54, 0x69, 0xc8, 0x2c, 0xf8, 0x61, 0x83, 0x7f, 0x39, 0xb5, 0x4b,
+                0x80, 0x7d, 0xbb, 0xf4, 0xaa, 0x34, 0x08, 0xc6, 0x4d, 0xaa, 0x7c, 0x81, 0xa9, 0x48, 0xcc, 0xb2,
+                0x6f, 0x79, 0x10, 0xb5, 0x0e, 0x7e, 0x40, 0xfc, 0xe9, 0xc4, 0x40, 0x98, 0x16, 0x68, 0xe1, 0x02,
+                0x30, 0x0b, 0x5f, 0x6e, 0xd7, 0x88, 0xd4, 0xc7, 0x73, 0xc3, 0xcd, 0x15, 0x3c, 0x2a, 0xa3, 0x78,
+                0xa9, 0x90, 0xde, 0x7f, 0x0d, 0x50, 0x33, 0xdc, 0x9e, 0xa3, 0xbd, 0x48, 0x29, 0x66, 0x1c, 0x25,
+                0xb0, 0x53, 0x6d, 0xa4, 0x84, 0x18, 0x57, 0xb6, 0xbd, 0x8f, 0x1f, 0xae, 0x41, 0xc9, 0x3f, 0x0e,
+                0x15, 0xe2, 0x53, 0xd0, 0x01, 0x80, 0xf3, 0x7d, 0x9c, 0x16, 0x01,
+        },
+        {
+                0x96, 0x23, 0xc4, 0x10, 0x9d, 0x3c, 0x78, 0xff, 0x22, 0xf3, 0x44, 0x41, 0xa5, 0xd1, 0x85, 0xc6,
+                0x36, 0xd4, 0x86, 0xff, 0xc4, 0x40, 0x98, 0x16, 0x68, 0xe1, 0x02, 0x30, 0x0b, 0x5f, 0x6e, 0xd7,
+                0x88, 0xd4, 0xc7, 0x73, 0xc3, 0xcd, 0x15, 0x3c, 0x2a, 0xa3, 0x78, 0xa9, 0x90, 0xde, 0x7f, 0x0d,
+                0x50, 0x33, 0xdc, 0x9e, 0xa3, 0xbd, 0x48, 0x29, 0x66, 0x1c, 0x25, 0xb0, 0x53, 0x6d, 0xa4, 0x84,
+                0x18, 0x57, 0xb6, 0xbd, 0x8f, 0x1f, 0xae, 0x41, 0xc9, 0x3f, 0x0e, 0x15, 0xe2, 0x53, 0xd0, 0x01,
+                0x80, 0xf3, 0x7d, 0x9c, 0x16, 0x01, 0x00, 0xc4, 0x40, 0x99, 0xf8, 0x8b, 0x82, 0x1f, 0xaf, 0xbe,
+                0x69, 0x67, 0xfa, 0x94, 0x91, 0x34, 0x7d, 0x42, 0x7a, 0x41, 0x32, 0x7c, 0xd9, 0xba, 0x57, 0xea,
+                0xfa, 0xff, 0x8e, 0xe1, 0x77, 0xc8, 0x1b, 0x14, 0xa5, 0xb6, 0xc3, 0x2f, 0xf6, 0x7a, 0xf4, 0xf7,
+                0x02, 0xd3, 0x74, 0x71, 0x7b, 0x00, 0x10, 0xb3, 0xfe, 0x0c, 0x22, 0x90, 0x9d, 0xfc, 0x08, 0xbc,
+                0xc5, 0x3c, 0x41, 0x41, 0xae, 0xbd, 0x81, 0x24, 0x1a, 0xc4, 0x40, 0x41, 0xb5, 0xb8, 0x58, 0x77,
+                0x9c, 0xe6, 0xf5, 0x78, 0xd1, 0x31, 0xd4, 0x12, 0xbd, 0x63, 0xef, 0x77, 0xe1, 0x68, 0x72, 0xb2,
+                0xa0, 0x66, 0x96, 0xbd, 0xeb, 0xb3, 0x60, 0xdb, 0x3a, 0x20, 0xc9, 0xc1, 0x63, 0x45, 0x0c, 0xbc,
+                0xb4, 0x03, 0x1d, 0x0f, 0x2a, 0xeb, 0x82, 0xa2, 0x86, 0xab, 0x11, 0x10, 0xe0, 0xd6, 0xa1, 0xc7,
+                0x11, 0x24, 0xab, 0x57, 0x11, 0xd8, 0x93, 0x67, 0xc9, 0xe6, 0x0a,
+        },
+        {
+                0x96, 0x23, 0xc4, 0x10, 0x9d, 0x3c, 0x78, 0xff, 0x22, 0xf3, 0x44, 0x41, 0xa5, 0xd1, 0x85, 0xc6,
+                0x36, 0xd4, 0x86, 0xff, 0xc4, 0x40, 0x41, 0xb5, 0xb8, 0x58, 0x77, 0x9c, 0xe6, 0xf5, 0x78, 0xd1,
+                0x31, 0xd4, 0x12, 0xbd, 0x63, 0xef, 0x77, 0xe1, 0x68, 0x72, 0xb2, 0xa0, 0x66, 0x96, 0xbd, 0xeb,
+                0xb3, 0x60, 0xdb, 0x3a, 0x20, 0xc9, 0xc1, 0x63, 0x45, 0x0c, 0xbc, 0xb4, 0x03, 0x1d, 0x0f, 0x2a,
+                0xeb, 0x82, 0xa2, 0x86, 0xab, 0x11, 0x10, 0xe0, 0xd6, 0xa1, 0xc7, 0x11, 0x24, 0xab, 0x57, 0x11,
+                0xd8, 0x93, 0x67, 0xc9, 0xe6, 0x0a, 0x00, 0xc4, 0x40, 0xa9, 0x2e, 0xa4, 0x31, 0x0d, 0x3b, 0x45,
+                0x07, 0xb0, 0x3e, 0xd8, 0xe3, 0x77, 0xb7, 0x9d, 0xe0, 0x9d, 0xd9, 0xbb, 0x73, 0x85, 0x88, 0x2d,
+                0xb0, 0xa8, 0xc3, 0x51, 0x4d, 0x6a, 0x6f, 0x09, 0xf6, 0x46, 0x9e, 0xba, 0x10, 0x13, 0x63, 0x05,
+                0x36, 0x3e, 0x18, 0xe3, 0xf3, 0xa0, 0x25, 0x31, 0x9b, 0x35, 0x39, 0x9b, 0xb8, 0xc4, 0x18, 0xa9,
+                0xc4, 0x20, 0xf0, 0xf0, 0x7b, 0x65, 0x7a, 0x37, 0x52, 0xc4, 0x40, 0x14, 0x74, 0xb4, 0x79, 0x74,
+                0xb3, 0x55, 0x2c, 0xb5, 0x5a, 0xd4, 0x63, 0xfc, 0x32, 0xe2, 0xc2, 0xb6, 0xb4, 0xdf, 0xce, 0xce,
+                0xfd, 0x73, 0x54, 0xad, 0xd4, 0xdd, 0x89, 0x40, 0xa1, 0x29, 0xb7, 0x8c, 0xa2, 0xc6, 0x39, 0xc2,
+                0x8a, 0xf7, 0x93, 0xc2, 0x6e, 0x65, 0xba, 0x96, 0x1e, 0x0e, 0x14, 0xe4, 0x85, 0xef, 0x8e, 0xe4,
+                0x18, 0xd4, 0x15, 0x83, 0xbd, 0x2f, 0x50, 0x9a, 0xd1, 0x1f, 0x00,
+        },
+        {
+                0x96, 0x23, 0xc4, 0x10, 0x9d, 0x3c, 0x78, 0xff, 0x22, 0xf3, 0x44, 0x41, 0xa5, 0xd1, 0x85, 0xc6,
+                0x36, 0xd4, 0x86, 0xff, 0xc4, 0x40, 0x14, 0x74, 0xb4, 0x79, 0x74, 0xb3, 0x55, 0x2c, 0xb5, 0x5a,
+                0xd4, 0x63, 0xfc, 0x32, 0xe2, 0xc2, 0xb6, 0xb4, 0xdf, 0xce, 0xce, 0xfd, 0x73, 0x54, 0xad, 0xd4,
+                0xdd, 0x89, 0x40, 0xa1, 0x29, 0xb7, 0x8c, 0xa2, 0xc6, 0x39, 0xc2, 0x8a, 0xf7, 0x93, 0xc2, 0x6e,
+                0x65, 0xba, 0x96, 0x1e, 0x0e, 0x14, 0xe4, 0x85, 0xef, 0x8e, 0xe4, 0x18, 0xd4, 0x15, 0x83, 0xbd,
+                0x2f, 0x50, 0x9a, 0xd1, 0x1f, 0x00, 0x00, 0xc4, 0x40, 0xa9, 0x14, 0x38, 0x69, 0x96, 0x3c, 0x13,
+                0x96, 0xbe, 0x7d, 0x91, 0x7d, 0x72, 0x88, 0x94, 0x4b, 0x25, 0x76, 0x52, 0x25, 0x3a, 0x10, 0x82,
+                0xdf, 0x78, 0xa1, 0x3f, 0x2c, 0x3f, 0xe1, 0xa4, 0xbf, 0x2c, 0x4e, 0xf1, 0xb4, 0xbc, 0x71, 0x9a,
+                0xdc, 0x5b, 0x1e, 0xf0, 0xc9, 0x51, 0x30, 0xde, 0x2c, 0x00, 0x44, 0x68, 0x52, 0x2b, 0x1a, 0x0e,
+                0x92, 0x41, 0x9f, 0x2c, 0x4b, 0xa0, 0x7b, 0x0f, 0x51, 0xc4, 0x40, 0x03, 0x99, 0xec, 0x55, 0xee,
+                0x32, 0xf7, 0x4f, 0x85, 0x28, 0x6a, 0x1a, 0x46, 0x29, 0xd7, 0x0e, 0x33, 0x0a, 0xfd, 0xaa, 0x0f,
+                0x3e, 0xec, 0x67, 0x98, 0x98, 0xeb, 0x48, 0x45, 0xa4, 0x5a, 0x1c, 0xdb, 0x99, 0x7e, 0xe2, 0x43,
+                0x89, 0xf0, 0x51, 0x65, 0xf6, 0x5c, 0x38, 0xd3, 0xf2, 0xe8, 0x12, 0x4c, 0x1a, 0x27, 0x63, 0xc1,
+                0xb6, 0xef, 0x1e, 0x47, 0xe1, 0xd6, 0xe8, 0x52, 0xc5, 0x22, 0x06,
+        },
+};
+
+/*!
+ * Modify one byte of \p item, the batch has to fail and only \p item has to be invalid.
+ */
+static bool kat_modified_check(ubirch_verify_item_t *items, size_t count, unsigned char *byte) {
+    *byte ^= 0x01;
+    bool found = ubirch_verify_batch_check(items, count, kat_public_key) != 0
+            && ubirch_verify_batch(items, count, kat_public_key) == ESP_ERR_INVALID_RESPONSE;
+    for (size_t i = 0; i < count; ++i) {
+        bool modified = (byte >= items[i].data && byte < items[i].data + sizeof(items[i].data))
+                || (byte >= items[i].signature && byte < items[i].signature + sizeof(items[i].signature));
+        found = found && (items[i].valid != modified);
+    }
+    *byte ^= 0x01;
+    return found;
+}
+
+esp_err_t ubirch_verify_batch_selftest(void) {
+    static ubirch_verify_item_t items[KAT_RESPONSES];
+    size_t count = MIN(KAT_RESPONSES, BATCH_SIZE);
+    ubirch_verify_batch_stats_t saved = stats;
+    bool passed = true;
+
+    for (size_t i = 0; i < KAT_RESPONSES; ++i) {
+        passed = passed && ubirch_verify_item_collect(&items[i], kat_responses[i], KAT_RESPONSE_SIZE) == ESP_OK;
+        passed = passed && ubirch_verify_batch_check(&items[i], 1, kat_public_key) == 0;
+    }
+    // a signature, which is not packed as bin 8 at the end, is not collected
+    char response[KAT_RESPONSE_SIZE];
+    memcpy(response, kat_responses[0], KAT_RESPONSE_SIZE);
+    response[KAT_RESPONSE_SIZE - crypto_sign_BYTES - 2] = (char)0xc5;
+    passed = passed && ubirch_verify_item_collect(&items[0], response, KAT_RESPONSE_SIZE) == ESP_ERR_INVALID_ARG
+            && ubirch_verify_item_collect(&items[0], kat_responses[0], KAT_RESPONSE_SIZE) == ESP_OK;
+    passed = passed && ubirch_verify_batch_check(items, count, kat_public_key) == 0
+            && ubirch_verify_batch(items, KAT_RESPONSES, kat_public_key) == ESP_OK;
+    // a modified s, R and signed data
+    passed = passed && kat_modified_check(items, count, &items[1].signature[40])
+            && kat_modified_check(items, count, &items[0].signature[3])
+            && kat_modified_check(items, count, &items[count - 1].data[17]);
+    stats = saved;
+    if (!passed) {
+        ESP_LOGE(TAG, "failed the known answer tests");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+
+void ubirch_verify_batch_stats_get(ubirch_verify_batch_stats_t *out) {
+    memcpy(out, &stats, sizeof(ubirch_verify_batch_stats_t));
+}
+
+#if CONFIG_UBIRCH_VERIFY_BATCH_BENCHMARK
+
+#define VERIFY_BENCHMARK_ITEMS 32
+
+void ubirch_verify_batch_benchmark(void) {
+    static ubirch_verify_item_t items[BATCH_SIZE];
+    ubirch_verify_batch_stats_t saved = stats;
+    for (size_t i = 0; i < BATCH_SIZE; ++i) {
+        ubirch_verify_item_collect(&items[i], kat_responses[i % KAT_RESPONSES], KAT_RESPONSE_SIZE);
+    }
+
+    // batch size 1 is the single verification
+    int64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < VERIFY_BENCHMARK_ITEMS; ++i) {
+        const ubirch_verify_item_t *item = &items[i % BATCH_SIZE];
+        ed25519_verify_key(item->data, item->len, item->signature, kat_public_key);
+    }
+    ESP_LOGI(TAG, "batch size  1: %u verifies/s", (unsigned int)((int64_t)VERIFY_BENCHMARK_ITEMS * 1000000
+            / (esp_timer_get_time() - start)));
+
+    for (size_t size = 2; size <= BATCH_SIZE; size *= 2) {
+        size_t verified = 0;
+        start = esp_timer_get_time();
+        for (; verified + size <= VERIFY_BENCHMARK_ITEMS; verified += size) {
+            if (ubirch_verify_batch_check(items, size, kat_public_key) != 0) {
+                ESP_LOGE(TAG, "batch of %u failed", (unsigned int)size);
+            }
+        }
+        ESP_LOGI(TAG, "batch size %2u: %u verifies/s", (unsigned int)size,
+                (unsigned int)((int64_t)verified * 1000000 / (esp_timer_get_time() - start)));
+    }
+    stats = saved;
+}
+
+#endif // CONFIG_UBIRCH_VERIFY_BATCH_BENCHMARK
+
+#endif // CONFIG_UBIRCH_VERIFY_BATCH
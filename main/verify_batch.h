@@ -0,0 +1,139 @@
+/*!
+ * @file verify_batch.h
+ * @brief Batch verification of the ed25519 signatures of backend responses.
+ *
+ * The responses of the backend are all signed with the same key. Instead of
+ * checking [s]B = R + [h]A for every response, a batch of n responses is
+ * checked with one equation, combined with random 128 bit factors z:
+ * ```
+ * [8]([-sum(z s) mod L]B + sum([z] R) + [sum(z h) mod L]A) = 0
+ * ```
+ * The sum is computed with one multi-scalar multiplication, whose doublings
+ * are shared by all points. A failed batch does not tell which signature is
+ * invalid, then every response is checked on its own with
+ * ed25519_verify_key().
+ *
+ * The batch equation multiplies by the cofactor 8, the single verification
+ * of the backend does not. A public key or an R of small order fails the
+ * batch, so it is checked alone. Signatures of a holder of the backend key,
+ * whose R has a small-order component, pass the batch and fail alone,
+ * forgeries without the key fail both. host/verify_test.py compares the
+ * batch with the single verification.
+ *
+ * @copyright &copy; 2026 ubirch GmbH (https://ubirch.com)
+ *
+ * ```
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ```
+ */
+
+#ifndef EXAMPLE_ESP32_VERIFY_BATCH_H
+#define EXAMPLE_ESP32_VERIFY_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <ubirch_ed25519.h>
+
+// the signature of a UPP covers the SHA-512 of the UPP without the signature
+#define UBIRCH_VERIFY_DATA_SIZE crypto_hash_sha512_BYTES
+
+/*!
+ * Signed data and signature of a response, waiting for its verification.
+ */
+typedef struct {
+    unsigned char data[UBIRCH_VERIFY_DATA_SIZE];    //!< the signed data, copied from the response
+    size_t len;                                     //!< length of the signed data
+    unsigned char signature[crypto_sign_BYTES];
+    bool valid;                                     //!< result of ubirch_verify_batch()
+} ubirch_verify_item_t;
+
+/*!
+ * Statistics of the batch verification.
+ */
+typedef struct {
+    uint32_t batches;       //!< batch equations checked
+    uint32_t items;         //!< signatures checked in a batch
+    uint32_t fallbacks;     //!< failed batches, which were checked one by one
+    uint32_t invalid;       //!< invalid signatures
+} ubirch_verify_batch_stats_t;
+
+/*!
+ * @brief Collect the signed data and the signature of a signed UPP.
+ *
+ * Like ubirch_protocol_verify(), the signed data is the SHA-512 of the UPP
+ * without the signature, which is the last element of the UPP.
+ *
+ * @param[out] item the item to fill
+ * @param[in] upp the signed UPP, e.g. a response of the backend
+ * @param[in] len the length of the UPP
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE if the UPP is too short to be signed, or
+ *         ESP_ERR_INVALID_ARG if it does not end with a signature packed as bin 8
+ */
+esp_err_t ubirch_verify_item_collect(ubirch_verify_item_t *item, const char *upp, size_t len);
+
+/*!
+ * @brief Check the batch equation of \p items, without the check one by one.
+ *
+ * @param[in] items the signed data and signatures
+ * @param[in] count number of items, at most CONFIG_UBIRCH_VERIFY_BATCH_SIZE
+ * @param[in] public_key the key of all signatures
+ * @return 0 if all signatures are valid, -1 if at least one is not
+ */
+int ubirch_verify_batch_check(const ubirch_verify_item_t *items, size_t count,
+        const unsigned char public_key[crypto_sign_PUBLICKEYBYTES]);
+
+/*!
+ * @brief Verify the signatures of \p items and set their valid flags.
+ *
+ * The items are checked in batches of CONFIG_UBIRCH_VERIFY_BATCH_SIZE, the
+ * items of a failed batch one by one with ed25519_verify_key().
+ *
+ * @param[in,out] items the signed data and signatures
+ * @param[in] count number of items
+ * @param[in] public_key the key of all signatures
+ * @return ESP_OK if all signatures are valid, or ESP_ERR_INVALID_RESPONSE
+ */
+esp_err_t ubirch_verify_batch(ubirch_verify_item_t *items, size_t count,
+        const unsigned char public_key[crypto_sign_PUBLICKEYBYTES]);
+
+/*!
+ * @brief Run the known answer tests, responses of the mock backend.
+ *
+ * The batches of valid responses have to pass, a batch with a modified
+ * signature or data has to fail, and only the modified item has to be
+ * found invalid by the check one by one.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_RESPONSE if a test failed
+ */
+esp_err_t ubirch_verify_batch_selftest(void);
+
+/*!
+ * @brief Get a copy of the statistics.
+ *
+ * @param[out] stats pointer to the statistics to fill
+ */
+void ubirch_verify_batch_stats_get(ubirch_verify_batch_stats_t *stats);
+
+#if CONFIG_UBIRCH_VERIFY_BATCH_BENCHMARK
+/*!
+ * @brief Log the verifications per second by batch size.
+ *
+ * Batch size 1 is the verification with ed25519_verify_key(). This blocks
+ * the calling task for some seconds.
+ */
+void ubirch_verify_batch_benchmark(void);
+#endif
+
+#endif /* EXAMPLE_ESP32_VERIFY_BATCH_H */
@@ -0,0 +1,85 @@
+import argparse
+import base64
+import hashlib
+import re
+import sys
+
+import msgpack
+
+MERKLE_FORMAT = 2
+
+parser = argparse.ArgumentParser(description='verify Merkle inclusion proofs of the gateway')
+
+parser.add_argument('--proof', type=str, help='proof as hex, from ubirch_merkle_proof_export()')
+parser.add_argument('--log', type=str, help='monitor log with "proof <epoch>/<leaf>: <hex>" lines')
+parser.add_argument('--reading', type=str, help='packed reading as hex, which has to match the leaf')
+
+args = parser.parse_args()
+
+
+def leaf_hash(reading):
+    return hashlib.sha512(b'\x00' + reading).digest()
+
+
+def node_hash(left, right):
+    return hashlib.sha512(b'\x01' + left + right).digest()
+
+
+def root_from_path(leaf, index, size, path):
+    """Root of the tree of size leaves, computed like the audit path verification of RFC 9162."""
+    if index >= size:
+        raise ValueError('leaf {} is not in a tree of {} leaves'.format(index, size))
+    fn = index
+    sn = size - 1
+    root = leaf
+    for sibling in path:
+        if sn == 0:
+            raise ValueError('proof is too long')
+        if fn & 1 or fn == sn:
+            root = node_hash(sibling, root)
+            while not fn & 1 and fn != 0:
+                fn >>= 1
+                sn >>= 1
+        else:
+            root = node_hash(root, sibling)
+        fn >>= 1
+        sn >>= 1
+    if sn != 0:
+        raise ValueError('proof is too short')
+    return root
+
+
+def verify(proof, reading=None):
+    sensor_id, payload, index, leaf, path = msgpack.unpackb(proof, raw=False)
+    payload_format, epoch, start_ms, leaves, root = msgpack.unpackb(payload, raw=False)
+    if payload_format != MERKLE_FORMAT:
+        raise ValueError('unknown payload format {}'.format(payload_format))
+    if reading is not None and leaf_hash(reading) != leaf:
+        raise ValueError('reading does not match leaf {}'.format(index))
+    if root_from_path(leaf, index, leaves, path) != root:
+        raise ValueError('proof does not lead to the root')
+
+    payload_hash = hashlib.sha512(payload).digest()
+    print('sensor {}, epoch {}, reading {} of {}: included'.format(sensor_id, epoch, index, leaves))
+    print('anchored hash: {}'.format(base64.b64encode(payload_hash).decode()))
+
+
+proofs = []
+if args.proof:
+    proofs.append(args.proof)
+if args.log:
+    with open(args.log) as _f:
+        proofs += re.findall(r'proof \d+/\d+: ([0-9a-f]+)', _f.read())
+if not proofs:
+    parser.error('no proof given')
+
+reading = bytes.fromhex(args.reading) if args.reading else None
+failed = 0
+for proof in proofs:
+    try:
+        verify(bytes.fromhex(proof), reading)
+    except (ValueError, TypeError) as e:
+        print('invalid proof: {}'.format(e))
+        failed += 1
+
+sys.exit(1 if failed else 0)